@@ -15,6 +15,7 @@
 #include "ns3/flow-monitor-helper.h"
 #include "ns3/flow-monitor-module.h"
 #include "ns3/dmg-almighty-controller.h"
+#include "ns3/dmg-sp-recorder.h"
 #include "ns3/buildings-module.h"
 
 using namespace ns3;
@@ -309,6 +310,14 @@ struct sim_config {
 	bool ifPrint;
 	bool ifVbr;
     bool ifInterf;
+	/* true for packing the SPs in concurrent layers */
+	bool spLayers;
+	/* Number of 802.11ad channels and of DMG devices of each node */
+	uint32_t channels;
+	uint32_t radios;
+	/* true for selecting the antenna sectors with a BeamformingEngine,
+	 * false for pointing the antennas exactly */
+	bool beamforming;
 	std::vector <std::vector <uint64_t> > lastTxSuccess;
 	std::vector <std::vector <uint64_t> > lastTxFailure;
 	uint64_t lastRx;
@@ -316,6 +325,14 @@ struct sim_config {
 	Ptr<ExponentialRandomVariable> rng;
 	uint32_t numSchedulePerBi;
 	double ackTraffFrac;
+	/* Period (ms) of the adaptation of the ACK time fraction to the reverse
+	 * traffic, 0 to keep ackTraffFrac, and its lower bound */
+	double autoAckTimeFrac;
+	double autoAckTimeFracMin;
+	/* Routing computed by the controller: "" to keep the paths of the
+	 * input file, minAirtime, widest, cliqueLoad or joint */
+	std::string routing;
+	std::vector <uint32_t> gateways;
 
 	std::ostringstream dir_oss;
 	std::vector < Ptr<OutputStreamWrapper> > streams_tp;
@@ -473,7 +490,8 @@ void WriteTpFiles(struct sim_config *config)
 
 		uint64_t rx_packets;
 
-		Ptr<EdcaTxopN> edca_src = config->meshNodes->Get(config->flowsPath.at(flowIdx).front())->GetDevice(0)->GetObject<WifiNetDevice>()->GetMac()->GetObject<DmgWifiMac> ()->GetBEQueue ();
+		const std::vector <uint32_t> &path = config->flowsPath.at(flowIdx);
+		Ptr<EdcaTxopN> edca_src = config->dmgCtrl->GetLinkDevice(path[0], path[1])->GetMac()->GetObject<DmgWifiMac> ()->GetBEQueue ();
 
 
 		uint64_t rx_bytes = 0;//SUM of subflows
@@ -502,8 +520,8 @@ void WriteTpFiles(struct sim_config *config)
 
 
 		//mac throughput
-		Ipv4Address srcIp = config->meshNodes->Get(config->flowsPath.at(flowIdx).front())->GetObject<Ipv4>()->GetAddress(1,0).GetLocal();
-		uint64_t rx_bytes_mac = config->meshNodes->Get(config->flowsPath.at(flowIdx).back())->GetDevice(0)->GetObject<WifiNetDevice>()->GetMac()->GetObject<DmgWifiMac>()->GetBytesRxFrom(srcIp);
+		Ipv4Address srcIp = config->dmgCtrl->GetFlowSourceAddress(flowIdx);
+		uint64_t rx_bytes_mac = config->dmgCtrl->GetLinkDevice(path.back(), path[path.size() - 2])->GetMac()->GetObject<DmgWifiMac>()->GetBytesRxFrom(srcIp);
 
 		double cur_rx_Mbits_mac = (rx_bytes_mac * 8.0) / 1e6;
 
@@ -528,7 +546,14 @@ void PrintQueueSize(struct sim_config *config,
 	//for each station
 	for(uint32_t staIdx=0; staIdx<config->meshNodes->GetN(); staIdx++ )
 	{
-		*stream_queuesize->GetStream() << "\t" << config->meshNodes->Get(staIdx)->GetDevice(0)->GetObject<WifiNetDevice>()->GetMac()->GetObject<DmgWifiMac> ()->GetBEQueue () -> GetEdcaQueue() ->GetSize();
+		uint32_t queueSize = 0;
+		for (uint32_t devIdx = 0; devIdx < config->meshNodes->Get(staIdx)->GetNDevices(); devIdx++)
+		{
+			Ptr<WifiNetDevice> dev = config->meshNodes->Get(staIdx)->GetDevice(devIdx)->GetObject<WifiNetDevice>();
+			if (dev != 0)
+				queueSize += dev->GetMac()->GetObject<DmgWifiMac> ()->GetBEQueue () -> GetEdcaQueue() ->GetSize();
+		}
+		*stream_queuesize->GetStream() << "\t" << queueSize;
 	}
 
 	//for each flow (destination)
@@ -538,16 +563,15 @@ void PrintQueueSize(struct sim_config *config,
 		{
 			uint32_t staId = config->flowsPath.at(flowIdx).at(i);
 			uint32_t nexthopId = config->flowsPath.at(flowIdx).at(i+1);
-			uint32_t srcId = config->flowsPath.at(flowIdx).front();
 			uint32_t destId = config->flowsPath.at(flowIdx).back();
 
-			Mac48Address nexthopMacAddr = config->meshNodes->Get(nexthopId)->GetDevice(0)->GetObject<WifiNetDevice>()->GetMac()->GetObject<DmgWifiMac> ()->GetAddress();
+			Mac48Address nexthopMacAddr = config->dmgCtrl->GetLinkDevice(nexthopId, staId)->GetMac()->GetObject<DmgWifiMac> ()->GetAddress();
 
 			std::pair <Ipv4Address, Ipv4Address> srcsinkAddr;
-			srcsinkAddr.first = config->meshNodes->Get(srcId)->GetObject<Ipv4>()->GetAddress(1,0).GetLocal();
-			srcsinkAddr.second = config->meshNodes->Get(destId)->GetObject<Ipv4>()->GetAddress(1,0).GetLocal();
+			srcsinkAddr.first = config->dmgCtrl->GetFlowSourceAddress(flowIdx);
+			srcsinkAddr.second = config->dmgCtrl->GetFlowSinkAddress(flowIdx);
 
-			*stream_queuesize->GetStream() << "\t"<< staId <<"to" << nexthopId <<"["<< destId <<"]\t" << config->meshNodes->Get(staId)->GetDevice(0)->GetObject<WifiNetDevice>()->GetMac()->GetObject<DmgWifiMac> ()->GetBEQueue () -> GetEdcaQueue()->GetNPacketsByAddress(WifiMacHeader::ADDR1,nexthopMacAddr, srcsinkAddr);
+			*stream_queuesize->GetStream() << "\t"<< staId <<"to" << nexthopId <<"["<< destId <<"]\t" << config->dmgCtrl->GetLinkDevice(staId, nexthopId)->GetMac()->GetObject<DmgWifiMac> ()->GetBEQueue () -> GetEdcaQueue()->GetNPacketsByAddress(WifiMacHeader::ADDR1,nexthopMacAddr, srcsinkAddr);
 		}
 	}
 	*stream_queuesize->GetStream() << std::endl;
@@ -701,31 +725,40 @@ FinalizeConfig(struct sim_config *config)
 
 	for (uint32_t i = 0; i < allNodes.GetN(); i++)
 	{
-		/* This loop is used to force the ARP tables on each node */
-		for (uint32_t j = 0; j < allNodes.GetN(); j++)
+		Ptr<Ipv4L3Protocol> ipv4 = allNodes.Get(i)->GetObject<Ipv4L3Protocol>();
+		/* This loop is used to force the ARP tables on each interface of each
+		 * node (interface 0 is the loopback) */
+		for (uint32_t ifIdx = 1; ifIdx < ipv4->GetNInterfaces(); ifIdx++)
 		{
-			if (i == j)
-				continue;
-
-			Address mac = allNodes.Get(j)->GetDevice(0)->GetAddress();
-			Ipv4Address ip = allNodes.Get(j)->GetObject<Ipv4>()->
-				GetAddress(1,0).GetLocal();
-			Ptr<ArpCache> arpCache = allNodes.Get(i)->GetObject<Ipv4L3Protocol>()->
-				GetInterface(1)->GetArpCache();
-
-			if (arpCache == NULL)
-				arpCache = CreateObject<ArpCache>();
-			arpCache->SetAliveTimeout(Seconds (config->simulationTime + 1));
-			ArpCache::Entry *entry = arpCache->Add(ip);
-			entry->MarkWaitReply(0);
-			entry->MarkAlive(mac);
+			for (uint32_t j = 0; j < allNodes.GetN(); j++)
+			{
+				if (i == j)
+					continue;
+
+				Ptr<Ipv4L3Protocol> peerIpv4 = allNodes.Get(j)->GetObject<Ipv4L3Protocol>();
+				for (uint32_t peerIfIdx = 1; peerIfIdx < peerIpv4->GetNInterfaces(); peerIfIdx++)
+				{
+					Address mac = peerIpv4->GetNetDevice(peerIfIdx)->GetAddress();
+					Ipv4Address ip = peerIpv4->GetAddress(peerIfIdx,0).GetLocal();
+					Ptr<ArpCache> arpCache = ipv4->GetInterface(ifIdx)->GetArpCache();
+
+					if (arpCache == NULL)
+						arpCache = CreateObject<ArpCache>();
+					arpCache->SetAliveTimeout(Seconds (config->simulationTime + 1));
+					ArpCache::Entry *entry = arpCache->Add(ip);
+					entry->MarkWaitReply(0);
+					entry->MarkAlive(mac);
+				}
+			}
 		}
 
 		/* Configure the minimum frame BER */
-		Ptr<YansWifiPhy> yansPhy = allNodes.Get(i)->GetDevice(0)->
-			GetObject<WifiNetDevice>()->GetPhy()->
-			GetObject<YansWifiPhy> ();
-		yansPhy->SetFrameMinBer(config->frameMinBer);
+		for (uint32_t devIdx = 0; devIdx < allNodes.Get(i)->GetNDevices(); devIdx++)
+		{
+			Ptr<WifiNetDevice> dev = allNodes.Get(i)->GetDevice(devIdx)->GetObject<WifiNetDevice>();
+			if (dev != 0)
+				dev->GetPhy()->GetObject<YansWifiPhy> ()->SetFrameMinBer(config->frameMinBer);
+		}
 	}
 }
 
@@ -808,7 +841,11 @@ void ReconfigureDmgBeaconInterval (struct sim_config *config, uint16_t it)
 
 	config->predictedFlowRate = config->dmgCtrl->FlowRateProgressiveFilling(config->flowsDmd, config->proFillStepL, config->appPayloadBytes, config->biOverheadFraction, config->nMpdus);
 
-    if(config->ifInterf)
+    if(config->spLayers)
+    {
+        config->dmgCtrl->ConfigureScheduleInLayers();
+    }
+    else if(config->ifInterf)
     {
         config->dmgCtrl->ConfigureScheduleWithInterfAvoidance();
     }
@@ -833,6 +870,88 @@ void ReconfigureDmgBeaconInterval (struct sim_config *config, uint16_t it)
 
 }
 
+/* Replace the paths of the input file with the ones computed by the
+ * controller from the gateways to the sinks of the flows */
+void RouteFlows (struct sim_config *config)
+{
+	std::vector <uint32_t> sinks;
+	for (uint32_t flowIdx = 0; flowIdx < config->flowsPath.size(); flowIdx++)
+		sinks.push_back(config->flowsPath.at(flowIdx).back());
+
+	config->dmgCtrl->SetSimInterference(config->ifInterf);
+	config->dmgCtrl->SetGw(config->gateways);
+	config->dmgCtrl->SetMeshNodes(config->meshNodes);
+	config->dmgCtrl->SetNChannels(config->channels);
+
+	if (config->routing == "joint")
+	{
+		/* Keep the routing with the highest minimum flow rate whose SPs fit
+		 * in the Beacon Interval */
+		config->dmgCtrl->SetBeamSwitchOverhead(config->beamSwitchOverhead);
+		config->dmgCtrl->SetNumSchedulePerBi(config->numSchedulePerBi);
+		config->dmgCtrl->SetBiDuration(config->biDurationNs);
+		config->dmgCtrl->SetBiOverheadFraction(config->biOverheadFraction);
+		config->dmgCtrl->SelectFlowsPath(sinks, config->flowsDmd, config->proFillStepL,
+				config->appPayloadBytes, config->biOverheadFraction, config->nMpdus);
+		config->flowsPath = config->dmgCtrl->GetFlowsPath();
+	}
+	else
+	{
+		DmgRoutePlanner::Metric metric;
+		if (config->routing == "minAirtime")
+			metric = DmgRoutePlanner::MIN_AIRTIME;
+		else if (config->routing == "widest")
+			metric = DmgRoutePlanner::WIDEST_PATH;
+		else if (config->routing == "cliqueLoad")
+			metric = DmgRoutePlanner::CLIQUE_LOAD;
+		else
+			NS_FATAL_ERROR("Unknown routing " << config->routing);
+		config->flowsPath = config->dmgCtrl->ComputeFlowsPath(sinks, config->flowsDmd, metric,
+				config->appPayloadBytes, config->nMpdus);
+	}
+
+	for (uint32_t flowIdx = 0; flowIdx < config->flowsPath.size(); flowIdx++)
+	{
+		std::ostringstream path;
+		for (uint32_t i = 0; i < config->flowsPath.at(flowIdx).size(); i++)
+			path << " " << config->flowsPath.at(flowIdx).at(i);
+		NS_LOG_UNCOND("Flow " << flowIdx << " routed on" << path.str());
+	}
+}
+
+/* Route to destAddr from sta through its device towards nextHop, to the
+ * address of the device of nextHop towards sta */
+void AddHopRoute (struct sim_config *config, Ipv4Address destAddr, uint32_t sta, uint32_t nextHop)
+{
+	Ipv4StaticRoutingHelper ipv4RoutingHelper;
+	Ptr<Ipv4> staIpv4 = config->meshNodes->Get(sta)->GetObject<Ipv4> ();
+	Ptr<Ipv4> nextHopIpv4 = config->meshNodes->Get(nextHop)->GetObject<Ipv4> ();
+	uint32_t staIf = staIpv4->GetInterfaceForDevice(config->dmgCtrl->GetLinkDevice(sta, nextHop));
+	uint32_t nextHopIf = nextHopIpv4->GetInterfaceForDevice(config->dmgCtrl->GetLinkDevice(nextHop, sta));
+	ipv4RoutingHelper.GetStaticRouting(staIpv4)->AddHostRouteTo (destAddr, nextHopIpv4->GetAddress(nextHopIf,0).GetLocal(), staIf);
+}
+
+/* Static routes along the paths of the flows, in both directions, on the
+ * devices of the channels of the links (call it after SetupDmgController) */
+void InstallStaticRoutes (struct sim_config *config)
+{
+	for (uint32_t flowIdx = 0; flowIdx< config->flowsPath.size(); flowIdx++){
+		Ipv4Address destAddr = config->dmgCtrl->GetFlowSinkAddress(flowIdx);
+		//Configure route from flowsSrc to flowsSink
+		for (uint32_t staIdx = 0; staIdx< config->flowsPath.at(flowIdx).size() - 1; staIdx++){
+			//NS_LOG_DEBUG("Flow "<<flowIdx<< " destin "<< destAddr << " sta " << config->flowsPath.at(flowIdx).at(staIdx)<<" next hop "<< config->flowsPath.at(flowIdx).at(staIdx+1));
+			AddHopRoute(config, destAddr, config->flowsPath.at(flowIdx).at(staIdx), config->flowsPath.at(flowIdx).at(staIdx + 1));
+		}
+		//the source sends from the address of its first hop device
+		destAddr = config->dmgCtrl->GetFlowSourceAddress(flowIdx);
+		//Configure route from flowsSink to flowsSrc
+		for (uint32_t staIdx = config->flowsPath.at(flowIdx).size() - 1 ; staIdx > 0 ; staIdx--){
+			//NS_LOG_DEBUG("Flow "<<flowIdx<< "_inverse destin "<< destAddr << " sta " << config->flowsPath.at(flowIdx).at(staIdx)<<" next hop "<< config->flowsPath.at(flowIdx).at(staIdx - 1));
+			AddHopRoute(config, destAddr, config->flowsPath.at(flowIdx).at(staIdx), config->flowsPath.at(flowIdx).at(staIdx - 1));
+		}
+	}
+}
+
 /* Utility function used to configure the DMG controller */
 void SetupDmgController (struct sim_config *config)
 {
@@ -841,8 +960,9 @@ void SetupDmgController (struct sim_config *config)
 	 */
 	/* We pass the container of the mesh nodes to the DmgAlmightyController */
     config->dmgCtrl->SetSimInterference(config->ifInterf);
-	config->dmgCtrl->SetGw(0);
+	config->dmgCtrl->SetGw(config->gateways);
 	config->dmgCtrl->SetMeshNodes(config->meshNodes);
+	config->dmgCtrl->SetNChannels(config->channels);
 
 	config->dmgCtrl->SetFlowsPath(config->flowsPath);
 
@@ -882,7 +1002,11 @@ void SetupDmgController (struct sim_config *config)
 	/* Configure the DmgBeaconInterval on each node with the list of Secrive
 	 * Periods.
 	 */
-    if(config->ifInterf)
+    if(config->spLayers)
+    {
+        config->dmgCtrl->ConfigureScheduleInLayers();
+    }
+    else if(config->ifInterf)
     {
         config->dmgCtrl->ConfigureScheduleWithInterfAvoidance();
     }
@@ -892,6 +1016,16 @@ void SetupDmgController (struct sim_config *config)
     }
 
 	config->dmgCtrl->ConfigureBeaconIntervals();
+	if (config->autoAckTimeFrac > 0 && config->ackTraffFrac > 0)
+		config->dmgCtrl->SetAutoAckTimeFrac(Seconds(config->autoAckTimeFrac / 1000.0), config->autoAckTimeFracMin);
+
+	if (config->spLayers)
+	{
+		for (uint32_t layer = 0; layer < config->dmgCtrl->GetNLayers(); layer++)
+			NS_LOG_UNCOND("SP layer " << layer << " utilization " << config->dmgCtrl->GetLayerUtilization(layer)
+					<< " occupancy " << config->dmgCtrl->GetLayerOccupancy(layer));
+		NS_LOG_UNCOND("SP layers concurrency " << config->dmgCtrl->GetLayerConcurrency());
+	}
 
 	if (config->nMpdus > 0) {
 		config->dmgCtrl->CreateBlockAckAgreement();
@@ -918,6 +1052,11 @@ void SetupDmgNodes (struct sim_config *config)
 	NodeContainer allNodes (*(config->meshNodes));//, *(config->ctrlNodes));
 
 	for (uint32_t i = 0; i < allNodes.GetN(); i++) {
+	/* Every DMG device (one per channel the node may use) has its own antenna */
+	for (uint32_t devIdx = 0; devIdx < allNodes.Get(i)->GetNDevices(); devIdx++) {
+		Ptr<WifiNetDevice> dev = allNodes.Get(i)->GetDevice(devIdx)->GetObject<WifiNetDevice>();
+		if (dev == 0)
+			continue;
 		/* Currently DMG nodes support only antennas whose type is ConeAntenna */
 		Ptr<ConeAntenna> ant = CreateObject<ConeAntenna> ();
 		/* Configure the gain (Rx and Tx) of the antenna */
@@ -926,32 +1065,28 @@ void SetupDmgNodes (struct sim_config *config)
 		/* The antenna is managed by a DmgAntennaController */
 		Ptr<DmgAntennaController> antCtrl = CreateObject<DmgAntennaController> ();
 		antCtrl->SetAntenna(ant);
-		antCtrl->SetPhy(allNodes.Get(i)->GetDevice(0)->GetObject<WifiNetDevice>()->
-				GetPhy());
+		antCtrl->SetPhy(dev->GetPhy());
+		if (config->beamforming) {
+			antCtrl->SetBeamformingEngine(CreateObject<BeamformingEngine> ());
+		}
 
 		/* Configure the DmgWifiMac with the DmgAntenna controller just created */
-		allNodes.Get(i)->GetDevice(0)->GetObject<WifiNetDevice>()->
-			GetMac()->GetObject<DmgWifiMac>()->SetDmgAntennaController(antCtrl);
+		dev->GetMac()->GetObject<DmgWifiMac>()->SetDmgAntennaController(antCtrl);
 
 		/* Configure the DmgWifiMac with a new DmgBeaconInterval */
-		allNodes.Get(i)->GetDevice(0)->GetObject<WifiNetDevice>()->
-			GetMac()->GetObject<DmgWifiMac>()->
+		dev->GetMac()->GetObject<DmgWifiMac>()->
 			SetDmgBeaconInterval(CreateObject<DmgBeaconInterval>());
 
 		/* It's important to configure a proper propagation time */
-		allNodes.Get(i)->GetDevice(0)->GetObject<WifiNetDevice>()->
-			GetMac()->GetObject<DmgWifiMac>()->SetPropagationGuard(
+		dev->GetMac()->GetObject<DmgWifiMac>()->SetPropagationGuard(
 					Seconds(sqrt(pow(config->square_side_l, 2) * 2) /
 						3e8));
 
 		/* Configure number of mpdus to aggregated (used to measure return duration) */
-		allNodes.Get(i)->GetDevice(0)->GetObject<WifiNetDevice>()->
-			GetMac()->GetObject<DmgWifiMac>()->SetMaxNumMpdu(config->nMpdus);
+		dev->GetMac()->GetObject<DmgWifiMac>()->SetMaxNumMpdu(config->nMpdus);
 
 		/* Configure phy level parameters */
-		Ptr<YansWifiPhy> yPhy =
-			allNodes.Get(i)->GetDevice(0)->GetObject<WifiNetDevice>()->
-			GetPhy()->GetObject<YansWifiPhy>();
+		Ptr<YansWifiPhy> yPhy = dev->GetPhy()->GetObject<YansWifiPhy>();
 		yPhy->SetTxGain(config->txRxGainDbi);
 		yPhy->SetRxGain(config->txRxGainDbi);
 		yPhy->SetTxPowerStart(config->txPowerDbi);
@@ -959,6 +1094,7 @@ void SetupDmgNodes (struct sim_config *config)
 		/* Sensitivity model includes implementation loss and noise figure */
 		yPhy->SetRxNoiseFigure(0);
 	}
+	}
 }
 
 void SetupOnOffTraffic(struct sim_config *config, std::string protocol)
@@ -1163,6 +1299,24 @@ int main (int argc, char *argv[])
 
 	bool ifVbr = false;
     bool ifInterf = true;
+	/* By default the SPs of a clique are scheduled one after the other */
+	bool spLayers = false;
+	/* By default all the links share channel 1 */
+	uint32_t channels = 1;
+	/* By default every node has a radio for every channel */
+	uint32_t radios = 0;
+	/* By default the antennas are pointed exactly */
+	bool beamforming = false;
+	/* By default the links keep the MCS chosen by the controller */
+	bool rateAdaptation = false;
+	/* By default every MPDU of an A-MPDU is received with its own event */
+	bool spFastForward = false;
+	/* By default an A-MPDU ends with the first MPDU that does not fit in the SP */
+	bool spTailPacking = false;
+	/* By default the PHYs evaluate the error rate model for every chunk */
+	bool tabulatedErrorRate = false;
+	/* By default the errors follow the 802.11ad sensitivities step by step */
+	bool dmgErrorRate = false;
 	/* Max # aggregated MPDU */
 	uint32_t nMpdus = 30;
 	/*By default the mac queue capacity is 5000 */
@@ -1171,6 +1325,17 @@ int main (int argc, char *argv[])
 	uint32_t numSchedulePerBi = 20;
 	/*By default the fraction of time used for traffic of inverse direction (e.g. tcp ack) is 0*/
 	double ackTraffFrac = 0.06;//94/(1554+94)= 0.057038835
+	/* By default the SP destination does not use the rest of the SP */
+	bool reverseDirection = false;
+	/* By default the ACK time fraction is fixed */
+	double autoAckTimeFrac = 0;
+	double autoAckTimeFracMin = 0.01;
+	/* By default the stats of the SPs are not recorded */
+	std::string spStatsFile = "";
+	/* By default the flows follow the paths of the input file */
+	std::string routing = "";
+	/* By default node 0 is the only gateway */
+	std::string gateways = "0";
 
 	std::string inputFileName ="scratch/Nottin.txt";//"Fig4_inverse.txt";//
 
@@ -1203,8 +1368,23 @@ int main (int argc, char *argv[])
 	cmd.AddValue("ifPrintThroughput","Print throughput in file or not", ifPrint);
 	cmd.AddValue("ifVbr","Use VBR", ifVbr);
     cmd.AddValue("ifInterf","Simulate interference", ifInterf);
+	cmd.AddValue("spLayers","Pack the SPs of the links that neither share a node nor interfere in concurrent layers", spLayers);
+	cmd.AddValue("channels","Number of 802.11ad channels (1-4) assigned to the links by the controller, scheduled independently (implies spLayers)", channels);
+	cmd.AddValue("radios","Number of DMG devices of every node, at most one per channel (0: as many as the channels)", radios);
+	cmd.AddValue("beamforming","Select the antenna sectors with sector sweeps", beamforming);
+	cmd.AddValue("rateAdaptation","Adapt the MCS of the links to the measured SNR", rateAdaptation);
+	cmd.AddValue("spFastForward","Deliver the A-MPDUs of the SPs without interference (needs ifInterf) as whole PPDUs, in the DMG mode of the channel", spFastForward);
+	cmd.AddValue("spTailPacking","Fill the end of the SPs with the heads of the other flows to the same next hop that still fit", spTailPacking);
+	cmd.AddValue("dmgErrorRate","Use the LDPC codeword error rate curves of the DMG MCSs instead of the sensitivity model", dmgErrorRate);
+	cmd.AddValue("tabulatedErrorRate","Look up the chunk success rates of the error rate model in tables shared by all the PHYs", tabulatedErrorRate);
 	cmd.AddValue("numSchedulePerBi","Number of Schedules Per Beacon Interval", numSchedulePerBi);
 	cmd.AddValue("ackTraffFrac","The fraction of time used for traffic of inverse direction (e.g. tcp ack)", ackTraffFrac);
+	cmd.AddValue("reverseDirection","Let the SP destination send its frames for the SP owner (e.g. tcp acks) in the rest of the SP", reverseDirection);
+	cmd.AddValue("autoAckTimeFrac","Period in ms of the adaptation of ackTraffFrac to the observed reverse traffic, 0 to keep it fixed", autoAckTimeFrac);
+	cmd.AddValue("autoAckTimeFracMin","Lower bound of the adapted ackTraffFrac", autoAckTimeFracMin);
+	cmd.AddValue("spStatsFile","Record the stats of every Tx SP in this binary file (read it with dmg-sp-reader)", spStatsFile);
+	cmd.AddValue("routing","Route the flows from the gateways to their sinks instead of following the input file: minAirtime, widest, cliqueLoad or joint (the one of them with the highest minimum flow rate)", routing);
+	cmd.AddValue("gateways","Comma separated list of the gateway nodes", gateways);
 	cmd.Parse (argc, argv);
 
 
@@ -1237,6 +1417,13 @@ int main (int argc, char *argv[])
 	config.trafficType = trafficType;
 	config.macQueueSizeinPkts = macQueueSizeinPkts;
     config.ifInterf = ifInterf;
+	if (channels < 1 || channels > 4)
+		NS_FATAL_ERROR("channels must be between 1 and 4");
+	config.channels = channels;
+	config.radios = (radios == 0 || radios > channels) ? channels : radios;
+	/* Only the layer scheduler handles the cliques of several channels */
+	config.spLayers = spLayers || channels > 1;
+	config.beamforming = beamforming;
 
 
 	/* File stream for throughput report.
@@ -1278,6 +1465,15 @@ int main (int argc, char *argv[])
 //	config.numSchedulePerBi = (config.trafficType == "udp")?numSchedulePerBi:(numSchedulePerBi - 5);
 	config.numSchedulePerBi = numSchedulePerBi;
 	config.ackTraffFrac = (config.trafficType == "udp")?(0.0):ackTraffFrac;
+	config.autoAckTimeFrac = autoAckTimeFrac;
+	config.autoAckTimeFracMin = autoAckTimeFracMin;
+	config.routing = routing;
+	std::istringstream gateways_iss (gateways);
+	std::string gateway;
+	while (std::getline(gateways_iss, gateway, ','))
+		config.gateways.push_back(std::atoi(gateway.c_str()));
+	if (config.gateways.empty())
+		NS_FATAL_ERROR("No gateway");
 
 
 	/*Uniform Random Variable*/
@@ -1330,8 +1526,12 @@ int main (int argc, char *argv[])
 	YansWifiPhyHelper phy = YansWifiPhyHelper::Default ();
 	phy.Set("dmgOfdm", BooleanValue(config.dmgOfdm));
 	Ptr<YansWifiChannel> channel = channelHelper.Create();
+	/* The PPDUs of the fast-forwarded SPs use the link budgets of the DMG mode */
+	if (spFastForward)
+		channel->SetAttribute ("DmgMode", BooleanValue (true));
 	phy.SetChannel (channel);
-	phy.SetErrorRateModel("ns3::SensitivityModel60GHz");
+	std::string errorRateModel = dmgErrorRate ? "ns3::DmgErrorRateModel" : "ns3::SensitivityModel60GHz";
+	phy.SetErrorRateModel(errorRateModel);
 
 	/******************************
 	 * MAC configuration 
@@ -1339,14 +1539,20 @@ int main (int argc, char *argv[])
 	WifiHelper wifi = WifiHelper::Default ();
 	wifi.SetStandard (WIFI_PHY_STANDARD_80211ad);
 
-	wifi.SetRemoteStationManager ("ns3::DmgDestinationFixedWifiManager");
+	/* The controller seeds both managers with the ideal MCS of the links */
+	if (rateAdaptation)
+		wifi.SetRemoteStationManager ("ns3::DmgSnrWifiManager");
+	else
+		wifi.SetRemoteStationManager ("ns3::DmgDestinationFixedWifiManager");
 
 	Ssid ssid = Ssid (SSID_STR);
 	DmgWifiMacHelper meshMac = DmgWifiMacHelper::Default ();
 
 	NetDeviceContainer devices;
 
-	meshMac.SetType ("ns3::DmgWifiMac");
+	meshMac.SetType ("ns3::DmgWifiMac", "SpFastForward", BooleanValue (spFastForward),
+			 "SpTailPacking", BooleanValue (spTailPacking),
+			 "ReverseDirection", BooleanValue (reverseDirection));
 
 	if (config.nMpdus > 0) {
 		meshMac.SetBlockAckThresholdForAc (AC_BE, 1);
@@ -1355,7 +1561,20 @@ int main (int argc, char *argv[])
 				"MaxAmpduSize", UintegerValue (config.nMpdus * (config.appPayloadBytes + 100)));
 	}
 
-	devices = wifi.Install(phy, meshMac, *(config.meshNodes));
+	/* One DMG device per radio; the controller tunes them to their channels */
+	for (uint32_t r = 0; r < config.radios; r++)
+		devices.Add(wifi.Install(phy, meshMac, *(config.meshNodes)));
+
+	if (tabulatedErrorRate)
+	{
+		/* One model for all the PHYs, so each mode is tabulated once */
+		Ptr<TabulatedErrorRateModel> errorRate = CreateObject<TabulatedErrorRateModel> ();
+		ObjectFactory factory;
+		factory.SetTypeId (errorRateModel);
+		errorRate->SetErrorRateModel (factory.Create<ErrorRateModel> ());
+		for (uint32_t i = 0; i < devices.GetN (); i++)
+			devices.Get (i)->GetObject<WifiNetDevice> ()->GetPhy ()->GetObject<YansWifiPhy> ()->SetErrorRateModel (errorRate);
+	}
 
 	/******************************
 	 * Set node positions 
@@ -1394,26 +1613,6 @@ int main (int argc, char *argv[])
 	address.SetBase ("192.168.1.0", "255.255.255.0");
 	Ipv4InterfaceContainer interfaces = address.Assign (devices);
 
-	for (uint32_t flowIdx = 0; flowIdx< config.flowsPath.size(); flowIdx++){
-		Ipv4Address destAddr = config.meshNodes->Get(config.flowsPath.at(flowIdx).back())->GetObject<Ipv4>()->GetAddress(1,0).GetLocal();
-		Ipv4StaticRoutingHelper ipv4RoutingHelper;
-		//Configure route from flowsSrc to flowsSink
-		for (uint32_t staIdx = 0; staIdx< config.flowsPath.at(flowIdx).size() - 1; staIdx++){
-			//NS_LOG_DEBUG("Flow "<<flowIdx<< " destin "<< destAddr << " sta " << config.flowsPath.at(flowIdx).at(staIdx)<<" next hop "<< config.flowsPath.at(flowIdx).at(staIdx+1));
-			Ptr<Ipv4StaticRouting> staticRouting = ipv4RoutingHelper.GetStaticRouting
-				(config.meshNodes->Get(config.flowsPath.at(flowIdx).at(staIdx))->GetObject<Ipv4> ());
-			staticRouting->AddHostRouteTo (destAddr,config.meshNodes->Get(config.flowsPath.at(flowIdx).at(staIdx + 1))->GetObject<Ipv4>()->GetAddress(1,0).GetLocal(), 1);
-		}
-		destAddr = config.meshNodes->Get(config.flowsPath.at(flowIdx).front())->GetObject<Ipv4>()->GetAddress(1,0).GetLocal();
-		//Configure route from flowsSink to flowsSrc
-		for (uint32_t staIdx = config.flowsPath.at(flowIdx).size() - 1 ; staIdx > 0 ; staIdx--){
-			//NS_LOG_DEBUG("Flow "<<flowIdx<< "_inverse destin "<< destAddr << " sta " << config.flowsPath.at(flowIdx).at(staIdx)<<" next hop "<< config.flowsPath.at(flowIdx).at(staIdx - 1));
-			Ptr<Ipv4StaticRouting> staticRouting = ipv4RoutingHelper.GetStaticRouting
-				(config.meshNodes->Get(config.flowsPath.at(flowIdx).at(staIdx))->GetObject<Ipv4> ());
-			staticRouting->AddHostRouteTo (destAddr,config.meshNodes->Get(config.flowsPath.at(flowIdx).at(staIdx - 1))->GetObject<Ipv4>()->GetAddress(1,0).GetLocal(), 1);
-		}
-	}
-
 	//Print Routing Table
 	/*Ipv4StaticRoutingHelper routingHelper;
 	  Ptr<OutputStreamWrapper> routingStream = Create<OutputStreamWrapper>
@@ -1426,9 +1625,9 @@ int main (int argc, char *argv[])
 	if (config.enablePcap)
 	{
 		phy.SetPcapDataLinkType(YansWifiPhyHelper::DLT_IEEE802_11_RADIO); 
-		for (uint32_t i = 0; i < config.meshNodes->GetN(); i++)
+		for (uint32_t i = 0; i < devices.GetN(); i++)
 		{
-			phy.EnablePcap("cap", config.meshNodes->Get(i)->GetDevice(0), true);
+			phy.EnablePcap("cap", devices.Get(i), true);
 		}
 	}
 
@@ -1460,7 +1659,19 @@ int main (int argc, char *argv[])
 	 * Finalize configuration and start simulation 
 	 *****************************/
 	SetupDmgNodes (&config);
+	if (!config.routing.empty())
+		RouteFlows(&config);
 	SetupDmgController(&config);
+	/* The routes follow the devices of the channels chosen by the controller */
+	InstallStaticRoutes(&config);
+
+	DmgSpRecorder spRecorder;
+	if (!spStatsFile.empty())
+	{
+		if (!spRecorder.Open(spStatsFile))
+			NS_FATAL_ERROR("Cannot open " << spStatsFile);
+		spRecorder.ConnectAll();
+	}
 
 	if (config.trafficType == "udp")
 	{
@@ -1517,6 +1728,7 @@ int main (int argc, char *argv[])
 
 	Simulator::Stop (Seconds(config.simulationTime + 1));
 	Simulator::Run ();
+	spRecorder.Close();
 
 	//monitor->SerializeToXmlFile ("results.xml",true,false);//True for histogram false for probe
 	Simulator::Destroy ();
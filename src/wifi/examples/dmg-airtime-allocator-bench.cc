@@ -0,0 +1,215 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+/* Micro-benchmark of the free airtime bookkeeping of the DMG scheduler.
+ *
+ * nCliques cliques of nSegs segments each are scheduled in the same Beacon
+ * Interval. Every segment gets an SP: first-fit in the free airtime, sliced
+ * over the first gaps when no gap is long enough, as the
+ * DmgAlmightyController does. Before that, the airtime already used by
+ * nBusy SPs of interfering links is reserved, so the free airtime is
+ * fragmented.
+ *
+ * The same schedule is built with the DmgAirtimeAllocator and, if --legacy
+ * is set, with the vector of [start, stop] rows the scheduler used before,
+ * and the two schedules are checked to be identical.
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/dmg-airtime-allocator.h"
+#include <iostream>
+
+using namespace ns3;
+
+typedef std::vector<std::pair<uint64_t, uint64_t> > SpList;
+
+/* Former DmgAlmightyController::RemoveIntervalFromTimeAvailable, arguments
+ * passed by value as they were */
+static std::vector<std::vector<uint64_t> >
+LegacyRemove (std::vector<std::vector<uint64_t> > toRemove, std::vector<std::vector<uint64_t> > avaiTime)
+{
+  for (uint32_t i = 0; i < toRemove.size (); i++)
+    {
+      uint64_t avoidStart = toRemove[i][0];
+      uint64_t avoidStop = toRemove[i][1];
+      for (uint32_t slot = 0; slot < avaiTime.size (); slot++)
+        {
+          if (avoidStart <= avaiTime[slot][0] && avoidStop >= avaiTime[slot][0] && avoidStop <= avaiTime[slot][1])
+            {
+              avaiTime[slot][0] = avoidStop;
+            }
+          else if (avoidStart >= avaiTime[slot][0] && avoidStart <= avaiTime[slot][1] && avoidStop >= avaiTime[slot][1])
+            {
+              avaiTime[slot][1] = avoidStart;
+            }
+          else if (avoidStart > avaiTime[slot][0] && avoidStart < avaiTime[slot][1] && avoidStop > avaiTime[slot][0] && avoidStop < avaiTime[slot][1])
+            {
+              std::vector<uint64_t> newRow;
+              newRow.push_back (avoidStop);
+              newRow.push_back (avaiTime[slot][1]);
+              avaiTime[slot][1] = avoidStart;
+              avaiTime.insert (avaiTime.begin () + slot + 1, newRow);
+            }
+        }
+    }
+  return avaiTime;
+}
+
+static std::vector<std::vector<uint64_t> >
+LegacyRemove (uint64_t start, uint64_t stop, const std::vector<std::vector<uint64_t> > &avaiTime)
+{
+  std::vector<std::vector<uint64_t> > toRemove (1);
+  toRemove[0].push_back (start);
+  toRemove[0].push_back (stop);
+  return LegacyRemove (toRemove, avaiTime);
+}
+
+static SpList
+ScheduleLegacy (uint64_t biNs, const SpList &busy, const std::vector<uint64_t> &durations)
+{
+  SpList sps;
+  std::vector<std::vector<uint64_t> > timeAvailable (1);
+  timeAvailable[0].push_back (0);
+  timeAvailable[0].push_back (biNs);
+  for (uint32_t i = 0; i < busy.size (); i++)
+    {
+      timeAvailable = LegacyRemove (busy[i].first, busy[i].second, timeAvailable);
+    }
+  for (uint32_t i = 0; i < durations.size (); i++)
+    {
+      uint64_t timeNeeded = durations[i];
+      bool ifSplited = true;
+      for (uint32_t iRow = 0; iRow < timeAvailable.size (); iRow++)
+        {
+          if (timeNeeded <= timeAvailable[iRow][1] - timeAvailable[iRow][0])
+            {
+              uint64_t start = timeAvailable[iRow][0];
+              sps.push_back (std::make_pair (start, start + timeNeeded));
+              timeAvailable = LegacyRemove (start, start + timeNeeded, timeAvailable);
+              ifSplited = false;
+              break;
+            }
+        }
+      for (uint32_t iRow = 0; ifSplited && timeNeeded && iRow < timeAvailable.size (); iRow++)
+        {
+          uint64_t start = timeAvailable[iRow][0];
+          uint64_t dur = std::min (timeNeeded, timeAvailable[iRow][1] - start);
+          if (dur == 0)
+            {
+              continue;
+            }
+          sps.push_back (std::make_pair (start, start + dur));
+          timeAvailable = LegacyRemove (start, start + dur, timeAvailable);
+          timeNeeded -= dur;
+        }
+    }
+  return sps;
+}
+
+static SpList
+ScheduleAllocator (uint64_t biNs, const SpList &busy, const std::vector<uint64_t> &durations)
+{
+  SpList sps;
+  DmgAirtimeAllocator timeAvailable;
+  timeAvailable.Release (0, biNs);
+  for (uint32_t i = 0; i < busy.size (); i++)
+    {
+      timeAvailable.Reserve (busy[i].first, busy[i].second);
+    }
+  for (uint32_t i = 0; i < durations.size (); i++)
+    {
+      uint64_t timeNeeded = durations[i];
+      uint64_t start, stop;
+      if (timeAvailable.FirstFit (timeNeeded, start, stop))
+        {
+          sps.push_back (std::make_pair (start, start + timeNeeded));
+          timeAvailable.Reserve (start, start + timeNeeded);
+          continue;
+        }
+      while (timeNeeded && timeAvailable.FirstFit (1, start, stop))
+        {
+          uint64_t dur = std::min (timeNeeded, stop - start);
+          sps.push_back (std::make_pair (start, start + dur));
+          timeAvailable.Reserve (start, start + dur);
+          timeNeeded -= dur;
+        }
+    }
+  return sps;
+}
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t nCliques = 500;
+  uint32_t nSegs = 20;
+  uint32_t nBusy = 10000;
+  double load = 0.9;
+  bool legacy = false;
+
+  CommandLine cmd;
+  cmd.AddValue ("nCliques", "Number of cliques", nCliques);
+  cmd.AddValue ("nSegs", "Number of segments (SPs) per clique", nSegs);
+  cmd.AddValue ("nBusy", "Number of SPs of interfering links already scheduled", nBusy);
+  cmd.AddValue ("load", "Fraction of the BI requested by the SPs", load);
+  cmd.AddValue ("legacy", "Also run the vector based bookkeeping", legacy);
+  cmd.Parse (argc, argv);
+
+  // 100 ms BI. Interfering SPs take 20% of it in 2*nBusy fragments, the
+  // segments request load * 80% of it
+  const uint64_t biNs = 100000000;
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  rng->SetStream (1);
+
+  SpList busy;
+  uint64_t busySlot = biNs / (nBusy + 1);
+  for (uint32_t i = 0; i < nBusy; i++)
+    {
+      uint64_t start = i * busySlot + rng->GetInteger (0, busySlot * 4 / 5);
+      busy.push_back (std::make_pair (start, start + busySlot / 5));
+    }
+  std::vector<uint64_t> durations;
+  double meanNs = load * biNs * 0.8 / (nCliques * nSegs);
+  for (uint32_t i = 0; i < nCliques * nSegs; i++)
+    {
+      durations.push_back (rng->GetInteger (1, (uint32_t) (2 * meanNs)));
+    }
+
+  SystemWallClockMs clock;
+  clock.Start ();
+  SpList sps = ScheduleAllocator (biNs, busy, durations);
+  int64_t allocatorMs = clock.End ();
+  std::cout << "DmgAirtimeAllocator: " << durations.size () << " SPs requested, "
+            << sps.size () << " SPs scheduled in " << allocatorMs << " ms" << std::endl;
+
+  if (legacy)
+    {
+      clock.Start ();
+      SpList legacySps = ScheduleLegacy (biNs, busy, durations);
+      int64_t legacyMs = clock.End ();
+      std::cout << "Legacy vector rows:  " << durations.size () << " SPs requested, "
+                << legacySps.size () << " SPs scheduled in " << legacyMs << " ms" << std::endl;
+      if (legacySps != sps)
+        {
+          std::cout << "ERROR: the two schedules differ" << std::endl;
+          return 1;
+        }
+    }
+  return 0;
+}
@@ -0,0 +1,151 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+/* Reader of the SP stats written by a DmgSpRecorder.
+ *
+ * By default it prints one line per link (transmitter, receiver) with the
+ * totals of its SPs: the fraction of the allocated time used by the
+ * exchanges, wasted in backlogged tails and spent before the first PPDU,
+ * the MPDUs per PPDU, the MPDUs added by SP tail packing, the fraction
+ * used by the reverse direction exchanges of the destination, the number of
+ * ACK sub-SPs and the goodput over the allocated time. With --csv it prints
+ * every record instead.
+ * --from and --to (ns) keep the SPs starting in [from, to).
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/dmg-sp-recorder.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <map>
+
+using namespace ns3;
+
+struct LinkTotals
+{
+  uint64_t nSps;
+  uint64_t allocatedNs;
+  uint64_t usedNs;
+  uint64_t tailNs;
+  uint64_t switchNs;
+  uint64_t bytes;
+  uint64_t nMpdus;
+  uint64_t nPpdus;
+  uint64_t nPacked;
+  uint64_t reverseNs;
+  uint64_t nAckSps;
+};
+
+int
+main (int argc, char *argv[])
+{
+  std::string input = "sp-stats.bin";
+  bool csv = false;
+  uint64_t from = 0;
+  uint64_t to = (uint64_t) -1;
+
+  CommandLine cmd;
+  cmd.AddValue ("input", "File written by a DmgSpRecorder", input);
+  cmd.AddValue ("csv", "Print every record instead of the totals per link", csv);
+  cmd.AddValue ("from", "Skip the SPs starting before this time (ns)", from);
+  cmd.AddValue ("to", "Skip the SPs starting from this time (ns)", to);
+  cmd.Parse (argc, argv);
+
+  DmgSpReader reader;
+  if (!reader.Open (input))
+    {
+      std::cerr << input << " is not a DMG SP stats file" << std::endl;
+      return 1;
+    }
+
+  if (csv)
+    {
+      std::cout << "source,destination,start,allocated,used,bytes,mpdus,ppdus,tail,switch,packed,reverse,ack" << std::endl;
+    }
+  std::map<std::pair<Mac48Address, Mac48Address>, LinkTotals> links;
+  DmgSpStats stats;
+  while (reader.Read (stats))
+    {
+      if (stats.startNs < from || stats.startNs >= to)
+        {
+          continue;
+        }
+      if (csv)
+        {
+          std::cout << stats.source << "," << stats.destination << "," << stats.startNs << ","
+                    << stats.allocatedNs << "," << stats.usedNs << "," << stats.bytes << ","
+                    << stats.nMpdus << "," << stats.nPpdus << "," << stats.tailNs << ","
+                    << stats.switchNs << "," << stats.nPacked << "," << stats.reverseNs << ","
+                    << stats.ack << std::endl;
+          continue;
+        }
+      std::pair<Mac48Address, Mac48Address> key (stats.source, stats.destination);
+      if (links.find (key) == links.end ())
+        {
+          LinkTotals zero = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+          links[key] = zero;
+        }
+      LinkTotals &link = links[key];
+      link.nSps++;
+      link.allocatedNs += stats.allocatedNs;
+      link.usedNs += stats.usedNs;
+      link.tailNs += stats.tailNs;
+      link.switchNs += stats.switchNs;
+      link.bytes += stats.bytes;
+      link.nMpdus += stats.nMpdus;
+      link.nPpdus += stats.nPpdus;
+      link.nPacked += stats.nPacked;
+      link.reverseNs += stats.reverseNs;
+      link.nAckSps += stats.ack;
+    }
+  if (csv)
+    {
+      return 0;
+    }
+
+  std::cout << std::setw (18) << "source" << std::setw (18) << "destination"
+            << std::setw (8) << "SPs" << std::setw (8) << "used" << std::setw (8) << "tail"
+            << std::setw (8) << "switch" << std::setw (10) << "MPDU/PPDU" << std::setw (8) << "packed"
+            << std::setw (8) << "reverse" << std::setw (8) << "ackSPs" << std::setw (10) << "Mbps"
+            << std::endl;
+  std::cout << std::fixed << std::setprecision (3);
+  for (std::map<std::pair<Mac48Address, Mac48Address>, LinkTotals>::const_iterator it = links.begin ();
+       it != links.end (); ++it)
+    {
+      const LinkTotals &link = it->second;
+      double allocated = link.allocatedNs ? link.allocatedNs : 1;
+      std::ostringstream source, destination;
+      source << it->first.first;
+      destination << it->first.second;
+      std::cout << std::setw (18) << source.str () << std::setw (18) << destination.str ()
+                << std::setw (8) << link.nSps
+                << std::setw (8) << link.usedNs / allocated
+                << std::setw (8) << link.tailNs / allocated
+                << std::setw (8) << link.switchNs / allocated
+                << std::setw (10) << (link.nPpdus ? (double) link.nMpdus / link.nPpdus : 0)
+                << std::setw (8) << link.nPacked
+                << std::setw (8) << link.reverseNs / allocated
+                << std::setw (8) << link.nAckSps
+                << std::setw (10) << link.bytes * 8 * 1e3 / allocated
+                << std::endl;
+    }
+  return 0;
+}
@@ -20,6 +20,7 @@
 
 #include "ns3/log.h"
 #include "abstract-antenna.h"
+#include <limits>
 
 namespace ns3 {
 
@@ -38,6 +39,26 @@ AbstractAntenna::GetTypeId (void)
 AbstractAntenna::AbstractAntenna() {}
 AbstractAntenna::~AbstractAntenna() {}
 
+void
+AbstractAntenna::GetTxGainsDbi (const double *azimuth, const double *elevation,
+                                double *gains, uint32_t n) const
+{
+  for (uint32_t i = 0; i < n; i++)
+    {
+      gains[i] = GetTxGainDbi (azimuth[i], elevation[i]);
+    }
+}
+
+void
+AbstractAntenna::GetRxGainsDbi (const double *azimuth, const double *elevation,
+                                double *gains, uint32_t n) const
+{
+  for (uint32_t i = 0; i < n; i++)
+    {
+      gains[i] = GetRxGainDbi (azimuth[i], elevation[i]);
+    }
+}
+
 void
 AbstractAntenna::SetAzimuthAngle (double azimuth)
 {
@@ -50,4 +71,16 @@ AbstractAntenna::GetBeamwidthDegrees (void) const
   return 360;
 }
 
+double
+AbstractAntenna::GetMaxGainDbi (void) const
+{
+  return std::numeric_limits<double>::infinity ();
+}
+
+Ptr<AbstractAntenna>
+AbstractAntenna::Copy (void) const
+{
+  return 0;
+}
+
 }
@@ -38,10 +38,23 @@ public:
 
     virtual double GetTxGainDbi(double azimuth, double elevation) const = 0;
     virtual double GetRxGainDbi(double azimuth, double elevation) const = 0;
+    // Gains toward n directions at once: gains[i] is the gain toward
+    // (azimuth[i], elevation[i]). One virtual call per batch; the default
+    // implementation loops over the single direction methods.
+    virtual void GetTxGainsDbi(const double *azimuth, const double *elevation,
+                               double *gains, uint32_t n) const;
+    virtual void GetRxGainsDbi(const double *azimuth, const double *elevation,
+                               double *gains, uint32_t n) const;
 
     //Set azimuth in radians
     virtual void SetAzimuthAngle (double azimuth);
     virtual double GetBeamwidthDegrees (void) const;
+    // Upper bound of the TX and RX gain over all directions, used to
+    // discard links that cannot be heard. Unbounded by default.
+    virtual double GetMaxGainDbi (void) const;
+    // Independent copy of the antenna, pointing included, or 0 if the
+    // antenna cannot be copied. Lets planning threads steer private copies.
+    virtual Ptr<AbstractAntenna> Copy (void) const;
 
 };
 
@@ -0,0 +1,174 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+#include "ampdu-container.h"
+#include "ampdu-subframe-header.h"
+#include "wifi-mac-trailer.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE ("AmpduContainer");
+
+namespace ns3 {
+
+AmpduContainer::AmpduContainer ()
+  : m_size (0)
+{
+}
+
+uint32_t
+AmpduContainer::CalculatePadding (uint32_t size)
+{
+  return (4 - (size % 4)) % 4;
+}
+
+void
+AmpduContainer::Add (Ptr<const Packet> payload, const WifiMacHeader &hdr)
+{
+  NS_LOG_FUNCTION (this << payload);
+  Mpdu mpdu;
+  mpdu.hdr = hdr;
+  mpdu.payload = payload;
+  mpdu.size = payload->GetSize () + hdr.GetSize () + WIFI_MAC_FCS_LENGTH;
+  AmpduSubframeHeader subframeHdr;
+  m_size += GetPadding () + subframeHdr.GetSerializedSize () + mpdu.size;
+  m_mpdus.push_back (mpdu);
+}
+
+void
+AmpduContainer::Clear (void)
+{
+  m_mpdus.clear ();
+  m_size = 0;
+}
+
+uint32_t
+AmpduContainer::GetNMpdus (void) const
+{
+  return m_mpdus.size ();
+}
+
+bool
+AmpduContainer::IsEmpty (void) const
+{
+  return m_mpdus.empty ();
+}
+
+uint32_t
+AmpduContainer::GetSize (void) const
+{
+  return m_size;
+}
+
+uint32_t
+AmpduContainer::GetPadding (void) const
+{
+  return CalculatePadding (m_size);
+}
+
+const WifiMacHeader &
+AmpduContainer::GetHeader (uint32_t i) const
+{
+  NS_ASSERT (i < m_mpdus.size ());
+  return m_mpdus[i].hdr;
+}
+
+Ptr<const Packet>
+AmpduContainer::GetPayload (uint32_t i) const
+{
+  NS_ASSERT (i < m_mpdus.size ());
+  return m_mpdus[i].payload;
+}
+
+uint32_t
+AmpduContainer::GetMpduSize (uint32_t i) const
+{
+  NS_ASSERT (i < m_mpdus.size ());
+  return m_mpdus[i].size;
+}
+
+uint32_t
+AmpduContainer::GetSubframeSize (uint32_t i) const
+{
+  NS_ASSERT (i < m_mpdus.size ());
+  AmpduSubframeHeader subframeHdr;
+  uint32_t size = subframeHdr.GetSerializedSize () + m_mpdus[i].size;
+  if (i + 1 < m_mpdus.size ())
+    {
+      size += CalculatePadding (size);
+    }
+  return size;
+}
+
+void
+AmpduContainer::SetDuration (Time duration)
+{
+  for (std::vector<Mpdu>::iterator it = m_mpdus.begin (); it != m_mpdus.end (); it++)
+    {
+      it->hdr.SetDuration (duration);
+    }
+}
+
+Ptr<Packet>
+AmpduContainer::GetMpdu (uint32_t i) const
+{
+  NS_ASSERT (i < m_mpdus.size ());
+  Ptr<Packet> packet = m_mpdus[i].payload->Copy ();
+  packet->AddHeader (m_mpdus[i].hdr);
+  WifiMacTrailer fcs;
+  packet->AddTrailer (fcs);
+  return packet;
+}
+
+Ptr<Packet>
+AmpduContainer::Serialize (void) const
+{
+  NS_LOG_FUNCTION (this);
+  Ptr<Packet> ampdu = Create<Packet> ();
+  for (uint32_t i = 0; i < m_mpdus.size (); i++)
+    {
+      Ptr<Packet> subframe = GetMpdu (i);
+      AmpduSubframeHeader subframeHdr;
+      subframeHdr.SetCrc (1);
+      subframeHdr.SetSig ();
+      subframeHdr.SetLength (m_mpdus[i].size);
+      subframe->AddHeader (subframeHdr);
+      ampdu->AddAtEnd (subframe);
+      uint32_t padding = GetSubframeSize (i) - subframe->GetSize ();
+      if (padding > 0)
+        {
+          ampdu->AddAtEnd (Create<Packet> (padding));
+        }
+    }
+  NS_ASSERT (ampdu->GetSize () == m_size);
+  return ampdu;
+}
+
+void
+AmpduContainer::PeekMacHeader (Ptr<const Packet> subframe, WifiMacHeader &hdr)
+{
+  // A copy shares the buffer of the subframe: removing the subframe header
+  // moves its start, no byte is copied
+  Ptr<Packet> mpdu = subframe->Copy ();
+  AmpduSubframeHeader subframeHdr;
+  mpdu->RemoveHeader (subframeHdr);
+  mpdu->PeekHeader (hdr);
+}
+
+} // namespace ns3
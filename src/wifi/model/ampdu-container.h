@@ -0,0 +1,143 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+#ifndef AMPDU_CONTAINER_H
+#define AMPDU_CONTAINER_H
+
+#include "ns3/simple-ref-count.h"
+#include "ns3/packet.h"
+#include "ns3/nstime.h"
+#include "wifi-mac-header.h"
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ *
+ * The MPDUs of an A-MPDU, kept as references to the MSDUs (or control
+ * payloads) and their MAC headers instead of a serialized packet.
+ *
+ * The size of each subframe (A-MPDU subframe header, MPDU and the padding
+ * to a multiple of 4 octets that follows every subframe but the last one)
+ * is computed when the MPDU is added, so the size of the A-MPDU is known
+ * without building it. The MPDUs are serialized one at a time when they
+ * are handed to the PHY; Serialize builds the whole A-MPDU for the users
+ * that need its bytes.
+ */
+class AmpduContainer : public SimpleRefCount<AmpduContainer>
+{
+public:
+  AmpduContainer ();
+
+  /**
+   * \param payload the MSDU or control frame body, not copied
+   * \param hdr the MAC header of the MPDU
+   *
+   * Append an MPDU to the A-MPDU.
+   */
+  void Add (Ptr<const Packet> payload, const WifiMacHeader &hdr);
+  /**
+   * Remove all the MPDUs.
+   */
+  void Clear (void);
+
+  /**
+   * \return the number of MPDUs
+   */
+  uint32_t GetNMpdus (void) const;
+  /**
+   * \return true if there are no MPDUs
+   */
+  bool IsEmpty (void) const;
+  /**
+   * \return the size of the serialized A-MPDU
+   */
+  uint32_t GetSize (void) const;
+  /**
+   * \return the padding that must follow the last subframe before a new
+   * one is appended
+   */
+  uint32_t GetPadding (void) const;
+
+  /**
+   * \param i the index of the MPDU
+   * \return the MAC header of the MPDU
+   */
+  const WifiMacHeader & GetHeader (uint32_t i) const;
+  /**
+   * \param i the index of the MPDU
+   * \return the payload of the MPDU
+   */
+  Ptr<const Packet> GetPayload (uint32_t i) const;
+  /**
+   * \param i the index of the MPDU
+   * \return the size of the MPDU, MAC header and FCS included
+   */
+  uint32_t GetMpduSize (uint32_t i) const;
+  /**
+   * \param i the index of the MPDU
+   * \return the size of the subframe of the MPDU in the A-MPDU, padding
+   * included
+   */
+  uint32_t GetSubframeSize (uint32_t i) const;
+
+  /**
+   * \param duration the Duration/ID field of the MPDUs
+   *
+   * Set the Duration/ID field of the header of every MPDU.
+   */
+  void SetDuration (Time duration);
+
+  /**
+   * \param i the index of the MPDU
+   * \return a new packet with the MPDU, MAC header and FCS included
+   */
+  Ptr<Packet> GetMpdu (uint32_t i) const;
+  /**
+   * \return a new packet with the A-MPDU, as the MpduStandardAggregator
+   * would have built it
+   */
+  Ptr<Packet> Serialize (void) const;
+
+  /**
+   * \param subframe an A-MPDU subframe, as handed to the PHY
+   * \param hdr the MAC header of the MPDU in the subframe
+   *
+   * Read the MAC header of the MPDU without deaggregating the subframe.
+   */
+  static void PeekMacHeader (Ptr<const Packet> subframe, WifiMacHeader &hdr);
+
+private:
+  struct Mpdu
+  {
+    WifiMacHeader hdr;
+    Ptr<const Packet> payload;
+    uint32_t size;
+  };
+
+  static uint32_t CalculatePadding (uint32_t size);
+
+  std::vector<Mpdu> m_mpdus;
+  uint32_t m_size; //!< size of the serialized A-MPDU
+};
+
+} // namespace ns3
+
+#endif /* AMPDU_CONTAINER_H */
@@ -25,6 +25,9 @@
 #include "ns3/string.h"
 #include "ns3/pointer.h"
 #include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include <algorithm>
+#include <cmath>
 
 namespace ns3 {
 
@@ -37,11 +40,27 @@ TypeId BeamformingEngine::GetTypeId (void)
     static TypeId tid = TypeId ("ns3::BeamformingEngine")
 	.SetParent<Object>()
 	.AddConstructor<BeamformingEngine>()
+	.AddAttribute ("Sectors",
+		       "Number of sectors of the codebook. 0: as many sectors as needed to cover "
+		       "360 degrees with the antenna beamwidth.",
+		       UintegerValue (0),
+		       MakeUintegerAccessor (&BeamformingEngine::m_sectors),
+		       MakeUintegerChecker<uint32_t> ())
+	.AddAttribute ("SswFrameDuration",
+		       "Airtime of a Sector Sweep frame, SBIFS included.",
+		       TimeValue (MicroSeconds (16)),
+		       MakeTimeAccessor (&BeamformingEngine::m_sswFrameDuration),
+		       MakeTimeChecker ())
+	.AddTraceSource ("SectorSweep",
+			 "A sector sweep toward a peer and its airtime",
+			 MakeTraceSourceAccessor (&BeamformingEngine::m_sectorSweepTrace),
+			 "ns3::BeamformingEngine::SectorSweepTracedCallback")
 	;
     return tid;
 }
 
 BeamformingEngine::BeamformingEngine()
+    : m_nSweeps (0)
 {
     NS_LOG_FUNCTION(this);
 }
@@ -51,4 +70,162 @@ BeamformingEngine::~BeamformingEngine()
     NS_LOG_FUNCTION(this);
 }
 
+void
+BeamformingEngine::DoDispose (void)
+{
+    NS_LOG_FUNCTION(this);
+    DisconnectMobility();
+    m_mobility = 0;
+    m_antenna = 0;
+    m_sweepAntenna = 0;
+    m_bestSector.clear();
+    Object::DoDispose();
+}
+
+void
+BeamformingEngine::DisconnectMobility (void)
+{
+    if (m_mobility != 0)
+    {
+	m_mobility->TraceDisconnectWithoutContext("CourseChange",
+		MakeCallback(&BeamformingEngine::NodeMoved, this));
+    }
+    for (std::set<Ptr<MobilityModel> >::iterator i = m_trackedPeers.begin(); i != m_trackedPeers.end(); ++i)
+    {
+	(*i)->TraceDisconnectWithoutContext("CourseChange",
+		MakeCallback(&BeamformingEngine::PeerMoved, this));
+    }
+    m_trackedPeers.clear();
+}
+
+void
+BeamformingEngine::SetAntenna (Ptr<AbstractAntenna> antenna)
+{
+    m_antenna = antenna;
+    m_sweepAntenna = antenna->Copy();
+    if (m_sweepAntenna == 0)
+    {
+	m_sweepAntenna = antenna;
+    }
+    InvalidateAll();
+}
+
+void
+BeamformingEngine::SetMobility (Ptr<MobilityModel> mobility)
+{
+    // The cache is dropped: stop tracking the previous node and the peers
+    DisconnectMobility();
+    m_mobility = mobility;
+    m_mobility->TraceConnectWithoutContext("CourseChange",
+	    MakeCallback(&BeamformingEngine::NodeMoved, this));
+    InvalidateAll();
+}
+
+uint32_t
+BeamformingEngine::GetNSectors (void) const
+{
+    if (m_sectors != 0)
+    {
+	return m_sectors;
+    }
+    NS_ASSERT (m_antenna != 0);
+    return (uint32_t) std::max(1.0, std::ceil(360 / m_antenna->GetBeamwidthDegrees() - 1e-9));
+}
+
+double
+BeamformingEngine::GetSectorAzimuth (uint32_t sector) const
+{
+    return 2 * M_PI * sector / GetNSectors();
+}
+
+uint32_t
+BeamformingEngine::GetBestSector (Ptr<MobilityModel> peer)
+{
+    std::map<Ptr<const MobilityModel>, uint32_t>::const_iterator i = m_bestSector.find(peer);
+    if (i != m_bestSector.end())
+    {
+	return i->second;
+    }
+    if (m_trackedPeers.insert(peer).second)
+    {
+	peer->TraceConnectWithoutContext("CourseChange",
+		MakeCallback(&BeamformingEngine::PeerMoved, this));
+    }
+    uint32_t sector = SectorSweep(peer);
+    m_bestSector[peer] = sector;
+    return sector;
+}
+
+uint32_t
+BeamformingEngine::SectorSweep (Ptr<const MobilityModel> peer)
+{
+    NS_LOG_FUNCTION(this << peer);
+    NS_ASSERT (m_sweepAntenna != 0 && m_mobility != 0);
+    Vector pos = m_mobility->GetPosition();
+    Vector peerPos = peer->GetPosition();
+    double azimuth = CalculateAzimuthAngle(pos, peerPos);
+    double elevation = CalculateElevationAngle(pos, peerPos);
+
+    // Highest gain toward the peer; among equal gains, the sector closest to
+    // the peer direction
+    uint32_t sectors = GetNSectors();
+    uint32_t best = 0;
+    double bestGain = 0;
+    double bestOffset = 0;
+    for (uint32_t s = 0; s < sectors; s++)
+    {
+	double sectorAzimuth = GetSectorAzimuth(s);
+	m_sweepAntenna->SetAzimuthAngle(sectorAzimuth);
+	double gain = m_sweepAntenna->GetTxGainDbi(azimuth, elevation);
+	double offset = std::fmod(std::fabs(azimuth - sectorAzimuth), 2 * M_PI);
+	offset = std::min(offset, 2 * M_PI - offset);
+	if (s == 0 || gain > bestGain || (gain == bestGain && offset < bestOffset))
+	{
+	    best = s;
+	    bestGain = gain;
+	    bestOffset = offset;
+	}
+    }
+    m_nSweeps++;
+    m_sectorSweepTrace(peer, GetSweepDuration());
+    NS_LOG_DEBUG("Sector " << best << " of " << sectors << " toward " << peerPos << ", gain " << bestGain << "dBi");
+    return best;
+}
+
+void
+BeamformingEngine::InvalidatePeer (Ptr<const MobilityModel> peer)
+{
+    m_bestSector.erase(peer);
+}
+
+void
+BeamformingEngine::InvalidateAll (void)
+{
+    m_bestSector.clear();
+}
+
+Time
+BeamformingEngine::GetSweepDuration (void) const
+{
+    return m_sswFrameDuration * (int64_t) GetNSectors();
+}
+
+uint32_t
+BeamformingEngine::GetNSweeps (void) const
+{
+    return m_nSweeps;
+}
+
+void
+BeamformingEngine::NodeMoved (Ptr<const MobilityModel>)
+{
+    InvalidateAll();
+}
+
+void
+BeamformingEngine::PeerMoved (Ptr<const MobilityModel> peer)
+{
+    InvalidatePeer(peer);
+}
+
 } // namespace ns3
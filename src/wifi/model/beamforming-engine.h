@@ -21,6 +21,12 @@
 #define BEAMFORMING_ENGINE_H
 
 #include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/abstract-antenna.h"
+#include "ns3/mobility-model.h"
+#include "ns3/traced-callback.h"
+#include <map>
+#include <set>
 
 namespace ns3 {
 
@@ -31,6 +37,17 @@ namespace ns3 {
  * The Beamforming Engine performs the beamforming procedures and protocols
  * with the guidance of the AWV Manager.
  *
+ * The antenna is steered over a discrete codebook of sectors: sector s
+ * points at azimuth 2*pi*s/N. The sector toward a peer is chosen by a
+ * transmit sector sweep (the gain toward the peer is measured for every
+ * sector, as in the Sector Level Sweep) and cached, so that pointing the
+ * antenna at a known peer is a table lookup. The cached sector of a peer is
+ * dropped when the node or the peer moves (CourseChange) or when the link is
+ * reported blocked.
+ *
+ * Every sweep costs N Sector Sweep frames of airtime, reported by the
+ * SectorSweep trace when it happens, so that it is charged to the Beacon
+ * Interval it happens in.
  */
 class BeamformingEngine : public Object
 {
@@ -39,8 +56,59 @@ public:
     virtual ~BeamformingEngine();
     static TypeId GetTypeId(void);
 
+    /* Antenna steered by the engine and mobility of its node */
+    void SetAntenna (Ptr<AbstractAntenna> antenna);
+    void SetMobility (Ptr<MobilityModel> mobility);
+
+    /* Number of sectors of the codebook: the Sectors attribute, or enough
+     * sectors of the antenna beamwidth to cover 360 degrees if it is 0 */
+    uint32_t GetNSectors (void) const;
+    /* Azimuth (radians) of the sector */
+    double GetSectorAzimuth (uint32_t sector) const;
+    /* Best TX sector toward peer. A sweep is done if it is not cached */
+    uint32_t GetBestSector (Ptr<MobilityModel> peer);
+
+    /* Drop the cached sector of peer (e.g. the link is blocked) */
+    void InvalidatePeer (Ptr<const MobilityModel> peer);
+    /* Drop all the cached sectors */
+    void InvalidateAll (void);
+
+    /* Airtime of one sweep: one SSW frame per sector */
+    Time GetSweepDuration (void) const;
+    /* Number of sweeps done so far */
+    uint32_t GetNSweeps (void) const;
+
+    /**
+     * TracedCallback signature for a sector sweep toward peer of airtime
+     * duration.
+     */
+    typedef void (* SectorSweepTracedCallback)(Ptr<const MobilityModel> peer, Time duration);
+
+protected:
+    virtual void DoDispose (void);
+
 private:
+    uint32_t SectorSweep (Ptr<const MobilityModel> peer);
+    void NodeMoved (Ptr<const MobilityModel> mobility);
+    void PeerMoved (Ptr<const MobilityModel> peer);
+    /* Disconnect the CourseChange of the node and of the peers */
+    void DisconnectMobility (void);
+
+    uint32_t m_sectors;
+    Time m_sswFrameDuration;
+
+    Ptr<AbstractAntenna> m_antenna;
+    /* Private copy of m_antenna swept during the searches, so that they do
+     * not change the pointing of the node (m_antenna itself if it cannot be
+     * copied) */
+    Ptr<AbstractAntenna> m_sweepAntenna;
+    Ptr<MobilityModel> m_mobility;
 
+    std::map<Ptr<const MobilityModel>, uint32_t> m_bestSector;
+    /* Peers whose CourseChange is connected */
+    std::set<Ptr<MobilityModel> > m_trackedPeers;
+    uint32_t m_nSweeps;
+    TracedCallback<Ptr<const MobilityModel>, Time> m_sectorSweepTrace;
 };
 
 } // namespace ns3
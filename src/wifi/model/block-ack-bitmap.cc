@@ -0,0 +1,140 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+#include "block-ack-bitmap.h"
+#include "ns3/assert.h"
+#include <cstring>
+
+namespace ns3 {
+
+/* Mask of the n bits of a word from bit offset */
+static inline uint64_t
+WordMask (uint32_t offset, uint32_t n)
+{
+  uint64_t mask = n < 64 ? (uint64_t (1) << n) - 1 : ~uint64_t (0);
+  return mask << offset;
+}
+
+BlockAckBitmap::BlockAckBitmap ()
+{
+  ResetAll ();
+}
+
+void
+BlockAckBitmap::Set (uint16_t seq)
+{
+  NS_ASSERT (seq < 4096);
+  uint64_t bit = uint64_t (1) << (seq & 63);
+  if (!(m_words[seq >> 6] & bit))
+    {
+      m_words[seq >> 6] |= bit;
+      m_count++;
+    }
+}
+
+void
+BlockAckBitmap::Reset (uint16_t seq)
+{
+  NS_ASSERT (seq < 4096);
+  uint64_t bit = uint64_t (1) << (seq & 63);
+  if (m_words[seq >> 6] & bit)
+    {
+      m_words[seq >> 6] &= ~bit;
+      m_count--;
+    }
+}
+
+bool
+BlockAckBitmap::IsSet (uint16_t seq) const
+{
+  NS_ASSERT (seq < 4096);
+  return (m_words[seq >> 6] >> (seq & 63)) & 1;
+}
+
+void
+BlockAckBitmap::ResetRange (uint16_t start, uint16_t end)
+{
+  NS_ASSERT (start < 4096 && end < 4096);
+  uint32_t pos = start;
+  uint32_t remaining = ((end - start + 4096) % 4096) + 1;
+  while (remaining > 0)
+    {
+      uint32_t offset = pos & 63;
+      uint32_t n = 64 - offset < remaining ? 64 - offset : remaining;
+      uint64_t cleared = m_words[pos >> 6] & WordMask (offset, n);
+      m_count -= __builtin_popcountll (cleared);
+      m_words[pos >> 6] &= ~cleared;
+      pos = (pos + n) % 4096;
+      remaining -= n;
+    }
+}
+
+void
+BlockAckBitmap::ResetAll (void)
+{
+  std::memset (m_words, 0, sizeof (m_words));
+  m_count = 0;
+}
+
+uint32_t
+BlockAckBitmap::GetCount (void) const
+{
+  return m_count;
+}
+
+bool
+BlockAckBitmap::FindFirst (uint16_t start, uint32_t count, uint16_t &seq) const
+{
+  NS_ASSERT (start < 4096 && count <= 4096);
+  if (m_count == 0)
+    {
+      return false;
+    }
+  uint32_t pos = start;
+  uint32_t remaining = count;
+  while (remaining > 0)
+    {
+      uint32_t offset = pos & 63;
+      uint32_t n = 64 - offset < remaining ? 64 - offset : remaining;
+      uint64_t bits = m_words[pos >> 6] & WordMask (offset, n);
+      if (bits)
+        {
+          seq = (pos & ~63) + __builtin_ctzll (bits);
+          return true;
+        }
+      pos = (pos + n) % 4096;
+      remaining -= n;
+    }
+  return false;
+}
+
+uint64_t
+BlockAckBitmap::GetWord (uint16_t start) const
+{
+  NS_ASSERT (start < 4096);
+  uint32_t offset = start & 63;
+  uint64_t word = m_words[start >> 6] >> offset;
+  if (offset)
+    {
+      word |= m_words[((start >> 6) + 1) % 64] << (64 - offset);
+    }
+  return word;
+}
+
+} // namespace ns3
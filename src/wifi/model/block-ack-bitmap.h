@@ -0,0 +1,190 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+#ifndef BLOCK_ACK_BITMAP_H
+#define BLOCK_ACK_BITMAP_H
+
+#include <stdint.h>
+#include <vector>
+#include "ns3/assert.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ *
+ * One bit per sequence number, for the whole sequence number space. The
+ * ranges are circular: they can wrap from 4095 to 0. Searches and range
+ * updates work on 64 sequence numbers at a time.
+ */
+class BlockAckBitmap
+{
+public:
+  BlockAckBitmap ();
+
+  void Set (uint16_t seq);
+  void Reset (uint16_t seq);
+  bool IsSet (uint16_t seq) const;
+  /**
+   * Reset the sequence numbers from start to end, both included.
+   */
+  void ResetRange (uint16_t start, uint16_t end);
+  void ResetAll (void);
+  /**
+   * \return the number of sequence numbers set
+   */
+  uint32_t GetCount (void) const;
+  /**
+   * \param start the first sequence number to look at
+   * \param count the number of sequence numbers to look at, at most 4096
+   * \param seq the first sequence number set, if any
+   * \return true if one of the count sequence numbers from start is set
+   */
+  bool FindFirst (uint16_t start, uint32_t count, uint16_t &seq) const;
+  /**
+   * \return the 64 bits of the sequence numbers from start: bit i is the
+   * one of start + i, like in a compressed BlockAck bitmap
+   */
+  uint64_t GetWord (uint16_t start) const;
+
+private:
+  uint64_t m_words[64];
+  uint32_t m_count;
+};
+
+/**
+ * \ingroup wifi
+ *
+ * Values indexed by sequence number, in seq % size slots. The size starts
+ * at 64, the largest block ack window, and doubles, up to the 4096
+ * sequence numbers, whenever two stored sequence numbers would share a
+ * slot. The sequence number arithmetic stays mod 4096.
+ */
+template <typename T>
+class BlockAckRing
+{
+public:
+  /**
+   * Store value with seq, replacing the value stored with seq.
+   */
+  void Insert (uint16_t seq, const T &value);
+  /**
+   * Free the slot of seq, if seq is stored.
+   */
+  void Remove (uint16_t seq);
+  /**
+   * \return the value stored with seq, which must be stored
+   */
+  T & Get (uint16_t seq);
+  const T & Get (uint16_t seq) const;
+  /**
+   * \return the number of slots
+   */
+  uint32_t GetSize (void) const;
+
+private:
+  struct Slot
+  {
+    Slot () : used (false), seq (0) {}
+    bool used;
+    uint16_t seq;
+    T value;
+  };
+  void Grow (void);
+
+  std::vector<Slot> m_slots;
+};
+
+template <typename T>
+void
+BlockAckRing<T>::Insert (uint16_t seq, const T &value)
+{
+  if (m_slots.empty ())
+    {
+      m_slots.resize (64);
+    }
+  while (m_slots[seq % m_slots.size ()].used && m_slots[seq % m_slots.size ()].seq != seq)
+    {
+      Grow ();
+    }
+  Slot &slot = m_slots[seq % m_slots.size ()];
+  slot.used = true;
+  slot.seq = seq;
+  slot.value = value;
+}
+
+template <typename T>
+void
+BlockAckRing<T>::Remove (uint16_t seq)
+{
+  if (m_slots.empty ())
+    {
+      return;
+    }
+  Slot &slot = m_slots[seq % m_slots.size ()];
+  if (slot.used && slot.seq == seq)
+    {
+      slot = Slot ();
+    }
+}
+
+template <typename T>
+T &
+BlockAckRing<T>::Get (uint16_t seq)
+{
+  NS_ASSERT (!m_slots.empty () && m_slots[seq % m_slots.size ()].used
+             && m_slots[seq % m_slots.size ()].seq == seq);
+  return m_slots[seq % m_slots.size ()].value;
+}
+
+template <typename T>
+const T &
+BlockAckRing<T>::Get (uint16_t seq) const
+{
+  NS_ASSERT (!m_slots.empty () && m_slots[seq % m_slots.size ()].used
+             && m_slots[seq % m_slots.size ()].seq == seq);
+  return m_slots[seq % m_slots.size ()].value;
+}
+
+template <typename T>
+uint32_t
+BlockAckRing<T>::GetSize (void) const
+{
+  return m_slots.size ();
+}
+
+template <typename T>
+void
+BlockAckRing<T>::Grow (void)
+{
+  NS_ASSERT (m_slots.size () < 4096);
+  std::vector<Slot> slots (m_slots.size () * 2);
+  for (uint32_t i = 0; i < m_slots.size (); i++)
+    {
+      if (m_slots[i].used)
+        {
+          slots[m_slots[i].seq % slots.size ()] = m_slots[i];
+        }
+    }
+  m_slots.swap (slots);
+}
+
+} // namespace ns3
+
+#endif /* BLOCK_ACK_BITMAP_H */
@@ -36,7 +36,8 @@ BlockAckCache::Init (uint16_t winStart, uint16_t winSize)
   m_winStart = winStart;
   m_winSize = winSize <= 64 ? winSize : 64;
   m_winEnd = (m_winStart + m_winSize - 1) % 4096;
-  memset (m_bitmap, 0, sizeof (m_bitmap));
+  m_received.ResetAll ();
+  m_fragmented.ResetAll ();
 }
 
 uint16_t
@@ -64,7 +65,14 @@ BlockAckCache::UpdateWithMpdu (const WifiMacHeader *hdr)
 
           WINSIZE_ASSERT;
         }
-      m_bitmap[seqNumber] |= (0x0001 << hdr->GetFragmentNumber ());
+      if (hdr->GetFragmentNumber () == 0)
+        {
+          m_received.Set (seqNumber);
+        }
+      else
+        {
+          m_fragmented.Set (seqNumber);
+        }
     }
 }
 
@@ -101,12 +109,8 @@ void
 BlockAckCache::ResetPortionOfBitmap (uint16_t start, uint16_t end)
 {
   NS_LOG_FUNCTION (this << start << end);
-  uint32_t i = start;
-  for (; i != end; i = (i + 1) % 4096)
-    {
-      m_bitmap[i] = 0;
-    }
-  m_bitmap[i] = 0;
+  m_received.ResetRange (start, end);
+  m_fragmented.ResetRange (start, end);
 }
 
 bool
@@ -126,19 +130,13 @@ BlockAckCache::FillBlockAckBitmap (CtrlBAckResponseHeader *blockAckHeader)
     }
   else if (blockAckHeader->IsCompressed ())
     {
-      uint32_t i = blockAckHeader->GetStartingSequence ();
-      uint32_t end = (i + m_winSize - 1) % 4096;
-      for (; i != end; i = (i + 1) % 4096)
-        {
-          if (m_bitmap[i] == 1)
-            {
-              blockAckHeader->SetReceivedPacket (i);
-            }
-        }
-      if (m_bitmap[i] == 1)
+      uint16_t start = blockAckHeader->GetStartingSequence ();
+      uint64_t received = m_received.GetWord (start) & ~m_fragmented.GetWord (start);
+      if (m_winSize < 64)
         {
-          blockAckHeader->SetReceivedPacket (i);
+          received &= (uint64_t (1) << m_winSize) - 1;
         }
+      blockAckHeader->SetCompressedBitmap (blockAckHeader->GetCompressedBitmap () | received);
     }
   else if (blockAckHeader->IsMultiTid ())
     {
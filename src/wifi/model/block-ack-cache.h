@@ -21,6 +21,7 @@
 #define BLOCK_ACK_CACHE_H
 
 #include <stdint.h>
+#include "block-ack-bitmap.h"
 
 namespace ns3 {
 
@@ -55,7 +56,10 @@ private:
   uint8_t m_winSize;
   uint16_t m_winEnd;
 
-  uint16_t m_bitmap[4096];
+  /* MPDUs received whole, and sequence numbers received in fragments: a
+     compressed block ack cannot acknowledge these */
+  BlockAckBitmap m_received;
+  BlockAckBitmap m_fragmented;
 };
 
 } // namespace ns3
@@ -49,6 +49,56 @@ BlockAckManager::Item::Item (Ptr<const Packet> packet, const WifiMacHeader &hdr,
   NS_LOG_FUNCTION (this << packet << hdr << tStamp);
 }
 
+BlockAckManager::Window::Window ()
+  : head (0)
+{
+}
+
+void
+BlockAckManager::Window::Store (const Item &item)
+{
+  NS_ASSERT_MSG (item.hdr.GetFragmentNumber () == 0 && !item.hdr.IsMoreFragments (),
+                 "Fragments are not supported under a block ack agreement");
+  uint16_t seq = item.hdr.GetSequenceNumber ();
+  if (stored.IsSet (seq))
+    {
+      /* A retransmission is stored again before it is removed from the
+         retransmissions: RemovePacket must keep this copy */
+      if (retry.IsSet (seq))
+        {
+          restored.Set (seq);
+        }
+    }
+  else
+    {
+      if (stored.GetCount () == 0 || QosUtilsIsOldPacket (head, seq))
+        {
+          head = seq;
+        }
+      stored.Set (seq);
+    }
+  items.Insert (seq, item);
+}
+
+void
+BlockAckManager::Window::Remove (uint16_t seq)
+{
+  items.Remove (seq);
+  stored.Reset (seq);
+  retry.Reset (seq);
+  restored.Reset (seq);
+  if (seq == head)
+    {
+      GetFirst (stored, head);
+    }
+}
+
+bool
+BlockAckManager::Window::GetFirst (const BlockAckBitmap &bits, uint16_t &seq) const
+{
+  return bits.FindFirst (head, 4096, seq);
+}
+
 Bar::Bar ()
 {
   NS_LOG_FUNCTION (this);
@@ -73,7 +123,6 @@ BlockAckManager::~BlockAckManager ()
   NS_LOG_FUNCTION (this);
   m_queue = 0;
   m_agreements.clear ();
-  m_retryPackets.clear ();
 }
 
 bool
@@ -132,8 +181,7 @@ BlockAckManager::CreateAgreement (const MgtAddBaRequestHeader *reqHdr, Mac48Addr
       agreement.SetDelayedBlockAck ();
     }
   agreement.SetState (OriginatorBlockAckAgreement::PENDING);
-  PacketQueue queue (0);
-  std::pair<OriginatorBlockAckAgreement, PacketQueue> value (agreement, queue);
+  std::pair<OriginatorBlockAckAgreement, Window> value (agreement, Window ());
   m_agreements.insert (std::make_pair (key, value));
   m_blockPackets (recipient, reqHdr->GetTid ());
 }
@@ -145,17 +193,6 @@ BlockAckManager::DestroyAgreement (Mac48Address recipient, uint8_t tid)
   AgreementsI it = m_agreements.find (std::make_pair (recipient, tid));
   if (it != m_agreements.end ())
     {
-      for (std::list<PacketQueueI>::iterator i = m_retryPackets.begin (); i != m_retryPackets.end ();)
-        {
-          if ((*i)->hdr.GetAddr1 () == recipient && (*i)->hdr.GetQosTid () == tid)
-            {
-              i = m_retryPackets.erase (i);
-            }
-          else
-            {
-              i++;
-            }
-        }
       m_agreements.erase (it);
       //remove scheduled bar
       for (std::list<Bar>::iterator i = m_bars.begin (); i != m_bars.end ();)
@@ -217,33 +254,7 @@ BlockAckManager::StorePacket (Ptr<const Packet> packet, const WifiMacHeader &hdr
   Item item (packet, hdr, tStamp);
   AgreementsI it = m_agreements.find (std::make_pair (recipient, tid));
   NS_ASSERT (it != m_agreements.end ());
-  PacketQueueI queueIt = it->second.second.begin ();
-  std::map<Mac48Address, uint64_t>::iterator itCounter =
-    m_mpduCounterPerDestination.find(recipient);
-
-  if (itCounter != m_mpduCounterPerDestination.end()) {
-    itCounter->second++;
-  } else {
-    m_mpduCounterPerDestination.insert(
-    std::pair<Mac48Address, uint64_t>(recipient, 1));
-  }
-
-  for (; queueIt != it->second.second.end ();)
-  {
-      if(((hdr.GetSequenceNumber () - queueIt->hdr.GetSequenceNumber () + 4096) % 4096) > 2047)
-      {
-          queueIt = it->second.second.insert (queueIt, item);
-          break;
-      }
-      else
-      {
-          queueIt++;
-      }
-  }
-  if(queueIt == it->second.second.end ())
-  {
-    it->second.second.push_back (item);
-  }
+  it->second.second.Store (item);
 }
 
 void
@@ -255,142 +266,111 @@ BlockAckManager::CompleteAmpduExchange(Mac48Address recipient, uint8_t tid)
   agreement.CompleteExchange ();
 }
 
+bool
+BlockAckManager::FindRetryPacket (AgreementsI begin, AgreementsI end, AgreementsI &agreement, uint16_t &seq)
+{
+  NS_LOG_FUNCTION (this);
+  for (agreement = begin; agreement != end; agreement++)
+    {
+      Window &window = agreement->second.second;
+      while (window.GetFirst (window.retry, seq))
+        {
+          if (!QosUtilsIsOldPacket (agreement->second.first.GetStartingSequence (), seq))
+            {
+              return true;
+            }
+          //standard says the originator should not send a packet with seqnum < winstart
+          NS_LOG_DEBUG ("The Retry packet have sequence number < WinStartO --> Discard " << seq << " " << agreement->second.first.GetStartingSequence ());
+          window.Remove (seq);
+        }
+    }
+  return false;
+}
+
+Ptr<const Packet>
+BlockAckManager::GetRetryPacket (AgreementsI agreement, uint16_t seq, WifiMacHeader &hdr)
+{
+  NS_LOG_FUNCTION (this << seq);
+  const Item &item = agreement->second.second.items.Get (seq);
+  if (seq > (agreement->second.first.GetStartingSequence () + 63) % 4096)
+    {
+      agreement->second.first.SetStartingSequence (seq);
+    }
+  Ptr<const Packet> packet = item.packet->Copy ();
+  hdr = item.hdr;
+  hdr.SetRetry ();
+  NS_LOG_INFO ("Retry packet seq = " << hdr.GetSequenceNumber ());
+  Mac48Address recipient = hdr.GetAddr1 ();
+  uint8_t tid = hdr.GetQosTid ();
+  if (!agreement->second.first.IsHtSupported ()
+      && (ExistsAgreementInState (recipient, tid, OriginatorBlockAckAgreement::ESTABLISHED)
+          || SwitchToBlockAckIfNeeded (recipient, tid, hdr.GetSequenceNumber ())))
+    {
+      hdr.SetQosAckPolicy (WifiMacHeader::BLOCK_ACK);
+    }
+  else
+    {
+      /* From section 9.10.3 in IEEE802.11e standard:
+       * In order to improve efficiency, originators using the Block Ack facility
+       * may send MPDU frames with the Ack Policy subfield in QoS control frames
+       * set to Normal Ack if only a few MPDUs are available for transmission.[...]
+       * When there are sufficient number of MPDUs, the originator may switch back to
+       * the use of Block Ack.
+       */
+      hdr.SetQosAckPolicy (WifiMacHeader::NORMAL_ACK);
+    }
+  return packet;
+}
+
 Ptr<const Packet>
 BlockAckManager::GetNextPacket (WifiMacHeader &hdr)
- {
-   NS_LOG_FUNCTION (this << &hdr);
-   Ptr<const Packet> packet = 0;
-   uint8_t tid;
-   Mac48Address recipient;
-   CleanupBuffers ();
-   if (!m_retryPackets.empty())
-     {
-       NS_LOG_DEBUG("Retry buffer size is " << m_retryPackets.size ());
-       std::list<PacketQueueI>::iterator it = m_retryPackets.begin ();  
-       while (it != m_retryPackets.end ())
-         {  
-           if ((*it)->hdr.IsQosData ())
-             tid = (*it)->hdr.GetQosTid ();
-           else
-             NS_FATAL_ERROR("Packet in blockAck manager retry queue is not Qos Data");
-           recipient = (*it)->hdr.GetAddr1 ();
-           AgreementsI agreement = m_agreements.find (std::make_pair (recipient, tid));
-           NS_ASSERT (agreement != m_agreements.end());
-           if (QosUtilsIsOldPacket (agreement->second.first.GetStartingSequence (),(*it)->hdr.GetSequenceNumber ()))
-             {
-               //standard says the originator should not send a packet with seqnum < winstart
-               NS_LOG_DEBUG("The Retry packet have sequence number < WinStartO --> Discard " << (*it)->hdr.GetSequenceNumber () << " " << agreement->second.first.GetStartingSequence ());
-               agreement->second.second.erase ((*it));   
-               it = m_retryPackets.erase (it);
-               continue;
-             }
-           else if ((*it)->hdr.GetSequenceNumber () > (agreement->second.first.GetStartingSequence ()+63) %4096)
-             {
-               agreement->second.first.SetStartingSequence ((*it)->hdr.GetSequenceNumber ());
-             }
-           packet = (*it)->packet->Copy();
-           hdr = (*it)->hdr;
-           hdr.SetRetry ();
-           NS_LOG_INFO ("Retry packet seq = " << hdr.GetSequenceNumber ());
-           if (hdr.IsQosData ())
-             tid = hdr.GetQosTid ();
-           else
-             NS_FATAL_ERROR("Packet in blockAck manager retry queue is not Qos Data");
-           recipient = hdr.GetAddr1 ();
-           if (!agreement->second.first.IsHtSupported ()
-               && (ExistsAgreementInState (recipient, tid, OriginatorBlockAckAgreement::ESTABLISHED)
-                  || SwitchToBlockAckIfNeeded (recipient, tid, hdr.GetSequenceNumber ())))
-             {
-                hdr.SetQosAckPolicy (WifiMacHeader::BLOCK_ACK);
-             }
-           else
-            {
-               /* From section 9.10.3 in IEEE802.11e standard:
-                * In order to improve efficiency, originators using the Block Ack facility
-                * may send MPDU frames with the Ack Policy subfield in QoS control frames
-                * set to Normal Ack if only a few MPDUs are available for transmission.[...]
-                * When there are sufficient number of MPDUs, the originator may switch back to
-                * the use of Block Ack.
-                */
-               hdr.SetQosAckPolicy (WifiMacHeader::NORMAL_ACK);
-               AgreementsI i = m_agreements.find (std::make_pair (recipient, tid));
-               i->second.second.erase (*it);
-             }
-           it = m_retryPackets.erase (it);
-           NS_LOG_DEBUG("Removed one packet retry buffer size = " <<m_retryPackets.size () );
-           break;
-         }
-     }
+{
+  NS_LOG_FUNCTION (this << &hdr);
+  CleanupBuffers ();
+  AgreementsI agreement;
+  uint16_t seq;
+  if (!FindRetryPacket (m_agreements.begin (), m_agreements.end (), agreement, seq))
+    {
+      return 0;
+    }
+  Ptr<const Packet> packet = GetRetryPacket (agreement, seq, hdr);
+  Window &window = agreement->second.second;
+  if (hdr.GetQosAckPolicy () == WifiMacHeader::NORMAL_ACK)
+    {
+      window.Remove (seq);
+    }
+  else
+    {
+      window.retry.Reset (seq);
+    }
+  NS_LOG_DEBUG ("Removed one packet retry buffer size = " << window.retry.GetCount ());
   return packet;
 }
 
 Ptr<const Packet>
 BlockAckManager::GetNextPacketByAddress (WifiMacHeader &hdr, Mac48Address recipient)
- {
-   NS_LOG_FUNCTION (this << &hdr);
-   Ptr<const Packet> packet = 0;
-   uint8_t tid;
-   CleanupBuffers ();
-   if (!m_retryPackets.empty())
-     {
-       NS_LOG_DEBUG("Retry buffer size is " << m_retryPackets.size ());
-       std::list<PacketQueueI>::iterator it = m_retryPackets.begin ();
-       while (it != m_retryPackets.end ())
-         {
-          if ((*it)->hdr.GetAddr1 () == recipient) {
-           if ((*it)->hdr.IsQosData ())
-             tid = (*it)->hdr.GetQosTid ();
-           else
-             NS_FATAL_ERROR("Packet in blockAck manager retry queue is not Qos Data");
-           AgreementsI agreement = m_agreements.find (std::make_pair (recipient, tid));
-           NS_ASSERT (agreement != m_agreements.end());
-           if (QosUtilsIsOldPacket (agreement->second.first.GetStartingSequence (),(*it)->hdr.GetSequenceNumber ()))
-             {
-               //standard says the originator should not send a packet with seqnum < winstart
-               NS_LOG_DEBUG("The Retry packet have sequence number < WinStartO --> Discard " << (*it)->hdr.GetSequenceNumber () << " " << agreement->second.first.GetStartingSequence ());
-               agreement->second.second.erase ((*it));
-               it = m_retryPackets.erase (it);
-               continue;
-             }
-           else if ((*it)->hdr.GetSequenceNumber () > (agreement->second.first.GetStartingSequence ()+63) %4096)
-             {
-               agreement->second.first.SetStartingSequence ((*it)->hdr.GetSequenceNumber ());
-             }
-           packet = (*it)->packet->Copy();
-           hdr = (*it)->hdr;
-           hdr.SetRetry ();
-           NS_LOG_INFO ("Retry packet seq = " << hdr.GetSequenceNumber ());
-           if (hdr.IsQosData ())
-             tid = hdr.GetQosTid ();
-           else
-             NS_FATAL_ERROR("Packet in blockAck manager retry queue is not Qos Data");
-           if (!agreement->second.first.IsHtSupported ()
-               && (ExistsAgreementInState (recipient, tid, OriginatorBlockAckAgreement::ESTABLISHED)
-                  || SwitchToBlockAckIfNeeded (recipient, tid, hdr.GetSequenceNumber ())))
-             {
-                hdr.SetQosAckPolicy (WifiMacHeader::BLOCK_ACK);
-             }
-           else
-            {
-               /* From section 9.10.3 in IEEE802.11e standard:
-                * In order to improve efficiency, originators using the Block Ack facility
-                * may send MPDU frames with the Ack Policy subfield in QoS control frames
-                * set to Normal Ack if only a few MPDUs are available for transmission.[...]
-                * When there are sufficient number of MPDUs, the originator may switch back to
-                * the use of Block Ack.
-                */
-               hdr.SetQosAckPolicy (WifiMacHeader::NORMAL_ACK);
-               AgreementsI i = m_agreements.find (std::make_pair (recipient, tid));
-               i->second.second.erase (*it);
-             }
-           it = m_retryPackets.erase (it);
-           NS_LOG_DEBUG("Removed one packet retry buffer size = " <<m_retryPackets.size () );
-           break;
-         } else {
-           it++;
-         }
-        }
-     }
+{
+  NS_LOG_FUNCTION (this << &hdr << recipient);
+  CleanupBuffers ();
+  AgreementsI agreement;
+  uint16_t seq;
+  if (!FindRetryPacket (m_agreements.lower_bound (std::make_pair (recipient, 0)),
+                        m_agreements.upper_bound (std::make_pair (recipient, 255)),
+                        agreement, seq))
+    {
+      return 0;
+    }
+  Ptr<const Packet> packet = GetRetryPacket (agreement, seq, hdr);
+  Window &window = agreement->second.second;
+  if (hdr.GetQosAckPolicy () == WifiMacHeader::NORMAL_ACK)
+    {
+      window.Remove (seq);
+    }
+  else
+    {
+      window.retry.Reset (seq);
+    }
+  NS_LOG_DEBUG ("Removed one packet retry buffer size = " << window.retry.GetCount ());
   return packet;
 }
 
@@ -398,137 +378,58 @@ Ptr<const Packet>
 BlockAckManager::PeekNextPacket (WifiMacHeader &hdr, Mac48Address recipient, uint8_t tid, Time *tstamp)
 {
   NS_LOG_FUNCTION (this);
-  Ptr<const Packet> packet = 0;
   CleanupBuffers ();
-  AgreementsI agreement = m_agreements.find (std::make_pair (recipient, tid));
-  NS_ASSERT (agreement != m_agreements.end());
-  std::list<PacketQueueI>::iterator it = m_retryPackets.begin ();
-  for (; it != m_retryPackets.end();it++)
+  AgreementsI it = m_agreements.find (std::make_pair (recipient, tid));
+  NS_ASSERT (it != m_agreements.end ());
+  AgreementsI end = it;
+  end++;
+  AgreementsI agreement;
+  uint16_t seq;
+  if (!FindRetryPacket (it, end, agreement, seq))
     {
-       if ((*it)->hdr.GetAddr1 () == recipient && (*it)->hdr.GetQosTid () == tid)
-       {
-         if (QosUtilsIsOldPacket (agreement->second.first.GetStartingSequence (),(*it)->hdr.GetSequenceNumber ()))
-           {
-               //standard says the originator should not send a packet with seqnum < winstart
-               NS_LOG_DEBUG("The Retry packet have sequence number < WinStartO --> Discard " << (*it)->hdr.GetSequenceNumber () << " " << agreement->second.first.GetStartingSequence ());
-               agreement->second.second.erase ((*it));
-               it = m_retryPackets.erase (it);
-                it--;
-               continue;
-           }
-          else if ((*it)->hdr.GetSequenceNumber () > (agreement->second.first.GetStartingSequence () + 63) % 4096)
-            {
-               agreement->second.first.SetStartingSequence ((*it)->hdr.GetSequenceNumber ());
-            }
-        packet = (*it)->packet->Copy();
-        hdr = (*it)->hdr;
-        hdr.SetRetry ();
-        *tstamp = (*it)->timestamp;
-        NS_LOG_INFO ("Retry packet seq = " << hdr.GetSequenceNumber ());
-            Mac48Address recipient = hdr.GetAddr1 ();
-           if (!agreement->second.first.IsHtSupported ()
-               && (ExistsAgreementInState (recipient, tid, OriginatorBlockAckAgreement::ESTABLISHED)
-                  || SwitchToBlockAckIfNeeded (recipient, tid, hdr.GetSequenceNumber ())))
-             {
-                hdr.SetQosAckPolicy (WifiMacHeader::BLOCK_ACK);
-             }
-          else
-            {
-                /* From section 9.10.3 in IEEE802.11e standard:
-                 * In order to improve efficiency, originators using the Block Ack facility
-                 * may send MPDU frames with the Ack Policy subfield in QoS control frames
-                 * set to Normal Ack if only a few MPDUs are available for transmission.[...]
-                 * When there are sufficient number of MPDUs, the originator may switch back to
-                 * the use of Block Ack.
-                 */
-                hdr.SetQosAckPolicy (WifiMacHeader::NORMAL_ACK);
-             }
-          NS_LOG_DEBUG("Peeked one packet from retry buffer size = " << m_retryPackets.size () );
-         return packet;
-      }
+      return 0;
     }
-  return packet;
+  *tstamp = agreement->second.second.items.Get (seq).timestamp;
+  return GetRetryPacket (agreement, seq, hdr);
 }
 
 Ptr<const Packet>
 BlockAckManager::PeekNextPacketByAddress (WifiMacHeader &hdr, Mac48Address recipient, Time *tstamp)
 {
   NS_LOG_FUNCTION (this);
-  Ptr<const Packet> packet = 0;
   CleanupBuffers ();
-  std::list<PacketQueueI>::iterator it = m_retryPackets.begin ();
-  for (; it != m_retryPackets.end();it++)
+  AgreementsI agreement;
+  uint16_t seq;
+  if (!FindRetryPacket (m_agreements.lower_bound (std::make_pair (recipient, 0)),
+                        m_agreements.upper_bound (std::make_pair (recipient, 255)),
+                        agreement, seq))
     {
-       if ((*it)->hdr.GetAddr1 () == recipient)
-       {
-          uint8_t tid = (*it)->hdr.GetQosTid ();
-          AgreementsI agreement = m_agreements.find (std::make_pair (recipient, tid));
-          NS_ASSERT (agreement != m_agreements.end());
-         if (QosUtilsIsOldPacket (agreement->second.first.GetStartingSequence (),(*it)->hdr.GetSequenceNumber ()))
-           { 
-               //standard says the originator should not send a packet with seqnum < winstart
-               NS_LOG_DEBUG("The Retry packet have sequence number < WinStartO --> Discard " << (*it)->hdr.GetSequenceNumber () << " " << agreement->second.first.GetStartingSequence ());
-               agreement->second.second.erase ((*it));   
-               it = m_retryPackets.erase (it);
-                it--; 
-               continue;
-           }
-          else if ((*it)->hdr.GetSequenceNumber () > (agreement->second.first.GetStartingSequence () + 63) % 4096)
-            {
-               agreement->second.first.SetStartingSequence ((*it)->hdr.GetSequenceNumber ());
-            }
-        packet = (*it)->packet->Copy();
-        hdr = (*it)->hdr;
-        hdr.SetRetry ();
-        *tstamp = (*it)->timestamp;
-        NS_LOG_INFO ("Retry packet seq = " << hdr.GetSequenceNumber ());
-            Mac48Address recipient = hdr.GetAddr1 ();
-           if (!agreement->second.first.IsHtSupported ()
-               && (ExistsAgreementInState (recipient, tid, OriginatorBlockAckAgreement::ESTABLISHED)
-                  || SwitchToBlockAckIfNeeded (recipient, tid, hdr.GetSequenceNumber ())))
-             {
-                hdr.SetQosAckPolicy (WifiMacHeader::BLOCK_ACK);
-             }
-          else
-            {
-                /* From section 9.10.3 in IEEE802.11e standard:
-                 * In order to improve efficiency, originators using the Block Ack facility
-                 * may send MPDU frames with the Ack Policy subfield in QoS control frames
-                 * set to Normal Ack if only a few MPDUs are available for transmission.[...]
-                 * When there are sufficient number of MPDUs, the originator may switch back to
-                 * the use of Block Ack.
-                 */
-                hdr.SetQosAckPolicy (WifiMacHeader::NORMAL_ACK);
-             }
-          NS_LOG_DEBUG("Peeked one packet from retry buffer size = " << m_retryPackets.size () );
-         return packet;        
-      }
+      return 0;
     }
-  return packet;
+  *tstamp = agreement->second.second.items.Get (seq).timestamp;
+  return GetRetryPacket (agreement, seq, hdr);
 }
 
 bool
 BlockAckManager::RemovePacket (uint8_t tid, Mac48Address recipient, uint16_t seqnumber)
 {
-
-  std::list<PacketQueueI>::iterator it = m_retryPackets.begin ();                
-  for (; it != m_retryPackets.end (); it++)
+  AgreementsI it = m_agreements.find (std::make_pair (recipient, tid));
+  if (it == m_agreements.end () || !it->second.second.retry.IsSet (seqnumber))
     {
-      if ((*it)->hdr.GetAddr1 () == recipient && (*it)->hdr.GetQosTid () == tid && (*it)->hdr.GetSequenceNumber () == seqnumber)
-        {
-          WifiMacHeader hdr = (*it)->hdr;
-          uint8_t tid = hdr.GetQosTid ();
-          Mac48Address recipient = hdr.GetAddr1 ();
-
-          AgreementsI i = m_agreements.find (std::make_pair (recipient, tid));
-          i->second.second.erase ((*it));
-
-          m_retryPackets.erase (it);  
-          NS_LOG_DEBUG("Removed Packet from retry queue = " << hdr.GetSequenceNumber () << " " << (uint32_t) tid << " " << recipient << " Buffer Size = " << m_retryPackets.size ());
-          return true;
-        }
+      return false;
     }
-  return false;
+  Window &window = it->second.second;
+  if (window.restored.IsSet (seqnumber))
+    {
+      window.restored.Reset (seqnumber);
+      window.retry.Reset (seqnumber);
+    }
+  else
+    {
+      window.Remove (seqnumber);
+    }
+  NS_LOG_DEBUG ("Removed Packet from retry queue = " << seqnumber << " " << (uint32_t) tid << " " << recipient << " Buffer Size = " << window.retry.GetCount ());
+  return true;
 }
 
 bool
@@ -563,30 +464,28 @@ bool
 BlockAckManager::HasPackets (void) const
 {
   NS_LOG_FUNCTION (this);
-  return (m_retryPackets.size () > 0 || m_bars.size () > 0);
+  if (m_bars.size () > 0)
+    {
+      return true;
+    }
+  for (AgreementsCI it = m_agreements.begin (); it != m_agreements.end (); it++)
+    {
+      if (it->second.second.retry.GetCount () > 0)
+        {
+          return true;
+        }
+    }
+  return false;
 }
 
 uint32_t
 BlockAckManager::GetNBufferedPackets (Mac48Address recipient, uint8_t tid) const
 {
   NS_LOG_FUNCTION (this << recipient << static_cast<uint32_t> (tid));
-  uint32_t nPackets = 0;
-  if (ExistsAgreement (recipient, tid))
+  AgreementsCI it = m_agreements.find (std::make_pair (recipient, tid));
+  if (it != m_agreements.end ())
     {
-      AgreementsCI it = m_agreements.find (std::make_pair (recipient, tid));
-      PacketQueueCI queueIt = (*it).second.second.begin ();
-      uint16_t currentSeq = 0;
-      while (queueIt != (*it).second.second.end ())
-        {
-          currentSeq = (*queueIt).hdr.GetSequenceNumber ();
-          nPackets++;
-          /* a fragmented packet must be counted as one packet */
-          while (queueIt != (*it).second.second.end () && (*queueIt).hdr.GetSequenceNumber () == currentSeq)
-            {
-              queueIt++;
-            }
-        }
-      return nPackets;
+      return it->second.second.stored.GetCount ();
     }
   return 0;
 }
@@ -595,31 +494,12 @@ uint32_t
 BlockAckManager::GetNRetryNeededPackets (Mac48Address recipient, uint8_t tid) const
 {
   NS_LOG_FUNCTION (this << recipient << static_cast<uint32_t> (tid));
-  uint32_t nPackets = 0;
-  uint16_t currentSeq = 0;
-  if (ExistsAgreement (recipient, tid))
+  AgreementsCI it = m_agreements.find (std::make_pair (recipient, tid));
+  if (it != m_agreements.end ())
     {
-      std::list<PacketQueueI>::const_iterator it = m_retryPackets.begin ();
-      while (it != m_retryPackets.end ())
-        {
-          if ((*it)->hdr.GetAddr1 () == recipient && (*it)->hdr.GetQosTid () == tid)
-            {
-              currentSeq = (*it)->hdr.GetSequenceNumber ();
-              nPackets++;
-              /* a fragmented packet must be counted as one packet */
-              while (it != m_retryPackets.end () && (*it)->hdr.GetSequenceNumber () == currentSeq)
-                {
-                  it++;
-                }
-            }
-          //go to next packet
-          if (it != m_retryPackets.end ())
-            {
-              it++;
-            }
-        }
+      return it->second.second.retry.GetCount ();
     }
-  return nPackets;
+  return 0;
 }
 
 void
@@ -639,15 +519,8 @@ BlockAckManager::SetWifiRemoteStationManager (Ptr<WifiRemoteStationManager> mana
 bool
 BlockAckManager::AlreadyExists(uint16_t currentSeq, Mac48Address recipient, uint8_t tid)
 {
-  std::list<PacketQueueI>::const_iterator it = m_retryPackets.begin ();
-  while (it != m_retryPackets.end ())
-    {
-       NS_LOG_FUNCTION (this<<(*it)->hdr.GetType());
-       if ((*it)->hdr.GetAddr1 () == recipient && (*it)->hdr.GetQosTid () == tid && currentSeq == (*it)->hdr.GetSequenceNumber ())
-         return true;
-       it++;
-     }
-  return false;
+  AgreementsCI it = m_agreements.find (std::make_pair (recipient, tid));
+  return it != m_agreements.end () && it->second.second.retry.IsSet (currentSeq);
 }
 
 void
@@ -662,7 +535,7 @@ BlockAckManager::NotifyGotBlockAck (const CtrlBAckResponseHeader *blockAck, Mac4
         {
           bool foundFirstLost = false;
           AgreementsI it = m_agreements.find (std::make_pair (recipient, tid));
-          PacketQueueI queueEnd = it->second.second.end ();
+          Window &window = it->second.second;
 
           if (it->second.first.m_inactivityEvent.IsRunning ())
             {
@@ -676,94 +549,80 @@ BlockAckManager::NotifyGotBlockAck (const CtrlBAckResponseHeader *blockAck, Mac4
                                                                         this,
                                                                         recipient, tid);
             }
+          /* The packets are visited in order of sequence number, from the
+             oldest one: every step finds the next one in the bitmap */
+          uint32_t nPackets = window.stored.GetCount ();
+          uint16_t from = window.head;
+          uint16_t seq;
           if (blockAck->IsBasic ())
             {
-              for (PacketQueueI queueIt = it->second.second.begin (); queueIt != queueEnd;)
+              for (uint32_t n = 0; n < nPackets && window.stored.FindFirst (from, 4096, seq); n++)
                 {
-                  if (blockAck->IsFragmentReceived ((*queueIt).hdr.GetSequenceNumber (),
-                                                    (*queueIt).hdr.GetFragmentNumber ()))
+                  from = (seq + 1) % 4096;
+                  if (blockAck->IsFragmentReceived (seq, window.items.Get (seq).hdr.GetFragmentNumber ()))
                     {
-                      queueIt = it->second.second.erase (queueIt);
+                      window.Remove (seq);
                     }
                   else
                     {
                       if (!foundFirstLost)
                         {
                           foundFirstLost = true;
-                          sequenceFirstLost = (*queueIt).hdr.GetSequenceNumber ();
+                          sequenceFirstLost = seq;
                           (*it).second.first.SetStartingSequence (sequenceFirstLost);
                         }
-
-                      if (!AlreadyExists((*queueIt).hdr.GetSequenceNumber (),recipient,tid))
-                        InsertInRetryQueue(queueIt);
-
-                      queueIt++;
+                      window.retry.Set (seq);
                     }
                 }
             }
           else if (blockAck->IsCompressed ())
             {
-              for (PacketQueueI queueIt = it->second.second.begin (); queueIt != queueEnd;)
+              uint16_t startingSeq = blockAck->GetStartingSequence ();
+              uint64_t bitmap = blockAck->GetCompressedBitmap ();
+              uint64_t nSuccesses = 0;
+              uint64_t nFailures = 0;
+              for (uint32_t n = 0; n < nPackets && window.stored.FindFirst (from, 4096, seq); n++)
                 {
-                  if (blockAck->IsPacketReceived ((*queueIt).hdr.GetSequenceNumber ()))
+                  from = (seq + 1) % 4096;
+                  uint16_t index = (seq - startingSeq + 4096) % 4096;
+                  const WifiMacHeader &hdr = window.items.Get (seq).hdr;
+                  if (index < 64 && ((bitmap >> index) & 1))
                     {
-                      uint16_t currentSeq = (*queueIt).hdr.GetSequenceNumber ();
-
-                      std::map<Mac48Address, uint64_t>::iterator itSuccesses =
-	                      m_mpduSuccessesPerDestination.find(recipient);
-
-                      if (itSuccesses != m_mpduSuccessesPerDestination.end()) {
-                        itSuccesses->second++;
-                      } else {
-                        m_mpduSuccessesPerDestination.insert(
-	                        std::pair<Mac48Address, uint64_t>(recipient, 1));
-                      }
-
-                      while (queueIt != queueEnd
-                             && (*queueIt).hdr.GetSequenceNumber () == currentSeq)
+                      nSuccesses++;
+                      //notify remote station of successful transmission
+                      m_stationManager->ReportDataOk (hdr.GetAddr1 (), &hdr, 0, txMode, 0);
+                      if (!m_txOkCallback.IsNull ())
                         {
-                          //notify remote station of successful transmission
-                          m_stationManager->ReportDataOk ((*queueIt).hdr.GetAddr1 (), &(*queueIt).hdr, 0, txMode, 0);
-                          if (!m_txOkCallback.IsNull ())
-                            {
-                              m_txOkCallback ((*queueIt).hdr);
-                            }
-                          queueIt = it->second.second.erase (queueIt);
+                          m_txOkCallback (hdr);
                         }
+                      window.Remove (seq);
                     }
                   else
                     {
-                      std::map<Mac48Address, uint64_t>::iterator itFailures =
-	                      m_mpduFailuresPerDestination.find(recipient);
-
-                      if (itFailures != m_mpduFailuresPerDestination.end()) {
-                        itFailures->second++;
-                      } else {
-                        m_mpduFailuresPerDestination.insert(
-	                        std::pair<Mac48Address, uint64_t>(recipient, 1));
-                      }
-
+                      nFailures++;
                       if (!foundFirstLost)
                         {
                           foundFirstLost = true;
-                          sequenceFirstLost = (*queueIt).hdr.GetSequenceNumber ();
+                          sequenceFirstLost = seq;
                           (*it).second.first.SetStartingSequence (sequenceFirstLost);
                         }
                       //notify remote station of unsuccessful transmission
-                      m_stationManager->ReportDataFailed ((*queueIt).hdr.GetAddr1 (), &(*queueIt).hdr);
+                      m_stationManager->ReportDataFailed (hdr.GetAddr1 (), &hdr);
                       if (!m_txFailedCallback.IsNull ())
                         {
-                          m_txFailedCallback ((*queueIt).hdr);
-                        }
-                      if (!AlreadyExists((*queueIt).hdr.GetSequenceNumber (),recipient,tid))
-                        {
-                          InsertInRetryQueue(queueIt);
+                          m_txFailedCallback (hdr);
                         }
-                      queueIt++;
+                      window.retry.Set (seq);
                     }
                 }
-
-              //NS_ASSERT(m_mpduCounter == (m_mpduSuccesses + m_mpduFailures));
+              if (nSuccesses > 0)
+                {
+                  m_mpduSuccessesPerDestination[recipient] += nSuccesses;
+                }
+              if (nFailures > 0)
+                {
+                  m_mpduFailuresPerDestination[recipient] += nFailures;
+                }
             }
           uint16_t newSeq = m_txMiddle->GetNextSeqNumberByTidAndAddress (tid, recipient);
           if ((foundFirstLost && !SwitchToBlockAckIfNeeded (recipient, tid, sequenceFirstLost))
@@ -923,29 +782,30 @@ bool
 BlockAckManager::HasOtherFragments (uint16_t sequenceNumber) const
 {
   NS_LOG_FUNCTION (this << sequenceNumber);
-  bool retVal = false;
-  if (m_retryPackets.size () > 0)
+  uint16_t seq;
+  for (AgreementsCI it = m_agreements.begin (); it != m_agreements.end (); it++)
     {
-      Item next = *(m_retryPackets.front ());
-      if (next.hdr.GetSequenceNumber () == sequenceNumber)
+      if (it->second.second.GetFirst (it->second.second.retry, seq))
         {
-          retVal = true;
+          return seq == sequenceNumber;
         }
     }
-  return retVal;
+  return false;
 }
 
 uint32_t
 BlockAckManager::GetNextPacketSize (void) const
 {
   NS_LOG_FUNCTION (this);
-  uint32_t size = 0;
-  if (m_retryPackets.size () > 0)
+  uint16_t seq;
+  for (AgreementsCI it = m_agreements.begin (); it != m_agreements.end (); it++)
     {
-      Item next = *(m_retryPackets.front ());
-      size = next.packet->GetSize ();
+      if (it->second.second.GetFirst (it->second.second.retry, seq))
+        {
+          return it->second.second.items.Get (seq).packet->GetSize ();
+        }
     }
-  return size;
+  return 0;
 }
 
 bool BlockAckManager::NeedBarRetransmission (uint8_t tid, uint16_t seqNumber, Mac48Address recipient)
@@ -965,41 +825,39 @@ void
 BlockAckManager::CleanupBuffers (void)
 {
   NS_LOG_FUNCTION (this);
+  Time now = Simulator::Now ();
   for (AgreementsI j = m_agreements.begin (); j != m_agreements.end (); j++)
     {
-      if (j->second.second.empty ())
+      Window &window = j->second.second;
+      if (window.stored.GetCount () == 0)
         {
           continue;
         }
-      Time now = Simulator::Now ();
-      PacketQueueI end = j->second.second.begin ();
-      for (PacketQueueI i = j->second.second.begin (); i != j->second.second.end (); i++)
+      /* Look for the oldest packet whose lifetime did not expire: the
+         packets before it are removed. If all the lifetimes expired, the
+         packets are kept but are not retransmitted */
+      uint32_t nPackets = window.stored.GetCount ();
+      uint16_t from = window.head;
+      uint16_t seq;
+      bool found = false;
+      for (uint32_t n = 0; n < nPackets && window.stored.FindFirst (from, 4096, seq); n++)
         {
-          if (i->timestamp + m_maxDelay > now)
+          if (window.items.Get (seq).timestamp + m_maxDelay > now)
             {
-              end = i;
+              found = true;
               break;
             }
-          else
+          window.retry.Reset (seq);
+          from = (seq + 1) % 4096;
+        }
+      if (found)
+        {
+          while (window.head != seq)
             {
-              /* remove retry packet iterator if it's present in retry queue */
-              for (std::list<PacketQueueI>::iterator it = m_retryPackets.begin (); it != m_retryPackets.end ();)
-                {
-                  if ((*it)->hdr.GetAddr1 () == j->second.first.GetPeer ()
-                      && (*it)->hdr.GetQosTid () == j->second.first.GetTid ()
-                      && (*it)->hdr.GetSequenceNumber () == i->hdr.GetSequenceNumber ())
-                    {
-                        it = m_retryPackets.erase (it);
-                    }
-                  else
-                    {
-                      it++;
-                    }
-                }
+              window.Remove (window.head);
             }
         }
-      j->second.second.erase (j->second.second.begin (), end);
-      j->second.first.SetStartingSequence (end->hdr.GetSequenceNumber ());
+      j->second.first.SetStartingSequence (window.head);
     }
 }
 
@@ -1042,14 +900,11 @@ uint16_t
 BlockAckManager::GetSeqNumOfNextRetryPacket (Mac48Address recipient, uint8_t tid) const
 {
   NS_LOG_FUNCTION (this << recipient << static_cast<uint32_t> (tid));
-  std::list<PacketQueueI>::const_iterator it = m_retryPackets.begin ();
-  while (it != m_retryPackets.end ())
+  AgreementsCI it = m_agreements.find (std::make_pair (recipient, tid));
+  uint16_t seq;
+  if (it != m_agreements.end () && it->second.second.GetFirst (it->second.second.retry, seq))
     {
-      if ((*it)->hdr.GetAddr1 () == recipient && (*it)->hdr.GetQosTid () == tid)
-        {
-          return (*it)->hdr.GetSequenceNumber ();
-        }
-      it++;
+      return seq;
     }
   return 4096;
 }
@@ -1066,33 +921,6 @@ BlockAckManager::SetTxFailedCallback (TxFailed callback)
   m_txFailedCallback = callback;
 }
 
-void
-BlockAckManager::InsertInRetryQueue (PacketQueueI item)
-{
-  NS_LOG_INFO ("Adding to retry queue " <<(*item).hdr.GetSequenceNumber ());
-  if (m_retryPackets.size () == 0)
-    {
-      m_retryPackets.push_back (item);
-    }
-  else
-    {
-      for (std::list<PacketQueueI>::iterator it = m_retryPackets.begin (); it != m_retryPackets.end ();)
-        {
-            if(((item->hdr.GetSequenceNumber () - (*it)->hdr.GetSequenceNumber () + 4096) % 4096) > 2047)
-            {
-              it = m_retryPackets.insert (it, item);
-              break;
-            }
-            else
-            {
-              it++;
-              if(it == m_retryPackets.end ())
-                m_retryPackets.push_back (item); 
-            }
-        }
-    }
-}
-
 uint64_t
 BlockAckManager::GetMpduFailures (Mac48Address mac)
 {
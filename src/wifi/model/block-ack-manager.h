@@ -22,7 +22,7 @@
 
 #include <map>
 #include <list>
-#include <deque>
+#include <vector>
 
 #include "ns3/packet.h"
 
@@ -32,6 +32,7 @@
 #include "qos-utils.h"
 #include "wifi-mode.h"
 #include "wifi-remote-station-manager.h"
+#include "block-ack-bitmap.h"
 
 namespace ns3 {
 
@@ -362,71 +363,96 @@ private:
   void CleanupBuffers (void);
   void InactivityTimeout (Mac48Address, uint8_t);
 
-  struct Item;
   /**
-   * typedef for a list of Item struct.
-   */
-  typedef std::list<Item> PacketQueue;
-  /**
-   * typedef for an iterator for PacketQueue.
+   * A struct for packet, Wifi header, and timestamp.
+   * Used in queue by block ACK manager.
    */
-  typedef std::list<Item>::iterator PacketQueueI;
+  struct Item
+  {
+    Item ();
+    Item (Ptr<const Packet> packet,
+          const WifiMacHeader &hdr,
+          Time tStamp);
+    Ptr<const Packet> packet;
+    WifiMacHeader hdr;
+    Time timestamp;
+  };
   /**
-   * typedef for a const iterator for PacketQueue.
+   * The packets of an agreement waiting for a block ack, indexed by
+   * sequence number. Fragments are not sent under block ack agreements, so
+   * a sequence number has one packet. The packets are ordered circularly
+   * from the oldest one.
    */
-  typedef std::list<Item>::const_iterator PacketQueueCI;
+  struct Window
+  {
+    Window ();
+    /**
+     * Store item, replacing the packet stored with its sequence number.
+     */
+    void Store (const Item &item);
+    /**
+     * Remove the packet with sequence number seq.
+     */
+    void Remove (uint16_t seq);
+    /**
+     * \param bits the packets to look at: stored or retry
+     * \param seq the sequence number of the first of them, if any
+     * \return true if one of them is set
+     */
+    bool GetFirst (const BlockAckBitmap &bits, uint16_t &seq) const;
+
+    BlockAckRing<Item> items;
+    BlockAckBitmap stored;     //!< packets waiting for a block ack
+    BlockAckBitmap retry;      //!< packets to retransmit
+    BlockAckBitmap restored;   //!< retransmissions stored again before RemovePacket
+    uint16_t head;             //!< oldest packet stored
+  };
 
   /**
    * typedef for a map between MAC address and block ACK agreement.
    */
   typedef std::map<std::pair<Mac48Address, uint8_t>,
-                   std::pair<OriginatorBlockAckAgreement, PacketQueue> > Agreements;
+                   std::pair<OriginatorBlockAckAgreement, Window> > Agreements;
   /**
    * typedef for an iterator for Agreements.
    */
   typedef std::map<std::pair<Mac48Address, uint8_t>,
-                   std::pair<OriginatorBlockAckAgreement, PacketQueue> >::iterator AgreementsI;
+                   std::pair<OriginatorBlockAckAgreement, Window> >::iterator AgreementsI;
   /**
    * typedef for a const iterator for Agreements.
    */
   typedef std::map<std::pair<Mac48Address, uint8_t>,
-                   std::pair<OriginatorBlockAckAgreement, PacketQueue> >::const_iterator AgreementsCI;
+                   std::pair<OriginatorBlockAckAgreement, Window> >::const_iterator AgreementsCI;
 
   /**
-   * A struct for packet, Wifi header, and timestamp.
-   * Used in queue by block ACK manager.
+   * \param begin first agreement to look at
+   * \param end agreement after the last one to look at
+   * \param agreement the agreement of the packet found
+   * \param seq the sequence number of the packet found
+   * \return true if a packet to retransmit was found
+   *
+   * Looks for the first packet to retransmit in the agreements from begin to end,
+   * discarding the ones older than the starting sequence of their agreement.
    */
-  struct Item
-  {
-    Item ();
-    Item (Ptr<const Packet> packet,
-          const WifiMacHeader &hdr,
-          Time tStamp);
-    Ptr<const Packet> packet;
-    WifiMacHeader hdr;
-    Time timestamp;
-  };
+  bool FindRetryPacket (AgreementsI begin, AgreementsI end, AgreementsI &agreement, uint16_t &seq);
   /**
-   * \param item
+   * \param agreement the agreement of the packet
+   * \param seq the sequence number of the packet
+   * \param hdr the header of the retransmission
+   * \return the packet to retransmit
    *
-   * Insert item in retransmission queue.
-   * This method ensures packets are retransmitted in the correct order.
+   * Prepares the retransmission of the packet seq of agreement and selects its
+   * ack policy.
    */
-  void InsertInRetryQueue (PacketQueueI item);
+  Ptr<const Packet> GetRetryPacket (AgreementsI agreement, uint16_t seq, WifiMacHeader &hdr);
 
   /**
-   * This data structure contains, for each block ack agreement (recipient, tid), a set of packets
+   * This data structure contains, for each block ack agreement (recipient, tid), the packets
    * for which an ack by block ack is requested.
-   * Every packet or fragment indicated as correctly received in block ack frame is
-   * erased from this data structure. Pushed back in retransmission queue otherwise.
+   * Every packet indicated as correctly received in block ack frame is
+   * erased from this data structure. Marked for retransmission otherwise.
    */
   Agreements m_agreements;
-  /**
-   * This list contains all iterators to stored packets that need to be retransmitted.
-   * A packet needs retransmission if it's indicated as not correctly received in a block ack
-   * frame.
-   */
-  std::list<PacketQueueI> m_retryPackets;
   std::list<Bar> m_bars;
 
   uint8_t m_blockAckThreshold;
@@ -444,7 +470,6 @@ private:
 
   std::map<Mac48Address, uint64_t> m_mpduFailuresPerDestination;
   std::map<Mac48Address, uint64_t> m_mpduSuccessesPerDestination;
-  std::map<Mac48Address, uint64_t> m_mpduCounterPerDestination;
 };
 
 } // namespace ns3
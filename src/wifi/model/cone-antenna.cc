@@ -22,6 +22,7 @@
 #include "ns3/double.h"
 #include "cone-antenna.h"
 #include <math.h>
+#include <algorithm>
 
 namespace ns3 {
 
@@ -104,6 +105,56 @@ double ConeAntenna::GetRxGainDbi(double azimuth, double elevation) const
     return m_gainDbi;
 }
 
+void
+ConeAntenna::GetTxGainsDbi (const double *azimuth, const double *elevation,
+                            double *gains, uint32_t n) const
+{
+    NS_LOG_FUNCTION(n);
+    GetGainsDbi(azimuth, elevation, gains, n);
+}
+
+void
+ConeAntenna::GetRxGainsDbi (const double *azimuth, const double *elevation,
+                            double *gains, uint32_t n) const
+{
+    NS_LOG_FUNCTION(n);
+    GetGainsDbi(azimuth, elevation, gains, n);
+}
+
+void
+ConeAntenna::GetGainsDbi (const double *azimuth, const double *elevation,
+                          double *gains, uint32_t n) const
+{
+    // Same decisions as getAngleDiff, without branches in the common case
+    // (angle differences up to 6*pi) so the loop can be vectorized. Larger
+    // differences are rare and redone with getAngleDiff.
+    const double halfBeamwidth = m_beamwidth/2;
+    bool farAngles = false;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        double dAz = fabs(azimuth[i]-m_azimuth);
+        dAz = (dAz > 2*M_PI) ? dAz - 2*M_PI : dAz;
+        dAz = (dAz > 2*M_PI) ? dAz - 2*M_PI : dAz;
+        double dEl = fabs(elevation[i]-m_elevation);
+        dEl = (dEl > 2*M_PI) ? dEl - 2*M_PI : dEl;
+        dEl = (dEl > 2*M_PI) ? dEl - 2*M_PI : dEl;
+        farAngles |= (dAz > 2*M_PI) | (dEl > 2*M_PI);
+        dAz = (dAz > M_PI) ? 2*M_PI - dAz : dAz;
+        dEl = (dEl > M_PI) ? 2*M_PI - dEl : dEl;
+        gains[i] = ((dAz > halfBeamwidth) | (dEl > halfBeamwidth)) ? m_gainDbiOutsideBeam : m_gainDbi;
+    }
+    if (!farAngles)
+        return;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        if ((getAngleDiff(azimuth[i], m_azimuth) > halfBeamwidth) ||
+            (getAngleDiff(elevation[i], m_elevation) > halfBeamwidth))
+            gains[i] = m_gainDbiOutsideBeam;
+        else
+            gains[i] = m_gainDbi;
+    }
+}
+
 double
 ConeAntenna::GetGainDbi(void) const
 {
@@ -132,6 +183,18 @@ ConeAntenna::SetGainDbiOutsideBeam (double gainDbi)
   m_gainDbiOutsideBeam = gainDbi;
 }
 
+double
+ConeAntenna::GetMaxGainDbi (void) const
+{
+  return std::max (m_gainDbi, m_gainDbiOutsideBeam);
+}
+
+Ptr<AbstractAntenna>
+ConeAntenna::Copy (void) const
+{
+  return CopyObject<ConeAntenna> (Ptr<const ConeAntenna> (this));
+}
+
 double
 ConeAntenna::GetBeamwidth(void) const
 {
@@ -39,6 +39,10 @@ public:
 
     double GetTxGainDbi (double azimuth, double elevation) const;
     double GetRxGainDbi (double azimuth, double elevation) const;
+    void GetTxGainsDbi (const double *azimuth, const double *elevation,
+                        double *gains, uint32_t n) const;
+    void GetRxGainsDbi (const double *azimuth, const double *elevation,
+                        double *gains, uint32_t n) const;
 
     double GetGainDbi (void) const;
     void SetGainDbi (double gainDbi);
@@ -46,6 +50,9 @@ public:
     double GetGainDbiOutsideBeam (void) const;
     void SetGainDbiOutsideBeam (double gainDbi);
 
+    double GetMaxGainDbi (void) const;
+    Ptr<AbstractAntenna> Copy (void) const;
+
     double GetBeamwidth (void) const;
     void SetBeamwidth (double beamwidth);
     double GetBeamwidthDegrees (void) const;
@@ -61,6 +68,10 @@ public:
     static double BeamwidthToGainDbi(double gainDbi);
 
 private:
+    /* TX and RX gains are the same */
+    void GetGainsDbi (const double *azimuth, const double *elevation,
+                      double *gains, uint32_t n) const;
+
     double m_gainDbi;
     double m_beamwidth;
     double m_azimuth;
@@ -751,6 +751,13 @@ uint64_t CtrlBAckResponseHeader::GetCompressedBitmap (void) const
     return bitmap.m_compressedBitmap;
 }
 
+void CtrlBAckResponseHeader::SetCompressedBitmap (uint64_t compressedBitmap)
+{
+    NS_LOG_FUNCTION (this << compressedBitmap);
+    NS_ASSERT (m_compressed && !m_multiTid);
+    bitmap.m_compressedBitmap = compressedBitmap;
+}
+
 void CtrlBAckResponseHeader::ResetBitmap (void)
 {
     NS_LOG_FUNCTION (this);
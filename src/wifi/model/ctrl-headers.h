@@ -326,6 +326,13 @@ public:
    * \return the compressed bitmap from the block ACK response header
    */
   uint64_t GetCompressedBitmap (void) const;
+  /**
+   * Set the compressed bitmap of the block ACK response header: bit i
+   * acknowledges the starting sequence + i.
+   *
+   * \param bitmap the compressed bitmap
+   */
+  void SetCompressedBitmap (uint64_t bitmap);
 
   /**
    * Reset the bitmap to 0.
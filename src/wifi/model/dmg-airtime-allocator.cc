@@ -0,0 +1,320 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+#include "dmg-airtime-allocator.h"
+#include "ns3/assert.h"
+#include <algorithm>
+
+namespace ns3 {
+
+DmgAirtimeAllocator::DmgAirtimeAllocator ()
+  : m_root (-1),
+    m_freeTime (0),
+    m_seed (2463534242U)
+{
+}
+
+void
+DmgAirtimeAllocator::Release (uint64_t start, uint64_t stop)
+{
+  if (start >= stop)
+    {
+      return;
+    }
+  // Free intervals overlapping or adjacent to [start, stop) are merged
+  // with it
+  int32_t before, rest, inside, after;
+  Split (m_root, start, before, rest);
+  Split (rest, stop + 1, inside, after);
+  int32_t last = Last (inside);
+  if (last != -1)
+    {
+      stop = std::max (stop, m_nodes[last].stop);
+    }
+  DeleteTree (inside);
+  last = Last (before);
+  if (last != -1 && m_nodes[last].stop >= start)
+    {
+      uint64_t lastStart = m_nodes[last].start;
+      stop = std::max (stop, m_nodes[last].stop);
+      int32_t lastTree;
+      Split (before, lastStart, before, lastTree);
+      DeleteTree (lastTree);
+      start = lastStart;
+    }
+  int32_t n = NewNode (start, stop);
+  m_root = Merge (Merge (before, n), after);
+}
+
+void
+DmgAirtimeAllocator::Reserve (uint64_t start, uint64_t stop)
+{
+  if (start >= stop || m_root == -1)
+    {
+      return;
+    }
+  int32_t before, rest, inside, after;
+  Split (m_root, start, before, rest);
+  Split (rest, stop, inside, after);
+  // What is left of a free interval ending after stop
+  uint64_t tailStop = stop;
+  int32_t last = Last (inside);
+  if (last != -1)
+    {
+      tailStop = std::max (tailStop, m_nodes[last].stop);
+    }
+  DeleteTree (inside);
+  last = Last (before);
+  if (last != -1 && m_nodes[last].stop > start)
+    {
+      uint64_t lastStart = m_nodes[last].start;
+      tailStop = std::max (tailStop, m_nodes[last].stop);
+      int32_t lastTree;
+      Split (before, lastStart, before, lastTree);
+      DeleteTree (lastTree);
+      before = Merge (before, NewNode (lastStart, start));
+    }
+  if (tailStop > stop)
+    {
+      before = Merge (before, NewNode (stop, tailStop));
+    }
+  m_root = Merge (before, after);
+}
+
+void
+DmgAirtimeAllocator::Clear (void)
+{
+  m_nodes.clear ();
+  m_freeNodes.clear ();
+  m_byLength.clear ();
+  m_root = -1;
+  m_freeTime = 0;
+}
+
+bool
+DmgAirtimeAllocator::FirstFit (uint64_t duration, uint64_t &start, uint64_t &stop) const
+{
+  int32_t n = m_root;
+  if (n == -1 || m_nodes[n].maxLength < duration)
+    {
+      return false;
+    }
+  while (true)
+    {
+      int32_t left = m_nodes[n].left;
+      if (left != -1 && m_nodes[left].maxLength >= duration)
+        {
+          n = left;
+        }
+      else if (m_nodes[n].stop - m_nodes[n].start >= duration)
+        {
+          start = m_nodes[n].start;
+          stop = m_nodes[n].stop;
+          return true;
+        }
+      else
+        {
+          n = m_nodes[n].right;
+          NS_ASSERT (n != -1);
+        }
+    }
+}
+
+bool
+DmgAirtimeAllocator::BestFit (uint64_t duration, uint64_t &start, uint64_t &stop) const
+{
+  std::set<std::pair<uint64_t, uint64_t> >::const_iterator it = m_byLength.lower_bound (std::make_pair (duration, (uint64_t) 0));
+  if (it == m_byLength.end ())
+    {
+      return false;
+    }
+  start = it->second;
+  stop = it->second + it->first;
+  return true;
+}
+
+uint32_t
+DmgAirtimeAllocator::GetNFreeIntervals (void) const
+{
+  return m_byLength.size ();
+}
+
+uint64_t
+DmgAirtimeAllocator::GetFreeTime (void) const
+{
+  return m_freeTime;
+}
+
+std::vector<std::pair<uint64_t, uint64_t> >
+DmgAirtimeAllocator::GetFreeIntervals (void) const
+{
+  std::vector<std::pair<uint64_t, uint64_t> > intervals;
+  intervals.reserve (m_byLength.size ());
+  Collect (m_root, intervals);
+  return intervals;
+}
+
+int32_t
+DmgAirtimeAllocator::NewNode (uint64_t start, uint64_t stop)
+{
+  // xorshift32
+  m_seed ^= m_seed << 13;
+  m_seed ^= m_seed >> 17;
+  m_seed ^= m_seed << 5;
+
+  Node node;
+  node.start = start;
+  node.stop = stop;
+  node.maxLength = stop - start;
+  node.priority = m_seed;
+  node.left = -1;
+  node.right = -1;
+
+  int32_t n;
+  if (m_freeNodes.empty ())
+    {
+      n = m_nodes.size ();
+      m_nodes.push_back (node);
+    }
+  else
+    {
+      n = m_freeNodes.back ();
+      m_freeNodes.pop_back ();
+      m_nodes[n] = node;
+    }
+  m_byLength.insert (std::make_pair (stop - start, start));
+  m_freeTime += stop - start;
+  return n;
+}
+
+void
+DmgAirtimeAllocator::DeleteNode (int32_t n)
+{
+  uint64_t length = m_nodes[n].stop - m_nodes[n].start;
+  m_byLength.erase (std::make_pair (length, m_nodes[n].start));
+  m_freeTime -= length;
+  m_freeNodes.push_back (n);
+}
+
+void
+DmgAirtimeAllocator::DeleteTree (int32_t n)
+{
+  if (n == -1)
+    {
+      return;
+    }
+  DeleteTree (m_nodes[n].left);
+  DeleteTree (m_nodes[n].right);
+  DeleteNode (n);
+}
+
+void
+DmgAirtimeAllocator::Update (int32_t n)
+{
+  Node &node = m_nodes[n];
+  node.maxLength = node.stop - node.start;
+  if (node.left != -1)
+    {
+      node.maxLength = std::max (node.maxLength, m_nodes[node.left].maxLength);
+    }
+  if (node.right != -1)
+    {
+      node.maxLength = std::max (node.maxLength, m_nodes[node.right].maxLength);
+    }
+}
+
+void
+DmgAirtimeAllocator::Split (int32_t n, uint64_t key, int32_t &left, int32_t &right)
+{
+  if (n == -1)
+    {
+      left = -1;
+      right = -1;
+      return;
+    }
+  int32_t l, r;
+  if (m_nodes[n].start < key)
+    {
+      Split (m_nodes[n].right, key, l, r);
+      m_nodes[n].right = l;
+      Update (n);
+      left = n;
+      right = r;
+    }
+  else
+    {
+      Split (m_nodes[n].left, key, l, r);
+      m_nodes[n].left = r;
+      Update (n);
+      left = l;
+      right = n;
+    }
+}
+
+int32_t
+DmgAirtimeAllocator::Merge (int32_t left, int32_t right)
+{
+  if (left == -1)
+    {
+      return right;
+    }
+  if (right == -1)
+    {
+      return left;
+    }
+  if (m_nodes[left].priority > m_nodes[right].priority)
+    {
+      int32_t merged = Merge (m_nodes[left].right, right);
+      m_nodes[left].right = merged;
+      Update (left);
+      return left;
+    }
+  int32_t merged = Merge (left, m_nodes[right].left);
+  m_nodes[right].left = merged;
+  Update (right);
+  return right;
+}
+
+int32_t
+DmgAirtimeAllocator::Last (int32_t n) const
+{
+  if (n == -1)
+    {
+      return -1;
+    }
+  while (m_nodes[n].right != -1)
+    {
+      n = m_nodes[n].right;
+    }
+  return n;
+}
+
+void
+DmgAirtimeAllocator::Collect (int32_t n, std::vector<std::pair<uint64_t, uint64_t> > &intervals) const
+{
+  if (n == -1)
+    {
+      return;
+    }
+  Collect (m_nodes[n].left, intervals);
+  intervals.push_back (std::make_pair (m_nodes[n].start, m_nodes[n].stop));
+  Collect (m_nodes[n].right, intervals);
+}
+
+} // namespace ns3
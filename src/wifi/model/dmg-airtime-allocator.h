@@ -0,0 +1,109 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+#ifndef DMG_AIRTIME_ALLOCATOR_H
+#define DMG_AIRTIME_ALLOCATOR_H
+
+#include <stdint.h>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace ns3 {
+
+/* Free airtime of a Beacon Interval, as a set of disjoint [start, stop)
+ * intervals of nanosecond offsets from the beginning of the schedule.
+ * Adjacent free intervals are always merged.
+ *
+ * The free intervals are kept in a treap ordered by start time, where each
+ * node also stores the longest free interval of its subtree, plus an index
+ * ordered by length. Reserve and Release cost O(log n) plus the number of
+ * free intervals they remove; FirstFit and BestFit cost O(log n).
+ *
+ * Nodes live in a vector and are linked by index, so an allocator is a
+ * value that can be copied (e.g. to try a schedule on a copy).
+ */
+class DmgAirtimeAllocator
+{
+public:
+  DmgAirtimeAllocator ();
+
+  /* Mark [start, stop) as free. It may overlap free airtime */
+  void Release (uint64_t start, uint64_t stop);
+  /* Mark [start, stop) as busy. It may overlap busy airtime */
+  void Reserve (uint64_t start, uint64_t stop);
+  /* Mark all the airtime as busy */
+  void Clear (void);
+
+  /* Find the free interval with the lowest start that lasts at least
+   * duration. Return false if there is none.
+   */
+  bool FirstFit (uint64_t duration, uint64_t &start, uint64_t &stop) const;
+  /* Find the shortest free interval (lowest start among the ties) that lasts
+   * at least duration. Return false if there is none.
+   */
+  bool BestFit (uint64_t duration, uint64_t &start, uint64_t &stop) const;
+
+  /* Return the number of free intervals */
+  uint32_t GetNFreeIntervals (void) const;
+  /* Return the total free airtime */
+  uint64_t GetFreeTime (void) const;
+  /* Return the free intervals, sorted by start time */
+  std::vector<std::pair<uint64_t, uint64_t> > GetFreeIntervals (void) const;
+
+private:
+  struct Node
+  {
+    uint64_t start;
+    uint64_t stop;
+    /* Longest free interval in the subtree rooted at this node */
+    uint64_t maxLength;
+    uint32_t priority;
+    int32_t left;
+    int32_t right;
+  };
+
+  int32_t NewNode (uint64_t start, uint64_t stop);
+  void DeleteNode (int32_t n);
+  /* Delete all the nodes of the subtree rooted at n */
+  void DeleteTree (int32_t n);
+  void Update (int32_t n);
+  /* Split the tree rooted at n in the nodes starting before key (left) and
+   * the other ones (right) */
+  void Split (int32_t n, uint64_t key, int32_t &left, int32_t &right);
+  /* Merge two trees, all the nodes of left starting before those of right */
+  int32_t Merge (int32_t left, int32_t right);
+  /* Return the last node of the tree rooted at n, -1 if it is empty */
+  int32_t Last (int32_t n) const;
+  void Collect (int32_t n, std::vector<std::pair<uint64_t, uint64_t> > &intervals) const;
+
+  std::vector<Node> m_nodes;
+  std::vector<int32_t> m_freeNodes;
+  int32_t m_root;
+  /* (length, start) of every free interval */
+  std::set<std::pair<uint64_t, uint64_t> > m_byLength;
+  uint64_t m_freeTime;
+  /* State of the generator of the node priorities. Fixed seed, so the shape
+   * of the tree (and the cost of the operations) is reproducible */
+  uint32_t m_seed;
+};
+
+} // namespace ns3
+
+#endif /* DMG_AIRTIME_ALLOCATOR_H */
@@ -0,0 +1,162 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+#include "dmg-airtime-model.h"
+#include "wifi-phy.h"
+#include "wifi-tx-vector.h"
+#include "wifi-mac-header.h"
+#include "wifi-mac-trailer.h"
+#include "ampdu-subframe-header.h"
+#include "ctrl-headers.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include <algorithm>
+
+NS_LOG_COMPONENT_DEFINE ("DmgAirtimeModel");
+
+namespace ns3 {
+
+bool
+DmgAirtimeModel::Key::operator< (const Key &o) const
+{
+  if (modeUid != o.modeUid)
+    {
+      return modeUid < o.modeUid;
+    }
+  if (nMpdus != o.nMpdus)
+    {
+      return nMpdus < o.nMpdus;
+    }
+  return msduBytes < o.msduBytes;
+}
+
+DmgAirtimeModel::DmgAirtimeModel ()
+  : m_sifs (MicroSeconds (3)),
+    m_propagationGuard (NanoSeconds (0)),
+    m_ackTimeoutGuard (MicroSeconds (1))
+{
+}
+
+void
+DmgAirtimeModel::SetPhy (Ptr<WifiPhy> phy)
+{
+  m_phy = phy;
+  m_table.clear ();
+}
+
+void
+DmgAirtimeModel::SetSifs (Time sifs)
+{
+  m_sifs = sifs;
+  m_table.clear ();
+}
+
+void
+DmgAirtimeModel::SetPropagationGuard (Time guard)
+{
+  m_propagationGuard = guard;
+  m_table.clear ();
+}
+
+void
+DmgAirtimeModel::SetAckTimeoutGuard (Time guard)
+{
+  m_ackTimeoutGuard = guard;
+  m_table.clear ();
+}
+
+uint32_t
+DmgAirtimeModel::GetPsduSize (uint32_t nMpdus, uint32_t msduBytes)
+{
+  WifiMacHeader hdr;
+  hdr.SetType (WIFI_MAC_QOSDATA);
+  uint32_t mpduSize = hdr.GetSize () + msduBytes + WIFI_MAC_FCS_LENGTH;
+  // DMG stations send even a single MPDU in an A-MPDU (see
+  // MacLow::AggregateToAmpdu). Every subframe but the last one is padded to
+  // a multiple of 4 bytes, as the MpduStandardAggregator does
+  AmpduSubframeHeader subHdr;
+  uint32_t subframeSize = subHdr.GetSerializedSize () + mpduSize;
+  uint32_t padding = (4 - (subframeSize % 4)) % 4;
+  return (std::max (nMpdus, 1U) - 1) * (subframeSize + padding) + subframeSize;
+}
+
+Time
+DmgAirtimeModel::GetExchangeDuration (WifiMode mode, uint32_t nMpdus, uint32_t msduBytes)
+{
+  Key key;
+  key.modeUid = mode.GetUid ();
+  key.nMpdus = nMpdus;
+  key.msduBytes = msduBytes;
+  std::map<Key, Time>::const_iterator it = m_table.find (key);
+  if (it != m_table.end ())
+    {
+      return it->second;
+    }
+  Time duration = ComputeExchangeDuration (mode, nMpdus, msduBytes);
+  m_table[key] = duration;
+  return duration;
+}
+
+void
+DmgAirtimeModel::Precompute (uint32_t nMpdus, uint32_t msduBytes)
+{
+  NS_ASSERT (m_phy != 0);
+  for (uint32_t i = 0; i < m_phy->GetNModes (); i++)
+    {
+      GetExchangeDuration (m_phy->GetMode (i), nMpdus, msduBytes);
+    }
+}
+
+uint32_t
+DmgAirtimeModel::GetNEntries (void) const
+{
+  return m_table.size ();
+}
+
+void
+DmgAirtimeModel::Clear (void)
+{
+  m_table.clear ();
+}
+
+Time
+DmgAirtimeModel::ComputeExchangeDuration (WifiMode mode, uint32_t nMpdus, uint32_t msduBytes) const
+{
+  NS_ASSERT (m_phy != 0);
+  WifiTxVector txVector (mode, 0, 0, false, 1, 0, false);
+  // packetType 0 and incFlag 0: the whole PSDU in one go, without touching
+  // the A-MPDU bookkeeping of the PHY
+  Time data = m_phy->CalculateTxDuration (GetPsduSize (nMpdus, msduBytes), txVector,
+                                          WIFI_PREAMBLE_LONG, m_phy->GetFrequency (), 0, 0);
+
+  WifiMacHeader hdr;
+  hdr.SetType (WIFI_MAC_CTL_BACKRESP);
+  CtrlBAckResponseHeader blockAck;
+  blockAck.SetType (COMPRESSED_BLOCK_ACK);
+  uint32_t blockAckSize = hdr.GetSize () + blockAck.GetSerializedSize () + WIFI_MAC_FCS_LENGTH;
+  Time ack = m_phy->CalculateTxDuration (blockAckSize, txVector,
+                                         WIFI_PREAMBLE_LONG, m_phy->GetFrequency (), 0, 0);
+
+  Time duration = data + m_sifs + ack + m_propagationGuard * 2 + m_ackTimeoutGuard;
+  NS_LOG_DEBUG (mode.GetUniqueName () << " nMpdus=" << nMpdus << " msduBytes=" << msduBytes
+                << " duration=" << duration);
+  return duration;
+}
+
+} // namespace ns3
@@ -0,0 +1,86 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+#ifndef DMG_AIRTIME_MODEL_H
+#define DMG_AIRTIME_MODEL_H
+
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "wifi-mode.h"
+#include <stdint.h>
+#include <map>
+
+namespace ns3 {
+
+class WifiPhy;
+
+/* Airtime of the exchange a DMG station performs in an SP: an A-MPDU of
+ * nMpdus QoS data MPDUs carrying msduBytes each, SIFS and the compressed
+ * BlockAck, sent in the data mode as the DmgDestinationFixedWifiManager
+ * does. As MacLow::DmgStopAggregation, twice the propagation guard and the
+ * ACK timeout guard are added, so the schedule is sized with the same
+ * budget MacLow checks before sending an A-MPDU in the SP.
+ *
+ * Durations are computed with WifiPhy::CalculateTxDuration and memoized
+ * per (mode, nMpdus, msduBytes).
+ */
+class DmgAirtimeModel
+{
+public:
+  DmgAirtimeModel ();
+
+  /* The PHY is only used to compute durations, its A-MPDU state is left
+   * untouched */
+  void SetPhy (Ptr<WifiPhy> phy);
+  void SetSifs (Time sifs);
+  void SetPropagationGuard (Time guard);
+  void SetAckTimeoutGuard (Time guard);
+
+  /* Return the size of the PSDU carrying nMpdus MSDUs of msduBytes */
+  static uint32_t GetPsduSize (uint32_t nMpdus, uint32_t msduBytes);
+  /* Return the duration of the exchange */
+  Time GetExchangeDuration (WifiMode mode, uint32_t nMpdus, uint32_t msduBytes);
+  /* Fill the table for every mode supported by the PHY */
+  void Precompute (uint32_t nMpdus, uint32_t msduBytes);
+  /* Return the number of memoized durations */
+  uint32_t GetNEntries (void) const;
+  /* Forget the memoized durations */
+  void Clear (void);
+
+private:
+  struct Key
+  {
+    uint32_t modeUid;
+    uint32_t nMpdus;
+    uint32_t msduBytes;
+    bool operator< (const Key &o) const;
+  };
+
+  Time ComputeExchangeDuration (WifiMode mode, uint32_t nMpdus, uint32_t msduBytes) const;
+
+  Ptr<WifiPhy> m_phy;
+  Time m_sifs;
+  Time m_propagationGuard;
+  Time m_ackTimeoutGuard;
+  std::map<Key, Time> m_table;
+};
+
+} // namespace ns3
+
+#endif /* DMG_AIRTIME_MODEL_H */
@@ -28,20 +28,118 @@
 #include "ns3/wifi-mac-queue.h"
 #include "dmg-destination-fixed-wifi-manager.h"
 #include "dmg-wifi-mac.h"
+#include "dmg-airtime-allocator.h"
 #include "yans-wifi-phy.h"
 #include "yans-wifi-channel.h"
 #include "ns3/propagation-loss-model.h"
 #include "ns3/pointer.h"
+#include "ns3/object-factory.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/system-thread.h"
+#include "ns3/simulator.h"
 #include "edca-txop-n.h"
 #include <iomanip>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <sstream>
 
 NS_LOG_COMPONENT_DEFINE ("DmgAlmightyController");
 
 namespace ns3 {
 
+NS_OBJECT_ENSURE_REGISTERED (DmgAlmightyController);
+
+namespace {
+ObjectFactory
+GetDefaultSolverFactory ()
+{
+	ObjectFactory factory;
+	factory.SetTypeId (DmgProgressiveFillingSolver::GetTypeId ());
+	return factory;
+}
+
+Ptr<DmgServicePeriod>
+CreateServicePeriod (Time start, Time stop, Mac48Address dest, Ipv4Address srcIpv4, Ipv4Address sinkIpv4, Ptr<MobilityModel> mob, bool transmitt, bool isolated, uint32_t layer)
+{
+	Ptr<DmgServicePeriod> sp = CreateObject<DmgServicePeriod> ();
+	sp->SetSpStart(start);
+	sp->SetSpStop(stop);
+	sp->SetSpDestination(dest);
+	sp->SetSpFlowSrcSinkIpv4Address(srcIpv4, sinkIpv4);
+	sp->SetSpDestinationMobility(mob);
+	sp->SetSpIfTx(transmitt);
+	sp->SetSpIsolated(isolated);
+	sp->SetSpLayer(layer);
+	return sp;
+}
+}
+
+TypeId
+DmgAlmightyController::GetTypeId (void)
+{
+	static TypeId tid = TypeId ("ns3::DmgAlmightyController")
+		.SetParent<Object> ()
+		.AddConstructor<DmgAlmightyController> ()
+		.AddAttribute ("OptimizationSolver",
+				"Factory of the DmgOptimizationSolver computing the flow rates, "
+				"e.g. ns3::DmgWaterFillingSolver or ns3::DmgSimplexSolver.",
+				ObjectFactoryValue (GetDefaultSolverFactory ()),
+				MakeObjectFactoryAccessor (&DmgAlmightyController::m_solverFactory),
+				MakeObjectFactoryChecker ())
+		.AddAttribute ("InterferenceThreshold",
+				"Power (dBm) above which a link transmission interferes with the "
+				"reception of another link when building the interfering cliques.",
+				DoubleValue (-1.0e6),
+				MakeDoubleAccessor (&DmgAlmightyController::m_interfThreshold),
+				MakeDoubleChecker<double> ())
+		.AddAttribute ("InterferenceRange",
+				"Distance (m) beyond which nodes are assumed not to interfere with "
+				"each other. 0 derives it from the Friis loss model and the "
+				"InterferenceThreshold, or disables the distance check for other "
+				"loss models.",
+				DoubleValue (0),
+				MakeDoubleAccessor (&DmgAlmightyController::m_interfRange),
+				MakeDoubleChecker<double> (0))
+		.AddAttribute ("PlanningThreads",
+				"Number of threads looking for interfering links and computing "
+				"the time fractions of the cliques. The plan does not depend on it. "
+				"Antenna logging is not thread safe.",
+				UintegerValue (1),
+				MakeUintegerAccessor (&DmgAlmightyController::m_planningThreads),
+				MakeUintegerChecker<uint32_t> (1))
+		;
+	return tid;
+}
+
 DmgAlmightyController::DmgAlmightyController ()
 {
 	m_meshNodes = 0;
+	m_lastSolveTimeMs = 0;
+	m_fillingSteplength = 0;
+	m_appPayloadBytes = 0;
+	m_phyRateOverheadFraction = 0;
+	m_nMpdus = 0;
+	m_airtimeModelConfigured = false;
+	m_scheduleWithInterfAvoidance = false;
+	m_scheduleInLayers = false;
+	m_replanIndexValid = false;
+	m_interfThreshold = -1.0e6;
+	m_interfRange = 0;
+	m_gridCellSize = 0;
+	m_planningThreads = 1;
+	m_gw = 0;
+	m_routeAppPayloadBytes = 0;
+	m_routeNMpdus = 0;
+	m_scheduleOverflowNs = 0;
+	m_scheduleTrial = false;
+	m_numSchedulePerBi = 1;
+	m_ackTimeFrac = 0;
+	m_ackTimeFracMin = 0;
+	m_ackTimeFracMax = 0;
+	m_ackTimeFracConnected = false;
+	m_nChannels = 1;
 	// Configure some default values. Not all these values are used in the current
 	// implementation.
 	m_antennaSectorsN = 4; // by default 4 sectors (90 degrees)
@@ -58,11 +156,16 @@ DmgAlmightyController::DmgAlmightyController ()
 	m_biOverhaedFraction = 0;
 
 	m_beamSwitchOverheadNs = 0;
+	m_sweepOverheadNs = 0;
     m_sim_interference = true;
 }
 
 DmgAlmightyController::~DmgAlmightyController ()
 {
+	m_ackTimeFracEvent.Cancel();
+	m_sweepReleaseEvent.Cancel();
+	for (uint32_t i = 0; i < m_sweepEngines.size(); i++)
+		m_sweepEngines[i]->TraceDisconnectWithoutContext("SectorSweep", MakeCallback(&DmgAlmightyController::RecordSweep, this));
 	delete m_meshNodes;
 	m_meshNodes = 0;
 }
@@ -73,6 +176,7 @@ DmgAlmightyController::SetMeshNodes (NodeContainer *meshnodes)
 	delete m_meshNodes;
 	m_meshNodes = 0;
 	m_meshNodes = new NodeContainer(*meshnodes);
+	m_routePlanner.Clear();
 }
 
 	NodeContainer *
@@ -87,6 +191,12 @@ DmgAlmightyController::SetFlowsPath(std::vector < std::vector <uint32_t> > path)
 	m_flowsPath = path;
 }
 
+	std::vector < std::vector <uint32_t> >
+DmgAlmightyController::GetFlowsPath (void)
+{
+	return m_flowsPath;
+}
+
 	void
 DmgAlmightyController::SetAntennaSectorsN (double sectorsN)
 {
@@ -258,6 +368,100 @@ DmgAlmightyController::GetBiOverheadFraction (void)
 	return m_biOverhaedFraction;
 }
 
+	uint64_t
+DmgAlmightyController::GetBiOverheadNs (void)
+{
+	return (uint64_t) ceil(m_biDuration * m_biOverhaedFraction) + m_sweepOverheadNs;
+}
+
+	uint64_t
+DmgAlmightyController::GetBiSweepOverheadNs (uint64_t bi)
+{
+	std::map <uint64_t, uint64_t>::const_iterator it = m_biSweepNs.find(bi);
+	return it == m_biSweepNs.end() ? 0 : it->second;
+}
+
+	void
+DmgAlmightyController::TrainBeams (void)
+{
+	uint32_t nodesN = m_meshNodes->GetN();
+	for (uint32_t nodeIdx = 0; nodeIdx < nodesN; nodeIdx++){
+		std::vector < Ptr<DmgWifiMac> > macs = GetNodeMacs(nodeIdx);
+		for (uint32_t devIdx = 0; devIdx < macs.size(); devIdx++){
+			if (macs[devIdx] == 0)
+				continue;
+			Ptr<BeamformingEngine> engine = macs[devIdx]->GetDmgAntennaController()->GetBeamformingEngine();
+			if (engine != 0 && std::find(m_sweepEngines.begin(), m_sweepEngines.end(), engine) == m_sweepEngines.end()){
+				//The sweeps done so far (e.g. by ConfigureWifiManager) belong to this BI
+				m_biSweepNs[Simulator::Now().GetNanoSeconds() / m_biDuration] +=
+					(engine->GetSweepDuration() * (int64_t) engine->GetNSweeps()).GetNanoSeconds();
+				engine->TraceConnectWithoutContext("SectorSweep", MakeCallback(&DmgAlmightyController::RecordSweep, this));
+				m_sweepEngines.push_back(engine);
+			}
+		}
+	}
+	for (uint32_t linkIdx = 0; linkIdx < m_linkList.size(); linkIdx++){
+		for (uint32_t end = 0; end < 2; end++){
+			Ptr<BeamformingEngine> engine = GetLinkMac(m_linkList[linkIdx][end], m_linkList[linkIdx][1 - end])->
+				GetDmgAntennaController()->GetBeamformingEngine();
+			if (engine != 0)
+				engine->GetBestSector(m_meshNodes->Get(m_linkList[linkIdx][1 - end])->GetObject<MobilityModel>());
+		}
+	}
+	//The schedule is installed in the current BI: it carries all the sweeps
+	//of this BI, whether of this training, of a previous one or of the data
+	//path. The later BIs do not, see ReleaseSweepOverhead
+	m_sweepOverheadNs = GetBiSweepOverheadNs(Simulator::Now().GetNanoSeconds() / m_biDuration);
+	if (m_sweepOverheadNs > 0)
+		NS_LOG_INFO("Sector sweeps overhead " << m_sweepOverheadNs << "ns");
+}
+
+	void
+DmgAlmightyController::RecordSweep (Ptr<const MobilityModel> peer, Time duration)
+{
+	//Sweeps do not reuse space: their airtime adds up
+	uint64_t bi = Simulator::Now().GetNanoSeconds() / m_biDuration;
+	m_biSweepNs[bi] += duration.GetNanoSeconds();
+	NS_LOG_DEBUG("Sector sweep toward " << peer->GetPosition() << " of " << duration << " in BI " << bi);
+}
+
+	void
+DmgAlmightyController::ReleaseSweepOverhead (void)
+{
+	NS_LOG_FUNCTION(this);
+	m_sweepOverheadNs = 0;
+	if (m_scheduleInLayers)
+		ScheduleLayers();
+	else {
+		m_scheduleOverflowNs = 0;
+		std::vector <bool> scheduled (cliqueS.size(), false);
+		for (uint32_t cIdx = 0; cIdx < cliqueS.size(); cIdx++) {
+			ClearCliqueSchedule(cIdx);
+		}
+		for (uint32_t i = 0; i < m_schedulingOrder.size(); i++) {
+			uint32_t cIdx = m_schedulingOrder.at(i);
+			if (m_scheduleWithInterfAvoidance)
+				ScheduleCliqueWithInterfAvoidance(cIdx, scheduled);
+			else
+				ScheduleClique(cIdx);
+			scheduled.at(cIdx) = true;
+		}
+	}
+	ScheduleSpUpdates(BuildServicePeriods(std::vector <bool> (m_meshNodes->GetN(), true)));
+}
+
+	void
+DmgAlmightyController::ScheduleSpUpdates (const std::vector < std::vector < std::vector < Ptr<DmgServicePeriod> > > > &sps)
+{
+	for (uint32_t staIdx = 0; staIdx < m_meshNodes->GetN(); staIdx++) {
+		std::vector < Ptr<DmgWifiMac> > macs = GetNodeMacs(staIdx);
+		for (uint32_t devIdx = 0; devIdx < macs.size(); devIdx++) {
+			if (macs[devIdx] != 0)
+				macs[devIdx]->GetDmgBeaconInterval()->ScheduleSpUpdate(sps.at(staIdx).at(devIdx));
+		}
+	}
+}
+
 	void
 DmgAlmightyController::SetBeamSwitchOverhead (uint64_t beamSwitchOverhead)
 {
@@ -280,6 +484,102 @@ DmgAlmightyController::SetNumSchedulePerBi(uint32_t numSchedulePerBi)
 DmgAlmightyController::SetAckTimeFrac(double ackTimeFrac)
 {
 	m_ackTimeFrac = ackTimeFrac;
+	m_ackTimeFracMax = ackTimeFrac;
+}
+
+	double
+DmgAlmightyController::GetAckTimeFrac (void)
+{
+	return m_ackTimeFrac;
+}
+
+	void
+DmgAlmightyController::SetAutoAckTimeFrac (Time period, double minFrac)
+{
+	NS_LOG_FUNCTION(this << period << minFrac);
+	// The ACK sub-SPs are the only measure of the reverse traffic: they must not vanish
+	NS_ASSERT_MSG(minFrac > 0 && minFrac <= m_ackTimeFracMax,
+			"The minimum ACK time fraction must be in (0, " << m_ackTimeFracMax << "]");
+	m_ackTimeFracEvent.Cancel();
+	m_ackTimeUsage.clear();
+	m_ackTimeFracPeriod = period;
+	m_ackTimeFracMin = minFrac;
+	if (period.IsZero())
+		return;
+	if (!m_ackTimeFracConnected) {
+		for (uint32_t i = 0; i < m_meshNodes->GetN(); i++) {
+			std::vector < Ptr<DmgWifiMac> > macs = GetNodeMacs(i);
+			for (uint32_t devIdx = 0; devIdx < macs.size(); devIdx++) {
+				if (macs[devIdx] != 0)
+					macs[devIdx]->TraceConnectWithoutContext("SpStats", MakeCallback(&DmgAlmightyController::RecordSpStats, this));
+			}
+		}
+		m_ackTimeFracConnected = true;
+	}
+	m_ackTimeFracEvent = Simulator::Schedule(period, &DmgAlmightyController::UpdateAckTimeFrac, this);
+}
+
+	void
+DmgAlmightyController::RecordSpStats (const DmgSpStats &stats)
+{
+	if (!m_ackTimeFracEvent.IsRunning())
+		return;
+	// An ACK sub-SP is transmitted by the receiver of the data
+	std::pair <Mac48Address, Mac48Address> link = stats.ack ?
+		std::make_pair(stats.destination, stats.source) : std::make_pair(stats.source, stats.destination);
+	std::pair <uint64_t, uint64_t> &usage = m_ackTimeUsage[link];
+	usage.first += stats.allocatedNs;
+	if (stats.ack)
+		usage.second += stats.usedNs;
+}
+
+	void
+DmgAlmightyController::UpdateAckTimeFrac (void)
+{
+	NS_LOG_FUNCTION(this);
+	if (!m_ackTimeUsage.empty()) {
+		double needed = 0;
+		for (std::map < std::pair <Mac48Address, Mac48Address>, std::pair <uint64_t, uint64_t> >::const_iterator it =
+				m_ackTimeUsage.begin(); it != m_ackTimeUsage.end(); ++it) {
+			if (it->second.first > 0)
+				needed = std::max(needed, (double) it->second.second / it->second.first);
+		}
+		double minFrac = std::max(m_ackTimeFracMin, GetMinAckTimeFrac());
+		double ackTimeFrac = std::min(std::max(needed * 1.25, minFrac), m_ackTimeFracMax);
+		if (std::abs(ackTimeFrac - m_ackTimeFrac) >= 0.005) {
+			NS_LOG_INFO("ACK time fraction " << m_ackTimeFrac << " -> " << ackTimeFrac
+					<< " (ACK sub-SPs used up to " << needed << " of the link time)");
+			m_ackTimeFrac = ackTimeFrac;
+			ScheduleSpUpdates(BuildServicePeriods(std::vector <bool> (m_meshNodes->GetN(), true)));
+		}
+	}
+	m_ackTimeUsage.clear();
+	m_ackTimeFracEvent = Simulator::Schedule(m_ackTimeFracPeriod, &DmgAlmightyController::UpdateAckTimeFrac, this);
+}
+
+	double
+DmgAlmightyController::GetMinAckTimeFrac (void)
+{
+	ConfigureAirtimeModel();
+	double minFrac = 0;
+	for (uint32_t cIdx = 0; cIdx < cliqueS.size(); cIdx++) {
+		for (uint32_t segIdx = 0; segIdx < cliqueS[cIdx].flowSegs.size(); segIdx++) {
+			// The ACK sub-SP goes from the data receiver to the data transmitter
+			uint32_t txIdx = cliqueS[cIdx].flowSegs[segIdx][1];
+			uint32_t rxIdx = cliqueS[cIdx].flowSegs[segIdx][0];
+			if (cliqueS[cIdx].bufDurNs[segIdx].empty() ||
+					m_linksDown.count(std::make_pair(std::max(txIdx, rxIdx), std::min(txIdx, rxIdx))))
+				continue;
+			WifiMode mode = GetLinkMac(txIdx, rxIdx)->GetWifiRemoteStationManager()->GetObject<DmgDestinationFixedWifiManager>()->
+				GetDestinationWifiMode(m_meshNodes->Get(rxIdx)->GetId());
+			double exchangeNs = m_airtimeModel.GetExchangeDuration(mode, 1, m_appPayloadBytes + 36).GetNanoSeconds();
+			for (uint32_t bIdx = 0; bIdx < cliqueS[cIdx].bufDurNs[segIdx].size(); bIdx++) {
+				if (cliqueS[cIdx].bufDurNs[segIdx][bIdx] > 0)
+					minFrac = std::max(minFrac, exchangeNs / cliqueS[cIdx].bufDurNs[segIdx][bIdx]);
+			}
+		}
+	}
+	return minFrac;
 }
 
 	void
@@ -328,6 +628,15 @@ DmgAlmightyController::GetSegIndicesInClique(std::vector <uint32_t> link, std::v
 	void
 DmgAlmightyController::ConfigureCliques (void)
 {
+	//start over, the paths may have changed
+	m_linkList.clear();
+	m_neighbourNodes.clear();
+	m_nextHops.clear();
+	cliqueS.clear();
+	m_linkChannel.clear();
+	m_channelDevice.clear();
+	m_replanIndexValid = false;
+
 	//prepare m_linkList (link noted in stations denoting the link *towards Sta 0 (gateway)*)
 	std::vector <uint32_t> link (2); 
 	for (uint32_t i = 0; i< m_flowsPath.front().size() - 1; i++){
@@ -338,36 +647,18 @@ DmgAlmightyController::ConfigureCliques (void)
 		m_linkList.push_back(link);
 	}
 
+	std::set < std::vector <uint32_t> > linkSet (m_linkList.begin(), m_linkList.end());
 	for(uint32_t flowIdx = 1; flowIdx < m_flowsPath.size(); flowIdx++){
 		for (uint32_t i = 0; i < m_flowsPath.at(flowIdx).size() - 1; i++){
-
-			bool ifMatch = false;
-			uint32_t linkIdx = 0;
-
-			while(!ifMatch && linkIdx < m_linkList.size()){
-
-				if ( ((m_flowsPath.at(flowIdx).at(i) == m_linkList.at(linkIdx).at(0)) && (m_flowsPath.at(flowIdx).at(i + 1) == m_linkList.at(linkIdx).at(1))) || ((m_flowsPath.at(flowIdx).at(i) == m_linkList.at(linkIdx).at(1)) && (m_flowsPath.at(flowIdx).at(i + 1) == m_linkList.at(linkIdx).at(0))) ){
-					ifMatch = true;
-					break;
-				}
-				linkIdx++;
-			}
-			if(!ifMatch){
-				link[0] = (m_flowsPath[flowIdx][i] > m_flowsPath[flowIdx][i + 1])? (m_flowsPath[flowIdx][i]):(m_flowsPath[flowIdx][i + 1]);
-				link[1] = (m_flowsPath[flowIdx][i] < m_flowsPath[flowIdx][i + 1])? (m_flowsPath[flowIdx][i]):(m_flowsPath[flowIdx][i + 1]);
+			link[0] = (m_flowsPath[flowIdx][i] > m_flowsPath[flowIdx][i + 1])? (m_flowsPath[flowIdx][i]):(m_flowsPath[flowIdx][i + 1]);
+			link[1] = (m_flowsPath[flowIdx][i] < m_flowsPath[flowIdx][i + 1])? (m_flowsPath[flowIdx][i]):(m_flowsPath[flowIdx][i + 1]);
+			if(linkSet.insert(link).second){
 				m_linkList.push_back(link);
 			}
 		}
 	}
 
-	for (uint32_t linkIdx = 0; linkIdx < m_linkList.size() - 1; linkIdx++){
-		for (uint32_t sortingIdx = linkIdx + 1; sortingIdx < m_linkList.size(); sortingIdx++) {
-			if (m_linkList[linkIdx] > m_linkList[sortingIdx]) {
-				std::swap(m_linkList.at(linkIdx).at(0), m_linkList.at(sortingIdx).at(0));
-				std::swap(m_linkList.at(linkIdx).at(1), m_linkList.at(sortingIdx).at(1));
-			}
-		}
-	}
+	std::sort(m_linkList.begin(), m_linkList.end());
 
 	//Print linkList for debugging
 	for ( uint32_t linkIdx = 0; linkIdx < m_linkList.size(); linkIdx++){
@@ -376,23 +667,16 @@ DmgAlmightyController::ConfigureCliques (void)
 
 
 	//Configure neighbourhood Info m_neighbourNodes //------needed?
+	std::vector < std::vector <uint32_t> > nodeNeighbours (m_meshNodes->GetN());
+	for ( uint32_t i = 0; i < m_linkList.size(); i++)
+	{
+		nodeNeighbours.at(m_linkList[i][0]).push_back(m_linkList[i][1]);
+		nodeNeighbours.at(m_linkList[i][1]).push_back(m_linkList[i][0]);
+	}
 	for( uint32_t nodeIdx = 0; nodeIdx < m_meshNodes->GetN(); nodeIdx++)
 	{
-		uint32_t neighIdx = 0;
-		std::vector<uint32_t> neighbours;
-		for ( uint32_t i = 0; i < m_linkList.size(); i++)
-		{
-			if ( nodeIdx == m_linkList[i][0] )
-			{
-				neighIdx++;
-				neighbours.push_back(m_linkList[i][1]);
-			}
-			if ( nodeIdx == m_linkList[i][1])
-			{
-				neighIdx++;
-				neighbours.push_back(m_linkList[i][0]);
-			}
-		}
+		std::vector<uint32_t> neighbours = nodeNeighbours[nodeIdx];
+		uint32_t neighIdx = neighbours.size();
 		m_neighbourNodes.push_back (neighbours);
 
 		//Build clique if the current node is a conflict node, i.e. has more than 1 neighbour, last element is the node itself
@@ -425,12 +709,18 @@ DmgAlmightyController::ConfigureCliques (void)
 		//NS_LOG_INFO("next hop "<< i <<" is "<< m_nextHops.at(i));
 	}
 
+	std::vector < std::vector <bool> > isMember (cliqueS.size(), std::vector <bool> (m_meshNodes->GetN(), false));
+	for ( uint32_t cIdx = 0; cIdx < cliqueS.size(); cIdx++){
+		for (uint32_t i = 0; i < cliqueS[cIdx].staMem.size(); i++){
+			isMember[cIdx].at(cliqueS[cIdx].staMem[i]) = true;
+		}
+	}
 	for ( uint32_t flowIdx=0; flowIdx < m_flowsPath.size(); flowIdx++){
 		for ( uint32_t cIdx = 0; cIdx < cliqueS.size(); cIdx++){
 			//build clique.flows and clique.flowSegs using flowPath
 			for (uint32_t i = 0; i < m_flowsPath[flowIdx].size() - 1; i++){
 				//if the clique has both stations of the current link
-				if((std::find(cliqueS[cIdx].staMem.begin(), cliqueS[cIdx].staMem.end(), m_flowsPath[flowIdx][i]) != cliqueS[cIdx].staMem.end()) && (std::find(cliqueS[cIdx].staMem.begin(), cliqueS[cIdx].staMem.end(), m_flowsPath[flowIdx][i+1]) != cliqueS[cIdx].staMem.end())){
+				if(isMember[cIdx].at(m_flowsPath[flowIdx][i]) && isMember[cIdx].at(m_flowsPath[flowIdx][i+1])){
 					cliqueS[cIdx].flows.push_back(flowIdx);
 
 					std::vector <uint32_t> link;
@@ -471,13 +761,37 @@ DmgAlmightyController::ConfigureCliques (void)
 DmgAlmightyController::SetGw  (uint32_t node)
 {
 	m_gw = node;
+	m_gws = std::vector <uint32_t> (1, node);
+	m_routePlanner.Clear();
+}
+
+	void
+DmgAlmightyController::SetGw  (std::vector <uint32_t> nodes)
+{
+	NS_ASSERT_MSG(!nodes.empty(), "No gateway");
+	m_gw = nodes.front();
+	m_gws = nodes;
+	m_routePlanner.Clear();
 }
+
 	uint32_t
 DmgAlmightyController::GetGw  (void)
 {
 	return m_gw;
 }
 
+	std::vector <uint32_t>
+DmgAlmightyController::GetGws  (void)
+{
+	return m_gws.empty() ? std::vector <uint32_t> (1, m_gw) : m_gws;
+}
+
+	bool
+DmgAlmightyController::IsRootConflictNode (uint32_t node)
+{
+	return GetMasterNodeId(node) == node;
+}
+
 void
 DmgAlmightyController::ConfigureHierarchy (void)
 {
@@ -493,30 +807,42 @@ DmgAlmightyController::ConfigureHierarchy (void)
 	{
 		uint32_t cfl = cliqueS[cIdx].staMem.back();
 		conflictNodes.push_back(cfl);
-		if (cfl ==GetGw())
-		{
-			m_master.insert(std::pair<int32_t, int32_t>(cfl, 0));
-			m_masterClique.insert(std::pair<int32_t, int32_t>(cfl, 0));
-			m_schedulingOrder.push_back(cfl);
-		}
-		else{
-			m_master.insert(std::pair<int32_t, int32_t>(cfl, -1));
-			m_masterClique.insert(std::pair<int32_t, int32_t>(cfl, -1));
-		}
+		m_master.insert(std::pair<int32_t, int32_t>(cfl, -1));
+		m_masterClique.insert(std::pair<int32_t, int32_t>(cfl, -1));
 	}        
 
 	//Current master
-	uint32_t masterId = GetGw();
+	uint32_t masterId;
 	//Current level in Hierarchy
 	uint32_t levelN = 0;
 	//Number of nodes that have not assigned master
 	uint32_t orphanN = cliqueS.size();
 
-
-	std::vector <uint32_t> level0 (1, GetGw());
+	//The roots are their own masters: the gateways, or the conflict node
+	//next to a gateway that is not a conflict node
+	std::vector <uint32_t> level0;
+	std::vector <uint32_t> gws = GetGws();
+	for (uint32_t g = 0; g < gws.size(); g++)
+	{
+		std::vector <uint32_t> roots (1, gws[g]);
+		if (std::find (conflictNodes.begin(), conflictNodes.end(), gws[g]) == conflictNodes.end())
+			roots = m_neighbourNodes.at(gws[g]);
+		for (uint32_t r = 0; r < roots.size(); r++)
+		{
+			std::vector<uint32_t>::iterator itRoot = std::find (conflictNodes.begin(), conflictNodes.end(), roots[r]);
+			if (itRoot == conflictNodes.end() || m_master[roots[r]] != -1)
+				continue;
+			m_master[roots[r]] = roots[r];
+			m_masterClique[roots[r]] = std::distance(conflictNodes.begin(), itRoot);
+			m_schedulingOrder.push_back(std::distance(conflictNodes.begin(), itRoot));
+			level0.push_back(roots[r]);
+			orphanN--;
+		}
+	}
 	hierarchy.push_back(level0);
 	NS_LOG_INFO(">>>>>>>>>>>>>>>>>>>>>>>>>>>>>>Hierarchy<<<<<<<<<<<<<<<<<<<<<<<"); 
-	NS_LOG_INFO("Level 0 : (gw)" << hierarchy.at(0).at(0));                        
+	for (uint32_t i = 0; i < level0.size(); i++)
+		NS_LOG_INFO("Level 0 : (gw)" << level0.at(i));                        
 
 	while (orphanN != 0)
 	{
@@ -560,8 +886,6 @@ DmgAlmightyController::ConfigureHierarchy (void)
 				}
 			}
 		}
-		//add new level
-		hierarchy.push_back(nthLevel);
 		//recount the number of orphaN
 		orphanN = 0;
 		for(std::map<int32_t, int32_t>::iterator itMaster = m_master.begin(); itMaster != m_master.end(); itMaster++) 
@@ -569,6 +893,24 @@ DmgAlmightyController::ConfigureHierarchy (void)
 			if(itMaster->second == -1)
 				orphanN++;
 		}
+		//a part of the network not connected to a root: its first conflict node is a new root
+		if (nthLevel.empty() && orphanN != 0)
+		{
+			for (uint32_t cIdx = 0; cIdx < conflictNodes.size(); cIdx++)
+			{
+				if (m_master[conflictNodes[cIdx]] != -1)
+					continue;
+				m_master[conflictNodes[cIdx]] = conflictNodes[cIdx];
+				m_masterClique[conflictNodes[cIdx]] = cIdx;
+				m_schedulingOrder.push_back(cIdx);
+				nthLevel.push_back(conflictNodes[cIdx]);
+				NS_LOG_INFO(" Level"<< levelN << " node "<< conflictNodes[cIdx] << " is a root");
+				orphanN--;
+				break;
+			}
+		}
+		//add new level
+		hierarchy.push_back(nthLevel);
 	}
     //Main hierarchy shall be ready upto this point
     //if simulating interfering scenario,
@@ -578,93 +920,139 @@ DmgAlmightyController::ConfigureHierarchy (void)
     if(m_sim_interference){
         ConfigureInterferenceSets();
     }
+    if(m_nChannels > 1){
+        ConfigureChannels();
+    }
 }
     
 void DmgAlmightyController::ConfigureInterferenceSets(void)
 {
+    // Same result as evaluating GetInterferencePowerFromPair for every couple of
+    // links, but the pairwise path loss and angles are cached, and victims
+    // that cannot reach the threshold even with their best RX gain (or that
+    // are out of range) are skipped together with all their links.
     m_intfStas.clear();
-    for (uint32_t staIdx = 0; staIdx < m_meshNodes->GetN(); staIdx++) {
-        for (uint32_t linkIdx = 0; linkIdx < m_linkList.size(); linkIdx++){
-            uint32_t neighId;
-            
-            if (staIdx != m_linkList[linkIdx][0] && staIdx != m_linkList[linkIdx][1])
+    BuildRadioCache();
+    double range = GetInterferenceRange();
+    NS_LOG_INFO("Interference range " << range << "m (0: unbounded)");
+
+    uint32_t nodesN = m_meshNodes->GetN();
+    m_nodeLinks.assign(nodesN, std::vector <uint32_t> ());
+    for (uint32_t linkIdx = 0; linkIdx < m_linkList.size(); linkIdx++){
+        m_nodeLinks.at(m_linkList[linkIdx][0]).push_back(linkIdx);
+        m_nodeLinks.at(m_linkList[linkIdx][1]).push_back(linkIdx);
+    }
+    m_maxRxGain.resize(nodesN);
+    m_phyRxGain.resize(nodesN);
+    for (uint32_t staIdx = 0; staIdx < nodesN; staIdx++){
+        m_maxRxGain[staIdx] = m_radio[staIdx].antenna->GetMaxGainDbi();
+        m_phyRxGain[staIdx] = m_radio[staIdx].phy->GetRxGain();
+    }
+    // same pointing as DmgAntennaController::PointAntenna (sector
+    // selection may sweep, so it is done here)
+    m_linkPointing.assign(m_linkList.size(), std::vector <double> (2));
+    for (uint32_t linkIdx = 0; linkIdx < m_linkList.size(); linkIdx++){
+        for (uint32_t end = 0; end < 2; end++){
+            m_linkPointing[linkIdx][end] = m_radio[m_linkList[linkIdx][end]].antenna->
+                GetPointingAzimuth(m_radio[m_linkList[linkIdx][1 - end]].mobility);
+        }
+    }
+
+    // Everything that goes through the ns-3 objects (path loss, antenna
+    // copies) is done here; the chunks only do arithmetic on the results.
+    m_nodeVictims.assign(nodesN, std::vector <uint32_t> ());
+    for (uint32_t staIdx = 0; staIdx < nodesN; staIdx++) {
+        if (m_nodeLinks[staIdx].empty())
+            continue;
+        std::vector <uint32_t> victims = GetNodesInRange(staIdx, range);
+        for (uint32_t v = 0; v < victims.size(); v++){
+            uint32_t victim = victims[v];
+            if (victim == staIdx || m_nodeLinks[victim].empty())
                 continue;
-            else
-                neighId = (staIdx == m_linkList[linkIdx][0])?(m_linkList[linkIdx][1]):(m_linkList[linkIdx][0]);
-            
-            Ptr<DmgWifiMac> staMac =
-            m_meshNodes->Get(staIdx)->GetDevice(0)->GetObject<WifiNetDevice>()->
-            GetMac()->GetObject<DmgWifiMac>();
-            Ptr<DmgWifiMac> neiMac =
-            m_meshNodes->Get(neighId)->GetDevice(0)->GetObject<WifiNetDevice>()->
-            GetMac()->GetObject<DmgWifiMac>();
-            
-            Ptr<DmgDestinationFixedWifiManager> staManager = staMac->
-            GetWifiRemoteStationManager()->GetObject<DmgDestinationFixedWifiManager>();
-            Ptr<DmgDestinationFixedWifiManager> neiManager = neiMac->
-            GetWifiRemoteStationManager()->GetObject<DmgDestinationFixedWifiManager>();
-            
-            double neiRxPower = GetIdealRxPower(m_meshNodes->Get(staIdx), m_meshNodes->Get(neighId));
+            //the only neighbour of a node is never its victim
+            uint32_t onlyLink = m_nodeLinks[staIdx][0];
+            if (m_nodeLinks[staIdx].size() == 1 && (victim == m_linkList[onlyLink][0] || victim == m_linkList[onlyLink][1]))
+                continue;
+            GetPairGeometry(staIdx, victim);
+            m_nodeVictims[staIdx].push_back(victim);
+        }
+    }
+    // Each chunk steers its own copy of the antennas. A single chunk uses
+    // the antennas of the nodes, as does any run with an antenna that
+    // cannot be copied.
+    uint32_t chunksN = GetNPlanningChunks(nodesN);
+    m_planningAntennas.assign(1, std::vector < Ptr<AbstractAntenna> > (nodesN));
+    for (uint32_t staIdx = 0; staIdx < nodesN; staIdx++){
+        m_planningAntennas[0][staIdx] = m_radio[staIdx].antenna->GetAntenna();
+    }
+    for (uint32_t chunk = 1; chunk < chunksN; chunk++){
+        std::vector < Ptr<AbstractAntenna> > copies (nodesN);
+        for (uint32_t staIdx = 0; staIdx < nodesN && chunksN > 1; staIdx++){
+            copies[staIdx] = m_planningAntennas[0][staIdx]->Copy();
+            if (copies[staIdx] == 0){
+                NS_LOG_INFO("Antenna of node " << staIdx << " cannot be copied, looking for interference sequentially");
+                chunksN = 1;
+            }
+        }
+        m_planningAntennas.push_back(copies);
+    }
+    m_planningAntennas.resize(chunksN);
+    m_interfered.assign(nodesN, std::vector < std::vector <InterferedLink> > ());
+    m_pairsEvaluated.assign(chunksN, 0);
+    if (chunksN == 1)
+        FindInterferedLinks(0, 0, nodesN);
+    else
+        ParallelFor(nodesN, MakeCallback(&DmgAlmightyController::FindInterferedLinks, this));
+    m_planningAntennas.clear();
+
+    uint64_t pairsN = 0;
+    for (uint32_t chunk = 0; chunk < m_pairsEvaluated.size(); chunk++){
+        pairsN += m_pairsEvaluated[chunk];
+    }
+    for (uint32_t staIdx = 0; staIdx < nodesN; staIdx++) {
+        for (uint32_t l = 0; l < m_interfered[staIdx].size(); l++){
+            const std::vector <InterferedLink> &hits = m_interfered[staIdx][l];
+            if (hits.empty())
+                continue;
+            uint32_t linkIdx = m_nodeLinks[staIdx][l];
+            uint32_t neighId = (staIdx == m_linkList[linkIdx][0])?(m_linkList[linkIdx][1]):(m_linkList[linkIdx][0]);
             double staRxPower = GetIdealRxPower(m_meshNodes->Get(neighId), m_meshNodes->Get(staIdx));
-            //-----------------------measure interference for other stations
-            for (uint32_t intfLinkIdx = 0; intfLinkIdx < m_linkList.size(); intfLinkIdx++){
-                uint32_t aIntf = m_linkList[intfLinkIdx][0];
-                uint32_t bIntf = m_linkList[intfLinkIdx][1];
-                
-                if (staIdx == aIntf || staIdx == bIntf || neighId == aIntf || neighId == bIntf)
-                    continue;
-                
-                double aRxPower = GetInterferencePowerFromPair(m_meshNodes->Get(m_linkList[intfLinkIdx][0]), m_meshNodes->Get(bIntf), m_meshNodes->Get(staIdx), m_meshNodes->Get(neighId));
-                double bRxPower = GetInterferencePowerFromPair(m_meshNodes->Get(m_linkList[intfLinkIdx][1]), m_meshNodes->Get(aIntf), m_meshNodes->Get(staIdx), m_meshNodes->Get(neighId));
-                
-                if (aRxPower > -1.0e6){
-                    NS_LOG_UNCOND(staIdx << " to "<< neighId <<"(" << staRxPower<<")");
-                    NS_LOG_UNCOND("Interference>>>>>>" << aIntf << " rx power "<< aRxPower<< " when switch to " << bIntf);
-                    std::vector <uint32_t> interfSet (4);
-                    interfSet[0] = staIdx;
-                    interfSet[1] = neighId;
-                    interfSet[2] = aIntf;
-                    interfSet[3] = bIntf;
-                    m_intfStas.push_back(interfSet);
-                }
-                if (bRxPower > -1.0e6){
-                    NS_LOG_UNCOND(staIdx << " to "<< neighId <<"(" << staRxPower<<")");
-                    NS_LOG_UNCOND("Interference>>>>>>" << bIntf << " rx power "<< bRxPower<< " when switch to " << aIntf);
-                    std::vector <uint32_t> interfSet (4);
-                    interfSet[0] = staIdx;
-                    interfSet[1] = neighId;
-                    interfSet[2] = bIntf;
-                    interfSet[3] = aIntf;
-                    m_intfStas.push_back(interfSet);
-                }
-                
+            for (uint32_t h = 0; h < hits.size(); h++){
+                uint32_t victim = m_linkList[hits[h].intfLinkIdx][hits[h].victimEnd];
+                uint32_t partner = m_linkList[hits[h].intfLinkIdx][1 - hits[h].victimEnd];
+                NS_LOG_UNCOND(staIdx << " to "<< neighId <<"(" << staRxPower<<")");
+                NS_LOG_UNCOND("Interference>>>>>>" << victim << " rx power "<< hits[h].rxPowerDbm<< " when switch to " << partner);
+                std::vector <uint32_t> interfSet (4);
+                interfSet[0] = staIdx;
+                interfSet[1] = neighId;
+                interfSet[2] = victim;
+                interfSet[3] = partner;
+                m_intfStas.push_back(interfSet);
             }
         }
     }
+    m_interfered.clear();
+    NS_LOG_INFO(pairsN << " link pairs evaluated in " << chunksN << " chunks, " << m_intfStas.size() << " interference sets");
+
     //////////////////////////////////////////////////////////
     //-------------add to 'interfering cliques'
     //Mark the start of interfering clique in the array of cliques
     m_interfCliqueStart = cliqueS.size();
+    // hops of the flows going through each directed link, in flow and hop order
+    std::map < std::pair <uint32_t, uint32_t>, std::vector < std::pair <uint32_t, uint32_t> > > linkHops;
+    for (uint32_t flowIdx=0; flowIdx < m_flowsPath.size(); flowIdx++){
+        for (uint32_t i = 0; i + 1 < m_flowsPath[flowIdx].size(); i++){
+            linkHops[std::make_pair(m_flowsPath[flowIdx][i], m_flowsPath[flowIdx][i + 1])].push_back(std::make_pair(flowIdx, i));
+        }
+    }
+    std::set < std::vector <uint32_t> > recorded;
     for (uint32_t intf_set_id = 0; intf_set_id< m_intfStas.size(); intf_set_id ++){
         
         
         //////////////////////////////to avoid adding the same set of stations again
-        bool if_recorded = false;
-        if (intf_set_id > 0){
-            for (uint32_t cId = m_interfCliqueStart; cId < cliqueS.size(); cId ++ ){
-                uint32_t num_same = 0;
-                for (uint32_t i= 0; i < m_intfStas[intf_set_id].size(); i++){
-                    if (std::find(cliqueS[cId].staMem.begin(), cliqueS[cId].staMem.end(), m_intfStas[intf_set_id][i])!=  cliqueS[cId].staMem.end()){
-                        num_same++;
-                    }
-                    if (num_same == m_intfStas[intf_set_id].size()){
-                        if_recorded = true;
-                    }
-                }
-            }
-        }
-        
-        if(if_recorded)
+        std::vector <uint32_t> members = m_intfStas[intf_set_id];
+        std::sort(members.begin(), members.end());
+        if(!recorded.insert(members).second)
             continue;
         //////////////////////////////to avoid adding the same set of stations again--end
         
@@ -676,28 +1064,34 @@ void DmgAlmightyController::ConfigureInterferenceSets(void)
         
         uint32_t cIdx = cliqueS.size() - 1;
         NS_LOG_INFO("adding interfering clique "<< cIdx);
-        for (uint32_t flowIdx=0; flowIdx < m_flowsPath.size(); flowIdx++){
-                //build clique.flows and clique.flowSegs using flowPath
-            for (uint32_t i = 0; i < m_flowsPath[flowIdx].size() - 1; i++){
-                //add flow seg to clique if the interfering links are in the flow
-                if (((cliqueS[cIdx].staMem[0] == m_flowsPath[flowIdx][i]) && (cliqueS[cIdx].staMem[1] == m_flowsPath[flowIdx][i + 1])) || ((cliqueS[cIdx].staMem[2] == m_flowsPath[flowIdx][i]) && (cliqueS[cIdx].staMem[3] == m_flowsPath[flowIdx][i + 1])) || ((cliqueS[cIdx].staMem[0] == m_flowsPath[flowIdx][i + 1]) && (cliqueS[cIdx].staMem[1] == m_flowsPath[flowIdx][i])) || ((cliqueS[cIdx].staMem[2] == m_flowsPath[flowIdx][i + 1]) && (cliqueS[cIdx].staMem[3] == m_flowsPath[flowIdx][i])) )
-                {
-                    NS_LOG_INFO("---- with flow "<< flowIdx);
-                    cliqueS[cIdx].flows.push_back(flowIdx);
-                    
-                    std::vector <uint32_t> link;
-                    link.push_back(m_flowsPath[flowIdx][i]);
-                    link.push_back(m_flowsPath[flowIdx][i+1]);
-                    
-                    cliqueS[cIdx].flowSegs.push_back(link);
-                    
-                    for (uint32_t j = 0; j < link.size(); j++){
-                        NS_LOG_INFO("between "<< link[j]);
-                    }
-                    cliqueS[cIdx].phyRate.push_back(0);
-                    cliqueS[cIdx].timeAlloc.push_back(0);//Initiate time for each flow segment. Will be configured in progressive filling
-                }
+        //add flow seg to clique if the interfering links are in the flow
+        std::vector < std::pair <uint32_t, uint32_t> > hops;
+        for (uint32_t l = 0; l < 4; l++){
+            uint32_t u = cliqueS[cIdx].staMem[(l / 2) * 2 + (l % 2)];
+            uint32_t v = cliqueS[cIdx].staMem[(l / 2) * 2 + 1 - (l % 2)];
+            std::map < std::pair <uint32_t, uint32_t>, std::vector < std::pair <uint32_t, uint32_t> > >::const_iterator it = linkHops.find(std::make_pair(u, v));
+            if (it != linkHops.end()){
+                hops.insert(hops.end(), it->second.begin(), it->second.end());
+            }
+        }
+        std::sort(hops.begin(), hops.end());
+        for (uint32_t h = 0; h < hops.size(); h++){
+            uint32_t flowIdx = hops[h].first;
+            uint32_t i = hops[h].second;
+            NS_LOG_INFO("---- with flow "<< flowIdx);
+            cliqueS[cIdx].flows.push_back(flowIdx);
+            
+            std::vector <uint32_t> link;
+            link.push_back(m_flowsPath[flowIdx][i]);
+            link.push_back(m_flowsPath[flowIdx][i+1]);
+            
+            cliqueS[cIdx].flowSegs.push_back(link);
+            
+            for (uint32_t j = 0; j < link.size(); j++){
+                NS_LOG_INFO("between "<< link[j]);
             }
+            cliqueS[cIdx].phyRate.push_back(0);
+            cliqueS[cIdx].timeAlloc.push_back(0);//Initiate time for each flow segment. Will be configured in progressive filling
         }
 
     }
@@ -724,6 +1118,245 @@ void DmgAlmightyController::ConfigureInterferenceSets(void)
 
     
 
+}
+
+	void
+DmgAlmightyController::SetNChannels (uint32_t n)
+{
+	NS_ASSERT_MSG(n >= 1 && n <= 4, "802.11ad has channels 1 to 4");
+	m_nChannels = n;
+}
+
+	uint32_t
+DmgAlmightyController::GetNChannels (void)
+{
+	return m_nChannels;
+}
+
+	uint32_t
+DmgAlmightyController::GetLinkChannel (uint32_t node, uint32_t peer)
+{
+	std::map < std::pair <uint32_t, uint32_t>, uint32_t >::const_iterator it =
+		m_linkChannel.find(std::make_pair(std::max(node, peer), std::min(node, peer)));
+	return it == m_linkChannel.end() ? 0 : it->second;
+}
+
+	uint32_t
+DmgAlmightyController::GetChannelDevice (uint32_t node, uint32_t channel)
+{
+	if (node >= m_channelDevice.size() || m_channelDevice[node][channel] < 0)
+		return 0;
+	return m_channelDevice[node][channel];
+}
+
+	Ptr<DmgWifiMac>
+DmgAlmightyController::GetChannelMac (uint32_t node, uint32_t channel)
+{
+	return m_meshNodes->Get(node)->GetDevice(GetChannelDevice(node, channel))->GetObject<WifiNetDevice>()->
+		GetMac()->GetObject<DmgWifiMac>();
+}
+
+	Ptr<WifiNetDevice>
+DmgAlmightyController::GetLinkDevice (uint32_t node, uint32_t peer)
+{
+	return m_meshNodes->Get(node)->GetDevice(GetChannelDevice(node, GetLinkChannel(node, peer)))->GetObject<WifiNetDevice>();
+}
+
+	Ptr<DmgWifiMac>
+DmgAlmightyController::GetLinkMac (uint32_t node, uint32_t peer)
+{
+	return GetChannelMac(node, GetLinkChannel(node, peer));
+}
+
+	std::vector < Ptr<DmgWifiMac> >
+DmgAlmightyController::GetNodeMacs (uint32_t node)
+{
+	Ptr<Node> n = m_meshNodes->Get(node);
+	std::vector < Ptr<DmgWifiMac> > macs (n->GetNDevices());
+	for (uint32_t devIdx = 0; devIdx < n->GetNDevices(); devIdx++) {
+		Ptr<WifiNetDevice> dev = n->GetDevice(devIdx)->GetObject<WifiNetDevice>();
+		if (dev != 0)
+			macs[devIdx] = dev->GetMac()->GetObject<DmgWifiMac>();
+	}
+	return macs;
+}
+
+	Ipv4Address
+DmgAlmightyController::GetFlowSourceAddress (uint32_t flowIdx)
+{
+	// The sockets of the source are not bound to an address: the packets
+	// leave from the address of the interface of the route to the sink
+	const std::vector <uint32_t> &path = m_flowsPath.at(flowIdx);
+	Ptr<Ipv4> ipv4 = m_meshNodes->Get(path.front())->GetObject<Ipv4>();
+	int32_t ifIdx = path.size() > 1 ? ipv4->GetInterfaceForDevice(GetLinkDevice(path[0], path[1])) : 1;
+	return ipv4->GetAddress(ifIdx < 0 ? 1 : ifIdx, 0).GetLocal();
+}
+
+	Ipv4Address
+DmgAlmightyController::GetFlowSinkAddress (uint32_t flowIdx)
+{
+	return m_meshNodes->Get(m_flowsPath.at(flowIdx).back())->GetObject<Ipv4>()->GetAddress(1,0).GetLocal();
+}
+
+/* Assign a channel to every link with the DmgChannelPlanner, tune the
+ * radios and split every clique into one clique per channel: the links on
+ * different channels do not share the airtime.
+ */
+	void
+DmgAlmightyController::ConfigureChannels (void)
+{
+	NS_LOG_FUNCTION(this << m_nChannels);
+	uint32_t nodesN = m_meshNodes->GetN();
+	DmgChannelPlanner planner;
+	planner.SetNChannels(m_nChannels);
+	planner.SetNNodes(nodesN);
+	std::vector < std::vector <uint32_t> > radios (nodesN);
+	for (uint32_t staIdx = 0; staIdx < nodesN; staIdx++) {
+		std::vector < Ptr<DmgWifiMac> > macs = GetNodeMacs(staIdx);
+		for (uint32_t devIdx = 0; devIdx < macs.size(); devIdx++) {
+			if (macs[devIdx] != 0)
+				radios[staIdx].push_back(devIdx);
+		}
+		NS_ASSERT_MSG(!radios[staIdx].empty(), "Node " << staIdx << " has no DMG device");
+		planner.SetNodeRadios(staIdx, std::min((uint32_t) radios[staIdx].size(), m_nChannels));
+	}
+
+	// hops of the flows over each link
+	std::map < std::pair <uint32_t, uint32_t>, uint32_t > linkHops;
+	for (uint32_t flowIdx = 0; flowIdx < m_flowsPath.size(); flowIdx++) {
+		for (uint32_t i = 0; i + 1 < m_flowsPath[flowIdx].size(); i++) {
+			uint32_t a = m_flowsPath[flowIdx][i];
+			uint32_t b = m_flowsPath[flowIdx][i + 1];
+			linkHops[std::make_pair(std::max(a, b), std::min(a, b))]++;
+		}
+	}
+	// The links are added from the gateways outwards. The load of a link is
+	// the airtime of 1Mb/s of each of its flows at the slower direction
+	std::map < std::pair <uint32_t, uint32_t>, uint32_t > plannerLinks;
+	std::vector <bool> visited (nodesN, false);
+	std::vector <uint32_t> roots = GetGws();
+	for (uint32_t staIdx = 0; staIdx < nodesN; staIdx++)
+		roots.push_back(staIdx);
+	for (uint32_t r = 0; r < roots.size(); r++) {
+		if (visited.at(roots[r]))
+			continue;
+		visited[roots[r]] = true;
+		std::vector <uint32_t> queue (1, roots[r]);
+		for (uint32_t q = 0; q < queue.size(); q++) {
+			uint32_t a = queue[q];
+			for (uint32_t n = 0; n < m_neighbourNodes.at(a).size(); n++) {
+				uint32_t b = m_neighbourNodes[a][n];
+				std::pair <uint32_t, uint32_t> link (std::max(a, b), std::min(a, b));
+				if (plannerLinks.count(link))
+					continue;
+				Ptr<YansWifiPhy> aPhy = m_meshNodes->Get(a)->GetDevice(0)->GetObject<WifiNetDevice>()->GetPhy()->GetObject<YansWifiPhy> ();
+				Ptr<YansWifiPhy> bPhy = m_meshNodes->Get(b)->GetDevice(0)->GetObject<WifiNetDevice>()->GetPhy()->GetObject<YansWifiPhy> ();
+				double rateAb = GetWifiMode(GetIdealRxPower(m_meshNodes->Get(a), m_meshNodes->Get(b)), bPhy).GetDataRate() / 1e6;
+				double rateBa = GetWifiMode(GetIdealRxPower(m_meshNodes->Get(b), m_meshNodes->Get(a)), aPhy).GetDataRate() / 1e6;
+				plannerLinks[link] = planner.AddLink(a, b, linkHops[link] / std::max(std::min(rateAb, rateBa), 1.0));
+				if (!visited[b]) {
+					visited[b] = true;
+					queue.push_back(b);
+				}
+			}
+		}
+	}
+	// m_intfStas[i] = (a, b, victim, partner): the two links conflict
+	for (uint32_t i = 0; i < m_intfStas.size(); i++) {
+		std::map < std::pair <uint32_t, uint32_t>, uint32_t >::const_iterator it1 =
+			plannerLinks.find(std::make_pair(std::max(m_intfStas[i][0], m_intfStas[i][1]), std::min(m_intfStas[i][0], m_intfStas[i][1])));
+		std::map < std::pair <uint32_t, uint32_t>, uint32_t >::const_iterator it2 =
+			plannerLinks.find(std::make_pair(std::max(m_intfStas[i][2], m_intfStas[i][3]), std::min(m_intfStas[i][2], m_intfStas[i][3])));
+		if (it1 != plannerLinks.end() && it2 != plannerLinks.end())
+			planner.AddConflict(it1->second, it2->second);
+	}
+	if (!planner.Assign())
+		NS_FATAL_ERROR("Not enough DMG devices for " << m_nChannels << " channels");
+	NS_LOG_INFO("Channel plan: max co-channel conflicting load " << planner.GetMaxConflictLoad());
+
+	m_linkChannel.clear();
+	for (std::map < std::pair <uint32_t, uint32_t>, uint32_t >::const_iterator it = plannerLinks.begin(); it != plannerLinks.end(); ++it) {
+		m_linkChannel[it->first] = planner.GetChannel(it->second);
+		NS_LOG_INFO("Link " << it->first.first << "-" << it->first.second << " on channel " << planner.GetChannel(it->second) + 1);
+	}
+	// the radios of each node, in device order, on its channels in order
+	m_channelDevice.assign(nodesN, std::vector <int32_t> (m_nChannels, -1));
+	for (uint32_t staIdx = 0; staIdx < nodesN; staIdx++) {
+		std::vector <uint32_t> channels = planner.GetNodeChannels(staIdx);
+		for (uint32_t k = 0; k < channels.size(); k++) {
+			uint32_t devIdx = radios[staIdx].at(k);
+			m_channelDevice[staIdx][channels[k]] = devIdx;
+			Ptr<YansWifiPhy> phy = m_meshNodes->Get(staIdx)->GetDevice(devIdx)->GetObject<WifiNetDevice>()->GetPhy()->GetObject<YansWifiPhy> ();
+			if (phy->GetChannelNumber() != channels[k] + 1) {
+				NS_LOG_INFO("Node " << staIdx << " device " << devIdx << " to channel " << channels[k] + 1);
+				phy->SetChannelNumber(channels[k] + 1);
+			}
+		}
+	}
+
+	// Split the classic cliques by channel: the members of a sub-clique are
+	// the ends of its segments, the conflict node last
+	uint32_t classicN = m_sim_interference ? m_interfCliqueStart : cliqueS.size();
+	std::vector <cliqueStruct> cliques;
+	std::vector < std::vector <uint32_t> > subCliques (classicN);
+	for (uint32_t cIdx = 0; cIdx < classicN; cIdx++) {
+		uint32_t cfl = cliqueS[cIdx].staMem.back();
+		if (cliqueS[cIdx].flowSegs.empty()) {
+			subCliques[cIdx].push_back(cliques.size());
+			cliques.push_back(cliqueS[cIdx]);
+			continue;
+		}
+		for (uint32_t ch = 0; ch < m_nChannels; ch++) {
+			cliqueStruct c;
+			for (uint32_t segIdx = 0; segIdx < cliqueS[cIdx].flowSegs.size(); segIdx++) {
+				const std::vector <uint32_t> &seg = cliqueS[cIdx].flowSegs[segIdx];
+				if (GetLinkChannel(seg[0], seg[1]) != ch)
+					continue;
+				c.flowSegs.push_back(seg);
+				c.flows.push_back(cliqueS[cIdx].flows[segIdx]);
+				c.timeAlloc.push_back(cliqueS[cIdx].timeAlloc[segIdx]);
+				c.phyRate.push_back(cliqueS[cIdx].phyRate[segIdx]);
+				for (uint32_t end = 0; end < 2; end++) {
+					if (seg[end] != cfl && std::find(c.staMem.begin(), c.staMem.end(), seg[end]) == c.staMem.end())
+						c.staMem.push_back(seg[end]);
+				}
+			}
+			if (c.flowSegs.empty())
+				continue;
+			c.staMem.push_back(cfl);
+			c.staMemN = c.staMem.size();
+			subCliques[cIdx].push_back(cliques.size());
+			cliques.push_back(c);
+		}
+	}
+	// only the interference between links on the same channel is left
+	std::vector < std::vector <uint32_t> > intfStas;
+	for (uint32_t i = 0; i < m_intfStas.size(); i++) {
+		if (GetLinkChannel(m_intfStas[i][0], m_intfStas[i][1]) == GetLinkChannel(m_intfStas[i][2], m_intfStas[i][3]))
+			intfStas.push_back(m_intfStas[i]);
+	}
+	m_intfStas = intfStas;
+	uint32_t interfCliqueStart = cliques.size();
+	for (uint32_t cIdx = classicN; cIdx < cliqueS.size(); cIdx++) {
+		const std::vector <uint32_t> &m = cliqueS[cIdx].staMem;
+		if (GetLinkChannel(m[0], m[1]) == GetLinkChannel(m[2], m[3]))
+			cliques.push_back(cliqueS[cIdx]);
+	}
+	NS_LOG_INFO(classicN << " cliques split into " << interfCliqueStart << " on " << m_nChannels << " channels, "
+			<< cliques.size() - interfCliqueStart << " interfering cliques of " << cliqueS.size() - classicN << " left");
+	cliqueS = cliques;
+	if (m_sim_interference)
+		m_interfCliqueStart = interfCliqueStart;
+
+	std::vector <uint32_t> schedulingOrder;
+	for (uint32_t i = 0; i < m_schedulingOrder.size(); i++)
+		schedulingOrder.insert(schedulingOrder.end(), subCliques.at(m_schedulingOrder[i]).begin(), subCliques[m_schedulingOrder[i]].end());
+	m_schedulingOrder = schedulingOrder;
+	for (std::map <int32_t, int32_t>::iterator it = m_masterClique.begin(); it != m_masterClique.end(); ++it) {
+		if (it->second >= 0)
+			it->second = subCliques.at(it->second).front();
+	}
+	m_replanIndexValid = false;
 }
 
 	uint32_t
@@ -750,80 +1383,67 @@ DmgAlmightyController::GetMasterNodeId (uint32_t node)
 DmgAlmightyController::ConfigureScheduleWithInterfAvoidance (void)
 {
 	NS_LOG_FUNCTION(this);
-    
-	uint64_t overheadDurNs = (uint64_t) ceil(m_biDuration * m_biOverhaedFraction);
-	uint64_t scheduleAvailableTimeNs = (uint64_t)floor((m_biDuration - overheadDurNs)/m_numSchedulePerBi);
-	uint64_t nextSpStartNs = 0;
-
-	std::vector <uint32_t> conflictNodes;
-
-    //Do sth with the cIdx >= m_interfCliqueStart
+	NS_ASSERT_MSG(m_nChannels == 1, "The channels are scheduled with ConfigureScheduleInLayers");
+
+	m_scheduleWithInterfAvoidance = true;
+	m_scheduleInLayers = false;
+	m_replanIndexValid = false;
+	m_scheduleOverflowNs = 0;
+	TrainBeams();
+	std::vector <bool> scheduled (cliqueS.size(), false);
 	for (uint32_t cIdx = 0; cIdx < cliqueS.size(); cIdx++) {
-		conflictNodes.push_back(cliqueS[cIdx].staMem.back());
-
-		cliqueS[cIdx].bufStart.clear();
-		cliqueS[cIdx].bufStart.resize(cliqueS[cIdx].flowSegs.size());
-		cliqueS[cIdx].bufDurNs.clear();
-		cliqueS[cIdx].bufDurNs.resize(cliqueS[cIdx].flowSegs.size());
-		cliqueS[cIdx].bufStaOrder.clear(); //bufSegIndexOrder?
+		ClearCliqueSchedule(cIdx);
 	}
-
 	for (uint32_t i = 0; i < m_schedulingOrder.size(); i++) {
-
 		uint32_t cIdx = m_schedulingOrder.at(i);
+		ScheduleCliqueWithInterfAvoidance(cIdx, scheduled);
+		scheduled.at(cIdx) = true;
+	}
+}
 
-		uint32_t conflictNode = conflictNodes.at(cIdx);
-		nextSpStartNs = 0;
-		NS_LOG_INFO("In clique " << cIdx << ">>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> ConflictNode" << conflictNode);
-
-		std::vector < std::vector < uint64_t > > bufCflSp;
-		std::vector < std::vector < uint64_t > > timeAvailableInClique; //Time available for the clique
+/* Buffer the SPs of the segments of clique cIdx, avoiding the SPs already
+ * buffered by the cliques marked in *scheduled* whose links interfere.
+ */
+	void
+DmgAlmightyController::ScheduleCliqueWithInterfAvoidance (uint32_t cIdx, const std::vector <bool> &scheduled)
+{
+	uint64_t overheadDurNs = GetBiOverheadNs();
+	uint64_t scheduleAvailableTimeNs = (uint64_t)floor((m_biDuration - overheadDurNs)/m_numSchedulePerBi);
+	uint64_t nextSpStartNs = 0;
+	uint32_t conflictNode = cliqueS[cIdx].staMem.back();
+	bool isRoot = IsRootConflictNode(conflictNode);
 
-		uint32_t idMasterClq;//The id of master clique
+	ClearCliqueSchedule(cIdx);
+	NS_LOG_INFO("In clique " << cIdx << ">>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> ConflictNode" << conflictNode);
 
-		if (conflictNode != conflictNodes.front()){
-			std::vector<uint32_t>::iterator it;
-			//The next hop of a cfl node is the master cfl
-			idMasterClq = GetMasterCliqueId(conflictNode);
-			NS_LOG_INFO ( " master node "<< GetMasterNodeId(conflictNode) << " clique " <<idMasterClq );
+	DmgAirtimeAllocator timeAvailableInClique; //Time available for the clique
 
-			//Get the buffered sps from the Master Clique
-			for (uint32_t segIdx = 0; segIdx < cliqueS[idMasterClq].flows.size(); segIdx++){            
-				if ((conflictNode == cliqueS[idMasterClq].flowSegs[segIdx][0])||(conflictNode == cliqueS[idMasterClq].flowSegs[segIdx][1])){
+	uint32_t idMasterClq;//The id of master clique
 
-                    for (uint32_t bIdx = 0; bIdx < cliqueS[idMasterClq].bufStart[segIdx].size(); bIdx++) {
-						std::vector <uint64_t> spStartStop;
-						spStartStop.push_back(cliqueS[idMasterClq].bufStart[segIdx][bIdx]);
-						spStartStop.push_back(cliqueS[idMasterClq].bufStart[segIdx][bIdx]+cliqueS[idMasterClq].bufDurNs[segIdx][bIdx]);
-						bufCflSp.push_back(spStartStop); 
-						NS_LOG_INFO("CFL has buffered SP from clique"<< idMasterClq << " from "<< bufCflSp.back().at(0) <<" to "<< bufCflSp.back().at(1) << " seg "<< segIdx);
-					}
-				}
-			}
+	if (!isRoot){
+		//The next hop of a cfl node is the master cfl
+		idMasterClq = GetMasterCliqueId(conflictNode);
+		NS_LOG_INFO ( " master node "<< GetMasterNodeId(conflictNode) << " clique " <<idMasterClq );
 
-			//Get the available time slot to aid the shuffling
-			timeAvailableInClique.resize(bufCflSp.size() + 1);
-			timeAvailableInClique.front().push_back(0);
-			for (uint32_t iRow = 0; iRow < bufCflSp.size(); iRow++){
-				timeAvailableInClique.at(iRow).push_back(bufCflSp.at(iRow).at(0));
-				timeAvailableInClique.at(iRow+1).push_back(bufCflSp.at(iRow).at(1));
+		//The time not used by the buffered sps of the Master Clique aids the shuffling
+		timeAvailableInClique.Release(0, scheduleAvailableTimeNs);
+		for (uint32_t segIdx = 0; segIdx < cliqueS[idMasterClq].flows.size(); segIdx++){            
+			if ((conflictNode == cliqueS[idMasterClq].flowSegs[segIdx][0])||(conflictNode == cliqueS[idMasterClq].flowSegs[segIdx][1])){
+				for (uint32_t bIdx = 0; bIdx < cliqueS[idMasterClq].bufStart[segIdx].size(); bIdx++) {
+					timeAvailableInClique.Reserve(cliqueS[idMasterClq].bufStart[segIdx][bIdx], cliqueS[idMasterClq].bufStart[segIdx][bIdx]+cliqueS[idMasterClq].bufDurNs[segIdx][bIdx]);
+					NS_LOG_INFO("CFL has buffered SP from clique"<< idMasterClq << " from "<< cliqueS[idMasterClq].bufStart[segIdx][bIdx] <<" to "<< cliqueS[idMasterClq].bufStart[segIdx][bIdx]+cliqueS[idMasterClq].bufDurNs[segIdx][bIdx] << " seg "<< segIdx);
+				}
 			}
-			timeAvailableInClique.back().push_back(scheduleAvailableTimeNs);
 		}
-        
-        for (uint32_t slot = 0; slot < timeAvailableInClique.size(); slot++)
-        {
-            NS_LOG_INFO("timeAvailableInClique from " << timeAvailableInClique[slot][0] << " to " << timeAvailableInClique[slot][1]);
-        }
+	}
 
-		//Slicing and buffering on STAs
-		for (uint32_t segIdx = 0; segIdx < cliqueS[cIdx].flowSegs.size(); segIdx++) {
-			NS_LOG_INFO("Flow "<< cliqueS[cIdx].flows[segIdx] << " segment between "<<cliqueS[cIdx].flowSegs[segIdx][0] <<" and "<< cliqueS[cIdx].flowSegs[segIdx][1]);
+	//Slicing and buffering on STAs
+	for (uint32_t segIdx = 0; segIdx < cliqueS[cIdx].flowSegs.size(); segIdx++) {
+		NS_LOG_INFO("Flow "<< cliqueS[cIdx].flows[segIdx] << " segment between "<<cliqueS[cIdx].flowSegs[segIdx][0] <<" and "<< cliqueS[cIdx].flowSegs[segIdx][1]);
             
             //avoiding interfering links to be active concurrently
-            std::vector < std::vector < uint64_t > > timeAvailable = timeAvailableInClique;
+            DmgAirtimeAllocator timeAvailable = timeAvailableInClique;
 
-            std::vector < std:: vector <uint64_t> > timeAvoid;
             // in interfering cliques
             for (uint32_t cItf = m_interfCliqueStart; cItf < cliqueS.size(); cItf++)
             {
@@ -853,7 +1473,8 @@ DmgAlmightyController::ConfigureScheduleWithInterfAvoidance (void)
                         
                         seg_avoid_in_classic = GetSegIndicesInClique(seg_to_avoid, cliqueS[cClassic].flowSegs);
 
-                        if(seg_avoid_in_classic.empty()){
+                        //the cliques after cIdx in the scheduling order have no SP yet
+                        if(seg_avoid_in_classic.empty() || (cClassic != cIdx && !scheduled.at(cClassic))){
                             continue;
                         }
                        
@@ -865,10 +1486,7 @@ DmgAlmightyController::ConfigureScheduleWithInterfAvoidance (void)
                             if(cliqueS[cClassic].bufStart[seg].size()){
                                 //NS_LOG_INFO("buf size"<< cliqueS[cClassic].bufStart[seg].size());
                                 for(uint32_t buf_id = 0; buf_id< cliqueS[cClassic].bufStart[seg].size(); buf_id++){
-                                    std::vector <uint64_t> avoidStartStop;
-                                    avoidStartStop.push_back(cliqueS[cClassic].bufStart[seg][buf_id]);
-                                    avoidStartStop.push_back(cliqueS[cClassic].bufStart[seg][buf_id] + cliqueS[cClassic].bufDurNs[seg][buf_id]);
-                                    timeAvoid.push_back(avoidStartStop);
+                                    timeAvailable.Reserve(cliqueS[cClassic].bufStart[seg][buf_id], cliqueS[cClassic].bufStart[seg][buf_id] + cliqueS[cClassic].bufDurNs[seg][buf_id]);
                                     
                                     //Print info for debugging
                                     //NS_LOG_INFO("...should avoid "<< cliqueS[cClassic].bufStart[seg][buf_id] <<" and "<< cliqueS[cClassic].bufStart[seg][buf_id] + cliqueS[cClassic].bufDurNs[seg][buf_id] << " (used by "<< seg_to_avoid[0] <<" and "<< seg_to_avoid[1] << " flow "<< cliqueS[cClassic].flows[seg] << " in clique " << cClassic <<")" );
@@ -879,126 +1497,68 @@ DmgAlmightyController::ConfigureScheduleWithInterfAvoidance (void)
                 }
             }
 
-            for(uint32_t i=0; i< timeAvoid.size(); i++)
-            {
-                for(uint32_t j=0; j<i; j++)
-                {
-                    if(timeAvoid[i][0] == timeAvoid[j][0] && timeAvoid[i][1] == timeAvoid[j][1])
-                    {
-                        timeAvoid.erase(timeAvoid.begin() + i);
-                        i--;
-                    }
-                }
-            }
-            for(uint32_t i=0; i< timeAvoid.size(); i++)
-                NS_LOG_INFO("To AVOID " << timeAvoid[i][0] << " "<< timeAvoid[i][1] <<" for interf");
+            NS_LOG_INFO(timeAvailable.GetNFreeIntervals() << " gaps left for interf");
 
-            
-            timeAvailable = RemoveIntervalFromTimeAvailable(timeAvoid, timeAvailable);
-            
-           
             //the actual scheduling
-			uint64_t segSpDurationNs = (uint64_t) floor (scheduleAvailableTimeNs * cliqueS[cIdx].timeAlloc[segIdx]);
-			bool segAllocated = 0;
+		uint64_t segSpDurationNs = (uint64_t) floor (scheduleAvailableTimeNs * cliqueS[cIdx].timeAlloc[segIdx]);
+		bool segAllocated = 0;
 
-			if (conflictNode == conflictNodes.front()) {
+		if (isRoot) {
 
-				cliqueS[cIdx].bufStart[segIdx].push_back(nextSpStartNs);
-				cliqueS[cIdx].bufDurNs[segIdx].push_back(segSpDurationNs);// buffer sp on sta
-				NS_LOG_INFO(" buffering time between "<< cliqueS[cIdx].bufStart[segIdx].back() <<" and "<< cliqueS[cIdx].bufStart[segIdx].back() + cliqueS[cIdx].bufDurNs[segIdx].back());
-				nextSpStartNs += segSpDurationNs;
-			}
-			else{
-				for (uint32_t segIdMaster = 0; segIdMaster < cliqueS[idMasterClq].bufStart.size(); segIdMaster++) 
-				{                 
-					if((cliqueS[cIdx].flowSegs[segIdx][0] == cliqueS[idMasterClq].flowSegs[segIdMaster][0]) && (cliqueS[cIdx].flowSegs[segIdx][1] == cliqueS[idMasterClq].flowSegs[segIdMaster][1]) && (cliqueS[cIdx].flows[segIdx] == cliqueS[idMasterClq].flows[segIdMaster])){
+			cliqueS[cIdx].bufStart[segIdx].push_back(nextSpStartNs);
+			cliqueS[cIdx].bufDurNs[segIdx].push_back(segSpDurationNs);// buffer sp on sta
+			NS_LOG_INFO(" buffering time between "<< cliqueS[cIdx].bufStart[segIdx].back() <<" and "<< cliqueS[cIdx].bufStart[segIdx].back() + cliqueS[cIdx].bufDurNs[segIdx].back());
+			nextSpStartNs += segSpDurationNs;
+		}
+		else{
+			for (uint32_t segIdMaster = 0; segIdMaster < cliqueS[idMasterClq].bufStart.size(); segIdMaster++) 
+			{                 
+				if((cliqueS[cIdx].flowSegs[segIdx][0] == cliqueS[idMasterClq].flowSegs[segIdMaster][0]) && (cliqueS[cIdx].flowSegs[segIdx][1] == cliqueS[idMasterClq].flowSegs[segIdMaster][1]) && (cliqueS[cIdx].flows[segIdx] == cliqueS[idMasterClq].flows[segIdMaster])){
 
-						for (uint32_t bIdx = 0; bIdx < cliqueS[idMasterClq].bufStart[segIdMaster].size(); bIdx++){
-							cliqueS[cIdx].bufStart[segIdx].push_back(cliqueS[idMasterClq].bufStart[segIdMaster][bIdx]);
-							cliqueS[cIdx].bufDurNs[segIdx].push_back(cliqueS[idMasterClq].bufDurNs[segIdMaster][bIdx]);
+					for (uint32_t bIdx = 0; bIdx < cliqueS[idMasterClq].bufStart[segIdMaster].size(); bIdx++){
+						cliqueS[cIdx].bufStart[segIdx].push_back(cliqueS[idMasterClq].bufStart[segIdMaster][bIdx]);
+						cliqueS[cIdx].bufDurNs[segIdx].push_back(cliqueS[idMasterClq].bufDurNs[segIdMaster][bIdx]);
 
-						}
-						//NS_LOG_INFO("Skipping because this flow seg has been allocated SP " );
-						segAllocated = 1;
 					}
+					//NS_LOG_INFO("Skipping because this flow seg has been allocated SP " );
+					segAllocated = 1;
 				}
-				if(segAllocated == 1){
-					continue;
-				}
+			}
+			if(segAllocated == 1){
+				continue;
+			}
 
-				uint64_t timeNeeded = segSpDurationNs;
-				NS_LOG_INFO("Time needed " << timeNeeded);
-				bool ifSplited = true;
-				//Firstly try to fit in any time available gap without chopping
-				for(uint32_t iRow = 0;iRow < timeAvailable.size() ;iRow++){
-					if (segSpDurationNs <= timeAvailable.at(iRow).at(1) - timeAvailable.at(iRow).at(0))
-                    {
-						cliqueS[cIdx].bufStart[segIdx].push_back(timeAvailable.at(iRow).at(0));
-						cliqueS[cIdx].bufDurNs[segIdx].push_back(segSpDurationNs);// buffer sp on sta
-						NS_LOG_INFO("SP fitted in between " << cliqueS[cIdx].bufStart[segIdx].back() << " and " << cliqueS[cIdx].bufDurNs[segIdx].back()+cliqueS[cIdx].bufStart[segIdx].back());
-						timeAvailable.at(iRow).at(0) +=segSpDurationNs;
-                        
-                        //modify timeAvailableInClique
-                        std::vector< std::vector< uint64_t> > timeTaken;
-                        std::vector< uint64_t> fromTo;
-                        fromTo.push_back(cliqueS[cIdx].bufStart[segIdx].back());//from
-                        fromTo.push_back(cliqueS[cIdx].bufDurNs[segIdx].back()+cliqueS[cIdx].bufStart[segIdx].back());//to
-                        timeTaken.push_back(fromTo);
-                        timeAvailableInClique = RemoveIntervalFromTimeAvailable(timeTaken, timeAvailableInClique);
-                        
-						ifSplited = false;
-						timeNeeded = 0;
-						break;
-					}
-				}
-				//If cannot fit in any gaps, fill the gaps sequentially from the 1st gap until all timeNeeded has been fitted
-				if(ifSplited){
-					for(uint32_t iRow = 0;iRow < timeAvailable.size() ;iRow++){
-						if (timeAvailable.at(iRow).at(1) == timeAvailable.at(iRow).at(0))
-							continue;
-
-						if (timeNeeded >= timeAvailable.at(iRow).at(1) - timeAvailable.at(iRow).at(0)){
-							NS_LOG_INFO(" sp cannot fitted in between " << timeAvailable.at(iRow).at(0) << " and " << timeAvailable.at(iRow).at(1) << "(slicing)");
-							cliqueS[cIdx].bufStart[segIdx].push_back(timeAvailable.at(iRow).at(0));
-							cliqueS[cIdx].bufDurNs[segIdx].push_back(timeAvailable.at(iRow).at(1) - timeAvailable.at(iRow).at(0));
-							timeAvailable.at(iRow).at(0) = timeAvailable.at(iRow).at(1);
-                            
-                            //modify timeAvailableInClique
-                            std::vector< std::vector< uint64_t> > timeTaken;
-                            std::vector< uint64_t> fromTo;
-                            fromTo.push_back(cliqueS[cIdx].bufStart[segIdx].back());//from
-                            fromTo.push_back(cliqueS[cIdx].bufDurNs[segIdx].back() + cliqueS[cIdx].bufStart[segIdx].back());//to
-                            timeTaken.push_back(fromTo);
-                            timeAvailableInClique = RemoveIntervalFromTimeAvailable(timeTaken, timeAvailableInClique);
-                            
-							timeNeeded = timeNeeded - cliqueS[cIdx].bufDurNs[segIdx].back();
-							NS_LOG_INFO(" more time needed " << timeNeeded);
-						}
-						else if (timeNeeded < timeAvailable.at(iRow).at(1) - timeAvailable.at(iRow).at(0)){
-							NS_LOG_INFO(" sp fitted in between " << timeAvailable.at(iRow).at(0) << " and " << timeAvailable.at(iRow).at(0) + timeNeeded << "(stop slicing)");
-							cliqueS[cIdx].bufStart[segIdx].push_back(timeAvailable.at(iRow).at(0));
-							cliqueS[cIdx].bufDurNs[segIdx].push_back(timeNeeded);
-							timeAvailable.at(iRow).at(0) += timeNeeded;
-                            
-                            //modify timeAvailableInClique
-                            std::vector< std::vector< uint64_t> > timeTaken;
-                            std::vector< uint64_t> fromTo;
-                            fromTo.push_back(cliqueS[cIdx].bufStart[segIdx].back());//from
-                            fromTo.push_back(cliqueS[cIdx].bufDurNs[segIdx].back() + cliqueS[cIdx].bufStart[segIdx].back());//to
-                            timeTaken.push_back(fromTo);
-                            timeAvailableInClique = RemoveIntervalFromTimeAvailable(timeTaken, timeAvailableInClique);
-                            
-							timeNeeded = 0;
-						}
-					}
-				}
+			uint64_t timeNeeded = segSpDurationNs;
+			NS_LOG_INFO("Time needed " << timeNeeded);
+			uint64_t gapStart, gapStop;
+			//Firstly try to fit in any time available gap without chopping
+			if (timeAvailable.FirstFit(segSpDurationNs, gapStart, gapStop)){
+				cliqueS[cIdx].bufStart[segIdx].push_back(gapStart);
+				cliqueS[cIdx].bufDurNs[segIdx].push_back(segSpDurationNs);// buffer sp on sta
+				NS_LOG_INFO("SP fitted in between " << cliqueS[cIdx].bufStart[segIdx].back() << " and " << cliqueS[cIdx].bufDurNs[segIdx].back()+cliqueS[cIdx].bufStart[segIdx].back());
+				timeAvailable.Reserve(gapStart, gapStart + segSpDurationNs);
+				timeAvailableInClique.Reserve(gapStart, gapStart + segSpDurationNs);
+				timeNeeded = 0;
+			}
+			//If cannot fit in any gaps, fill the gaps sequentially from the 1st gap until all timeNeeded has been fitted
+			while (timeNeeded && timeAvailable.FirstFit(1, gapStart, gapStop)){
+				uint64_t durNs = std::min(timeNeeded, gapStop - gapStart);
+				NS_LOG_INFO(" sp fitted in between " << gapStart << " and " << gapStart + durNs << ((durNs < timeNeeded)?"(slicing)":"(stop slicing)"));
+				cliqueS[cIdx].bufStart[segIdx].push_back(gapStart);
+				cliqueS[cIdx].bufDurNs[segIdx].push_back(durNs);
+				timeAvailable.Reserve(gapStart, gapStart + durNs);
+				timeAvailableInClique.Reserve(gapStart, gapStart + durNs);
+				timeNeeded -= durNs;
+			}
 
                 if (timeNeeded){
-					if (timeNeeded<=10){
-						timeNeeded = 0;
-						//NS_LOG_INFO(" time in clique overflowing but for small amount (<=10ns)");
-					}
-					else{
+				if (timeNeeded<=10){
+					timeNeeded = 0;
+					//NS_LOG_INFO(" time in clique overflowing but for small amount (<=10ns)");
+				}
+				else{
+					m_scheduleOverflowNs += timeNeeded;
+					if (!m_scheduleTrial){
 						NS_LOG_WARN(" WARNING: time in clique" << cIdx << "overflowing");
 						exit(-1);
 					}
@@ -1008,242 +1568,335 @@ DmgAlmightyController::ConfigureScheduleWithInterfAvoidance (void)
 	}
 }
 
-    //utility function to remove 'toRemove' from 'avaiTime'
-std::vector < std::vector <uint64_t> >
-DmgAlmightyController:: RemoveIntervalFromTimeAvailable (std::vector < std::vector <uint64_t> > toRemove, std::vector < std::vector <uint64_t> > avaiTime)
-{
-    for(uint32_t i=0; i< toRemove.size(); i++)
-    {
-        uint64_t avoidStart = toRemove[i][0];
-        uint64_t avoidStop = toRemove[i][1];
-        for (uint32_t slot = 0; slot < avaiTime.size(); slot++)
-        {
-//            NS_LOG_INFO("avaiTime from " << avaiTime[slot][0] << " to " << avaiTime[slot][1] << " avoid start "<< avoidStart << " avoid stop " << avoidStop);
-            
-            if(avoidStart <= avaiTime[slot][0] && avoidStop >= avaiTime[slot][0] && avoidStop <= avaiTime[slot][1])
-            {
-                avaiTime[slot][0] = avoidStop;
-//                NS_LOG_INFO("shortening slot from front " << avaiTime[slot][0] << " to " << avaiTime[slot][1]);
-            }
-            else if(avoidStart >= avaiTime[slot][0] && avoidStart <= avaiTime[slot][1] && avoidStop >= avaiTime[slot][1])
-            {
-                avaiTime[slot][1] = avoidStart;
-//                NS_LOG_INFO("shortening slot from back " << avaiTime[slot][0] << " to " << avaiTime[slot][1]);
-            }
-            else if(avoidStart > avaiTime[slot][0] && avoidStart < avaiTime[slot][1] && avoidStop > avaiTime[slot][0] && avoidStop < avaiTime[slot][1])
-            {
-//                NS_LOG_INFO("inserting new row ");
-//                for(uint32_t i=0; i< avaiTime.size(); i++)
-//                    NS_LOG_INFO(" before TimeAvai" << avaiTime[i][0] << " "<< avaiTime[i][1] <<" for interf");
-//
-                std::vector <uint64_t> newRow;
-                newRow.push_back(avoidStop);
-                newRow.push_back(avaiTime[slot][1]);
-                
-                avaiTime[slot][1] = avoidStart;
-                
-//                NS_LOG_INFO(" vec increasing?" << avaiTime.size());
-                
-                std::vector< std::vector<uint64_t > >::iterator it;
-                
-                it = avaiTime.begin() + slot + 1;
-                it = avaiTime.insert (it , newRow); //slot++ or not?
-                
-//                NS_LOG_INFO(" vec increasing" << avaiTime.size());
-//                for(uint32_t i=0; i< avaiTime.size(); i++)
-//                        NS_LOG_INFO("TimeAvai " << avaiTime[i][0] << " "<< avaiTime[i][1] <<" for interf");
-            }
-            else
-            {
-                //NS_LOG_INFO("not changing avaiTime");
-            }
-        }
-        
-    }
 
-    return avaiTime;
-}
-    
     // When m_sim_interf == false
 void
 DmgAlmightyController::ConfigureSchedule (void)
 {
     NS_LOG_FUNCTION(this);
+    NS_ASSERT_MSG(m_nChannels == 1, "The channels are scheduled with ConfigureScheduleInLayers");
     
-    uint64_t overheadDurNs = (uint64_t) ceil(m_biDuration * m_biOverhaedFraction);
-    uint64_t scheduleAvailableTimeNs = (uint64_t)floor((m_biDuration - overheadDurNs)/m_numSchedulePerBi);
-    uint64_t nextSpStartNs = 0;
-    
-    std::vector <uint32_t> conflictNodes;
-    
-    //Do sth with the cIdx >= m_interfCliqueStart
+    m_scheduleWithInterfAvoidance = false;
+    m_scheduleInLayers = false;
+    m_replanIndexValid = false;
+    m_scheduleOverflowNs = 0;
+    TrainBeams();
     for (uint32_t cIdx = 0; cIdx < cliqueS.size(); cIdx++) {
-        conflictNodes.push_back(cliqueS[cIdx].staMem.back());
-        
-        cliqueS[cIdx].bufStart.clear();
-        cliqueS[cIdx].bufStart.resize(cliqueS[cIdx].flowSegs.size());
-        cliqueS[cIdx].bufDurNs.clear();
-        cliqueS[cIdx].bufDurNs.resize(cliqueS[cIdx].flowSegs.size());
-        cliqueS[cIdx].bufStaOrder.clear(); //bufSegIndexOrder?
+        ClearCliqueSchedule(cIdx);
     }
-    
     for (uint32_t i = 0; i < m_schedulingOrder.size(); i++) {
-        
-        uint32_t cIdx = m_schedulingOrder.at(i);
-        
-        uint32_t conflictNode = conflictNodes.at(cIdx);
-        nextSpStartNs = 0;
-        NS_LOG_INFO("In clique " << cIdx << ">>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> ConflictNode" << conflictNode);
-        
-        std::vector < std::vector < uint64_t > > bufCflSp;
-        std::vector < std::vector < uint64_t > > timeAvailable; //Time available for the clique
-        
-        uint32_t idMasterClq;//The id of master clique
-        
-        if (conflictNode != conflictNodes.front()){
-            std::vector<uint32_t>::iterator it;
-            //The next hop of a cfl node is the master cfl
-            idMasterClq = GetMasterCliqueId(conflictNode);
-            NS_LOG_INFO ( " master node "<< GetMasterNodeId(conflictNode) << " clique " <<idMasterClq );
-            
-            //Get the buffered sps from the Master Clique
-            for (uint32_t segIdx = 0; segIdx < cliqueS[idMasterClq].flows.size(); segIdx++){
-                if ((conflictNode == cliqueS[idMasterClq].flowSegs[segIdx][0])||(conflictNode == cliqueS[idMasterClq].flowSegs[segIdx][1])){
-                    for (uint32_t bIdx = 0; bIdx < cliqueS[idMasterClq].bufStart[segIdx].size(); bIdx++) {
-                        std::vector <uint64_t> spStartStop;
-                        spStartStop.push_back(cliqueS[idMasterClq].bufStart[segIdx][bIdx]);
-                        spStartStop.push_back(cliqueS[idMasterClq].bufStart[segIdx][bIdx]+cliqueS[idMasterClq].bufDurNs[segIdx][bIdx]);
-                        bufCflSp.push_back(spStartStop);
-                        NS_LOG_INFO("CFL has buffered SP from clique"<< idMasterClq << " from "<< bufCflSp.back().at(0) <<" to "<< bufCflSp.back().at(1));
-                    }
-                }
-            }
-            
-            //Get the available time slot to aid the shuffling
-            timeAvailable.resize(bufCflSp.size() + 1);
-            timeAvailable.front().push_back(0);
-            
-            for (uint32_t iRow = 0; iRow < bufCflSp.size(); iRow++){
-                timeAvailable.at(iRow).push_back(bufCflSp.at(iRow).at(0));
-                timeAvailable.at(iRow+1).push_back(bufCflSp.at(iRow).at(1));
-            }
-            timeAvailable.back().push_back(scheduleAvailableTimeNs);
-        }
-        
-        //Slicing and buffering on STAs
-        for (uint32_t segIdx = 0; segIdx < cliqueS[cIdx].flowSegs.size(); segIdx++) {
-            NS_LOG_INFO("Flow "<< cliqueS[cIdx].flows[segIdx] << " segment between "<<cliqueS[cIdx].flowSegs[segIdx][0] <<" and "<< cliqueS[cIdx].flowSegs[segIdx][1]);
-            
+        ScheduleClique(m_schedulingOrder.at(i));
+    }
+}
+
+/* Buffer the SPs of the segments of clique cIdx in the time left free by its
+ * master clique */
+void
+DmgAlmightyController::ScheduleClique (uint32_t cIdx)
+{
+	uint64_t overheadDurNs = GetBiOverheadNs();
+	uint64_t scheduleAvailableTimeNs = (uint64_t)floor((m_biDuration - overheadDurNs)/m_numSchedulePerBi);
+	uint64_t nextSpStartNs = 0;
+	uint32_t conflictNode = cliqueS[cIdx].staMem.back();
+	bool isRoot = IsRootConflictNode(conflictNode);
+
+	ClearCliqueSchedule(cIdx);
+	NS_LOG_INFO("In clique " << cIdx << ">>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>> ConflictNode" << conflictNode);
+
+	DmgAirtimeAllocator timeAvailable; //Time available for the clique
+
+	uint32_t idMasterClq;//The id of master clique
+
+	if (!isRoot){
+		//The next hop of a cfl node is the master cfl
+		idMasterClq = GetMasterCliqueId(conflictNode);
+		NS_LOG_INFO ( " master node "<< GetMasterNodeId(conflictNode) << " clique " <<idMasterClq );
+
+		//The time not used by the buffered sps of the Master Clique aids the shuffling
+		timeAvailable.Release(0, scheduleAvailableTimeNs);
+		for (uint32_t segIdx = 0; segIdx < cliqueS[idMasterClq].flows.size(); segIdx++){
+			if ((conflictNode == cliqueS[idMasterClq].flowSegs[segIdx][0])||(conflictNode == cliqueS[idMasterClq].flowSegs[segIdx][1])){
+				for (uint32_t bIdx = 0; bIdx < cliqueS[idMasterClq].bufStart[segIdx].size(); bIdx++) {
+					timeAvailable.Reserve(cliqueS[idMasterClq].bufStart[segIdx][bIdx], cliqueS[idMasterClq].bufStart[segIdx][bIdx]+cliqueS[idMasterClq].bufDurNs[segIdx][bIdx]);
+					NS_LOG_INFO("CFL has buffered SP from clique"<< idMasterClq << " from "<< cliqueS[idMasterClq].bufStart[segIdx][bIdx] <<" to "<< cliqueS[idMasterClq].bufStart[segIdx][bIdx]+cliqueS[idMasterClq].bufDurNs[segIdx][bIdx]);
+				}
+			}
+		}
+	}
+
+	//Slicing and buffering on STAs
+	for (uint32_t segIdx = 0; segIdx < cliqueS[cIdx].flowSegs.size(); segIdx++) {
+		NS_LOG_INFO("Flow "<< cliqueS[cIdx].flows[segIdx] << " segment between "<<cliqueS[cIdx].flowSegs[segIdx][0] <<" and "<< cliqueS[cIdx].flowSegs[segIdx][1]);
+
 //            for (uint32_t slot = 0; slot < timeAvailable.size(); slot++)
 //            {
 //                NS_LOG_INFO("timeAvailable from " << timeAvailable[slot][0] << " to " << timeAvailable[slot][1]);
 //            }
-            
+
+		uint64_t segSpDurationNs = (uint64_t) floor (scheduleAvailableTimeNs * cliqueS[cIdx].timeAlloc[segIdx]);
+		bool segAllocated = 0;
+
+		if (isRoot) {
+
+			cliqueS[cIdx].bufStart[segIdx].push_back(nextSpStartNs);
+			cliqueS[cIdx].bufDurNs[segIdx].push_back(segSpDurationNs);// buffer sp on sta
+			NS_LOG_INFO(" buffering time between "<< cliqueS[cIdx].bufStart[segIdx].back() <<" and "<< cliqueS[cIdx].bufStart[segIdx].back() + cliqueS[cIdx].bufDurNs[segIdx].back());
+			nextSpStartNs += segSpDurationNs;
+		}
+		else{
+			for (uint32_t segIdMaster = 0; segIdMaster < cliqueS[idMasterClq].bufStart.size(); segIdMaster++)
+			{
+				if((cliqueS[cIdx].flowSegs[segIdx][0] == cliqueS[idMasterClq].flowSegs[segIdMaster][0]) && (cliqueS[cIdx].flowSegs[segIdx][1] == cliqueS[idMasterClq].flowSegs[segIdMaster][1]) && (cliqueS[cIdx].flows[segIdx] == cliqueS[idMasterClq].flows[segIdMaster])){
+
+					for (uint32_t bIdx = 0; bIdx < cliqueS[idMasterClq].bufStart[segIdMaster].size(); bIdx++){
+						cliqueS[cIdx].bufStart[segIdx].push_back(cliqueS[idMasterClq].bufStart[segIdMaster][bIdx]);
+						cliqueS[cIdx].bufDurNs[segIdx].push_back(cliqueS[idMasterClq].bufDurNs[segIdMaster][bIdx]);
+
+					}
+					//NS_LOG_INFO("Skipping because this flow seg has been allocated SP " );
+					segAllocated = 1;
+				}
+			}
+			if(segAllocated == 1){
+				continue;
+			}
+
+			uint64_t timeNeeded = segSpDurationNs;
+			NS_LOG_INFO("Time needed "<< timeNeeded );
+			uint64_t gapStart, gapStop;
+			//Firstly try to fit in any time available gap without chopping
+			if (timeAvailable.FirstFit(segSpDurationNs, gapStart, gapStop)){
+				cliqueS[cIdx].bufStart[segIdx].push_back(gapStart);
+				cliqueS[cIdx].bufDurNs[segIdx].push_back(segSpDurationNs);// buffer sp on sta
+				NS_LOG_INFO("SP fitted in between " << cliqueS[cIdx].bufStart[segIdx].back() << " and " << cliqueS[cIdx].bufDurNs[segIdx].back()+cliqueS[cIdx].bufStart[segIdx].back());
+				timeAvailable.Reserve(gapStart, gapStart + segSpDurationNs);
+				timeNeeded = 0;
+			}
+			//If cannot fit in any gaps, fill the gaps sequentially from the 1st gap until all timeNeeded has been fitted
+			while (timeNeeded && timeAvailable.FirstFit(1, gapStart, gapStop)){
+				uint64_t durNs = std::min(timeNeeded, gapStop - gapStart);
+				NS_LOG_INFO(" sp fitted in between " << gapStart << " and " << gapStart + durNs << ((durNs < timeNeeded)?"(slicing)":"(stop slicing)"));
+				cliqueS[cIdx].bufStart[segIdx].push_back(gapStart);
+				cliqueS[cIdx].bufDurNs[segIdx].push_back(durNs);
+				timeAvailable.Reserve(gapStart, gapStart + durNs);
+				timeNeeded -= durNs;
+			}
+			if (timeNeeded){
+				if (timeNeeded<=10){
+					timeNeeded = 0;
+					//NS_LOG_INFO(" time in clique overflowing but for small amount (<=10ns)");
+				}
+				else{
+					m_scheduleOverflowNs += timeNeeded;
+					if (!m_scheduleTrial){
+						NS_LOG_WARN(" WARNING: time in clique" << cIdx << "overflowing");
+						exit(-1);
+					}
+				}
+			}
+		}
+	}
+}
+
+void
+DmgAlmightyController::ClearCliqueSchedule (uint32_t cIdx)
+{
+	cliqueS[cIdx].bufStart.clear();
+	cliqueS[cIdx].bufStart.resize(cliqueS[cIdx].flowSegs.size());
+	cliqueS[cIdx].bufDurNs.clear();
+	cliqueS[cIdx].bufDurNs.resize(cliqueS[cIdx].flowSegs.size());
+	cliqueS[cIdx].bufLayer.clear();
+	cliqueS[cIdx].bufLayer.resize(cliqueS[cIdx].flowSegs.size());
+	cliqueS[cIdx].bufStaOrder.clear(); //bufSegIndexOrder?
+}
+
+void
+DmgAlmightyController::ConfigureScheduleInLayers (void)
+{
+    NS_LOG_FUNCTION(this);
+
+    m_scheduleWithInterfAvoidance = false;
+    m_scheduleInLayers = true;
+    m_replanIndexValid = false;
+    TrainBeams();
+    ScheduleLayers();
+}
+
+/* A segment (hop of a flow) shared by several cliques gets the airtime of
+ * the first one in the scheduling order, as ScheduleClique copies the SPs of
+ * the master clique, and all of them buffer the same SPs.
+ */
+void
+DmgAlmightyController::ScheduleLayers (void)
+{
+    uint64_t overheadDurNs = GetBiOverheadNs();
+    uint64_t scheduleAvailableTimeNs = (uint64_t)floor((m_biDuration - overheadDurNs)/m_numSchedulePerBi);
+
+    for (uint32_t cIdx = 0; cIdx < cliqueS.size(); cIdx++) {
+        ClearCliqueSchedule(cIdx);
+    }
+    m_layerScheduler.Clear();
+    // (flow, from, to) of each segment -> link of the layer scheduler
+    std::map < std::vector <uint32_t>, uint32_t > segLinks;
+    // (higher node id, lower node id) -> links of the layer scheduler between them
+    std::map < std::pair <uint32_t, uint32_t>, std::vector <uint32_t> > nodeLinks;
+    for (uint32_t i = 0; i < m_schedulingOrder.size(); i++) {
+        uint32_t cIdx = m_schedulingOrder.at(i);
+        for (uint32_t segIdx = 0; segIdx < cliqueS[cIdx].flowSegs.size(); segIdx++) {
+            std::vector <uint32_t> seg (1, cliqueS[cIdx].flows[segIdx]);
+            seg.insert(seg.end(), cliqueS[cIdx].flowSegs[segIdx].begin(), cliqueS[cIdx].flowSegs[segIdx].end());
+            if (segLinks.count(seg))
+                continue;
             uint64_t segSpDurationNs = (uint64_t) floor (scheduleAvailableTimeNs * cliqueS[cIdx].timeAlloc[segIdx]);
-            bool segAllocated = 0;
-            
-            if (conflictNode == conflictNodes.front()) {
-                
-                cliqueS[cIdx].bufStart[segIdx].push_back(nextSpStartNs);
-                cliqueS[cIdx].bufDurNs[segIdx].push_back(segSpDurationNs);// buffer sp on sta
-                NS_LOG_INFO(" buffering time between "<< cliqueS[cIdx].bufStart[segIdx].back() <<" and "<< cliqueS[cIdx].bufStart[segIdx].back() + cliqueS[cIdx].bufDurNs[segIdx].back());
-                nextSpStartNs += segSpDurationNs;
+            // the radios of a node on different channels do not conflict
+            uint32_t channelBase = GetLinkChannel(seg[1], seg[2]) * m_meshNodes->GetN();
+            uint32_t link = m_layerScheduler.AddLink(channelBase + seg[1], channelBase + seg[2], segSpDurationNs);
+            segLinks[seg] = link;
+            nodeLinks[std::make_pair(std::max(seg[1], seg[2]), std::min(seg[1], seg[2]))].push_back(link);
+        }
+    }
+    // m_intfStas[i] = (a, b, victim, partner): the segments of the two links conflict
+    for (uint32_t i = 0; i < m_intfStas.size(); i++){
+        std::map < std::pair <uint32_t, uint32_t>, std::vector <uint32_t> >::const_iterator it1 =
+            nodeLinks.find(std::make_pair(std::max(m_intfStas[i][0], m_intfStas[i][1]), std::min(m_intfStas[i][0], m_intfStas[i][1])));
+        std::map < std::pair <uint32_t, uint32_t>, std::vector <uint32_t> >::const_iterator it2 =
+            nodeLinks.find(std::make_pair(std::max(m_intfStas[i][2], m_intfStas[i][3]), std::min(m_intfStas[i][2], m_intfStas[i][3])));
+        if (it1 == nodeLinks.end() || it2 == nodeLinks.end())
+            continue;
+        for (uint32_t l1 = 0; l1 < it1->second.size(); l1++){
+            for (uint32_t l2 = 0; l2 < it2->second.size(); l2++){
+                m_layerScheduler.AddConflict(it1->second[l1], it2->second[l2]);
             }
-            else{
-                for (uint32_t segIdMaster = 0; segIdMaster < cliqueS[idMasterClq].bufStart.size(); segIdMaster++)
-                {
-                    if((cliqueS[cIdx].flowSegs[segIdx][0] == cliqueS[idMasterClq].flowSegs[segIdMaster][0]) && (cliqueS[cIdx].flowSegs[segIdx][1] == cliqueS[idMasterClq].flowSegs[segIdMaster][1]) && (cliqueS[cIdx].flows[segIdx] == cliqueS[idMasterClq].flows[segIdMaster])){
-                        
-                        for (uint32_t bIdx = 0; bIdx < cliqueS[idMasterClq].bufStart[segIdMaster].size(); bIdx++){
-                            cliqueS[cIdx].bufStart[segIdx].push_back(cliqueS[idMasterClq].bufStart[segIdMaster][bIdx]);
-                            cliqueS[cIdx].bufDurNs[segIdx].push_back(cliqueS[idMasterClq].bufDurNs[segIdMaster][bIdx]);
-                            
-                        }
-                        //NS_LOG_INFO("Skipping because this flow seg has been allocated SP " );
-                        segAllocated = 1;
-                    }
-                }
-                if(segAllocated == 1){
-                    continue;
-                }
-                
-                uint64_t timeNeeded = segSpDurationNs;
-                NS_LOG_INFO("Time needed "<< timeNeeded );
-                bool ifSplited = true;
-                //Firstly try to fit in any time available gap without chopping
-                for(uint32_t iRow = 0;iRow < timeAvailable.size() ;iRow++){
-                    if (segSpDurationNs <= timeAvailable.at(iRow).at(1) - timeAvailable.at(iRow).at(0)){
-                        cliqueS[cIdx].bufStart[segIdx].push_back(timeAvailable.at(iRow).at(0));
-                        cliqueS[cIdx].bufDurNs[segIdx].push_back(segSpDurationNs);// buffer sp on sta
-                        NS_LOG_INFO("SP fitted in between " << cliqueS[cIdx].bufStart[segIdx].back() << " and " << cliqueS[cIdx].bufDurNs[segIdx].back()+cliqueS[cIdx].bufStart[segIdx].back());
-                        timeAvailable.at(iRow).at(0) +=segSpDurationNs;
-                        ifSplited = false;
-                        timeNeeded = 0;
-                        break;
-                    }
-                }
-                //If cannot fit in any gaps, fill the gaps sequentially from the 1st gap until all timeNeeded has been fitted
-                if(ifSplited){
-                    for(uint32_t iRow = 0;iRow < timeAvailable.size() ;iRow++){
-                        if (timeAvailable.at(iRow).at(1) == timeAvailable.at(iRow).at(0))
-                            continue;
-                        
-                        if (timeNeeded >= timeAvailable.at(iRow).at(1) - timeAvailable.at(iRow).at(0)){
-                            NS_LOG_INFO(" sp cannot fitted in between " << timeAvailable.at(iRow).at(0) << " and " << timeAvailable.at(iRow).at(1) << "(slicing)");
-                            cliqueS[cIdx].bufStart[segIdx].push_back(timeAvailable.at(iRow).at(0));
-                            cliqueS[cIdx].bufDurNs[segIdx].push_back(timeAvailable.at(iRow).at(1) - timeAvailable.at(iRow).at(0));
-                            timeAvailable.at(iRow).at(0) = timeAvailable.at(iRow).at(1);
-                            timeNeeded = timeNeeded - cliqueS[cIdx].bufDurNs[segIdx].back();
-                            NS_LOG_INFO(" more time needed " << timeNeeded);
-                        }
-                        else if (timeNeeded < timeAvailable.at(iRow).at(1) - timeAvailable.at(iRow).at(0)){
-                            NS_LOG_INFO(" sp fitted in between " << timeAvailable.at(iRow).at(0) << " and " << timeAvailable.at(iRow).at(0) + timeNeeded << "(stop slicing)");
-                            cliqueS[cIdx].bufStart[segIdx].push_back(timeAvailable.at(iRow).at(0));
-                            cliqueS[cIdx].bufDurNs[segIdx].push_back(timeNeeded);
-                            timeAvailable.at(iRow).at(0) += timeNeeded;
-                            timeNeeded = 0;
-                        }
-                    }
-                }
-                if (timeNeeded){
-                    if (timeNeeded<=10){
-                        timeNeeded = 0;
-                        //NS_LOG_INFO(" time in clique overflowing but for small amount (<=10ns)");
-                    }
-                    else{
-                        NS_LOG_WARN(" WARNING: time in clique" << cIdx << "overflowing");
-                        exit(-1);
-                    }
-                }
+        }
+    }
+
+    m_layerScheduler.Schedule(scheduleAvailableTimeNs);
+    m_scheduleOverflowNs = 0;
+    for (uint32_t l = 0; l < m_layerScheduler.GetNLinks(); l++){
+        m_scheduleOverflowNs += m_layerScheduler.GetUnplacedNs(l);
+        if (m_layerScheduler.GetUnplacedNs(l) > 10)
+            NS_LOG_WARN(" WARNING: " << m_layerScheduler.GetUnplacedNs(l) << " ns of segment " << l << " do not fit in the schedule");
+    }
+    for (uint32_t layer = 0; layer < m_layerScheduler.GetNLayers(); layer++){
+        NS_LOG_INFO("Layer " << layer << ": utilization " << m_layerScheduler.GetLayerUtilization(layer)
+                << ", occupancy " << m_layerScheduler.GetLayerOccupancy(layer));
+    }
+
+    for (uint32_t i = 0; i < m_schedulingOrder.size(); i++) {
+        uint32_t cIdx = m_schedulingOrder.at(i);
+        for (uint32_t segIdx = 0; segIdx < cliqueS[cIdx].flowSegs.size(); segIdx++) {
+            std::vector <uint32_t> seg (1, cliqueS[cIdx].flows[segIdx]);
+            seg.insert(seg.end(), cliqueS[cIdx].flowSegs[segIdx].begin(), cliqueS[cIdx].flowSegs[segIdx].end());
+            uint32_t link = segLinks[seg];
+            const std::vector < std::pair <uint64_t, uint64_t> > &sps = m_layerScheduler.GetSps(link);
+            for (uint32_t bIdx = 0; bIdx < sps.size(); bIdx++){
+                cliqueS[cIdx].bufStart[segIdx].push_back(sps[bIdx].first);
+                cliqueS[cIdx].bufDurNs[segIdx].push_back(sps[bIdx].second);
+                cliqueS[cIdx].bufLayer[segIdx].push_back(m_layerScheduler.GetLayer(link));
             }
         }
     }
 }
 
+uint32_t
+DmgAlmightyController::GetNLayers (void)
+{
+    return m_layerScheduler.GetNLayers();
+}
+
+double
+DmgAlmightyController::GetLayerUtilization (uint32_t layer)
+{
+    return m_layerScheduler.GetLayerUtilization(layer);
+}
+
+double
+DmgAlmightyController::GetLayerOccupancy (uint32_t layer)
+{
+    return m_layerScheduler.GetLayerOccupancy(layer);
+}
+
+double
+DmgAlmightyController::GetLayerConcurrency (void)
+{
+    return m_layerScheduler.GetConcurrency();
+}
+
+
 	void
 DmgAlmightyController:: ConfigureBeaconIntervals (void)
 {
     //exit(-1);
 	NS_LOG_FUNCTION(this);
 
-	// Set beacon interval duration on all nodes
+	// Set beacon interval duration on all the devices
 	for (uint32_t i = 0; i < m_meshNodes->GetN(); i++) {
-		m_meshNodes->Get(i)->GetDevice(0)->GetObject<WifiNetDevice>()->
-			GetMac()->GetObject<DmgWifiMac>()->
-			GetDmgBeaconInterval()->SetBiDuration(NanoSeconds(m_biDuration));
+		std::vector < Ptr<DmgWifiMac> > macs = GetNodeMacs(i);
+		for (uint32_t devIdx = 0; devIdx < macs.size(); devIdx++) {
+			if (macs[devIdx] != 0)
+				macs[devIdx]->GetDmgBeaconInterval()->SetBiDuration(NanoSeconds(m_biDuration));
+		}
 	}
+	std::vector < std::vector < std::vector < Ptr<DmgServicePeriod> > > > sps = BuildServicePeriods(std::vector <bool> (m_meshNodes->GetN(), true));
+
+	//Erase Previous SPs on all devices and install the new ones
+	for (uint32_t staIdx = 0; staIdx < m_meshNodes->GetN(); staIdx++) {
+		std::vector < Ptr<DmgWifiMac> > macs = GetNodeMacs(staIdx);
+		for (uint32_t devIdx = 0; devIdx < macs.size(); devIdx++) {
+			if (macs[devIdx] == 0)
+				continue;
+			Ptr<DmgBeaconInterval> dmgBiSta = macs[devIdx]->GetDmgBeaconInterval();
+			dmgBiSta->EraseSp();
+			for (uint32_t spIdx = 0; spIdx < sps.at(staIdx).at(devIdx).size(); spIdx++) {
+				dmgBiSta->AddSp(sps.at(staIdx).at(devIdx).at(spIdx));
+			}
+		}
+	}
+
+	for (uint32_t staIdx = 0; staIdx < m_meshNodes->GetN(); staIdx++) 
+	{
+		std::vector < Ptr<DmgWifiMac> > macs = GetNodeMacs(staIdx);
+		for (uint32_t devIdx = 0; devIdx < macs.size(); devIdx++) {
+			if (macs[devIdx] == 0)
+				continue;
+			Ptr<DmgBeaconInterval> dmgBiSta = macs[devIdx]->GetDmgBeaconInterval();
+
+			macs[devIdx]->SetDmgBeaconInterval(dmgBiSta);
+			dmgBiSta->SetBeamSwitchOverhead(NanoSeconds(m_beamSwitchOverheadNs));
+			dmgBiSta->ScheduleNextAntennaAlignment();
+
+			if (dmgBiSta->GetSps().size() != 0)
+				macs[devIdx]->StartDmgSpTracking();
+		}
+	}
+
+	//The sweeps are charged to the current BI only
+	m_sweepReleaseEvent.Cancel();
+	if (m_sweepOverheadNs > 0)
+		m_sweepReleaseEvent = Simulator::ScheduleNow(&DmgAlmightyController::ReleaseSweepOverhead, this);
+}
+
+/* For each node flagged in *nodes*, list the SPs buffered in the cliques, in
+ * the order they are installed on the DmgBeaconInterval of each device of
+ * the node: the device on the channel of the link of the SP.
+ */
+	std::vector < std::vector < std::vector < Ptr<DmgServicePeriod> > > >
+DmgAlmightyController::BuildServicePeriods (const std::vector <bool> &nodes)
+{
+	std::vector < std::vector < std::vector < Ptr<DmgServicePeriod> > > > sps (m_meshNodes->GetN());
+	for (uint32_t staIdx = 0; staIdx < m_meshNodes->GetN(); staIdx++) {
+		sps[staIdx].resize(m_meshNodes->Get(staIdx)->GetNDevices());
+	}
+
 	// Prepare the conflictNodes vector
 	std::vector <uint32_t> conflictNodes;
 	for (uint32_t cIdx = 0; cIdx < cliqueS.size(); cIdx++) {
 		conflictNodes.push_back(cliqueS[cIdx].staMem.back());
 	}
-	//Erase Previous SPs on all nodes
-	for (uint32_t staIdx = 0; staIdx < m_meshNodes->GetN(); staIdx++) {
-		Ptr<DmgBeaconInterval> dmgBiSta= m_meshNodes->Get(staIdx)->GetDevice(0)->GetObject<WifiNetDevice>()->GetMac()->GetObject<DmgWifiMac>()->GetDmgBeaconInterval();
-		dmgBiSta->EraseSp();
-	}
 
-	uint64_t overheadDurNs = (uint64_t) ceil(m_biDuration * m_biOverhaedFraction);
+	std::set < std::pair <uint32_t, uint32_t> > interfered = GetInterferedLinks();
+
+	uint64_t overheadDurNs = GetBiOverheadNs();
 	uint64_t scheduleStartNs = overheadDurNs;
 	uint64_t scheduleDurNs = (uint64_t) floor((m_biDuration - overheadDurNs)/m_numSchedulePerBi);
 
@@ -1256,13 +1909,22 @@ DmgAlmightyController:: ConfigureBeaconIntervals (void)
 
 		for (uint32_t cIdx = 0; cIdx < cliqueS.size(); cIdx++){
 			uint32_t conflictNode = conflictNodes.at(cIdx);
+			bool cliqueSelected = false;
+			for (uint32_t cliqMember = 0; cliqMember < cliqueS[cIdx].staMem.size(); cliqMember++) {
+				cliqueSelected = cliqueSelected || nodes.at(cliqueS[cIdx].staMem[cliqMember]);
+			}
+			if (!cliqueSelected)
+				continue;
                         if(scheIdx ==0)
 		        NS_LOG_INFO(" Start installing in clique "<< cIdx);
 
 			for (uint32_t cliqMember = 0; cliqMember < cliqueS[cIdx].staMem.size(); cliqMember++) {
 
 				uint32_t staIdx = cliqueS[cIdx].staMem[cliqMember];
-				if(staIdx == conflictNode){
+				if(!nodes.at(staIdx)){
+					continue;
+				}
+				else if(staIdx == conflictNode){
 					//For conflict node, sort and install
                                         if(scheIdx ==0)
 					NS_LOG_INFO("STA " << staIdx << " is the Cfl of current clique");
@@ -1293,31 +1955,33 @@ DmgAlmightyController:: ConfigureBeaconIntervals (void)
 						uint32_t bufId = bufIdOrder[i];
 						uint32_t staId = (conflictNode == cliqueS[cIdx].flowSegs[segId][0])?(cliqueS[cIdx].flowSegs[segId][1]):(cliqueS[cIdx].flowSegs[segId][0]);
 
-						Ptr<DmgBeaconInterval> dmgBiCfl = m_meshNodes->Get(conflictNode)->GetDevice(0)->GetObject<WifiNetDevice>()->GetMac()->GetObject<DmgWifiMac>()->GetDmgBeaconInterval();
-
 						Ptr<MobilityModel> mobSta = m_meshNodes->Get(staId)->
 							GetObject<MobilityModel> ();
 
-						Mac48Address macSta = m_meshNodes->Get(staId)->GetDevice(0)->
-							GetObject<WifiNetDevice>()->GetMac()->GetObject<DmgWifiMac>()->
-							GetAddress();
+						uint32_t channel = GetLinkChannel(cliqueS[cIdx].flowSegs[segId][0], cliqueS[cIdx].flowSegs[segId][1]);
+						Mac48Address macSta = GetChannelMac(staId, channel)->GetAddress();
+						std::vector < Ptr<DmgServicePeriod> > &cflSps = sps.at(conflictNode).at(GetChannelDevice(conflictNode, channel));
 
 						uint32_t flowSink = m_flowsPath.at(cliqueS[cIdx].flows[segId]).back();
-						uint32_t flowSrc = m_flowsPath.at(cliqueS[cIdx].flows[segId]).front();
-						Ipv4Address ipSink = m_meshNodes->Get(flowSink)->GetObject<Ipv4>()->GetAddress(1,0).GetLocal();
-						Ipv4Address ipSrc = m_meshNodes->Get(flowSrc)->GetObject<Ipv4>()->GetAddress(1,0).GetLocal();
+						Ipv4Address ipSink = GetFlowSinkAddress(cliqueS[cIdx].flows[segId]);
+						Ipv4Address ipSrc = GetFlowSourceAddress(cliqueS[cIdx].flows[segId]);
 
 						Time spStart = NanoSeconds(cliqueS[cIdx].bufStart[segId][bufId] + scheduleStartNs);
 						Time spStop = NanoSeconds(cliqueS[cIdx].bufStart[segId][bufId] + cliqueS[cIdx].bufDurNs[segId][bufId] + scheduleStartNs);
 						Time subSpEnd = spStart + NanoSeconds((uint64_t) floor (cliqueS[cIdx].bufDurNs[segId][bufId]* (1 - m_ackTimeFrac)));
 
 						bool cflIfTx = (conflictNode == cliqueS[cIdx].flowSegs[segId][0])?(true):(false);
+						uint32_t layer = cliqueS[cIdx].bufLayer[segId].empty()?(0):(cliqueS[cIdx].bufLayer[segId][bufId]);
+						bool isolated = m_sim_interference &&
+							!interfered.count(std::make_pair(std::max(conflictNode, staId), std::min(conflictNode, staId)));
 						if (m_ackTimeFrac != 0){
-							dmgBiCfl->AddSp(spStart, subSpEnd, macSta, ipSrc, ipSink, mobSta, cflIfTx);
-							dmgBiCfl->AddSp(subSpEnd, spStop, macSta, ipSink, ipSrc, mobSta, 1 - cflIfTx);//ACK packets are from flow sink to flow src
+							cflSps.push_back(CreateServicePeriod(spStart, subSpEnd, macSta, ipSrc, ipSink, mobSta, cflIfTx, isolated, layer));
+							Ptr<DmgServicePeriod> ackSp = CreateServicePeriod(subSpEnd, spStop, macSta, ipSink, ipSrc, mobSta, 1 - cflIfTx, isolated, layer);//ACK packets are from flow sink to flow src
+							ackSp->SetSpAck(true);
+							cflSps.push_back(ackSp);
 						}
 						else
-							dmgBiCfl->AddSp(spStart, spStop, macSta, ipSrc, ipSink, mobSta, cflIfTx);
+							cflSps.push_back(CreateServicePeriod(spStart, spStop, macSta, ipSrc, ipSink, mobSta, cflIfTx, isolated, layer));
                                                 if(scheIdx ==0)
 						NS_LOG_INFO(" Add SP on Cfl "<< conflictNode <<" for STA" << staId << " from " << spStart << " to "<< spStop << ". Is the cfl Tx? " << cflIfTx <<" sink "<< ipSink <<" (" << flowSink <<")");
 					}
@@ -1365,31 +2029,33 @@ DmgAlmightyController:: ConfigureBeaconIntervals (void)
 						uint32_t segId = segIdOrder[i];
 						uint32_t bufId = bufIdOrder[i];
 
-						Ptr<DmgBeaconInterval> dmgBiSta = m_meshNodes->Get(staIdx)->GetDevice(0)->GetObject<WifiNetDevice>()->GetMac()->GetObject<DmgWifiMac>()->GetDmgBeaconInterval();
-
 						Ptr<MobilityModel> mobCfl = m_meshNodes->Get(conflictNode)->
 							GetObject<MobilityModel> ();
 
-						Mac48Address macCfl = m_meshNodes->Get(conflictNode)->GetDevice(0)->
-							GetObject<WifiNetDevice>()->GetMac()->GetObject<DmgWifiMac>()->
-							GetAddress();
+						uint32_t channel = GetLinkChannel(cliqueS[cIdx].flowSegs[segId][0], cliqueS[cIdx].flowSegs[segId][1]);
+						Mac48Address macCfl = GetChannelMac(conflictNode, channel)->GetAddress();
+						std::vector < Ptr<DmgServicePeriod> > &staSps = sps.at(staIdx).at(GetChannelDevice(staIdx, channel));
 
 						uint32_t flowSink = m_flowsPath.at(cliqueS[cIdx].flows[segId]).back();
-						uint32_t flowSrc = m_flowsPath.at(cliqueS[cIdx].flows[segId]).front();
-						Ipv4Address ipSink = m_meshNodes->Get(flowSink)->GetObject<Ipv4>()->GetAddress(1,0).GetLocal();
-						Ipv4Address ipSrc = m_meshNodes->Get(flowSrc)->GetObject<Ipv4>()->GetAddress(1,0).GetLocal();
+						Ipv4Address ipSink = GetFlowSinkAddress(cliqueS[cIdx].flows[segId]);
+						Ipv4Address ipSrc = GetFlowSourceAddress(cliqueS[cIdx].flows[segId]);
 
 						Time spStart = NanoSeconds(cliqueS[cIdx].bufStart[segId][bufId] + scheduleStartNs);
 						Time spStop = NanoSeconds(cliqueS[cIdx].bufStart[segId][bufId] + cliqueS[cIdx].bufDurNs[segId][bufId] + scheduleStartNs);
 						Time subSpEnd = spStart + NanoSeconds((uint64_t) floor (cliqueS[cIdx].bufDurNs[segId][bufId]* (1 - m_ackTimeFrac)));
 
 						bool staIfTx = (staIdx == cliqueS[cIdx].flowSegs[segId][0])?(true):(false);
+						uint32_t layer = cliqueS[cIdx].bufLayer[segId].empty()?(0):(cliqueS[cIdx].bufLayer[segId][bufId]);
+						bool isolated = m_sim_interference &&
+							!interfered.count(std::make_pair(std::max(staIdx, conflictNode), std::min(staIdx, conflictNode)));
 						if (m_ackTimeFrac != 0){
-							dmgBiSta->AddSp(spStart, subSpEnd, macCfl, ipSrc, ipSink, mobCfl, staIfTx);
-							dmgBiSta->AddSp(subSpEnd, spStop, macCfl, ipSink, ipSrc, mobCfl, 1 - staIfTx);
+							staSps.push_back(CreateServicePeriod(spStart, subSpEnd, macCfl, ipSrc, ipSink, mobCfl, staIfTx, isolated, layer));
+							Ptr<DmgServicePeriod> ackSp = CreateServicePeriod(subSpEnd, spStop, macCfl, ipSink, ipSrc, mobCfl, 1 - staIfTx, isolated, layer);
+							ackSp->SetSpAck(true);
+							staSps.push_back(ackSp);
 						}
 						else
-							dmgBiSta->AddSp(spStart, spStop, macCfl, ipSrc, ipSink, mobCfl, staIfTx);
+							staSps.push_back(CreateServicePeriod(spStart, spStop, macCfl, ipSrc, ipSink, mobCfl, staIfTx, isolated, layer));
 
                                                 if(scheIdx ==0)
 						NS_LOG_INFO(" Add SP on STA "<< staIdx <<" from "<< spStart<<" to "<< spStop << " Tx? " << staIfTx  <<" sink "<< ipSink <<" (" << flowSink <<")");
@@ -1399,85 +2065,45 @@ DmgAlmightyController:: ConfigureBeaconIntervals (void)
 		}//end clique        
 		scheduleStartNs += scheduleDurNs;
 	}
+	return sps;
+}
 
-	for (uint32_t staIdx = 0; staIdx < m_meshNodes->GetN(); staIdx++) 
-	{
-		Ptr<DmgBeaconInterval> dmgBiSta = m_meshNodes->Get(staIdx)->GetDevice(0)->
-			GetObject<WifiNetDevice>()->GetMac()->GetObject<DmgWifiMac>()->GetDmgBeaconInterval();
-
-		m_meshNodes->Get(staIdx)->GetDevice(0)->GetObject<WifiNetDevice>()->GetMac()->GetObject<DmgWifiMac>()->SetDmgBeaconInterval(dmgBiSta);
-		dmgBiSta->SetBeamSwitchOverhead(NanoSeconds(m_beamSwitchOverheadNs));
-		dmgBiSta->ScheduleNextAntennaAlignment();
-
-		if (m_meshNodes->Get(staIdx)->GetDevice(0)->GetObject<WifiNetDevice>()->GetMac()->GetObject<DmgWifiMac>()->GetDmgBeaconInterval()-> GetSps().size() != 0) 
-		{
-			m_meshNodes->Get(staIdx)->GetDevice(0)->GetObject<WifiNetDevice>()->
-				GetMac()->GetObject<DmgWifiMac>()->StartDmgSpTracking();
+std::set < std::pair <uint32_t, uint32_t> >
+DmgAlmightyController::GetInterferedLinks (void)
+{
+	// m_intfStas[i] = (a, b, victim, partner): victim is interfered when it
+	// receives from partner while a transmits to b. Both links are involved.
+	std::set < std::pair <uint32_t, uint32_t> > interfered;
+	for (uint32_t i = 0; i < m_intfStas.size(); i++){
+		for (uint32_t k = 0; k < 4; k += 2){
+			uint32_t x = m_intfStas[i][k];
+			uint32_t y = m_intfStas[i][k + 1];
+			interfered.insert(std::make_pair(std::max(x, y), std::min(x, y)));
 		}
 	}
+	return interfered;
+}
+
+/* MCS table of the PHY flavour of phy, built the first time it is needed */
+	const DmgMcsTable &
+DmgAlmightyController::GetMcsTable (Ptr<YansWifiPhy> phy)
+{
+	std::pair<bool, uint16_t> flavour = std::make_pair(phy->GetDmgOfdm(), phy->GetExtendedRateMode());
+	std::map<std::pair<bool, uint16_t>, DmgMcsTable>::iterator it = m_mcsTables.find(flavour);
+	if (it == m_mcsTables.end()) {
+		it = m_mcsTables.insert(std::make_pair(flavour, DmgMcsTable())).first;
+		it->second.Build(phy);
+	}
+	return it->second;
 }
 
 /* Utility function used internally to this module to configure the
  * WifiRemoteStationManager
  */
 	WifiMode
-DmgAlmightyController::GetWifiMode (double rxPowerDbi, bool ofdm)
-{
-	std::string ret = "VHTMCS0";
-
-	if (ofdm) {
-		if (rxPowerDbi >= -47)
-			ret = "VHTMCS24a";
-		else if (rxPowerDbi >= -49)
-			ret = "VHTMCS23a";
-		else if (rxPowerDbi >= -51)
-			ret = "VHTMCS22a";
-		else if (rxPowerDbi >= -53)
-			ret = "VHTMCS21a";
-		else if (rxPowerDbi >= -54)
-			ret = "VHTMCS20a";
-		else if (rxPowerDbi >= -56)
-			ret = "VHTMCS19a";
-		else if (rxPowerDbi >= -58)
-			ret = "VHTMCS18a";
-		else if (rxPowerDbi >= -60)
-			ret = "VHTMCS17a";
-		else if (rxPowerDbi >= -62)
-			ret = "VHTMCS16a";
-		else if (rxPowerDbi >= -63)
-			ret = "VHTMCS15a";
-		else if (rxPowerDbi >= -64)
-			ret = "VHTMCS14a";
-		else if (rxPowerDbi >= -66)
-			ret = "VHTMCS13a";
-
-	} else {
-		if (rxPowerDbi >= -53)
-			ret = "VHTMCS12";
-		else if (rxPowerDbi >= -54)
-			ret = "VHTMCS11";
-		else if (rxPowerDbi >= -55)
-			ret = "VHTMCS10";
-		else if (rxPowerDbi >= -59)
-			ret = "VHTMCS9";
-		else if (rxPowerDbi >= -61)
-			ret = "VHTMCS8";
-		else if (rxPowerDbi >= -62)
-			ret = "VHTMCS7";
-		//ret = "VHTMCS5";
-		else if (rxPowerDbi >= -63)
-			ret = "VHTMCS6";
-		else if (rxPowerDbi >= -64)
-			ret = "VHTMCS4";
-		else if (rxPowerDbi >= -65)
-			ret = "VHTMCS3";
-		else if (rxPowerDbi >= -66)
-			ret = "VHTMCS2";
-		else if (rxPowerDbi >= -68)
-			ret = "VHTMCS1";
-	}
-
-	return ret;
+DmgAlmightyController::GetWifiMode (double rxPowerDbi, Ptr<YansWifiPhy> phy)
+{
+	return GetMcsTable(phy).LookupRxPower(rxPowerDbi);
 }
 
 /* Configure, on each node, the ideal Tx MCS for each possible destination
@@ -1486,53 +2112,46 @@ DmgAlmightyController::GetWifiMode (double rxPowerDbi, bool ofdm)
 DmgAlmightyController::ConfigureWifiManager (void)
 {
 	ConfigureAntennaAlignment();
-	//to be go through the link list
-	for (uint32_t staIdx = 0; staIdx < m_meshNodes->GetN(); staIdx++) {
-		for (uint32_t linkIdx = 0; linkIdx < m_linkList.size(); linkIdx++){
-
-			uint32_t neighId;
-
-			if (staIdx != m_linkList[linkIdx][0] && staIdx != m_linkList[linkIdx][1])
-				continue;
-			else 
-				neighId = (staIdx == m_linkList[linkIdx][0])?(m_linkList[linkIdx][1]):(m_linkList[linkIdx][0]);
-
-			Ptr<DmgWifiMac> staMac =
-				m_meshNodes->Get(staIdx)->GetDevice(0)->GetObject<WifiNetDevice>()->
-				GetMac()->GetObject<DmgWifiMac>();
-			Ptr<DmgWifiMac> neiMac =
-				m_meshNodes->Get(neighId)->GetDevice(0)->GetObject<WifiNetDevice>()->
-				GetMac()->GetObject<DmgWifiMac>();
-
-			Ptr<DmgDestinationFixedWifiManager> staManager = staMac->
-				GetWifiRemoteStationManager()->GetObject<DmgDestinationFixedWifiManager>();
-			Ptr<DmgDestinationFixedWifiManager> neiManager = neiMac->
-				GetWifiRemoteStationManager()->GetObject<DmgDestinationFixedWifiManager>();
-
-			double neiRxPower = GetIdealRxPower(m_meshNodes->Get(staIdx), m_meshNodes->Get(neighId));
-			double staRxPower = GetIdealRxPower(m_meshNodes->Get(neighId), m_meshNodes->Get(staIdx));
-
-			//NS_LOG_UNCOND("sta rx power" << staRxPower);
-
-
-
-			bool dmgOfdm = m_meshNodes->Get(staIdx)->GetDevice(0)->GetObject<WifiNetDevice>()->
-				GetPhy()->GetObject<YansWifiPhy> () ->GetDmgOfdm();
-
-			WifiMode neiWifiMode = GetWifiMode(staRxPower, dmgOfdm);
-			WifiMode staWifiMode = GetWifiMode(neiRxPower, dmgOfdm);
-
-			Mac48Address neiMacAddr = neiMac->GetAddress();
-			Mac48Address staMacAddr = staMac->GetAddress();
-
-			staManager->AddDestinationWifiMode(neiMacAddr, staWifiMode);
-			neiManager->AddDestinationWifiMode(staMacAddr, neiWifiMode);
-
-			if(staWifiMode.GetUniqueName() == "VHTMCS0"){
-				NS_LOG_UNCOND( "ERROR: Mesh node "<< staIdx << " is in mode MCS 0 with node" << neighId);
-				if (neiRxPower <= m_energyDetectionThreshold)
+	//each link once, for both directions
+	for (uint32_t linkIdx = 0; linkIdx < m_linkList.size(); linkIdx++){
+		uint32_t staIdx = m_linkList[linkIdx][0];
+		uint32_t neighId = m_linkList[linkIdx][1];
+		Ptr<Node> sta = m_meshNodes->Get(staIdx);
+		Ptr<Node> nei = m_meshNodes->Get(neighId);
+
+		Ptr<DmgWifiMac> staMac = GetLinkMac(staIdx, neighId);
+		Ptr<DmgWifiMac> neiMac = GetLinkMac(neighId, staIdx);
+
+		Ptr<DmgDestinationFixedWifiManager> staManager = staMac->
+			GetWifiRemoteStationManager()->GetObject<DmgDestinationFixedWifiManager>();
+		Ptr<DmgDestinationFixedWifiManager> neiManager = neiMac->
+			GetWifiRemoteStationManager()->GetObject<DmgDestinationFixedWifiManager>();
+
+		double neiRxPower = GetIdealRxPower(sta, nei);
+		double staRxPower = GetIdealRxPower(nei, sta);
+
+		Ptr<YansWifiPhy> staPhy = sta->GetDevice(0)->GetObject<WifiNetDevice>()->
+			GetPhy()->GetObject<YansWifiPhy> ();
+		Ptr<YansWifiPhy> neiPhy = nei->GetDevice(0)->GetObject<WifiNetDevice>()->
+			GetPhy()->GetObject<YansWifiPhy> ();
+
+		//the mode is chosen with the table of the receiver
+		WifiMode neiWifiMode = GetWifiMode(staRxPower, staPhy);
+		WifiMode staWifiMode = GetWifiMode(neiRxPower, neiPhy);
+
+		staManager->AddDestinationWifiMode(nei->GetId(), neiMac->GetAddress(), staWifiMode);
+		neiManager->AddDestinationWifiMode(sta->GetId(), staMac->GetAddress(), neiWifiMode);
+
+		for (uint32_t end = 0; end < 2; end++) {
+			uint32_t from = end ? neighId : staIdx;
+			uint32_t to = end ? staIdx : neighId;
+			WifiMode mode = end ? neiWifiMode : staWifiMode;
+			double rxPower = end ? staRxPower : neiRxPower;
+			if(mode.GetUniqueName() == "VHTMCS0"){
+				NS_LOG_UNCOND( "ERROR: Mesh node "<< from << " is in mode MCS 0 with node" << to);
+				if (rxPower <= m_energyDetectionThreshold)
 				{
-					NS_LOG_INFO( "Node "<< neighId << "is out of node "<< staIdx << "'s range." );
+					NS_LOG_INFO( "Node "<< to << "is out of node "<< from << "'s range." );
 				}
 				exit(-1);
 			}
@@ -1628,20 +2247,276 @@ double DmgAlmightyController::GetInterferencePowerFromPair (Ptr<Node> victim, Pt
 	return victimRxPower;
 }
 
+void DmgAlmightyController::BuildRadioCache(void)
+{
+	uint32_t nodesN = m_meshNodes->GetN();
+	m_radio.assign(nodesN, NodeRadio());
+	for (uint32_t nodeIdx = 0; nodeIdx < nodesN; nodeIdx++){
+		Ptr<WifiNetDevice> device = m_meshNodes->Get(nodeIdx)->GetDevice(0)->GetObject<WifiNetDevice>();
+		m_radio[nodeIdx].phy = device->GetPhy()->GetObject<YansWifiPhy> ();
+		m_radio[nodeIdx].antenna = device->GetMac()->GetObject<DmgWifiMac>()->GetDmgAntennaController();
+		m_radio[nodeIdx].mobility = m_meshNodes->Get(nodeIdx)->GetObject<MobilityModel> ();
+		m_radio[nodeIdx].position = m_radio[nodeIdx].mobility->GetPosition();
+	}
+	PairGeometry unknown;
+	unknown.valid = false;
+	unknown.rxPowerDbm = 0;
+	unknown.azimuth = 0;
+	unknown.elevation = 0;
+	m_pairGeometry.assign(nodesN, std::vector<PairGeometry> (nodesN, unknown));
+
+	//Bucket the nodes in square cells as large as the interference range
+	m_grid.clear();
+	m_gridCellSize = GetInterferenceRange();
+	if (m_gridCellSize > 0){
+		for (uint32_t nodeIdx = 0; nodeIdx < nodesN; nodeIdx++){
+			int64_t cx = (int64_t) std::floor(m_radio[nodeIdx].position.x / m_gridCellSize);
+			int64_t cy = (int64_t) std::floor(m_radio[nodeIdx].position.y / m_gridCellSize);
+			m_grid[std::make_pair(cx, cy)].push_back(nodeIdx);
+		}
+	}
+}
+
+const DmgAlmightyController::PairGeometry &
+DmgAlmightyController::GetPairGeometry(uint32_t from, uint32_t to)
+{
+	PairGeometry &geo = m_pairGeometry[from][to];
+	if (!geo.valid){
+		Ptr<YansWifiPhy> phy = m_radio[from].phy;
+		Ptr<PropagationLossModel> loss = phy->GetChannel()->GetObject<YansWifiChannel>()->GetPropagationLossModel();
+		geo.rxPowerDbm = loss->CalcRxPower(phy->GetTxPowerStart() + phy->GetTxGain(),
+				m_radio[from].mobility, m_radio[to].mobility);
+		geo.azimuth = CalculateAzimuthAngle(m_radio[from].position, m_radio[to].position);
+		geo.elevation = CalculateElevationAngle(m_radio[from].position, m_radio[to].position);
+		geo.valid = true;
+	}
+	return geo;
+}
+
+double DmgAlmightyController::GetInterferenceRange(void)
+{
+	if (m_interfRange > 0)
+		return m_interfRange;
+	return GetFriisRange(m_interfThreshold);
+}
+
+double DmgAlmightyController::GetFriisRange(double rxPowerDbm)
+{
+	if (m_radio.empty())
+		return 0;
+
+	//Only a bare Friis model gives a distance beyond which the received power
+	//is always below the threshold. Any other model is not bounded.
+	Ptr<PropagationLossModel> loss = m_radio[0].phy->GetChannel()->GetObject<YansWifiChannel>()->GetPropagationLossModel();
+	if (loss->GetNext() != 0)
+		return 0;
+	double frequency, systemLoss;
+	Ptr<FriisLoSPropagationLossModel> friisLoS = loss->GetObject<FriisLoSPropagationLossModel> ();
+	Ptr<FriisPropagationLossModel> friis = loss->GetObject<FriisPropagationLossModel> ();
+	if (friisLoS != 0){
+		frequency = friisLoS->GetFrequency();
+		systemLoss = friisLoS->GetSystemLoss();
+	}
+	else if (friis != 0){
+		frequency = friis->GetFrequency();
+		systemLoss = friis->GetSystemLoss();
+	}
+	else
+		return 0;
+
+	double maxTx = -std::numeric_limits<double>::infinity();
+	double maxAntennaGain = -std::numeric_limits<double>::infinity();
+	double maxRxGain = -std::numeric_limits<double>::infinity();
+	for (uint32_t nodeIdx = 0; nodeIdx < m_radio.size(); nodeIdx++){
+		Ptr<YansWifiPhy> phy = m_radio[nodeIdx].phy;
+		maxTx = std::max(maxTx, phy->GetTxPowerStart() + phy->GetTxGain());
+		maxTx = std::max(maxTx, phy->GetTxPowerEnd() + phy->GetTxGain());
+		maxAntennaGain = std::max(maxAntennaGain, m_radio[nodeIdx].antenna->GetMaxGainDbi());
+		maxRxGain = std::max(maxRxGain, phy->GetRxGain());
+	}
+	double budgetDb = maxTx + 2 * maxAntennaGain + maxRxGain - rxPowerDbm - 10 * std::log10(systemLoss);
+	double lambda = 299792458.0 / frequency;
+	double range = lambda / (4 * M_PI) * std::pow(10.0, budgetDb / 20);
+	if (!(range < std::numeric_limits<double>::max()))
+		return 0;
+	return range;
+}
+
+std::vector<uint32_t> DmgAlmightyController::GetNodesInRange(uint32_t node, double range)
+{
+	std::vector<uint32_t> nodes;
+	if (range <= 0 || m_gridCellSize <= 0){
+		for (uint32_t nodeIdx = 0; nodeIdx < m_radio.size(); nodeIdx++)
+			nodes.push_back(nodeIdx);
+		return nodes;
+	}
+	const Vector &pos = m_radio[node].position;
+	int64_t cells = (int64_t) std::ceil(range / m_gridCellSize);
+	int64_t cx = (int64_t) std::floor(pos.x / m_gridCellSize);
+	int64_t cy = (int64_t) std::floor(pos.y / m_gridCellSize);
+	for (int64_t x = cx - cells; x <= cx + cells; x++){
+		for (int64_t y = cy - cells; y <= cy + cells; y++){
+			std::map<std::pair<int64_t, int64_t>, std::vector<uint32_t> >::const_iterator cell = m_grid.find(std::make_pair(x, y));
+			if (cell == m_grid.end())
+				continue;
+			for (uint32_t i = 0; i < cell->second.size(); i++){
+				//small margin so that rounding never drops a node at the edge
+				if (CalculateDistance(pos, m_radio[cell->second[i]].position) <= range * (1 + 1e-9))
+					nodes.push_back(cell->second[i]);
+			}
+		}
+	}
+	std::sort(nodes.begin(), nodes.end());
+	return nodes;
+}
+
+void DmgAlmightyController::FindInterferedLinks(uint32_t chunk, uint32_t begin, uint32_t end)
+{
+	//Plain pointers only: Ptr reference counts are not thread safe
+	std::vector <AbstractAntenna *> antennas (m_planningAntennas[chunk].size());
+	for (uint32_t n = 0; n < antennas.size(); n++){
+		antennas[n] = PeekPointer(m_planningAntennas[chunk][n]);
+	}
+	uint64_t pairsN = 0;
+	std::vector <double> azimuths, elevations, txGains;
+	for (uint32_t staIdx = begin; staIdx < end; staIdx++) {
+		const std::vector <uint32_t> &victims = m_nodeVictims[staIdx];
+		m_interfered[staIdx].resize(m_nodeLinks[staIdx].size());
+		azimuths.resize(victims.size());
+		elevations.resize(victims.size());
+		txGains.resize(victims.size());
+		for (uint32_t v = 0; v < victims.size(); v++){
+			azimuths[v] = m_pairGeometry[staIdx][victims[v]].azimuth;
+			elevations[v] = m_pairGeometry[staIdx][victims[v]].elevation;
+		}
+		for (uint32_t l = 0; l < m_nodeLinks[staIdx].size(); l++){
+			uint32_t linkIdx = m_nodeLinks[staIdx][l];
+			uint32_t neighId = (staIdx == m_linkList[linkIdx][0])?(m_linkList[linkIdx][1]):(m_linkList[linkIdx][0]);
+			antennas[staIdx]->SetAzimuthAngle(m_linkPointing[linkIdx][staIdx == m_linkList[linkIdx][1]]);
+			if (!victims.empty())
+				antennas[staIdx]->GetTxGainsDbi(&azimuths[0], &elevations[0], &txGains[0], victims.size());
+
+			//-----------------------measure interference for other stations
+			std::vector <InterferedLink> &hits = m_interfered[staIdx][l];
+			for (uint32_t v = 0; v < victims.size(); v++){
+				uint32_t victim = victims[v];
+				if (victim == neighId)
+					continue;
+				const PairGeometry &geo = m_pairGeometry[staIdx][victim];
+				double txPower = geo.rxPowerDbm + txGains[v];
+				if (txPower + m_maxRxGain[victim] + m_phyRxGain[victim] <= m_interfThreshold)
+					continue;
+				for (uint32_t vl = 0; vl < m_nodeLinks[victim].size(); vl++){
+					uint32_t intfLinkIdx = m_nodeLinks[victim][vl];
+					uint32_t partner = (victim == m_linkList[intfLinkIdx][0])?(m_linkList[intfLinkIdx][1]):(m_linkList[intfLinkIdx][0]);
+					if (partner == staIdx || partner == neighId)
+						continue;
+					pairsN++;
+					antennas[victim]->SetAzimuthAngle(m_linkPointing[intfLinkIdx][victim == m_linkList[intfLinkIdx][1]]);
+					double victimRxPower = txPower +
+						antennas[victim]->GetRxGainDbi(geo.azimuth + M_PI, -geo.elevation) +
+						m_phyRxGain[victim];
+					if (victimRxPower > m_interfThreshold){
+						InterferedLink hit;
+						hit.intfLinkIdx = intfLinkIdx;
+						hit.victimEnd = (victim == m_linkList[intfLinkIdx][1]);
+						hit.rxPowerDbm = victimRxPower;
+						hits.push_back(hit);
+					}
+				}
+			}
+			std::sort(hits.begin(), hits.end());
+		}
+	}
+	m_pairsEvaluated[chunk] += pairsN;
+}
+
+void DmgAlmightyController::ComputeTimeAlloc(uint32_t, uint32_t begin, uint32_t end)
+{
+	for (uint32_t cIdx = begin; cIdx < end; cIdx++){
+		for (uint32_t segIdx = 0; segIdx < cliqueS[cIdx].flows.size(); segIdx++){
+			cliqueS[cIdx].timeAlloc[segIdx] = (cliqueS[cIdx].phyRate[segIdx] > 0)?(m_flowsRate[cliqueS[cIdx].flows[segIdx]]/cliqueS[cIdx].phyRate[segIdx]):(0);
+		}
+	}
+}
+
+uint32_t DmgAlmightyController::GetNPlanningChunks(uint32_t n) const
+{
+#ifdef HAVE_PTHREAD_H
+	return std::max((uint32_t) 1, std::min(m_planningThreads, n));
+#else
+	return 1;
+#endif
+}
+
+namespace {
+/* A chunk of a DmgAlmightyController::ParallelFor */
+struct PlanningChunk
+{
+	Callback<void, uint32_t, uint32_t, uint32_t> task;
+	uint32_t chunk;
+	uint32_t begin;
+	uint32_t end;
+	void Run (void)
+	{
+		task(chunk, begin, end);
+	}
+};
+}
+
+void DmgAlmightyController::ParallelFor(uint32_t n, Callback<void, uint32_t, uint32_t, uint32_t> task)
+{
+	uint32_t chunksN = GetNPlanningChunks(n);
+	std::vector <PlanningChunk> chunks (chunksN);
+	for (uint32_t c = 0; c < chunksN; c++){
+		chunks[c].task = task;
+		chunks[c].chunk = c;
+		chunks[c].begin = (uint64_t) n * c / chunksN;
+		chunks[c].end = (uint64_t) n * (c + 1) / chunksN;
+	}
+#ifdef HAVE_PTHREAD_H
+	//the calling thread runs the first chunk
+	std::vector < Ptr<SystemThread> > threads;
+	for (uint32_t c = 1; c < chunksN; c++){
+		threads.push_back(Create<SystemThread> (MakeCallback(&PlanningChunk::Run, &chunks[c])));
+		threads.back()->Start();
+	}
+	if (chunksN)
+		chunks[0].Run();
+	for (uint32_t t = 0; t < threads.size(); t++){
+		threads[t]->Join();
+	}
+#else
+	for (uint32_t c = 0; c < chunksN; c++){
+		chunks[c].Run();
+	}
+#endif
+}
+
 void DmgAlmightyController::EnforceAdditionalSignalLossBetween(Ptr<Node> node1, Ptr<Node> node2, double addLoss)
 {
+	//the link is blocked: its sectors must be trained again
+	Ptr<DmgWifiMac> n1Mac = GetLinkMac(node1->GetId(), node2->GetId());
+	Ptr<DmgWifiMac> n2Mac = GetLinkMac(node2->GetId(), node1->GetId());
+	Ptr<BeamformingEngine> engine1 = n1Mac->GetDmgAntennaController()->GetBeamformingEngine();
+	Ptr<BeamformingEngine> engine2 = n2Mac->GetDmgAntennaController()->GetBeamformingEngine();
+	if (engine1 != 0)
+		engine1->InvalidatePeer(node2->GetObject<MobilityModel>());
+	if (engine2 != 0)
+		engine2->InvalidatePeer(node1->GetObject<MobilityModel>());
+
 	double node1RxPower = GetIdealRxPower(node2, node1);
 	double node2RxPower = GetIdealRxPower(node1, node2);
 
-	bool dmgOfdm1 = node1->GetDevice(0)->GetObject<WifiNetDevice>()->
-		GetPhy()->GetObject<YansWifiPhy> () ->GetDmgOfdm();
-	bool dmgOfdm2 = node2->GetDevice(0)->GetObject<WifiNetDevice>()->
-		GetPhy()->GetObject<YansWifiPhy> () ->GetDmgOfdm();
+	Ptr<YansWifiPhy> phy1 = node1->GetDevice(0)->GetObject<WifiNetDevice>()->
+		GetPhy()->GetObject<YansWifiPhy> ();
+	Ptr<YansWifiPhy> phy2 = node2->GetDevice(0)->GetObject<WifiNetDevice>()->
+		GetPhy()->GetObject<YansWifiPhy> ();
 
 	NS_LOG_INFO("Node "<< node1->GetId() << " and Node "<< node2->GetId() <<" rx power "<<node1RxPower <<" and "<< node2RxPower);
 
-	WifiMode n1WifiMode = GetWifiMode(node2RxPower - addLoss, dmgOfdm1);
-	WifiMode n2WifiMode = GetWifiMode(node1RxPower - addLoss, dmgOfdm2);
+	WifiMode n1WifiMode = GetWifiMode(node2RxPower - addLoss, phy2);
+	WifiMode n2WifiMode = GetWifiMode(node1RxPower - addLoss, phy1);
 
 	if(node1RxPower - addLoss <= -66)
 		NS_LOG_WARN("node1RxPower - addLoss <= -66");
@@ -1649,174 +2524,89 @@ void DmgAlmightyController::EnforceAdditionalSignalLossBetween(Ptr<Node> node1,
 	NS_LOG_INFO("  .reduced to " << node1RxPower - addLoss << " and "<< node2RxPower - addLoss);
 	NS_LOG_INFO("  ..wifi mode " << n1WifiMode.GetUniqueName() << " and "<< n2WifiMode.GetUniqueName());
 
-	Ptr<DmgWifiMac> n1Mac = node1->GetDevice(0)->GetObject<WifiNetDevice>()->
-		GetMac()->GetObject<DmgWifiMac>();
-	Ptr<DmgWifiMac> n2Mac = node2->GetDevice(0)->GetObject<WifiNetDevice>()->
-		GetMac()->GetObject<DmgWifiMac>();
-
 	Ptr<DmgDestinationFixedWifiManager> n1Manager = n1Mac->
 		GetWifiRemoteStationManager()->GetObject<DmgDestinationFixedWifiManager>();
 	Ptr<DmgDestinationFixedWifiManager> n2Manager = n2Mac->
 		GetWifiRemoteStationManager()->GetObject<DmgDestinationFixedWifiManager>();
 
-	n1Manager->AddDestinationWifiMode(n2Mac->GetAddress(), n1WifiMode);
-	n2Manager->AddDestinationWifiMode(n1Mac->GetAddress(), n2WifiMode);
+	n1Manager->AddDestinationWifiMode(node2->GetId(), n2Mac->GetAddress(), n1WifiMode);
+	n2Manager->AddDestinationWifiMode(node1->GetId(), n1Mac->GetAddress(), n2WifiMode);
 }
 
 
 double DmgAlmightyController::GetActualTxDurationNs(WifiMode mode, uint32_t nMpdus)
 {
-	double ret = 0.0;
-	//if (ofdm) {// OFDM ONLY FOR NOW
-	if (mode == std::string("VHTMCS24a"))
-        {
-                if (nMpdus == 30)
-		        ret = 65291;
-                else if (nMpdus == 10)
-		        ret = 26107;
-                else if (nMpdus == 5)
-		        ret = 16880;
-                else if (nMpdus == 1)
-		        ret = 9624;
-        }
-	else if (mode == std::string("VHTMCS23a"))
-        {
-                if (nMpdus == 30)
-		        ret = 69883;
-                else if (nMpdus == 10)
-                        ret = 27659;
-                else if (nMpdus == 5)
-		        ret = 17683;
-                else if (nMpdus == 1)
-		        ret = 9942;
-        }	
-        else if (mode == std::string("VHTMCS22a"))
-        {
-                if (nMpdus == 30)
-		ret = 81779;
-                else if (nMpdus == 10)
-                        ret = 31582;
-                else if (nMpdus == 5)
-		        ret = 19728;
-                else if (nMpdus == 1)
-		        ret = 10282;
-        }	
-        else if (mode == std::string("VHTMCS21a"))
-        {
-                if (nMpdus == 30)
-		        ret = 92700;
-                else if (nMpdus == 10)
-                        ret = 35332;
-                else if (nMpdus == 5)
-		        ret = 21745;
-                else if (nMpdus == 1)
-		        ret = 10836;
-        }
-	else if (mode == std::string("VHTMCS20a"))
-        {
-                if (nMpdus == 30)
-		        ret = 99481;
-                else if (nMpdus == 10)
-                        ret = 37767;
-                else if (nMpdus == 5)
-		        ret = 22999;
-                else if (nMpdus == 1)
-		        ret = 11136;
-        }
-	else if (mode == std::string("VHTMCS19a"))
-        {
-                if (nMpdus == 30)
-		        ret = 117180;
-                else if (nMpdus == 10)
-                        ret = 43713;
-                else if (nMpdus == 5)
-                        ret = 26071;
-                else if (nMpdus == 1)
-		        ret = 11698;
-        }	
-        else if (mode == std::string("VHTMCS18a"))
-        {
-                if (nMpdus == 30)
-		        ret = 143830;
-                else if (nMpdus == 10)
-                        ret = 52724;
-                else if (nMpdus == 5)
-                        ret = 30454;
-                else if (nMpdus == 1)
-		        ret = 12782;
-        }
-	/*else if (mode == std::string("VHTMCS17a"))
-        {
-                if (nMpdus == 30)
-		ret = 188435;
-                else if (nMpdus == 1)
-		        ret = 9624;
-	}
-        else if (mode == std::string("VHTMCS16a"))
-        {
-                if (nMpdus == 30)
-		ret = 223878;
-                else if (nMpdus == 1)
-		        ret = 9624;
-	}
-        else if (mode == std::string("VHTMCS15a"))
-        {
-                if (nMpdus == 30)
-		ret = 277194;
-                else if (nMpdus == 1)
-		        ret = 9624;
-	}
-        else if (mode == std::string("VHTMCS14a"))
-        {
-                if (nMpdus == 30)
-		ret = 437174;
-                else if (nMpdus == 1)
-		        ret = 9624;
-        }
-	else if (mode == std::string("VHTMCS13a"))
-        {
-                if (nMpdus == 30)
-		ret = 543726;
-                else if (nMpdus == 1)
-		        ret = 9624;
-        }*/
-	return ret;
+	ConfigureAirtimeModel();
+	// MSDU: application payload + UDP/IP headers + LLC/SNAP
+	return m_airtimeModel.GetExchangeDuration(mode, nMpdus, m_appPayloadBytes + 36).GetNanoSeconds();
+}
+
+	void
+DmgAlmightyController::ConfigureAirtimeModel(void)
+{
+	if (m_airtimeModelConfigured)
+		return;
+	Ptr<WifiNetDevice> dev = m_meshNodes->Get(0)->GetDevice(0)->GetObject<WifiNetDevice>();
+	Ptr<DmgWifiMac> mac = dev->GetMac()->GetObject<DmgWifiMac>();
+	m_airtimeModel.SetPhy(dev->GetPhy());
+	m_airtimeModel.SetSifs(mac->GetSifs());
+	m_airtimeModel.SetPropagationGuard(mac->GetPropagationGuard());
+	TimeValue ackTimeoutGuard;
+	mac->GetAttribute("DmgAckTimeoutGuard", ackTimeoutGuard);
+	m_airtimeModel.SetAckTimeoutGuard(ackTimeoutGuard.Get());
+	m_airtimeModelConfigured = true;
 }
 
 	void
 DmgAlmightyController::ConfigurePhyRate(uint32_t appPayloadBytes, double biOverheadFraction, uint32_t nMpdus)
 {
 	NS_LOG_FUNCTION(this);
+	m_appPayloadBytes = appPayloadBytes;
+	m_phyRateOverheadFraction = biOverheadFraction;
+	m_nMpdus = nMpdus;
+	ConfigureAirtimeModel();
+	m_airtimeModel.Precompute(m_nMpdus, m_appPayloadBytes + 36);
 	for (uint32_t cIdx = 0; cIdx< cliqueS.size(); cIdx++){
 
         if (m_sim_interference && (cIdx >= m_interfCliqueStart)){
             NS_LOG_INFO("In interfeing clique "<< cIdx);
         }
 		for (uint32_t segIdx = 0; segIdx < cliqueS[cIdx].flows.size(); segIdx++){
-			uint32_t neiIdx = cliqueS[cIdx].flowSegs[segIdx][1];
-			uint32_t staIdx = cliqueS[cIdx].flowSegs[segIdx][0];
-			Mac48Address neiMacAddr = m_meshNodes->Get(neiIdx)->GetDevice(0)->GetObject<WifiNetDevice>()->GetMac()->GetObject<DmgWifiMac>()->GetAddress();
-			WifiMode sta2NeiWifiMode = m_meshNodes->Get(staIdx)->GetDevice(0)->GetObject<WifiNetDevice>()->GetMac()->GetObject<DmgWifiMac>()-> GetWifiRemoteStationManager()->GetObject<DmgDestinationFixedWifiManager>()->GetDestinationWifiMode(neiMacAddr);
+			ConfigureSegPhyRate(cIdx, segIdx);
+		}
+	}
+}
+
+	void
+DmgAlmightyController::ConfigureSegPhyRate(uint32_t cIdx, uint32_t segIdx)
+{
+		uint32_t neiIdx = cliqueS[cIdx].flowSegs[segIdx][1];
+		uint32_t staIdx = cliqueS[cIdx].flowSegs[segIdx][0];
+		if (m_linksDown.count(std::make_pair(std::max(staIdx, neiIdx), std::min(staIdx, neiIdx)))) {
+			cliqueS[cIdx].phyRate[segIdx] = 0;
+			NS_LOG_INFO("Link between "<< staIdx << " and " << neiIdx << " is down");
+			return;
+		}
+		Mac48Address neiMacAddr = GetLinkMac(neiIdx, staIdx)->GetAddress();
+		WifiMode sta2NeiWifiMode = GetLinkMac(staIdx, neiIdx)->GetWifiRemoteStationManager()->GetObject<DmgDestinationFixedWifiManager>()->GetDestinationWifiMode(m_meshNodes->Get(neiIdx)->GetId());
 
-			//num of MPDUs = 30; hard coded tx duration in GetActualTxDurationNs();
-			//equivalent phy rate as seen from mac
-			//cliqueS[cIdx].phyRate[segIdx] = sta2NeiWifiMode.GetDataRate()/1e6;
-                        Time duration = m_meshNodes->Get(staIdx)->GetDevice(0)->GetObject<WifiNetDevice>()->GetMac()->GetObject<DmgWifiMac>()->GetNMpduReturnDuration(neiMacAddr);
+		//tx duration of m_nMpdus MPDUs from the airtime model, see GetActualTxDurationNs();
+		//equivalent phy rate as seen from mac
+		//cliqueS[cIdx].phyRate[segIdx] = sta2NeiWifiMode.GetDataRate()/1e6;
+                        Time duration = GetLinkMac(staIdx, neiIdx)->GetNMpduReturnDuration(neiMacAddr);
 
 /*                        if(duration.GetNanoSeconds())
                         {
-                                cliqueS[cIdx].phyRate[segIdx] = double(nMpdus * (appPayloadBytes + 36) * 8 )/ duration.GetNanoSeconds() *1e3 *(1.0 - biOverheadFraction);
+                                cliqueS[cIdx].phyRate[segIdx] = double(m_nMpdus * (m_appPayloadBytes + 36) * 8 )/ duration.GetNanoSeconds() *1e3 *(1.0 - m_phyRateOverheadFraction);
                                 NS_LOG_INFO("Using measured phy rate");
                         }
                         else*/
                         {
-                                NS_LOG_INFO("Using hard coded phy rate");
-                                cliqueS[cIdx].phyRate[segIdx] = double(nMpdus * (appPayloadBytes + 36) * 8 )/GetActualTxDurationNs(sta2NeiWifiMode, nMpdus)*1e3 *(1.0 - biOverheadFraction);//sta2NeiWifiMode.GetDataRate()/1e6;
+                                NS_LOG_INFO("Using modeled phy rate");
+                                cliqueS[cIdx].phyRate[segIdx] = double(m_nMpdus * (m_appPayloadBytes + 36) * 8 )/GetActualTxDurationNs(sta2NeiWifiMode, m_nMpdus)*1e3 *(1.0 - m_phyRateOverheadFraction);//sta2NeiWifiMode.GetDataRate()/1e6;
                         }
 
-			NS_LOG_INFO("Equiv phy rate between "<< staIdx << " and " << neiIdx << " is " << cliqueS[cIdx].phyRate[segIdx] << "Mb/s. wifi mode" << sta2NeiWifiMode.GetUniqueName());
-		}
-	}
+		NS_LOG_INFO("Equiv phy rate between "<< staIdx << " and " << neiIdx << " is " << cliqueS[cIdx].phyRate[segIdx] << "Mb/s. wifi mode" << sta2NeiWifiMode.GetUniqueName());
 }
 
 	std::vector <double>
@@ -1824,80 +2614,30 @@ DmgAlmightyController::FlowRateProgressiveFilling(std::vector <double> flowsDmd,
 {
 	NS_LOG_FUNCTION(this);
 
+	m_flowsDmd = flowsDmd;
+	m_fillingSteplength = fillingSteplength;
 	ConfigurePhyRate(appPayloadBytes, biOverheadFraction, nMpdus);
 
-	std::vector <bool> ifActive (flowsDmd.size(), true);
-	std::vector <double> flowsRate (flowsDmd.size(), 0.0);
-	//Initiate
-	uint32_t nActive = flowsDmd.size();
-
-	//Fill
-	while (nActive!=0){
-		//for each active flow, increase the rate and check if demand is met
-		for (uint32_t fIdx = 0; fIdx < flowsDmd.size(); fIdx++){
-			if (ifActive[fIdx]){
-				// increase the rate
-				flowsRate[fIdx] = flowsRate[fIdx]+fillingSteplength;
-				// if demand is met, turn status to inactive
-				if(flowsRate[fIdx] >= flowsDmd[fIdx]){
-					ifActive[fIdx] = false;
-					flowsRate[fIdx] = flowsDmd[fIdx];
-					NS_LOG_INFO("Flow "<< fIdx <<" is satisfied");
-				}
-			}
-		}
+	std::vector <DmgOptimizationSolver::Clique> cliques (cliqueS.size());
+	for (uint32_t cIdx = 0; cIdx< cliqueS.size(); cIdx++){
+		cliques[cIdx].flows = cliqueS[cIdx].flows;
+		cliques[cIdx].capacity = cliqueS[cIdx].phyRate;
+	}
 
-		//for each clique
-		for (uint32_t cIdx = 0; cIdx< cliqueS.size(); cIdx++){
-			double timeSum = 0.0;
-			//calculate time fraction on each link segment: time fraction = flowrate / capacity
-			for (uint32_t segIdx = 0; segIdx < cliqueS[cIdx].flows.size(); segIdx++){
-				cliqueS[cIdx].timeAlloc[segIdx] = flowsRate[cliqueS[cIdx].flows[segIdx]]/cliqueS[cIdx].phyRate[segIdx];
-				timeSum += cliqueS[cIdx].timeAlloc[segIdx];
-			}
+	Ptr<DmgOptimizationSolver> solver = m_solverFactory.Create<DmgOptimizationSolver> ();
+	NS_ASSERT_MSG (solver != 0, "OptimizationSolver is not a DmgOptimizationSolver");
+	solver->SetAttributeFailSafe ("StepLength", DoubleValue (fillingSteplength));
+	std::vector <double> flowsRate = solver->Solve (flowsDmd, cliques);
+	m_lastSolveTimeMs = solver->GetLastSolveTimeMs ();
+	NS_LOG_INFO("Flow rates computed by "<< m_solverFactory.GetTypeId().GetName() << " in " << m_lastSolveTimeMs << "ms");
+	m_flowsRate = flowsRate;
 
-			//check if time is used up
-			if (timeSum >= 1.0){
-				//NS_LOG_INFO("Time in clique "<< cIdx <<" is fully used");
-				//rate and time of activeflows needed to be reallocate,
-				double timeLeft = 1.0;
-				double sum = 0.0;// sum = sum (1/capacities)
-				//Calculated rate to be allocated
-				//1. time left by inactive flows
-				for (uint32_t segIdx = 0; segIdx < cliqueS[cIdx].flows.size(); segIdx++){
-					if (ifActive[cliqueS[cIdx].flows[segIdx]] == false) {
-						timeLeft = timeLeft - cliqueS[cIdx].timeAlloc[segIdx];
-						//flowsRate[cliqueS[cIdx].flows[segIdx]]/cliqueS[cIdx].phyRate[segIdx];//
-					}
-					else sum = sum + 1.0/(cliqueS[cIdx].phyRate[segIdx]);  //sum of (1/capacity)
-				}
-				//2. new rate = timeleft/sum(1/capacities)
-				//NS_LOG_INFO("newRate "<< timeLeft/sum);
-				double newRate = std::floor(timeLeft/sum * 10000.0)/10000.0;
-				//NS_LOG_INFO("newRate "<< newRate);
-				//Reallocate for active (soon to be inactive) flows same rate
-				for (uint32_t segIdx = 0; segIdx < cliqueS[cIdx].flows.size(); segIdx++){
-					if (ifActive[cliqueS[cIdx].flows[segIdx]] == true) {
-						flowsRate[cliqueS[cIdx].flows[segIdx]] = newRate;
-						cliqueS[cIdx].timeAlloc[segIdx] = newRate / (cliqueS[cIdx].phyRate[segIdx]);
-						ifActive[cliqueS[cIdx].flows[segIdx]] = false;
-					}
-				}
-			}
-		}
-		//Re-compute the number of active flows
-		nActive = 0;
-		for (uint32_t fIdx = 0; fIdx< flowsDmd.size(); fIdx++){
-			if(ifActive[fIdx] == true)
-				nActive++;
-		}
-	}//end while;
+	ParallelFor(cliqueS.size(), MakeCallback(&DmgAlmightyController::ComputeTimeAlloc, this));
 
 	//double check time
 	for (uint32_t cIdx = 0; cIdx< cliqueS.size(); cIdx++){
 		double timeSum = 0.0;
 		for (uint32_t segIdx = 0; segIdx < cliqueS[cIdx].flows.size(); segIdx++){
-			cliqueS[cIdx].timeAlloc[segIdx] = flowsRate[cliqueS[cIdx].flows[segIdx]]/cliqueS[cIdx].phyRate[segIdx];
 			timeSum += cliqueS[cIdx].timeAlloc[segIdx];
 			NS_LOG_INFO("Flow "<< cliqueS[cIdx].flows[segIdx]<< " between " << cliqueS[cIdx].flowSegs[segIdx][0] <<" and " << cliqueS[cIdx].flowSegs[segIdx][1] <<" is allocated time "<< cliqueS[cIdx].timeAlloc[segIdx]);
 		}
@@ -1914,6 +2654,374 @@ DmgAlmightyController::FlowRateProgressiveFilling(std::vector <double> flowsDmd,
 	return flowsRate;
 }
 
+	int64_t
+DmgAlmightyController::GetLastSolveTimeMs (void)
+{
+	return m_lastSolveTimeMs;
+}
+
+	void
+DmgAlmightyController::BuildRoutePlanner (uint32_t appPayloadBytes, uint32_t nMpdus)
+{
+	NS_LOG_FUNCTION(this);
+	m_routePlanner.Clear();
+	BuildRadioCache();
+	ConfigureAirtimeModel();
+	uint32_t nodesN = m_meshNodes->GetN();
+	m_routePlanner.SetNNodes(nodesN);
+
+	//No link is possible beyond the distance where the slowest MCS is lost
+	double minRxPower = std::numeric_limits<double>::infinity();
+	for (uint32_t nodeIdx = 0; nodeIdx < nodesN; nodeIdx++){
+		const DmgMcsTable &table = GetMcsTable(m_radio[nodeIdx].phy);
+		if (table.GetNModes() > 0)
+			minRxPower = std::min(minRxPower, table.GetThresholdDb(0) + table.GetNoiseFloorDbm());
+	}
+	double range = minRxPower < std::numeric_limits<double>::infinity() ? GetFriisRange(minRxPower) : 0;
+	NS_LOG_INFO("Link range " << range << "m (0: unbounded)");
+
+	uint32_t msduBytes = appPayloadBytes + 36;
+	for (uint32_t a = 0; a < nodesN; a++){
+		std::vector<uint32_t> candidates = GetNodesInRange(a, range);
+		for (uint32_t i = 0; i < candidates.size(); i++){
+			uint32_t b = candidates[i];
+			if (b <= a || m_linksDown.count(std::make_pair(b, a)))
+				continue;
+			//the ideal MCS assumes LoS, as ConfigureAntennaAlignment does for the links
+			Ptr<FriisLoSPropagationLossModel> friisLoS = m_radio[a].phy->GetChannel()->GetObject<YansWifiChannel>()->
+				GetPropagationLossModel()->GetObject<FriisLoSPropagationLossModel>();
+			if (friisLoS != 0){
+				friisLoS->SetLoS(m_radio[a].mobility, m_radio[b].mobility, true);
+				friisLoS->SetLoS(m_radio[b].mobility, m_radio[a].mobility, true);
+			}
+			WifiMode modeAb = GetWifiMode(GetIdealRxPower(m_meshNodes->Get(a), m_meshNodes->Get(b)), m_radio[b].phy);
+			WifiMode modeBa = GetWifiMode(GetIdealRxPower(m_meshNodes->Get(b), m_meshNodes->Get(a)), m_radio[a].phy);
+			if (GetMcsTable(m_radio[b].phy).FindMode(modeAb) < 0 || GetMcsTable(m_radio[a].phy).FindMode(modeBa) < 0)
+				continue;
+			//airtime of a bit (ns) in the exchanges of nMpdus MPDUs
+			double bits = double(nMpdus * msduBytes * 8);
+			double airtimeAb = m_airtimeModel.GetExchangeDuration(modeAb, nMpdus, msduBytes).GetNanoSeconds() / bits;
+			double airtimeBa = m_airtimeModel.GetExchangeDuration(modeBa, nMpdus, msduBytes).GetNanoSeconds() / bits;
+			m_routePlanner.AddLink(a, b, airtimeAb, airtimeBa);
+		}
+	}
+	std::vector <uint32_t> gws = GetGws();
+	for (uint32_t g = 0; g < gws.size(); g++)
+		m_routePlanner.AddGateway(gws[g]);
+	m_routeAppPayloadBytes = appPayloadBytes;
+	m_routeNMpdus = nMpdus;
+	NS_LOG_INFO("Route planner: " << nodesN << " nodes, " << m_routePlanner.GetNLinks() << " links");
+	//restore the LoS of the configured links
+	if (!m_linkList.empty())
+		ConfigureAntennaAlignment();
+}
+
+	std::vector < std::vector <uint32_t> >
+DmgAlmightyController::ComputeFlowsPath (std::vector <uint32_t> sinks, std::vector <double> flowsDmd,
+		DmgRoutePlanner::Metric metric, uint32_t appPayloadBytes, uint32_t nMpdus)
+{
+	NS_LOG_FUNCTION(this << metric);
+	if (m_routePlanner.GetNNodes() != m_meshNodes->GetN() || appPayloadBytes != m_routeAppPayloadBytes || nMpdus != m_routeNMpdus)
+		BuildRoutePlanner(appPayloadBytes, nMpdus);
+
+	if (!m_routePlanner.Route(metric, sinks, flowsDmd))
+	{
+		for (uint32_t fIdx = 0; fIdx < sinks.size(); fIdx++)
+		{
+			if (m_routePlanner.GetPath(fIdx).empty())
+				NS_FATAL_ERROR("Flow " << fIdx << ": node " << sinks[fIdx] << " cannot be reached from a gateway");
+		}
+	}
+	std::vector < std::vector <uint32_t> > paths (sinks.size());
+	for (uint32_t fIdx = 0; fIdx < sinks.size(); fIdx++)
+	{
+		paths[fIdx] = m_routePlanner.GetPath(fIdx);
+		std::ostringstream path;
+		for (uint32_t i = 0; i < paths[fIdx].size(); i++)
+			path << " " << paths[fIdx][i];
+		NS_LOG_INFO("Flow " << fIdx << " path:" << path.str());
+	}
+	NS_LOG_INFO("Max node load " << m_routePlanner.GetMaxNodeLoad());
+	return paths;
+}
+
+	std::vector <double>
+DmgAlmightyController::SelectFlowsPath (std::vector <uint32_t> sinks, std::vector <double> flowsDmd, double fillingSteplength,
+		uint32_t appPayloadBytes, double biOverheadFraction, uint32_t nMpdus)
+{
+	NS_LOG_FUNCTION(this);
+	const DmgRoutePlanner::Metric metrics[] = {DmgRoutePlanner::MIN_AIRTIME, DmgRoutePlanner::WIDEST_PATH, DmgRoutePlanner::CLIQUE_LOAD};
+	std::vector < std::vector <uint32_t> > bestPaths;
+	uint64_t bestOverflow = std::numeric_limits<uint64_t>::max();
+	double bestMin = -1;
+	double bestSum = -1;
+	for (uint32_t m = 0; m < sizeof (metrics) / sizeof (metrics[0]); m++)
+	{
+		std::vector < std::vector <uint32_t> > paths = ComputeFlowsPath(sinks, flowsDmd, metrics[m], appPayloadBytes, nMpdus);
+		SetFlowsPath(paths);
+		ConfigureCliques();
+		ConfigureHierarchy();
+		ConfigureWifiManager();
+		std::vector <double> rates = FlowRateProgressiveFilling(flowsDmd, fillingSteplength, appPayloadBytes, biOverheadFraction, nMpdus);
+		double minRate = rates.empty() ? 0 : *std::min_element(rates.begin(), rates.end());
+		double sumRate = std::accumulate(rates.begin(), rates.end(), 0.0);
+		//the rates are only reachable if the SPs of the cliques fit in the schedule
+		m_scheduleTrial = true;
+		if (m_nChannels > 1)
+			ConfigureScheduleInLayers();
+		else if (m_sim_interference)
+			ConfigureScheduleWithInterfAvoidance();
+		else
+			ConfigureSchedule();
+		m_scheduleTrial = false;
+		NS_LOG_INFO("Routing " << m << ": min flow rate " << minRate << "Mb/s, total " << sumRate << "Mb/s, "
+				<< m_scheduleOverflowNs << "ns not scheduled");
+		if (m_scheduleOverflowNs < bestOverflow
+				|| (m_scheduleOverflowNs == bestOverflow && (minRate > bestMin || (minRate == bestMin && sumRate > bestSum))))
+		{
+			bestOverflow = m_scheduleOverflowNs;
+			bestMin = minRate;
+			bestSum = sumRate;
+			bestPaths = paths;
+		}
+	}
+	if (bestOverflow > 0)
+		NS_LOG_WARN("No routing fits in the schedule");
+	if (bestPaths != m_flowsPath)
+	{
+		SetFlowsPath(bestPaths);
+		ConfigureCliques();
+		ConfigureHierarchy();
+		ConfigureWifiManager();
+		FlowRateProgressiveFilling(flowsDmd, fillingSteplength, appPayloadBytes, biOverheadFraction, nMpdus);
+	}
+	return m_flowsRate;
+}
+
+	std::vector <double>
+DmgAlmightyController::UpdateFlowDemand (std::vector <double> flowsDmd)
+{
+	NS_LOG_FUNCTION(this);
+	NS_ASSERT_MSG (flowsDmd.size() == m_flowsDmd.size(), "UpdateFlowDemand called before FlowRateProgressiveFilling");
+
+	std::vector <uint32_t> changedFlows;
+	for (uint32_t fIdx = 0; fIdx < flowsDmd.size(); fIdx++){
+		if (flowsDmd[fIdx] != m_flowsDmd[fIdx]){
+			changedFlows.push_back(fIdx);
+		}
+	}
+	m_flowsDmd = flowsDmd;
+	ReplanFlows(changedFlows);
+	return m_flowsRate;
+}
+
+	std::vector <double>
+DmgAlmightyController::NotifyLinkChange (uint32_t node1, uint32_t node2, bool up)
+{
+	NS_LOG_FUNCTION(this << node1 << node2 << up);
+	std::pair <uint32_t, uint32_t> link (std::max(node1, node2), std::min(node1, node2));
+	if (up)
+		m_linksDown.erase(link);
+	else
+		m_linksDown.insert(link);
+	m_routePlanner.Clear();
+
+	BuildReplanIndex();
+	std::vector <uint32_t> changedFlows;
+	for (uint32_t cIdx = 0; cIdx < cliqueS.size(); cIdx++){
+		for (uint32_t segIdx = 0; segIdx < cliqueS[cIdx].flowSegs.size(); segIdx++){
+			uint32_t a = cliqueS[cIdx].flowSegs[segIdx][0];
+			uint32_t b = cliqueS[cIdx].flowSegs[segIdx][1];
+			if (std::max(a, b) == link.first && std::min(a, b) == link.second){
+				ConfigureSegPhyRate(cIdx, segIdx);
+				changedFlows.push_back(cliqueS[cIdx].flows[segIdx]);
+			}
+		}
+	}
+	ReplanFlows(changedFlows);
+	return m_flowsRate;
+}
+
+	void
+DmgAlmightyController::BuildReplanIndex (void)
+{
+	if (m_replanIndexValid)
+		return;
+
+	m_flowCliques.assign(m_flowsPath.size(), std::vector <uint32_t> ());
+	for (uint32_t cIdx = 0; cIdx < cliqueS.size(); cIdx++){
+		for (uint32_t segIdx = 0; segIdx < cliqueS[cIdx].flows.size(); segIdx++){
+			std::vector <uint32_t> &cliques = m_flowCliques.at(cliqueS[cIdx].flows[segIdx]);
+			if (cliques.empty() || cliques.back() != cIdx)
+				cliques.push_back(cIdx);
+		}
+	}
+
+	// Same lookups as ScheduleClique and ScheduleCliqueWithInterfAvoidance
+	m_scheduleDeps.assign(cliqueS.size(), std::vector <uint32_t> ());
+	for (uint32_t i = 0; i < m_schedulingOrder.size(); i++){
+		uint32_t cIdx = m_schedulingOrder.at(i);
+		std::vector <uint32_t> &deps = m_scheduleDeps.at(cIdx);
+		if (!IsRootConflictNode(cliqueS[cIdx].staMem.back()))
+			deps.push_back(GetMasterCliqueId(cliqueS[cIdx].staMem.back()));
+		if (!m_scheduleWithInterfAvoidance)
+			continue;
+		for (uint32_t segIdx = 0; segIdx < cliqueS[cIdx].flowSegs.size(); segIdx++){
+			for (uint32_t cItf = m_interfCliqueStart; cItf < cliqueS.size(); cItf++){
+				std::vector <uint32_t> segIdInClq = GetSegIndicesInClique(cliqueS[cIdx].flowSegs[segIdx], cliqueS[cItf].flowSegs);
+				if (segIdInClq.empty())
+					continue;
+				for (uint32_t otherSeg = 0; otherSeg < cliqueS[cItf].flowSegs.size(); otherSeg++){
+					if (std::find(segIdInClq.begin(), segIdInClq.end(), otherSeg) != segIdInClq.end())
+						continue;
+					for (uint32_t cClassic = 0; cClassic < m_interfCliqueStart; cClassic++){
+						if (cClassic != cIdx && !GetSegIndicesInClique(cliqueS[cItf].flowSegs[otherSeg], cliqueS[cClassic].flowSegs).empty()
+								&& std::find(deps.begin(), deps.end(), cClassic) == deps.end())
+							deps.push_back(cClassic);
+					}
+				}
+			}
+		}
+	}
+	m_replanIndexValid = true;
+}
+
+	void
+DmgAlmightyController::ReplanFlows (std::vector <uint32_t> changedFlows)
+{
+	NS_LOG_FUNCTION(this << changedFlows.size());
+	if (changedFlows.empty())
+		return;
+	BuildReplanIndex();
+
+	// Flows sharing a clique with a changed flow, transitively: the rates of
+	// the other flows cannot change.
+	std::vector <bool> flowIn (m_flowsPath.size(), false);
+	std::vector <bool> cliqueIn (cliqueS.size(), false);
+	std::vector <uint32_t> flows;
+	std::vector <uint32_t> cliques;
+	for (uint32_t i = 0; i < changedFlows.size(); i++){
+		if (!flowIn.at(changedFlows[i])){
+			flowIn.at(changedFlows[i]) = true;
+			flows.push_back(changedFlows[i]);
+		}
+	}
+	for (uint32_t i = 0; i < flows.size(); i++){
+		std::vector <uint32_t> &flowCliques = m_flowCliques.at(flows[i]);
+		for (uint32_t j = 0; j < flowCliques.size(); j++){
+			uint32_t cIdx = flowCliques[j];
+			if (cliqueIn.at(cIdx))
+				continue;
+			cliqueIn.at(cIdx) = true;
+			cliques.push_back(cIdx);
+			for (uint32_t segIdx = 0; segIdx < cliqueS[cIdx].flows.size(); segIdx++){
+				if (!flowIn.at(cliqueS[cIdx].flows[segIdx])){
+					flowIn.at(cliqueS[cIdx].flows[segIdx]) = true;
+					flows.push_back(cliqueS[cIdx].flows[segIdx]);
+				}
+			}
+		}
+	}
+	// The solver depends on the order of the flows and cliques: keep the one
+	// of the full problem, so that the rates match FlowRateProgressiveFilling
+	std::sort(flows.begin(), flows.end());
+	std::sort(cliques.begin(), cliques.end());
+
+	// Solve the rate allocation of these flows only
+	std::vector <uint32_t> localFlow (m_flowsPath.size(), 0);
+	std::vector <double> flowsDmd (flows.size());
+	for (uint32_t i = 0; i < flows.size(); i++){
+		localFlow.at(flows[i]) = i;
+		flowsDmd[i] = m_flowsDmd.at(flows[i]);
+	}
+	std::vector <DmgOptimizationSolver::Clique> problem (cliques.size());
+	for (uint32_t i = 0; i < cliques.size(); i++){
+		for (uint32_t segIdx = 0; segIdx < cliqueS[cliques[i]].flows.size(); segIdx++){
+			problem[i].flows.push_back(localFlow.at(cliqueS[cliques[i]].flows[segIdx]));
+		}
+		problem[i].capacity = cliqueS[cliques[i]].phyRate;
+	}
+	Ptr<DmgOptimizationSolver> solver = m_solverFactory.Create<DmgOptimizationSolver> ();
+	solver->SetAttributeFailSafe ("StepLength", DoubleValue (m_fillingSteplength));
+	std::vector <double> flowsRate = solver->Solve (flowsDmd, problem);
+	m_lastSolveTimeMs = solver->GetLastSolveTimeMs ();
+	for (uint32_t i = 0; i < flows.size(); i++){
+		m_flowsRate.at(flows[i]) = flowsRate[i];
+	}
+
+	std::vector <bool> timeChanged (cliqueS.size(), false);
+	for (uint32_t i = 0; i < cliques.size(); i++){
+		uint32_t cIdx = cliques[i];
+		for (uint32_t segIdx = 0; segIdx < cliqueS[cIdx].flows.size(); segIdx++){
+			float timeAlloc = (cliqueS[cIdx].phyRate[segIdx] > 0)?(m_flowsRate.at(cliqueS[cIdx].flows[segIdx])/cliqueS[cIdx].phyRate[segIdx]):(0);
+			if (timeAlloc != cliqueS[cIdx].timeAlloc[segIdx]){
+				cliqueS[cIdx].timeAlloc[segIdx] = timeAlloc;
+				timeChanged.at(cIdx) = true;
+			}
+		}
+	}
+
+	// Re-schedule, in the scheduling order, the cliques whose time allocation
+	// changed or that depend on a clique whose SPs changed
+	std::vector <bool> spChanged (cliqueS.size(), false);
+	std::vector <bool> scheduled (cliqueS.size(), false);
+	uint32_t rescheduledN = 0;
+	if (m_scheduleInLayers && std::find(timeChanged.begin(), timeChanged.end(), true) != timeChanged.end()){
+		// The layers are packed over the whole network
+		std::vector <cliqueStruct> previous = cliqueS;
+		ScheduleLayers();
+		for (uint32_t cIdx = 0; cIdx < cliqueS.size(); cIdx++){
+			spChanged.at(cIdx) = (previous[cIdx].bufStart != cliqueS[cIdx].bufStart) || (previous[cIdx].bufDurNs != cliqueS[cIdx].bufDurNs)
+				|| (previous[cIdx].bufLayer != cliqueS[cIdx].bufLayer);
+		}
+		rescheduledN = m_schedulingOrder.size();
+	}
+	for (uint32_t i = 0; i < m_schedulingOrder.size() && !m_scheduleInLayers; i++){
+		uint32_t cIdx = m_schedulingOrder.at(i);
+		bool reschedule = timeChanged.at(cIdx);
+		for (uint32_t d = 0; !reschedule && d < m_scheduleDeps.at(cIdx).size(); d++){
+			reschedule = spChanged.at(m_scheduleDeps.at(cIdx).at(d));
+		}
+		if (reschedule){
+			std::vector < std::vector < uint64_t > > bufStart = cliqueS[cIdx].bufStart;
+			std::vector < std::vector < uint64_t > > bufDurNs = cliqueS[cIdx].bufDurNs;
+			if (m_scheduleWithInterfAvoidance)
+				ScheduleCliqueWithInterfAvoidance(cIdx, scheduled);
+			else
+				ScheduleClique(cIdx);
+			spChanged.at(cIdx) = (bufStart != cliqueS[cIdx].bufStart) || (bufDurNs != cliqueS[cIdx].bufDurNs);
+			rescheduledN++;
+		}
+		scheduled.at(cIdx) = true;
+	}
+
+	// Push the new SPs to the members of the cliques whose SPs changed
+	std::vector <bool> nodes (m_meshNodes->GetN(), false);
+	for (uint32_t cIdx = 0; cIdx < cliqueS.size(); cIdx++){
+		if (!spChanged.at(cIdx))
+			continue;
+		for (uint32_t i = 0; i < cliqueS[cIdx].staMem.size(); i++){
+			nodes.at(cliqueS[cIdx].staMem[i]) = true;
+		}
+	}
+	std::vector < std::vector < std::vector < Ptr<DmgServicePeriod> > > > sps = BuildServicePeriods(nodes);
+	uint32_t updatedN = 0;
+	for (uint32_t staIdx = 0; staIdx < m_meshNodes->GetN(); staIdx++){
+		if (!nodes.at(staIdx))
+			continue;
+		std::vector < Ptr<DmgWifiMac> > macs = GetNodeMacs(staIdx);
+		bool updated = false;
+		for (uint32_t devIdx = 0; devIdx < macs.size(); devIdx++){
+			if (macs[devIdx] != 0 && macs[devIdx]->GetDmgBeaconInterval()->ScheduleSpUpdate(sps.at(staIdx).at(devIdx)))
+				updated = true;
+		}
+		if (updated)
+			updatedN++;
+	}
+	NS_LOG_INFO("Re-planned " << flows.size() << " flows, " << cliques.size() << " cliques; re-scheduled "
+			<< rescheduledN << " cliques; " << updatedN << " nodes get new SPs at the next BI");
+}
+
 	void
 DmgAlmightyController::AssignEqualAirTime(void)
 {
@@ -1956,8 +3064,8 @@ DmgAlmightyController::FlowRateMaxDlmac(uint32_t payloadBytes, double biOverhead
 
 			if(i != 0){
 				uint32_t prevIdx = m_flowsPath[flowIdx][i-1];
-				Mac48Address staMacAddr = m_meshNodes->Get(staIdx)->GetDevice(0)->GetObject<WifiNetDevice>()->GetMac()->GetObject<DmgWifiMac>()->GetAddress();
-				WifiMode prev2staWifiMode = m_meshNodes->Get(prevIdx)->GetDevice(0)->GetObject<WifiNetDevice>()->GetMac()->GetObject<DmgWifiMac>()-> GetWifiRemoteStationManager()->GetObject<DmgDestinationFixedWifiManager>()->GetDestinationWifiMode(staMacAddr);
+				Mac48Address staMacAddr = GetLinkMac(staIdx, prevIdx)->GetAddress();
+				WifiMode prev2staWifiMode = GetLinkMac(prevIdx, staIdx)->GetWifiRemoteStationManager()->GetObject<DmgDestinationFixedWifiManager>()->GetDestinationWifiMode(staMacAddr);
 
 				double phyRateIn = prev2staWifiMode.GetDataRate()/1e6;
 				staScheduleLenNs.at(staIdx) += std::ceil(payloadBytes *8 *(1.0/phyRateIn) *1e3) + overheadTimeEachPayloadNs;
@@ -1965,8 +3073,8 @@ DmgAlmightyController::FlowRateMaxDlmac(uint32_t payloadBytes, double biOverhead
 			}
 
 
-			Mac48Address nextMacAddr = m_meshNodes->Get(nextIdx)->GetDevice(0)->GetObject<WifiNetDevice>()->GetMac()->GetObject<DmgWifiMac>()->GetAddress();
-			WifiMode sta2nextWifiMode = m_meshNodes->Get(staIdx)->GetDevice(0)->GetObject<WifiNetDevice>()->GetMac()->GetObject<DmgWifiMac>()-> GetWifiRemoteStationManager()->GetObject<DmgDestinationFixedWifiManager>()->GetDestinationWifiMode(nextMacAddr);
+			Mac48Address nextMacAddr = GetLinkMac(nextIdx, staIdx)->GetAddress();
+			WifiMode sta2nextWifiMode = GetLinkMac(staIdx, nextIdx)->GetWifiRemoteStationManager()->GetObject<DmgDestinationFixedWifiManager>()->GetDestinationWifiMode(nextMacAddr);
 
 			double phyRateOut = sta2nextWifiMode.GetDataRate()/1e6;
 			staScheduleLenNs.at(staIdx) += std::ceil(payloadBytes *8 *(1.0/phyRateOut) *1e3) + overheadTimeEachPayloadNs;
@@ -2010,17 +3118,13 @@ DmgAlmightyController::CreateBlockAckAgreement(void)
 	for (uint32_t flowIdx = 0; flowIdx < m_flowsPath.size(); flowIdx++) {
 		for(uint32_t i = 0; i < m_flowsPath[flowIdx].size() - 1; i++){
 
-			Ptr<DmgWifiMac> staMac =
-				m_meshNodes->Get(m_flowsPath[flowIdx][i])->GetDevice(0)->GetObject<WifiNetDevice>()->
-				GetMac()->GetObject<DmgWifiMac>();
+			Ptr<DmgWifiMac> staMac = GetLinkMac(m_flowsPath[flowIdx][i], m_flowsPath[flowIdx][i+1]);
 
 			PointerValue ptrStaEdca;
 			staMac->GetAttribute ("BE_EdcaTxopN", ptrStaEdca);
 			Ptr<EdcaTxopN> staEdca = ptrStaEdca.Get<EdcaTxopN> ();
 
-			Ptr<DmgWifiMac> nextHopMac =
-				m_meshNodes->Get(m_flowsPath[flowIdx][i+1])->GetDevice(0)->GetObject<WifiNetDevice>()->
-				GetMac()->GetObject<DmgWifiMac>();
+			Ptr<DmgWifiMac> nextHopMac = GetLinkMac(m_flowsPath[flowIdx][i+1], m_flowsPath[flowIdx][i]);
 
 			PointerValue ptrNextHopEdca;
 			nextHopMac->GetAttribute ("BE_EdcaTxopN", ptrNextHopEdca);
@@ -2042,14 +3146,12 @@ DmgAlmightyController::PrintIdealRxPowerAndMcs(void)
 		for (uint32_t neighIdx= 0; neighIdx< m_neighbourNodes[staIdx].size(); neighIdx++){
 			uint32_t neighId = m_neighbourNodes[staIdx][neighIdx];
 
-			Ptr<DmgWifiMac> neiMac =
-				m_meshNodes->Get(neighId)->GetDevice(0)->GetObject<WifiNetDevice>()->
-				GetMac()->GetObject<DmgWifiMac>();
+			Ptr<DmgWifiMac> neiMac = GetLinkMac(neighId, staIdx);
 
 			double neiRxPower = GetIdealRxPower(m_meshNodes->Get(staIdx), m_meshNodes->Get(neighId));
 			double staRxPower = GetIdealRxPower(m_meshNodes->Get(neighId), m_meshNodes->Get(staIdx));
 
-			WifiMode staWifiMode = m_meshNodes->Get(staIdx)->GetDevice(0)->GetObject<WifiNetDevice>()->GetMac()->GetObject<DmgWifiMac>()-> GetWifiRemoteStationManager()->GetObject<DmgDestinationFixedWifiManager>()->GetDestinationWifiMode(neiMac->GetAddress());
+			WifiMode staWifiMode = GetLinkMac(staIdx, neighId)->GetWifiRemoteStationManager()->GetObject<DmgDestinationFixedWifiManager>()->GetDestinationWifiMode(neiMac->GetAddress());
 
 			NS_LOG_INFO( "Mesh node " << staIdx << " to node " << neighId <<": rx power "
 					<< neiRxPower << "dBi; " << staWifiMode.GetUniqueName() <<". rate " << staWifiMode.GetDataRate()/1000000 << "Mbps" );
@@ -2081,14 +3183,12 @@ DmgAlmightyController::PrintIdealRxPowerAndMcs(void)
 				continue;
 			}
 
-			Ptr<DmgWifiMac> neiMac =
-				m_meshNodes->Get(neighId)->GetDevice(0)->GetObject<WifiNetDevice>()->
-				GetMac()->GetObject<DmgWifiMac>();
+			Ptr<DmgWifiMac> neiMac = GetLinkMac(neighId, staIdx);
 
 			double neiRxPower = GetIdealRxPower(m_meshNodes->Get(staIdx), m_meshNodes->Get(neighId));
 			double staRxPower = GetIdealRxPower(m_meshNodes->Get(neighId), m_meshNodes->Get(staIdx));
 
-			WifiMode staWifiMode = m_meshNodes->Get(staIdx)->GetDevice(0)->GetObject<WifiNetDevice>()->GetMac()->GetObject<DmgWifiMac>()-> GetWifiRemoteStationManager()->GetObject<DmgDestinationFixedWifiManager>()->GetDestinationWifiMode(neiMac->GetAddress());
+			WifiMode staWifiMode = GetLinkMac(staIdx, neighId)->GetWifiRemoteStationManager()->GetObject<DmgDestinationFixedWifiManager>()->GetDestinationWifiMode(neiMac->GetAddress());
 
 			*stream->GetStream() << staWifiMode.GetDataRate() <<"\t";                        
 
@@ -2110,23 +3210,27 @@ DmgAlmightyController::PrintSpInfo(void)
         NS_LOG_INFO("SP info printed to file " << timeFileName_oss.str());
         Ptr<OutputStreamWrapper> stream = ascii.CreateFileStream (timeFileName_oss.str());
 
+	std::map <Mac48Address, uint32_t> macNodes;
+	for (uint32_t i = 0; i < m_meshNodes->GetN(); i++){
+		std::vector < Ptr<DmgWifiMac> > macs = GetNodeMacs(i);
+		for (uint32_t devIdx = 0; devIdx < macs.size(); devIdx++){
+			if (macs[devIdx] != 0)
+				macNodes[macs[devIdx]->GetAddress()] = i;
+		}
+	}
 	for (uint32_t staIdx = 0; staIdx < m_meshNodes->GetN(); staIdx++) {
-		Ptr<DmgBeaconInterval> dmgBiSta = m_meshNodes->Get(staIdx)->GetDevice(0)->
-			GetObject<WifiNetDevice>()->GetMac()->GetObject<DmgWifiMac>()->GetDmgBeaconInterval();
-		uint32_t destinationId;
-		//Print sp info
-		*stream->GetStream() << "STA "<< staIdx<< " (SP size "<< dmgBiSta->GetSps().size()<<")" << std::endl;
-		for (uint32_t spIdx = 0; spIdx < dmgBiSta->GetSps().size(); spIdx++) {
-			for (uint32_t i = 0; i < m_meshNodes->GetN(); i++){
-				Mac48Address macAdd = m_meshNodes->Get(i)->GetDevice(0)->
-					GetObject<WifiNetDevice>()->GetMac()->GetObject<DmgWifiMac>()->
-					GetAddress();
-				if (macAdd == dmgBiSta->GetSps().at(spIdx)->GetSpDestination()){
-					destinationId = i;
-				}
-			}
+		std::vector < Ptr<DmgWifiMac> > macs = GetNodeMacs(staIdx);
+		for (uint32_t devIdx = 0; devIdx < macs.size(); devIdx++) {
+			if (macs[devIdx] == 0)
+				continue;
+			Ptr<DmgBeaconInterval> dmgBiSta = macs[devIdx]->GetDmgBeaconInterval();
+			//Print sp info
+			*stream->GetStream() << "STA "<< staIdx<< " (SP size "<< dmgBiSta->GetSps().size()<<")" << std::endl;
+			for (uint32_t spIdx = 0; spIdx < dmgBiSta->GetSps().size(); spIdx++) {
+				uint32_t destinationId = macNodes[dmgBiSta->GetSps().at(spIdx)->GetSpDestination()];
 
-        		*stream->GetStream() << staIdx<< " peer "<< destinationId <<" from " << dmgBiSta->GetSps().at(spIdx)->GetSpStart()<< " to " << dmgBiSta->GetSps().at(spIdx)->GetSpStop() << " Tx? "<< dmgBiSta->GetSps().at(spIdx)->GetSpIfTx() << " final dest to "<< dmgBiSta->GetSps().at(spIdx)->GetSpFlowSourceSinkIpv4Address().second << std::endl;        
+				*stream->GetStream() << staIdx<< " peer "<< destinationId <<" from " << dmgBiSta->GetSps().at(spIdx)->GetSpStart()<< " to " << dmgBiSta->GetSps().at(spIdx)->GetSpStop() << " Tx? "<< dmgBiSta->GetSps().at(spIdx)->GetSpIfTx() << " final dest to "<< dmgBiSta->GetSps().at(spIdx)->GetSpFlowSourceSinkIpv4Address().second << std::endl;
+			}
 		}
 	}
 }
@@ -2137,8 +3241,8 @@ DmgAlmightyController::StartMacEnqueueRateMeasurement (void)
 { 
 	NS_LOG_FUNCTION(this);
 	for (uint32_t flowIdx = 0; flowIdx < m_flowsPath.size(); flowIdx++) {
-		Ipv4Address ipSink = m_meshNodes->Get(m_flowsPath.at(flowIdx).back())->GetObject<Ipv4>()->GetAddress(1,0).GetLocal();
-		m_meshNodes->Get(m_flowsPath.at(flowIdx).front())->GetDevice(0)->GetObject<WifiNetDevice>()->GetMac()->GetObject<DmgWifiMac> ()->InstallEnqueueRateMeter (ipSink);
+		Ipv4Address ipSink = GetFlowSinkAddress(flowIdx);
+		GetLinkMac(m_flowsPath[flowIdx][0], m_flowsPath[flowIdx][1])->InstallEnqueueRateMeter (ipSink);
 	}
 }
 
@@ -2146,8 +3250,8 @@ DmgAlmightyController::StartMacEnqueueRateMeasurement (void)
 DmgAlmightyController::RestartMacEnqueueRateMeasurement (void)
 { 
 	for (uint32_t flowIdx = 0; flowIdx < m_flowsPath.size(); flowIdx++) {
-		Ipv4Address ipSink = m_meshNodes->Get(m_flowsPath.at(flowIdx).back())->GetObject<Ipv4>()->GetAddress(1,0).GetLocal();
-		m_meshNodes->Get(m_flowsPath.at(flowIdx).front())->GetDevice(0)->GetObject<WifiNetDevice>()->GetMac()->GetObject<DmgWifiMac> ()->ResetEnqueueRateMeter (ipSink);
+		Ipv4Address ipSink = GetFlowSinkAddress(flowIdx);
+		GetLinkMac(m_flowsPath[flowIdx][0], m_flowsPath[flowIdx][1])->ResetEnqueueRateMeter (ipSink);
 	}
 }
 
@@ -2157,8 +3261,8 @@ DmgAlmightyController::GetMacEnqueueRateMeasurement (void)
 {
 	m_flowDemandMeasured.clear();
 	for (uint32_t flowIdx = 0; flowIdx < m_flowsPath.size(); flowIdx++) {
-		Ipv4Address ipSink = m_meshNodes->Get(m_flowsPath.at(flowIdx).back())->GetObject<Ipv4>()->GetAddress(1,0).GetLocal();
-		Ptr<DmgWifiMac> mac = m_meshNodes->Get(m_flowsPath.at(flowIdx).front())->GetDevice(0)->GetObject<WifiNetDevice>()->GetMac()->GetObject<DmgWifiMac> ();
+		Ipv4Address ipSink = GetFlowSinkAddress(flowIdx);
+		Ptr<DmgWifiMac> mac = GetLinkMac(m_flowsPath[flowIdx][0], m_flowsPath[flowIdx][1]);
 		m_flowDemandMeasured.push_back(mac-> CalcEnqueueRate (ipSink));
 
 		NS_LOG_UNCOND("FLOW "<< flowIdx <<" measured demand " << m_flowDemandMeasured.at(flowIdx));
@@ -2206,6 +3310,10 @@ DmgAlmightyController::ConfigureAntennaAlignment (void)
 		}
 	}
 
+	// LoS changed: link budgets cached by the channel are stale.
+	if (m_meshNodes->GetN() > 0)
+		m_meshNodes->Get(0)->GetDevice(0)->GetObject<WifiNetDevice>()->GetPhy()->GetObject<YansWifiPhy> ()->
+			GetChannel()->GetObject<YansWifiChannel>()->FlushLinkBudgetCache();
 }
 
 
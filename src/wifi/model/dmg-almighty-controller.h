@@ -26,26 +26,47 @@
 #include "ns3/wifi-mode.h"
 #include "ns3/nstime.h"
 #include "ns3/ipv4-interface-address.h"
+#include "ns3/object-factory.h"
+#include "ns3/vector.h"
+#include "ns3/callback.h"
+#include "ns3/event-id.h"
+#include "ns3/mac48-address.h"
+#include "dmg-optimization-solver.h"
+#include "dmg-beacon-interval.h"
+#include "dmg-airtime-model.h"
+#include "dmg-mcs-table.h"
+#include "dmg-layer-scheduler.h"
+#include "dmg-sp-stats.h"
+#include "dmg-route-planner.h"
+#include "dmg-channel-planner.h"
 
 #include <vector>
 #include <algorithm>
 #include <map>
+#include <set>
 
 
 
 namespace ns3 {
 
+class YansWifiPhy;
+class DmgAntennaController;
+class MobilityModel;
+class AbstractAntenna;
+class WifiNetDevice;
+class DmgWifiMac;
+
 /* Controller of the DMG network.
  * The controller knows every node (AP and STA) of the network.
  * It is able to compute the standard based association (AP with the highest
  * SNR).
  * It is able to configure the DmgBeaconInterval and the DmgServicePeriod of the
  * nodes.
- * Currently the controller supports only static networks (nodes positions and
- * configurations do not change during the simulations. The nodes are configured
- * at the beginning of the simulations.)
- * In future implementations the controller will be able to handle dynamic
- * networks
+ * The nodes are configured at the beginning of the simulations. Afterwards,
+ * demand changes and link up/down events can be handled incrementally with
+ * UpdateFlowDemand and NotifyLinkChange: only the affected flows, cliques and
+ * DmgBeaconIntervals are re-planned. Changes of the topology (flow paths,
+ * cliques, hierarchy) still require a full re-configuration.
  *
  * We suppose that all the nodes are configured in the same way wrt:
  * - Antenna type.
@@ -55,10 +76,15 @@ namespace ns3 {
  * - BI duration.
  * - BI overhead.
  * - rx noise figure.
+ *
+ * The flow rates are computed by a DmgOptimizationSolver created from the
+ * OptimizationSolver attribute (progressive filling by default).
  */
 class DmgAlmightyController : public Object
 {
 public:
+  static TypeId GetTypeId (void);
+
   DmgAlmightyController ();
 
   virtual ~DmgAlmightyController ();
@@ -66,6 +92,24 @@ public:
   /* Set the Mesh nodes container */
   void SetMeshNodes (NodeContainer *meshnodes);
   void SetFlowsPath  (std::vector < std::vector <uint32_t> > path);
+  std::vector < std::vector <uint32_t> > GetFlowsPath (void);
+  /* Compute the path of a flow from a gateway (see SetGw) to every sink
+   * with a DmgRoutePlanner. The links are the pairs of nodes whose ideal
+   * MCS is not the control mode in both directions; the airtime of a link
+   * is the one of the SP exchange of nMpdus MPDUs of appPayloadBytes. The
+   * flow demands (Mb/s) weigh the clique loads of CLIQUE_LOAD. Call after
+   * SetMeshNodes and SetGw; the paths are returned, not installed. */
+  std::vector < std::vector <uint32_t> > ComputeFlowsPath (std::vector <uint32_t> sinks, std::vector <double> flowsDmd,
+      DmgRoutePlanner::Metric metric, uint32_t appPayloadBytes, uint32_t nMpdus);
+  /* Route the flows with every metric of ComputeFlowsPath, configure the
+   * controller with each routing (SetFlowsPath, ConfigureCliques,
+   * ConfigureHierarchy, ConfigureWifiManager, FlowRateProgressiveFilling)
+   * and keep the one with the highest minimum flow rate (then the highest
+   * total) among the ones whose SPs fit in the schedule. Call after the
+   * Beacon Interval settings (SetBiDuration, SetNumSchedulePerBi...).
+   * Return its flow rates; GetFlowsPath returns its paths. */
+  std::vector <double> SelectFlowsPath (std::vector <uint32_t> sinks, std::vector <double> flowsDmd, double fillingSteplength,
+      uint32_t appPayloadBytes, double biOverheadFraction, uint32_t nMpdus);
   /* Return the nodes container */
   NodeContainer *GetMeshNodes (void);
   NodeContainer *GetCtrlNodes (void);
@@ -80,6 +124,7 @@ struct cliqueStruct
     std::vector < double > phyRate;                   //{rate1;   rate2;   rate2   }
     std::vector < std::vector < uint64_t > > bufStart;//same number of rows with flowSegs
     std::vector < std::vector < uint64_t > > bufDurNs;
+    std::vector < std::vector < uint32_t > > bufLayer;//layer of each buffered sp, empty with a single layer
     std::vector < uint32_t> bufStaOrder; // To be used by the conflict node for shuffling and get the correct order.
 };
     std::vector <cliqueStruct> cliqueS;//to be renamed.
@@ -119,14 +164,40 @@ struct cliqueStruct
   void SetBiOverheadFraction (double biOverhead);
   void SetNumSchedulePerBi(uint32_t numSchedulePerBi);
   void SetAckTimeFrac(double ackTimeFrac);
+  double GetAckTimeFrac (void);
+  /* Adapt the ACK time fraction to the reverse traffic: every period, the
+   * fraction becomes 1.25 times the largest fraction of a link SPs used by
+   * its ACK sub-SPs, between minFrac and the fraction set with
+   * SetAckTimeFrac, and the SPs are rebuilt when it changes. The ACK
+   * sub-SPs never get too short for one MPDU of the application payload. With reverse
+   * direction grants (DmgWifiMac::ReverseDirection) the ACKs ride on the
+   * data sub-SPs and the ACK sub-SPs shrink to minFrac. Call after
+   * ConfigureBeaconIntervals; a zero period stops the adaptation. */
+  void SetAutoAckTimeFrac (Time period, double minFrac);
   double GetBiOverheadFraction (void);
+  /* Airtime in nanoseconds of the sector sweeps of the BeamformingEngines
+   * done in the BI of index bi (the one starting at bi times the BI
+   * duration), beam training and data path alike */
+  uint64_t GetBiSweepOverheadNs (uint64_t bi);
   void SetBeamSwitchOverhead (uint64_t beamSwitchOverhead);
   uint64_t GetBeamSwitchOverhead (void);
+  /* Duration of the SP exchange of nMpdus MPDUs carrying the configured
+   * application payload, see DmgAirtimeModel */
   double GetActualTxDurationNs(WifiMode mode, uint32_t nMpdus);
 
   /*Configure a single scheudel and buffer all sps in the structure conlictS */
   void ConfigureSchedule (void);
   void ConfigureScheduleWithInterfAvoidance (void);
+  /* Pack the segments of all the cliques into concurrent layers with a
+   * DmgLayerScheduler: the segments sharing a node or whose links are in an
+   * interference set conflict, the others may be active at the same time.
+   * The SPs carry their layer. */
+  void ConfigureScheduleInLayers (void);
+  /* Statistics of the last ConfigureScheduleInLayers, see DmgLayerScheduler */
+  uint32_t GetNLayers (void);
+  double GetLayerUtilization (uint32_t layer);
+  double GetLayerOccupancy (uint32_t layer);
+  double GetLayerConcurrency (void);
   
   /* Configure a DmgBeaconInterval for each node of the network with the schedule.
    * A DmgBeaconInterval holds a list of DmgServicePeriod 
@@ -145,7 +216,31 @@ struct cliqueStruct
   void ConfigureRoutingBasedAssociation (void);
 
   void ConfigureCliques (void);
+  /* Compute the rate of each flow with the configured DmgOptimizationSolver
+   * and the resulting time allocation of every clique segment.
+   * fillingSteplength is forwarded to solvers having a StepLength attribute.
+   */
   std::vector <double>  FlowRateProgressiveFilling(std::vector <double> flowsDmd, double fillingSteplength, uint32_t appPayloadBytes, double biOverheadFraction, uint32_t nMpdus);
+  /* Wall clock time in milliseconds spent by the solver in the last rate computation */
+  int64_t GetLastSolveTimeMs (void);
+
+  /* Incremental re-planning. Both functions require a complete configuration
+   * (FlowRateProgressiveFilling, ConfigureSchedule,
+   * ConfigureScheduleWithInterfAvoidance or ConfigureScheduleInLayers,
+   * ConfigureBeaconIntervals).
+   * The rates are recomputed only for the flows sharing a clique, directly or
+   * transitively, with a changed flow; the SPs only for the cliques whose time
+   * allocation changed and the cliques scheduled around them (all of them
+   * with layers, packed over the whole network). The nodes whose
+   * SPs changed get the new ones at their next Beacon Interval.
+   */
+  /* Set new flow demands and return the flow rates */
+  std::vector <double> UpdateFlowDemand (std::vector <double> flowsDmd);
+  /* A link went up or down, or its MCS changed (e.g. after
+   * EnforceAdditionalSignalLossBetween). A link down carries no traffic.
+   * Return the flow rates.
+   */
+  std::vector <double> NotifyLinkChange (uint32_t node1, uint32_t node2, bool up);
   /* For each Mesh node, the controller assign the same amount of air-time to each
    * stations associated to that mesh station 
    */
@@ -177,9 +272,32 @@ struct cliqueStruct
   std::vector <double> GetMacEnqueueRateMeasurement (void);
 
   void SetGw  (uint32_t node);
+  /* Several gateways: each node is routed from the closest one, see
+   * ComputeFlowsPath, and the first one is returned by GetGw */
+  void SetGw  (std::vector <uint32_t> nodes);
   uint32_t GetGw  (void);
+  std::vector <uint32_t> GetGws (void);
 
   void ConfigureHierarchy (void);
+  /* Number of channels of the network. With more than one, ConfigureHierarchy
+   * assigns a channel to every link with a DmgChannelPlanner (the links
+   * sharing a node or interfering conflict, and the busier the link the
+   * heavier the conflict), tunes one radio (WifiNetDevice) of each node per
+   * channel it uses, and splits the cliques by channel, so that every
+   * channel is scheduled on its own. The nodes need as many DmgWifiMac
+   * devices as the channels they may use, and the SPs must be scheduled
+   * with ConfigureScheduleInLayers. Default 1: every link on device 0. */
+  void SetNChannels (uint32_t n);
+  uint32_t GetNChannels (void);
+  /* Device of node on the channel of its link with peer (device 0 with a
+   * single channel) */
+  Ptr<WifiNetDevice> GetLinkDevice (uint32_t node, uint32_t peer);
+  /* Channel (from 0) of the link between node and peer */
+  uint32_t GetLinkChannel (uint32_t node, uint32_t peer);
+  /* Addresses of the packets of a flow: the source sends from the address
+   * of its device towards the first hop, to the first address of the sink */
+  Ipv4Address GetFlowSourceAddress (uint32_t flowIdx);
+  Ipv4Address GetFlowSinkAddress (uint32_t flowIdx);
   uint32_t GetMasterCliqueId (uint32_t node);
   uint32_t GetMasterNodeId (uint32_t node);
 
@@ -194,15 +312,114 @@ struct cliqueStruct
 
   std::vector <uint32_t> GetSegIndicesInClique(std::vector <uint32_t>,std::vector < std::vector < uint32_t > > flowSegs);
     
-  std::vector < std::vector <uint64_t> > RemoveIntervalFromTimeAvailable (std::vector < std::vector <uint64_t> >, std::vector < std::vector <uint64_t> >);
 
 
 private:
 
   /* Function used by ConfigureWifiManager for configuring the 
-   * DmgDestinationFixedWifiManager
+   * DmgDestinationFixedWifiManager: the fastest mode phy can receive at
+   * rxPowerDbi
    */
-  WifiMode GetWifiMode (double rxPowerDbi, bool ofdm);
+  WifiMode GetWifiMode (double rxPowerDbi, Ptr<YansWifiPhy> phy);
+  const DmgMcsTable &GetMcsTable (Ptr<YansWifiPhy> phy);
+
+  /* Buffer the SPs of a single clique. Used by ConfigureSchedule and
+   * ConfigureScheduleWithInterfAvoidance. scheduled flags the cliques already
+   * scheduled, whose SPs must be avoided. */
+  void ScheduleClique (uint32_t cIdx);
+  void ScheduleCliqueWithInterfAvoidance (uint32_t cIdx, const std::vector <bool> &scheduled);
+  void ClearCliqueSchedule (uint32_t cIdx);
+  /* Buffer the SPs of all the cliques, packed in layers. Used by
+   * ConfigureScheduleInLayers */
+  void ScheduleLayers (void);
+  /* Duration in nanoseconds of the BI overhead: the configured fraction of
+   * the BI plus the sector sweeps of the BI of the last beam training, until
+   * the schedule of the later BIs is built */
+  uint64_t GetBiOverheadNs (void);
+  /* Make the nodes with a BeamformingEngine select the sectors of all the
+   * links, and charge the sweeps of the current BI to the BI overhead of the
+   * schedule. ConfigureBeaconIntervals installs it in the current BI only,
+   * see ReleaseSweepOverhead */
+  void TrainBeams (void);
+  /* SectorSweep sink of the BeamformingEngines: charge the sweep to the
+   * current BI */
+  void RecordSweep (Ptr<const MobilityModel> peer, Time duration);
+  /* Rebuild the schedule without the sweeps of the last beam training and
+   * install it from the next BI */
+  void ReleaseSweepOverhead (void);
+  /* Install sps from the next BI on the devices of all the nodes */
+  void ScheduleSpUpdates (const std::vector < std::vector < std::vector < Ptr<DmgServicePeriod> > > > &sps);
+  /* SPs to install on the devices (by index in the node) of the nodes
+   * flagged in nodes (other nodes get no SP) */
+  std::vector < std::vector < std::vector < Ptr<DmgServicePeriod> > > > BuildServicePeriods (const std::vector <bool> &nodes);
+  /* Assign the channels of the links and split the cliques by channel, see
+   * SetNChannels */
+  void ConfigureChannels (void);
+  /* Index of the device of node on channel (0 with a single channel) */
+  uint32_t GetChannelDevice (uint32_t node, uint32_t channel);
+  Ptr<DmgWifiMac> GetChannelMac (uint32_t node, uint32_t channel);
+  Ptr<DmgWifiMac> GetLinkMac (uint32_t node, uint32_t peer);
+  /* DmgWifiMac of every device of node, by device index (0 for the other
+   * devices) */
+  std::vector < Ptr<DmgWifiMac> > GetNodeMacs (uint32_t node);
+  /* Links (higher node id, lower node id) that interfere with, or are
+   * interfered by, another planned link according to the interference sets.
+   * Without interference sets every link may be. */
+  std::set < std::pair <uint32_t, uint32_t> > GetInterferedLinks (void);
+  /* Resolve the PHY, antenna and position of every mesh node and reset the
+   * pairwise cache and the spatial index used by ConfigureInterferenceSets */
+  void BuildRadioCache (void);
+  /* Received power at node 'to' of a transmission of node 'from', antenna
+   * gains excluded, plus the direction of 'to' from 'from'. Computed once
+   * per pair. */
+  struct PairGeometry
+  {
+    bool valid;
+    double rxPowerDbm;
+    double azimuth;
+    double elevation;
+  };
+  const PairGeometry & GetPairGeometry (uint32_t from, uint32_t to);
+  /* Distance beyond which no node can be interfered (0 if unbounded) */
+  double GetInterferenceRange (void);
+  /* Nodes within range of node (all of them if range is 0), sorted */
+  std::vector <uint32_t> GetNodesInRange (uint32_t node, double range);
+  /* Interfered links of the links of the nodes in [begin, end), computed
+   * with the antennas of m_planningAntennas[chunk] */
+  void FindInterferedLinks (uint32_t chunk, uint32_t begin, uint32_t end);
+  /* Time fraction of the segments of the cliques in [begin, end) */
+  void ComputeTimeAlloc (uint32_t chunk, uint32_t begin, uint32_t end);
+  /* Number of chunks ParallelFor splits n items into */
+  uint32_t GetNPlanningChunks (uint32_t n) const;
+  /* Call task (chunk, begin, end) on GetNPlanningChunks (n) contiguous
+   * chunks of [0, n), each on its own SystemThread, and wait for all of
+   * them. Tasks must not log nor copy ns-3 smart pointers: reference counts
+   * are not thread safe. */
+  void ParallelFor (uint32_t n, Callback<void, uint32_t, uint32_t, uint32_t> task);
+  /* Equivalent phy rate of a clique segment, 0 when the link is down */
+  void ConfigureSegPhyRate (uint32_t cIdx, uint32_t segIdx);
+  /* Take the parameters of the airtime model from the first mesh station */
+  void ConfigureAirtimeModel (void);
+  /* Build m_flowCliques and m_scheduleDeps */
+  void BuildReplanIndex (void);
+  /* Re-plan the flows connected to changedFlows */
+  void ReplanFlows (std::vector <uint32_t> changedFlows);
+  /* The root cliques of the hierarchy are scheduled from the beginning of
+   * the schedule, the others around their master clique */
+  bool IsRootConflictNode (uint32_t node);
+  /* Fill m_routePlanner with the mesh nodes, the gateways and the links
+   * used by ComputeFlowsPath */
+  void BuildRoutePlanner (uint32_t appPayloadBytes, uint32_t nMpdus);
+  /* Distance beyond which a transmission is received below rxPowerDbm,
+   * with the best antenna gains (0 if unbounded) */
+  double GetFriisRange (double rxPowerDbm);
+  /* SpStats sink of the mesh nodes used by SetAutoAckTimeFrac */
+  void RecordSpStats (const DmgSpStats &stats);
+  /* Periodic update of the ACK time fraction, see SetAutoAckTimeFrac */
+  void UpdateAckTimeFrac (void);
+  /* Smallest ACK time fraction whose ACK sub-SPs all fit the exchange of
+   * one MPDU of the application payload */
+  double GetMinAckTimeFrac (void);
 
   /* it a caller responsibility to ensure that the internal state
    * of the controller (e.g. assocPairs) is set correctly after one of the following two
@@ -263,6 +480,15 @@ private:
    * We suppose that this value is the same for all the mesh stations and controller
    */
   uint64_t m_beamSwitchOverheadNs;
+  /* Airtime in nanoseconds of the sector sweeps done in the BI of the last
+   * beam training, added to the BI overhead until ReleaseSweepOverhead
+   */
+  uint64_t m_sweepOverheadNs;
+  /* Airtime in nanoseconds of the sector sweeps done in each BI (by index) */
+  std::map <uint64_t, uint64_t> m_biSweepNs;
+  /* Engines whose SectorSweep is connected to RecordSweep */
+  std::vector < Ptr<BeamformingEngine> > m_sweepEngines;
+  EventId m_sweepReleaseEvent;
 
   /* Number of repeated schedule in the beacon interval, each of which contains   
    * a full set of all SPs in the scheduled order.
@@ -273,6 +499,16 @@ private:
    * TCP acks
    */
   double m_ackTimeFrac;
+  /* SetAutoAckTimeFrac state: the period, the fraction bounds, and for
+   * every link (data transmitter, data receiver) the time allocated to its
+   * data and ACK sub-SPs and the time used by the ACK sub-SPs, in ns, since
+   * the last update */
+  Time m_ackTimeFracPeriod;
+  double m_ackTimeFracMin;
+  double m_ackTimeFracMax;
+  bool m_ackTimeFracConnected;
+  std::map < std::pair <Mac48Address, Mac48Address>, std::pair <uint64_t, uint64_t> > m_ackTimeUsage;
+  EventId m_ackTimeFracEvent;
 
   std::vector < std::vector <uint32_t> > m_flowsPath;
 
@@ -303,6 +539,24 @@ private:
 
    /*Index of the gateway node*/
    uint32_t m_gw;
+   /* All the gateways, m_gw first */
+   std::vector <uint32_t> m_gws;
+   /* Links of the mesh nodes for ComputeFlowsPath, built for these
+    * exchanges and cleared when the gateways or the links change */
+   DmgRoutePlanner m_routePlanner;
+   uint32_t m_routeAppPayloadBytes;
+   uint32_t m_routeNMpdus;
+   /* Airtime of the cliques that did not fit in the last schedule; with
+    * the hierarchical schedules it is fatal unless the schedule is a trial
+    * of SelectFlowsPath */
+   uint64_t m_scheduleOverflowNs;
+   bool m_scheduleTrial;
+
+   /* Channels: the channel of every link (higher node id, lower node id)
+    * and the device of every node on every channel (-1 if none) */
+   uint32_t m_nChannels;
+   std::map < std::pair <uint32_t, uint32_t>, uint32_t > m_linkChannel;
+   std::vector < std::vector <int32_t> > m_channelDevice;
 
    std::map <int32_t, int32_t> m_master;
    std::map <int32_t, int32_t> m_masterClique;
@@ -314,6 +568,80 @@ private:
     // the index of the first interference clique
    uint32_t m_interfCliqueStart;
 
+   // Factory of the DmgOptimizationSolver used for the flow rate allocation
+   ObjectFactory m_solverFactory;
+   int64_t m_lastSolveTimeMs;
+
+   /* State of the last planning, used by the incremental re-planning */
+   std::vector <double> m_flowsDmd;
+   std::vector <double> m_flowsRate;
+   double m_fillingSteplength;
+   uint32_t m_appPayloadBytes;
+   double m_phyRateOverheadFraction;
+   uint32_t m_nMpdus;
+   /* Memoized SP exchange durations, parameters taken from the first mesh
+    * station */
+   DmgAirtimeModel m_airtimeModel;
+   bool m_airtimeModelConfigured;
+   /* MCS tables per PHY flavour (dmgOfdm, ExtendedRateMode) */
+   std::map<std::pair<bool, uint16_t>, DmgMcsTable> m_mcsTables;
+   bool m_scheduleWithInterfAvoidance;
+   bool m_scheduleInLayers;
+   // segments of the last schedule in layers
+   DmgLayerScheduler m_layerScheduler;
+   // links (higher node id, lower node id) that are down
+   std::set < std::pair <uint32_t, uint32_t> > m_linksDown;
+   // m_flowCliques.at(f): cliques crossed by flow f
+   std::vector < std::vector <uint32_t> > m_flowCliques;
+   // m_scheduleDeps.at(c): cliques whose SPs are read when scheduling clique c
+   std::vector < std::vector <uint32_t> > m_scheduleDeps;
+   bool m_replanIndexValid;
+
+   /* Interference between links (ConfigureInterferenceSets) */
+   // a link is interfered when it receives more than this power (dBm)
+   double m_interfThreshold;
+   // user provided bound on the interference distance (m), 0 to derive it
+   double m_interfRange;
+   struct NodeRadio
+   {
+     Ptr<YansWifiPhy> phy;
+     Ptr<DmgAntennaController> antenna;
+     Ptr<MobilityModel> mobility;
+     Vector position;
+   };
+   std::vector <NodeRadio> m_radio;
+   std::vector < std::vector <PairGeometry> > m_pairGeometry;
+   // uniform grid over the node positions: cell -> nodes
+   double m_gridCellSize;
+   std::map < std::pair <int64_t, int64_t>, std::vector <uint32_t> > m_grid;
+
+   /* Parallel planning */
+   uint32_t m_planningThreads;
+   // private copies of the node antennas, one set per chunk
+   std::vector < std::vector < Ptr<AbstractAntenna> > > m_planningAntennas;
+   // state shared (read only) by the FindInterferedLinks chunks
+   struct InterferedLink
+   {
+     uint32_t intfLinkIdx;
+     // 0 if the victim is m_linkList[intfLinkIdx][0], 1 otherwise
+     uint32_t victimEnd;
+     double rxPowerDbm;
+     bool operator < (const InterferedLink &o) const
+     {
+       return (intfLinkIdx < o.intfLinkIdx) || (intfLinkIdx == o.intfLinkIdx && victimEnd < o.victimEnd);
+     }
+   };
+   std::vector < std::vector <uint32_t> > m_nodeLinks;
+   std::vector < std::vector <uint32_t> > m_nodeVictims;
+   std::vector <double> m_maxRxGain;
+   std::vector <double> m_phyRxGain;
+   // m_linkPointing[linkIdx][end]: azimuth of the antenna of
+   // m_linkList[linkIdx][end] when it points the other end
+   std::vector < std::vector <double> > m_linkPointing;
+   // m_interfered[node][l]: links interfered by the l-th link of node
+   std::vector < std::vector < std::vector <InterferedLink> > > m_interfered;
+   std::vector <uint64_t> m_pairsEvaluated;
+
 };
 
 } // namespace ns3
@@ -37,6 +37,17 @@ DmgAntennaController::~DmgAntennaController ()
 {
 }
 
+void
+DmgAntennaController::DoDispose (void)
+{
+  if (m_beamformingEngine != 0)
+    {
+      m_beamformingEngine->Dispose ();
+      m_beamformingEngine = 0;
+    }
+  Object::DoDispose ();
+}
+
 void
 DmgAntennaController::SetPhy (Ptr<WifiPhy> phy)
 {
@@ -49,6 +60,34 @@ DmgAntennaController::SetAntenna (Ptr<AbstractAntenna> antenna)
   m_antenna = antenna;
 }
 
+Ptr<AbstractAntenna>
+DmgAntennaController::GetAntenna (void) const
+{
+  return m_antenna;
+}
+
+void
+DmgAntennaController::SetBeamformingEngine (Ptr<BeamformingEngine> engine)
+{
+  if (m_beamformingEngine != 0 && m_beamformingEngine != engine)
+    {
+      m_beamformingEngine->Dispose ();
+    }
+  m_beamformingEngine = engine;
+  if (m_beamformingEngine != 0)
+    {
+      m_beamformingEngine->SetAntenna(m_antenna);
+      m_beamformingEngine->SetMobility(m_phy->GetObject<YansWifiPhy>()->
+	      GetMobility()->GetObject<MobilityModel>());
+    }
+}
+
+Ptr<BeamformingEngine>
+DmgAntennaController::GetBeamformingEngine (void) const
+{
+  return m_beamformingEngine;
+}
+
 double
 DmgAntennaController::GetTxGainDbi(double azimuth, double elevation)
 {
@@ -62,19 +101,47 @@ DmgAntennaController::GetRxGainDbi(double azimuth, double elevation)
 }
 
 void
-DmgAntennaController::PointAntenna (Ptr<WifiPhy> target)
+DmgAntennaController::GetTxGainsDbi (const double *azimuth, const double *elevation,
+                                     double *gains, uint32_t n)
 {
-  Vector sourcePos = m_phy->GetObject<YansWifiPhy>()->
-	  GetMobility()->GetObject<MobilityModel>()->GetPosition();
-  Vector targetPos = target->GetObject<YansWifiPhy>()->
-	  GetMobility()->GetObject<MobilityModel>()->GetPosition();
+  m_antenna->GetTxGainsDbi (azimuth, elevation, gains, n);
+}
 
-  double azimuthAngle = atan2(targetPos.y - sourcePos.y,
-			      targetPos.x - sourcePos.x);
+void
+DmgAntennaController::GetRxGainsDbi (const double *azimuth, const double *elevation,
+                                     double *gains, uint32_t n)
+{
+  m_antenna->GetRxGainsDbi (azimuth, elevation, gains, n);
+}
 
+void
+DmgAntennaController::PointAntenna (Ptr<WifiPhy> target)
+{
+  PointAntennaToPeer(target->GetObject<YansWifiPhy>()->
+	  GetMobility()->GetObject<MobilityModel>());
+}
+
+void
+DmgAntennaController::PointAntennaToPeer (Ptr<MobilityModel> target)
+{
   // Change the azimuth angle of the antenna to point to targer.
   // We assume elevation in 0.
-  m_antenna->SetAzimuthAngle(azimuthAngle);
+  m_antenna->SetAzimuthAngle(GetPointingAzimuth(target));
+}
+
+double
+DmgAntennaController::GetPointingAzimuth (Ptr<MobilityModel> target)
+{
+  if (m_beamformingEngine != 0)
+    {
+      return m_beamformingEngine->GetSectorAzimuth(m_beamformingEngine->GetBestSector(target));
+    }
+  Vector sourcePos = m_phy->GetObject<YansWifiPhy>()->
+	  GetMobility()->GetObject<MobilityModel>()->GetPosition();
+  Vector targetPos = target->GetPosition();
+
+  return atan2(targetPos.y - sourcePos.y,
+	       targetPos.x - sourcePos.x);
 }
 
 void
@@ -97,5 +164,11 @@ DmgAntennaController::GetBeamwidthDegrees (void)
   return m_antenna->GetBeamwidthDegrees();
 }
 
+double
+DmgAntennaController::GetMaxGainDbi (void)
+{
+  return m_antenna->GetMaxGainDbi();
+}
+
 } // namespace ns3
 
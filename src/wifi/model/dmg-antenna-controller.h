@@ -23,6 +23,8 @@
 #include "ns3/object.h"
 #include "ns3/wifi-phy.h"
 #include "ns3/abstract-antenna.h"
+#include "ns3/beamforming-engine.h"
+#include "ns3/mobility-model.h"
 #include "ns3/vector.h"
 
 namespace ns3 {
@@ -49,6 +51,12 @@ public:
    * ConeAntenna
    */
   void SetAntenna (Ptr<AbstractAntenna> antenna);
+  Ptr<AbstractAntenna> GetAntenna (void) const;
+  /* Steer the antenna over the sector codebook of engine instead of
+   * pointing it exactly at the targets. Set the PHY and the antenna first.
+   */
+  void SetBeamformingEngine (Ptr<BeamformingEngine> engine);
+  Ptr<BeamformingEngine> GetBeamformingEngine (void) const;
 
   /* Return the transmission gain of the antenna for a given azimuth and
    * elevation.
@@ -60,22 +68,44 @@ public:
    * for both transmission and reception.
    */
   double GetRxGainDbi(double azimuth, double elevation);
+  /* Return the transmission (reception) gains toward n directions, see
+   * AbstractAntenna::GetTxGainsDbi.
+   */
+  void GetTxGainsDbi (const double *azimuth, const double *elevation,
+                      double *gains, uint32_t n);
+  void GetRxGainsDbi (const double *azimuth, const double *elevation,
+                      double *gains, uint32_t n);
   /* Return the beamwidth of the antenna.
    * With ConeAntenna the beamwidth depends on the Tx and Rx gain.
    */
   double GetBeamwidthDegrees (void);
+  /* Return an upper bound of the TX and RX gain of the antenna over all
+   * directions.
+   */
+  double GetMaxGainDbi (void);
 
   /* Change the azimuth of the antenna to point the target.
    * We assume elevation is always 0.
    * We assume target is a YansWifiPhy
    */
   void PointAntenna (Ptr<WifiPhy> target);
+  /* Change the azimuth of the antenna to point the node whose mobility is
+   * target: the best sector of the BeamformingEngine if any, the exact
+   * direction otherwise.
+   */
+  void PointAntennaToPeer (Ptr<MobilityModel> target);
+  /* Azimuth PointAntennaToPeer (target) would set */
+  double GetPointingAzimuth (Ptr<MobilityModel> target);
   /* Change the azimuth of the antenna to point the target whose position is
-   * targetPos.
+   * targetPos. The target is unknown, so the pointing is always exact.
    * We assume elevation is always 0.
    */
   void PointAntenna (Vector targetPos);
 
+protected:
+  /* Dispose the BeamformingEngine, which tracks the mobility of the nodes */
+  virtual void DoDispose (void);
+
 private:
 
   /* PHY of the node this antenna controller is associated with.
@@ -86,6 +116,8 @@ private:
    * We assume m_antenna is a ConeAntenna
    */
   Ptr<AbstractAntenna> m_antenna;
+  /* Sector selection, 0 for exact pointing */
+  Ptr<BeamformingEngine> m_beamformingEngine;
 
 };
 
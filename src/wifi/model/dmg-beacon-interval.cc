@@ -21,6 +21,7 @@
 #include "dmg-beacon-interval.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
+#include <algorithm>
 
 namespace ns3 {
 
@@ -29,6 +30,10 @@ NS_LOG_COMPONENT_DEFINE ("DmgBeaconInterval");
 NS_OBJECT_ENSURE_REGISTERED (DmgBeaconInterval);
 
 DmgServicePeriod::DmgServicePeriod ()
+  : m_spTransmitter (false),
+    m_spIsolated (false),
+    m_spAck (false),
+    m_spLayer (0)
 {
 }
 
@@ -115,12 +120,65 @@ DmgServicePeriod::SetSpIfTx(bool transmitt)
   m_spTransmitter = transmitt;
 }
 
+void
+DmgServicePeriod::SetSpIsolated (bool isolated)
+{
+  m_spIsolated = isolated;
+}
+
+bool
+DmgServicePeriod::GetSpIsolated (void)
+{
+  return m_spIsolated;
+}
+
+void
+DmgServicePeriod::SetSpLayer (uint32_t layer)
+{
+  m_spLayer = layer;
+}
+
+uint32_t
+DmgServicePeriod::GetSpLayer (void)
+{
+  return m_spLayer;
+}
+
+void
+DmgServicePeriod::SetSpAck (bool ack)
+{
+  m_spAck = ack;
+}
+
+bool
+DmgServicePeriod::GetSpAck (void)
+{
+  return m_spAck;
+}
+
+bool
+DmgServicePeriod::IsEqual (Ptr<DmgServicePeriod> sp)
+{
+  return m_spStart == sp->GetSpStart()
+    && m_spStop == sp->GetSpStop()
+    && m_spTransmitter == sp->GetSpIfTx()
+    && m_spIsolated == sp->GetSpIsolated()
+    && m_spLayer == sp->GetSpLayer()
+    && m_spAck == sp->GetSpAck()
+    && m_spDestination == sp->GetSpDestination()
+    && m_spFlowSourceSinkIpv4Address == sp->GetSpFlowSourceSinkIpv4Address()
+    && m_spDestinationMobility == sp->GetSpDestinationMobility();
+}
+
 
 DmgBeaconInterval::DmgBeaconInterval ()
 {
   m_dmgAntennaController = 0;
   m_alignAntennaTime = NanoSeconds(0);
   m_initialized = false;
+  m_timelinesValid = false;
+  m_lookupValid[0] = false;
+  m_lookupValid[1] = false;
 }
 
 DmgBeaconInterval::~DmgBeaconInterval ()
@@ -131,6 +189,8 @@ void
 DmgBeaconInterval::SetBiDuration (Time biDur)
 {
   m_biDuration = biDur;
+  m_lookupValid[0] = false;
+  m_lookupValid[1] = false;
 }
 
 Time
@@ -156,356 +216,302 @@ DmgBeaconInterval::AddSp (Time start, Time stop,
   sp->SetSpFlowSrcSinkIpv4Address(srcIpv4, sinkIpv4);
   sp->SetSpDestinationMobility(mob);
   sp->SetSpIfTx(transmitt);
+  AddSp(sp);
+}
+
+void
+DmgBeaconInterval::AddSp (Ptr<DmgServicePeriod> sp)
+{
   m_sp.push_back(sp);
+  m_timelinesValid = false;
 }
 
 void
 DmgBeaconInterval::EraseSp ()
 {
   m_sp.clear();
+  m_timelinesValid = false;
 }
 
-Time
-DmgBeaconInterval::GetNextSpStart (void)
+bool
+DmgBeaconInterval::ScheduleSpUpdate (std::vector<Ptr<DmgServicePeriod> > sps)
 {
-  Time t;
+  NS_LOG_FUNCTION(this << sps.size());
+  bool same = (sps.size() == m_sp.size());
+  for (uint32_t i = 0; same && i < sps.size(); i++) {
+    same = m_sp.at(i)->IsEqual(sps.at(i));
+  }
 
-  NS_ASSERT(m_sp.size() > 0);
+  m_spUpdate.Cancel();
+  m_pendingSp.clear();
+  if (same) {
+    return false;
+  }
+
+  m_pendingSp = sps;
   Time now = Simulator::Now();
-  Time lastBiStart = (now / m_biDuration) *
-				 m_biDuration;
+  Time nextBiStart = (now / m_biDuration + 1) * m_biDuration;
+  m_spUpdate = Simulator::Schedule (nextBiStart - now,
+				    &DmgBeaconInterval::ApplySpUpdate, this);
+  return true;
+}
 
-  bool nextSpFound = false;
-  do {
-    for (uint32_t i = 0; i < m_sp.size(); i++) {
-      Time spStop = lastBiStart + m_sp.at(i)->GetSpStop();
+void
+DmgBeaconInterval::ApplySpUpdate (void)
+{
+  NS_LOG_FUNCTION(this << m_pendingSp.size());
+  m_sp.swap(m_pendingSp);
+  m_pendingSp.clear();
+  m_timelinesValid = false;
+
+  /* The pending alignment refers to the old list of SPs */
+  if (m_dmgAntennaController != 0) {
+    m_alignAntenna.Cancel();
+    m_lastAlignAntennaSpIndex = 0;
+    ScheduleNextAntennaAlignment();
+  }
+}
 
-      if (now < spStop) {
-        t = lastBiStart + m_sp.at(i)->GetSpStart();
-        nextSpFound = true;
-        break;
-      }
+void
+DmgBeaconInterval::BuildTimeline (bool txOnly, SpTimeline &timeline)
+{
+  std::vector<std::pair<Time, uint32_t> > stops;
+  for (uint32_t i = 0; i < m_sp.size(); i++) {
+    if (!txOnly || m_sp.at(i)->GetSpIfTx()) {
+      stops.push_back(std::make_pair(m_sp.at(i)->GetSpStop(), i));
     }
+  }
+  std::sort(stops.begin(), stops.end());
+
+  timeline.stops.resize(stops.size());
+  timeline.first.resize(stops.size());
+  uint32_t first = m_sp.size();
+  for (uint32_t k = stops.size(); k > 0; k--) {
+    first = std::min(first, stops.at(k - 1).second);
+    timeline.stops.at(k - 1) = stops.at(k - 1).first;
+    timeline.first.at(k - 1) = first;
+  }
+}
 
-    lastBiStart += m_biDuration;
-  } while (!nextSpFound);
+void
+DmgBeaconInterval::BuildTimelines (void)
+{
+  BuildTimeline(false, m_allSpTimeline);
+  BuildTimeline(true, m_txSpTimeline);
+  m_lookupValid[0] = false;
+  m_lookupValid[1] = false;
+  m_timelinesValid = true;
+}
 
-  return t;
+bool
+DmgBeaconInterval::FindNextSp (bool txOnly, uint32_t &index, Time &biStart)
+{
+  if (!m_timelinesValid) {
+    BuildTimelines();
+  }
+
+  uint32_t view = txOnly ? 1 : 0;
+  SpTimeline &timeline = txOnly ? m_txSpTimeline : m_allSpTimeline;
+  if (timeline.stops.empty()) {
+    return false;
+  }
+
+  /* Several queries are usually issued at the same time (e.g. start, stop
+   * and destination of the next SP): answer them with a single lookup */
+  Time now = Simulator::Now();
+  if (m_lookupValid[view] && m_lookupTime[view] == now) {
+    index = m_lookupIndex[view];
+    biStart = m_lookupBiStart[view];
+    return true;
+  }
+
+  Time lastBiStart = (now / m_biDuration) * m_biDuration;
+  /* The next SP is the first one, in the order the SPs have been added, whose
+   * stop time is after now */
+  std::vector<Time>::iterator it = std::upper_bound(timeline.stops.begin(),
+						    timeline.stops.end(),
+						    now - lastBiStart);
+  if (it != timeline.stops.end()) {
+    index = timeline.first.at(it - timeline.stops.begin());
+    biStart = lastBiStart;
+  } else {
+    /* No more SPs in this BI: first SP of the next BI */
+    index = timeline.first.at(0);
+    biStart = lastBiStart + m_biDuration;
+  }
+
+  m_lookupValid[view] = true;
+  m_lookupTime[view] = now;
+  m_lookupIndex[view] = index;
+  m_lookupBiStart[view] = biStart;
+  return true;
 }
 
 Time
-DmgBeaconInterval::GetNextSpStop (void)
+DmgBeaconInterval::GetNextSpStart (void)
 {
-  Time t;
+  uint32_t i;
+  Time biStart;
 
   NS_ASSERT(m_sp.size() > 0);
+  FindNextSp(false, i, biStart);
 
-  Time now = Simulator::Now();
-  Time lastBiStart = (now / m_biDuration) *
-				 m_biDuration;
-
-  bool nextSpFound = false;
-  do {
-    for (uint32_t i = 0; i < m_sp.size(); i++) {
-      Time spStop = lastBiStart + m_sp.at(i)->GetSpStop();
+  return biStart + m_sp.at(i)->GetSpStart();
+}
 
-      if (now < spStop) {
-        t = spStop;
-	nextSpFound = true;
-        break;
-      }
-    }
+Time
+DmgBeaconInterval::GetNextSpStop (void)
+{
+  uint32_t i;
+  Time biStart;
 
-    lastBiStart += m_biDuration;
-  }while (!nextSpFound);
+  NS_ASSERT(m_sp.size() > 0);
+  FindNextSp(false, i, biStart);
 
-  return t;
+  return biStart + m_sp.at(i)->GetSpStop();
 }
 
 //----------------added on 20 Jan
 bool
 DmgBeaconInterval::GetNextSpIfTx(void)
 {
-    bool transmitter;
-    NS_ASSERT(m_sp.size() > 0);
-    
-    Time now = Simulator::Now();
-    Time lastBiStart = (now / m_biDuration) *
-    m_biDuration;
-    bool nextSpFound = false;
-    do {
-        for (uint32_t i = 0; i < m_sp.size(); i++) {
-            Time spStop = lastBiStart + m_sp.at(i)->GetSpStop();
-            if (now < spStop) {
-                transmitter = m_sp.at(i)->GetSpIfTx();
-                nextSpFound = true;
-                break;
-            }
-        }
-        lastBiStart += m_biDuration;
-    }while (!nextSpFound);
-    
-    return transmitter;
+  uint32_t i;
+  Time biStart;
+
+  NS_ASSERT(m_sp.size() > 0);
+  FindNextSp(false, i, biStart);
+
+  return m_sp.at(i)->GetSpIfTx();
 }
 
 Time
 DmgBeaconInterval::GetNextTxSpStart (void)
 {
-    bool ifAnyTxSp=false;
-    for (uint32_t i = 0; i < m_sp.size(); i++) {
-        if (m_sp.at(i)->GetSpIfTx()){
-            ifAnyTxSp=true;
-           }
-    }
-    if(!ifAnyTxSp){
-        return (Seconds(65535)+Simulator::Now());
-    }
-    else{
-        
-    Time t;
-    
-    NS_ASSERT(m_sp.size() > 0);
-    
-    Time now = Simulator::Now();
-    Time lastBiStart = (now / m_biDuration) *
-    m_biDuration;
-    bool nextTxSpFound = false;
-    do {
-        for (uint32_t i = 0; i < m_sp.size(); i++) {
-            NS_LOG_DEBUG("m_sp"<<i);
-            Time spStop = lastBiStart + m_sp.at(i)->GetSpStop();
-            NS_LOG_DEBUG(now << "(now) < spstop? "<< spStop << " tx? " <<m_sp.at(i)->GetSpIfTx());
-            if ((now < spStop)&&(m_sp.at(i)->GetSpIfTx())) {
-                t = lastBiStart + m_sp.at(i)->GetSpStart();
-                NS_LOG_DEBUG("lastBiStart "<<lastBiStart<< " Bi SpStart "<< m_sp.at(i)->GetSpStart() << " Bi SpStop "<< m_sp.at(i)->GetSpStop());
-                NS_LOG_DEBUG("Time start "<< t << " Time stop "<< lastBiStart + m_sp.at(i)->GetSpStop());
-                nextTxSpFound = true;
-                break;
-            }
-        }
-        
-        lastBiStart += m_biDuration;
-    } while (!nextTxSpFound);
-    
-    return t;
-    }
+  uint32_t i;
+  Time biStart;
+
+  if (!FindNextSp(true, i, biStart)) {
+    return (Seconds(65535)+Simulator::Now());
+  }
+  NS_LOG_DEBUG("lastBiStart "<<biStart<< " Bi SpStart "<< m_sp.at(i)->GetSpStart() << " Bi SpStop "<< m_sp.at(i)->GetSpStop());
+
+  return biStart + m_sp.at(i)->GetSpStart();
 }
 
 Time
 DmgBeaconInterval::GetNextTxSpStop (void)
 {
-    bool ifAnyTxSp=false;
-    for (uint32_t i = 0; i < m_sp.size(); i++) {
-        if (m_sp.at(i)->GetSpIfTx()){
-            ifAnyTxSp=true;
-        }
-    }
-    if(!ifAnyTxSp){
-        return (Seconds(65535)+Simulator::Now());
-    }
-    else{
-        
-    Time t;
-    
-    NS_ASSERT(m_sp.size() > 0);
-    
-    Time now = Simulator::Now();
-    Time lastBiStart = (now / m_biDuration) *
-    m_biDuration;
-    
-    bool nextTxSpFound = false;
-    do {
-        for (uint32_t i = 0; i < m_sp.size(); i++) {
-            Time spStop = lastBiStart + m_sp.at(i)->GetSpStop();
-            if ((now < spStop)&&(m_sp.at(i)->GetSpIfTx()))  {
-                t = spStop;
-                nextTxSpFound = true;
-                break;
-            }
-        }
-        
-        lastBiStart += m_biDuration;
-    }while (!nextTxSpFound);
-    
-    return t;
-    }
+  uint32_t i;
+  Time biStart;
+
+  if (!FindNextSp(true, i, biStart)) {
+    return (Seconds(65535)+Simulator::Now());
+  }
+
+  return biStart + m_sp.at(i)->GetSpStop();
 }
 
-    Mac48Address
-    DmgBeaconInterval::GetNextTxSpDestination (void)
-    {
-        bool ifAnyTxSp=false;
-        for (uint32_t i = 0; i < m_sp.size(); i++) {
-            if (m_sp.at(i)->GetSpIfTx()){
-                ifAnyTxSp=true;
-            }
-        }
-        if(ifAnyTxSp){
-        Mac48Address mac;
-        
-        NS_ASSERT(m_sp.size() > 0);
-        
-        Time now = Simulator::Now();
-        Time lastBiStart = (now / m_biDuration) *
-        m_biDuration;
-        
-        bool nextSpFound = false;
-        do {
-            for (uint32_t i = 0; i < m_sp.size(); i++) {
-                Time spStop = lastBiStart + m_sp.at(i)->GetSpStop();
-                
-                if ((now < spStop)&&(m_sp.at(i)->GetSpIfTx())) {
-                    
-                    mac = m_sp.at(i)->GetSpDestination();
-                    nextSpFound = true;
-                    break;
-                }
-                
-            }
-            
-            lastBiStart += m_biDuration;
-        }while (!nextSpFound);
-        
-        return mac;
-        }
-    }
+Mac48Address
+DmgBeaconInterval::GetNextTxSpDestination (void)
+{
+  uint32_t i;
+  Time biStart;
 
-    std::pair<Ipv4Address, Ipv4Address> 
-    DmgBeaconInterval::GetNextTxSpSrcSinkIpv4Address (void)
-    {
-        bool ifAnyTxSp=false;
-        for (uint32_t i = 0; i < m_sp.size(); i++) {
-            if (m_sp.at(i)->GetSpIfTx()){
-                ifAnyTxSp=true;
-            }
-        }
-        if(ifAnyTxSp){
-        std::pair <Ipv4Address,Ipv4Address> ipv4;
-        
-        NS_ASSERT(m_sp.size() > 0);
-        
-        Time now = Simulator::Now();
-        Time lastBiStart = (now / m_biDuration) *
-        m_biDuration;
-        
-        bool nextSpFound = false;
-        do {
-            for (uint32_t i = 0; i < m_sp.size(); i++) {
-                Time spStop = lastBiStart + m_sp.at(i)->GetSpStop();
-                
-                if ((now < spStop)&&(m_sp.at(i)->GetSpIfTx())) {
-                    
-                    ipv4 = m_sp.at(i)->GetSpFlowSourceSinkIpv4Address();
-                    nextSpFound = true;
-                    break;
-                }
-                
-            }
-            
-            lastBiStart += m_biDuration;
-        }while (!nextSpFound);
-        return ipv4;
-        }
-    }
-    
-    Ptr<MobilityModel>
-    DmgBeaconInterval::GetNextTxSpDestinationMobility (void)
-    {
-        bool ifAnyTxSp=false;
-        for (uint32_t i = 0; i < m_sp.size(); i++) {
-            if (m_sp.at(i)->GetSpIfTx()){
-                ifAnyTxSp=true;
-            }
-        }
-        if(ifAnyTxSp){
-
-        Ptr<MobilityModel> mob;
-        
-        NS_ASSERT(m_sp.size() > 0);
-        
-        Time now = Simulator::Now();
-        Time lastBiStart = (now / m_biDuration) *
-        m_biDuration;
-        
-        bool nextSpFound = false;
-        do {
-            for (uint32_t i = 0; i < m_sp.size(); i++) {
-                Time spStop = lastBiStart + m_sp.at(i)->GetSpStop();
-                
-                if ((now < spStop)&&(m_sp.at(i)->GetSpIfTx())) {
-                    mob = m_sp.at(i)->GetSpDestinationMobility();
-                    nextSpFound = true;
-                    break;
-                }
-            }
-            
-            lastBiStart += m_biDuration;
-        }while (!nextSpFound);
-        
-        return mob;
-        }
-    }
+  if (!FindNextSp(true, i, biStart)) {
+    return Mac48Address();
+  }
+
+  return m_sp.at(i)->GetSpDestination();
+}
+
+std::pair<Ipv4Address, Ipv4Address> 
+DmgBeaconInterval::GetNextTxSpSrcSinkIpv4Address (void)
+{
+  uint32_t i;
+  Time biStart;
+
+  if (!FindNextSp(true, i, biStart)) {
+    return std::pair<Ipv4Address, Ipv4Address> ();
+  }
+
+  return m_sp.at(i)->GetSpFlowSourceSinkIpv4Address();
+}
+
+Ptr<MobilityModel>
+DmgBeaconInterval::GetNextTxSpDestinationMobility (void)
+{
+  uint32_t i;
+  Time biStart;
+
+  if (!FindNextSp(true, i, biStart)) {
+    return 0;
+  }
+
+  return m_sp.at(i)->GetSpDestinationMobility();
+}
+
+bool
+DmgBeaconInterval::GetNextTxSpIsolated (void)
+{
+  uint32_t i;
+  Time biStart;
+
+  if (!FindNextSp(true, i, biStart)) {
+    return false;
+  }
+
+  return m_sp.at(i)->GetSpIsolated();
+}
+
+bool
+DmgBeaconInterval::GetNextTxSpAck (void)
+{
+  uint32_t i;
+  Time biStart;
+
+  if (!FindNextSp(true, i, biStart)) {
+    return false;
+  }
+
+  return m_sp.at(i)->GetSpAck();
+}
 
 // -----------------------------------
 
 Mac48Address
 DmgBeaconInterval::GetNextSpDestination (void)
 {
-  Mac48Address mac;
+  uint32_t i;
+  Time biStart;
 
   NS_ASSERT(m_sp.size() > 0);
-    
-  Time now = Simulator::Now();
-  Time lastBiStart = (now / m_biDuration) *
-				 m_biDuration;
-
-  bool nextSpFound = false;
-  do {
-    for (uint32_t i = 0; i < m_sp.size(); i++) {
-      Time spStop = lastBiStart + m_sp.at(i)->GetSpStop();
-        
-      if (now < spStop) {
-
-        mac = m_sp.at(i)->GetSpDestination();
-	    nextSpFound = true;
-        break;
-      }
-
-    }
+  FindNextSp(false, i, biStart);
 
-    lastBiStart += m_biDuration;
-  }while (!nextSpFound);
-  
-  return mac;
+  return m_sp.at(i)->GetSpDestination();
 }
 
 Ptr<MobilityModel>
 DmgBeaconInterval::GetNextSpDestinationMobility (void)
 {
-  Ptr<MobilityModel> mob;
+  uint32_t i;
+  Time biStart;
 
   NS_ASSERT(m_sp.size() > 0);
+  FindNextSp(false, i, biStart);
 
-  Time now = Simulator::Now();
-  Time lastBiStart = (now / m_biDuration) *
-				 m_biDuration;
-
-  bool nextSpFound = false;
-  do {
-    for (uint32_t i = 0; i < m_sp.size(); i++) {
-      Time spStop = lastBiStart + m_sp.at(i)->GetSpStop();
+  return m_sp.at(i)->GetSpDestinationMobility();
+}
 
-      if (now < spStop) {
-        mob = m_sp.at(i)->GetSpDestinationMobility();
-	nextSpFound = true;
-        break;
-      }
-    }
+std::pair <Ipv4Address, Ipv4Address>
+DmgBeaconInterval::GetNextSpSrcSinkIpv4Address (void)
+{
+  uint32_t i;
+  Time biStart;
 
-    lastBiStart += m_biDuration;
-  }while (!nextSpFound);
+  NS_ASSERT(m_sp.size() > 0);
+  FindNextSp(false, i, biStart);
 
-  return mob;
+  return m_sp.at(i)->GetSpFlowSourceSinkIpv4Address();
 }
 
 void
@@ -524,10 +530,8 @@ void
 DmgBeaconInterval::AlignAntenna()
 {
     NS_LOG_FUNCTION(this);
-  Vector targetPos = m_sp.at(m_lastAlignAntennaSpIndex)->
-	  GetSpDestinationMobility()->GetPosition();
-    
-  m_dmgAntennaController->PointAntenna(targetPos);
+  m_dmgAntennaController->PointAntennaToPeer(m_sp.at(m_lastAlignAntennaSpIndex)->
+	  GetSpDestinationMobility());
 
   m_lastAlignAntennaSpIndex++;
 
@@ -538,7 +542,7 @@ DmgBeaconInterval::AlignAntenna()
     Time nextBiStart = ((now / m_biDuration) + 1) *
 				 m_biDuration;
 
-    Simulator::Schedule (nextBiStart - now,
+    m_alignAntenna = Simulator::Schedule (nextBiStart - now,
 			&DmgBeaconInterval::ScheduleNextAntennaAlignment, this);
 
   } else {
@@ -576,5 +580,34 @@ DmgBeaconInterval::GetSps(void)
   return m_sp;
 }
 
+uint32_t
+DmgBeaconInterval::GetNLayers (void)
+{
+  uint32_t layers = 0;
+  for (uint32_t i = 0; i < m_sp.size(); i++)
+    {
+      layers = std::max (layers, m_sp.at(i)->GetSpLayer() + 1);
+    }
+  return layers;
+}
+
+double
+DmgBeaconInterval::GetLayerUtilization (uint32_t layer)
+{
+  if (m_biDuration.IsZero ())
+    {
+      return 0;
+    }
+  Time busy = Seconds (0);
+  for (uint32_t i = 0; i < m_sp.size(); i++)
+    {
+      if (m_sp.at(i)->GetSpLayer() == layer)
+        {
+          busy += m_sp.at(i)->GetSpStop() - m_sp.at(i)->GetSpStart();
+        }
+    }
+  return busy.GetSeconds () / m_biDuration.GetSeconds ();
+}
+
 } // namespace ns3
 
@@ -76,9 +76,31 @@ public:
   /* Set whether the station itself is transmitting during the SP*/
   void SetSpIfTx(bool);
 
+  /* Set whether no link planned by the controller interferes with the
+   * exchanges of this SP, in either direction */
+  void SetSpIsolated (bool isolated);
+  /* Return true if no link interferes with the exchanges of this SP */
+  bool GetSpIsolated (void);
+
+  /* Set the layer of this SP: the SPs of a layer, on all the nodes, are
+   * links that the controller allows to be active at the same time */
+  void SetSpLayer (uint32_t layer);
+  /* Return the layer of this SP (0 if the schedule has a single layer) */
+  uint32_t GetSpLayer (void);
+
+  /* Set whether this SP is the end of a split SP reserved to the reverse
+   * direction of the flow (e.g. the TCP ACKs) */
+  void SetSpAck (bool ack);
+  /* Return true if this SP is reserved to the reverse direction of the flow */
+  bool GetSpAck (void);
+
   void SetBeamSwitchOverhead (Time beamSwitchOverhead);
   //Time GetBeamSwitchOverhead (void);
 
+  /* Return true if sp describes the same Service Period (times, destination,
+   * flow and direction) */
+  bool IsEqual (Ptr<DmgServicePeriod> sp);
+
 private:
   /* Start time of this Serive Period. The start time is relative to the
    * beginning of the current Beacon Interval */
@@ -89,6 +111,12 @@ private:
   Time m_spStop;
   /* Get whether the station itself is transmitting or receving in the SP -----added on 20 Jan*/
   bool m_spTransmitter;
+  /* No planned link interferes with this SP */
+  bool m_spIsolated;
+  /* The SP carries the reverse direction of the flow */
+  bool m_spAck;
+  /* Layer of the concurrent schedule this SP belongs to */
+  uint32_t m_spLayer;
 
   /* MAC address of the *NEXT HOP* destination of this Service Period */
   Mac48Address m_spDestination;
@@ -126,8 +154,16 @@ public:
    * this Beacon Interval do not overlap to each other.
    * -----------------------------------The last attribut 'bool transmitt' is added on 20 Jan*/
   void AddSp (Time start, Time stop, Mac48Address dest, Ipv4Address srcIpv4 ,Ipv4Address sinkIpv4, Ptr<MobilityModel> mob, bool transmitt );
+  void AddSp (Ptr<DmgServicePeriod> sp);
   /* Erase all the Service Periods of this beacon Interval */
   void EraseSp ();
+  /* Replace all the Service Periods of this Beacon Interval with sps at the
+   * beginning of the next Beacon Interval, so that the current one completes
+   * with the old schedule. A later call before that time supersedes the
+   * pending one. Return false, and schedule nothing, when sps is the list of
+   * Service Periods already in use.
+   */
+  bool ScheduleSpUpdate (std::vector<Ptr<DmgServicePeriod> > sps);
 
   /* The following methods return the absolute start and end times of the SP +
    * the destination MAC.
@@ -153,6 +189,11 @@ public:
   Mac48Address GetNextTxSpDestination (void);
   std::pair <Ipv4Address, Ipv4Address> GetNextTxSpSrcSinkIpv4Address (void);
   Ptr<MobilityModel> GetNextTxSpDestinationMobility (void);
+  /* Return true if no link interferes with the next (or current) Tx SP */
+  bool GetNextTxSpIsolated (void);
+  /* Return true if the next (or current) Tx SP is reserved to the reverse
+   * direction of its flow */
+  bool GetNextTxSpAck (void);
     
   /* Return the destination MAC address of the next (or current if the service period is not
    * finished yet) service period.
@@ -162,11 +203,25 @@ public:
    * finished yet) service period.
    */
   Ptr<MobilityModel> GetNextSpDestinationMobility (void);
+  /* Return the Ipv4 addresses of the source and sink of the flow of the next
+   * (or current if the service period is not finished yet) service period.
+   */
+  std::pair <Ipv4Address, Ipv4Address> GetNextSpSrcSinkIpv4Address (void);
   /* Return the vector of all the Service Period associated with this Beacon
    * Interval
    */
   std::vector<Ptr<DmgServicePeriod> > GetSps(void);
 
+  /* Return the number of layers of the Service Periods of this Beacon
+   * Interval. The layers are concurrent across the network; on a single
+   * node their Service Periods never overlap, since the node has a single
+   * beam.
+   */
+  uint32_t GetNLayers (void);
+  /* Return the fraction of this Beacon Interval covered by the Service
+   * Periods of layer */
+  double GetLayerUtilization (uint32_t layer);
+
   /* A beacon Interval knows the antenna controller of the node.
    * This is useful to force antenna alignment at the beginning of each service
    * period.
@@ -182,6 +237,31 @@ public:
 private:
   /* used by ScheduleNextAntennaAlignment */
   void AlignAntenna();
+  /* used by ScheduleSpUpdate */
+  void ApplySpUpdate (void);
+
+  /* Sorted view of (a subset of) the Service Periods of this Beacon Interval.
+   * It answers "which is the first SP, in the order SPs were added, that
+   * stops after a given BI-relative time" with a binary search on the stop
+   * times instead of a walk of m_sp.
+   */
+  struct SpTimeline
+  {
+    /* Stop times (relative to the BI start) sorted in ascending order */
+    std::vector<Time> stops;
+    /* first[k] is the lowest index in m_sp among the SPs whose stop time is
+     * stops[k] or later */
+    std::vector<uint32_t> first;
+  };
+  /* Build the timeline of all the SPs or of the TX SPs only */
+  void BuildTimeline (bool txOnly, SpTimeline &timeline);
+  /* Rebuild both timelines. Called lazily after AddSp/EraseSp */
+  void BuildTimelines (void);
+  /* Find the next (or current) SP. Return false if there is no such SP
+   * (i.e. there is no TX SP when txOnly is true). index is the position of
+   * the SP in m_sp and biStart the absolute start time of the BI it belongs to.
+   */
+  bool FindNextSp (bool txOnly, uint32_t &index, Time &biStart);
 
   /* Duration of this Beacon Interval */
   Time m_biDuration;
@@ -199,6 +279,21 @@ private:
   bool m_initialized;
   Time m_beamSwitchOverhead;
 
+  /* Service Periods installed at the beginning of the next Beacon Interval */
+  std::vector<Ptr<DmgServicePeriod> > m_pendingSp;
+  EventId m_spUpdate;
+
+  /* SP timelines, rebuilt when the list of SPs changes */
+  SpTimeline m_allSpTimeline;
+  SpTimeline m_txSpTimeline;
+  bool m_timelinesValid;
+  /* Result of the last lookup for each timeline (0: all SPs, 1: TX SPs),
+   * reused by the queries issued at the same simulation time */
+  bool m_lookupValid[2];
+  Time m_lookupTime[2];
+  uint32_t m_lookupIndex[2];
+  Time m_lookupBiStart[2];
+
 };
 
 } // namespace ns3
@@ -0,0 +1,260 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+#include "dmg-channel-planner.h"
+#include "ns3/assert.h"
+#include <algorithm>
+
+namespace ns3 {
+
+DmgChannelPlanner::DmgChannelPlanner ()
+  : m_nChannels (1),
+    m_nIterations (8)
+{
+}
+
+void
+DmgChannelPlanner::Clear (void)
+{
+  m_radios.clear ();
+  m_nodeLinks.clear ();
+  m_links.clear ();
+}
+
+void
+DmgChannelPlanner::SetNChannels (uint32_t n)
+{
+  NS_ASSERT (n > 0);
+  m_nChannels = n;
+}
+
+uint32_t
+DmgChannelPlanner::GetNChannels (void) const
+{
+  return m_nChannels;
+}
+
+void
+DmgChannelPlanner::SetNNodes (uint32_t n)
+{
+  // 0 radios: as many as the channels
+  m_radios.resize (n, 0);
+  m_nodeLinks.resize (n);
+}
+
+void
+DmgChannelPlanner::SetNodeRadios (uint32_t node, uint32_t radios)
+{
+  NS_ASSERT (node < m_radios.size () && radios > 0);
+  m_radios[node] = radios;
+}
+
+uint32_t
+DmgChannelPlanner::AddLink (uint32_t a, uint32_t b, double load)
+{
+  NS_ASSERT (a < m_nodeLinks.size () && b < m_nodeLinks.size () && a != b);
+  Link link;
+  link.a = a;
+  link.b = b;
+  link.load = load;
+  link.channel = 0;
+  m_links.push_back (link);
+  m_nodeLinks[a].push_back (m_links.size () - 1);
+  m_nodeLinks[b].push_back (m_links.size () - 1);
+  return m_links.size () - 1;
+}
+
+uint32_t
+DmgChannelPlanner::GetNLinks (void) const
+{
+  return m_links.size ();
+}
+
+void
+DmgChannelPlanner::AddConflict (uint32_t i, uint32_t j)
+{
+  NS_ASSERT (i < m_links.size () && j < m_links.size ());
+  if (i == j)
+    {
+      return;
+    }
+  m_links[i].interferers.push_back (j);
+  m_links[j].interferers.push_back (i);
+}
+
+void
+DmgChannelPlanner::SetNIterations (uint32_t n)
+{
+  m_nIterations = n;
+}
+
+std::vector<std::vector<uint32_t> >
+DmgChannelPlanner::GetConflicts (void) const
+{
+  std::vector<std::vector<uint32_t> > conflicts (m_links.size ());
+  for (uint32_t i = 0; i < m_links.size (); i++)
+    {
+      std::vector<uint32_t> &c = conflicts[i];
+      c = m_links[i].interferers;
+      c.insert (c.end (), m_nodeLinks[m_links[i].a].begin (), m_nodeLinks[m_links[i].a].end ());
+      c.insert (c.end (), m_nodeLinks[m_links[i].b].begin (), m_nodeLinks[m_links[i].b].end ());
+      std::sort (c.begin (), c.end ());
+      c.erase (std::unique (c.begin (), c.end ()), c.end ());
+      c.erase (std::remove (c.begin (), c.end (), i), c.end ());
+    }
+  return conflicts;
+}
+
+std::vector<double>
+DmgChannelPlanner::GetChannelCosts (const std::vector<uint32_t> &conflicts, const std::vector<bool> &colored) const
+{
+  std::vector<double> costs (m_nChannels, 0);
+  for (uint32_t k = 0; k < conflicts.size (); k++)
+    {
+      if (colored[conflicts[k]])
+        {
+          costs[m_links[conflicts[k]].channel] += m_links[conflicts[k]].load;
+        }
+    }
+  return costs;
+}
+
+bool
+DmgChannelPlanner::CanUse (uint32_t node, uint32_t channel, const std::vector<bool> &colored, uint32_t skip) const
+{
+  uint32_t radios = m_radios[node] == 0 ? m_nChannels : m_radios[node];
+  std::vector<bool> used (m_nChannels, false);
+  uint32_t usedN = 0;
+  for (uint32_t k = 0; k < m_nodeLinks[node].size (); k++)
+    {
+      uint32_t l = m_nodeLinks[node][k];
+      if (l == skip || !colored[l] || used[m_links[l].channel])
+        {
+          continue;
+        }
+      used[m_links[l].channel] = true;
+      usedN++;
+    }
+  return used[channel] || usedN < radios;
+}
+
+bool
+DmgChannelPlanner::Assign (void)
+{
+  std::vector<std::vector<uint32_t> > conflicts = GetConflicts ();
+  std::vector<bool> colored (m_links.size (), false);
+  for (uint32_t i = 0; i < m_links.size (); i++)
+    {
+      std::vector<double> costs = GetChannelCosts (conflicts[i], colored);
+      int32_t best = -1;
+      for (uint32_t c = 0; c < m_nChannels; c++)
+        {
+          if (CanUse (m_links[i].a, c, colored, i) && CanUse (m_links[i].b, c, colored, i)
+              && (best < 0 || costs[c] < costs[best]))
+            {
+              best = c;
+            }
+        }
+      if (best < 0)
+        {
+          // No radio left at one of the nodes: take a channel of the other
+          for (uint32_t c = 0; c < m_nChannels; c++)
+            {
+              if ((CanUse (m_links[i].a, c, colored, i) || CanUse (m_links[i].b, c, colored, i))
+                  && (best < 0 || costs[c] < costs[best]))
+                {
+                  best = c;
+                }
+            }
+        }
+      m_links[i].channel = best < 0 ? 0 : best;
+      colored[i] = true;
+    }
+
+  for (uint32_t it = 0; it < m_nIterations; it++)
+    {
+      bool moved = false;
+      for (uint32_t i = 0; i < m_links.size (); i++)
+        {
+          std::vector<double> costs = GetChannelCosts (conflicts[i], colored);
+          uint32_t best = m_links[i].channel;
+          for (uint32_t c = 0; c < m_nChannels; c++)
+            {
+              if (costs[c] < costs[best] && CanUse (m_links[i].a, c, colored, i)
+                  && CanUse (m_links[i].b, c, colored, i))
+                {
+                  best = c;
+                }
+            }
+          moved |= best != m_links[i].channel;
+          m_links[i].channel = best;
+        }
+      if (!moved)
+        {
+          break;
+        }
+    }
+
+  for (uint32_t node = 0; node < m_nodeLinks.size (); node++)
+    {
+      uint32_t radios = m_radios[node] == 0 ? m_nChannels : m_radios[node];
+      if (GetNodeChannels (node).size () > radios)
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+uint32_t
+DmgChannelPlanner::GetChannel (uint32_t link) const
+{
+  NS_ASSERT (link < m_links.size ());
+  return m_links[link].channel;
+}
+
+std::vector<uint32_t>
+DmgChannelPlanner::GetNodeChannels (uint32_t node) const
+{
+  NS_ASSERT (node < m_nodeLinks.size ());
+  std::vector<uint32_t> channels;
+  for (uint32_t k = 0; k < m_nodeLinks[node].size (); k++)
+    {
+      channels.push_back (m_links[m_nodeLinks[node][k]].channel);
+    }
+  std::sort (channels.begin (), channels.end ());
+  channels.erase (std::unique (channels.begin (), channels.end ()), channels.end ());
+  return channels;
+}
+
+double
+DmgChannelPlanner::GetMaxConflictLoad (void) const
+{
+  std::vector<std::vector<uint32_t> > conflicts = GetConflicts ();
+  std::vector<bool> colored (m_links.size (), true);
+  double maxLoad = 0;
+  for (uint32_t i = 0; i < m_links.size (); i++)
+    {
+      double load = m_links[i].load + GetChannelCosts (conflicts[i], colored)[m_links[i].channel];
+      maxLoad = std::max (maxLoad, load);
+    }
+  return maxLoad;
+}
+
+} // namespace ns3
@@ -0,0 +1,107 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+#ifndef DMG_CHANNEL_PLANNER_H
+#define DMG_CHANNEL_PLANNER_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/* Assigns a channel to every link of a mesh network.
+ *
+ * Two links conflict when they share a node or when they have been declared
+ * interfering: on the same channel they must share the airtime, on
+ * different channels they do not. Every node has a number of radios, one
+ * per channel it can use, so the links of a node span at most that many
+ * channels.
+ *
+ * The links are colored greedily in the order they were added: each one
+ * gets, among the channels that both its nodes can still use, the one with
+ * the lowest load (airtime fraction) of the conflicting links already
+ * colored. Adding the links from the gateways outwards, every link finds a
+ * radio at its new node, so a forest never runs out of radios. Then every
+ * link is moved, in turn, to its channel with the lowest conflicting load,
+ * until no move lowers it: each move lowers the sum over the co-channel
+ * conflicting pairs of the product of their loads.
+ */
+class DmgChannelPlanner
+{
+public:
+  DmgChannelPlanner ();
+
+  /* Remove the nodes and links */
+  void Clear (void);
+  /* Number of channels. Default 1 */
+  void SetNChannels (uint32_t n);
+  uint32_t GetNChannels (void) const;
+  void SetNNodes (uint32_t n);
+  /* Number of channels node can use at once. Default: all of them */
+  void SetNodeRadios (uint32_t node, uint32_t radios);
+  /* Add a link between nodes a and b busy for a fraction load of the
+   * time. Return its index */
+  uint32_t AddLink (uint32_t a, uint32_t b, double load);
+  uint32_t GetNLinks (void) const;
+  /* Declare that links i and j interfere with each other */
+  void AddConflict (uint32_t i, uint32_t j);
+  /* Maximum number of passes moving the links. Default 8 */
+  void SetNIterations (uint32_t n);
+
+  /* Assign the channels. Return false if some link got a channel one of
+   * its nodes has no radio left for */
+  bool Assign (void);
+  /* Return the channel of link, in [0, GetNChannels ()) */
+  uint32_t GetChannel (uint32_t link) const;
+  /* Return the channels used by the links of node, sorted */
+  std::vector<uint32_t> GetNodeChannels (uint32_t node) const;
+  /* Return the largest load of a link plus the loads of the links it
+   * conflicts with on its channel */
+  double GetMaxConflictLoad (void) const;
+
+private:
+  struct Link
+  {
+    uint32_t a;
+    uint32_t b;
+    double load;
+    /* Links declared interfering with this one */
+    std::vector<uint32_t> interferers;
+    uint32_t channel;
+  };
+
+  /* Return the links conflicting with each link, sorted */
+  std::vector<std::vector<uint32_t> > GetConflicts (void) const;
+  /* Load of the colored links of conflicts on every channel */
+  std::vector<double> GetChannelCosts (const std::vector<uint32_t> &conflicts,
+                                       const std::vector<bool> &colored) const;
+  /* Whether node can use channel: it already does for another link than
+   * skip, or it has a radio left */
+  bool CanUse (uint32_t node, uint32_t channel, const std::vector<bool> &colored, uint32_t skip) const;
+
+  uint32_t m_nChannels;
+  uint32_t m_nIterations;
+  std::vector<uint32_t> m_radios;
+  std::vector<std::vector<uint32_t> > m_nodeLinks;
+  std::vector<Link> m_links;
+};
+
+} // namespace ns3
+
+#endif /* DMG_CHANNEL_PLANNER_H */
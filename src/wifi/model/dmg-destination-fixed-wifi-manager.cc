@@ -56,7 +56,8 @@ WifiRemoteStation *
 DmgDestinationFixedWifiManager::DoCreateStation (void) const
 {
   NS_LOG_FUNCTION (this);
-  WifiRemoteStation *station = new WifiRemoteStation ();
+  DmgDestinationFixedWifiRemoteStation *station = new DmgDestinationFixedWifiRemoteStation ();
+  station->m_nodeId = UNKNOWN_NODE_ID;
   return station;
 }
 
@@ -109,10 +110,47 @@ WifiTxVector
 DmgDestinationFixedWifiManager::DoGetDataTxVector (WifiRemoteStation *st, uint32_t size)
 {
   NS_LOG_FUNCTION (this << st << size);
-  std::map<Mac48Address, WifiMode>::iterator it =
-	  m_modePerDestination.find(st->m_state->m_address);
-  NS_ASSERT(it != m_modePerDestination.end());
-  WifiMode mode = it->second;
+  return MakeDataTxVector (st, GetStationWifiMode (st));
+}
+
+uint32_t
+DmgDestinationFixedWifiManager::GetStationNodeId (WifiRemoteStation *st)
+{
+  DmgDestinationFixedWifiRemoteStation *station = (DmgDestinationFixedWifiRemoteStation *) st;
+  if (station->m_nodeId == UNKNOWN_NODE_ID)
+    {
+      std::map<Mac48Address, uint32_t>::const_iterator it = m_nodePerAddress.find (st->m_state->m_address);
+      if (it != m_nodePerAddress.end ())
+        {
+          station->m_nodeId = it->second;
+        }
+    }
+  return station->m_nodeId;
+}
+
+bool
+DmgDestinationFixedWifiManager::HasStationWifiMode (WifiRemoteStation *st)
+{
+  return HasDestinationWifiMode (GetStationNodeId (st))
+         || m_modePerAddress.find (st->m_state->m_address) != m_modePerAddress.end ();
+}
+
+WifiMode
+DmgDestinationFixedWifiManager::GetStationWifiMode (WifiRemoteStation *st)
+{
+  uint32_t nodeId = GetStationNodeId (st);
+  if (HasDestinationWifiMode (nodeId))
+    {
+      return m_modePerNode[nodeId];
+    }
+  std::map<Mac48Address, WifiMode>::const_iterator it = m_modePerAddress.find (st->m_state->m_address);
+  NS_ASSERT_MSG (it != m_modePerAddress.end (), "No mode for destination " << st->m_state->m_address);
+  return it->second;
+}
+
+WifiTxVector
+DmgDestinationFixedWifiManager::MakeDataTxVector (WifiRemoteStation *st, WifiMode mode)
+{
   return WifiTxVector (mode, GetDefaultTxPowerLevel (), GetLongRetryCount (st),
 		       GetShortGuardInterval (st),
 		       Min (GetNumberOfReceiveAntennas (st),
@@ -148,34 +186,76 @@ DmgDestinationFixedWifiManager::IsLowLatency (void) const
 }
 
 void
-DmgDestinationFixedWifiManager::AddDestinationWifiMode (Mac48Address mac, WifiMode mode)
+DmgDestinationFixedWifiManager::AddDestinationWifiMode (uint32_t nodeId, Mac48Address mac, WifiMode mode)
 {
-  std::map<Mac48Address, WifiMode>::iterator it =
-	  m_modePerDestination.find(mac);
-
-  if (it != m_modePerDestination.end()) {
-    m_modePerDestination.erase(it);
-  }
+  NS_LOG_FUNCTION (this << nodeId << mac << mode);
+  // The address of a node never changes, so the node IDs cached by the
+  // stations stay valid
+  std::pair<std::map<Mac48Address, uint32_t>::iterator, bool> ret =
+    m_nodePerAddress.insert (std::make_pair (mac, nodeId));
+  NS_ASSERT_MSG (ret.first->second == nodeId, "MAC address " << mac << " already used by node " << ret.first->second);
+  m_modePerAddress.erase (mac);
+  if (nodeId >= m_modePerNode.size ())
+    {
+      m_modePerNode.resize (nodeId + 1);
+      m_hasMode.resize (nodeId + 1, false);
+    }
+  m_modePerNode[nodeId] = mode;
+  m_hasMode[nodeId] = true;
+}
 
-  m_modePerDestination.insert(
-	std::pair<Mac48Address, WifiMode>(mac, mode));
+void
+DmgDestinationFixedWifiManager::AddDestinationWifiMode (Mac48Address mac, WifiMode mode)
+{
+  NS_LOG_FUNCTION (this << mac << mode);
+  std::map<Mac48Address, uint32_t>::const_iterator it = m_nodePerAddress.find (mac);
+  if (it != m_nodePerAddress.end ())
+    {
+      AddDestinationWifiMode (it->second, mac, mode);
+    }
+  else
+    {
+      m_modePerAddress[mac] = mode;
+    }
 }
 //----------------------------added on 17.02.2016 Edinburgh
 WifiMode
-DmgDestinationFixedWifiManager::GetDestinationWifiMode (Mac48Address mac)
+DmgDestinationFixedWifiManager::GetDestinationWifiMode (uint32_t nodeId) const
 {
-    std::map<Mac48Address, WifiMode>::iterator it =
-    m_modePerDestination.find(mac);
-    
-    NS_ASSERT(it != m_modePerDestination.end());
+  NS_ASSERT_MSG (HasDestinationWifiMode (nodeId), "No mode for node " << nodeId);
+  return m_modePerNode[nodeId];
+}
 
-    return m_modePerDestination.at(mac);
+bool
+DmgDestinationFixedWifiManager::HasDestinationWifiMode (uint32_t nodeId) const
+{
+  return nodeId < m_hasMode.size () && m_hasMode[nodeId];
+}
+
+WifiMode
+DmgDestinationFixedWifiManager::GetDestinationWifiMode (Mac48Address mac) const
+{
+  std::map<Mac48Address, WifiMode>::const_iterator it = m_modePerAddress.find (mac);
+  if (it != m_modePerAddress.end ())
+    {
+      return it->second;
+    }
+  return GetDestinationWifiMode (GetDestinationNodeId (mac));
 } //----------------------------added on 17.02.2016 Edinburgh
 
 void
 DmgDestinationFixedWifiManager::DeleteDestinationsMap (void)
 {
-  m_modePerDestination.clear();
+  m_hasMode.assign (m_hasMode.size (), false);
+  m_modePerAddress.clear ();
+}
+
+uint32_t
+DmgDestinationFixedWifiManager::GetDestinationNodeId (Mac48Address mac) const
+{
+  std::map<Mac48Address, uint32_t>::const_iterator it = m_nodePerAddress.find (mac);
+  NS_ASSERT_MSG (it != m_nodePerAddress.end (), "Unknown destination " << mac);
+  return it->second;
 }
 
 } // namespace ns3
@@ -24,12 +24,16 @@
 
 #include "wifi-remote-station-manager.h"
 #include <map>
+#include <vector>
 #include "ns3/mac48-address.h"
 
 namespace ns3 {
 
-/* This WifiManager maintains a maps that associates to each possible mac
- * destination address an MCS
+/* This WifiManager associates to each possible destination an MCS.
+ * Destinations are identified by node ID: the modes are kept in a dense
+ * array indexed by node ID, and each remote station remembers the node ID
+ * of its address, so looking up the mode of a frame costs no search.
+ * Destinations added by MAC address only are looked up by address.
  */
 class DmgDestinationFixedWifiManager : public WifiRemoteStationManager
 {
@@ -38,18 +42,46 @@ public:
   DmgDestinationFixedWifiManager ();
   virtual ~DmgDestinationFixedWifiManager ();
 
-  /* Add a destination MAC address and associated with the the WifiMode mode
-   * Every frame transmitted to mac will be transmitted with the WifiMode mode.*/
+  /* Associate the WifiMode mode to the destination node nodeId, whose MAC
+   * address is mac. Every frame transmitted to mac will be transmitted with
+   * the WifiMode mode.*/
+  void AddDestinationWifiMode (uint32_t nodeId, Mac48Address mac, WifiMode mode);
+  /* As above, for the destination mac. If mac was not added before with its
+   * node ID, the mode is kept by address until it is */
   void AddDestinationWifiMode (Mac48Address mac, WifiMode mode);
     
   //----------------------------added on 17.02.2016 Edinburgh
   /* a simple utility function that can return the WifiMode that is employed 
    between a node and its destination*/
-  WifiMode GetDestinationWifiMode (Mac48Address mac);
+  WifiMode GetDestinationWifiMode (uint32_t nodeId) const;
+  WifiMode GetDestinationWifiMode (Mac48Address mac) const;
   //----------------------------added on 17.02.2016 Edinburgh
-  /* Delete all the pairs destination MAC - WifiMode */
+  /* Delete all the pairs destination - WifiMode */
   void DeleteDestinationsMap (void);
 
+protected:
+  /* Node ID of the destination, resolved the first time a frame is sent
+   * to it */
+  struct DmgDestinationFixedWifiRemoteStation : public WifiRemoteStation
+  {
+    uint32_t m_nodeId;
+  };
+
+  /* Return the node ID of the destination of station, UNKNOWN_NODE_ID if
+   * no mode was associated to its address yet */
+  uint32_t GetStationNodeId (WifiRemoteStation *station);
+  /* Return true if a WifiMode was associated to nodeId */
+  bool HasDestinationWifiMode (uint32_t nodeId) const;
+  /* Return true if a WifiMode was associated to the destination of station,
+   * by node ID or by address */
+  bool HasStationWifiMode (WifiRemoteStation *station);
+  /* Return the WifiMode associated to the destination of station */
+  WifiMode GetStationWifiMode (WifiRemoteStation *station);
+  /* Return the WifiTxVector used to send data to station with mode */
+  WifiTxVector MakeDataTxVector (WifiRemoteStation *station, WifiMode mode);
+
+  static const uint32_t UNKNOWN_NODE_ID = 0xffffffff;
+
 private:
   // overriden from base class
   virtual WifiRemoteStation* DoCreateStation (void) const;
@@ -77,8 +109,17 @@ private:
                                          reqMode);
 
 
-  /* WifiMode map. Associated a WifiMode to each MAC destination address */
-  std::map<Mac48Address, WifiMode> m_modePerDestination;
+  /* Return the node ID of the destination mac, added before */
+  uint32_t GetDestinationNodeId (Mac48Address mac) const;
+
+  /* WifiMode of each destination, indexed by node ID */
+  std::vector<WifiMode> m_modePerNode;
+  std::vector<bool> m_hasMode;
+  /* Node ID of each MAC destination address. Only used by the stations to
+   * find their node ID the first time they send */
+  std::map<Mac48Address, uint32_t> m_nodePerAddress;
+  /* WifiMode of the destinations added without node ID */
+  std::map<Mac48Address, WifiMode> m_modePerAddress;
 
 };
 
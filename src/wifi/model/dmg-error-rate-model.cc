@@ -0,0 +1,274 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "dmg-error-rate-model.h"
+#include "wifi-phy.h"
+
+#include "ns3/double.h"
+#include "ns3/assert.h"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("DmgErrorRateModel");
+
+NS_OBJECT_ENSURE_REGISTERED (DmgErrorRateModel);
+
+/* Coded bits of an 802.11ad LDPC codeword */
+static const double LDPC_CODEWORD_BITS = 672;
+/* Reference of the receiver sensitivity: PER of 1% for a 4096 bytes PSDU */
+static const double SENSITIVITY_PER = 0.01;
+static const double SENSITIVITY_PSDU_BITS = 4096 * 8;
+/* Noise figure plus implementation loss assumed by the sensitivities */
+static const double SENSITIVITY_MARGIN_DB = 15;
+/* Spacing of the points of the curves */
+static const double CURVE_STEP_DB = 0.1;
+/* The curves go from CURVE_LOW to CURVE_HIGH standard deviations of the
+ * waterfall around its center: a codeword error rate from 1 - 3e-7 to 6e-16 */
+static const double CURVE_LOW = -5;
+static const double CURVE_HIGH = 8;
+
+/* Receiver sensitivity (dBm) of each DMG MCS, as used by the
+ * SensitivityModel60GHz. The LDPC rate is the code rate of the mode, but
+ * for the modes with code rate 1/4 that repeat twice the coded bits of a
+ * rate 1/2 code */
+struct DmgMcsSensitivity
+{
+  const char *name;
+  double sensitivityDbm;
+};
+
+static const DmgMcsSensitivity DMG_MCS_SENSITIVITIES[] = {
+  /* Control PHY */
+  {"VHTMCS0", -78},
+  /* SC PHY */
+  {"VHTMCS1", -68}, {"VHTMCS2", -67}, {"VHTMCS3", -65}, {"VHTMCS4", -64},
+  {"VHTMCS5", -62}, {"VHTMCS6", -63}, {"VHTMCS7", -62}, {"VHTMCS8", -61},
+  {"VHTMCS9", -59}, {"VHTMCS10", -55}, {"VHTMCS11", -54}, {"VHTMCS12", -53},
+  /* Extrapolated SC PHY */
+  {"VHTMCS13", -52}, {"VHTMCS14", -50}, {"VHTMCS15", -48}, {"VHTMCS16", -46},
+  {"VHTMCS17", -42}, {"VHTMCS18", -40},
+  /* OFDM PHY */
+  {"VHTMCS13a", -66}, {"VHTMCS14a", -64}, {"VHTMCS15a", -63}, {"VHTMCS16a", -62},
+  {"VHTMCS17a", -60}, {"VHTMCS18a", -58}, {"VHTMCS19a", -56}, {"VHTMCS20a", -54},
+  {"VHTMCS21a", -53}, {"VHTMCS22a", -51}, {"VHTMCS23a", -49}, {"VHTMCS24a", -47},
+};
+
+static double
+GetCodeRate (enum WifiCodeRate rate)
+{
+  switch (rate)
+    {
+    case WIFI_CODE_RATE_1_4:
+      return 1.0 / 4;
+    case WIFI_CODE_RATE_1_2:
+      return 1.0 / 2;
+    case WIFI_CODE_RATE_5_8:
+      return 5.0 / 8;
+    case WIFI_CODE_RATE_3_4:
+      return 3.0 / 4;
+    case WIFI_CODE_RATE_13_16:
+      return 13.0 / 16;
+    default:
+      NS_FATAL_ERROR ("Not an 802.11ad code rate");
+      return 1;
+    }
+}
+
+/* Standard deviation (dB) of the waterfall of the codeword error rate:
+ * the higher rates have steeper curves */
+static double
+GetWaterfallWidthDb (double ldpcRate)
+{
+  return ldpcRate < 0.6 ? 0.45 : ldpcRate < 0.7 ? 0.4 : 0.35;
+}
+
+/* Gaussian tail function */
+static double
+Q (double x)
+{
+  return 0.5 * erfc (x / std::sqrt (2.0));
+}
+
+/* Inverse of Q for 0 < p < 0.5, by bisection */
+static double
+InverseQ (double p)
+{
+  double low = 0;
+  double high = 40;
+  while (high - low > 1e-12)
+    {
+      double middle = (low + high) / 2;
+      if (Q (middle) > p)
+        {
+          low = middle;
+        }
+      else
+        {
+          high = middle;
+        }
+    }
+  return high;
+}
+
+TypeId
+DmgErrorRateModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DmgErrorRateModel")
+    .SetParent<ErrorRateModel> ()
+    .AddConstructor<DmgErrorRateModel> ()
+    .AddAttribute ("Margin",
+                   "SNR (dB) the AWGN curves are shifted by. The default is the noise figure and implementation loss assumed by the 802.11ad receiver sensitivities.",
+                   DoubleValue (SENSITIVITY_MARGIN_DB),
+                   MakeDoubleAccessor (&DmgErrorRateModel::m_marginDb),
+                   MakeDoubleChecker<double> ())
+  ;
+  return tid;
+}
+
+DmgErrorRateModel::DmgErrorRateModel ()
+{
+  NS_LOG_FUNCTION (this);
+  BuildCurves ();
+}
+
+DmgErrorRateModel::~DmgErrorRateModel ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+DmgErrorRateModel::BuildCurves (void)
+{
+  uint32_t n = sizeof (DMG_MCS_SENSITIVITIES) / sizeof (DMG_MCS_SENSITIVITIES[0]);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      WifiMode mode = WifiMode (DMG_MCS_SENSITIVITIES[i].name);
+      double modeRate = GetCodeRate (mode.GetCodeRate ());
+      double ldpcRate = modeRate == 1.0 / 4 ? 1.0 / 2 : modeRate;
+      Curve curve;
+      curve.bitsPerCodeword = LDPC_CODEWORD_BITS * ldpcRate / modeRate;
+
+      // AWGN SNR of the sensitivity, and codeword error rate giving the
+      // PER of the sensitivity over the codewords of its PSDU
+      double noiseDbm = 10 * std::log10 (1.3803e-23 * 290.0 * mode.GetBandwidth ()) + 30;
+      double snrDb = DMG_MCS_SENSITIVITIES[i].sensitivityDbm - noiseDbm - SENSITIVITY_MARGIN_DB;
+      double codewords = SENSITIVITY_PSDU_BITS / (LDPC_CODEWORD_BITS * ldpcRate);
+      double cwer = 1 - std::pow (1 - SENSITIVITY_PER, 1 / codewords);
+      double width = GetWaterfallWidthDb (ldpcRate);
+      double centerDb = snrDb - width * InverseQ (cwer);
+
+      // The sensitivity is a point of the curve, so the thresholds of the
+      // 802.11ad sensitivities are exact
+      uint32_t below = (uint32_t) std::ceil ((snrDb - centerDb - CURVE_LOW * width) / CURVE_STEP_DB);
+      curve.startDb = snrDb - below * CURVE_STEP_DB;
+      uint32_t points = below + (uint32_t) std::ceil ((centerDb + CURVE_HIGH * width - snrDb) / CURVE_STEP_DB) + 1;
+      for (uint32_t j = 0; j < points; j++)
+        {
+          double x = (curve.startDb + j * CURVE_STEP_DB - centerDb) / width;
+          curve.logCwsr.push_back (x > 0 ? log1p (-Q (x)) : std::log (Q (-x)));
+        }
+      NS_LOG_DEBUG (mode << ": " << curve.bitsPerCodeword << " bits per codeword, 1% PER of 4096 bytes at "
+                    << snrDb << " dB, " << points << " points from " << curve.startDb << " dB");
+
+      uint32_t uid = mode.GetUid ();
+      if (uid >= m_curves.size ())
+        {
+          m_curves.resize (uid + 1);
+        }
+      m_curves[uid] = curve;
+    }
+}
+
+const DmgErrorRateModel::Curve &
+DmgErrorRateModel::GetCurve (WifiMode mode) const
+{
+  uint32_t uid = mode.GetUid ();
+  NS_ABORT_MSG_IF (uid >= m_curves.size () || m_curves[uid].logCwsr.empty (),
+                   "DmgErrorRateModel has no curve for " << mode);
+  return m_curves[uid];
+}
+
+double
+DmgErrorRateModel::GetLogCwsr (const Curve &curve, double snrDb) const
+{
+  double x = (snrDb - m_marginDb - curve.startDb) / CURVE_STEP_DB;
+  uint32_t last = curve.logCwsr.size () - 1;
+  if (x <= 0)
+    {
+      return curve.logCwsr[0];
+    }
+  if (x >= last)
+    {
+      return curve.logCwsr[last];
+    }
+  uint32_t i = (uint32_t) x;
+  double f = x - i;
+  return (1 - f) * curve.logCwsr[i] + f * curve.logCwsr[i + 1];
+}
+
+double
+DmgErrorRateModel::GetChunkSuccessRate (WifiMode mode, double snr, uint32_t nbits) const
+{
+  NS_LOG_FUNCTION (this << mode << snr << nbits);
+  if (nbits == 0)
+    {
+      return 1.0;
+    }
+  if (snr <= 0)
+    {
+      return 0.0;
+    }
+  const Curve &curve = GetCurve (mode);
+  return std::exp (nbits / curve.bitsPerCodeword * GetLogCwsr (curve, 10 * std::log10 (snr)));
+}
+
+double
+DmgErrorRateModel::GetCodewordErrorRate (WifiMode mode, double snrDb) const
+{
+  return -expm1 (GetLogCwsr (GetCurve (mode), snrDb));
+}
+
+double
+DmgErrorRateModel::GetSnrDb (WifiMode mode, double per, uint32_t nbits) const
+{
+  NS_ASSERT (per > 0 && per < 1 && nbits > 0);
+  const Curve &curve = GetCurve (mode);
+  // The log of the codeword success rate grows with the SNR: find the
+  // first point reaching the one of per
+  double target = log1p (-per) * curve.bitsPerCodeword / nbits;
+  std::vector<double>::const_iterator it = std::lower_bound (curve.logCwsr.begin (), curve.logCwsr.end (), target);
+  if (it == curve.logCwsr.begin ())
+    {
+      return curve.startDb + m_marginDb;
+    }
+  if (it == curve.logCwsr.end ())
+    {
+      return curve.startDb + (curve.logCwsr.size () - 1) * CURVE_STEP_DB + m_marginDb;
+    }
+  uint32_t i = it - curve.logCwsr.begin () - 1;
+  double f = (target - curve.logCwsr[i]) / (curve.logCwsr[i + 1] - curve.logCwsr[i]);
+  return curve.startDb + (i + f) * CURVE_STEP_DB + m_marginDb;
+}
+
+} // namespace ns3
@@ -0,0 +1,89 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+#ifndef DMG_ERROR_RATE_MODEL_H
+#define DMG_ERROR_RATE_MODEL_H
+
+#include <stdint.h>
+#include <vector>
+#include "wifi-mode.h"
+#include "error-rate-model.h"
+
+namespace ns3 {
+
+/* Error rate model of the 802.11ad control, SC and OFDM PHYs.
+ *
+ * Every MCS carries an AWGN curve of the error rate of its LDPC codewords
+ * (672 coded bits) versus the SNR. A chunk succeeds if all the codewords
+ * it spans do, so its success rate is the codeword success rate raised to
+ * the number of codewords, counted from the coded bits of the chunk, the
+ * LDPC rate and the repetition of the mode.
+ *
+ * The curves have the waterfall of a short LDPC code, placed so that a
+ * 4096 bytes PSDU has a PER of 1% at the 802.11ad receiver sensitivity of
+ * the MCS. They are stored as the logarithm of the codeword success rate
+ * every 0.1 dB and interpolated linearly, so a lookup costs a logarithm
+ * and an exponential. The sensitivities assume a noise figure of 10 dB
+ * and an implementation loss of 5 dB: the curves are shifted by Margin,
+ * by default that 15 dB, for the PHYs without noise figure. Use 0 with a
+ * PHY that models its own noise figure.
+ *
+ * GetSnrDb inverts the curves: the DmgMcsTable of a PHY with this model
+ * reads its thresholds from it, so the controller and the rate managers
+ * choose the modes with the same curves the receivers use.
+ */
+class DmgErrorRateModel : public ErrorRateModel
+{
+public:
+  static TypeId GetTypeId (void);
+
+  DmgErrorRateModel ();
+  virtual ~DmgErrorRateModel ();
+
+  virtual double GetChunkSuccessRate (WifiMode mode, double snr, uint32_t nbits) const;
+
+  /* Return the lowest SNR (dB) at which a chunk of nbits coded bits sent
+   * with mode has at most the error rate per */
+  double GetSnrDb (WifiMode mode, double per, uint32_t nbits) const;
+  /* Return the error rate of an LDPC codeword of mode at snrDb */
+  double GetCodewordErrorRate (WifiMode mode, double snrDb) const;
+
+private:
+  struct Curve
+  {
+    double startDb;             // SNR of the first point, without margin
+    double bitsPerCodeword;     // coded bits of the mode per LDPC codeword
+    std::vector<double> logCwsr; // log of the codeword success rate
+  };
+
+  /* Build the curves of all the DMG modes */
+  void BuildCurves (void);
+  /* Return the curve of mode */
+  const Curve & GetCurve (WifiMode mode) const;
+  /* Return the interpolated log of the codeword success rate of curve at snrDb */
+  double GetLogCwsr (const Curve &curve, double snrDb) const;
+
+  double m_marginDb;
+  /* Curve of each mode, indexed by mode UID. Empty for the non DMG modes */
+  std::vector<Curve> m_curves;
+};
+
+} // namespace ns3
+
+#endif /* DMG_ERROR_RATE_MODEL_H */
@@ -0,0 +1,336 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+#include "dmg-layer-scheduler.h"
+#include "dmg-airtime-allocator.h"
+#include "ns3/assert.h"
+#include <algorithm>
+
+namespace ns3 {
+
+namespace {
+
+/* Coloring order: busier nodes first, then more airtime, then more
+ * conflicts, then lower index */
+struct LinkOrder
+{
+  const std::vector<uint64_t> *loads;
+  const std::vector<uint64_t> *durations;
+  const std::vector<std::vector<uint32_t> > *conflicts;
+
+  bool operator() (uint32_t i, uint32_t j) const
+  {
+    if ((*loads)[i] != (*loads)[j])
+      {
+        return (*loads)[i] > (*loads)[j];
+      }
+    if ((*durations)[i] != (*durations)[j])
+      {
+        return (*durations)[i] > (*durations)[j];
+      }
+    if ((*conflicts)[i].size () != (*conflicts)[j].size ())
+      {
+        return (*conflicts)[i].size () > (*conflicts)[j].size ();
+      }
+    return i < j;
+  }
+};
+
+}
+
+DmgLayerScheduler::DmgLayerScheduler ()
+  : m_nLayers (0),
+    m_scheduleNs (0)
+{
+}
+
+void
+DmgLayerScheduler::Clear (void)
+{
+  m_links.clear ();
+  m_nLayers = 0;
+  m_scheduleNs = 0;
+}
+
+uint32_t
+DmgLayerScheduler::AddLink (uint32_t a, uint32_t b, uint64_t durationNs)
+{
+  Link link;
+  link.a = a;
+  link.b = b;
+  link.durationNs = durationNs;
+  link.layer = 0;
+  link.unplacedNs = 0;
+  m_links.push_back (link);
+  return m_links.size () - 1;
+}
+
+void
+DmgLayerScheduler::AddConflict (uint32_t i, uint32_t j)
+{
+  NS_ASSERT (i < m_links.size () && j < m_links.size ());
+  if (i == j)
+    {
+      return;
+    }
+  m_links[i].interferers.push_back (j);
+  m_links[j].interferers.push_back (i);
+}
+
+std::vector<std::vector<uint32_t> >
+DmgLayerScheduler::GetConflicts (bool interferers) const
+{
+  std::vector<std::vector<uint32_t> > conflicts (m_links.size ());
+  for (uint32_t i = 0; i < m_links.size (); i++)
+    {
+      if (interferers)
+        {
+          conflicts[i] = m_links[i].interferers;
+        }
+      for (uint32_t j = 0; j < m_links.size (); j++)
+        {
+          if (j != i
+              && (m_links[j].a == m_links[i].a || m_links[j].a == m_links[i].b
+                  || m_links[j].b == m_links[i].a || m_links[j].b == m_links[i].b))
+            {
+              conflicts[i].push_back (j);
+            }
+        }
+      std::sort (conflicts[i].begin (), conflicts[i].end ());
+      conflicts[i].erase (std::unique (conflicts[i].begin (), conflicts[i].end ()), conflicts[i].end ());
+    }
+  return conflicts;
+}
+
+std::vector<uint32_t>
+DmgLayerScheduler::GetOrder (const std::vector<std::vector<uint32_t> > &conflicts) const
+{
+  // Airtime of the links of each node
+  std::vector<uint64_t> nodeLoads;
+  for (uint32_t i = 0; i < m_links.size (); i++)
+    {
+      nodeLoads.resize (std::max ((uint32_t) nodeLoads.size (), std::max (m_links[i].a, m_links[i].b) + 1), 0);
+      nodeLoads[m_links[i].a] += m_links[i].durationNs;
+      nodeLoads[m_links[i].b] += m_links[i].durationNs;
+    }
+  std::vector<uint64_t> loads (m_links.size ());
+  std::vector<uint64_t> durations (m_links.size ());
+  std::vector<uint32_t> order (m_links.size ());
+  for (uint32_t i = 0; i < m_links.size (); i++)
+    {
+      loads[i] = std::max (nodeLoads[m_links[i].a], nodeLoads[m_links[i].b]);
+      durations[i] = m_links[i].durationNs;
+      order[i] = i;
+    }
+  LinkOrder less;
+  less.loads = &loads;
+  less.durations = &durations;
+  less.conflicts = &conflicts;
+  std::sort (order.begin (), order.end (), less);
+  return order;
+}
+
+uint64_t
+DmgLayerScheduler::Place (uint32_t i, const std::vector<uint32_t> &conflicts,
+                          const std::vector<bool> &placed, uint64_t timeNeeded)
+{
+  Link &link = m_links[i];
+  DmgAirtimeAllocator timeAvailable;
+  timeAvailable.Release (0, m_scheduleNs);
+  for (uint32_t s = 0; s < link.sps.size (); s++)
+    {
+      timeAvailable.Reserve (link.sps[s].first, link.sps[s].first + link.sps[s].second);
+    }
+  for (uint32_t c = 0; c < conflicts.size (); c++)
+    {
+      const Link &other = m_links[conflicts[c]];
+      for (uint32_t s = 0; placed[conflicts[c]] && s < other.sps.size (); s++)
+        {
+          timeAvailable.Reserve (other.sps[s].first, other.sps[s].first + other.sps[s].second);
+        }
+    }
+
+  uint64_t gapStart, gapStop;
+  // In one piece if possible, otherwise sliced over the first gaps
+  if (timeNeeded && timeAvailable.FirstFit (timeNeeded, gapStart, gapStop))
+    {
+      link.sps.push_back (std::make_pair (gapStart, timeNeeded));
+      return 0;
+    }
+  while (timeNeeded && timeAvailable.FirstFit (1, gapStart, gapStop))
+    {
+      uint64_t durNs = std::min (timeNeeded, gapStop - gapStart);
+      link.sps.push_back (std::make_pair (gapStart, durNs));
+      timeAvailable.Reserve (gapStart, gapStart + durNs);
+      timeNeeded -= durNs;
+    }
+  return timeNeeded;
+}
+
+bool
+DmgLayerScheduler::Schedule (uint64_t scheduleNs)
+{
+  m_scheduleNs = scheduleNs;
+  m_nLayers = 0;
+  std::vector<std::vector<uint32_t> > conflicts = GetConflicts (true);
+  std::vector<uint32_t> order = GetOrder (conflicts);
+
+  // Greedy coloring: the lowest layer not used by a conflicting link
+  std::vector<bool> colored (m_links.size (), false);
+  for (uint32_t k = 0; k < order.size (); k++)
+    {
+      uint32_t i = order[k];
+      m_links[i].layer = 0;
+      if (m_links[i].durationNs == 0)
+        {
+          // Without airtime a link constrains no other one
+          continue;
+        }
+      std::vector<bool> used (m_nLayers + 1, false);
+      for (uint32_t c = 0; c < conflicts[i].size (); c++)
+        {
+          if (colored[conflicts[i][c]])
+            {
+              used[m_links[conflicts[i][c]].layer] = true;
+            }
+        }
+      uint32_t layer = 0;
+      while (used[layer])
+        {
+          layer++;
+        }
+      m_links[i].layer = layer;
+      m_nLayers = std::max (m_nLayers, layer + 1);
+      colored[i] = true;
+    }
+
+  // Placement in coloring order. The airtime that does not fit around the
+  // conflicting links is placed around the links sharing a node only
+  std::vector<std::vector<uint32_t> > nodeConflicts = GetConflicts (false);
+  bool fits = true;
+  std::vector<bool> placed (m_links.size (), false);
+  for (uint32_t k = 0; k < order.size (); k++)
+    {
+      uint32_t i = order[k];
+      m_links[i].sps.clear ();
+      uint64_t timeNeeded = Place (i, conflicts[i], placed, m_links[i].durationNs);
+      m_links[i].unplacedNs = Place (i, nodeConflicts[i], placed, timeNeeded);
+      fits = fits && m_links[i].unplacedNs == 0;
+      placed[i] = true;
+    }
+  return fits;
+}
+
+uint32_t
+DmgLayerScheduler::GetNLinks (void) const
+{
+  return m_links.size ();
+}
+
+uint32_t
+DmgLayerScheduler::GetNLayers (void) const
+{
+  return m_nLayers;
+}
+
+uint32_t
+DmgLayerScheduler::GetLayer (uint32_t link) const
+{
+  return m_links.at (link).layer;
+}
+
+const std::vector<std::pair<uint64_t, uint64_t> > &
+DmgLayerScheduler::GetSps (uint32_t link) const
+{
+  return m_links.at (link).sps;
+}
+
+uint64_t
+DmgLayerScheduler::GetUnplacedNs (uint32_t link) const
+{
+  return m_links.at (link).unplacedNs;
+}
+
+uint64_t
+DmgLayerScheduler::GetBusyTime (const std::vector<uint32_t> &links) const
+{
+  // The union of the SPs is the free time of an allocator releasing them
+  DmgAirtimeAllocator busy;
+  for (uint32_t i = 0; i < links.size (); i++)
+    {
+      const Link &link = m_links[links[i]];
+      for (uint32_t s = 0; s < link.sps.size (); s++)
+        {
+          busy.Release (link.sps[s].first, link.sps[s].first + link.sps[s].second);
+        }
+    }
+  return busy.GetFreeTime ();
+}
+
+double
+DmgLayerScheduler::GetLayerUtilization (uint32_t layer) const
+{
+  if (m_scheduleNs == 0)
+    {
+      return 0;
+    }
+  uint64_t airtime = 0;
+  for (uint32_t i = 0; i < m_links.size (); i++)
+    {
+      if (m_links[i].layer == layer)
+        {
+          airtime += m_links[i].durationNs - m_links[i].unplacedNs;
+        }
+    }
+  return (double) airtime / m_scheduleNs;
+}
+
+double
+DmgLayerScheduler::GetLayerOccupancy (uint32_t layer) const
+{
+  if (m_scheduleNs == 0)
+    {
+      return 0;
+    }
+  std::vector<uint32_t> links;
+  for (uint32_t i = 0; i < m_links.size (); i++)
+    {
+      if (m_links[i].layer == layer)
+        {
+          links.push_back (i);
+        }
+    }
+  return (double) GetBusyTime (links) / m_scheduleNs;
+}
+
+double
+DmgLayerScheduler::GetConcurrency (void) const
+{
+  std::vector<uint32_t> links;
+  uint64_t airtime = 0;
+  for (uint32_t i = 0; i < m_links.size (); i++)
+    {
+      links.push_back (i);
+      airtime += m_links[i].durationNs - m_links[i].unplacedNs;
+    }
+  uint64_t busy = GetBusyTime (links);
+  return busy ? (double) airtime / busy : 0;
+}
+
+} // namespace ns3
@@ -0,0 +1,118 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+#ifndef DMG_LAYER_SCHEDULER_H
+#define DMG_LAYER_SCHEDULER_H
+
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+namespace ns3 {
+
+/* Packs the airtime of a set of links into concurrent layers.
+ *
+ * Two links conflict when they share a node (a node has a single beam and
+ * is half duplex) or when they have been declared interfering. The conflict
+ * graph is colored greedily, so that the links of a layer (a color) can all
+ * be active at the same time. The links of the busiest nodes are colored
+ * first, since their airtime is the hardest to fit.
+ *
+ * The links are then placed in the same order: each one gets the first
+ * free airtime of the schedule not used by the placed links it conflicts
+ * with, sliced over several gaps if needed, so the links of different
+ * layers overlap in time wherever they do not conflict. Interference is a
+ * soft conflict: the airtime that does not fit around the interferers is
+ * placed around the links sharing a node only.
+ */
+class DmgLayerScheduler
+{
+public:
+  DmgLayerScheduler ();
+
+  /* Remove all the links and their schedule */
+  void Clear (void);
+  /* Add a link between nodes a and b that needs durationNs of airtime.
+   * Return its index */
+  uint32_t AddLink (uint32_t a, uint32_t b, uint64_t durationNs);
+  /* Declare that links i and j interfere with each other */
+  void AddConflict (uint32_t i, uint32_t j);
+
+  /* Color the conflict graph and place the airtime of the links in
+   * [0, scheduleNs). Return false if the airtime of some link does not fit
+   */
+  bool Schedule (uint64_t scheduleNs);
+
+  /* Return the number of links */
+  uint32_t GetNLinks (void) const;
+  /* Return the number of layers of the last schedule */
+  uint32_t GetNLayers (void) const;
+  /* Return the layer of link */
+  uint32_t GetLayer (uint32_t link) const;
+  /* Return the (start, duration) of the SPs of link, in ns from the
+   * beginning of the schedule */
+  const std::vector<std::pair<uint64_t, uint64_t> > & GetSps (uint32_t link) const;
+  /* Return the airtime of link that does not fit in the schedule */
+  uint64_t GetUnplacedNs (uint32_t link) const;
+
+  /* Return the airtime of the SPs of layer over the duration of the
+   * schedule. It exceeds 1 when the links of the layer are concurrent */
+  double GetLayerUtilization (uint32_t layer) const;
+  /* Return the fraction of the schedule in which at least one link of layer
+   * is active */
+  double GetLayerOccupancy (uint32_t layer) const;
+  /* Return the airtime of all the SPs over the time in which at least one
+   * link is active: the average number of concurrent links */
+  double GetConcurrency (void) const;
+
+private:
+  struct Link
+  {
+    uint32_t a;
+    uint32_t b;
+    uint64_t durationNs;
+    /* Links declared interfering with this one */
+    std::vector<uint32_t> interferers;
+    uint32_t layer;
+    std::vector<std::pair<uint64_t, uint64_t> > sps;
+    uint64_t unplacedNs;
+  };
+
+  /* Return the links conflicting with each link: the links sharing a node,
+   * plus the interferers if interferers is true, sorted */
+  std::vector<std::vector<uint32_t> > GetConflicts (bool interferers) const;
+  /* Return the links in coloring order: the links of the busiest node
+   * first, then more airtime, then more conflicts, then lower index */
+  std::vector<uint32_t> GetOrder (const std::vector<std::vector<uint32_t> > &conflicts) const;
+  /* Place up to timeNeeded of airtime of link i in the time left free by
+   * the placed links of conflicts and by its own SPs. Return the airtime
+   * that does not fit */
+  uint64_t Place (uint32_t i, const std::vector<uint32_t> &conflicts,
+                  const std::vector<bool> &placed, uint64_t timeNeeded);
+  /* Return the time in which at least one of the SPs of links is active */
+  uint64_t GetBusyTime (const std::vector<uint32_t> &links) const;
+
+  std::vector<Link> m_links;
+  uint32_t m_nLayers;
+  uint64_t m_scheduleNs;
+};
+
+} // namespace ns3
+
+#endif /* DMG_LAYER_SCHEDULER_H */
@@ -0,0 +1,185 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+#include "dmg-mcs-table.h"
+#include "yans-wifi-phy.h"
+#include "error-rate-model.h"
+#include "dmg-error-rate-model.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <cmath>
+
+NS_LOG_COMPONENT_DEFINE ("DmgMcsTable");
+
+namespace ns3 {
+
+/* Sensitivity reference of 802.11ad: PER below 1% for a 4096 bytes PSDU */
+static const uint32_t SENSITIVITY_PSDU_BYTES = 4096;
+static const double SENSITIVITY_PER = 0.01;
+
+static bool
+CompareEntries (const std::pair<double, WifiMode> &a, const std::pair<double, WifiMode> &b)
+{
+  if (a.first != b.first)
+    {
+      return a.first < b.first;
+    }
+  return a.second.GetDataRate () > b.second.GetDataRate ();
+}
+
+DmgMcsTable::DmgMcsTable ()
+  : m_fallback (WifiPhy::GetVHTMCS0 ()),
+    m_noiseFloorDbm (0)
+{
+}
+
+void
+DmgMcsTable::Build (Ptr<YansWifiPhy> phy)
+{
+  Build (phy, SENSITIVITY_PER, SENSITIVITY_PSDU_BYTES);
+}
+
+void
+DmgMcsTable::Build (Ptr<YansWifiPhy> phy, double per, uint32_t psduBytes)
+{
+  m_thresholdsDb.clear ();
+  m_modes.clear ();
+  Ptr<ErrorRateModel> errorModel = phy->GetErrorRateModel ();
+  NS_ASSERT (errorModel != 0);
+  Ptr<DmgErrorRateModel> dmgModel = DynamicCast<DmgErrorRateModel> (errorModel);
+  enum WifiModulationClass modClass = phy->GetDmgOfdm () ? WIFI_MOD_CLASS_VHT_OFDM : WIFI_MOD_CLASS_VHT_SC;
+
+  std::vector<std::pair<double, WifiMode> > entries;
+  for (uint32_t i = 0; i < phy->GetNModes (); i++)
+    {
+      WifiMode mode = phy->GetMode (i);
+      if (mode.GetModulationClass () != modClass)
+        {
+          continue;
+        }
+      if (dmgModel != 0)
+        {
+          // The receivers see the coded bits of the PSDU
+          uint32_t codedBits = (uint64_t) psduBytes * 8 * mode.GetPhyRate () / mode.GetDataRate ();
+          entries.push_back (std::make_pair (dmgModel->GetSnrDb (mode, per, codedBits), mode));
+          continue;
+        }
+      // Bisection on the SNR in dB. The PER of the error rate models is
+      // monotonic in the SNR, and high ends up at the lowest SNR known to
+      // meet the target
+      double low = -50;
+      double high = 100;
+      while (high - low > 1e-9)
+        {
+          double middle = (low + high) / 2;
+          double psr = errorModel->GetChunkSuccessRate (mode, std::pow (10.0, middle / 10), psduBytes * 8);
+          if (psr >= 1 - per)
+            {
+              high = middle;
+            }
+          else
+            {
+              low = middle;
+            }
+        }
+      entries.push_back (std::make_pair (high, mode));
+    }
+
+  std::sort (entries.begin (), entries.end (), CompareEntries);
+  uint64_t bestRate = 0;
+  for (uint32_t i = 0; i < entries.size (); i++)
+    {
+      if (entries[i].second.GetDataRate () <= bestRate)
+        {
+          NS_LOG_DEBUG ("Dropping " << entries[i].second.GetUniqueName () << ": a faster mode needs no more SNR");
+          continue;
+        }
+      bestRate = entries[i].second.GetDataRate ();
+      m_thresholdsDb.push_back (entries[i].first);
+      m_modes.push_back (entries[i].second);
+      NS_LOG_DEBUG (entries[i].second.GetUniqueName () << " from " << entries[i].first << " dB");
+    }
+
+  double noiseW = 1.3803e-23 * 290.0 * m_fallback.GetBandwidth () * std::pow (10.0, phy->GetRxNoiseFigure () / 10);
+  m_noiseFloorDbm = 10 * std::log10 (noiseW) + 30;
+}
+
+WifiMode
+DmgMcsTable::Lookup (double snrDb) const
+{
+  int32_t i = GetIndex (snrDb);
+  if (i < 0)
+    {
+      return m_fallback;
+    }
+  return m_modes[i];
+}
+
+int32_t
+DmgMcsTable::GetIndex (double snrDb) const
+{
+  std::vector<double>::const_iterator it = std::upper_bound (m_thresholdsDb.begin (), m_thresholdsDb.end (), snrDb);
+  return (it - m_thresholdsDb.begin ()) - 1;
+}
+
+int32_t
+DmgMcsTable::FindMode (WifiMode mode) const
+{
+  for (uint32_t i = 0; i < m_modes.size (); i++)
+    {
+      if (m_modes[i] == mode)
+        {
+          return i;
+        }
+    }
+  return -1;
+}
+
+WifiMode
+DmgMcsTable::LookupRxPower (double rxPowerDbm) const
+{
+  return Lookup (rxPowerDbm - m_noiseFloorDbm);
+}
+
+uint32_t
+DmgMcsTable::GetNModes (void) const
+{
+  return m_modes.size ();
+}
+
+WifiMode
+DmgMcsTable::GetMode (uint32_t i) const
+{
+  return m_modes[i];
+}
+
+double
+DmgMcsTable::GetThresholdDb (uint32_t i) const
+{
+  return m_thresholdsDb[i];
+}
+
+double
+DmgMcsTable::GetNoiseFloorDbm (void) const
+{
+  return m_noiseFloorDbm;
+}
+
+} // namespace ns3
@@ -0,0 +1,81 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+#ifndef DMG_MCS_TABLE_H
+#define DMG_MCS_TABLE_H
+
+#include "ns3/ptr.h"
+#include "wifi-mode.h"
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+class YansWifiPhy;
+
+/* SNR thresholds of the DMG MCSs of a PHY flavour (SC or OFDM, with or
+ * without the extended rate modes), sorted in increasing order.
+ *
+ * The threshold of a mode is the lowest SNR at which the error rate model
+ * of the PHY gives a PER below a target, by default 1% for a 4096 bytes
+ * PSDU as the 802.11ad receiver sensitivity. Modes that need at least the
+ * SNR of a faster one are dropped, so the table is sorted by data rate too
+ * and the best mode for an SNR is found with a binary search. Below the
+ * first threshold the control mode (VHTMCS0) is returned.
+ */
+class DmgMcsTable
+{
+public:
+  DmgMcsTable ();
+
+  /* Build the table from the modes supported by phy and its error rate
+   * model. Only the modes of the modulation class selected by the
+   * "dmgOfdm" attribute are used */
+  void Build (Ptr<YansWifiPhy> phy);
+  /* As above, with the PER target per for PSDUs of psduBytes */
+  void Build (Ptr<YansWifiPhy> phy, double per, uint32_t psduBytes);
+
+  /* Return the fastest mode that can be received at snrDb */
+  WifiMode Lookup (double snrDb) const;
+  /* Return the fastest mode that can be received at rxPowerDbm, without
+   * interference */
+  WifiMode LookupRxPower (double rxPowerDbm) const;
+
+  /* Return the index of the fastest mode that can be received at snrDb,
+   * -1 if there is none */
+  int32_t GetIndex (double snrDb) const;
+  /* Return the index of mode, -1 if it is not in the table */
+  int32_t FindMode (WifiMode mode) const;
+
+  uint32_t GetNModes (void) const;
+  WifiMode GetMode (uint32_t i) const;
+  double GetThresholdDb (uint32_t i) const;
+  /* Return the thermal noise plus noise figure of the PHY, in dBm */
+  double GetNoiseFloorDbm (void) const;
+
+private:
+  std::vector<double> m_thresholdsDb;
+  std::vector<WifiMode> m_modes;
+  WifiMode m_fallback;
+  double m_noiseFloorDbm;
+};
+
+} // namespace ns3
+
+#endif /* DMG_MCS_TABLE_H */
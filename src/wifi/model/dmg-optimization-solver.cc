@@ -18,10 +18,36 @@
  * Author: Nicolo' Facchi <nicolo.facchi@gmail.com>
  */
 #include "dmg-optimization-solver.h"
+#include "ns3/log.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/system-wall-clock-ms.h"
+#include <cmath>
+#include <limits>
+
+NS_LOG_COMPONENT_DEFINE ("DmgOptimizationSolver");
 
 namespace ns3 {
 
+NS_OBJECT_ENSURE_REGISTERED (DmgOptimizationSolver);
+NS_OBJECT_ENSURE_REGISTERED (DmgProgressiveFillingSolver);
+NS_OBJECT_ENSURE_REGISTERED (DmgWaterFillingSolver);
+NS_OBJECT_ENSURE_REGISTERED (DmgSimplexSolver);
+
+/* Relative tolerance used to decide that a demand is met or a clique saturated */
+static const double SOLVER_EPSILON = 1e-9;
+
+TypeId
+DmgOptimizationSolver::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DmgOptimizationSolver")
+    .SetParent<Object> ()
+    ;
+  return tid;
+}
+
 DmgOptimizationSolver::DmgOptimizationSolver ()
+  : m_lastSolveTimeMs (0)
 {
 }
 
@@ -29,6 +55,454 @@ DmgOptimizationSolver::~DmgOptimizationSolver ()
 {
 }
 
+std::vector <double>
+DmgOptimizationSolver::Solve (const std::vector <double> &flowsDmd,
+                              const std::vector <Clique> &cliques)
+{
+  NS_LOG_FUNCTION (this << flowsDmd.size () << cliques.size ());
+  for (uint32_t cIdx = 0; cIdx < cliques.size (); cIdx++)
+    {
+      NS_ASSERT (cliques[cIdx].flows.size () == cliques[cIdx].capacity.size ());
+      for (uint32_t segIdx = 0; segIdx < cliques[cIdx].flows.size (); segIdx++)
+        {
+          NS_ASSERT (cliques[cIdx].flows[segIdx] < flowsDmd.size ());
+        }
+    }
+
+  SystemWallClockMs clock;
+  clock.Start ();
+  std::vector <double> flowsRate = DoSolve (flowsDmd, cliques);
+  m_lastSolveTimeMs = clock.End ();
 
-} // namespace ns3
+  NS_LOG_INFO (GetInstanceTypeId ().GetName () << " solved " << flowsDmd.size () << " flows, "
+               << cliques.size () << " cliques in " << m_lastSolveTimeMs << "ms");
+  return flowsRate;
+}
+
+int64_t
+DmgOptimizationSolver::GetLastSolveTimeMs (void) const
+{
+  return m_lastSolveTimeMs;
+}
+
+/* DmgProgressiveFillingSolver */
+
+TypeId
+DmgProgressiveFillingSolver::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DmgProgressiveFillingSolver")
+    .SetParent<DmgOptimizationSolver> ()
+    .AddConstructor<DmgProgressiveFillingSolver> ()
+    .AddAttribute ("StepLength",
+                   "Rate increment given to every unsatisfied flow at each step.",
+                   DoubleValue (0.001),
+                   MakeDoubleAccessor (&DmgProgressiveFillingSolver::m_stepLength),
+                   MakeDoubleChecker<double> (0.0))
+    ;
+  return tid;
+}
+
+DmgProgressiveFillingSolver::DmgProgressiveFillingSolver ()
+  : m_stepLength (0.001)
+{
+}
+
+DmgProgressiveFillingSolver::~DmgProgressiveFillingSolver ()
+{
+}
+
+std::vector <double>
+DmgProgressiveFillingSolver::DoSolve (const std::vector <double> &flowsDmd,
+                                      const std::vector <Clique> &cliques)
+{
+  NS_ASSERT_MSG (m_stepLength > 0, "StepLength must be positive");
+
+  std::vector <bool> ifActive (flowsDmd.size (), true);
+  std::vector <double> flowsRate (flowsDmd.size (), 0.0);
+  // Same precision as DmgAlmightyController::cliqueStruct::timeAlloc
+  std::vector < std::vector <float> > timeAlloc (cliques.size ());
+  for (uint32_t cIdx = 0; cIdx < cliques.size (); cIdx++)
+    {
+      timeAlloc[cIdx].resize (cliques[cIdx].flows.size (), 0);
+    }
+  // A flow crossing a segment without capacity (e.g. a link that is down)
+  // gets no rate
+  for (uint32_t cIdx = 0; cIdx < cliques.size (); cIdx++)
+    {
+      for (uint32_t segIdx = 0; segIdx < cliques[cIdx].flows.size (); segIdx++)
+        {
+          if (cliques[cIdx].capacity[segIdx] <= 0)
+            {
+              ifActive[cliques[cIdx].flows[segIdx]] = false;
+            }
+        }
+    }
+  uint32_t nActive = 0;
+  for (uint32_t fIdx = 0; fIdx < flowsDmd.size (); fIdx++)
+    {
+      nActive += ifActive[fIdx];
+    }
+
+  while (nActive != 0)
+    {
+      // for each active flow, increase the rate and check if demand is met
+      for (uint32_t fIdx = 0; fIdx < flowsDmd.size (); fIdx++)
+        {
+          if (ifActive[fIdx])
+            {
+              flowsRate[fIdx] = flowsRate[fIdx] + m_stepLength;
+              if (flowsRate[fIdx] >= flowsDmd[fIdx])
+                {
+                  ifActive[fIdx] = false;
+                  flowsRate[fIdx] = flowsDmd[fIdx];
+                  NS_LOG_INFO ("Flow " << fIdx << " is satisfied");
+                }
+            }
+        }
+
+      for (uint32_t cIdx = 0; cIdx < cliques.size (); cIdx++)
+        {
+          const Clique &clique = cliques[cIdx];
+          double timeSum = 0.0;
+          // time fraction = flowrate / capacity
+          for (uint32_t segIdx = 0; segIdx < clique.flows.size (); segIdx++)
+            {
+              if (clique.capacity[segIdx] <= 0)
+                {
+                  continue;
+                }
+              timeAlloc[cIdx][segIdx] = flowsRate[clique.flows[segIdx]] / clique.capacity[segIdx];
+              timeSum += timeAlloc[cIdx][segIdx];
+            }
+
+          if (timeSum >= 1.0)
+            {
+              // The clique is saturated: share the time left by the inactive
+              // flows equally (in rate) among the active ones and freeze them.
+              double timeLeft = 1.0;
+              double sum = 0.0;
+              for (uint32_t segIdx = 0; segIdx < clique.flows.size (); segIdx++)
+                {
+                  if (ifActive[clique.flows[segIdx]] == false)
+                    {
+                      timeLeft = timeLeft - timeAlloc[cIdx][segIdx];
+                    }
+                  else
+                    {
+                      sum = sum + 1.0 / (clique.capacity[segIdx]);
+                    }
+                }
+              double newRate = std::floor (timeLeft / sum * 10000.0) / 10000.0;
+              for (uint32_t segIdx = 0; segIdx < clique.flows.size (); segIdx++)
+                {
+                  if (ifActive[clique.flows[segIdx]] == true)
+                    {
+                      flowsRate[clique.flows[segIdx]] = newRate;
+                      timeAlloc[cIdx][segIdx] = newRate / (clique.capacity[segIdx]);
+                      ifActive[clique.flows[segIdx]] = false;
+                    }
+                }
+            }
+        }
+
+      nActive = 0;
+      for (uint32_t fIdx = 0; fIdx < flowsDmd.size (); fIdx++)
+        {
+          if (ifActive[fIdx] == true)
+            {
+              nActive++;
+            }
+        }
+    }
+  return flowsRate;
+}
+
+/* DmgWaterFillingSolver */
+
+TypeId
+DmgWaterFillingSolver::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DmgWaterFillingSolver")
+    .SetParent<DmgOptimizationSolver> ()
+    .AddConstructor<DmgWaterFillingSolver> ()
+    ;
+  return tid;
+}
 
+DmgWaterFillingSolver::DmgWaterFillingSolver ()
+{
+}
+
+DmgWaterFillingSolver::~DmgWaterFillingSolver ()
+{
+}
+
+std::vector <double>
+DmgWaterFillingSolver::DoSolve (const std::vector <double> &flowsDmd,
+                                const std::vector <Clique> &cliques)
+{
+  std::vector <double> flowsRate (flowsDmd.size (), 0.0);
+  std::vector <bool> frozen (flowsDmd.size (), false);
+  uint32_t nActive = flowsDmd.size ();
+
+  for (uint32_t fIdx = 0; fIdx < flowsDmd.size (); fIdx++)
+    {
+      if (flowsDmd[fIdx] <= 0)
+        {
+          frozen[fIdx] = true;
+          nActive--;
+        }
+    }
+  // A segment without capacity cannot carry its flow at all
+  for (uint32_t cIdx = 0; cIdx < cliques.size (); cIdx++)
+    {
+      for (uint32_t segIdx = 0; segIdx < cliques[cIdx].flows.size (); segIdx++)
+        {
+          uint32_t fIdx = cliques[cIdx].flows[segIdx];
+          if (cliques[cIdx].capacity[segIdx] <= 0 && !frozen[fIdx])
+            {
+              frozen[fIdx] = true;
+              nActive--;
+            }
+        }
+    }
+
+  std::vector <double> load (cliques.size ());
+  std::vector <double> weight (cliques.size ());
+  while (nActive != 0)
+    {
+      // Largest common increment allowed by the demands...
+      double delta = std::numeric_limits<double>::infinity ();
+      for (uint32_t fIdx = 0; fIdx < flowsDmd.size (); fIdx++)
+        {
+          if (!frozen[fIdx])
+            {
+              delta = std::min (delta, flowsDmd[fIdx] - flowsRate[fIdx]);
+            }
+        }
+      // ...and by the residual time of the cliques: load + delta * weight <= 1
+      for (uint32_t cIdx = 0; cIdx < cliques.size (); cIdx++)
+        {
+          const Clique &clique = cliques[cIdx];
+          load[cIdx] = 0;
+          weight[cIdx] = 0;
+          for (uint32_t segIdx = 0; segIdx < clique.flows.size (); segIdx++)
+            {
+              if (clique.capacity[segIdx] <= 0)
+                {
+                  continue;
+                }
+              load[cIdx] += flowsRate[clique.flows[segIdx]] / clique.capacity[segIdx];
+              if (!frozen[clique.flows[segIdx]])
+                {
+                  weight[cIdx] += 1.0 / clique.capacity[segIdx];
+                }
+            }
+          if (weight[cIdx] > 0)
+            {
+              delta = std::min (delta, (1.0 - load[cIdx]) / weight[cIdx]);
+            }
+        }
+      NS_ASSERT_MSG (delta != std::numeric_limits<double>::infinity (),
+                     "Unbounded flow: infinite demand and no clique");
+      delta = std::max (delta, 0.0);
+
+      for (uint32_t fIdx = 0; fIdx < flowsDmd.size (); fIdx++)
+        {
+          if (!frozen[fIdx])
+            {
+              flowsRate[fIdx] += delta;
+            }
+        }
+
+      // Freeze the flows crossing a saturated clique...
+      for (uint32_t cIdx = 0; cIdx < cliques.size (); cIdx++)
+        {
+          const Clique &clique = cliques[cIdx];
+          if (weight[cIdx] == 0 || load[cIdx] + delta * weight[cIdx] < 1.0 - SOLVER_EPSILON)
+            {
+              continue;
+            }
+          for (uint32_t segIdx = 0; segIdx < clique.flows.size (); segIdx++)
+            {
+              uint32_t fIdx = clique.flows[segIdx];
+              if (!frozen[fIdx])
+                {
+                  frozen[fIdx] = true;
+                  nActive--;
+                  NS_LOG_INFO ("Flow " << fIdx << " is bottlenecked by clique " << cIdx);
+                }
+            }
+        }
+      // ...and those whose demand is met
+      for (uint32_t fIdx = 0; fIdx < flowsDmd.size (); fIdx++)
+        {
+          if (!frozen[fIdx] && flowsRate[fIdx] >= flowsDmd[fIdx] * (1.0 - SOLVER_EPSILON))
+            {
+              flowsRate[fIdx] = flowsDmd[fIdx];
+              frozen[fIdx] = true;
+              nActive--;
+              NS_LOG_INFO ("Flow " << fIdx << " is satisfied");
+            }
+        }
+    }
+  return flowsRate;
+}
+
+/* DmgSimplexSolver */
+
+TypeId
+DmgSimplexSolver::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DmgSimplexSolver")
+    .SetParent<DmgOptimizationSolver> ()
+    .AddConstructor<DmgSimplexSolver> ()
+    .AddAttribute ("MaxIterations",
+                   "Maximum number of simplex pivots before giving up.",
+                   UintegerValue (100000),
+                   MakeUintegerAccessor (&DmgSimplexSolver::m_maxIterations),
+                   MakeUintegerChecker<uint32_t> ())
+    ;
+  return tid;
+}
+
+DmgSimplexSolver::DmgSimplexSolver ()
+  : m_maxIterations (100000)
+{
+}
+
+DmgSimplexSolver::~DmgSimplexSolver ()
+{
+}
+
+std::vector <double>
+DmgSimplexSolver::DoSolve (const std::vector <double> &flowsDmd,
+                           const std::vector <Clique> &cliques)
+{
+  uint32_t n = flowsDmd.size ();
+
+  // Constraints A x <= b with b >= 0: one row per clique, one row per
+  // finite demand. A segment without capacity forces its flow to 0.
+  std::vector < std::vector <double> > a;
+  std::vector <double> b;
+  std::vector <bool> blocked (n, false);
+  for (uint32_t cIdx = 0; cIdx < cliques.size (); cIdx++)
+    {
+      std::vector <double> row (n, 0.0);
+      for (uint32_t segIdx = 0; segIdx < cliques[cIdx].flows.size (); segIdx++)
+        {
+          if (cliques[cIdx].capacity[segIdx] <= 0)
+            {
+              blocked[cliques[cIdx].flows[segIdx]] = true;
+              continue;
+            }
+          row[cliques[cIdx].flows[segIdx]] += 1.0 / cliques[cIdx].capacity[segIdx];
+        }
+      a.push_back (row);
+      b.push_back (1.0);
+    }
+  for (uint32_t fIdx = 0; fIdx < n; fIdx++)
+    {
+      if (blocked[fIdx] || flowsDmd[fIdx] != std::numeric_limits<double>::infinity ())
+        {
+          std::vector <double> row (n, 0.0);
+          row[fIdx] = 1.0;
+          a.push_back (row);
+          b.push_back (blocked[fIdx] ? 0.0 : std::max (flowsDmd[fIdx], 0.0));
+        }
+    }
+  uint32_t m = a.size ();
+
+  // Tableau: m constraint rows plus the objective row, n structural
+  // columns, m slack columns and the right hand side.
+  uint32_t cols = n + m + 1;
+  std::vector < std::vector <double> > t (m + 1, std::vector <double> (cols, 0.0));
+  std::vector <uint32_t> basis (m);
+  for (uint32_t r = 0; r < m; r++)
+    {
+      for (uint32_t c = 0; c < n; c++)
+        {
+          t[r][c] = a[r][c];
+        }
+      t[r][n + r] = 1.0;
+      t[r][cols - 1] = b[r];
+      basis[r] = n + r;
+    }
+  for (uint32_t c = 0; c < n; c++)
+    {
+      t[m][c] = -1.0; // maximize the sum of the rates
+    }
+
+  uint32_t iteration = 0;
+  while (true)
+    {
+      // Bland's rule: lowest index entering column with negative reduced cost
+      uint32_t enter = cols;
+      for (uint32_t c = 0; c < cols - 1; c++)
+        {
+          if (t[m][c] < -SOLVER_EPSILON)
+            {
+              enter = c;
+              break;
+            }
+        }
+      if (enter == cols)
+        {
+          break; // optimal
+        }
+
+      uint32_t leave = m;
+      double bestRatio = std::numeric_limits<double>::infinity ();
+      for (uint32_t r = 0; r < m; r++)
+        {
+          if (t[r][enter] > SOLVER_EPSILON)
+            {
+              double ratio = t[r][cols - 1] / t[r][enter];
+              if (ratio < bestRatio - SOLVER_EPSILON
+                  || (ratio <= bestRatio + SOLVER_EPSILON && leave < m && basis[r] < basis[leave]))
+                {
+                  bestRatio = ratio;
+                  leave = r;
+                }
+            }
+        }
+      NS_ASSERT_MSG (leave != m, "Unbounded flow: infinite demand and no clique");
+
+      double pivot = t[leave][enter];
+      for (uint32_t c = 0; c < cols; c++)
+        {
+          t[leave][c] /= pivot;
+        }
+      for (uint32_t r = 0; r <= m; r++)
+        {
+          if (r != leave && t[r][enter] != 0)
+            {
+              double factor = t[r][enter];
+              for (uint32_t c = 0; c < cols; c++)
+                {
+                  t[r][c] -= factor * t[leave][c];
+                }
+            }
+        }
+      basis[leave] = enter;
+
+      if (++iteration >= m_maxIterations)
+        {
+          NS_LOG_WARN ("Simplex stopped after " << iteration << " pivots");
+          break;
+        }
+    }
+
+  std::vector <double> flowsRate (n, 0.0);
+  for (uint32_t r = 0; r < m; r++)
+    {
+      if (basis[r] < n)
+        {
+          flowsRate[basis[r]] = std::max (t[r][cols - 1], 0.0);
+        }
+    }
+  NS_LOG_INFO ("Total throughput " << t[m][cols - 1] << " after " << iteration << " pivots");
+  return flowsRate;
+}
+
+} // namespace ns3
@@ -21,21 +21,114 @@
 #define DMG_OPTIMIZATION_SOLVER_H
 
 #include "ns3/object.h"
+#include <vector>
 
 namespace ns3 {
 
-/* Dummy and unused class in the current implementation.
- * In future implementation this calss will be used by the DmgAlmightyController
- * to solve optimization problems for network resources optimization */
+/* Solver of the flow rate allocation problem used by the DmgAlmightyController.
+ * The problem is given as a demand per flow and a set of cliques. Within a
+ * clique only one link segment can be active at a time, so a clique is
+ * feasible when the sum over its segments of flowRate / segmentCapacity
+ * does not exceed 1.
+ * Subclasses implement DoSolve; Solve measures and records the time spent
+ * in DoSolve.
+ */
 class DmgOptimizationSolver : public Object
 {
 public:
+  static TypeId GetTypeId (void);
+
   DmgOptimizationSolver ();
 
   virtual ~DmgOptimizationSolver ();
 
+  /* A clique of the rate allocation problem.
+   * flows.at(s) is the flow carried by the link segment s, capacity.at(s)
+   * the equivalent PHY rate of that segment (same unit as the demands).
+   */
+  struct Clique
+  {
+    std::vector <uint32_t> flows;
+    std::vector <double> capacity;
+  };
+
+  /* Return the rate allocated to each flow. The returned rates never
+   * exceed the flow demands and satisfy every clique constraint.
+   */
+  std::vector <double> Solve (const std::vector <double> &flowsDmd,
+                              const std::vector <Clique> &cliques);
+
+  /* Wall clock time in milliseconds spent in the last call to Solve */
+  int64_t GetLastSolveTimeMs (void) const;
+
+private:
+  virtual std::vector <double> DoSolve (const std::vector <double> &flowsDmd,
+                                        const std::vector <Clique> &cliques) = 0;
+
+  int64_t m_lastSolveTimeMs;
+};
+
+/* The historical allocation of the controller: every unsatisfied flow is
+ * increased by StepLength until its demand is met or one of its cliques is
+ * saturated. Its cost grows with demand / StepLength and the result is only
+ * approximately max-min fair.
+ */
+class DmgProgressiveFillingSolver : public DmgOptimizationSolver
+{
+public:
+  static TypeId GetTypeId (void);
+
+  DmgProgressiveFillingSolver ();
+
+  virtual ~DmgProgressiveFillingSolver ();
+
+private:
+  virtual std::vector <double> DoSolve (const std::vector <double> &flowsDmd,
+                                        const std::vector <Clique> &cliques);
+
+  double m_stepLength;
+};
+
+/* Exact max-min fair allocation by water-filling. At each round all the
+ * unfrozen flows are raised by the largest common increment allowed by the
+ * demands and by the residual time of every clique, then the flows that
+ * reached their demand or that cross a saturated clique are frozen.
+ * Each round is O(flows x cliques) and at least one flow is frozen per round.
+ */
+class DmgWaterFillingSolver : public DmgOptimizationSolver
+{
+public:
+  static TypeId GetTypeId (void);
+
+  DmgWaterFillingSolver ();
+
+  virtual ~DmgWaterFillingSolver ();
+
+private:
+  virtual std::vector <double> DoSolve (const std::vector <double> &flowsDmd,
+                                        const std::vector <Clique> &cliques);
+};
+
+/* Throughput maximizing allocation: maximize the sum of the flow rates
+ * subject to the clique constraints and to rate <= demand, solved with a
+ * dense tableau simplex (Bland's rule). Max-min fairness is not enforced,
+ * flows can be starved.
+ */
+class DmgSimplexSolver : public DmgOptimizationSolver
+{
+public:
+  static TypeId GetTypeId (void);
+
+  DmgSimplexSolver ();
+
+  virtual ~DmgSimplexSolver ();
+
+private:
+  virtual std::vector <double> DoSolve (const std::vector <double> &flowsDmd,
+                                        const std::vector <Clique> &cliques);
 
- };
+  uint32_t m_maxIterations;
+};
 
 } // namespace ns3
 
@@ -0,0 +1,391 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+#include "dmg-route-planner.h"
+#include "ns3/assert.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+
+namespace ns3 {
+
+namespace {
+
+/* Label of a node in the widest path search: the rate (1 / airtime) of the
+ * slowest link from the gateway and the airtime of the path */
+struct WidestLabel
+{
+  double width;
+  double airtime;
+  uint32_t node;
+
+  /* Heap order: the widest, then the shortest on top. The airtime only
+   * orders the labels of the same width: unlike the width, it is not kept
+   * optimal along the paths */
+  bool operator< (const WidestLabel &o) const
+  {
+    if (width != o.width)
+      {
+        return width < o.width;
+      }
+    return airtime > o.airtime;
+  }
+};
+
+}
+
+DmgRoutePlanner::DmgRoutePlanner ()
+  : m_nLinks (0),
+    m_nIterations (8),
+    m_maxNodeLoad (0)
+{
+}
+
+void
+DmgRoutePlanner::Clear (void)
+{
+  m_arcs.clear ();
+  m_gateways.clear ();
+  m_nLinks = 0;
+  m_pred.clear ();
+  m_paths.clear ();
+  m_maxNodeLoad = 0;
+}
+
+void
+DmgRoutePlanner::SetNNodes (uint32_t n)
+{
+  m_arcs.resize (n);
+}
+
+uint32_t
+DmgRoutePlanner::GetNNodes (void) const
+{
+  return m_arcs.size ();
+}
+
+uint32_t
+DmgRoutePlanner::AddLink (uint32_t a, uint32_t b, double airtimeAb, double airtimeBa)
+{
+  NS_ASSERT (a < m_arcs.size () && b < m_arcs.size () && a != b);
+  NS_ASSERT (airtimeAb > 0 && airtimeBa > 0);
+  Arc arc;
+  arc.to = b;
+  arc.airtime = airtimeAb;
+  m_arcs[a].push_back (arc);
+  arc.to = a;
+  arc.airtime = airtimeBa;
+  m_arcs[b].push_back (arc);
+  return m_nLinks++;
+}
+
+uint32_t
+DmgRoutePlanner::GetNLinks (void) const
+{
+  return m_nLinks;
+}
+
+void
+DmgRoutePlanner::AddGateway (uint32_t node)
+{
+  NS_ASSERT (node < m_arcs.size ());
+  if (std::find (m_gateways.begin (), m_gateways.end (), node) == m_gateways.end ())
+    {
+      m_gateways.push_back (node);
+    }
+}
+
+void
+DmgRoutePlanner::SetNIterations (uint32_t n)
+{
+  NS_ASSERT (n > 0);
+  m_nIterations = n;
+}
+
+double
+DmgRoutePlanner::GetArcAirtime (uint32_t from, uint32_t to) const
+{
+  for (uint32_t i = 0; i < m_arcs[from].size (); i++)
+    {
+      if (m_arcs[from][i].to == to)
+        {
+          return m_arcs[from][i].airtime;
+        }
+    }
+  NS_ASSERT_MSG (false, "No link from " << from << " to " << to);
+  return 0;
+}
+
+void
+DmgRoutePlanner::Search (Metric metric, const std::vector<double> &weights, const std::vector<uint32_t> &treePred)
+{
+  uint32_t n = m_arcs.size ();
+  m_pred.resize (n);
+  for (uint32_t v = 0; v < n; v++)
+    {
+      m_pred[v] = v;
+    }
+  std::vector<bool> done (n, false);
+
+  if (metric == WIDEST_PATH)
+    {
+      std::vector<double> width (n, 0);
+      std::vector<double> airtime (n, std::numeric_limits<double>::infinity ());
+      std::priority_queue<WidestLabel> heap;
+      for (uint32_t g = 0; g < m_gateways.size (); g++)
+        {
+          WidestLabel label = {std::numeric_limits<double>::infinity (), 0, m_gateways[g]};
+          width[label.node] = label.width;
+          airtime[label.node] = 0;
+          heap.push (label);
+        }
+      while (!heap.empty ())
+        {
+          WidestLabel label = heap.top ();
+          heap.pop ();
+          if (done[label.node])
+            {
+              continue;
+            }
+          done[label.node] = true;
+          const std::vector<Arc> &arcs = m_arcs[label.node];
+          for (uint32_t i = 0; i < arcs.size (); i++)
+            {
+              WidestLabel next = {std::min (label.width, 1 / arcs[i].airtime),
+                                  label.airtime + arcs[i].airtime, arcs[i].to};
+              if (!done[next.node] && (next.width > width[next.node]
+                                       || (next.width == width[next.node] && next.airtime < airtime[next.node])))
+                {
+                  width[next.node] = next.width;
+                  airtime[next.node] = next.airtime;
+                  m_pred[next.node] = label.node;
+                  heap.push (next);
+                }
+            }
+        }
+      return;
+    }
+
+  typedef std::pair<double, uint32_t> Entry;
+  std::vector<double> cost (n, std::numeric_limits<double>::infinity ());
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > heap;
+  for (uint32_t g = 0; g < m_gateways.size (); g++)
+    {
+      cost[m_gateways[g]] = 0;
+      heap.push (std::make_pair (0.0, m_gateways[g]));
+    }
+  while (!heap.empty ())
+    {
+      uint32_t u = heap.top ().second;
+      heap.pop ();
+      if (done[u])
+        {
+          continue;
+        }
+      done[u] = true;
+      for (uint32_t i = 0; i < m_arcs[u].size (); i++)
+        {
+          const Arc &arc = m_arcs[u][i];
+          if (!treePred.empty () && treePred[arc.to] != arc.to && treePred[arc.to] != u)
+            {
+              // Already routed through another node
+              continue;
+            }
+          double c = cost[u] + arc.airtime * (weights.empty () ? 1 : 1 + weights[u] + weights[arc.to]);
+          if (!done[arc.to] && c < cost[arc.to])
+            {
+              cost[arc.to] = c;
+              m_pred[arc.to] = u;
+              heap.push (std::make_pair (c, arc.to));
+            }
+        }
+    }
+}
+
+bool
+DmgRoutePlanner::BuildPath (uint32_t sink, std::vector<uint32_t> &path) const
+{
+  NS_ASSERT (sink < m_arcs.size ());
+  path.clear ();
+  if (m_pred[sink] == sink)
+    {
+      // A gateway or a node out of reach
+      return false;
+    }
+  for (uint32_t v = sink; ; v = m_pred[v])
+    {
+      path.push_back (v);
+      if (m_pred[v] == v)
+        {
+          break;
+        }
+    }
+  std::reverse (path.begin (), path.end ());
+  return true;
+}
+
+bool
+DmgRoutePlanner::BuildPaths (const std::vector<uint32_t> &sinks)
+{
+  bool reached = true;
+  m_paths.assign (sinks.size (), std::vector<uint32_t> ());
+  for (uint32_t f = 0; f < sinks.size (); f++)
+    {
+      reached &= BuildPath (sinks[f], m_paths[f]);
+    }
+  return reached;
+}
+
+void
+DmgRoutePlanner::AddPathLoad (const std::vector<uint32_t> &path, double demand, std::vector<double> &loads) const
+{
+  for (uint32_t i = 0; i + 1 < path.size (); i++)
+    {
+      // Mb/s times ns/bit
+      double load = demand * GetArcAirtime (path[i], path[i + 1]) * 1e-3;
+      loads[path[i]] += load;
+      loads[path[i + 1]] += load;
+    }
+}
+
+std::vector<double>
+DmgRoutePlanner::GetNodeLoads (const std::vector<double> &demands) const
+{
+  std::vector<double> loads (m_arcs.size (), 0);
+  for (uint32_t f = 0; f < m_paths.size (); f++)
+    {
+      AddPathLoad (m_paths[f], demands.empty () ? 1 : demands[f], loads);
+    }
+  return loads;
+}
+
+bool
+DmgRoutePlanner::RouteFlowByFlow (const std::vector<uint32_t> &sinks, const std::vector<double> &demands,
+                                  const std::vector<double> &history)
+{
+  uint32_t n = m_arcs.size ();
+  // The largest demands are routed first
+  std::vector<std::pair<double, uint32_t> > order;
+  for (uint32_t f = 0; f < sinks.size (); f++)
+    {
+      order.push_back (std::make_pair (-(demands.empty () ? 1 : demands[f]), f));
+    }
+  std::stable_sort (order.begin (), order.end ());
+
+  std::vector<uint32_t> treePred (n);
+  for (uint32_t v = 0; v < n; v++)
+    {
+      treePred[v] = v;
+    }
+  std::vector<double> loads (n, 0);
+  std::vector<double> weights (n);
+  bool reached = true;
+  m_paths.assign (sinks.size (), std::vector<uint32_t> ());
+  for (uint32_t i = 0; i < order.size (); i++)
+    {
+      uint32_t f = order[i].second;
+      for (uint32_t v = 0; v < n; v++)
+        {
+          weights[v] = history[v] + loads[v];
+        }
+      Search (MIN_AIRTIME, weights, treePred);
+      if (!BuildPath (sinks[f], m_paths[f]))
+        {
+          reached = false;
+          continue;
+        }
+      for (uint32_t j = 1; j < m_paths[f].size (); j++)
+        {
+          treePred[m_paths[f][j]] = m_paths[f][j - 1];
+        }
+      AddPathLoad (m_paths[f], demands.empty () ? 1 : demands[f], loads);
+    }
+  m_pred = treePred;
+  return reached;
+}
+
+bool
+DmgRoutePlanner::Route (Metric metric, const std::vector<uint32_t> &sinks, const std::vector<double> &demands)
+{
+  NS_ASSERT (demands.empty () || demands.size () == sinks.size ());
+  NS_ASSERT_MSG (!m_gateways.empty (), "No gateway");
+  bool reached;
+  if (metric != CLIQUE_LOAD)
+    {
+      Search (metric, std::vector<double> (), std::vector<uint32_t> ());
+      reached = BuildPaths (sinks);
+      std::vector<double> loads = GetNodeLoads (demands);
+      m_maxNodeLoad = loads.empty () ? 0 : *std::max_element (loads.begin (), loads.end ());
+      return reached;
+    }
+
+  // The first routing is the minimum airtime one. The next ones route the
+  // flows one at a time, away from the nodes loaded by the flows already
+  // routed and by the previous routings (averaged to damp oscillations)
+  std::vector<double> history (m_arcs.size (), 0);
+  std::vector<std::vector<uint32_t> > bestPaths;
+  std::vector<uint32_t> bestPred;
+  double bestLoad = std::numeric_limits<double>::infinity ();
+  bool bestReached = false;
+  for (uint32_t it = 0; it < m_nIterations; it++)
+    {
+      if (it == 0)
+        {
+          Search (MIN_AIRTIME, std::vector<double> (), std::vector<uint32_t> ());
+          reached = BuildPaths (sinks);
+        }
+      else
+        {
+          reached = RouteFlowByFlow (sinks, demands, history);
+        }
+      std::vector<double> loads = GetNodeLoads (demands);
+      double maxLoad = loads.empty () ? 0 : *std::max_element (loads.begin (), loads.end ());
+      if (maxLoad < bestLoad)
+        {
+          bestLoad = maxLoad;
+          bestPaths = m_paths;
+          bestPred = m_pred;
+          bestReached = reached;
+        }
+      for (uint32_t v = 0; v < history.size (); v++)
+        {
+          history[v] = it == 0 ? loads[v] : (history[v] + loads[v]) / 2;
+        }
+    }
+  m_paths = bestPaths;
+  m_pred = bestPred;
+  m_maxNodeLoad = bestLoad;
+  return bestReached;
+}
+
+const std::vector<uint32_t> &
+DmgRoutePlanner::GetPath (uint32_t flow) const
+{
+  NS_ASSERT (flow < m_paths.size ());
+  return m_paths[flow];
+}
+
+double
+DmgRoutePlanner::GetMaxNodeLoad (void) const
+{
+  return m_maxNodeLoad;
+}
+
+} // namespace ns3
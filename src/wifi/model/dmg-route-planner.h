@@ -0,0 +1,123 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+#ifndef DMG_ROUTE_PLANNER_H
+#define DMG_ROUTE_PLANNER_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/* Routes the flows of a mesh network from its gateways.
+ *
+ * Every link has the airtime needed to carry one bit in each direction (ns
+ * per bit, including the PPDU and BlockAck overheads). A Dijkstra search
+ * from all the gateways at once gives a forest: every node is reached from
+ * the gateway it is closest to, and every flow follows the branch from its
+ * gateway to its sink. The flows of the same sink share the path, and the
+ * union of the paths is a forest, as DmgAlmightyController expects.
+ *
+ * - MIN_AIRTIME minimizes the airtime of a bit over the path.
+ * - WIDEST_PATH maximizes the rate of the slowest link of the path. Among
+ *   the paths of the same width, the search prefers the lower airtime only
+ *   when it labels a node: the path of a sink is not always the one with
+ *   the lowest airtime among its widest paths.
+ * - CLIQUE_LOAD minimizes the airtime too, but the cost of a link grows with
+ *   the load of its nodes: the airtime fraction of the flow demands carried
+ *   by the links of the node, i.e. the load of the clique the node is the
+ *   conflict node of. After the MIN_AIRTIME routing, the flows are routed
+ *   one at a time (largest demand first, keeping the branches of the flows
+ *   already routed) with the loads of those flows and of the previous
+ *   routings; the routing with the lowest maximum load is kept.
+ *
+ * The search uses a binary heap over adjacency lists, O(E log V).
+ */
+class DmgRoutePlanner
+{
+public:
+  enum Metric
+  {
+    MIN_AIRTIME,
+    WIDEST_PATH,
+    CLIQUE_LOAD
+  };
+
+  DmgRoutePlanner ();
+
+  /* Remove the nodes, links and gateways */
+  void Clear (void);
+  void SetNNodes (uint32_t n);
+  uint32_t GetNNodes (void) const;
+  /* Add a link between nodes a and b, with the airtime (ns) of a bit from a
+   * to b and from b to a. Return its index */
+  uint32_t AddLink (uint32_t a, uint32_t b, double airtimeAb, double airtimeBa);
+  uint32_t GetNLinks (void) const;
+  void AddGateway (uint32_t node);
+  /* Number of routings tried by CLIQUE_LOAD. Default 8 */
+  void SetNIterations (uint32_t n);
+
+  /* Route a flow of demands[i] Mb/s from a gateway to every sinks[i]
+   * (demands may be empty: 1 Mb/s each). Return false if some sink cannot
+   * be reached */
+  bool Route (Metric metric, const std::vector<uint32_t> &sinks, const std::vector<double> &demands);
+  /* Return the path of flow i of the last Route, from its gateway to its
+   * sink. Empty if the sink cannot be reached */
+  const std::vector<uint32_t> & GetPath (uint32_t flow) const;
+  /* Return the airtime fraction of the busiest node with the paths of the
+   * last Route */
+  double GetMaxNodeLoad (void) const;
+
+private:
+  struct Arc
+  {
+    uint32_t to;
+    double airtime;
+  };
+
+  /* Fill m_pred with the forest of metric; weights scale the airtime of
+   * the arcs leaving and entering every node (CLIQUE_LOAD), and the nodes
+   * whose treePred is not themselves are only reached from it */
+  void Search (Metric metric, const std::vector<double> &weights, const std::vector<uint32_t> &treePred);
+  /* Build the path of sink from m_pred; return false if there is none */
+  bool BuildPath (uint32_t sink, std::vector<uint32_t> &path) const;
+  /* Build the paths of sinks from m_pred; return false if one is missing */
+  bool BuildPaths (const std::vector<uint32_t> &sinks);
+  /* One CLIQUE_LOAD routing, see above */
+  bool RouteFlowByFlow (const std::vector<uint32_t> &sinks, const std::vector<double> &demands,
+                        const std::vector<double> &history);
+  void AddPathLoad (const std::vector<uint32_t> &path, double demand, std::vector<double> &loads) const;
+  /* Airtime fraction of every node with the current paths */
+  std::vector<double> GetNodeLoads (const std::vector<double> &demands) const;
+  double GetArcAirtime (uint32_t from, uint32_t to) const;
+
+  std::vector<std::vector<Arc> > m_arcs;
+  std::vector<uint32_t> m_gateways;
+  uint32_t m_nLinks;
+  uint32_t m_nIterations;
+  /* Predecessor of every node in the forest, itself for the gateways and
+   * the nodes not reached */
+  std::vector<uint32_t> m_pred;
+  std::vector<std::vector<uint32_t> > m_paths;
+  double m_maxNodeLoad;
+};
+
+} // namespace ns3
+
+#endif /* DMG_ROUTE_PLANNER_H */
@@ -0,0 +1,269 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "dmg-snr-wifi-manager.h"
+#include "yans-wifi-phy.h"
+
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("DmgSnrWifiManager");
+
+/* Reference PSDU size of the TargetPer, as for the 802.11ad sensitivity */
+static const uint32_t TARGET_PSDU_BYTES = 4096;
+
+struct DmgSnrWifiManager::DmgSnrWifiRemoteStation : public DmgDestinationFixedWifiRemoteStation
+{
+  double m_snrDb;          // smoothed SNR of the frames received from the station
+  bool m_hasSnr;
+  double m_successRatio;   // smoothed ratio of the MPDUs delivered
+  uint32_t m_successes;    // MPDUs delivered since the last failure
+  int32_t m_snrIndex;      // table index chosen by the SNR, -1 for VHTMCS0
+  uint32_t m_backoff;      // modes below m_snrIndex after losses
+  WifiMode m_mode;         // mode of the next data frames
+};
+
+NS_OBJECT_ENSURE_REGISTERED (DmgSnrWifiManager);
+
+TypeId
+DmgSnrWifiManager::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DmgSnrWifiManager")
+    .SetParent<DmgDestinationFixedWifiManager> ()
+    .AddConstructor<DmgSnrWifiManager> ()
+    .AddAttribute ("TargetPer",
+                   "PER of a 4096 bytes PSDU the chosen mode must not exceed, according to the error rate model of the PHY.",
+                   DoubleValue (0.01),
+                   MakeDoubleAccessor (&DmgSnrWifiManager::m_targetPer),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("SnrSmoothing",
+                   "Weight of a new sample in the smoothed SNR.",
+                   DoubleValue (0.1),
+                   MakeDoubleAccessor (&DmgSnrWifiManager::m_snrSmoothing),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("SuccessSmoothing",
+                   "Weight of a new MPDU in the smoothed success ratio.",
+                   DoubleValue (0.05),
+                   MakeDoubleAccessor (&DmgSnrWifiManager::m_successSmoothing),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("HysteresisDb",
+                   "Margin over the threshold of a faster mode the SNR needs to switch to it.",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&DmgSnrWifiManager::m_hysteresisDb),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("MinSuccessRatio",
+                   "Success ratio below which the station backs off one mode.",
+                   DoubleValue (0.9),
+                   MakeDoubleAccessor (&DmgSnrWifiManager::m_minSuccessRatio),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("RecoverySuccesses",
+                   "Number of MPDUs delivered in a row to recover one mode after a back off.",
+                   UintegerValue (100),
+                   MakeUintegerAccessor (&DmgSnrWifiManager::m_recoverySuccesses),
+                   MakeUintegerChecker<uint32_t> (1))
+  ;
+  return tid;
+}
+
+DmgSnrWifiManager::DmgSnrWifiManager ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+DmgSnrWifiManager::~DmgSnrWifiManager ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+DmgSnrWifiManager::SetupPhy (Ptr<WifiPhy> phy)
+{
+  NS_LOG_FUNCTION (this << phy);
+  DmgDestinationFixedWifiManager::SetupPhy (phy);
+  Ptr<YansWifiPhy> yansPhy = phy->GetObject<YansWifiPhy> ();
+  NS_ASSERT_MSG (yansPhy != 0, "DmgSnrWifiManager needs a YansWifiPhy");
+  m_table.Build (yansPhy, m_targetPer, TARGET_PSDU_BYTES);
+}
+
+const DmgMcsTable &
+DmgSnrWifiManager::GetMcsTable (void) const
+{
+  return m_table;
+}
+
+WifiRemoteStation *
+DmgSnrWifiManager::DoCreateStation (void) const
+{
+  NS_LOG_FUNCTION (this);
+  DmgSnrWifiRemoteStation *station = new DmgSnrWifiRemoteStation ();
+  station->m_nodeId = UNKNOWN_NODE_ID;
+  station->m_snrDb = 0;
+  station->m_hasSnr = false;
+  station->m_successRatio = 1;
+  station->m_successes = 0;
+  station->m_snrIndex = -1;
+  station->m_backoff = 0;
+  station->m_mode = WifiPhy::GetVHTMCS0 ();
+  return station;
+}
+
+void
+DmgSnrWifiManager::InitIndex (DmgSnrWifiRemoteStation *station)
+{
+  if (!HasStationWifiMode (station))
+    {
+      return;
+    }
+  // The fastest mode of the table not faster than the seeded one: they
+  // differ only if the seed is the control mode or a dominated mode
+  WifiMode seed = GetStationWifiMode (station);
+  int32_t i = m_table.FindMode (seed);
+  if (i < 0)
+    {
+      i = m_table.GetNModes ();
+      while (i > 0 && m_table.GetMode (i - 1).GetDataRate () > seed.GetDataRate ())
+        {
+          i--;
+        }
+      i--;
+    }
+  station->m_snrIndex = i;
+  station->m_mode = seed;
+}
+
+void
+DmgSnrWifiManager::UpdateSnr (DmgSnrWifiRemoteStation *station, double snr)
+{
+  double snrDb = 10 * std::log10 (snr);
+  if (!station->m_hasSnr)
+    {
+      station->m_hasSnr = true;
+      station->m_snrDb = snrDb;
+      station->m_snrIndex = m_table.GetIndex (snrDb);
+    }
+  else
+    {
+      station->m_snrDb += m_snrSmoothing * (snrDb - station->m_snrDb);
+      int32_t up = m_table.GetIndex (station->m_snrDb - m_hysteresisDb);
+      int32_t down = m_table.GetIndex (station->m_snrDb);
+      if (up > station->m_snrIndex)
+        {
+          station->m_snrIndex = up;
+        }
+      else if (down < station->m_snrIndex)
+        {
+          station->m_snrIndex = down;
+        }
+    }
+  UpdateMode (station);
+}
+
+void
+DmgSnrWifiManager::UpdateMode (DmgSnrWifiRemoteStation *station)
+{
+  if ((int32_t) station->m_backoff > station->m_snrIndex + 1)
+    {
+      station->m_backoff = station->m_snrIndex + 1;
+    }
+  int32_t i = station->m_snrIndex - station->m_backoff;
+  WifiMode mode = i >= 0 ? m_table.GetMode (i) : WifiPhy::GetVHTMCS0 ();
+  if (!(mode == station->m_mode))
+    {
+      NS_LOG_DEBUG ("Station " << station->m_state->m_address << " snr=" << station->m_snrDb
+                    << " backoff=" << station->m_backoff << ": " << station->m_mode
+                    << " -> " << mode);
+      station->m_mode = mode;
+    }
+}
+
+void
+DmgSnrWifiManager::DoReportRxOk (WifiRemoteStation *st,
+                                 double rxSnr, WifiMode txMode)
+{
+  NS_LOG_FUNCTION (this << st << rxSnr << txMode);
+  UpdateSnr ((DmgSnrWifiRemoteStation *) st, rxSnr);
+}
+
+void
+DmgSnrWifiManager::DoReportDataFailed (WifiRemoteStation *st)
+{
+  NS_LOG_FUNCTION (this << st);
+  DmgSnrWifiRemoteStation *station = (DmgSnrWifiRemoteStation *) st;
+  if (!station->m_hasSnr)
+    {
+      InitIndex (station);
+    }
+  station->m_successes = 0;
+  station->m_successRatio *= 1 - m_successSmoothing;
+  if (station->m_successRatio < m_minSuccessRatio)
+    {
+      station->m_backoff++;
+      station->m_successRatio = 1;
+      UpdateMode (station);
+    }
+}
+
+void
+DmgSnrWifiManager::DoReportDataOk (WifiRemoteStation *st,
+                                   double ackSnr, WifiMode ackMode, double dataSnr)
+{
+  NS_LOG_FUNCTION (this << st << ackSnr << ackMode << dataSnr);
+  DmgSnrWifiRemoteStation *station = (DmgSnrWifiRemoteStation *) st;
+  // The BlockAckManager reports the MPDUs of a BlockAck without SNR: the
+  // BlockAck itself goes through DoReportRxOk
+  if (ackSnr > 0)
+    {
+      UpdateSnr (station, ackSnr);
+    }
+  station->m_successRatio += m_successSmoothing * (1 - station->m_successRatio);
+  station->m_successes++;
+  if (station->m_backoff > 0 && station->m_successes >= m_recoverySuccesses)
+    {
+      if (!station->m_hasSnr)
+        {
+          InitIndex (station);
+        }
+      station->m_backoff--;
+      station->m_successes = 0;
+      UpdateMode (station);
+    }
+}
+
+WifiTxVector
+DmgSnrWifiManager::DoGetDataTxVector (WifiRemoteStation *st, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << st << size);
+  DmgSnrWifiRemoteStation *station = (DmgSnrWifiRemoteStation *) st;
+  if (!station->m_hasSnr && station->m_backoff == 0)
+    {
+      if (HasStationWifiMode (station))
+        {
+          return MakeDataTxVector (station, GetStationWifiMode (station));
+        }
+    }
+  return MakeDataTxVector (station, station->m_mode);
+}
+
+} // namespace ns3
@@ -0,0 +1,87 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+#ifndef DMG_SNR_WIFI_MANAGER_H
+#define DMG_SNR_WIFI_MANAGER_H
+
+#include "dmg-destination-fixed-wifi-manager.h"
+#include "dmg-mcs-table.h"
+
+namespace ns3 {
+
+/* Online rate adaptation for DMG links.
+ *
+ * Each station keeps an exponentially smoothed SNR of the frames received
+ * from the destination (BlockAcks and data) and a smoothed success ratio
+ * of the MPDUs sent to it. The SNR selects the fastest mode of a
+ * DmgMcsTable built with the TargetPer of the error rate model of the
+ * PHY; the mode goes up only when the SNR exceeds the threshold of the
+ * faster mode by HysteresisDb, and down as soon as the SNR falls below the
+ * threshold of the current one. When the success ratio falls below
+ * MinSuccessRatio the station backs off one mode from the one chosen by
+ * the SNR, and recovers one mode every RecoverySuccesses delivered MPDUs.
+ *
+ * The mode is updated when a report comes in, so choosing the mode of a
+ * frame is a lookup. Until the first SNR sample of a destination the mode
+ * given by the controller with AddDestinationWifiMode is used, as the
+ * DmgDestinationFixedWifiManager does.
+ */
+class DmgSnrWifiManager : public DmgDestinationFixedWifiManager
+{
+public:
+  static TypeId GetTypeId (void);
+  DmgSnrWifiManager ();
+  virtual ~DmgSnrWifiManager ();
+
+  virtual void SetupPhy (Ptr<WifiPhy> phy);
+
+  /* Return the table the modes are chosen from */
+  const DmgMcsTable & GetMcsTable (void) const;
+
+private:
+  struct DmgSnrWifiRemoteStation;
+
+  // overriden from base class
+  virtual WifiRemoteStation* DoCreateStation (void) const;
+  virtual void DoReportRxOk (WifiRemoteStation *station,
+                             double rxSnr, WifiMode txMode);
+  virtual void DoReportDataFailed (WifiRemoteStation *station);
+  virtual void DoReportDataOk (WifiRemoteStation *station,
+                               double ackSnr, WifiMode ackMode, double dataSnr);
+  virtual WifiTxVector DoGetDataTxVector (WifiRemoteStation *station, uint32_t size);
+
+  /* Resolve the table index of the mode seeded for station */
+  void InitIndex (DmgSnrWifiRemoteStation *station);
+  /* Feed a linear SNR sample to the estimate of station */
+  void UpdateSnr (DmgSnrWifiRemoteStation *station, double snr);
+  /* Recompute the mode of station from its SNR index and back off */
+  void UpdateMode (DmgSnrWifiRemoteStation *station);
+
+  DmgMcsTable m_table;
+  double m_targetPer;
+  double m_snrSmoothing;
+  double m_successSmoothing;
+  double m_hysteresisDb;
+  double m_minSuccessRatio;
+  uint32_t m_recoverySuccesses;
+};
+
+} // namespace ns3
+
+#endif /* DMG_SNR_WIFI_MANAGER_H */
@@ -0,0 +1,388 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+#include "dmg-sp-recorder.h"
+#include "ns3/config.h"
+#include "ns3/callback.h"
+#include "ns3/log.h"
+#include <cstring>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("DmgSpRecorder");
+
+static const char DMG_SP_MAGIC[8] = {'D', 'M', 'G', 'S', 'P', 'R', 'E', 'C'};
+static const uint32_t DMG_SP_VERSION = 1;
+
+struct DmgSpColumn
+{
+  const char *name;
+  uint8_t width;
+};
+
+/* Columns of the files, in the order of the fields of DmgSpStats */
+static const DmgSpColumn DMG_SP_COLUMNS[] = {
+  {"source", 6}, {"destination", 6}, {"start", 8}, {"allocated", 4},
+  {"used", 4}, {"bytes", 4}, {"mpdus", 4}, {"ppdus", 4}, {"tail", 4},
+  {"switch", 4}, {"packed", 4}, {"reverse", 4}, {"ack", 1},
+};
+static const uint32_t DMG_SP_N_COLUMNS = sizeof (DMG_SP_COLUMNS) / sizeof (DMG_SP_COLUMNS[0]);
+
+static uint64_t
+MacToInt (Mac48Address mac)
+{
+  uint8_t buffer[6];
+  mac.CopyTo (buffer);
+  uint64_t value = 0;
+  for (uint32_t i = 0; i < 6; i++)
+    {
+      value = (value << 8) | buffer[i];
+    }
+  return value;
+}
+
+static Mac48Address
+IntToMac (uint64_t value)
+{
+  uint8_t buffer[6];
+  for (int32_t i = 5; i >= 0; i--)
+    {
+      buffer[i] = value & 0xff;
+      value >>= 8;
+    }
+  Mac48Address mac;
+  mac.CopyFrom (buffer);
+  return mac;
+}
+
+static uint64_t
+GetField (const DmgSpStats &stats, uint32_t field)
+{
+  switch (field)
+    {
+    case 0:
+      return MacToInt (stats.source);
+    case 1:
+      return MacToInt (stats.destination);
+    case 2:
+      return stats.startNs;
+    case 3:
+      return stats.allocatedNs;
+    case 4:
+      return stats.usedNs;
+    case 5:
+      return stats.bytes;
+    case 6:
+      return stats.nMpdus;
+    case 7:
+      return stats.nPpdus;
+    case 8:
+      return stats.tailNs;
+    case 9:
+      return stats.switchNs;
+    case 10:
+      return stats.nPacked;
+    case 11:
+      return stats.reverseNs;
+    default:
+      return stats.ack;
+    }
+}
+
+static void
+SetField (DmgSpStats &stats, uint32_t field, uint64_t value)
+{
+  switch (field)
+    {
+    case 0:
+      stats.source = IntToMac (value);
+      break;
+    case 1:
+      stats.destination = IntToMac (value);
+      break;
+    case 2:
+      stats.startNs = value;
+      break;
+    case 3:
+      stats.allocatedNs = value;
+      break;
+    case 4:
+      stats.usedNs = value;
+      break;
+    case 5:
+      stats.bytes = value;
+      break;
+    case 6:
+      stats.nMpdus = value;
+      break;
+    case 7:
+      stats.nPpdus = value;
+      break;
+    case 8:
+      stats.tailNs = value;
+      break;
+    case 9:
+      stats.switchNs = value;
+      break;
+    case 10:
+      stats.nPacked = value;
+      break;
+    case 11:
+      stats.reverseNs = value;
+      break;
+    default:
+      stats.ack = value;
+      break;
+    }
+}
+
+static void
+WriteInt (std::ostream &os, uint64_t value, uint8_t width)
+{
+  char buffer[8];
+  for (uint8_t i = 0; i < width; i++)
+    {
+      buffer[i] = value & 0xff;
+      value >>= 8;
+    }
+  os.write (buffer, width);
+}
+
+static bool
+ReadInt (std::istream &is, uint64_t &value, uint8_t width)
+{
+  unsigned char buffer[8];
+  if (width > 8 || !is.read ((char *) buffer, width))
+    {
+      return false;
+    }
+  value = 0;
+  for (int32_t i = width - 1; i >= 0; i--)
+    {
+      value = (value << 8) | buffer[i];
+    }
+  return true;
+}
+
+static DmgSpStats
+EmptyStats (void)
+{
+  DmgSpStats stats;
+  for (uint32_t c = 0; c < DMG_SP_N_COLUMNS; c++)
+    {
+      SetField (stats, c, 0);
+    }
+  return stats;
+}
+
+DmgSpRecorder::DmgSpRecorder ()
+  : m_blockSize (4096),
+    m_nRecords (0)
+{
+}
+
+DmgSpRecorder::~DmgSpRecorder ()
+{
+  Close ();
+}
+
+bool
+DmgSpRecorder::Open (std::string filename)
+{
+  Close ();
+  m_file.open (filename.c_str (), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!m_file.is_open ())
+    {
+      NS_LOG_WARN ("Cannot open " << filename);
+      return false;
+    }
+  m_file.write (DMG_SP_MAGIC, sizeof (DMG_SP_MAGIC));
+  WriteInt (m_file, DMG_SP_VERSION, 4);
+  WriteInt (m_file, DMG_SP_N_COLUMNS, 4);
+  for (uint32_t c = 0; c < DMG_SP_N_COLUMNS; c++)
+    {
+      uint8_t length = std::strlen (DMG_SP_COLUMNS[c].name);
+      WriteInt (m_file, DMG_SP_COLUMNS[c].width, 1);
+      WriteInt (m_file, length, 1);
+      m_file.write (DMG_SP_COLUMNS[c].name, length);
+    }
+  m_block.reserve (m_blockSize);
+  m_nRecords = 0;
+  return true;
+}
+
+void
+DmgSpRecorder::SetBlockSize (uint32_t records)
+{
+  NS_ASSERT (records > 0);
+  m_blockSize = records;
+}
+
+void
+DmgSpRecorder::ConnectAll (void)
+{
+  Config::ConnectWithoutContext ("/NodeList/*/DeviceList/*/$ns3::WifiNetDevice/Mac/$ns3::DmgWifiMac/SpStats",
+                                 MakeCallback (&DmgSpRecorder::Record, this));
+}
+
+void
+DmgSpRecorder::Record (const DmgSpStats &stats)
+{
+  if (!m_file.is_open ())
+    {
+      return;
+    }
+  m_block.push_back (stats);
+  m_nRecords++;
+  if (m_block.size () >= m_blockSize)
+    {
+      WriteBlock ();
+    }
+}
+
+void
+DmgSpRecorder::WriteBlock (void)
+{
+  if (m_block.empty ())
+    {
+      return;
+    }
+  WriteInt (m_file, m_block.size (), 4);
+  for (uint32_t c = 0; c < DMG_SP_N_COLUMNS; c++)
+    {
+      for (uint32_t r = 0; r < m_block.size (); r++)
+        {
+          WriteInt (m_file, GetField (m_block[r], c), DMG_SP_COLUMNS[c].width);
+        }
+    }
+  m_block.clear ();
+}
+
+void
+DmgSpRecorder::Close (void)
+{
+  if (!m_file.is_open ())
+    {
+      return;
+    }
+  WriteBlock ();
+  m_file.close ();
+}
+
+uint64_t
+DmgSpRecorder::GetNRecords (void) const
+{
+  return m_nRecords;
+}
+
+DmgSpReader::DmgSpReader ()
+  : m_next (0)
+{
+}
+
+bool
+DmgSpReader::Open (std::string filename)
+{
+  m_file.close ();
+  m_file.clear ();
+  m_widths.clear ();
+  m_fields.clear ();
+  m_block.clear ();
+  m_next = 0;
+  m_file.open (filename.c_str (), std::ios::in | std::ios::binary);
+
+  char magic[sizeof (DMG_SP_MAGIC)];
+  uint64_t version, nColumns;
+  if (!m_file.read (magic, sizeof (magic))
+      || std::memcmp (magic, DMG_SP_MAGIC, sizeof (magic)) != 0
+      || !ReadInt (m_file, version, 4) || !ReadInt (m_file, nColumns, 4))
+    {
+      return false;
+    }
+  for (uint32_t c = 0; c < nColumns; c++)
+    {
+      uint64_t width, length;
+      if (!ReadInt (m_file, width, 1) || !ReadInt (m_file, length, 1) || width > 8)
+        {
+          return false;
+        }
+      std::string name (length, ' ');
+      if (length > 0 && !m_file.read (&name[0], length))
+        {
+          return false;
+        }
+      int32_t field = -1;
+      for (uint32_t f = 0; f < DMG_SP_N_COLUMNS; f++)
+        {
+          if (name == DMG_SP_COLUMNS[f].name)
+            {
+              field = f;
+            }
+        }
+      m_widths.push_back (width);
+      m_fields.push_back (field);
+    }
+  return true;
+}
+
+bool
+DmgSpReader::ReadBlock (void)
+{
+  uint64_t nRecords;
+  if (!ReadInt (m_file, nRecords, 4))
+    {
+      return false;
+    }
+  m_block.assign (nRecords, EmptyStats ());
+  m_next = 0;
+  for (uint32_t c = 0; c < m_widths.size (); c++)
+    {
+      for (uint32_t r = 0; r < nRecords; r++)
+        {
+          uint64_t value;
+          if (!ReadInt (m_file, value, m_widths[c]))
+            {
+              NS_LOG_WARN ("Truncated block");
+              m_block.clear ();
+              return false;
+            }
+          if (m_fields[c] >= 0)
+            {
+              SetField (m_block[r], m_fields[c], value);
+            }
+        }
+    }
+  return true;
+}
+
+bool
+DmgSpReader::Read (DmgSpStats &stats)
+{
+  while (m_next >= m_block.size ())
+    {
+      if (!m_file.is_open () || !ReadBlock ())
+        {
+          return false;
+        }
+    }
+  stats = m_block[m_next++];
+  return true;
+}
+
+} // namespace ns3
@@ -0,0 +1,64 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+#ifndef DMG_SP_STATS_H
+#define DMG_SP_STATS_H
+
+#include <stdint.h>
+#include "ns3/mac48-address.h"
+
+namespace ns3 {
+
+/* What a transmitter did with one of its SPs, reported by MacLow when the
+ * SP ends. All the times are in ns.
+ *
+ * An exchange lasts from the start of a PPDU to the end of its ACK or
+ * BlockAck, or to the timeout waiting for it. The tail is the time left
+ * after the last exchange when the last A-MPDU was closed by
+ * DmgStopAggregation while an MPDU was still waiting, i.e. the time lost
+ * at the end of a backlogged SP. The switch time is the time from the
+ * start of the SP to its first PPDU: the beam switch and the access
+ * delay. The packed MPDUs are the ones MacLow took from other flows to
+ * fill the end of the SP, see MacLow::SetSpTailPacking. The reverse time is
+ * the time the transmitter lent to the destination with reverse direction
+ * grants, from the BlockAck announcing the reverse PPDU to the end of its
+ * exchange, see MacLow::SetReverseDirection. Ack is 1 for the SPs the
+ * controller reserved to the reverse direction of their flow (e.g. the TCP
+ * ACKs), see DmgAlmightyController::SetAckTimeFrac.
+ */
+struct DmgSpStats
+{
+  Mac48Address source;
+  Mac48Address destination;
+  uint64_t startNs;     // start of the SP
+  uint32_t allocatedNs; // duration of the SP
+  uint32_t usedNs;      // time spent in exchanges
+  uint32_t bytes;       // payload bytes of the MPDUs acknowledged
+  uint32_t nMpdus;      // MPDUs sent, retransmissions included
+  uint32_t nPpdus;      // PPDUs sent
+  uint32_t tailNs;      // time left after the last exchange of a backlogged SP
+  uint32_t switchNs;    // time before the first PPDU
+  uint32_t nPacked;     // MPDUs added by SP tail packing
+  uint32_t reverseNs;   // time lent to the destination by reverse direction grants
+  uint32_t ack;         // 1 if the SP is reserved to the reverse direction of its flow
+};
+
+} // namespace ns3
+
+#endif /* DMG_SP_STATS_H */
@@ -100,10 +100,36 @@ TypeId DmgWifiMac::GetTypeId (void)
 			 "The header of unsuccessfully transmitted packet",
 			 MakeTraceSourceAccessor (&DmgWifiMac::m_txErrCallback),
 			 "ns3::WifiMacHeader::TracedCallback")
+	.AddTraceSource ("SpStats",
+			 "What a Tx SP was used for, at its end",
+			 MakeTraceSourceAccessor (&DmgWifiMac::m_spStatsTrace),
+			 "ns3::DmgWifiMac::SpStatsTracedCallback")
   .AddAttribute ("DmgAckTimeoutGuard", "Guard time for ack timeout (only if m_isDmg is true)",
                    TimeValue (MicroSeconds (1)),
                    MakeTimeAccessor (&DmgWifiMac::m_dmgAckTimeoutGuard),
                    MakeTimeChecker ())
+  .AddAttribute ("SpFastForward",
+                   "Deliver the A-MPDUs of the SPs no other link can interfere with as whole PPDUs, "
+                   "scheduling one reception event per PPDU instead of one per MPDU",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&DmgWifiMac::SetSpFastForward,
+                                        &DmgWifiMac::GetSpFastForward),
+                   MakeBooleanChecker ())
+  .AddAttribute ("SpTailPacking",
+                   "When the next MPDU of an A-MPDU does not fit in the rest of the SP, "
+                   "add the heads of the other flows of the same next hop and TID that still fit",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&DmgWifiMac::SetSpTailPacking,
+                                        &DmgWifiMac::GetSpTailPacking),
+                   MakeBooleanChecker ())
+  .AddAttribute ("ReverseDirection",
+                   "Grant the rest of the Tx SPs to the destination of their A-MPDUs, which "
+                   "sends its frames for this station (e.g. TCP ACKs) after the BlockAck. "
+                   "It must be the same on all the stations",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&DmgWifiMac::SetReverseDirection,
+                                        &DmgWifiMac::GetReverseDirection),
+                   MakeBooleanChecker ())
     ;
 
     return tid;
@@ -124,6 +150,7 @@ DmgWifiMac::DmgWifiMac()
     m_low = CreateObject<MacLow>();
     m_low->SetRxCallback(MakeCallback(&MacRxMiddle::Receive, m_rxMiddle));
     m_low->SetIsDmg(true);
+    m_low->SetSpStatsCallback(MakeCallback(&DmgWifiMac::NotifySpStats, this));
 
     m_dcfManager = new DcfManager();
     m_dcfManager->SetupLowListener(m_low);
@@ -187,6 +214,11 @@ void DmgWifiMac::DoDispose ()
     m_phy = 0;
     m_stationManager = 0;
 
+    if (m_dmgAntennaController != 0)
+    {
+	m_dmgAntennaController->Dispose ();
+    }
+
     //m_dca->Dispose();
     //m_dca = 0;
 
@@ -847,6 +879,11 @@ void DmgWifiMac::TxFailed(const WifiMacHeader &hdr)
     m_txErrCallback(hdr);
 }
 
+void DmgWifiMac::NotifySpStats(const DmgSpStats &stats)
+{
+    m_spStatsTrace(stats);
+}
+
 void
 DmgWifiMac::ConfigureCw (uint32_t cwmin, uint32_t cwmax)
 {
@@ -919,6 +956,48 @@ DmgWifiMac::SetPropagationGuard(Time guard)
   m_low->SetPropagationGuard(guard);
 }
 
+Time
+DmgWifiMac::GetPropagationGuard(void) const
+{
+  return m_low->GetPropagationGuard();
+}
+
+void
+DmgWifiMac::SetSpFastForward(bool enable)
+{
+  m_low->SetSpFastForward(enable);
+}
+
+bool
+DmgWifiMac::GetSpFastForward(void) const
+{
+  return m_low->GetSpFastForward();
+}
+
+void
+DmgWifiMac::SetSpTailPacking(bool enable)
+{
+  m_low->SetSpTailPacking(enable);
+}
+
+bool
+DmgWifiMac::GetSpTailPacking(void) const
+{
+  return m_low->GetSpTailPacking();
+}
+
+void
+DmgWifiMac::SetReverseDirection(bool enable)
+{
+  m_low->SetReverseDirection(enable);
+}
+
+bool
+DmgWifiMac::GetReverseDirection(void) const
+{
+  return m_low->GetReverseDirection();
+}
+
 void
 DmgWifiMac::SetDmgAckTimeoutGuard (Time guard)
 {
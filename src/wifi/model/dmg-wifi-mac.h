@@ -30,6 +30,7 @@
 
 #include "beamforming-engine.h"
 #include "dmg-antenna-controller.h"
+#include "dmg-sp-stats.h"
 
 #include <map>
 
@@ -258,6 +259,13 @@ public:
   void SetDmgBeaconInterval(Ptr<DmgBeaconInterval> dmgBi);
   Ptr<DmgBeaconInterval> GetDmgBeaconInterval(void);
   void SetPropagationGuard(Time guard);
+  Time GetPropagationGuard(void) const;
+  void SetSpFastForward(bool enable);
+  bool GetSpFastForward(void) const;
+  void SetSpTailPacking(bool enable);
+  bool GetSpTailPacking(void) const;
+  void SetReverseDirection(bool enable);
+  bool GetReverseDirection(void) const;
   void StartDmgSpTracking (void);
 
 
@@ -283,6 +291,13 @@ public:
   Time GetNMpduReturnDuration (Mac48Address mac);
 
    void SetMaxNumMpdu (uint32_t n);
+
+  /**
+   * TracedCallback signature for the end of a Tx SP.
+   *
+   * \param stats what the SP was used for
+   */
+  typedef void (* SpStatsTracedCallback)(const DmgSpStats &stats);
 protected:
   virtual void DoInitialize ();
   virtual void DoDispose ();
@@ -509,6 +524,10 @@ private:
 
   TracedCallback<const WifiMacHeader &> m_txOkCallback;
   TracedCallback<const WifiMacHeader &> m_txErrCallback;
+  /* Fired by MacLow at the end of every Tx SP */
+  TracedCallback<const DmgSpStats &> m_spStatsTrace;
+
+  void NotifySpStats (const DmgSpStats &stats);
 
   Mac48Address m_self;                      //!< Address of this MacLow (Mac48Address)
 
@@ -190,6 +190,14 @@ class EdcaTxopN::BlockAckEventListener : public MacLowBlockAckEventListener
 		{
 			return m_txop->GetNRetryNeededPackets (recipient, tid);
 		}
+		virtual Ptr<const Packet> PeekReverseDirectionPacket (Mac48Address originator, WifiMacHeader *hdr)
+		{
+			return m_txop->PeekReverseDirectionPacket (originator, hdr);
+		}
+		virtual void StartReverseDirection (Mac48Address originator, Time end)
+		{
+			m_txop->StartReverseDirection (originator, end);
+		}
 
 	private:
 		EdcaTxopN *m_txop;
@@ -234,7 +242,8 @@ EdcaTxopN::GetTypeId (void)
 	m_isDmg (false),
 	m_dmgAntennaController (0),
 	m_nextSpStart (NanoSeconds(0)),
-	m_nextSpStop (NanoSeconds(0))
+	m_nextSpStop (NanoSeconds(0)),
+	m_reverseDirectionActive (false)
 {
 	NS_LOG_FUNCTION (this);
 	m_transmissionListener = new EdcaTxopN::TransmissionListener (this);
@@ -648,10 +657,11 @@ void EdcaTxopN::NotifyAccessGranted (void)
                                 }
 				NS_ASSERT(m_currentHdr.GetAddr1() == m_dmgBeaconInterval->GetNextTxSpDestination());
 
-				m_dmgAntennaController->PointAntenna(m_dmgBeaconInterval->
-						GetNextTxSpDestinationMobility()->GetPosition());
+				m_dmgAntennaController->PointAntennaToPeer(m_dmgBeaconInterval->
+						GetNextTxSpDestinationMobility());
 
 				params.SetCurrentSpEnd(m_dmgBeaconInterval->GetNextTxSpStop());
+				params.SetCurrentSpIsolated(m_dmgBeaconInterval->GetNextTxSpIsolated());
 
 				NS_LOG_DEBUG("Start Transmission to " << m_currentHdr.GetAddr1());
 			}
@@ -890,7 +900,9 @@ EdcaTxopN::MissedBlockAck (void)
 	NS_LOG_FUNCTION (this);
 	NS_LOG_DEBUG ("missed block ack");
 	//NS_ASSERT(!m_isDmg);
-	m_manager->MissedBlockAck();
+	if (!m_reverseDirectionActive) {
+		m_manager->MissedBlockAck();
+	}
 	NS_LOG_FUNCTION ("back to "<<this);
 	//if (NeedBarRetransmission() && !m_isDmg)
 	if (NeedBarRetransmission())
@@ -956,6 +968,13 @@ EdcaTxopN::MissedBlockAck (void)
 		m_currentPacket = 0;
 		m_dcf->ResetCw ();
 	}
+	if (m_reverseDirectionActive) {
+		/* The grant is over: like at the end of an SP, the BAR is dropped
+		 * and the MPDUs wait for the next SP to the recipient */
+		m_reverseDirectionActive = false;
+		m_currentPacket = 0;
+		return;
+	}
 	if (!m_isDmg) {
 		m_dcf->StartBackoffNow (m_rng->GetNext (0, m_dcf->GetCw ()));
 	}
@@ -1365,7 +1384,9 @@ EdcaTxopN::GotBlockAck (const CtrlBAckResponseHeader *blockAck, Mac48Address rec
 	NS_LOG_FUNCTION (this << blockAck << recipient);
 	NS_LOG_DEBUG ("got block ack from=" << recipient);
 	//NS_ASSERT(!m_isDmg);
-	m_manager->GotBlockAck();
+	if (!m_reverseDirectionActive) {
+		m_manager->GotBlockAck();
+	}
 	m_baManager->NotifyGotBlockAck (blockAck, recipient, txMode);
 
 	if (!m_txOkCallback.IsNull ())
@@ -1373,6 +1394,7 @@ EdcaTxopN::GotBlockAck (const CtrlBAckResponseHeader *blockAck, Mac48Address rec
 		m_txOkCallback (m_currentHdr);
 	}
 	m_currentPacket = 0;
+	m_reverseDirectionActive = false;
 	m_dcf->ResetCw ();
 	if (!m_isDmg) {
 		m_dcf->StartBackoffNow (m_rng->GetNext (0, m_dcf->GetCw ()));
@@ -1497,6 +1519,7 @@ EdcaTxopN::SendBlockAckRequest (const struct Bar &bar)
 	}
 	if (m_isDmg) {
 		params.SetCurrentSpEnd(m_dmgBeaconInterval->GetNextTxSpStop());
+		params.SetCurrentSpIsolated(m_dmgBeaconInterval->GetNextTxSpIsolated());
 	}
 	m_low->StartTransmission (m_currentPacket, &m_currentHdr, params, m_transmissionListener);
 }
@@ -1806,6 +1829,7 @@ EdcaTxopN::StartDmgSp ()
 
 	m_dmgNextSpDestination = m_dmgBeaconInterval->GetNextTxSpDestination();
 	m_dmgNextSpSrcSink = m_dmgBeaconInterval->GetNextTxSpSrcSinkIpv4Address();
+	m_low->NotifySpStart(m_nextSpStop, m_dmgNextSpDestination, m_dmgBeaconInterval->GetNextTxSpAck());
 
 	NS_LOG_DEBUG(now<<"(now). Starting an Tx SP, current SP stops at "<< m_nextSpStop);
 	StartAccessIfNeeded();
@@ -1817,6 +1841,7 @@ EdcaTxopN::StopDmgSp ()
 	NS_LOG_FUNCTION(this);
 	Time now = Simulator::Now();
 	NS_LOG_DEBUG(now<<"(now). Stopping an Tx SP, current SP started at "<< m_nextSpStart);
+	m_low->NotifySpEnd();
 
 	m_nextSpStart = m_dmgBeaconInterval->GetNextTxSpStart();
 	m_nextSpStop = m_dmgBeaconInterval->GetNextTxSpStop();
@@ -1858,6 +1883,81 @@ EdcaTxopN::StartDmgSpTracking (void)
 	m_dmgNextSpSrcSink = m_dmgBeaconInterval->GetNextTxSpSrcSinkIpv4Address();
 }
 
+	Ptr<const Packet>
+EdcaTxopN::PeekReverseDirectionPacket (Mac48Address originator, WifiMacHeader *hdr)
+{
+	NS_LOG_FUNCTION (this << originator);
+	if (!m_isDmg || m_currentPacket != 0 || m_dmgBeaconInterval == 0
+			|| m_dmgBeaconInterval->GetSps().empty()) {
+		return 0;
+	}
+	/* Only in the current Rx SP from originator */
+	if (m_dmgBeaconInterval->GetNextSpIfTx()
+			|| m_dmgBeaconInterval->GetNextSpStart() > Simulator::Now()
+			|| m_dmgBeaconInterval->GetNextSpDestination() != originator) {
+		return 0;
+	}
+	Time tstamp;
+	Ptr<const Packet> packet = m_baManager->PeekNextPacketByAddress (*hdr, originator, &tstamp);
+	if (packet == 0) {
+		std::pair<Ipv4Address, Ipv4Address> flow = m_dmgBeaconInterval->GetNextSpSrcSinkIpv4Address();
+		packet = m_queue->PeekByAddress (hdr, WifiMacHeader::ADDR1, originator,
+				std::make_pair(flow.second, flow.first), &tstamp);
+	}
+	if (packet == 0 || !hdr->IsQosData ()
+			|| !m_baManager->ExistsAgreementInState (originator, hdr->GetQosTid (),
+				OriginatorBlockAckAgreement::ESTABLISHED)) {
+		return 0;
+	}
+	return packet;
+}
+
+	void
+EdcaTxopN::StartReverseDirection (Mac48Address originator, Time end)
+{
+	NS_LOG_FUNCTION (this << originator << end);
+	WifiMacHeader hdr;
+	if (PeekReverseDirectionPacket (originator, &hdr) == 0) {
+		NS_LOG_DEBUG ("nothing left for the reverse direction grant of " << originator);
+		return;
+	}
+	m_currentPacket = m_baManager->GetNextPacketByAddress (m_currentHdr, originator);
+	if (m_currentPacket == 0) {
+		std::pair<Ipv4Address, Ipv4Address> flow = m_dmgBeaconInterval->GetNextSpSrcSinkIpv4Address();
+		m_currentPacket = m_queue->DequeueByAddress (&m_currentHdr, WifiMacHeader::ADDR1, originator,
+				std::make_pair(flow.second, flow.first));
+		NS_ASSERT (m_currentPacket != 0);
+
+		uint16_t sequence = m_txMiddle->GetNextSequenceNumberfor (&m_currentHdr);
+		m_currentHdr.SetSequenceNumber (sequence);
+		m_currentHdr.SetFragmentNumber (0);
+		m_currentHdr.SetNoMoreFragments ();
+		m_currentHdr.SetNoRetry ();
+		m_fragmentNumber = 0;
+		VerifyBlockAck ();
+	}
+	NS_LOG_DEBUG ("reverse direction to " << originator << " until " << end);
+	m_reverseDirectionActive = true;
+
+	MacLowTransmissionParameters params;
+	params.DisableOverrideDurationId ();
+	if (m_currentHdr.IsQosBlockAck ())
+	{
+		params.DisableAck ();
+	}
+	else
+	{
+		params.EnableAck ();
+	}
+	params.DisableRts ();
+	params.DisableNextData ();
+	params.SetCurrentSpEnd (end);
+	params.SetCurrentSpIsolated (false);
+	m_low->StartTransmission (m_currentPacket, &m_currentHdr, params, m_transmissionListener);
+	if (!GetAmpduExist ())
+		CompleteTx ();
+}
+
 	void
 EdcaTxopN::SetMaxQueuePacketNumberPerDestination (uint32_t maxPacket)
 {
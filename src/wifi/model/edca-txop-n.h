@@ -470,6 +470,21 @@ public:
   void StartDmgSpTracking (void);
   void SetMaxQueuePacketNumberPerDestination (uint32_t maxPacket);
 
+  /**
+   * \param originator the owner of the current Rx SP.
+   * \param hdr the header of the returned packet.
+   * \return the packet StartReverseDirection would send first to originator:
+   * a retransmission, or a packet of the reverse direction of the flow of
+   * the SP. 0 if there is none or if a transmission is in progress.
+   */
+  Ptr<const Packet> PeekReverseDirectionPacket (Mac48Address originator, WifiMacHeader *hdr);
+  /**
+   * Send an A-MPDU to originator in its SP, whose exchange ends before end.
+   * The exchange does not involve the DcfManager: the Tx SPs of this
+   * station are not affected.
+   */
+  void StartReverseDirection (Mac48Address originator, Time end);
+
 private:
   void DoInitialize ();
   /**
@@ -588,6 +603,8 @@ private:
   EventId m_dmgSpStop;
   Mac48Address m_dmgNextSpDestination;
   std::pair<Ipv4Address, Ipv4Address> m_dmgNextSpSrcSink;
+  /* The current packet is sent with a reverse direction grant */
+  bool m_reverseDirectionActive;
 };
 
 }  // namespace ns3
@@ -90,34 +90,6 @@ InterferenceHelper::Event::GetTxVector (void) const
   return m_txVector;
 }
 
-/****************************************************************
- *       Class which records SNIR change events for a
- *       short period of time.
- ****************************************************************/
-
-InterferenceHelper::NiChange::NiChange (Time time, double delta)
-  : m_time (time),
-    m_delta (delta)
-{}
-
-Time
-InterferenceHelper::NiChange::GetTime (void) const
-{
-  return m_time;
-}
-
-double
-InterferenceHelper::NiChange::GetDelta (void) const
-{
-  return m_delta;
-}
-
-bool
-InterferenceHelper::NiChange::operator < (const InterferenceHelper::NiChange& o) const
-{
-  return (m_time < o.m_time);
-}
-
 /****************************************************************
  *       The actual InterferenceHelper
  ****************************************************************/
@@ -184,8 +156,8 @@ InterferenceHelper::GetEnergyDuration (double energyW)
     noiseInterferenceW = m_firstPower;
     for (NiChanges::const_iterator i = m_niChanges.begin (); i != m_niChanges.end (); i++)
     {
-        noiseInterferenceW += i->GetDelta ();
-        end = i->GetTime ();
+        noiseInterferenceW += i->second;
+        end = i->first;
         if (end < now)
         {
             continue;
@@ -201,40 +173,24 @@ InterferenceHelper::GetEnergyDuration (double energyW)
 void
 InterferenceHelper::AppendEvent (Ptr<InterferenceHelper::Event> event)
 {
-    Time now = Simulator::Now ();
     if (!m_rxing)
     {
-        NiChanges::iterator nowIterator = GetPosition (now);
-        for (NiChanges::iterator i = m_niChanges.begin (); i != nowIterator; i++)
-        {
-            m_firstPower += i->GetDelta ();
-        }
-        m_niChanges.erase (m_niChanges.begin (), nowIterator);
-        m_niChanges.insert (m_niChanges.begin (), NiChange (event->GetStartTime (), event->GetRxPowerW ()));
+        FoldChanges (Simulator::Now (), true);
     }
-    else
-    {
-        AddNiChangeEvent (NiChange (event->GetStartTime (), event->GetRxPowerW ()));
-    }
-    AddNiChangeEvent (NiChange (event->GetEndTime (), -event->GetRxPowerW ()));
+    // a change goes after the changes of the same time already there
+    m_niChanges.insert (std::make_pair (event->GetStartTime (), event->GetRxPowerW ()));
+    m_niChanges.insert (std::make_pair (event->GetEndTime (), -event->GetRxPowerW ()));
 }
 
-double
-InterferenceHelper::CalculateNoiseInterferenceW(Ptr<InterferenceHelper::Event> event, NiChanges *ni) const
+void
+InterferenceHelper::FoldChanges (Time moment, bool inclusive)
 {
-    double noiseInterference = m_firstPower;
-    NS_ASSERT(m_rxing);
-    for (NiChanges::const_iterator i = m_niChanges.begin() + 1; i != m_niChanges.end(); i++)
+    NiChanges::iterator end = inclusive ? m_niChanges.upper_bound (moment) : m_niChanges.lower_bound (moment);
+    for (NiChanges::iterator i = m_niChanges.begin (); i != end; i++)
     {
-        if ((event->GetEndTime() == i->GetTime()) && event->GetRxPowerW() == -i->GetDelta())
-        {
-            break;
-        }
-        ni->push_back(*i);
+        m_firstPower += i->second;
     }
-    ni->insert(ni->begin(), NiChange(event->GetStartTime(), noiseInterference));
-    ni->push_back(NiChange(event->GetEndTime(), 0));
-    return noiseInterference;
+    m_niChanges.erase (m_niChanges.begin (), end);
 }
 
 double
@@ -266,286 +222,301 @@ InterferenceHelper::CalculateChunkSuccessRate(double snir, Time duration, WifiMo
     return csr;
 }
 
-double
-InterferenceHelper::CalculatePer(Ptr<const InterferenceHelper::Event> event, NiChanges *ni) const
+InterferenceHelper::PlcpFields
+InterferenceHelper::GetPlcpFields (Ptr<const InterferenceHelper::Event> event, Time start) const
 {
-    double psr = 1.0; /* Packet Success Rate */
-    double per;
-    NiChanges::iterator j = ni->begin();
-    Time previous = (*j).GetTime();
-
-    WifiMode payloadMode = event->GetPayloadMode();
-    WifiPreamble preamble = event->GetPreambleType();
-    WifiMode MfHeaderMode;
+    PlcpFields fields;
+    fields.payloadMode = event->GetPayloadMode();
+    fields.preamble = event->GetPreambleType();
+    WifiMode payloadMode = fields.payloadMode;
+    WifiPreamble preamble = fields.preamble;
 
     if (preamble == WIFI_PREAMBLE_HT_MF)
     {
-        MfHeaderMode = WifiPhy::GetMFPlcpHeaderMode (payloadMode, preamble); //return L-SIG mode
+        fields.mfHeaderMode = WifiPhy::GetMFPlcpHeaderMode (payloadMode, preamble); //return L-SIG mode
     }
 
-    WifiMode headerMode = WifiPhy::GetPlcpHeaderMode(payloadMode, preamble);
+    fields.headerMode = WifiPhy::GetPlcpHeaderMode(payloadMode, preamble);
     // packet start time + preamble.
-    Time plcpHeaderStart = (*j).GetTime() + WifiPhy::GetPlcpPreambleDuration(payloadMode, preamble);
+    fields.headerStart = start + WifiPhy::GetPlcpPreambleDuration(payloadMode, preamble);
     // packet start time + preamble + L SIG
-    Time plcpHsigHeaderStart = plcpHeaderStart + WifiPhy::GetPlcpHeaderDuration(payloadMode, preamble);
+    fields.hsigHeaderStart = fields.headerStart + WifiPhy::GetPlcpHeaderDuration(payloadMode, preamble);
     // packet start time + preamble + L SIG + HT SIG
-    Time plcpHtTrainingSymbolsStart = plcpHsigHeaderStart + WifiPhy::GetPlcpHtSigHeaderDuration(payloadMode, preamble);
+    fields.htTrainingSymbolsStart = fields.hsigHeaderStart + WifiPhy::GetPlcpHtSigHeaderDuration(payloadMode, preamble);
     // packet start time + preamble + L SIG + HT SIG + Training
-    Time plcpPayloadStart = plcpHtTrainingSymbolsStart + WifiPhy::GetPlcpHtTrainingSymbolDuration(preamble, event->GetTxVector());
+    fields.payloadStart = fields.htTrainingSymbolsStart + WifiPhy::GetPlcpHtTrainingSymbolDuration(preamble, event->GetTxVector());
+    return fields;
+}
 
-    double noiseInterferenceW = (*j).GetDelta();
+void
+InterferenceHelper::AddChunk (Ptr<const InterferenceHelper::Event> event, const PlcpFields &fields,
+                              Time previous, Time current, double noiseInterferenceW, double *psr) const
+{
+    NS_ASSERT (current >= previous);
+    WifiMode payloadMode = fields.payloadMode;
+    WifiPreamble preamble = fields.preamble;
+    WifiMode headerMode = fields.headerMode;
+    WifiMode MfHeaderMode = fields.mfHeaderMode;
+    Time plcpHeaderStart = fields.headerStart;
+    Time plcpHsigHeaderStart = fields.hsigHeaderStart;
+    Time plcpHtTrainingSymbolsStart = fields.htTrainingSymbolsStart;
+    Time plcpPayloadStart = fields.payloadStart;
     double powerW = event->GetRxPowerW();
 
-    j++;
-    while (ni->end() != j)
+    //Case 1: Both prev and curr point to the payload
+    if (previous >= plcpPayloadStart)
     {
-        Time current = (*j).GetTime();
-        NS_ASSERT (current >= previous);
+        *psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, payloadMode),
+                                          current - previous,
+                                          payloadMode);
+    }
 
-        //Case 1: Both prev and curr point to the payload
-        if (previous >= plcpPayloadStart)
+    //Case 2: previous is before payload
+    else if (previous >= plcpHtTrainingSymbolsStart)
+    {
+        //Case 2a: current is after payload
+        if (current >= plcpPayloadStart)
         {
-            psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, payloadMode),
-                                             current - previous,
-                                             payloadMode);
+            //Case 2ai and 2aii: All formats
+            *psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, payloadMode),
+                                                           current - plcpPayloadStart,
+                                                           payloadMode);
         }
+    }
 
-        //Case 2: previous is before payload
-        else if (previous >= plcpHtTrainingSymbolsStart)
+    //Case 3: previous is in HT-SIG: Non HT will not enter here since it didn't enter in the last two and they are all the same for non HT
+    else if (previous >= plcpHsigHeaderStart)
+    {
+        //Case 3a: cuurent after payload start
+        if (current >= plcpPayloadStart)
         {
-            //Case 2a: current is after payload
-            if (current >= plcpPayloadStart)
-            {
-                //Case 2ai and 2aii: All formats
-                psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, payloadMode),
-                                                              current - plcpPayloadStart,
-                                                              payloadMode);
-            }
+            *psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, payloadMode),
+                                              current - plcpPayloadStart,
+                                              payloadMode);
+
+            *psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, headerMode),
+                                              plcpHtTrainingSymbolsStart - previous,
+                                              headerMode);
         }
 
-        //Case 3: previous is in HT-SIG: Non HT will not enter here since it didn't enter in the last two and they are all the same for non HT
-        else if (previous >= plcpHsigHeaderStart)
+        //case 3b: current after HT training symbols start
+        else if (current >= plcpHtTrainingSymbolsStart)
         {
-            //Case 3a: cuurent after payload start
-            if (current >= plcpPayloadStart)
-            {
-                psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, payloadMode),
-                                                 current - plcpPayloadStart,
-                                                 payloadMode);
+            *psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, headerMode),
+                                              plcpHtTrainingSymbolsStart - previous,
+                                              headerMode);
+        }
 
-                psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, headerMode),
-                                                 plcpHtTrainingSymbolsStart - previous,
-                                                 headerMode);
-            }
+        //Case 3c: current is with previous in HT sig
+        else
+        {
+            *psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, headerMode),
+                                              current- previous,
+                                              headerMode);
+        }
+    }
+
+    //Case 4: previous in L-SIG: GF will not reach here because it will execute the previous if and exit
+    else if (previous >= plcpHeaderStart)
+    {
+        //Case 4a: current after payload start
+        if (current >= plcpPayloadStart)
+        {
+            *psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, payloadMode),
+                                              current - plcpPayloadStart,
+                                              payloadMode);
 
-            //case 3b: current after HT training symbols start
-            else if (current >= plcpHtTrainingSymbolsStart)
+            //Case 4ai: Non HT format (No HT-SIG or Training Symbols)
+            if (preamble == WIFI_PREAMBLE_LONG || preamble == WIFI_PREAMBLE_SHORT) //plcpHtTrainingSymbolsStart==plcpHeaderStart)
             {
-                psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, headerMode),
-                                                 plcpHtTrainingSymbolsStart - previous,
-                                                 headerMode);
+                *psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, headerMode),
+                                                  plcpPayloadStart - previous,
+                                                  headerMode);
             }
-
-            //Case 3c: current is with previous in HT sig
             else
             {
-                psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, headerMode),
-                                                 current- previous,
-                                                 headerMode);
+                *psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, headerMode),
+                                                  plcpHtTrainingSymbolsStart - plcpHsigHeaderStart,
+                                                  headerMode);
+
+                *psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, MfHeaderMode),
+                                                  plcpHsigHeaderStart - previous,
+                                                  MfHeaderMode);
             }
         }
 
-        //Case 4: previous in L-SIG: GF will not reach here because it will execute the previous if and exit
-        else if (previous >= plcpHeaderStart)
+        //Case 4b: current in HT training symbol. non HT will not come here since it went in previous if or if the previous if is not true this will be not true
+        else if (current >= plcpHtTrainingSymbolsStart)
         {
-            //Case 4a: current after payload start
-            if (current >= plcpPayloadStart)
-            {
-                psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, payloadMode),
-                                                 current - plcpPayloadStart,
-                                                 payloadMode);
-
-                //Case 4ai: Non HT format (No HT-SIG or Training Symbols)
-                if (preamble == WIFI_PREAMBLE_LONG || preamble == WIFI_PREAMBLE_SHORT) //plcpHtTrainingSymbolsStart==plcpHeaderStart)
-                {
-                    psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, headerMode),
-                                                     plcpPayloadStart - previous,
-                                                     headerMode);
-                }
-                else
-                {
-                    psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, headerMode),
-                                                     plcpHtTrainingSymbolsStart - plcpHsigHeaderStart,
-                                                     headerMode);
-
-                    psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, MfHeaderMode),
-                                                     plcpHsigHeaderStart - previous,
-                                                     MfHeaderMode);
-                }
-            }
+            *psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, headerMode),
+                                              plcpHtTrainingSymbolsStart - plcpHsigHeaderStart,
+                                              headerMode);
 
-            //Case 4b: current in HT training symbol. non HT will not come here since it went in previous if or if the previous if is not true this will be not true
-            else if (current >= plcpHtTrainingSymbolsStart)
-            {
-                psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, headerMode),
-                                                 plcpHtTrainingSymbolsStart - plcpHsigHeaderStart,
-                                                 headerMode);
+            *psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, MfHeaderMode),
+                                              plcpHsigHeaderStart - previous,
+                                              MfHeaderMode);
+        }
 
-                psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, MfHeaderMode),
-                                                 plcpHsigHeaderStart - previous,
-                                                 MfHeaderMode);
-            }
+        //Case 4c: current in H sig.non HT will not come here since it went in previous if or if the previous ifis not true this will be not true
+        else if (current >= plcpHsigHeaderStart)
+        {
+            *psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, headerMode),
+                                              current - plcpHsigHeaderStart,
+                                              headerMode);
 
-            //Case 4c: current in H sig.non HT will not come here since it went in previous if or if the previous ifis not true this will be not true
-            else if (current >= plcpHsigHeaderStart)
-            {
-                psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, headerMode),
-                                                 current - plcpHsigHeaderStart,
-                                                 headerMode);
+            *psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, MfHeaderMode),
+                                              plcpHsigHeaderStart - previous,
+                                              MfHeaderMode);
+        }
 
-                psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, MfHeaderMode),
-                                                 plcpHsigHeaderStart - previous,
-                                                 MfHeaderMode);
+        //Case 4d: Current with prev in L SIG
+        else
+        {
+            //Case 4di: Non HT format (No HT-SIG or Training Symbols)
+            if (preamble == WIFI_PREAMBLE_LONG || preamble == WIFI_PREAMBLE_SHORT) //plcpHtTrainingSymbolsStart==plcpHeaderStart)
+            {
+                *psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, headerMode),
+                                                  current - previous,
+                                                  headerMode);
             }
-
-            //Case 4d: Current with prev in L SIG
             else
             {
-                //Case 4di: Non HT format (No HT-SIG or Training Symbols)
-                if (preamble == WIFI_PREAMBLE_LONG || preamble == WIFI_PREAMBLE_SHORT) //plcpHtTrainingSymbolsStart==plcpHeaderStart)
-                {
-                    psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, headerMode),
-                                                     current - previous,
-                                                     headerMode);
-                }
-                else
-                {
-                    psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, MfHeaderMode),
-                                                     current - previous,
-                                                     MfHeaderMode);
-                }
+                *psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, MfHeaderMode),
+                                                  current - previous,
+                                                  MfHeaderMode);
             }
         }
+    }
 
-        //Case 5: previous is in the preamble works for all cases
-        else
+    //Case 5: previous is in the preamble works for all cases
+    else
+    {
+        if (current >= plcpPayloadStart)
         {
-            if (current >= plcpPayloadStart)
-            {
-                //for all
-                psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, payloadMode),
-                                                 current - plcpPayloadStart,
-                                                 payloadMode);
-
-                // Non HT format (No HT-SIG or Training Symbols)
-                if (preamble == WIFI_PREAMBLE_LONG || preamble == WIFI_PREAMBLE_SHORT)
-                    psr *= CalculateChunkSuccessRate(CalculateSnr(powerW,noiseInterferenceW, headerMode),
-                                                     plcpPayloadStart - plcpHeaderStart,
-                                                     headerMode);
-                else
-                    // Greenfield or Mixed format
-                    psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, headerMode),
-                                                     plcpHtTrainingSymbolsStart - plcpHsigHeaderStart,
-                                                     headerMode);
-
-                if (preamble == WIFI_PREAMBLE_HT_MF)
-                    psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, MfHeaderMode),
-                                                     plcpHsigHeaderStart - plcpHeaderStart,
-                                                     MfHeaderMode);
-            }
-            else if (current >= plcpHtTrainingSymbolsStart)
-            {
-                // Non HT format will not come here since it will execute prev if
+            //for all
+            *psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, payloadMode),
+                                              current - plcpPayloadStart,
+                                              payloadMode);
+
+            // Non HT format (No HT-SIG or Training Symbols)
+            if (preamble == WIFI_PREAMBLE_LONG || preamble == WIFI_PREAMBLE_SHORT)
+                *psr *= CalculateChunkSuccessRate(CalculateSnr(powerW,noiseInterferenceW, headerMode),
+                                                  plcpPayloadStart - plcpHeaderStart,
+                                                  headerMode);
+            else
                 // Greenfield or Mixed format
-                psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, headerMode),
-                                                 plcpHtTrainingSymbolsStart - plcpHsigHeaderStart,
-                                                 headerMode);
-
-                if (preamble == WIFI_PREAMBLE_HT_MF)
-                    psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, MfHeaderMode),
-                                                     plcpHsigHeaderStart - plcpHeaderStart,
-                                                     MfHeaderMode);
+                *psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, headerMode),
+                                                  plcpHtTrainingSymbolsStart - plcpHsigHeaderStart,
+                                                  headerMode);
+
+            if (preamble == WIFI_PREAMBLE_HT_MF)
+                *psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, MfHeaderMode),
+                                                  plcpHsigHeaderStart - plcpHeaderStart,
+                                                  MfHeaderMode);
+        }
+        else if (current >= plcpHtTrainingSymbolsStart)
+        {
+            // Non HT format will not come here since it will execute prev if
+            // Greenfield or Mixed format
+            *psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, headerMode),
+                                              plcpHtTrainingSymbolsStart - plcpHsigHeaderStart,
+                                              headerMode);
+
+            if (preamble == WIFI_PREAMBLE_HT_MF)
+                *psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, MfHeaderMode),
+                                                  plcpHsigHeaderStart - plcpHeaderStart,
+                                                  MfHeaderMode);
+        }
+        //non HT will not come here
+        else if (current >= plcpHsigHeaderStart)
+        {
+            *psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, headerMode),
+                                              current - plcpHsigHeaderStart,
+                                              headerMode);
+            if (preamble != WIFI_PREAMBLE_HT_GF)
+            {
+                *psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, MfHeaderMode),
+                                                  plcpHsigHeaderStart - plcpHeaderStart,
+                                                  MfHeaderMode);
             }
-            //non HT will not come here
-            else if (current >= plcpHsigHeaderStart)
+        }
+        // GF will not come here
+        else if (current >= plcpHeaderStart)
+        {
+            if (preamble == WIFI_PREAMBLE_LONG || preamble == WIFI_PREAMBLE_SHORT)
             {
-                psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, headerMode),
-                                                 current - plcpHsigHeaderStart,
-                                                 headerMode);
-                if (preamble != WIFI_PREAMBLE_HT_GF)
-                {
-                    psr *= CalculateChunkSuccessRate(CalculateSnr(powerW, noiseInterferenceW, MfHeaderMode),
-                                                     plcpHsigHeaderStart - plcpHeaderStart,
-                                                     MfHeaderMode);
-                }
+                *psr *= CalculateChunkSuccessRate(CalculateSnr (powerW, noiseInterferenceW, headerMode),
+                                                  current - plcpHeaderStart,
+                                                  headerMode);
             }
-            // GF will not come here
-            else if (current >= plcpHeaderStart)
+            else
             {
-                if (preamble == WIFI_PREAMBLE_LONG || preamble == WIFI_PREAMBLE_SHORT)
-                {
-                    psr *= CalculateChunkSuccessRate(CalculateSnr (powerW, noiseInterferenceW, headerMode),
-                                                     current - plcpHeaderStart,
-                                                     headerMode);
-                }
-                else
-                {
-                    psr *= CalculateChunkSuccessRate(CalculateSnr (powerW, noiseInterferenceW, MfHeaderMode),
-                                                     current - plcpHeaderStart,
-                                                     MfHeaderMode);
-                }
+                *psr *= CalculateChunkSuccessRate(CalculateSnr (powerW, noiseInterferenceW, MfHeaderMode),
+                                                  current - plcpHeaderStart,
+                                                  MfHeaderMode);
             }
         }
-
-        noiseInterferenceW += (*j).GetDelta();
-        previous = (*j).GetTime();
-        j++;
     }
-
-    per = 1 - psr;
-
-    return per;
 }
 
 struct InterferenceHelper::SnrPer
 InterferenceHelper::CalculateSnrPer(Ptr<InterferenceHelper::Event> event)
 {
-    NiChanges ni;
-    double noiseInterferenceW = CalculateNoiseInterferenceW(event, &ni);
+    NS_ASSERT(m_rxing);
+    /* The first change is the start of the event itself: the changes after
+     * it divide the event into chunks of constant noise and interference,
+     * up to the end of the event.
+     */
+    NiChanges::const_iterator i = m_niChanges.begin();
+    NS_ASSERT(i != m_niChanges.end() && i->first == event->GetStartTime());
+    double noiseInterferenceW = m_firstPower;
     double snr = CalculateSnr(event->GetRxPowerW(),
                               noiseInterferenceW,
                               event->GetPayloadMode());
 
-    /* calculate the SNIR at the start of the packet and accumulate
-    * all SNIR changes in the snir vector.
-    */
-    double per = CalculatePer(event, &ni);
+    PlcpFields fields = GetPlcpFields(event, event->GetStartTime());
+    double psr = 1.0; /* Packet Success Rate */
+    Time previous = event->GetStartTime();
+    for (i++; i != m_niChanges.end(); i++)
+    {
+        if ((event->GetEndTime() == i->first) && event->GetRxPowerW() == -i->second)
+        {
+            break;
+        }
+        AddChunk(event, fields, previous, i->first, noiseInterferenceW, &psr);
+        noiseInterferenceW += i->second;
+        previous = i->first;
+    }
+    AddChunk(event, fields, previous, event->GetEndTime(), noiseInterferenceW, &psr);
 
     struct SnrPer snrPer;
     snrPer.snr = snr;
-    snrPer.per = per;
+    snrPer.per = 1 - psr;
 
     return snrPer;
 }
 
-void
-InterferenceHelper::EraseEvents (void)
+struct InterferenceHelper::SnrPer
+InterferenceHelper::CalculateSnrPer (uint32_t size, double rxPowerW, Time duration,
+                                     WifiTxVector txVector, enum WifiPreamble preamble) const
 {
-    m_niChanges.clear();
-    m_rxing = false;
-    m_firstPower = 0.0;
-}
+    Ptr<Event> event = Create<Event> (size, txVector.GetMode (), preamble, duration, rxPowerW, txVector);
+    PlcpFields fields = GetPlcpFields (event, event->GetStartTime ());
+    double psr = 1.0;
+    AddChunk (event, fields, event->GetStartTime (), event->GetEndTime (), 0, &psr);
 
-InterferenceHelper::NiChanges::iterator
-InterferenceHelper::GetPosition(Time moment)
-{
-    return std::upper_bound(m_niChanges.begin(), m_niChanges.end(), NiChange(moment, 0));
+    struct SnrPer snrPer;
+    snrPer.snr = CalculateSnr (rxPowerW, 0, txVector.GetMode ());
+    snrPer.per = 1 - psr;
+    return snrPer;
 }
 
 void
-InterferenceHelper::AddNiChangeEvent(NiChange change)
+InterferenceHelper::EraseEvents (void)
 {
-    m_niChanges.insert(GetPosition(change.GetTime()), change);
+    m_niChanges.clear();
+    m_rxing = false;
+    m_firstPower = 0.0;
 }
 
 void
@@ -558,6 +529,9 @@ void
 InterferenceHelper::NotifyRxEnd ()
 {
     m_rxing = false;
+    // the changes before now no longer matter to the receptions and
+    // energy durations to come
+    FoldChanges (Simulator::Now (), false);
 }
 
 } // namespace ns3
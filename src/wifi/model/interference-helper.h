@@ -23,6 +23,7 @@
 #include <stdint.h>
 #include <vector>
 #include <list>
+#include <map>
 #include "wifi-mode.h"
 #include "wifi-preamble.h"
 #include "wifi-phy-standard.h"
@@ -185,13 +186,26 @@ private:
                                       Time duration, double rxPower, WifiTxVector txvector);
 
   /**
-   * Calculate the SNIR at the start of the packet and accumulate
-   * all SNIR changes in the snir vector.
+   * Calculate the SNIR at the start of the packet and the PER of the
+   * packet, walking once the interference changes during the packet.
    *
    * \param event the event corresponding to the first time the packet arrives
    * \return struct of SNR and PER
    */
   struct InterferenceHelper::SnrPer CalculateSnrPer (Ptr<InterferenceHelper::Event> event);
+  /**
+   * Calculate the SNR and PER of a signal received without interference,
+   * without adding it to the interference helper.
+   *
+   * \param size packet size
+   * \param rxPowerW receive power (w)
+   * \param duration the duration of the signal
+   * \param txVector TXVECTOR of the packet
+   * \param preamble preamble type
+   * \return struct of SNR and PER
+   */
+  struct InterferenceHelper::SnrPer CalculateSnrPer (uint32_t size, double rxPowerW, Time duration,
+                                                     WifiTxVector txVector, enum WifiPreamble preamble) const;
   /**
    * Notify that RX has started.
    */
@@ -207,51 +221,29 @@ private:
 
 private:
   /**
-   * Noise and Interference (thus Ni) event.
-   */
-  class NiChange
-  {
-    public:
-        /**
-         * Create a NiChange at the given time and the amount of NI change.
-         *
-         * \param time time of the event
-         * \param delta the power
-         */
-        NiChange (Time time, double delta);
-        /**
-         * Return the event time.
-         *
-         * \return the event time.
-         */
-        Time GetTime (void) const;
-        /**
-         * Return the power
-         *
-         * \return the power
-         */
-        double GetDelta (void) const;
-        /**
-         * Compare the event time of two NiChange objects (a < o).
-         *
-         * \param o
-         * \return true if a < o.time, false otherwise
-         */
-        bool operator < (const NiChange& o) const;
-
-    private:
-        Time m_time;
-        double m_delta;
-
-  };
-  /**
-   * typedef for a vector of NiChanges
+   * Noise and Interference (thus Ni) changes: the power delta of each
+   * start (positive) and end (negative) of a signal, sorted by time. The
+   * changes of the same time keep their insertion order.
    */
-  typedef std::vector<NiChange> NiChanges;
+  typedef std::multimap<Time, double> NiChanges;
   /**
    * typedef for a list of Events
    */
   typedef std::list<Ptr<Event> > Events;
+  /**
+   * Start times of the PLCP fields of an event and the modes they are sent with.
+   */
+  struct PlcpFields
+  {
+    Time headerStart;            //!< packet start + preamble
+    Time hsigHeaderStart;        //!< + L-SIG
+    Time htTrainingSymbolsStart; //!< + HT-SIG
+    Time payloadStart;           //!< + training symbols
+    WifiMode payloadMode;
+    WifiMode headerMode;
+    WifiMode mfHeaderMode;       //!< L-SIG mode, for the HT mixed format only
+    enum WifiPreamble preamble;
+  };
 
   //InterferenceHelper (const InterferenceHelper &o);
   //InterferenceHelper &operator = (const InterferenceHelper &o);
@@ -262,13 +254,13 @@ private:
    */
   void AppendEvent (Ptr<Event> event);
   /**
-   * Calculate noise and interference power in W.
+   * Fold the changes before moment (included if inclusive) into
+   * m_firstPower and drop them.
    *
-   * \param event
-   * \param ni
-   * \return noise and interference power
+   * \param moment
+   * \param inclusive
    */
-  double CalculateNoiseInterferenceW (Ptr<Event> event, NiChanges *ni) const;
+  void FoldChanges (Time moment, bool inclusive);
   /**
    * Calculate SNR (linear ratio) from the given signal power and noise+interference power.
    * (Mode is not currently used)
@@ -290,29 +282,34 @@ private:
    */
   double CalculateChunkSuccessRate (double snir, Time duration, WifiMode mode) const;
   /**
-   * Calculate the error rate of the given packet. The packet can be divided into
-   * multiple chunks (e.g. due to interference from other transmissions).
+   * Return the PLCP fields of an event received from start.
+   *
+   * \param event
+   * \param start
+   * \return the PLCP fields
+   */
+  PlcpFields GetPlcpFields (Ptr<const Event> event, Time start) const;
+  /**
+   * Multiply psr by the success rate of the part of the event between
+   * previous and current, received with a constant noise and interference.
+   * A packet is divided into such chunks by the changes of interference.
    *
    * \param event
-   * \param ni
-   * \return the error rate of the packet
+   * \param fields the PLCP fields of the event
+   * \param previous start of the chunk
+   * \param current end of the chunk
+   * \param noiseInterferenceW noise and interference power (W) in the chunk
+   * \param psr the packet success rate to update
    */
-  double CalculatePer (Ptr<const Event> event, NiChanges *ni) const;
+  void AddChunk (Ptr<const Event> event, const PlcpFields &fields, Time previous, Time current,
+                 double noiseInterferenceW, double *psr) const;
 
   double m_noiseFigure; /**< noise figure (linear) */
   Ptr<ErrorRateModel> m_errorRateModel;
   /// Experimental: needed for energy duration calculation
   NiChanges m_niChanges;
-  double m_firstPower;
+  double m_firstPower;  //!< power of the signals whose changes were dropped
   bool m_rxing;
-  /// Returns an iterator to the first nichange, which is later than moment
-  NiChanges::iterator GetPosition (Time moment);
-  /**
-   * Add NiChange to the list at the appropriate position.
-   *
-   * \param change
-   */
-  void AddNiChangeEvent (NiChange change);
 };
 
 } // namespace ns3
@@ -39,6 +39,7 @@
 #include "ampdu-tag.h"
 #include "wifi-mac-queue.h"
 #include "mpdu-aggregator.h"
+#include <algorithm>
 
 #undef NS_LOG_APPEND_CONTEXT
 #define NS_LOG_APPEND_CONTEXT std::clog << "[mac=" << m_self << "] "
@@ -117,13 +118,23 @@ MacLowBlockAckEventListener::GetNRetryNeededPackets (Mac48Address recipient, uin
 {
     return 0;
 }
+Ptr<const Packet>
+MacLowBlockAckEventListener::PeekReverseDirectionPacket (Mac48Address, WifiMacHeader *)
+{
+  return 0;
+}
+void
+MacLowBlockAckEventListener::StartReverseDirection (Mac48Address, Time)
+{
+}
 
 MacLowTransmissionParameters::MacLowTransmissionParameters ()
   : m_nextSize (0),
     m_waitAck (ACK_NONE),
     m_sendRts (false),
     m_overrideDurationId (Seconds (0)),
-    m_currentSpEnd (Seconds(0))
+    m_currentSpEnd (Seconds(0)),
+    m_currentSpIsolated (false)
 {}
 
 void
@@ -288,6 +299,18 @@ MacLowTransmissionParameters::GetCurrentSpEnd(void) const
   return m_currentSpEnd;
 }
 
+void
+MacLowTransmissionParameters::SetCurrentSpIsolated(bool isolated)
+{
+  m_currentSpIsolated = isolated;
+}
+
+bool
+MacLowTransmissionParameters::IsCurrentSpIsolated(void) const
+{
+  return m_currentSpIsolated;
+}
+
 std::ostream &operator << (std::ostream &os, const MacLowTransmissionParameters &params)
 {
   os << "["
@@ -394,7 +417,15 @@ MacLow::MacLow ()
     m_dmgBeaconInterval (0),
     m_isDmg (false),
     m_propagationGuard (NanoSeconds(0)),
-    m_dmgAckTimeoutGuard (MicroSeconds(1))
+    m_dmgAckTimeoutGuard (MicroSeconds(1)),
+    m_spFastForward (false),
+    m_spTailPacking (false),
+    m_reverseDirection (false),
+    m_rdGranted (false),
+    m_rdPending (false),
+    m_spOpen (false),
+    m_spInExchange (false),
+    m_spTailRefused (false)
 {
   NS_LOG_FUNCTION (this);
   m_lastNavDuration = Seconds (0);
@@ -402,7 +433,7 @@ MacLow::MacLow ()
   m_promisc = false;
   m_ampdu = false;
   m_sentMpdus = 0;
-  m_aggregateQueue = CreateObject<WifiMacQueue> ();
+  m_currentAmpdu = Create<AmpduContainer> ();
   m_macSampling = "00:00:00:00:00:00";
   m_seqSampling = 0;
 }
@@ -455,7 +486,7 @@ MacLow::DoDispose (void)
     }
   m_mpduAggregator = 0;
   m_sentMpdus = 0;
-  m_aggregateQueue = 0;
+  m_currentAmpdu = 0;
   m_ampdu = false;
 }
 
@@ -702,18 +733,7 @@ MacLow::RegisterDcfListener (MacLowDcfListener *listener)
 
 bool MacLow::IsAmpdu(Ptr<const Packet> packet, const WifiMacHeader hdr)
 {
-    uint32_t size, actualSize;
-    WifiMacTrailer fcs;
-    size = packet->GetSize() + hdr.GetSize() + fcs.GetSerializedSize();
-    Ptr<Packet> p = AggregateToAmpdu(packet, hdr);
-    actualSize = p->GetSize();
-    if (actualSize > size)
-    {
-	m_currentPacket = p;
-	return true;
-    }
-    else
-	return false;
+    return AggregateToAmpdu(packet, hdr);
 }
 
 void MacLow::StartTransmission (Ptr<const Packet> packet,
@@ -738,26 +758,28 @@ void MacLow::StartTransmission (Ptr<const Packet> packet,
     */
     m_currentHdr = *hdr;
     CancelAllEvents();
+    EndSpExchange();
     m_listener = listener;
     m_txParams = params;
+    m_spTailRefused = false;
 
     //NS_ASSERT (m_phy->IsStateIdle ());
 
-    if(m_aggregateQueue->GetSize() == 0)
+    if(m_currentAmpdu->IsEmpty())
     {
 	m_currentPacket = packet->Copy();
 	m_ampdu = IsAmpdu(m_currentPacket, m_currentHdr);
     }
     else
     {
-	/*m_aggregateQueue > 0 occurs when a RTS/CTS exchange failed before an A-MPDU transmission.
+	/*m_currentAmpdu not empty occurs when a RTS/CTS exchange failed before an A-MPDU transmission.
 	*In that case, we transmit the same A-MPDU as previously.
 	*/
-	m_sentMpdus = m_aggregateQueue->GetSize ();
+	m_sentMpdus = m_currentAmpdu->GetNMpdus ();
 	m_ampdu = true;
     }
 
-    NS_LOG_DEBUG ("startTx size=" << GetSize (m_currentPacket, &m_currentHdr) <<
+    NS_LOG_DEBUG ("startTx size=" << GetCurrentSize () <<
 		    ", to=" << m_currentHdr.GetAddr1 () << ", listener=" << m_listener);
 
     if (m_ampdu)
@@ -802,15 +824,12 @@ MacLow::ReceiveError (Ptr<const Packet> packet, double rxSnr)
   NS_LOG_FUNCTION (this << packet << rxSnr);
   NS_LOG_DEBUG ("rx failed ");
   AmpduTag ampdu;
-  Ptr<Packet> pkt = packet->Copy();
-  bool isInAmpdu = pkt->RemovePacketTag(ampdu);
+  bool isInAmpdu = packet->PeekPacketTag(ampdu);
 
   if(isInAmpdu && m_receivedAtLeastOneMpdu && (ampdu.GetNoOfMpdus() == 1))
     {
-      MpduAggregator::DeaggregatedMpdus packets =  MpduAggregator::Deaggregate (pkt);
-      MpduAggregator::DeaggregatedMpdusCI n = packets.begin ();
       WifiMacHeader hdr;
-      (*n).first->PeekHeader(hdr);
+      AmpduContainer::PeekMacHeader (packet, hdr);
       if(hdr.IsQosData())
         {
           NS_LOG_DEBUG ("last a-mpdu subframe detected/sendImmediateBlockAck from=" << hdr.GetAddr2 ());
@@ -974,6 +993,11 @@ void MacLow::ReceiveOk (Ptr<Packet> packet, double rxSnr, WifiMode txMode, WifiP
         }
       if (gotAck)
         {
+          for (uint32_t i = 0; m_spInExchange && i < m_spInFlight.size (); i++)
+            {
+              m_spStats.bytes += m_spInFlight[i].second;
+            }
+          EndSpExchange ();
           m_listener->GotAck (rxSnr, txMode);
         }
       if (m_txParams.HasNextPacket ())
@@ -989,9 +1013,34 @@ void MacLow::ReceiveOk (Ptr<Packet> packet, double rxSnr, WifiMode txMode, WifiP
       NS_LOG_DEBUG ("got block ack from " << hdr.GetAddr2 ());
       CtrlBAckResponseHeader blockAck;
       packet->RemoveHeader (blockAck);
+      for (uint32_t i = 0; m_spInExchange && i < m_spInFlight.size (); i++)
+        {
+          if (blockAck.IsPacketReceived (m_spInFlight[i].first))
+            {
+              m_spStats.bytes += m_spInFlight[i].second;
+            }
+        }
+      EndSpExchange ();
       m_blockAckTimeoutEvent.Cancel ();
       NotifyAckTimeoutResetNow ();
-      m_listener->GotBlockAck (&blockAck, hdr.GetAddr2 (),txMode);
+      m_stationManager->ReportRxOk (hdr.GetAddr2 (), &hdr, rxSnr, txMode);
+      if (m_rdGranted && hdr.GetDuration () > Seconds (0))
+        {
+          /* The destination uses the grant: the BlockAck is notified at
+           * the end of its exchange, or of the grant if its PPDU is lost */
+          NS_LOG_DEBUG ("reverse direction PPDU announced by " << hdr.GetAddr2 () << " for " << hdr.GetDuration ());
+          m_rdPending = true;
+          m_rdBlockAck = blockAck;
+          m_rdPeer = hdr.GetAddr2 ();
+          m_rdMode = txMode;
+          m_rdStart = Simulator::Now ();
+          m_rdEndEvent = Simulator::Schedule (hdr.GetDuration (), &MacLow::EndReverseDirection, this);
+        }
+      else
+        {
+          m_listener->GotBlockAck (&blockAck, hdr.GetAddr2 (),txMode);
+        }
+      m_rdGranted = false;
       m_sentMpdus = 0;
       m_ampdu = false;
 
@@ -1318,6 +1367,16 @@ MacLow::GetSize (Ptr<const Packet> packet, const WifiMacHeader *hdr) const
   return size;
 }
 
+uint32_t
+MacLow::GetCurrentSize (void) const
+{
+  if (m_ampdu)
+    {
+      return m_currentAmpdu->GetSize ();
+    }
+  return GetSize (m_currentPacket, &m_currentHdr);
+}
+
 WifiTxVector
 MacLow::GetCtsToSelfTxVector (Ptr<const Packet> packet, const WifiMacHeader *hdr) const
 {
@@ -1570,35 +1629,51 @@ void MacLow::ForwardDown(Ptr<const Packet> packet, const WifiMacHeader* hdr,
     }
     else
     {
-	Ptr<Packet> newPacket;
-	Ptr <const Packet> dequeuedPacket;
-	WifiMacHeader newHdr;
-	WifiMacTrailer fcs;
-	uint32_t queueSize = m_aggregateQueue->GetSize();
-	bool last = false;
+	uint32_t nMpdus = m_currentAmpdu->GetNMpdus();
 	uint8_t packetType = 0;
-	//Add packet tag
-	AmpduTag ampdutag;
-	ampdutag.SetAmpdu(true);
 	Time delay = Seconds(0);
 
-	NS_LOG_DEBUG("Sending " << queueSize << " MPDUS as part of A-MPDU " << Simulator::Now ()<< " from "<< m_currentHdr.GetAddr2()<<" to "<< m_currentHdr.GetAddr1());
+	NS_LOG_DEBUG("Sending " << nMpdus << " MPDUS as part of A-MPDU " << Simulator::Now ()<< " from "<< m_currentHdr.GetAddr2()<<" to "<< m_currentHdr.GetAddr1());
+
+	// The MPDUs are serialized only now, one at a time, from the
+	// references kept by the container
+	m_currentAmpdu->SetDuration(hdr->GetDuration());
+	std::vector<Ptr<const Packet> > subframes;
+	subframes.reserve(nMpdus);
+	for (uint32_t i = 0; i < nMpdus; i++)
+        {
+	    uint32_t queueSize = nMpdus - i;
+	    Ptr<Packet> newPacket = m_currentAmpdu->GetMpdu(i);
+	    m_mpduAggregator->AddHeaderAndPad(newPacket, queueSize == 1);
+	    //Add packet tag
+	    AmpduTag ampdutag;
+	    ampdutag.SetAmpdu(true);
+	    ampdutag.SetNoOfMpdus(queueSize);
+	    newPacket->AddPacketTag(ampdutag);
+	    subframes.push_back(newPacket);
+	    if (m_spOpen && m_currentAmpdu->GetHeader(i).IsQosData())
+	    {
+		m_spInFlight.push_back(std::make_pair(m_currentAmpdu->GetHeader(i).GetSequenceNumber(),
+						      m_currentAmpdu->GetPayload(i)->GetSize()));
+	    }
+        }
+	m_currentAmpdu->Clear();
+
+	// No other link can overlap an isolated SP: the PHY may deliver the
+	// whole A-MPDU at once
+	if (m_spFastForward && m_txParams.IsCurrentSpIsolated()
+	    && m_phy->SendPpdu(subframes, txVector, preamble))
+	{
+	    return;
+	}
 
-	for ( ; queueSize > 0; queueSize--)
+	for (uint32_t i = 0; i < nMpdus; i++)
         {
-	    dequeuedPacket = m_aggregateQueue->Dequeue(&newHdr);
-	    newPacket = dequeuedPacket->Copy();
-	    newHdr.SetDuration(hdr->GetDuration());
-	    newPacket->AddHeader(newHdr);
-	    newPacket->AddTrailer(fcs);
+	    uint32_t queueSize = nMpdus - i;
+	    Ptr<const Packet> newPacket = subframes[i];
 	    if (queueSize == 1) {
-                last = true;
                 packetType = 2; // Last packet in A-MPDU
            }
-	    m_mpduAggregator->AddHeaderAndPad(newPacket, last);
-
-	    ampdutag.SetNoOfMpdus(queueSize);
-	    newPacket->AddPacketTag(ampdutag);
 	    if (delay == Seconds(0))
                 {
                 if (queueSize != 1) {
@@ -1611,7 +1686,7 @@ void MacLow::ForwardDown(Ptr<const Packet> packet, const WifiMacHeader* hdr,
 		Simulator::Schedule(delay, &MacLow::SendPacket, this, newPacket, txVector, preamble, packetType);
             }
 	    if(queueSize > 1)
-		delay = delay + m_phy->CalculateTxDuration(GetSize(newPacket, &newHdr), txVector, preamble, m_phy->GetFrequency(), packetType, 0) + Seconds(1e-9);
+		delay = delay + m_phy->CalculateTxDuration(newPacket->GetSize(), txVector, preamble, m_phy->GetFrequency(), packetType, 0) + Seconds(1e-9);
 	    preamble = WIFI_PREAMBLE_NONE;
         }
     }
@@ -1651,6 +1726,7 @@ MacLow::NormalAckTimeout (void)
   /// \todo should check that there was no rx start before now.
   /// we should restart a new ack timeout now until the expected
   /// end of rx if there was a rx start before now.
+  EndSpExchange ();
   m_stationManager->ReportDataFailed (m_currentHdr.GetAddr1 (), &m_currentHdr);
   MacLowTransmissionListener *listener = m_listener;
   m_listener = 0;
@@ -1682,6 +1758,7 @@ MacLow::BlockAckTimeout (void)
 {
   NS_LOG_FUNCTION (this);
   NS_LOG_UNCOND (Simulator::Now ()<<"block ack timeout. from "<< m_currentHdr.GetAddr2()<<" to "<< m_currentHdr.GetAddr1());
+  EndSpExchange ();
 
   m_stationManager->ReportDataFailed (m_currentHdr.GetAddr1 (), &m_currentHdr);
   MacLowTransmissionListener *listener = m_listener;
@@ -1748,7 +1825,7 @@ MacLow::SendRtsForPacket (void)
       duration += GetSifs ();
       duration += GetCtsDuration (m_currentHdr.GetAddr1 (), rtsTxVector);
       duration += GetSifs ();
-      duration += m_phy->CalculateTxDuration (GetSize (m_currentPacket, &m_currentHdr),
+      duration += m_phy->CalculateTxDuration (GetCurrentSize (),
                                               dataTxVector, preamble, m_phy->GetFrequency(), 0, 0);
       duration += GetSifs ();
       if (m_txParams.MustWaitBasicBlockAck ())
@@ -1806,7 +1883,7 @@ MacLow::StartDataTxTimers (WifiTxVector dataTxVector)
   else
     preamble=WIFI_PREAMBLE_LONG;
  
-  Time txDuration = m_phy->CalculateTxDuration (GetSize (m_currentPacket, &m_currentHdr), dataTxVector, preamble, m_phy->GetFrequency(), 0, 0);
+  Time txDuration = m_phy->CalculateTxDuration (GetCurrentSize (), dataTxVector, preamble, m_phy->GetFrequency(), 0, 0);
   if (m_txParams.MustWaitNormalAck ())
     {
       Time timerDelay;
@@ -1842,12 +1919,10 @@ MacLow::StartDataTxTimers (WifiTxVector dataTxVector)
     }
   else if (m_txParams.MustWaitBasicBlockAck ())
     {
-      WifiMacHeader hdr;
-      m_currentPacket->PeekHeader (hdr);
       Time timerDelay;
       if (m_isDmg) {
 	timerDelay = txDuration + GetSifs() +
-		GetBlockAckDuration(hdr.GetAddr1(), dataTxVector, BASIC_BLOCK_ACK) +
+		GetBlockAckDuration(m_currentHdr.GetAddr1(), dataTxVector, BASIC_BLOCK_ACK) +
 		m_dmgAckTimeoutGuard + m_propagationGuard * 2;
       } else {
         timerDelay = txDuration + GetBasicBlockAckTimeout ();
@@ -1858,12 +1933,10 @@ MacLow::StartDataTxTimers (WifiTxVector dataTxVector)
     }
   else if (m_txParams.MustWaitCompressedBlockAck ())
     {
-      WifiMacHeader hdr;
-      m_currentPacket->PeekHeader (hdr);
       Time timerDelay;
       if (m_isDmg) {
 	      timerDelay = txDuration + GetSifs() +
-		    GetBlockAckDuration(hdr.GetAddr1(), dataTxVector, COMPRESSED_BLOCK_ACK) +
+		    GetBlockAckDuration(m_currentHdr.GetAddr1(), dataTxVector, COMPRESSED_BLOCK_ACK) +
 		    m_dmgAckTimeoutGuard + m_propagationGuard * 2;
       } else {
         timerDelay = txDuration + GetCompressedBlockAckTimeout ();
@@ -1990,8 +2063,35 @@ void MacLow::SendDataPacket (void)
             }
         }
     }
+    m_rdGranted = false;
+    if (!m_txParams.HasDurationId() && m_txParams.MustWaitCompressedBlockAck())
+    {
+        Time grant = GetReverseDirectionGrant(m_phy->CalculateTxDuration(GetCurrentSize(), dataTxVector, preamble, m_phy->GetFrequency(), 0, 0));
+        if (grant > duration)
+        {
+            duration = grant;
+            m_rdGranted = true;
+        }
+    }
     m_currentHdr.SetDuration(duration);
 
+    uint32_t size = GetCurrentSize();
+    if (m_spOpen)
+    {
+	if (m_spStats.nPpdus == 0)
+	{
+	    m_spStats.switchNs = Simulator::Now().GetNanoSeconds() - m_spStats.startNs;
+	}
+	m_spStats.nPpdus++;
+	m_spStats.nMpdus += m_ampdu ? m_currentAmpdu->GetNMpdus() : 1;
+	m_spInExchange = true;
+	m_spExchangeStart = Simulator::Now();
+	m_spInFlight.clear();
+	if (!m_ampdu && m_currentHdr.IsQosData())
+	{
+	    m_spInFlight.push_back(std::make_pair(m_currentHdr.GetSequenceNumber(), m_currentPacket->GetSize()));
+	}
+    }
     if (!m_ampdu)
     {
 	m_currentPacket->AddHeader(m_currentHdr);
@@ -2000,7 +2100,7 @@ void MacLow::SendDataPacket (void)
     }
 
         //NS_LOG_UNCOND("MPDUS: " << m_maxNumMpdu );
-        if (m_aggregateQueue->GetSize() == m_maxNumMpdu && m_currentPacket->GetSize() > 100)
+        if (m_currentAmpdu->GetNMpdus() == m_maxNumMpdu && size > 100)
         {
 
                 //check if records exists for this ip, if not, then create one
@@ -2075,7 +2175,7 @@ MacLow::SendCtsToSelf (void)
     {
       WifiTxVector dataTxVector = GetDataTxVector (m_currentPacket, &m_currentHdr);
       duration += GetSifs ();
-      duration += m_phy->CalculateTxDuration (GetSize (m_currentPacket,&m_currentHdr),
+      duration += m_phy->CalculateTxDuration (GetCurrentSize (),
                                               dataTxVector, preamble, m_phy->GetFrequency(), 0, 0);
       if (m_txParams.MustWaitBasicBlockAck ())
         {
@@ -2226,7 +2326,7 @@ MacLow::SendDataAfterCts (Mac48Address source, Time duration, WifiMode txMode)
         }
     }
 
-  Time txDuration = m_phy->CalculateTxDuration (GetSize (m_currentPacket, &m_currentHdr),dataTxVector, preamble, m_phy->GetFrequency(), 0, 0);
+  Time txDuration = m_phy->CalculateTxDuration (GetCurrentSize (),dataTxVector, preamble, m_phy->GetFrequency(), 0, 0);
   duration -= txDuration;
   duration -= GetSifs ();
 
@@ -2254,6 +2354,7 @@ MacLow::WaitSifsAfterEndTx (void)
 void 
 MacLow::EndTxNoAck (void)
 {
+  EndSpExchange ();
   MacLowTransmissionListener *listener = m_listener;
   m_listener = 0;
   listener->EndTxNoAck ();
@@ -2360,20 +2461,15 @@ MacLow::StoreMpduIfNeeded (Ptr<Packet> packet, WifiMacHeader hdr)
   AgreementsI it = m_bAckAgreements.find (std::make_pair (hdr.GetAddr2 (), hdr.GetQosTid ()));
   if (it != m_bAckAgreements.end ())
     {
+      NS_ASSERT_MSG (hdr.GetFragmentNumber () == 0 && !hdr.IsMoreFragments (),
+                     "Fragments are not supported under a block ack agreement");
       WifiMacTrailer fcs;
       packet->RemoveTrailer (fcs);
-      BufferedPacket bufferedPacket (packet, hdr);
 
-      uint16_t endSequence = ((*it).second.first.GetStartingSequence () + 2047) % 4096;
-      uint16_t mappedSeqControl = QosUtilsMapSeqControlToUniqueInteger (hdr.GetSequenceControl (), endSequence);
-
-      BufferedPacketI i = (*it).second.second.begin ();
-      for (; i != (*it).second.second.end ()
-           && QosUtilsMapSeqControlToUniqueInteger ((*i).second.GetSequenceControl (), endSequence) < mappedSeqControl; i++)
-        {
-          ;
-        }
-      (*it).second.second.insert (i, bufferedPacket);
+      ReorderBuffer &buffer = (*it).second.second;
+      uint16_t seq = hdr.GetSequenceNumber ();
+      buffer.packets.Insert (seq, BufferedPacket (packet, hdr));
+      buffer.stored.Set (seq);
 
       //Update block ack cache
       BlockAckCachesI j = m_bAckCaches.find (std::make_pair (hdr.GetAddr2 (), hdr.GetQosTid ()));
@@ -2403,7 +2499,7 @@ MacLow::CreateBlockAckAgreement (const MgtAddBaResponseHeader *respHdr, Mac48Add
   agreement.SetTimeout (respHdr->GetTimeout ());
   agreement.SetStartingSequence (startingSeq);
 
-  std::list<BufferedPacket> buffer (0);
+  ReorderBuffer buffer;
   AgreementKey key (originator, respHdr->GetTid ());
   AgreementValue value (agreement, buffer);
   m_bAckAgreements.insert (std::make_pair (key, value));
@@ -2448,60 +2544,18 @@ MacLow::RxCompleteBufferedPacketsWithSmallerSequence (uint16_t seq, Mac48Address
   AgreementsI it = m_bAckAgreements.find (std::make_pair (originator, tid));
   if (it != m_bAckAgreements.end ())
     {
-      uint16_t endSequence = ((*it).second.first.GetStartingSequence () + 2047) % 4096;
-      uint16_t mappedStart = QosUtilsMapSeqControlToUniqueInteger (seq << 4, endSequence);
-      BufferedPacketI last = (*it).second.second.begin ();
-      uint16_t guard = 0;
-      if (last != (*it).second.second.end ())
+      /* The old packets are the ones in the half of the sequence number
+         space before the starting sequence */
+      ReorderBuffer &buffer = (*it).second.second;
+      uint16_t oldest = ((*it).second.first.GetStartingSequence () + 2048) % 4096;
+      uint32_t count = (seq - oldest + 4096) % 4096;
+      uint16_t next;
+      while (buffer.stored.FindFirst (oldest, count, next))
         {
-          guard = (*it).second.second.begin ()->second.GetSequenceControl () & 0xfff0;
+          RxBufferedPacket (buffer, next);
+          count -= (next - oldest + 4096) % 4096 + 1;
+          oldest = (next + 1) % 4096;
         }
-      BufferedPacketI i = (*it).second.second.begin ();
-      for (; i != (*it).second.second.end ()
-	   && QosUtilsMapSeqControlToUniqueInteger ((*i).second.GetSequenceControl (), endSequence) < mappedStart;)
-        {
-          if (guard == (*i).second.GetSequenceControl ())
-            {
-              if (!(*i).second.IsMoreFragments ())
-                {
-                  while (last != i)
-                    {
-                      m_rxCallback ((*last).first, &(*last).second);
-                      last++;
-                    }
-                  m_rxCallback ((*last).first, &(*last).second);
-                  last++;
-                  /* go to next packet */
-                  while (i != (*it).second.second.end () && ((guard >> 4) & 0x0fff) == (*i).second.GetSequenceNumber ())
-                    {
-                      i++;
-                    }
-                  if (i != (*it).second.second.end ())
-                    {
-                      guard = (*i).second.GetSequenceControl () & 0xfff0;
-                      last = i;
-                    }
-                }
-              else
-                {
-                  guard++;
-                }
-            }
-          else
-            {
-              /* go to next packet */
-              while (i != (*it).second.second.end () && ((guard >> 4) & 0x0fff) == (*i).second.GetSequenceNumber ())
-                {
-                  i++;
-                }
-              if (i != (*it).second.second.end ())
-                {
-                  guard = (*i).second.GetSequenceControl () & 0xfff0;
-                  last = i;
-                }
-            }
-        }
-      (*it).second.second.erase ((*it).second.second.begin (), i);
     }
 }
 
@@ -2511,31 +2565,26 @@ MacLow::RxCompleteBufferedPacketsUntilFirstLost (Mac48Address originator, uint8_
   AgreementsI it = m_bAckAgreements.find (std::make_pair (originator, tid));
   if (it != m_bAckAgreements.end ())
     {
-      uint16_t startingSeqCtrl = ((*it).second.first.GetStartingSequence () << 4) & 0xfff0;
-      uint16_t guard = startingSeqCtrl;
-
-      BufferedPacketI lastComplete = (*it).second.second.begin ();
-      BufferedPacketI i = (*it).second.second.begin ();
-      for (; i != (*it).second.second.end () && guard == (*i).second.GetSequenceControl (); i++)
+      ReorderBuffer &buffer = (*it).second.second;
+      uint16_t seq = (*it).second.first.GetStartingSequence ();
+      while (buffer.stored.IsSet (seq))
         {
-          if (!(*i).second.IsMoreFragments ())
-            {
-              while (lastComplete != i)
-                {
-                  m_rxCallback ((*lastComplete).first, &(*lastComplete).second);
-                  lastComplete++;
-                }
-              m_rxCallback ((*lastComplete).first, &(*lastComplete).second);
-              lastComplete++;
-            }
-          guard = (*i).second.IsMoreFragments () ? (guard + 1) : ((guard + 16) & 0xfff0);
+          RxBufferedPacket (buffer, seq);
+          seq = (seq + 1) % 4096;
         }
-      (*it).second.first.SetStartingSequence ((guard >> 4) & 0x0fff);
-      /* All packets already forwarded to WifiMac must be removed from buffer:
-      [begin (), lastComplete) */
-      (*it).second.second.erase ((*it).second.second.begin (), lastComplete);
+      (*it).second.first.SetStartingSequence (seq);
     }
 }
+
+void
+MacLow::RxBufferedPacket (ReorderBuffer &buffer, uint16_t seq)
+{
+  BufferedPacket packet = buffer.packets.Get (seq);
+  buffer.packets.Remove (seq);
+  buffer.stored.Reset (seq);
+  m_rxCallback (packet.first, &packet.second);
+}
+
 void
 MacLow::SendBlockAckResponse (const CtrlBAckResponseHeader* blockAck, Mac48Address originator, bool immediate,
                               Time duration, WifiMode blockAckReqTxMode)
@@ -2621,7 +2670,34 @@ MacLow::SendBlockAckAfterAmpdu (uint8_t tid, Mac48Address originator, Time durat
   NS_LOG_DEBUG ("Got Implicit block Ack Req with seq " << seqNumber);
   (*i).second.FillBlockAckBitmap (&blockAck);  
 
+  WifiTxVector blockAckTxVector = GetBlockAckTxVector (originator, blockAckReqTxMode);
+  Time blockAckDuration = GetBlockAckDuration (originator, blockAckTxVector, COMPRESSED_BLOCK_ACK);
+  if (m_reverseDirection && m_isDmg && immediate)
+    {
+      /* The Duration of the BlockAck is the rest of the grant when a
+       * reverse direction PPDU follows, 0 otherwise */
+      Time grant = duration - GetSifs () - blockAckDuration;
+      if (NeedReverseDirection (tid, originator, grant))
+        {
+          SendBlockAckResponse (&blockAck, originator, immediate, duration, blockAckReqTxMode);
+          m_rdStartEvent = Simulator::Schedule (blockAckDuration + GetSifs (),
+                                                &MacLow::StartReverseDirection, this,
+                                                QosUtilsMapTidToAc (tid), originator,
+                                                Simulator::Now () + blockAckDuration + grant);
+          return;
+        }
+      if (grant > Seconds (0))
+        {
+          duration -= grant;
+        }
+    }
   SendBlockAckResponse (&blockAck, originator, immediate, duration, blockAckReqTxMode);
+  if (m_rdPending && originator == m_rdPeer)
+    {
+      /* This BlockAck ends the reverse direction exchange */
+      m_rdEndEvent.Cancel ();
+      m_rdEndEvent = Simulator::Schedule (blockAckDuration, &MacLow::EndReverseDirection, this);
+    }
 }
 
 void
@@ -2728,22 +2804,26 @@ void MacLow::DeaggregateAmpduAndReceive(Ptr<Packet> aggregatedPacket, double rxS
     if (aggregatedPacket->RemovePacketTag(ampdu))
     {
 	ampduSubframe = true;
-	MpduAggregator::DeaggregatedMpdus packets =  MpduAggregator::Deaggregate(aggregatedPacket);
-	MpduAggregator::DeaggregatedMpdusCI n = packets.begin();
+	// The PHY delivers the subframes of an A-MPDU one at a time: the
+	// subframe header and the padding are stripped in place
+	Ptr<Packet> mpdu = aggregatedPacket;
+	AmpduSubframeHeader subframeHdr;
+	mpdu->RemoveHeader(subframeHdr);
+	mpdu->RemoveAtEnd(mpdu->GetSize() - subframeHdr.GetLength());
 
 	WifiMacHeader firsthdr;
-	(*n).first->PeekHeader(firsthdr);
+	mpdu->PeekHeader(firsthdr);
 	NS_LOG_DEBUG("duration/id=" << firsthdr.GetDuration());
-	NotifyNav((*n).first,firsthdr, txMode, preamble);
+	NotifyNav(mpdu,firsthdr, txMode, preamble);
 	if (firsthdr.GetAddr1() == m_self)
         {
 	    m_receivedAtLeastOneMpdu = true;
 	    if (firsthdr.IsAck() || firsthdr.IsBlockAck() || firsthdr.IsBlockAckReq())
-		ReceiveOk ((*n).first, rxSnr, txMode, preamble, ampduSubframe);
+		ReceiveOk (mpdu, rxSnr, txMode, preamble, ampduSubframe);
 	    else if (firsthdr.IsData() || firsthdr.IsQosData())
             {
 		NS_LOG_DEBUG ("Deaggregate packet with sequence=" << firsthdr.GetSequenceNumber ());
-		ReceiveOk((*n).first, rxSnr, txMode, preamble, ampduSubframe);
+		ReceiveOk(mpdu, rxSnr, txMode, preamble, ampduSubframe);
 		if (firsthdr.IsQosAck())
                 {
 		    NS_LOG_DEBUG("Normal Ack");
@@ -2789,7 +2869,7 @@ void MacLow::DeaggregateAmpduAndReceive(Ptr<Packet> aggregatedPacket, double rxS
     }
 }
 
-bool MacLow::StopAggregation(Ptr<const Packet> peekedPacket, WifiMacHeader peekedHdr, Ptr<Packet> aggregatedPacket, uint16_t size) const
+bool MacLow::StopAggregation(Ptr<const Packet> peekedPacket, WifiMacHeader peekedHdr, Ptr<const AmpduContainer> ampdu, uint16_t size) const
 {
     WifiPreamble preamble;
     WifiTxVector dataTxVector = GetDataTxVector(m_currentPacket, &m_currentHdr);
@@ -2808,7 +2888,7 @@ bool MacLow::StopAggregation(Ptr<const Packet> peekedPacket, WifiMacHeader peeke
         return true;
     }
     
-    Time duration = m_phy->CalculateTxDuration(aggregatedPacket->GetSize() + peekedPacket->GetSize() +
+    Time duration = m_phy->CalculateTxDuration(ampdu->GetSize() + peekedPacket->GetSize() +
 					       peekedHdr.GetSize() + WIFI_MAC_FCS_LENGTH,dataTxVector, preamble, m_phy->GetFrequency(), 0, 0);
 
     if (m_phy->GetCurrentStandard() == WIFI_PHY_STANDARD_80211ad)
@@ -2825,49 +2905,96 @@ bool MacLow::StopAggregation(Ptr<const Packet> peekedPacket, WifiMacHeader peeke
 	    return true;
     }
 
-    if (!m_mpduAggregator->CanBeAggregated(peekedPacket->GetSize() + peekedHdr.GetSize() + WIFI_MAC_FCS_LENGTH, aggregatedPacket, size)) {
+    if (!m_mpduAggregator->CanBeAggregated(peekedPacket->GetSize() + peekedHdr.GetSize() + WIFI_MAC_FCS_LENGTH, ampdu, size)) {
         return true;
     }
     
     return false;
 }
 
-bool MacLow::DmgStopAggregation(Ptr<const Packet> peekedPacket, WifiMacHeader peekedHdr, Ptr<Packet> aggregatedPacket, uint16_t size) const
+bool MacLow::DmgStopAggregation(Ptr<const Packet> peekedPacket, WifiMacHeader peekedHdr, Ptr<const AmpduContainer> ampdu, uint16_t size) const
 {
-  WifiPreamble preamble;
-  WifiTxVector dataTxVector = GetDataTxVector(m_currentPacket, &m_currentHdr);
-
   if (!m_isDmg) {
     return false;
   }
 
-  preamble = WIFI_PREAMBLE_LONG;
-
   if (peekedPacket == 0) {
     return true;
   }
 
-  Time duration = m_phy->CalculateTxDuration(aggregatedPacket->GetSize() + peekedPacket->GetSize() +
-					       peekedHdr.GetSize() + WIFI_MAC_FCS_LENGTH,dataTxVector, preamble, m_phy->GetFrequency(), 0, 0);
+  if (!DmgFitsInSp(ampdu->GetSize() + peekedPacket->GetSize() + peekedHdr.GetSize() + WIFI_MAC_FCS_LENGTH)) {
+    m_spTailRefused = true;
+    return true;
+  }
 
+  return false;
+}
 
+bool MacLow::DmgFitsInSp(uint32_t psduSize) const
+{
+  WifiTxVector dataTxVector = GetDataTxVector(m_currentPacket, &m_currentHdr);
+  Time duration = m_phy->CalculateTxDuration(psduSize, dataTxVector, WIFI_PREAMBLE_LONG, m_phy->GetFrequency(), 0, 0);
   Time blockAckDuration = GetBlockAckDuration(m_currentHdr.GetAddr1(), dataTxVector, COMPRESSED_BLOCK_ACK);
 
-  if ((Simulator::Now() + duration + GetSifs() + blockAckDuration + 2 * m_propagationGuard + m_dmgAckTimeoutGuard) >=
-      m_txParams.GetCurrentSpEnd()) {
-    return true;
-  }
+  return (Simulator::Now() + duration + GetSifs() + blockAckDuration + 2 * m_propagationGuard + m_dmgAckTimeoutGuard) <
+    m_txParams.GetCurrentSpEnd();
+}
 
-  return false;
+Ptr<const Packet>
+MacLow::PackSpTail (Ptr<const Packet> peekedPacket, WifiMacHeader *peekedHdr,
+                    Ptr<WifiMacQueue> queue, uint8_t tid, Mac48Address addr,
+                    std::pair <Ipv4Address,Ipv4Address> srcSinkIpAddr,
+                    Time *tstamp, uint16_t size, bool *packed)
+{
+  *packed = false;
+  if (!m_spTailPacking || peekedPacket == 0 ||
+      !DmgStopAggregation (peekedPacket, *peekedHdr, m_currentAmpdu, size))
+    {
+      return peekedPacket;
+    }
+  /* Largest MPDU, header and FCS included, that still fits: the duration
+   * grows with the size, so look for it by bisection */
+  uint32_t ampduSize = m_currentAmpdu->GetSize ();
+  uint32_t low = 0;
+  uint32_t high = peekedPacket->GetSize () + peekedHdr->GetSize () + WIFI_MAC_FCS_LENGTH;
+  while (high - low > 1)
+    {
+      uint32_t middle = (low + high) / 2;
+      if (DmgFitsInSp (ampduSize + middle))
+        {
+          low = middle;
+        }
+      else
+        {
+          high = middle;
+        }
+    }
+  if (low <= WIFI_MAC_FCS_LENGTH)
+    {
+      return peekedPacket;
+    }
+  WifiMacHeader hdr;
+  Time smallTstamp;
+  /* A smaller MPDU of the same flow would overtake the refused one: take
+   * the head of another flow of the TID instead */
+  Ptr<const Packet> small = queue->PeekFittingFlowHeadByTid (&hdr, tid, addr, srcSinkIpAddr,
+                                                             low - WIFI_MAC_FCS_LENGTH, &smallTstamp);
+  if (small == 0)
+    {
+      return peekedPacket;
+    }
+  NS_LOG_DEBUG ("Packing a " << small->GetSize () << " bytes MPDU in the tail of the SP");
+  *peekedHdr = hdr;
+  *tstamp = smallTstamp;
+  *packed = true;
+  return small;
 }
 
-Ptr<Packet> MacLow::AggregateToAmpdu (Ptr<const Packet> packet, const WifiMacHeader hdr)
+bool MacLow::AggregateToAmpdu (Ptr<const Packet> packet, const WifiMacHeader hdr)
 {
-    NS_ASSERT(m_aggregateQueue->GetSize() == 0);
+    NS_ASSERT(m_currentAmpdu->IsEmpty());
     bool isAmpdu = false;
-    Ptr<Packet> newPacket;
     WifiMacHeader peekedHdr;
-    newPacket = packet->Copy();
 
     //extracting ipv4 address
     std::pair <Ipv4Address,Ipv4Address> srcSinkIpAddr;
@@ -2894,7 +3021,6 @@ Ptr<Packet> MacLow::AggregateToAmpdu (Ptr<const Packet> packet, const WifiMacHea
             {
               /* here is performed mpdu aggregation */
               /* MSDU aggregation happened in edca if the user asked for it so m_currentPacket may contains a normal packet or a A-MSDU*/
-              Ptr<Packet> currentAggregatedPacket = Create<Packet> ();
               peekedHdr = hdr;
               uint16_t startingSequenceNumber = 0;
               uint16_t currentSequenceNumber = 0;
@@ -2902,7 +3028,6 @@ Ptr<Packet> MacLow::AggregateToAmpdu (Ptr<const Packet> packet, const WifiMacHea
               uint16_t blockAckSize = 0;
               bool aggregated = false;
               int i = 0;
-              Ptr<Packet> aggPacket = newPacket->Copy ();
 
               if (!hdr.IsBlockAckReq())
                 {
@@ -2912,18 +3037,14 @@ Ptr<Packet> MacLow::AggregateToAmpdu (Ptr<const Packet> packet, const WifiMacHea
                        peekedHdr.SetQosAckPolicy (WifiMacHeader::NORMAL_ACK);
                     }
                   currentSequenceNumber = peekedHdr.GetSequenceNumber();
-                  newPacket->AddHeader (peekedHdr);
-                  WifiMacTrailer fcs;
-                  newPacket->AddTrailer (fcs);
 
-                  aggregated=m_mpduAggregator->Aggregate (newPacket, currentAggregatedPacket);
+                  aggregated=m_mpduAggregator->Aggregate (packet, peekedHdr, m_currentAmpdu);
 
                   if (aggregated)
                     {
                       NS_LOG_DEBUG ("Adding packet with Sequence number " << peekedHdr.GetSequenceNumber()<<" to A-MPDU");
                       i++;
                       m_sentMpdus++;
-                      m_aggregateQueue->Enqueue (aggPacket, peekedHdr);
                     }
                 } 
               else if (hdr.IsBlockAckReq())
@@ -2936,6 +3057,7 @@ Ptr<Packet> MacLow::AggregateToAmpdu (Ptr<const Packet> packet, const WifiMacHea
                 }
               aggregated = false;
               bool retry = false;
+              bool packed = false;
               //looks for other packets to the same destination with the same Tid need to extend that to include MSDUs
               // (RUI: to double check this)
               Ptr<const Packet> peekedPacket = listenerIt->second->PeekNextPacketInBaQueue (peekedHdr, peekedHdr.GetAddr1 (), tid, &tstamp);
@@ -2944,6 +3066,8 @@ Ptr<Packet> MacLow::AggregateToAmpdu (Ptr<const Packet> packet, const WifiMacHea
                   peekedPacket = queue->PeekByTidAndAddress (&peekedHdr, tid,
                                                              WifiMacHeader::ADDR1,
                                                              hdr.GetAddr1 (), srcSinkIpAddr, &tstamp);
+                  peekedPacket = PackSpTail (peekedPacket, &peekedHdr, queue, tid, hdr.GetAddr1 (),
+                                             srcSinkIpAddr, &tstamp, blockAckSize, &packed);
                   currentSequenceNumber = listenerIt->second->PeekNextSequenceNumberfor (&peekedHdr);
                 }
               else
@@ -2953,8 +3077,8 @@ Ptr<Packet> MacLow::AggregateToAmpdu (Ptr<const Packet> packet, const WifiMacHea
                 }
 
                while (IsInWindow (currentSequenceNumber, startingSequenceNumber, 64) &&
-                   !StopAggregation (peekedPacket, peekedHdr, currentAggregatedPacket, blockAckSize) &&
-                   !DmgStopAggregation (peekedPacket, peekedHdr, currentAggregatedPacket, blockAckSize))
+                   !StopAggregation (peekedPacket, peekedHdr, m_currentAmpdu, blockAckSize) &&
+                   !DmgStopAggregation (peekedPacket, peekedHdr, m_currentAmpdu, blockAckSize))
                 {
                   //for now always send AMPDU with normal ACK
                   if (retry == false)
@@ -2971,16 +3095,9 @@ Ptr<Packet> MacLow::AggregateToAmpdu (Ptr<const Packet> packet, const WifiMacHea
                       peekedHdr.SetQosAckPolicy (WifiMacHeader::BLOCK_ACK);
                   }
 
-                  newPacket = peekedPacket->Copy ();
-                  Ptr<Packet> aggPacket = newPacket->Copy ();
-                 
-                  newPacket->AddHeader (peekedHdr);
-                  WifiMacTrailer fcs;
-                  newPacket->AddTrailer (fcs);
-                  aggregated = m_mpduAggregator->Aggregate (newPacket, currentAggregatedPacket);
+                  aggregated = m_mpduAggregator->Aggregate (peekedPacket, peekedHdr, m_currentAmpdu);
                   if (aggregated)
                     {
-                      m_aggregateQueue->Enqueue (aggPacket, peekedHdr);
                       if (i == 1 && hdr.IsQosData ())
                       {
                           listenerIt->second->CompleteMpduTx (packet, hdr, tstamp);
@@ -2989,12 +3106,15 @@ Ptr<Packet> MacLow::AggregateToAmpdu (Ptr<const Packet> packet, const WifiMacHea
                       i++;
                       isAmpdu = true;
                       m_sentMpdus++;
+                      if (packed)
+                        {
+                          m_spStats.nPacked++;
+                        }
                       listenerIt->second->CompleteMpduTx (peekedPacket, peekedHdr, tstamp);
                       if (retry)
                           listenerIt->second->RemoveFromBaQueue(tid, hdr.GetAddr1 (), peekedHdr.GetSequenceNumber ());
                       else
                           queue->Remove (peekedPacket);
-                      newPacket = 0;
                     }
                   else
                   {
@@ -3009,6 +3129,8 @@ Ptr<Packet> MacLow::AggregateToAmpdu (Ptr<const Packet> packet, const WifiMacHea
                           retry = false;
                           peekedPacket = queue->PeekByTidAndAddress (&peekedHdr, tid,
                                                                      WifiMacHeader::ADDR1, hdr.GetAddr1 (), srcSinkIpAddr, &tstamp);
+                          peekedPacket = PackSpTail (peekedPacket, &peekedHdr, queue, tid, hdr.GetAddr1 (),
+                                                     srcSinkIpAddr, &tstamp, blockAckSize, &packed);
                           if (peekedPacket != 0)
                             {
                               //find what will the sequence number be so that we don't send more than 64 packets apart
@@ -3023,6 +3145,8 @@ Ptr<Packet> MacLow::AggregateToAmpdu (Ptr<const Packet> packet, const WifiMacHea
                     {
                       peekedPacket = queue->PeekByTidAndAddress (&peekedHdr, tid,
                                                                  WifiMacHeader::ADDR1, hdr.GetAddr1 (), srcSinkIpAddr, &tstamp);
+                      peekedPacket = PackSpTail (peekedPacket, &peekedHdr, queue, tid, hdr.GetAddr1 (),
+                                                 srcSinkIpAddr, &tstamp, blockAckSize, &packed);
                       if (peekedPacket != 0)
                         {
                           //find what will the sequence number be so that we don't send more than 64 packets apart
@@ -3042,32 +3166,19 @@ Ptr<Packet> MacLow::AggregateToAmpdu (Ptr<const Packet> packet, const WifiMacHea
                   }
                   if (hdr.IsBlockAckReq())
                     {
-                      newPacket = packet->Copy();
-                      peekedHdr = hdr;
-                      Ptr<Packet> aggPacket = newPacket->Copy();
-                      m_aggregateQueue->Enqueue (aggPacket, peekedHdr);
-                      newPacket->AddHeader (peekedHdr);
-                      WifiMacTrailer fcs;
-                      newPacket->AddTrailer (fcs);
-                      m_mpduAggregator->Aggregate (newPacket, currentAggregatedPacket);
+                      m_currentAmpdu->Add (packet, hdr);
                     }
                   if (qosPolicy==0)
                     {
                          listenerIt->second->CompleteTransfer(hdr.GetAddr1 (),tid);
                     }
-                  //Add packet tag
-                  AmpduTag ampdutag;
-                  ampdutag.SetAmpdu (true);
-                  ampdutag.SetNoOfMpdus(i);
-                  newPacket = currentAggregatedPacket;
-                  newPacket->AddPacketTag(ampdutag);
-                  currentAggregatedPacket = 0;
                   NS_LOG_DEBUG ("tx unicast A-MPDU");
                   listenerIt->second->SetAmpdu(true);
+                  return !m_currentAmpdu->IsEmpty ();
                 }
               else
                 {
-                  uint32_t queueSize = m_aggregateQueue->GetSize ();
+                  uint32_t queueSize = m_currentAmpdu->GetNMpdus ();
                   NS_ASSERT (queueSize <= 2); //since it is not an A-MPDU then only 2 packets should have been added to the queue no more
                   if (queueSize >= 1)
                     {
@@ -3078,13 +3189,13 @@ Ptr<Packet> MacLow::AggregateToAmpdu (Ptr<const Packet> packet, const WifiMacHea
             }
         }
     }
-    return newPacket;
+    return false;
 }
 
 void MacLow::FlushAggregateQueue (void)
 {
     NS_LOG_DEBUG("Flush aggregate queue");
-    m_aggregateQueue->Flush ();
+    m_currentAmpdu->Clear ();
 }
 
 void
@@ -3135,6 +3246,30 @@ MacLow::GetDmgAckTimeoutGuard (void) const
   return m_dmgAckTimeoutGuard;
 }
 
+void
+MacLow::SetSpFastForward (bool enable)
+{
+  m_spFastForward = enable;
+}
+
+bool
+MacLow::GetSpFastForward (void) const
+{
+  return m_spFastForward;
+}
+
+void
+MacLow::SetSpTailPacking (bool enable)
+{
+  m_spTailPacking = enable;
+}
+
+bool
+MacLow::GetSpTailPacking (void) const
+{
+  return m_spTailPacking;
+}
+
 void
 MacLow::CancelBlockAckTimeout (void)
 {
@@ -3147,6 +3282,162 @@ MacLow::CancelBlockAckTimeout (void)
 }
 
 
+void
+MacLow::SetSpStatsCallback (SpStatsCallback callback)
+{
+  m_spStatsCallback = callback;
+}
+
+void
+MacLow::NotifySpStart (Time stop, Mac48Address destination, bool ack)
+{
+  NS_LOG_FUNCTION (this << stop << destination << ack);
+  NotifySpEnd ();
+  Time now = Simulator::Now ();
+  m_spOpen = true;
+  m_spStop = stop;
+  m_spInExchange = false;
+  m_spLastExchangeEnd = now;
+  m_spTailRefused = false;
+  m_spInFlight.clear ();
+  m_spStats.source = m_self;
+  m_spStats.destination = destination;
+  m_spStats.startNs = now.GetNanoSeconds ();
+  m_spStats.allocatedNs = (stop - now).GetNanoSeconds ();
+  m_spStats.usedNs = 0;
+  m_spStats.bytes = 0;
+  m_spStats.nMpdus = 0;
+  m_spStats.nPpdus = 0;
+  m_spStats.tailNs = 0;
+  m_spStats.switchNs = 0;
+  m_spStats.nPacked = 0;
+  m_spStats.reverseNs = 0;
+  m_spStats.ack = ack;
+}
+
+void
+MacLow::NotifySpEnd (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_spOpen)
+    {
+      return;
+    }
+  // An exchange cut by the end of the SP counts up to now
+  EndSpExchange ();
+  if (m_rdPending)
+    {
+      /* Grant cut by the end of the SP: the BlockAck is notified after
+       * EdcaTxopN has closed the SP */
+      m_rdEndEvent.Cancel ();
+      m_rdEndEvent = Simulator::ScheduleNow (&MacLow::EndReverseDirection, this);
+    }
+  if (m_spTailRefused && m_spStop > m_spLastExchangeEnd)
+    {
+      m_spStats.tailNs = (m_spStop - m_spLastExchangeEnd).GetNanoSeconds ();
+    }
+  m_spOpen = false;
+  if (!m_spStatsCallback.IsNull ())
+    {
+      m_spStatsCallback (m_spStats);
+    }
+}
+
+void
+MacLow::EndSpExchange (void)
+{
+  if (!m_spInExchange)
+    {
+      return;
+    }
+  m_spInExchange = false;
+  m_spInFlight.clear ();
+  m_spLastExchangeEnd = Simulator::Now ();
+  m_spStats.usedNs += (m_spLastExchangeEnd - m_spExchangeStart).GetNanoSeconds ();
+}
+
+void
+MacLow::SetReverseDirection (bool enable)
+{
+  m_reverseDirection = enable;
+}
+
+bool
+MacLow::GetReverseDirection (void) const
+{
+  return m_reverseDirection;
+}
+
+Time
+MacLow::GetReverseDirectionGrant (Time txDuration)
+{
+  if (!m_reverseDirection || !m_isDmg || !m_spOpen || !m_ampdu)
+    {
+      return Seconds (0);
+    }
+  /* The exchange of the destination must end, as seen by this station
+   * after two propagation delays, before the end of the SP */
+  Time end = m_spStop - m_propagationGuard * 2 - m_dmgAckTimeoutGuard;
+  Time grant = end - Simulator::Now () - txDuration;
+  if (grant <= Seconds (0))
+    {
+      return Seconds (0);
+    }
+  return MicroSeconds (std::min<int64_t> (grant.GetMicroSeconds (), 0x7fff));
+}
+
+bool
+MacLow::NeedReverseDirection (uint8_t tid, Mac48Address originator, Time grant)
+{
+  if (m_spOpen || m_rdPending || grant <= Seconds (0))
+    {
+      return false;
+    }
+  std::map<AcIndex, MacLowBlockAckEventListener*>::const_iterator listenerIt = m_edcaListeners.find (QosUtilsMapTidToAc (tid));
+  if (listenerIt == m_edcaListeners.end ())
+    {
+      return false;
+    }
+  WifiMacHeader hdr;
+  Ptr<const Packet> packet = listenerIt->second->PeekReverseDirectionPacket (originator, &hdr);
+  if (packet == 0)
+    {
+      return false;
+    }
+  /* At least one MPDU and its BlockAck, after a SIFS */
+  Time exchange = GetSifs () + GetNextSimpleAmpduExchangeDuration (packet, &hdr)
+    + m_propagationGuard * 2 + m_dmgAckTimeoutGuard;
+  NS_LOG_DEBUG ("reverse direction exchange " << exchange << " grant " << grant);
+  return exchange <= grant;
+}
+
+void
+MacLow::StartReverseDirection (AcIndex ac, Mac48Address originator, Time end)
+{
+  NS_LOG_FUNCTION (this << ac << originator << end);
+  std::map<AcIndex, MacLowBlockAckEventListener*>::const_iterator listenerIt = m_edcaListeners.find (ac);
+  NS_ASSERT (listenerIt != m_edcaListeners.end ());
+  listenerIt->second->StartReverseDirection (originator, end);
+}
+
+void
+MacLow::EndReverseDirection (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_rdEndEvent.Cancel ();
+  if (!m_rdPending)
+    {
+      return;
+    }
+  m_rdPending = false;
+  if (m_spOpen)
+    {
+      m_spLastExchangeEnd = Simulator::Now ();
+      m_spStats.reverseNs += (m_spLastExchangeEnd - m_rdStart).GetNanoSeconds ();
+    }
+  m_listener->GotBlockAck (&m_rdBlockAck, m_rdPeer, m_rdMode);
+}
+
 std::pair <Ipv4Address,Ipv4Address> 
 MacLow::InspectIpv4Addr(Ptr<const Packet> packet)
 {
@@ -43,7 +43,9 @@
 #include "block-ack-cache.h"
 #include "wifi-tx-vector.h"
 #include "mpdu-aggregator.h"
+#include "ampdu-container.h"
 #include "dmg-beacon-interval.h"
+#include "dmg-sp-stats.h"
 
 namespace ns3 {
 
@@ -272,6 +274,20 @@ public:
    * Returns number of packets for a specific agreement that need retransmission.
    */
   virtual uint32_t GetNRetryNeededPackets (Mac48Address recipient, uint8_t tid) const;
+  /**
+   * \param originator address of the station whose A-MPDU is being acknowledged.
+   * \param hdr the header of the returned packet.
+   * \return the first packet the queue would send to originator with a
+   * reverse direction grant, 0 if there is none.
+   */
+  virtual Ptr<const Packet> PeekReverseDirectionPacket (Mac48Address originator, WifiMacHeader *hdr);
+  /**
+   * \param originator address of the station that granted the reverse direction.
+   * \param end the end of the grant.
+   *
+   * Send a PPDU to originator, whose exchange must end before end.
+   */
+  virtual void StartReverseDirection (Mac48Address originator, Time end);
 };
 
 /**
@@ -442,6 +458,10 @@ public:
 
   void SetCurrentSpEnd(Time end);
   Time GetCurrentSpEnd(void) const;
+  /* Whether no other link of the controller interference sets can overlap
+   * the current SP, see MacLow::SetSpFastForward */
+  void SetCurrentSpIsolated(bool isolated);
+  bool IsCurrentSpIsolated(void) const;
 
 private:
 
@@ -460,6 +480,7 @@ private:
   bool m_sendRts;
   Time m_overrideDurationId;
   Time m_currentSpEnd;
+  bool m_currentSpIsolated;
 };
 
 /**
@@ -787,12 +808,13 @@ public:
   /**
    * \param packet the packet to be aggregated. If the aggregation is succesfull, it corresponds either to the first data packet that will be aggregated or to the BAR that will be piggybacked at the end of the A-MPDU.
    * \param hdr the WifiMacHeader for the packet.
-   * \return the A-MPDU packet if aggregation is successfull, the input packet otherwise
+   * \return true if aggregation is successfull, false otherwise
    *
-   * This function adds the packets that will be added to an A-MPDU to an aggregate queue
+   * This function adds references to the packets that will be sent in an A-MPDU to the
+   * current A-MPDU container. They are serialized only when the A-MPDU is forwarded down.
    * 
    */
-  Ptr<Packet> AggregateToAmpdu (Ptr<const Packet> packet, const WifiMacHeader hdr);
+  bool AggregateToAmpdu (Ptr<const Packet> packet, const WifiMacHeader hdr);
   /**
    * \param aggregatedPacket which is the current A-MPDU
    * \param rxSnr snr of packet received
@@ -806,15 +828,26 @@ public:
   /**
    * \param peekedPacket the packet to be aggregated
    * \param peekedHdr the WifiMacHeader for the packet.
-   * \param aggregatedPacket the current A-MPDU
+   * \param ampdu the current A-MPDU
    * \param size the size of a piggybacked block ack request
    * \return false if the given packet can be added to an A-MPDU, true otherwise
    *
    * This function decides if a given packet can be added to an A-MPDU or not
    * 
    */
-  bool StopAggregation (Ptr<const Packet> peekedPacket, WifiMacHeader peekedHdr, Ptr<Packet> aggregatedPacket, uint16_t size) const;
-  bool DmgStopAggregation (Ptr<const Packet> peekedPacket, WifiMacHeader peekedHdr, Ptr<Packet> aggregatedPacket, uint16_t size) const;
+  bool StopAggregation (Ptr<const Packet> peekedPacket, WifiMacHeader peekedHdr, Ptr<const AmpduContainer> ampdu, uint16_t size) const;
+  bool DmgStopAggregation (Ptr<const Packet> peekedPacket, WifiMacHeader peekedHdr, Ptr<const AmpduContainer> ampdu, uint16_t size) const;
+  /* True if a PPDU of psduSize bytes sent now and its BlockAck end before
+   * the current SP */
+  bool DmgFitsInSp (uint32_t psduSize) const;
+  /* If SP tail packing is enabled and DmgStopAggregation refuses
+   * peekedPacket, return the oldest head of another flow of the same next
+   * hop and TID that still fits in the SP, and set packed. Otherwise
+   * return peekedPacket */
+  Ptr<const Packet> PackSpTail (Ptr<const Packet> peekedPacket, WifiMacHeader *peekedHdr,
+                                Ptr<WifiMacQueue> queue, uint8_t tid, Mac48Address addr,
+                                std::pair <Ipv4Address,Ipv4Address> srcSinkIpAddr,
+                                Time *tstamp, uint16_t size, bool *packed);
   /**
    *
    * This function is called to flush the aggregate queue, which is used for A-MPDU
@@ -835,10 +868,37 @@ public:
   Time GetPropagationGuard (void);
   void SetDmgAckTimeoutGuard (Time guard);
   Time GetDmgAckTimeoutGuard (void) const;
+  /* When enabled, the A-MPDUs sent in an isolated SP are handed to the PHY
+   * as a whole PPDU (WifiPhy::SendPpdu), which delivers them with one event
+   * instead of one event per subframe. */
+  void SetSpFastForward (bool enable);
+  bool GetSpFastForward (void) const;
+  /* When enabled, an A-MPDU whose next MPDU does not fit in the rest of
+   * the SP is completed with the heads of the other flows of the same
+   * next hop and TID that still fit. No flow is reordered. */
+  void SetSpTailPacking (bool enable);
+  bool GetSpTailPacking (void) const;
+  /* When enabled, the A-MPDUs sent in a Tx SP grant the rest of the SP to
+   * their destination: the BlockAck response announces, with its Duration
+   * field, a PPDU of the destination for this station (e.g. TCP ACKs of
+   * the flow of the SP), and the BlockAck of the A-MPDU is notified once
+   * that exchange is over. As destination, a BlockAck with a Duration
+   * greater than 0 is sent only when such a PPDU follows. All the stations
+   * must use the same setting. */
+  void SetReverseDirection (bool enable);
+  bool GetReverseDirection (void) const;
 
   // Called by EdcaTxopN at the end of SP
   void CancelBlockAckTimeout (void);
 
+  typedef Callback<void, const DmgSpStats &> SpStatsCallback;
+  /* Callback invoked with the stats of every Tx SP when it ends */
+  void SetSpStatsCallback (SpStatsCallback callback);
+  /* Called by EdcaTxopN at the start and at the end of a Tx SP: the
+   * exchanges in between are accounted to the SP */
+  void NotifySpStart (Time stop, Mac48Address destination, bool ack);
+  void NotifySpEnd (void);
+
   /* Return the Ip address of the packet*/
   std::pair <Ipv4Address,Ipv4Address> InspectIpv4Addr(Ptr<const Packet> packet);
   /* Return the measured duration of a complete MPDU transmission*/
@@ -898,6 +958,11 @@ private:
    * \return the total packet size
    */
   uint32_t GetSize (Ptr<const Packet> packet, const WifiMacHeader *hdr) const;
+  /**
+   * \return the size of the PSDU being sent: the current A-MPDU if any,
+   * the current packet with its WifiMacHeader and FCS trailer otherwise
+   */
+  uint32_t GetCurrentSize (void) const;
   /**
    * Forward the packet down to WifiPhy for transmission. This is called for the entire A-MPDu when MPDU aggregation is used.
    *
@@ -1227,8 +1292,7 @@ private:
   /**
    * This method checks if exists a valid established block ack agreement.
    * If there is, store the packet without pass it up to WifiMac. The packet is buffered
-   * in order of increasing sequence control field. All comparison are performed
-   * circularly modulo 2^12.
+   * in the slot of its sequence number, replacing a copy received before.
    */
   bool StoreMpduIfNeeded (Ptr<Packet> packet, WifiMacHeader hdr);
   /**
@@ -1289,6 +1353,32 @@ private:
    *
    */
   bool IsAmpdu (Ptr<const Packet> packet, const WifiMacHeader hdr);
+  /**
+   * Account the exchange in progress, if any, to the current SP.
+   */
+  void EndSpExchange (void);
+  /**
+   * Return the time the destination of the current A-MPDU may use after
+   * its BlockAck, 0 if the A-MPDU does not grant the reverse direction.
+   *
+   * \param txDuration the duration of the A-MPDU
+   */
+  Time GetReverseDirectionGrant (Time txDuration);
+  /**
+   * As destination of an A-MPDU granting the reverse direction, return
+   * true if a PPDU for originator is ready and its exchange fits between
+   * the end of the BlockAck and the end of the grant.
+   */
+  bool NeedReverseDirection (uint8_t tid, Mac48Address originator, Time grant);
+  /**
+   * Hand the PPDU announced by the BlockAck to the EDCA of ac.
+   */
+  void StartReverseDirection (AcIndex ac, Mac48Address originator, Time end);
+  /**
+   * As owner of the SP, notify the BlockAck held back during the reverse
+   * direction exchange.
+   */
+  void EndReverseDirection (void);
 
   Ptr<WifiPhy> m_phy; //!< Pointer to WifiPhy (actually send/receives frames)
   Ptr<WifiRemoteStationManager> m_stationManager; //!< Pointer to WifiRemoteStationManager (rate control)
@@ -1346,10 +1436,23 @@ private:
    * BlockAck data structures.
    */
   typedef std::pair<Ptr<Packet>, WifiMacHeader> BufferedPacket;
-  typedef std::list<BufferedPacket>::iterator BufferedPacketI;
+  /*
+   * Reorder buffer of an agreement: the MPDUs indexed by sequence number.
+   * Fragments are not buffered under a block ack agreement, so a sequence
+   * number has one MPDU.
+   */
+  struct ReorderBuffer
+  {
+    BlockAckRing<BufferedPacket> packets;
+    BlockAckBitmap stored;
+  };
+  /**
+   * Forward up the MPDU buffered with sequence number seq and free its slot.
+   */
+  void RxBufferedPacket (ReorderBuffer &buffer, uint16_t seq);
 
   typedef std::pair<Mac48Address, uint8_t> AgreementKey;
-  typedef std::pair<BlockAckAgreement, std::list<BufferedPacket> > AgreementValue;
+  typedef std::pair<BlockAckAgreement, ReorderBuffer> AgreementValue;
 
   typedef std::map<AgreementKey, AgreementValue> Agreements;
   typedef std::map<AgreementKey, AgreementValue>::iterator AgreementsI;
@@ -1364,7 +1467,7 @@ private:
   QueueListeners m_edcaListeners;
   bool m_ctsToSelfSupported;          //!< Flag whether CTS-to-self is supported.
   uint8_t m_sentMpdus;                //!< Number of transmitted MPDUs in an A-MPDU that have not been acknowledged yet.
-  Ptr<WifiMacQueue> m_aggregateQueue; //!< Queue used for MPDU aggregation.
+  Ptr<AmpduContainer> m_currentAmpdu; //!< MPDUs of the A-MPDU being sent.
 
 
   Mac48Address m_macSampling;
@@ -1381,8 +1484,40 @@ private:
   bool m_isDmg;
   Time m_propagationGuard;
   Time m_dmgAckTimeoutGuard;
+  bool m_spFastForward;
+  bool m_spTailPacking;
+  bool m_reverseDirection;
+
+  /* Reverse direction, as the owner of the SP: the current A-MPDU grants
+   * the rest of the SP, and the BlockAck held back while the destination
+   * uses the grant */
+  bool m_rdGranted;
+  bool m_rdPending;
+  CtrlBAckResponseHeader m_rdBlockAck;
+  Mac48Address m_rdPeer;
+  WifiMode m_rdMode;
+  Time m_rdStart;
+  EventId m_rdEndEvent;
+  /* Reverse direction, as destination: start of the PPDU announced by the
+   * BlockAck */
+  EventId m_rdStartEvent;
 
   uint32_t m_maxNumMpdu;
+
+  /* Stats of the current Tx SP */
+  SpStatsCallback m_spStatsCallback;
+  DmgSpStats m_spStats;
+  bool m_spOpen;
+  Time m_spStop;
+  bool m_spInExchange;
+  Time m_spExchangeStart;
+  Time m_spLastExchangeEnd;
+  /* Set by DmgStopAggregation when the time of the SP closes an A-MPDU
+   * before the queue is empty */
+  mutable bool m_spTailRefused;
+  /* Sequence number and payload size of the QoS data MPDUs waiting for
+   * their ACK or BlockAck */
+  std::vector<std::pair<uint16_t, uint32_t> > m_spInFlight;
 };
 
 } // namespace ns3
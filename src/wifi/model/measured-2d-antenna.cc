@@ -1,363 +1,473 @@
-/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
-/*
- * Copyright (c) 2010
- *
- * This program is free software; you can redistribute it and/or modify
- * it under the terms of the GNU General Public License version 2 as
- * published by the Free Software Foundation;
- *
- * This program is distributed in the hope that it will be useful,
- * but WITHOUT ANY WARRANTY; without even the implied warranty of
- * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
- * GNU General Public License for more details.
- *
- * You should have received a copy of the GNU General Public License
- * along with this program; if not, write to the Free Software
- * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
- *
- * Author: Daniel Halperin <dhalperi@cs.washington.edu>
- */
-
-#include "ns3/double.h"
-#include "ns3/log.h"
-#include "ns3/object-vector.h"
-#include <math.h>
-#include "measured-2d-antenna.h"
-
-namespace ns3 {
-
-NS_LOG_COMPONENT_DEFINE("Measured2DAntenna");
-
-NS_OBJECT_ENSURE_REGISTERED (Measured2DAntenna);
-
-/* Utility Functions */
-static double
-getAngleDiff(double a, double b)
-{
-        double d = fabs(a-b);
-        while (d > 2*M_PI)
-                d -= 2*M_PI;
-        if (d > M_PI)
-                d = 2*M_PI - d;
-        return d;
-}
-
-static int wrap_index(int i, int n)
-{
-        i = i%n;
-        if (i < 0)
-                return i+n;
-        return i;
-}
-
-TypeId
-M2D::GetTypeId(void)
-{
-  static TypeId tid = TypeId ("ns3::M2D")
-    .SetParent<Object> ()
-    .AddConstructor<M2D> ()
-  ;
-  return tid;
-}
-
-M2D::M2D()
-{
-}
-M2D::M2D(double angle, double gain)
-	: m_angle(angle),m_gain(gain)
-{
-}
-
-M2D::~M2D()
-{
-}
-
-double
-M2D::GetAngle (void) const
-{
-	return m_angle;
-}
-
-void
-M2D::SetAngle (double angle)
-{
-	m_angle = angle;
-}
-
-double
-M2D::GetGain (void) const
-{
-	return m_gain;
-}
-
-void
-M2D::SetGain (double gain)
-{
-	m_gain = gain;
-}
-
-TypeId
-Measured2DAntenna::GetTypeId (void)
-{
-  static TypeId tid = TypeId ("ns3::Measured2DAntenna")
-    .SetParent<AbstractAntenna> ()
-    .AddConstructor<Measured2DAntenna> ()
-    .AddAttribute ("Azimuth",
-                   "The azimuth angle (XY-plane) in which this antenna is pointed in radians.",
-                   DoubleValue (0),
-                   MakeDoubleAccessor (&Measured2DAntenna::m_azimuth),
-                   MakeDoubleChecker<double> ())
-    .AddAttribute ("Elevation",
-                   "The elevation angle (Z-plane) in which this antenna is pointed in radians.",
-                   DoubleValue (0),
-                   MakeDoubleAccessor (&Measured2DAntenna::m_elevation),
-                   MakeDoubleChecker<double> ())
-    .AddAttribute ("VerticalBeamwidth",
-                   "The vertical beamwidth of this antenna in radians.",
-                   DoubleValue (M_PI/18),	/* 10 degrees */
-                   MakeDoubleAccessor (&Measured2DAntenna::m_verticalBeamwidth),
-                   MakeDoubleChecker<double> ())
-    .AddAttribute ("Mode",
-		   "23 or 10.",
-		   DoubleValue (23),
-		   MakeDoubleAccessor (&Measured2DAntenna::GetMode, &Measured2DAntenna::SetMode),
-		   MakeDoubleChecker<double> ())
-    ;
-  return tid;
-}
-
-Measured2DAntenna::Measured2DAntenna()
-	: m_verticalBeamwidth(M_PI/18)
-{
-}
-
-Measured2DAntenna::~Measured2DAntenna() { }
-
-double
-Measured2DAntenna::GetTxGainDbi(double azimuth, double elevation) const
-{
-	NS_LOG_FUNCTION(azimuth << elevation);
-	if (getAngleDiff(elevation,m_elevation) > m_verticalBeamwidth/2)
-		return -10000;
-	return GetGain(azimuth);
-}
-
-double
-Measured2DAntenna::GetRxGainDbi(double azimuth, double elevation) const
-{
-	NS_LOG_FUNCTION(azimuth << elevation);
-	if (getAngleDiff(elevation,m_elevation) > m_verticalBeamwidth/2)
-		return -10000;
-	return GetGain(azimuth);
-}
-
-double
-Measured2DAntenna::GetBeamwidth(void) const
-{
-	NS_LOG_FUNCTION(m_verticalBeamwidth);
-	return m_verticalBeamwidth;
-}
-
-double
-Measured2DAntenna::GetGain(double angle) const
-{
-	NS_LOG_FUNCTION(angle);
-
-	if (m_measurements.size() == 0)
-		NS_FATAL_ERROR("trying to get gain with no measurements!"); 
-
-	if (m_measurements.size() == 1)
-		return m_measurements[0]->GetGain();
-
-	int i = 0, i1, i2;
-	int S = m_measurements.size();
-	angle = angle - m_azimuth;
-	double diff = getAngleDiff(m_measurements[0]->GetAngle(), angle);
-	double diff1, diff2;
-	double ret;
-	while(true)
-	{
-		if (diff == 0)
-		{
-			ret = m_measurements[i]->GetGain();
-			goto out;
-		}
-
-		i1 = wrap_index(i+1,S);
-		diff1 = getAngleDiff(m_measurements[i1]->GetAngle(), angle);
-		i2 = wrap_index(i-1,S);
-		diff2 = getAngleDiff(m_measurements[i2]->GetAngle(), angle);
-
-		if (diff1 < diff)
-		{
-			i = i1;
-			diff = diff1;
-			continue;
-		}
-
-		if (diff2 < diff)
-		{
-			i = i2;
-			diff = diff2;
-			continue;
-		}
-
-		if (diff1 < diff2)
-		{
-			break;
-		}
-
-		i1 = i;
-		diff1 = diff;
-		i = i2;
-		diff = diff2;
-		break;
-	}
-
-	/* At this point, i should be the closest, and i1===i+1 the next closest */
-        NS_LOG(ns3::LOG_INFO, "i=" << i << " i1=" << i1 << " gain[i]=" <<
-               m_measurements[i]->GetGain() << " gain[i1]=" <<
-               m_measurements[i1]->GetGain() << " diff=" << diff <<
-               " diff1=" << diff1);
-
-	ret = m_measurements[i]->GetGain() * (diff1/(diff+diff1)) +
-	       m_measurements[i1]->GetGain() * (diff/(diff+diff1));
-
-out:
-	NS_LOG(ns3::LOG_INFO, "returning " << ret);
-	return ret;
-}
-
-double
-Measured2DAntenna::GetAzimuthAngle(void) const
-{
-	NS_LOG_FUNCTION(m_azimuth);
-	return m_azimuth;
-}
-
-void
-Measured2DAntenna::SetAzimuthAngle(double azimuth)
-{
-	NS_LOG_FUNCTION(azimuth);
-	m_azimuth = azimuth;
-}
-
-double
-Measured2DAntenna::GetElevationAngle(void) const
-{
-	NS_LOG_FUNCTION(m_elevation);
-	return m_elevation;
-}
-
-void
-Measured2DAntenna::SetElevationAngle(double elevation)
-{
-	NS_LOG_FUNCTION(elevation);
-	m_elevation = elevation;
-}
-
-void
-Measured2DAntenna::SetMode(double mode)
-{
-	NS_LOG_FUNCTION(mode);
-	if (mode != 10 && mode != 23 && mode != 800)
-		NS_FATAL_ERROR("illegal mode " << mode << " != 10 or 23 or 800");
-
-	m_mode = mode;
-	m_measurements.clear();
-
-	if (mode == 23)
-	{
-		m_measurements.push_back(CreateObject<M2D>(0,45.9));
-		m_measurements.push_back(CreateObject<M2D>(15,25.3));
-		m_measurements.push_back(CreateObject<M2D>(30,18.2));
-		m_measurements.push_back(CreateObject<M2D>(60,6.2));
-		m_measurements.push_back(CreateObject<M2D>(90,2.6));
-		m_measurements.push_back(CreateObject<M2D>(120,0.4));
-		m_measurements.push_back(CreateObject<M2D>(150,2.8));
-		m_measurements.push_back(CreateObject<M2D>(180,0));
-		m_measurements.push_back(CreateObject<M2D>(-150,1));
-		m_measurements.push_back(CreateObject<M2D>(-120,2));
-		m_measurements.push_back(CreateObject<M2D>(-90,2.8));
-		m_measurements.push_back(CreateObject<M2D>(-60,6.9));
-		m_measurements.push_back(CreateObject<M2D>(-30,15.5));
-		m_measurements.push_back(CreateObject<M2D>(-15,28.7));
-		for (unsigned int t = 0; t < m_measurements.size(); ++t)
-		{
-                        m_measurements[t]->SetGain(m_measurements[t]->GetGain() - 16.8);
-                        m_measurements[t]->SetAngle(m_measurements[t]->GetAngle() * M_PI/180);
-		}
-        }
-        else if (mode == 10)
-        {
-		m_measurements.push_back(CreateObject<M2D>(0,26.3));
-		m_measurements.push_back(CreateObject<M2D>(15,25.8));
-		m_measurements.push_back(CreateObject<M2D>(30,22.8));
-		m_measurements.push_back(CreateObject<M2D>(60,12.6));
-		m_measurements.push_back(CreateObject<M2D>(90,4.1));
-		m_measurements.push_back(CreateObject<M2D>(120,3.4));
-		m_measurements.push_back(CreateObject<M2D>(150,2.9));
-		m_measurements.push_back(CreateObject<M2D>(180,0));
-		m_measurements.push_back(CreateObject<M2D>(-150,1.3));
-		m_measurements.push_back(CreateObject<M2D>(-120,2.6));
-		m_measurements.push_back(CreateObject<M2D>(-90,5.3));
-		m_measurements.push_back(CreateObject<M2D>(-60,13.9));
-		m_measurements.push_back(CreateObject<M2D>(-30,23.2));
-		m_measurements.push_back(CreateObject<M2D>(-15,26.8));
-		for (unsigned int t = 0; t < m_measurements.size(); ++t)
-		{
-			m_measurements[t]->SetGain(m_measurements[t]->GetGain()-16.8);
-			m_measurements[t]->SetAngle(m_measurements[t]->GetAngle()*M_PI/180);
-		}
-        }
-        else if (mode == 800)
-        {
-		m_measurements.push_back(CreateObject<M2D>(-90+5, -28.08));
-		m_measurements.push_back(CreateObject<M2D>(-90+11.25, -17.08));
-		m_measurements.push_back(CreateObject<M2D>(-90+22.5, -13.08));
-		m_measurements.push_back(CreateObject<M2D>(-90+33.75, -5.08));
-		m_measurements.push_back(CreateObject<M2D>(-90+45, -0.08));
-		m_measurements.push_back(CreateObject<M2D>(-90+56.25, 4.92));
-		m_measurements.push_back(CreateObject<M2D>(-90+67.5, 5.92));
-		m_measurements.push_back(CreateObject<M2D>(-90+78.75, 6.92));
-		m_measurements.push_back(CreateObject<M2D>(0, 7.92));
-		m_measurements.push_back(CreateObject<M2D>(11.25, 6.92));
-		m_measurements.push_back(CreateObject<M2D>(22.5, 5.92));
-		m_measurements.push_back(CreateObject<M2D>(33.75, 4.92));
-		m_measurements.push_back(CreateObject<M2D>(45, -0.08));
-		m_measurements.push_back(CreateObject<M2D>(56.25, -5.08));
-		m_measurements.push_back(CreateObject<M2D>(67.5, -13.08));
-		m_measurements.push_back(CreateObject<M2D>(78.75, -17.08));
-		m_measurements.push_back(CreateObject<M2D>(85, -28.08));
-		m_measurements.push_back(CreateObject<M2D>(90, -16.08));
-		m_measurements.push_back(CreateObject<M2D>(90+11.25, -17.08));
-		m_measurements.push_back(CreateObject<M2D>(90+22.5, -28.08));
-		m_measurements.push_back(CreateObject<M2D>(90+33.75, -16.08));
-		m_measurements.push_back(CreateObject<M2D>(90+45, -14.08));
-		m_measurements.push_back(CreateObject<M2D>(90+56.25, -15.08));
-		m_measurements.push_back(CreateObject<M2D>(90+67.5, -28.08));
-		m_measurements.push_back(CreateObject<M2D>(90+78.75, -14.58));
-		m_measurements.push_back(CreateObject<M2D>(180, -14.08));
-		m_measurements.push_back(CreateObject<M2D>(180+11.25, -14.58));
-		m_measurements.push_back(CreateObject<M2D>(180+22.5, -28.08));
-		m_measurements.push_back(CreateObject<M2D>(180+33.75, -15.08));
-		m_measurements.push_back(CreateObject<M2D>(180+45, -14.08));
-		m_measurements.push_back(CreateObject<M2D>(180+56.25, -16.08));
-		m_measurements.push_back(CreateObject<M2D>(180+67.5, -28.08));
-		m_measurements.push_back(CreateObject<M2D>(180+78.75, -17.08));
-		m_measurements.push_back(CreateObject<M2D>(270, -16.08));
-
-		for (unsigned int t = 0; t < m_measurements.size(); ++t) {
-			m_measurements[t]->SetAngle(m_measurements[t]->GetAngle()*M_PI/180);
-		}
-	}
-}
-
-double
-Measured2DAntenna::GetMode(void) const
-{
-	return m_mode;
-}
-
-};
-
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Daniel Halperin <dhalperi@cs.washington.edu>
+ */
+
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/log.h"
+#include "ns3/object-vector.h"
+#include <math.h>
+#include <algorithm>
+#include "measured-2d-antenna.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("Measured2DAntenna");
+
+NS_OBJECT_ENSURE_REGISTERED (Measured2DAntenna);
+
+/* Utility Functions */
+static double
+getAngleDiff(double a, double b)
+{
+        double d = fabs(a-b);
+        while (d > 2*M_PI)
+                d -= 2*M_PI;
+        if (d > M_PI)
+                d = 2*M_PI - d;
+        return d;
+}
+
+static int wrap_index(int i, int n)
+{
+        i = i%n;
+        if (i < 0)
+                return i+n;
+        return i;
+}
+
+TypeId
+M2D::GetTypeId(void)
+{
+  static TypeId tid = TypeId ("ns3::M2D")
+    .SetParent<Object> ()
+    .AddConstructor<M2D> ()
+  ;
+  return tid;
+}
+
+M2D::M2D()
+{
+}
+M2D::M2D(double angle, double gain)
+	: m_angle(angle),m_gain(gain)
+{
+}
+
+M2D::~M2D()
+{
+}
+
+double
+M2D::GetAngle (void) const
+{
+	return m_angle;
+}
+
+void
+M2D::SetAngle (double angle)
+{
+	m_angle = angle;
+}
+
+double
+M2D::GetGain (void) const
+{
+	return m_gain;
+}
+
+void
+M2D::SetGain (double gain)
+{
+	m_gain = gain;
+}
+
+TypeId
+Measured2DAntenna::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::Measured2DAntenna")
+    .SetParent<AbstractAntenna> ()
+    .AddConstructor<Measured2DAntenna> ()
+    .AddAttribute ("Azimuth",
+                   "The azimuth angle (XY-plane) in which this antenna is pointed in radians.",
+                   DoubleValue (0),
+                   MakeDoubleAccessor (&Measured2DAntenna::m_azimuth),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("Elevation",
+                   "The elevation angle (Z-plane) in which this antenna is pointed in radians.",
+                   DoubleValue (0),
+                   MakeDoubleAccessor (&Measured2DAntenna::m_elevation),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("VerticalBeamwidth",
+                   "The vertical beamwidth of this antenna in radians.",
+                   DoubleValue (M_PI/18),	/* 10 degrees */
+                   MakeDoubleAccessor (&Measured2DAntenna::m_verticalBeamwidth),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("Mode",
+		   "23 or 10.",
+		   DoubleValue (23),
+		   MakeDoubleAccessor (&Measured2DAntenna::GetMode, &Measured2DAntenna::SetMode),
+		   MakeDoubleChecker<double> ())
+    .AddAttribute ("LookupTableSize",
+                   "Number of angles at which the measured pattern is sampled; "
+                   "the gain is interpolated linearly between the samples "
+                   "(e.g. 3600: within 0.05 dB of the measurements). "
+                   "0 interpolates between the measurements at each call.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&Measured2DAntenna::SetLookupTableSize,
+                                         &Measured2DAntenna::GetLookupTableSize),
+                   MakeUintegerChecker<uint32_t> ())
+    ;
+  return tid;
+}
+
+Measured2DAntenna::Measured2DAntenna()
+	: m_verticalBeamwidth(M_PI/18),
+	  m_lutSize(0)
+{
+}
+
+Measured2DAntenna::~Measured2DAntenna() { }
+
+double
+Measured2DAntenna::GetTxGainDbi(double azimuth, double elevation) const
+{
+	NS_LOG_FUNCTION(azimuth << elevation);
+	if (getAngleDiff(elevation,m_elevation) > m_verticalBeamwidth/2)
+		return -10000;
+	return GetGain(azimuth);
+}
+
+double
+Measured2DAntenna::GetRxGainDbi(double azimuth, double elevation) const
+{
+	NS_LOG_FUNCTION(azimuth << elevation);
+	if (getAngleDiff(elevation,m_elevation) > m_verticalBeamwidth/2)
+		return -10000;
+	return GetGain(azimuth);
+}
+
+void
+Measured2DAntenna::GetTxGainsDbi(const double *azimuth, const double *elevation,
+				 double *gains, uint32_t n) const
+{
+	NS_LOG_FUNCTION(n);
+	GetGainsDbi(azimuth, elevation, gains, n);
+}
+
+void
+Measured2DAntenna::GetRxGainsDbi(const double *azimuth, const double *elevation,
+				 double *gains, uint32_t n) const
+{
+	NS_LOG_FUNCTION(n);
+	GetGainsDbi(azimuth, elevation, gains, n);
+}
+
+void
+Measured2DAntenna::GetGainsDbi(const double *azimuth, const double *elevation,
+			       double *gains, uint32_t n) const
+{
+	if (m_lutSize == 0)
+	{
+		for (uint32_t i = 0; i < n; i++)
+			gains[i] = (getAngleDiff(elevation[i],m_elevation) > m_verticalBeamwidth/2)?(-10000):(GetGain(azimuth[i]));
+		return;
+	}
+	if (m_lut.empty())
+		BuildLookupTable();
+	const double binsPerRadian = m_lutSize/(2*M_PI);
+	for (uint32_t i = 0; i < n; i++)
+	{
+		double angle = azimuth[i] - m_azimuth;
+		double pos = (angle - 2*M_PI*floor(angle/(2*M_PI))) * binsPerRadian;
+		uint32_t bin = std::min((uint32_t) pos, m_lutSize - 1);
+		double frac = pos - bin;
+		double gain = m_lut[bin] + (m_lut[bin + 1] - m_lut[bin]) * frac;
+		gains[i] = (getAngleDiff(elevation[i],m_elevation) > m_verticalBeamwidth/2)?(-10000):(gain);
+	}
+}
+
+void
+Measured2DAntenna::BuildLookupTable(void) const
+{
+	NS_LOG_FUNCTION(m_lutSize);
+	m_lut.resize(m_lutSize + 1);
+	for (uint32_t i = 0; i < m_lutSize; i++)
+		m_lut[i] = InterpolateMeasurements(2*M_PI*i/m_lutSize);
+	m_lut[m_lutSize] = m_lut[0];
+}
+
+void
+Measured2DAntenna::SetLookupTableSize(uint32_t size)
+{
+	m_lutSize = size;
+	m_lut.clear();
+}
+
+uint32_t
+Measured2DAntenna::GetLookupTableSize(void) const
+{
+	return m_lutSize;
+}
+
+double
+Measured2DAntenna::GetBeamwidth(void) const
+{
+	NS_LOG_FUNCTION(m_verticalBeamwidth);
+	return m_verticalBeamwidth;
+}
+
+double
+Measured2DAntenna::GetMaxGainDbi(void) const
+{
+	// Out of the vertical beam the gain is -10000; in it, the gain is
+	// interpolated between measurements so it never exceeds the largest.
+	double maxGain = -10000;
+	for (uint32_t i = 0; i < m_measurements.size(); i++)
+		maxGain = std::max(maxGain, m_measurements[i]->GetGain());
+	return maxGain;
+}
+
+Ptr<AbstractAntenna>
+Measured2DAntenna::Copy(void) const
+{
+	// The measurements are only set by SetMode: the copy shares them
+	Ptr<Measured2DAntenna> copy = CreateObject<Measured2DAntenna>();
+	copy->m_mode = m_mode;
+	copy->m_verticalBeamwidth = m_verticalBeamwidth;
+	copy->m_elevation = m_elevation;
+	copy->m_azimuth = m_azimuth;
+	copy->m_measurements = m_measurements;
+	copy->m_lutSize = m_lutSize;
+	copy->m_lut = m_lut;
+	return copy;
+}
+
+double
+Measured2DAntenna::GetGain(double angle) const
+{
+	NS_LOG_FUNCTION(angle);
+	if (m_lutSize == 0)
+		return InterpolateMeasurements(angle - m_azimuth);
+	double gain;
+	GetGainsDbi(&angle, &m_elevation, &gain, 1);
+	return gain;
+}
+
+double
+Measured2DAntenna::InterpolateMeasurements(double angle) const
+{
+	if (m_measurements.size() == 0)
+		NS_FATAL_ERROR("trying to get gain with no measurements!"); 
+
+	if (m_measurements.size() == 1)
+		return m_measurements[0]->GetGain();
+
+	int i = 0, i1, i2;
+	int S = m_measurements.size();
+	double diff = getAngleDiff(m_measurements[0]->GetAngle(), angle);
+	double diff1, diff2;
+	double ret;
+	while(true)
+	{
+		if (diff == 0)
+		{
+			ret = m_measurements[i]->GetGain();
+			goto out;
+		}
+
+		i1 = wrap_index(i+1,S);
+		diff1 = getAngleDiff(m_measurements[i1]->GetAngle(), angle);
+		i2 = wrap_index(i-1,S);
+		diff2 = getAngleDiff(m_measurements[i2]->GetAngle(), angle);
+
+		if (diff1 < diff)
+		{
+			i = i1;
+			diff = diff1;
+			continue;
+		}
+
+		if (diff2 < diff)
+		{
+			i = i2;
+			diff = diff2;
+			continue;
+		}
+
+		if (diff1 < diff2)
+		{
+			break;
+		}
+
+		i1 = i;
+		diff1 = diff;
+		i = i2;
+		diff = diff2;
+		break;
+	}
+
+	/* At this point, i should be the closest, and i1===i+1 the next closest */
+        NS_LOG(ns3::LOG_INFO, "i=" << i << " i1=" << i1 << " gain[i]=" <<
+               m_measurements[i]->GetGain() << " gain[i1]=" <<
+               m_measurements[i1]->GetGain() << " diff=" << diff <<
+               " diff1=" << diff1);
+
+	ret = m_measurements[i]->GetGain() * (diff1/(diff+diff1)) +
+	       m_measurements[i1]->GetGain() * (diff/(diff+diff1));
+
+out:
+	NS_LOG(ns3::LOG_INFO, "returning " << ret);
+	return ret;
+}
+
+double
+Measured2DAntenna::GetAzimuthAngle(void) const
+{
+	NS_LOG_FUNCTION(m_azimuth);
+	return m_azimuth;
+}
+
+void
+Measured2DAntenna::SetAzimuthAngle(double azimuth)
+{
+	NS_LOG_FUNCTION(azimuth);
+	m_azimuth = azimuth;
+}
+
+double
+Measured2DAntenna::GetElevationAngle(void) const
+{
+	NS_LOG_FUNCTION(m_elevation);
+	return m_elevation;
+}
+
+void
+Measured2DAntenna::SetElevationAngle(double elevation)
+{
+	NS_LOG_FUNCTION(elevation);
+	m_elevation = elevation;
+}
+
+void
+Measured2DAntenna::SetMode(double mode)
+{
+	NS_LOG_FUNCTION(mode);
+	if (mode != 10 && mode != 23 && mode != 800)
+		NS_FATAL_ERROR("illegal mode " << mode << " != 10 or 23 or 800");
+
+	m_mode = mode;
+	m_measurements.clear();
+	m_lut.clear();
+
+	if (mode == 23)
+	{
+		m_measurements.push_back(CreateObject<M2D>(0,45.9));
+		m_measurements.push_back(CreateObject<M2D>(15,25.3));
+		m_measurements.push_back(CreateObject<M2D>(30,18.2));
+		m_measurements.push_back(CreateObject<M2D>(60,6.2));
+		m_measurements.push_back(CreateObject<M2D>(90,2.6));
+		m_measurements.push_back(CreateObject<M2D>(120,0.4));
+		m_measurements.push_back(CreateObject<M2D>(150,2.8));
+		m_measurements.push_back(CreateObject<M2D>(180,0));
+		m_measurements.push_back(CreateObject<M2D>(-150,1));
+		m_measurements.push_back(CreateObject<M2D>(-120,2));
+		m_measurements.push_back(CreateObject<M2D>(-90,2.8));
+		m_measurements.push_back(CreateObject<M2D>(-60,6.9));
+		m_measurements.push_back(CreateObject<M2D>(-30,15.5));
+		m_measurements.push_back(CreateObject<M2D>(-15,28.7));
+		for (unsigned int t = 0; t < m_measurements.size(); ++t)
+		{
+                        m_measurements[t]->SetGain(m_measurements[t]->GetGain() - 16.8);
+                        m_measurements[t]->SetAngle(m_measurements[t]->GetAngle() * M_PI/180);
+		}
+        }
+        else if (mode == 10)
+        {
+		m_measurements.push_back(CreateObject<M2D>(0,26.3));
+		m_measurements.push_back(CreateObject<M2D>(15,25.8));
+		m_measurements.push_back(CreateObject<M2D>(30,22.8));
+		m_measurements.push_back(CreateObject<M2D>(60,12.6));
+		m_measurements.push_back(CreateObject<M2D>(90,4.1));
+		m_measurements.push_back(CreateObject<M2D>(120,3.4));
+		m_measurements.push_back(CreateObject<M2D>(150,2.9));
+		m_measurements.push_back(CreateObject<M2D>(180,0));
+		m_measurements.push_back(CreateObject<M2D>(-150,1.3));
+		m_measurements.push_back(CreateObject<M2D>(-120,2.6));
+		m_measurements.push_back(CreateObject<M2D>(-90,5.3));
+		m_measurements.push_back(CreateObject<M2D>(-60,13.9));
+		m_measurements.push_back(CreateObject<M2D>(-30,23.2));
+		m_measurements.push_back(CreateObject<M2D>(-15,26.8));
+		for (unsigned int t = 0; t < m_measurements.size(); ++t)
+		{
+			m_measurements[t]->SetGain(m_measurements[t]->GetGain()-16.8);
+			m_measurements[t]->SetAngle(m_measurements[t]->GetAngle()*M_PI/180);
+		}
+        }
+        else if (mode == 800)
+        {
+		m_measurements.push_back(CreateObject<M2D>(-90+5, -28.08));
+		m_measurements.push_back(CreateObject<M2D>(-90+11.25, -17.08));
+		m_measurements.push_back(CreateObject<M2D>(-90+22.5, -13.08));
+		m_measurements.push_back(CreateObject<M2D>(-90+33.75, -5.08));
+		m_measurements.push_back(CreateObject<M2D>(-90+45, -0.08));
+		m_measurements.push_back(CreateObject<M2D>(-90+56.25, 4.92));
+		m_measurements.push_back(CreateObject<M2D>(-90+67.5, 5.92));
+		m_measurements.push_back(CreateObject<M2D>(-90+78.75, 6.92));
+		m_measurements.push_back(CreateObject<M2D>(0, 7.92));
+		m_measurements.push_back(CreateObject<M2D>(11.25, 6.92));
+		m_measurements.push_back(CreateObject<M2D>(22.5, 5.92));
+		m_measurements.push_back(CreateObject<M2D>(33.75, 4.92));
+		m_measurements.push_back(CreateObject<M2D>(45, -0.08));
+		m_measurements.push_back(CreateObject<M2D>(56.25, -5.08));
+		m_measurements.push_back(CreateObject<M2D>(67.5, -13.08));
+		m_measurements.push_back(CreateObject<M2D>(78.75, -17.08));
+		m_measurements.push_back(CreateObject<M2D>(85, -28.08));
+		m_measurements.push_back(CreateObject<M2D>(90, -16.08));
+		m_measurements.push_back(CreateObject<M2D>(90+11.25, -17.08));
+		m_measurements.push_back(CreateObject<M2D>(90+22.5, -28.08));
+		m_measurements.push_back(CreateObject<M2D>(90+33.75, -16.08));
+		m_measurements.push_back(CreateObject<M2D>(90+45, -14.08));
+		m_measurements.push_back(CreateObject<M2D>(90+56.25, -15.08));
+		m_measurements.push_back(CreateObject<M2D>(90+67.5, -28.08));
+		m_measurements.push_back(CreateObject<M2D>(90+78.75, -14.58));
+		m_measurements.push_back(CreateObject<M2D>(180, -14.08));
+		m_measurements.push_back(CreateObject<M2D>(180+11.25, -14.58));
+		m_measurements.push_back(CreateObject<M2D>(180+22.5, -28.08));
+		m_measurements.push_back(CreateObject<M2D>(180+33.75, -15.08));
+		m_measurements.push_back(CreateObject<M2D>(180+45, -14.08));
+		m_measurements.push_back(CreateObject<M2D>(180+56.25, -16.08));
+		m_measurements.push_back(CreateObject<M2D>(180+67.5, -28.08));
+		m_measurements.push_back(CreateObject<M2D>(180+78.75, -17.08));
+		m_measurements.push_back(CreateObject<M2D>(270, -16.08));
+
+		for (unsigned int t = 0; t < m_measurements.size(); ++t) {
+			m_measurements[t]->SetAngle(m_measurements[t]->GetAngle()*M_PI/180);
+		}
+	}
+}
+
+double
+Measured2DAntenna::GetMode(void) const
+{
+	return m_mode;
+}
+
+};
+
@@ -1,94 +1,114 @@
-/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
-/*
- * Copyright (c) 2010
- *
- * This program is free software; you can redistribute it and/or modify
- * it under the terms of the GNU General Public License version 2 as
- * published by the Free Software Foundation;
- *
- * This program is distributed in the hope that it will be useful,
- * but WITHOUT ANY WARRANTY; without even the implied warranty of
- * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
- * GNU General Public License for more details.
- *
- * You should have received a copy of the GNU General Public License
- * along with this program; if not, write to the Free Software
- * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
- *
- * Author: Daniel Halperin <dhalperi@cs.washington.edu>
- */
-
-#ifndef M2D_ANTENNA_H
-#define M2D_ANTENNA_H
-
-#include "abstract-antenna.h"
-#include "ns3/vector.h"
-
-namespace ns3 {
-
-/**
- * \brief Antenna Measurement Object as a part of the antenna
- */
-class M2D : public Object
-{
-public:
-  static TypeId GetTypeId (void);
-
-  M2D ();
-  M2D(double angle, double gain);
-  ~M2D ();
-
-  double GetGain (void) const;
-  void SetGain (double);
-
-  double GetAngle (void) const;
-  void SetAngle (double);
-
-private:
-  M2D (const M2D &o);
-  M2D & operator = (const M2D &o);
-  double m_angle;
-  double m_gain;
-};
-
-/**
- * \brief Antenna functionality for wireless devices
- */
-class Measured2DAntenna : public AbstractAntenna
-{
-public:
-  static TypeId GetTypeId (void);
-
-  Measured2DAntenna ();
-  ~Measured2DAntenna ();
-
-  double GetTxGainDbi (double azimuth, double elevation) const;
-  double GetRxGainDbi (double azimuth, double elevation) const;
-
-  double GetAzimuthAngle (void) const;
-  void SetAzimuthAngle (double azimuth);
-
-  double GetElevationAngle (void) const;
-  void SetElevationAngle (double elevation);
-
-  double GetBeamwidth (void) const;
-
-  double GetMode (void) const;
-  void SetMode (double);
-
-private:
-  Measured2DAntenna (const Measured2DAntenna &o);
-  Measured2DAntenna & operator = (const Measured2DAntenna &o);
-
-  double GetGain(double angle) const;
-
-  double m_mode;
-  double m_verticalBeamwidth;
-  double m_elevation;
-  double m_azimuth;
-  std::vector<Ptr<M2D> > m_measurements;
-};
-
-}; // namespace ns3
-
-#endif /* M2D_ANTENNA_H */
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Daniel Halperin <dhalperi@cs.washington.edu>
+ */
+
+#ifndef M2D_ANTENNA_H
+#define M2D_ANTENNA_H
+
+#include "abstract-antenna.h"
+#include "ns3/vector.h"
+
+namespace ns3 {
+
+/**
+ * \brief Antenna Measurement Object as a part of the antenna
+ */
+class M2D : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  M2D ();
+  M2D(double angle, double gain);
+  ~M2D ();
+
+  double GetGain (void) const;
+  void SetGain (double);
+
+  double GetAngle (void) const;
+  void SetAngle (double);
+
+private:
+  M2D (const M2D &o);
+  M2D & operator = (const M2D &o);
+  double m_angle;
+  double m_gain;
+};
+
+/**
+ * \brief Antenna functionality for wireless devices
+ */
+class Measured2DAntenna : public AbstractAntenna
+{
+public:
+  static TypeId GetTypeId (void);
+
+  Measured2DAntenna ();
+  ~Measured2DAntenna ();
+
+  double GetTxGainDbi (double azimuth, double elevation) const;
+  double GetRxGainDbi (double azimuth, double elevation) const;
+  void GetTxGainsDbi (const double *azimuth, const double *elevation,
+                      double *gains, uint32_t n) const;
+  void GetRxGainsDbi (const double *azimuth, const double *elevation,
+                      double *gains, uint32_t n) const;
+
+  double GetAzimuthAngle (void) const;
+  void SetAzimuthAngle (double azimuth);
+
+  double GetElevationAngle (void) const;
+  void SetElevationAngle (double elevation);
+
+  double GetBeamwidth (void) const;
+  double GetMaxGainDbi (void) const;
+  Ptr<AbstractAntenna> Copy (void) const;
+
+  double GetMode (void) const;
+  void SetMode (double);
+
+private:
+  Measured2DAntenna (const Measured2DAntenna &o);
+  Measured2DAntenna & operator = (const Measured2DAntenna &o);
+
+  double GetGain(double angle) const;
+  /* Gain interpolated between the measurements, angle relative to the
+   * antenna azimuth */
+  double InterpolateMeasurements(double angle) const;
+  /* TX and RX gains are the same */
+  void GetGainsDbi (const double *azimuth, const double *elevation,
+                    double *gains, uint32_t n) const;
+  void BuildLookupTable (void) const;
+  void SetLookupTableSize (uint32_t size);
+  uint32_t GetLookupTableSize (void) const;
+
+  double m_mode;
+  double m_verticalBeamwidth;
+  double m_elevation;
+  double m_azimuth;
+  std::vector<Ptr<M2D> > m_measurements;
+  /* InterpolateMeasurements sampled at m_lutSize angles evenly spaced over
+   * [0, 2*pi), plus the first sample again to close the circle. Built on
+   * first use, empty if m_lutSize is 0 */
+  uint32_t m_lutSize;
+  mutable std::vector<double> m_lut;
+};
+
+}; // namespace ns3
+
+#endif /* M2D_ANTENNA_H */
@@ -25,6 +25,7 @@
 #include "ns3/object.h"
 
 #include "ampdu-subframe-header.h"
+#include "ampdu-container.h"
 
 #include <list>
 
@@ -58,6 +59,15 @@ public:
    * specified how and if <i>packet</i> can be added to <i>aggregatedPacket</i>.
    */
   virtual bool Aggregate (Ptr<const Packet> packet, Ptr<Packet> aggregatedPacket) = 0;
+  /**
+   * \param payload the body of the MPDU we have to append to <i>ampdu</i>.
+   * \param hdr the MAC header of the MPDU.
+   * \param ampdu the A-MPDU that will reference the MPDU, if aggregation is possible.
+   * \return true if the MPDU can be aggregated to <i>ampdu</i>, false otherwise.
+   *
+   * As above, without copying the MPDU: only a reference to <i>payload</i> is kept.
+   */
+  virtual bool Aggregate (Ptr<const Packet> payload, const WifiMacHeader &hdr, Ptr<AmpduContainer> ampdu) = 0;
   /**
    * Adds A-MPDU subframe header and padding to each MPDU that is part of an A-MPDU before it is sent.
    */
@@ -71,6 +81,13 @@ public:
    * This method is used to determine if a packet could be aggregated to an A-MPDU without exceeding the maximum packet size.
    */
   virtual bool CanBeAggregated (uint32_t packetSize, Ptr<Packet> aggregatedPacket, uint8_t blockAckSize) = 0;
+  /**
+   * \param packetSize size of the MPDU we want to append to <i>ampdu</i>.
+   * \param ampdu the A-MPDU that will reference the MPDU of size <i>packetSize</i>, if aggregation is possible.
+   * \param blockAckSize size of the piggybacked block ack request
+   * \return true if the MPDU of size <i>packetSize</i> can be aggregated to <i>ampdu</i>, false otherwise.
+   */
+  virtual bool CanBeAggregated (uint32_t packetSize, Ptr<const AmpduContainer> ampdu, uint8_t blockAckSize) = 0;
   /**
    * \return padding that must be added to the end of an aggregated packet
    *
@@ -22,6 +22,7 @@
 
 #include "ampdu-subframe-header.h"
 #include "mpdu-standard-aggregator.h"
+#include "wifi-mac-trailer.h"
 
 NS_LOG_COMPONENT_DEFINE ("MpduStandardAggregator");
 
@@ -78,6 +79,20 @@ bool MpduStandardAggregator::Aggregate(Ptr<const Packet> packet, Ptr<Packet> agg
     return false;
 }
 
+bool MpduStandardAggregator::Aggregate (Ptr<const Packet> payload, const WifiMacHeader &hdr, Ptr<AmpduContainer> ampdu)
+{
+    NS_LOG_FUNCTION (this);
+    AmpduSubframeHeader currentHdr;
+    uint32_t mpduSize = payload->GetSize () + hdr.GetSize () + WIFI_MAC_FCS_LENGTH;
+
+    if ((currentHdr.GetSerializedSize () + mpduSize + ampdu->GetSize () + ampdu->GetPadding ()) <= m_maxAmpduLength)
+    {
+	ampdu->Add (payload, hdr);
+	return true;
+    }
+    return false;
+}
+
 void MpduStandardAggregator::AddHeaderAndPad (Ptr<Packet> packet, bool last)
 {
     NS_LOG_FUNCTION (this);
@@ -115,6 +130,16 @@ bool MpduStandardAggregator::CanBeAggregated (uint32_t packetSize, Ptr<Packet> a
     }
 }
 
+bool MpduStandardAggregator::CanBeAggregated (uint32_t packetSize, Ptr<const AmpduContainer> ampdu, uint8_t blockAckSize)
+{
+    uint32_t padding = ampdu->GetPadding ();
+    if (blockAckSize > 0)
+    {
+	blockAckSize = blockAckSize + 4 + padding;
+    }
+    return (4 + packetSize + ampdu->GetSize () + padding + blockAckSize) <= m_maxAmpduLength;
+}
+
 uint32_t MpduStandardAggregator::CalculatePadding (Ptr<const Packet> packet)
 {
     return (4 - (packet->GetSize () % 4 )) % 4;
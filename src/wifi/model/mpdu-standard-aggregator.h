@@ -44,6 +44,13 @@ public:
    * Returns true if <i>packet</i> can be aggregated to <i>aggregatedPacket</i>, false otherwise.
    */
   virtual bool Aggregate (Ptr<const Packet> packet, Ptr<Packet> aggregatedPacket);
+  /**
+   * \param payload the body of the MPDU we have to append to <i>ampdu</i>.
+   * \param hdr the MAC header of the MPDU.
+   * \param ampdu the A-MPDU that will reference the MPDU, if aggregation is possible.
+   * \return true if the MPDU can be aggregated to <i>ampdu</i>, false otherwise.
+   */
+  virtual bool Aggregate (Ptr<const Packet> payload, const WifiMacHeader &hdr, Ptr<AmpduContainer> ampdu);
   /**
    * Adds A-MPDU subframe header and padding to each MPDU that is part of an A-MPDU before it is sent.
    */
@@ -57,6 +64,13 @@ public:
    * This method is used to determine if a packet could be aggregated to an A-MPDU without exceeding the maximum packet size.
    */
   virtual bool CanBeAggregated (uint32_t packetSize, Ptr<Packet> aggregatedPacket, uint8_t blockAckSize);
+  /**
+   * \param packetSize size of the MPDU we want to append to <i>ampdu</i>.
+   * \param ampdu the A-MPDU that will reference the MPDU of size <i>packetSize</i>, if aggregation is possible.
+   * \param blockAckSize size of the piggybacked block ack request
+   * \return true if the MPDU of size <i>packetSize</i> can be aggregated to <i>ampdu</i>, false otherwise.
+   */
+  virtual bool CanBeAggregated (uint32_t packetSize, Ptr<const AmpduContainer> ampdu, uint8_t blockAckSize);
   /**
    * \return padding that must be added to the end of an aggregated packet
    *
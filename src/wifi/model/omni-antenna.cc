@@ -97,4 +97,10 @@ OmniAntenna::GetBeamwidth(void) const
 	return m_beamwidth;
 }
 
+double
+OmniAntenna::GetMaxGainDbi(void) const
+{
+	return m_gainDbi > 0 ? m_gainDbi : 0;
+}
+
 };
@@ -44,6 +44,7 @@ public:
   double GetGainDbi (void) const;
   void SetGainDbi (double gainDbi);
   double GetBeamwidth (void) const;
+  double GetMaxGainDbi (void) const;
 
 private:
   OmniAntenna (const OmniAntenna &o);
@@ -0,0 +1,254 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "tabulated-error-rate-model.h"
+
+#include "ns3/pointer.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TabulatedErrorRateModel");
+
+NS_OBJECT_ENSURE_REGISTERED (TabulatedErrorRateModel);
+
+/* The tables keep log (-log (success rate)): for a bit success rate p
+ * raised to the number of bits n it is log (n) + log (-log (p)), linear in
+ * log (n), and log (-log (p)) follows the waterfall of the model closely
+ * enough to be interpolated linearly in the SNR (dB). Both logarithms are
+ * bounded, for the success rates of 0 and 1.
+ */
+static const double MIN_LOG = -700;
+
+static double
+ToTable (double csr)
+{
+  double loss = -std::log (std::max (csr, std::exp (MIN_LOG)));
+  return std::log (std::max (loss, std::exp (MIN_LOG)));
+}
+
+static double
+FromTable (double value)
+{
+  return std::exp (-std::exp (value));
+}
+
+TypeId
+TabulatedErrorRateModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TabulatedErrorRateModel")
+    .SetParent<ErrorRateModel> ()
+    .AddConstructor<TabulatedErrorRateModel> ()
+    .AddAttribute ("ErrorRateModel",
+                   "The error rate model tabulated.",
+                   PointerValue (),
+                   MakePointerAccessor (&TabulatedErrorRateModel::SetErrorRateModel,
+                                        &TabulatedErrorRateModel::GetErrorRateModel),
+                   MakePointerChecker<ErrorRateModel> ())
+    .AddAttribute ("MinSnr",
+                   "Lowest SNR (dB) of the tables. The grid is fixed when the first table is built.",
+                   DoubleValue (-10.0),
+                   MakeDoubleAccessor (&TabulatedErrorRateModel::m_minSnrDb),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("MaxSnr",
+                   "Highest SNR (dB) of the tables.",
+                   DoubleValue (60.0),
+                   MakeDoubleAccessor (&TabulatedErrorRateModel::m_maxSnrDb),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("SnrStep",
+                   "Distance (dB) between the SNRs of the tables.",
+                   DoubleValue (0.05),
+                   MakeDoubleAccessor (&TabulatedErrorRateModel::m_snrStepDb),
+                   MakeDoubleChecker<double> (0.001))
+    .AddAttribute ("MaxBits",
+                   "Largest chunk of the tables, rounded down to a power of 2. The chunks are tabulated for the powers of 2 up to it.",
+                   UintegerValue (1 << 22),
+                   MakeUintegerAccessor (&TabulatedErrorRateModel::m_maxBits),
+                   MakeUintegerChecker<uint32_t> (2))
+    .AddAttribute ("Validate",
+                   "Compare every success rate with the one of the tabulated model.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TabulatedErrorRateModel::m_validate),
+                   MakeBooleanChecker ())
+    .AddAttribute ("Tolerance",
+                   "Largest difference from the success rate of the tabulated model accepted while validating.",
+                   DoubleValue (0.01),
+                   MakeDoubleAccessor (&TabulatedErrorRateModel::m_tolerance),
+                   MakeDoubleChecker<double> (0, 1))
+  ;
+  return tid;
+}
+
+TabulatedErrorRateModel::TabulatedErrorRateModel ()
+  : m_nSnrs (0),
+    m_nSizes (0),
+    m_maxError (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TabulatedErrorRateModel::~TabulatedErrorRateModel ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+TabulatedErrorRateModel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_model = 0;
+  Clear ();
+  ErrorRateModel::DoDispose ();
+}
+
+void
+TabulatedErrorRateModel::SetErrorRateModel (Ptr<ErrorRateModel> model)
+{
+  NS_LOG_FUNCTION (this << model);
+  m_model = model;
+  Clear ();
+}
+
+Ptr<ErrorRateModel>
+TabulatedErrorRateModel::GetErrorRateModel (void) const
+{
+  return m_model;
+}
+
+void
+TabulatedErrorRateModel::Clear (void)
+{
+  m_tables.clear ();
+  m_nSnrs = 0;
+  m_nSizes = 0;
+}
+
+double
+TabulatedErrorRateModel::GetMaxError (void) const
+{
+  return m_maxError;
+}
+
+void
+TabulatedErrorRateModel::Prepare (WifiMode mode) const
+{
+  GetTable (mode);
+}
+
+const std::vector<double> &
+TabulatedErrorRateModel::GetTable (WifiMode mode) const
+{
+  NS_ASSERT_MSG (m_model != 0, "TabulatedErrorRateModel without an error rate model");
+  if (m_tables.empty ())
+    {
+      NS_ASSERT (m_maxSnrDb > m_minSnrDb);
+      TabulatedErrorRateModel *self = const_cast<TabulatedErrorRateModel *> (this);
+      self->m_nSnrs = (uint32_t) std::floor ((m_maxSnrDb - m_minSnrDb) / m_snrStepDb) + 1;
+      self->m_nSizes = 1;
+      while (m_maxBits >> self->m_nSizes)
+        {
+          self->m_nSizes++;
+        }
+    }
+  uint32_t uid = mode.GetUid ();
+  if (uid >= m_tables.size ())
+    {
+      m_tables.resize (uid + 1);
+    }
+  std::vector<double> &table = m_tables[uid];
+  if (table.empty ())
+    {
+      NS_LOG_DEBUG ("Tabulating " << mode << ": " << m_nSnrs << " SNRs x " << m_nSizes << " sizes");
+      table.reserve (m_nSnrs * m_nSizes);
+      for (uint32_t i = 0; i < m_nSnrs; i++)
+        {
+          double snr = std::pow (10.0, (m_minSnrDb + i * m_snrStepDb) / 10.0);
+          for (uint32_t k = 0; k < m_nSizes; k++)
+            {
+              double csr = m_model->GetChunkSuccessRate (mode, snr, 1U << k);
+              table.push_back (ToTable (csr));
+            }
+        }
+    }
+  return table;
+}
+
+double
+TabulatedErrorRateModel::Lookup (WifiMode mode, double snr, uint32_t nbits) const
+{
+  if (nbits == 0)
+    {
+      return 1.0;
+    }
+  const std::vector<double> &table = GetTable (mode);
+  if (snr <= 0 || nbits > (1U << (m_nSizes - 1)))
+    {
+      return -1;
+    }
+  double x = (10 * std::log10 (snr) - m_minSnrDb) / m_snrStepDb;
+  if (x < 0 || x > m_nSnrs - 1)
+    {
+      return -1;
+    }
+  uint32_t i = std::min ((uint32_t) x, m_nSnrs - 2);
+  double fs = x - i;
+
+  uint32_t k = 0;
+  while (nbits >> (k + 1))
+    {
+      k++;
+    }
+  k = std::min (k, m_nSizes - 2);
+  double fb = std::log ((double) nbits / (1U << k)) / std::log (2.0);
+
+  const double *low = &table[i * m_nSizes + k];
+  const double *high = low + m_nSizes;
+  return FromTable ((1 - fs) * ((1 - fb) * low[0] + fb * low[1])
+                    + fs * ((1 - fb) * high[0] + fb * high[1]));
+}
+
+double
+TabulatedErrorRateModel::GetChunkSuccessRate (WifiMode mode, double snr, uint32_t nbits) const
+{
+  NS_LOG_FUNCTION (this << mode << snr << nbits);
+  double csr = Lookup (mode, snr, nbits);
+  if (csr < 0)
+    {
+      return m_model->GetChunkSuccessRate (mode, snr, nbits);
+    }
+  if (m_validate)
+    {
+      double error = std::fabs (csr - m_model->GetChunkSuccessRate (mode, snr, nbits));
+      m_maxError = std::max (m_maxError, error);
+      if (error > m_tolerance)
+        {
+          NS_FATAL_ERROR ("Tabulated success rate of " << mode << " at SNR " << snr << " for "
+                          << nbits << " bits off by " << error);
+        }
+    }
+  return csr;
+}
+
+} // namespace ns3
@@ -0,0 +1,121 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent <agent@local>
+ */
+#ifndef TABULATED_ERROR_RATE_MODEL_H
+#define TABULATED_ERROR_RATE_MODEL_H
+
+#include <stdint.h>
+#include <vector>
+#include "wifi-mode.h"
+#include "error-rate-model.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ * \brief an error rate model that looks up the chunk success rates of
+ * another model in tables
+ *
+ * The first time a mode is used, the success rate of the wrapped model is
+ * evaluated over a grid of SNRs, from MinSnr to MaxSnr in steps of
+ * SnrStep (dB), and of chunk sizes, the powers of 2 up to MaxBits. A chunk
+ * success rate is then interpolated between the two closest SNRs and the
+ * two closest sizes, in the logarithm of the logarithm of the success
+ * rate. Since the usual models raise a bit success rate to the number of
+ * bits, the interpolation over the logarithm of the size is exact for
+ * them. The chunks outside of the grid are passed to the wrapped model.
+ *
+ * The wrapped model must be a function of its arguments only: a model
+ * whose success rate steps with the SNR, as the SensitivityModel60GHz,
+ * is only approximated close to its steps. With Validate, every success
+ * rate is compared with the one of the wrapped model, and an error larger
+ * than Tolerance aborts the simulation.
+ */
+class TabulatedErrorRateModel : public ErrorRateModel
+{
+public:
+  static TypeId GetTypeId (void);
+
+  TabulatedErrorRateModel ();
+  virtual ~TabulatedErrorRateModel ();
+
+  /**
+   * \param model the error rate model to tabulate
+   *
+   * Drop the tables built with the previous model.
+   */
+  void SetErrorRateModel (Ptr<ErrorRateModel> model);
+  /**
+   * \return the error rate model tabulated
+   */
+  Ptr<ErrorRateModel> GetErrorRateModel (void) const;
+
+  /**
+   * \param mode the Wi-Fi mode to tabulate
+   *
+   * Build the table of mode now instead of on its first chunk.
+   */
+  void Prepare (WifiMode mode) const;
+  /**
+   * \return the largest difference from the wrapped model found while
+   * validating
+   */
+  double GetMaxError (void) const;
+
+  virtual double GetChunkSuccessRate (WifiMode mode, double snr, uint32_t nbits) const;
+
+private:
+  virtual void DoDispose (void);
+
+  /**
+   * \param mode the Wi-Fi mode
+   * \return the table of mode, built if it does not exist yet
+   */
+  const std::vector<double> & GetTable (WifiMode mode) const;
+  /**
+   * \return the success rate of the chunk interpolated in the table of
+   * mode, or -1 if the chunk is outside of the grid
+   */
+  double Lookup (WifiMode mode, double snr, uint32_t nbits) const;
+  /**
+   * Drop all the tables.
+   */
+  void Clear (void);
+
+  Ptr<ErrorRateModel> m_model;   //!< the error rate model tabulated
+  double m_minSnrDb;
+  double m_maxSnrDb;
+  double m_snrStepDb;
+  uint32_t m_maxBits;
+  bool m_validate;
+  double m_tolerance;
+
+  uint32_t m_nSnrs;              //!< number of SNRs of a table
+  uint32_t m_nSizes;             //!< number of chunk sizes of a table, 1 to 2^(m_nSizes - 1) bits
+  /**
+   * log (-log (success rate)) of each mode, indexed by mode UID, per
+   * SNR and then per chunk size. Empty until the mode is used.
+   */
+  mutable std::vector<std::vector<double> > m_tables;
+  mutable double m_maxError;     //!< largest error found while validating
+};
+
+} // namespace ns3
+
+#endif /* TABULATED_ERROR_RATE_MODEL_H */
@@ -62,8 +62,10 @@ WifiMacQueue::GetTypeId (void)
 }
 
 WifiMacQueue::WifiMacQueue ()
-  : m_size (0)
+  : m_size (0),
+    m_oldestTstamp (Seconds (0))
 {
+  m_lastPeeked = m_queue.end ();
   m_shallowBufTimerOn = false; // if the shallow buffer has been recorded 
   m_shallowBufStart =  Simulator::Now();   // The time at which the buffer has been reportedly shallow 
   m_shallowBufDurThresh = Seconds(1);
@@ -141,9 +143,108 @@ WifiMacQueue::Enqueue (Ptr<const Packet> packet, const WifiMacHeader &hdr)
       return;
     }
   Time now = Simulator::Now ();
-  m_queue.push_back (Item (packet, hdr, now));
+  Insert (Item (packet, hdr, now), false);
+}
+
+void
+WifiMacQueue::Insert (const Item &item, bool front)
+{
+  if (m_queue.empty () || item.tstamp < m_oldestTstamp)
+    {
+      m_oldestTstamp = item.tstamp;
+    }
+  PacketQueueI it;
+  if (front)
+    {
+      m_queue.push_front (item);
+      it = m_queue.begin ();
+    }
+  else
+    {
+      m_queue.push_back (item);
+      it = --m_queue.end ();
+    }
   m_size++;
 
+  if (!it->hdr.IsQosData ())
+    {
+      return;
+    }
+  it->srcsinkIp = ParseSrcDestinIpv4Address (it->packet);
+  FlowKey flow = std::make_pair (it->hdr.GetAddr1 (), it->srcsinkIp);
+  SubQueue &flowQueue = m_flowQueues[flow];
+  SubQueue &tidFlowQueue = m_tidFlowQueues[std::make_pair (flow, it->hdr.GetQosTid ())];
+  if (front)
+    {
+      it->flowIt = flowQueue.insert (flowQueue.begin (), it);
+      it->tidFlowIt = tidFlowQueue.insert (tidFlowQueue.begin (), it);
+    }
+  else
+    {
+      it->flowIt = flowQueue.insert (flowQueue.end (), it);
+      it->tidFlowIt = tidFlowQueue.insert (tidFlowQueue.end (), it);
+    }
+  m_nPacketsByTidAndAddr[std::make_pair (it->hdr.GetAddr1 (), it->hdr.GetQosTid ())]++;
+}
+
+WifiMacQueue::PacketQueueI
+WifiMacQueue::Erase (PacketQueueI it)
+{
+  if (it == m_lastPeeked)
+    {
+      m_lastPeeked = m_queue.end ();
+    }
+  if (it->hdr.IsQosData ())
+    {
+      FlowKey flow = std::make_pair (it->hdr.GetAddr1 (), it->srcsinkIp);
+      std::map<FlowKey, SubQueue>::iterator flowQueue = m_flowQueues.find (flow);
+      NS_ASSERT (flowQueue != m_flowQueues.end ());
+      flowQueue->second.erase (it->flowIt);
+      if (flowQueue->second.empty ())
+        {
+          m_flowQueues.erase (flowQueue);
+        }
+      std::map<TidFlowKey, SubQueue>::iterator tidFlowQueue =
+        m_tidFlowQueues.find (std::make_pair (flow, it->hdr.GetQosTid ()));
+      NS_ASSERT (tidFlowQueue != m_tidFlowQueues.end ());
+      tidFlowQueue->second.erase (it->tidFlowIt);
+      if (tidFlowQueue->second.empty ())
+        {
+          m_tidFlowQueues.erase (tidFlowQueue);
+        }
+      std::map<TidAddrKey, uint32_t>::iterator count =
+        m_nPacketsByTidAndAddr.find (std::make_pair (it->hdr.GetAddr1 (), it->hdr.GetQosTid ()));
+      NS_ASSERT (count != m_nPacketsByTidAndAddr.end () && count->second > 0);
+      if (--count->second == 0)
+        {
+          m_nPacketsByTidAndAddr.erase (count);
+        }
+    }
+  m_size--;
+  return m_queue.erase (it);
+}
+
+WifiMacQueue::PacketQueueI
+WifiMacQueue::FindFirstByFlow (Mac48Address addr, std::pair <Ipv4Address,Ipv4Address> srcsinkIp)
+{
+  std::map<FlowKey, SubQueue>::iterator flowQueue = m_flowQueues.find (std::make_pair (addr, srcsinkIp));
+  if (flowQueue == m_flowQueues.end ())
+    {
+      return m_queue.end ();
+    }
+  return flowQueue->second.front ();
+}
+
+WifiMacQueue::PacketQueueI
+WifiMacQueue::FindFirstByTidAndFlow (Mac48Address addr, std::pair <Ipv4Address,Ipv4Address> srcsinkIp, uint8_t tid)
+{
+  std::map<TidFlowKey, SubQueue>::iterator tidFlowQueue =
+    m_tidFlowQueues.find (std::make_pair (std::make_pair (addr, srcsinkIp), tid));
+  if (tidFlowQueue == m_tidFlowQueues.end ())
+    {
+      return m_queue.end ();
+    }
+  return tidFlowQueue->second.front ();
 }
 
 void
@@ -155,20 +256,25 @@ WifiMacQueue::Cleanup (void)
     }
 
   Time now = Simulator::Now ();
-  uint32_t n = 0;
+  //m_oldestTstamp is a lower bound of all timestamps: nothing can have expired yet
+  if (m_oldestTstamp + m_maxDelay > now)
+    {
+      return;
+    }
+  Time oldest = now;
   for (PacketQueueI i = m_queue.begin (); i != m_queue.end ();)
     {
       if (i->tstamp + m_maxDelay > now)
         {
+          oldest = std::min (oldest, i->tstamp);
           i++;
         }
       else
         {
-          i = m_queue.erase (i);
-          n++;
+          i = Erase (i);
         }
     }
-  m_size -= n;
+  m_oldestTstamp = oldest;
 }
 
 Ptr<const Packet>
@@ -178,8 +284,7 @@ WifiMacQueue::Dequeue (WifiMacHeader *hdr)
   if (!m_queue.empty ())
     {
       Item i = m_queue.front ();
-      m_queue.pop_front ();
-      m_size--;
+      Erase (m_queue.begin ());
       *hdr = i.hdr;
       return i.packet;
     }
@@ -192,9 +297,9 @@ WifiMacQueue::Peek (WifiMacHeader *hdr)
   Cleanup ();
   if (!m_queue.empty ())
     {
-      Item i = m_queue.front ();
-      *hdr = i.hdr;
-      return i.packet;
+      m_lastPeeked = m_queue.begin ();
+      *hdr = m_lastPeeked->hdr;
+      return m_lastPeeked->packet;
     }
   return 0;
 }
@@ -208,25 +313,29 @@ WifiMacQueue::DequeueByTidAndAddress (WifiMacHeader *hdr, uint8_t tid,
   NS_LOG_FUNCTION (this);
   Cleanup ();
   Ptr<const Packet> packet = 0;
-  if (!m_queue.empty ())
+  PacketQueueI it = m_queue.end ();
+  if (type == WifiMacHeader::ADDR1)
+    {
+      it = FindFirstByTidAndFlow (nextHopMacAddr, srcsinkIp, tid);
+    }
+  else
     {
-      PacketQueueI it;
       for (it = m_queue.begin (); it != m_queue.end (); ++it)
         {
-          if (it->hdr.IsQosData ())
+          if (it->hdr.IsQosData ()
+              && GetNextHopMacAddressForPacket (type, it) == nextHopMacAddr
+              && it->hdr.GetQosTid () == tid && GetSrcDestinIpv4AddressForPacket (it) == srcsinkIp)
             {
-              if (GetNextHopMacAddressForPacket (type, it) == nextHopMacAddr
-                  && it->hdr.GetQosTid () == tid && GetSrcDestinIpv4AddressForPacket(it) == srcsinkIp )
-                {
-                  packet = it->packet;
-                  *hdr = it->hdr;
-                  m_queue.erase (it);
-                  m_size--;
-                  break;
-                }
+              break;
             }
         }
     }
+  if (it != m_queue.end ())
+    {
+      packet = it->packet;
+      *hdr = it->hdr;
+      Erase (it);
+    }
   return packet;
 }
 
@@ -239,86 +348,139 @@ WifiMacQueue::PeekByTidAndAddress (WifiMacHeader *hdr, uint8_t tid,
 {
   NS_LOG_FUNCTION (this);
   Cleanup ();
-  if (!m_queue.empty ())
+  PacketQueueI it = m_queue.end ();
+  if (type == WifiMacHeader::ADDR1)
+    {
+      it = FindFirstByTidAndFlow (nextHopMacAddr, srcsinkIp, tid);
+    }
+  else
     {
-      PacketQueueI it;
       for (it = m_queue.begin (); it != m_queue.end (); ++it)
         {
-          if (it->hdr.IsQosData ())
+          if (it->hdr.IsQosData ()
+              && GetNextHopMacAddressForPacket (type, it) == nextHopMacAddr
+              && it->hdr.GetQosTid () == tid && GetSrcDestinIpv4AddressForPacket (it) == srcsinkIp)
             {
-              if (GetNextHopMacAddressForPacket (type, it) == nextHopMacAddr
-                  && it->hdr.GetQosTid () == tid  && GetSrcDestinIpv4AddressForPacket(it) == srcsinkIp )
-                {
-                  *hdr = it->hdr;
-                  *timestamp=it->tstamp;
-                  return it->packet;
-                }
+              break;
             }
         }
     }
+  if (it != m_queue.end ())
+    {
+      m_lastPeeked = it;
+      *hdr = it->hdr;
+      *timestamp = it->tstamp;
+      return it->packet;
+    }
+  return 0;
+}
+
+Ptr<const Packet>
+WifiMacQueue::PeekFittingFlowHeadByTid (WifiMacHeader *hdr, uint8_t tid,
+                                        Mac48Address addr,
+                                        std::pair <Ipv4Address,Ipv4Address> srcsinkIp,
+                                        uint32_t maxSize, Time *timestamp)
+{
+  NS_LOG_FUNCTION (this << (uint32_t) tid << addr << maxSize);
+  Cleanup ();
+  PacketQueueI found = m_queue.end ();
+  for (std::map<TidFlowKey, SubQueue>::iterator tidFlowQueue = m_tidFlowQueues.begin ();
+       tidFlowQueue != m_tidFlowQueues.end (); ++tidFlowQueue)
+    {
+      if (tidFlowQueue->first.first.first != addr || tidFlowQueue->first.second != tid
+          || tidFlowQueue->first.first.second == srcsinkIp)
+        {
+          continue;
+        }
+      PacketQueueI it = tidFlowQueue->second.front ();
+      if (it->packet->GetSize () + it->hdr.GetSize () <= maxSize
+          && (found == m_queue.end () || it->tstamp < found->tstamp))
+        {
+          found = it;
+        }
+    }
+  if (found != m_queue.end ())
+    {
+      m_lastPeeked = found;
+      *hdr = found->hdr;
+      *timestamp = found->tstamp;
+      return found->packet;
+    }
   return 0;
 }
- 
-    Ptr<const Packet>
-    WifiMacQueue::DequeueByAddress (WifiMacHeader *hdr,
-                                        WifiMacHeader::AddressType type, 
-                                        Mac48Address nextHopMacAddr,
-                                        std::pair <Ipv4Address,Ipv4Address> srcsinkIp)
-    {
-        NS_LOG_FUNCTION (this);
-        Cleanup ();
-        Ptr<const Packet> packet = 0;
-        if (!m_queue.empty ())
+
+Ptr<const Packet>
+WifiMacQueue::DequeueByAddress (WifiMacHeader *hdr,
+                                WifiMacHeader::AddressType type,
+                                Mac48Address nextHopMacAddr,
+                                std::pair <Ipv4Address,Ipv4Address> srcsinkIp)
+{
+  NS_LOG_FUNCTION (this);
+  Cleanup ();
+  Ptr<const Packet> packet = 0;
+  PacketQueueI it = m_queue.end ();
+  if (type == WifiMacHeader::ADDR1)
+    {
+      it = FindFirstByFlow (nextHopMacAddr, srcsinkIp);
+    }
+  else
+    {
+      for (it = m_queue.begin (); it != m_queue.end (); ++it)
         {
-            PacketQueueI it;
-            for (it = m_queue.begin (); it != m_queue.end (); ++it)
+          if (it->hdr.IsQosData ()
+              && GetNextHopMacAddressForPacket (type, it) == nextHopMacAddr
+              && GetSrcDestinIpv4AddressForPacket (it) == srcsinkIp)
             {
-                if (it->hdr.IsQosData ())
-                {
-                    if (GetNextHopMacAddressForPacket (type, it) == nextHopMacAddr  && GetSrcDestinIpv4AddressForPacket(it) == srcsinkIp )
-                    {
-                        packet = it->packet;
-                        *hdr = it->hdr;
-                        m_queue.erase (it);
-                        m_size--;
-                        break;
-                    }
-                }
+              break;
             }
         }
-        return packet;
     }
-    
-    Ptr<const Packet>
-    WifiMacQueue::PeekByAddress (WifiMacHeader *hdr,
-                                        WifiMacHeader::AddressType type, 
-                                        Mac48Address nextHopMacAddr,
-                                        std::pair <Ipv4Address,Ipv4Address> srcsinkIp,
-                                        Time *timestamp)
+  if (it != m_queue.end ())
+    {
+      packet = it->packet;
+      *hdr = it->hdr;
+      Erase (it);
+    }
+  return packet;
+}
+
+Ptr<const Packet>
+WifiMacQueue::PeekByAddress (WifiMacHeader *hdr,
+                             WifiMacHeader::AddressType type,
+                             Mac48Address nextHopMacAddr,
+                             std::pair <Ipv4Address,Ipv4Address> srcsinkIp,
+                             Time *timestamp)
+{
+  NS_LOG_FUNCTION (this << "peeking for packets to"<< nextHopMacAddr<<"src addr "<< srcsinkIp.first << " sink Ip Addr"<< srcsinkIp.second);
+  Cleanup ();
+  PacketQueueI it = m_queue.end ();
+  if (type == WifiMacHeader::ADDR1)
     {
-        NS_LOG_FUNCTION (this << "peeking for packets to"<< nextHopMacAddr<<"src addr "<< srcsinkIp.first << " sink Ip Addr"<< srcsinkIp.second);
-        Cleanup ();
-        if (!m_queue.empty ())
+      it = FindFirstByFlow (nextHopMacAddr, srcsinkIp);
+    }
+  else
+    {
+      for (it = m_queue.begin (); it != m_queue.end (); ++it)
         {
-            PacketQueueI it;
-            for (it = m_queue.begin (); it != m_queue.end (); ++it)
+          if (it->hdr.IsQosData ()
+              && GetNextHopMacAddressForPacket (type, it) == nextHopMacAddr
+              && GetSrcDestinIpv4AddressForPacket (it) == srcsinkIp)
             {
-                if (it->hdr.IsQosData ())
-                {
-                    NS_LOG_DEBUG ("TYPE: "<<type);
-                    if (GetNextHopMacAddressForPacket (type, it) == nextHopMacAddr && GetSrcDestinIpv4AddressForPacket(it) == srcsinkIp )
-                    {
-                        *hdr = it->hdr;
-                        *timestamp=it->tstamp;
-                        NS_LOG_DEBUG("peek packet to " << nextHopMacAddr);
-                        return it->packet;
-                    }
-                }
+              break;
             }
         }
-        NS_LOG_DEBUG("Return 0");
-        return 0;
     }
+  if (it != m_queue.end ())
+    {
+      m_lastPeeked = it;
+      *hdr = it->hdr;
+      *timestamp = it->tstamp;
+      NS_LOG_DEBUG ("peek packet to " << nextHopMacAddr);
+      return it->packet;
+    }
+  NS_LOG_DEBUG ("Return 0");
+  return 0;
+}
 
 
 bool
@@ -338,6 +500,10 @@ void
 WifiMacQueue::Flush (void)
 {
   m_queue.erase (m_queue.begin (), m_queue.end ());
+  m_flowQueues.clear ();
+  m_tidFlowQueues.clear ();
+  m_nPacketsByTidAndAddr.clear ();
+  m_lastPeeked = m_queue.end ();
   m_size = 0;
 }
 
@@ -362,15 +528,25 @@ WifiMacQueue::GetNextHopMacAddressForPacket (enum WifiMacHeader::AddressType typ
 std::pair <Ipv4Address,Ipv4Address> 
 WifiMacQueue::GetSrcDestinIpv4AddressForPacket (PacketQueueI it)
 {
-  Ptr<Packet> pCopy = it->packet->Copy ();
+  return it->srcsinkIp;
+}
 
-  LlcSnapHeader llc;
-  pCopy->RemoveHeader(llc);
+std::pair <Ipv4Address,Ipv4Address> 
+WifiMacQueue::ParseSrcDestinIpv4Address (Ptr<const Packet> packet)
+{
+  std::pair <Ipv4Address,Ipv4Address> srcsinkIp;  
 
+  LlcSnapHeader llc;
   Ipv4Header ipv4Header;
-  pCopy->RemoveHeader (ipv4Header);
+  if (packet->GetSize () < llc.GetSerializedSize () + ipv4Header.GetSerializedSize ())
+    {
+      //not an IPv4 packet (e.g. raw packets in tests)
+      return srcsinkIp;
+    }
 
-  std::pair <Ipv4Address,Ipv4Address> srcsinkIp;  
+  Ptr<Packet> pCopy = packet->Copy ();
+  pCopy->RemoveHeader(llc);
+  pCopy->RemoveHeader (ipv4Header);
 
   srcsinkIp.first = ipv4Header.GetSource ();
   srcsinkIp.second = ipv4Header.GetDestination ();
@@ -381,13 +557,18 @@ WifiMacQueue::GetSrcDestinIpv4AddressForPacket (PacketQueueI it)
 bool
 WifiMacQueue::Remove (Ptr<const Packet> packet)
 {
+  //the usual pattern is to peek a packet and then remove it
+  if (m_lastPeeked != m_queue.end () && m_lastPeeked->packet == packet)
+    {
+      Erase (m_lastPeeked);
+      return true;
+    }
   PacketQueueI it = m_queue.begin ();
   for (; it != m_queue.end (); it++)
     {
       if (it->packet == packet)
         {
-          m_queue.erase (it);
-          m_size--;
+          Erase (it);
           return true;
         }
     }
@@ -404,8 +585,7 @@ WifiMacQueue::PushFront (Ptr<const Packet> packet, const WifiMacHeader &hdr)
       return;
     }
   Time now = Simulator::Now ();
-  m_queue.push_front (Item (packet, hdr, now));
-  m_size++;
+  Insert (Item (packet, hdr, now), true);
 }
 
 uint32_t
@@ -414,6 +594,12 @@ WifiMacQueue::GetNPacketsByTidAndAddress (uint8_t tid, WifiMacHeader::AddressTyp
 {
   Cleanup ();
   uint32_t nPackets = 0;
+  if (type == WifiMacHeader::ADDR1)
+    {
+      std::map<TidAddrKey, uint32_t>::const_iterator count =
+        m_nPacketsByTidAndAddr.find (std::make_pair (addr, tid));
+      return count == m_nPacketsByTidAndAddr.end () ? 0 : count->second;
+    }
   if (!m_queue.empty ())
     {
       PacketQueueI it;
@@ -438,14 +624,20 @@ WifiMacQueue::GetNPacketsByAddress (WifiMacHeader::AddressType type,
 {
   Cleanup ();
   uint32_t nPackets = 0;
+  if (type == WifiMacHeader::ADDR1)
+    {
+      std::map<FlowKey, SubQueue>::const_iterator flowQueue =
+        m_flowQueues.find (std::make_pair (addr, srcsinkIp));
+      return flowQueue == m_flowQueues.end () ? 0 : flowQueue->second.size ();
+    }
   if (!m_queue.empty ())
     {
       PacketQueueI it;
       for (it = m_queue.begin (); it != m_queue.end (); it++)
         {
-          if (GetNextHopMacAddressForPacket (type, it) == addr && GetSrcDestinIpv4AddressForPacket(it) == srcsinkIp)
+          if (it->hdr.IsQosData ())
             {
-              if (it->hdr.IsQosData ())
+              if (GetNextHopMacAddressForPacket (type, it) == addr && GetSrcDestinIpv4AddressForPacket(it) == srcsinkIp)
                 {
                   nPackets++;
                 }
@@ -470,8 +662,7 @@ WifiMacQueue::DequeueFirstAvailable (WifiMacHeader *hdr, Time &timestamp,
           *hdr = it->hdr;
           timestamp = it->tstamp;
           packet = it->packet;
-          m_queue.erase (it);
-          m_size--;
+          Erase (it);
           return packet;
         }
     }
@@ -489,6 +680,7 @@ WifiMacQueue::PeekFirstAvailable (WifiMacHeader *hdr, Time &timestamp,
       if (!it->hdr.IsQosData ()
           || !blockedPackets->IsBlocked (it->hdr.GetAddr1 (), it->hdr.GetQosTid ()))
         {
+          m_lastPeeked = it;
           *hdr = it->hdr;
           timestamp = it->tstamp;
           return it->packet;
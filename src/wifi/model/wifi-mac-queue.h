@@ -23,6 +23,7 @@
 #define WIFI_MAC_QUEUE_H
 
 #include <list>
+#include <map>
 #include <utility>
 #include "ns3/packet.h"
 #include "ns3/nstime.h"
@@ -49,6 +50,11 @@ class QosBlockedDestinations;
  * to verify whether or not it should be dropped. If
  * dot11EDCATableMSDULifetime has elapsed, it is dropped.
  * Otherwise, it is returned to the caller.
+ *
+ * QoS data packets are also kept in secondary FIFO sub-queues keyed by
+ * next hop (Addr1), IPv4 source/sink pair and TID. The IPv4 pair is parsed
+ * once at enqueue time, so that the DMG per-flow Peek/Dequeue methods and
+ * the per-address packet counters do not need to scan the whole queue.
  */
 class WifiMacQueue : public Object
 {
@@ -148,6 +154,30 @@ public:
                                          Mac48Address addr,
                                          std::pair <Ipv4Address,Ipv4Address> srcsinkIp,
                                          Time *timestamp);
+  /**
+   * Search the QoS data packets of the given next hop (Addr1) and TID
+   * for the oldest head of an IPv4 source/sink flow, other than
+   * <i>srcsinkIp</i>, whose size plus the size of its header is at most
+   * <i>maxSize</i>. Only the heads are considered, so that no packet
+   * overtakes the earlier packets of its flow. This method doesn't remove
+   * the packet from this queue.
+   * Is typically used by ns3::MacLow to fill the end of a DMG SP with the
+   * MPDUs that still fit in it.
+   *
+   * \param hdr the header of the packet found
+   * \param tid the given TID
+   * \param addr the given next hop
+   * \param srcsinkIp the IPv4 source/sink pair of the flow to skip
+   * \param maxSize the maximum size of the packet and its header
+   * \param timestamp the time the packet was queued
+   * \return packet, 0 if no head is small enough
+   */
+  Ptr<const Packet> PeekFittingFlowHeadByTid (WifiMacHeader *hdr,
+                                              uint8_t tid,
+                                              Mac48Address addr,
+                                              std::pair <Ipv4Address,Ipv4Address> srcsinkIp,
+                                              uint32_t maxSize,
+                                              Time *timestamp);
     
     Ptr<const Packet> DequeueByAddress (WifiMacHeader *hdr,
                                               WifiMacHeader::AddressType type,
@@ -162,7 +192,8 @@ public:
   /**
    * If exists, removes <i>packet</i> from queue and returns true. Otherwise it
    * takes no effects and return false. Deletion of the packet is
-   * performed in linear time (O(n)).
+   * performed in constant time if <i>packet</i> is the last packet returned
+   * by one of the Peek methods, in linear time (O(n)) otherwise.
    *
    * \param packet the packet to be removed
    * \return true if the packet was removed, false otherwise
@@ -240,6 +271,41 @@ protected:
    */
   virtual void Cleanup (void);
 
+  struct Item;
+  /**
+   * typedef for packet (struct Item) queue.
+   */
+  typedef std::list<struct Item> PacketQueue;
+  /**
+   * typedef for packet (struct Item) queue reverse iterator.
+   */
+  typedef std::list<struct Item>::reverse_iterator PacketQueueRI;
+  /**
+   * typedef for packet (struct Item) queue iterator.
+   */
+  typedef std::list<struct Item>::iterator PacketQueueI;
+  /**
+   * typedef for a sub-queue holding, in FIFO order, iterators to the
+   * QoS data packets of m_queue that share the same index key.
+   */
+  typedef std::list<PacketQueueI> SubQueue;
+  /**
+   * typedef for sub-queue iterator.
+   */
+  typedef std::list<PacketQueueI>::iterator SubQueueI;
+  /**
+   * Key of the per-flow index: next hop (Addr1) and IPv4 source/sink pair.
+   */
+  typedef std::pair<Mac48Address, std::pair<Ipv4Address,Ipv4Address> > FlowKey;
+  /**
+   * Key of the per-flow, per-TID index.
+   */
+  typedef std::pair<FlowKey, uint8_t> TidFlowKey;
+  /**
+   * Key of the per-next-hop, per-TID packet counter.
+   */
+  typedef std::pair<Mac48Address, uint8_t> TidAddrKey;
+
   /**
    * A struct that holds information about a packet for putting
    * in a packet queue.
@@ -259,20 +325,11 @@ protected:
     Ptr<const Packet> packet;	//!< Actual packet
     WifiMacHeader hdr;		//!< Wifi MAC header associated with the packet
     Time tstamp;		//!< timestamp when the packet arrived at the queue
+    std::pair <Ipv4Address,Ipv4Address> srcsinkIp; //!< IPv4 source/sink pair, cached at enqueue time
+    SubQueueI flowIt;		//!< position in m_flowQueues (QoS data only)
+    SubQueueI tidFlowIt;	//!< position in m_tidFlowQueues (QoS data only)
   };
 
-  /**
-   * typedef for packet (struct Item) queue.
-   */
-  typedef std::list<struct Item> PacketQueue;
-  /**
-   * typedef for packet (struct Item) queue reverse iterator.
-   */
-  typedef std::list<struct Item>::reverse_iterator PacketQueueRI;
-  /**
-   * typedef for packet (struct Item) queue iterator.
-   */
-  typedef std::list<struct Item>::iterator PacketQueueI;
   /**
    * Return the appropriate address for the given packet (given by PacketQueue iterator).
    *
@@ -284,17 +341,64 @@ protected:
 
   /**
    * Return the Ipv4 address for the given packet (given by PacketQueue iterator).
+   * The pair is parsed once when the packet is queued and cached in the Item.
    *
-   * \param type
    * \param it
    * \return the address
    */
   std::pair <Ipv4Address,Ipv4Address> GetSrcDestinIpv4AddressForPacket (PacketQueueI it);
 
+  /**
+   * Parse the IPv4 source/sink pair out of an LLC/SNAP encapsulated packet.
+   *
+   * \param packet
+   * \return the address pair
+   */
+  static std::pair <Ipv4Address,Ipv4Address> ParseSrcDestinIpv4Address (Ptr<const Packet> packet);
+
+  /**
+   * Insert an item at the front or at the back of the queue and add it to
+   * the secondary indexes.
+   *
+   * \param item the item to insert
+   * \param front true to insert at the front of the queue
+   */
+  void Insert (const Item &item, bool front);
+  /**
+   * Remove the given item from the queue and from the secondary indexes.
+   *
+   * \param it the item to remove
+   * \return iterator to the item following the removed one
+   */
+  PacketQueueI Erase (PacketQueueI it);
+  /**
+   * Return the first QoS data packet queued for the given flow, if any.
+   *
+   * \param addr the next hop (Addr1)
+   * \param srcsinkIp the IPv4 source/sink pair
+   * \return an iterator to the packet or m_queue.end ()
+   */
+  PacketQueueI FindFirstByFlow (Mac48Address addr, std::pair <Ipv4Address,Ipv4Address> srcsinkIp);
+  /**
+   * Return the first QoS data packet queued for the given flow and TID, if any.
+   *
+   * \param addr the next hop (Addr1)
+   * \param srcsinkIp the IPv4 source/sink pair
+   * \param tid the TID
+   * \return an iterator to the packet or m_queue.end ()
+   */
+  PacketQueueI FindFirstByTidAndFlow (Mac48Address addr, std::pair <Ipv4Address,Ipv4Address> srcsinkIp, uint8_t tid);
+
   PacketQueue m_queue;	//!< Packet (struct Item) queue.
   uint32_t m_size;	//!< Current queue size.
   uint32_t m_maxSize;	//!< Queue capacity.
   Time m_maxDelay;	//!< Time to live for packets in the queue.
+  Time m_oldestTstamp;	//!< Lower bound of the timestamps of the queued packets.
+
+  std::map<FlowKey, SubQueue> m_flowQueues;		//!< QoS data packets indexed by (Addr1, src/sink)
+  std::map<TidFlowKey, SubQueue> m_tidFlowQueues;	//!< QoS data packets indexed by (Addr1, src/sink, TID)
+  std::map<TidAddrKey, uint32_t> m_nPacketsByTidAndAddr;	//!< number of QoS data packets per (Addr1, TID)
+  PacketQueueI m_lastPeeked;	//!< last packet returned by a peek, checked first by Remove
 
   bool m_shallowBufTimerOn; // if the shallow buffer has been recorded 
   Time m_shallowBufStart;   // The time at which the buffer has been reportedly shallow 
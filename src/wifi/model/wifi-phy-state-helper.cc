@@ -437,6 +437,28 @@ WifiPhyStateHelper::SwitchFromRxEndError (Ptr<const Packet> packet, double snr)
     }
 }
 
+void
+WifiPhyStateHelper::ReceiveSubframeOk (Ptr<Packet> packet, double snr, WifiMode mode, enum WifiPreamble preamble)
+{
+  NS_ASSERT (IsStateRx ());
+  m_rxOkTrace (packet, snr, mode, preamble);
+  if (!m_rxOkCallback.IsNull ())
+    {
+      m_rxOkCallback (packet, snr, mode, preamble);
+    }
+}
+
+void
+WifiPhyStateHelper::ReceiveSubframeError (Ptr<const Packet> packet, double snr)
+{
+  NS_ASSERT (IsStateRx ());
+  m_rxErrorTrace (packet, snr);
+  if (!m_rxErrorCallback.IsNull ())
+    {
+      m_rxErrorCallback (packet, snr);
+    }
+}
+
 void
 WifiPhyStateHelper::DoSwitchFromRx (void)
 {
@@ -168,6 +168,25 @@ public:
    * \param snr the SNR of the received packet
    */
   void SwitchFromRxEndError (Ptr<const Packet> packet, double snr);
+  /**
+   * Deliver a subframe received successfully, staying in RX. Used for the
+   * subframes of a PPDU but the last, which goes through SwitchFromRxEndOk.
+   *
+   * \param packet the successfully received subframe
+   * \param snr the SNR of the received subframe
+   * \param mode the transmission mode of the subframe
+   * \param preamble the preamble of the received subframe
+   */
+  void ReceiveSubframeOk (Ptr<Packet> packet, double snr, WifiMode mode, enum WifiPreamble preamble);
+  /**
+   * Report a subframe that we failed to receive, staying in RX. Used for
+   * the subframes of a PPDU but the last, which goes through
+   * SwitchFromRxEndError.
+   *
+   * \param packet the subframe that we failed to received
+   * \param snr the SNR of the received subframe
+   */
+  void ReceiveSubframeError (Ptr<const Packet> packet, double snr);
   /**
    * Switch to CCA busy.
    *
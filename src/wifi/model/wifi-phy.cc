@@ -950,6 +950,12 @@ WifiPhy::CalculateTxDuration(uint32_t size, WifiTxVector txvector, WifiPreamble
     return duration;
 }
 
+bool
+WifiPhy::SendPpdu (const std::vector<Ptr<const Packet> > &, WifiTxVector, enum WifiPreamble)
+{
+    return false;
+}
+
 void
 WifiPhy::NotifyTxBegin(Ptr<const Packet> packet)
 {
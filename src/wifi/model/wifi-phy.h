@@ -33,6 +33,7 @@
 #include "abstract-antenna.h"
 #include "ns3/traced-callback.h"
 #include "wifi-tx-vector.h"
+#include <vector>
 
 namespace ns3 {
 
@@ -212,6 +213,17 @@ public:
    * \param packetType the type of the packet 0 is not A-MPDU, 1 is a MPDU that is part of an A-MPDU and 2 is the last MPDU in an A-MPDU
    */
   virtual void SendPacket (Ptr<const Packet> packet, WifiTxVector txvector, enum WifiPreamble preamble, uint8_t packetType) = 0;
+  /**
+   * \param mpdus the subframes of an A-MPDU, as SendPacket would get them one at a time
+   * \param txvector the txvector of the PPDU
+   * \param preamble the type of preamble of the PPDU
+   * \return true if the PPDU was sent, false if the caller must send the subframes with SendPacket
+   *
+   * Send the subframes of an A-MPDU as one PPDU: the receiver is notified
+   * once, when the PPDU ends, instead of once per subframe. The default
+   * implementation sends nothing and returns false.
+   */
+  virtual bool SendPpdu (const std::vector<Ptr<const Packet> > &mpdus, WifiTxVector txvector, enum WifiPreamble preamble);
 
   /**
    * \param listener the new listener
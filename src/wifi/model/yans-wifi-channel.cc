@@ -24,6 +24,8 @@
 #include "ns3/node.h"
 #include "ns3/log.h"
 #include "ns3/pointer.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
 #include "ns3/object-factory.h"
 #include "yans-wifi-channel.h"
 #include "yans-wifi-phy.h"
@@ -31,7 +33,9 @@
 #include "ns3/propagation-delay-model.h"
 #include "ns3/wifi-mac-header.h"
 #include "ampdu-tag.h"
-#include "mpdu-aggregator.h"
+#include "ampdu-container.h"
+#include "dmg-antenna-controller.h"
+#include <algorithm>
 
 namespace ns3 {
 
@@ -53,11 +57,47 @@ YansWifiChannel::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&YansWifiChannel::m_delay),
                    MakePointerChecker<PropagationDelayModel> ())
+    .AddAttribute ("DmgMode", "Reuse precomputed link budgets between PHYs equipped with a "
+                   "DmgAntennaController and do not schedule receptions below DmgRxPowerFloor.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&YansWifiChannel::m_dmgMode),
+                   MakeBooleanChecker ())
+    .AddAttribute ("DmgRxPowerFloor", "In DMG mode, receivers whose best-case received power "
+                   "(max TX and RX antenna gains) is below this value in dBm are skipped.",
+                   DoubleValue (-120.0),
+                   MakeDoubleAccessor (&YansWifiChannel::m_dmgRxPowerFloorDbm),
+                   MakeDoubleChecker<double> ())
   ;
   return tid;
 }
 
+namespace {
+
+/**
+ * Order link budgets by decreasing best-case gain.
+ */
+struct LinkBudgetBestFirst
+{
+  template <typename T>
+  bool operator () (const T &a, const T &b) const
+  {
+    return a.bestGainDb > b.bestGainDb;
+  }
+};
+
+bool
+IsMoving (Ptr<MobilityModel> mobility)
+{
+  Vector v = mobility->GetVelocity ();
+  return v.x != 0 || v.y != 0 || v.z != 0;
+}
+
+} // anonymous namespace
+
 YansWifiChannel::YansWifiChannel ()
+  : m_dmgMode (false),
+    m_dmgRxPowerFloorDbm (-120.0),
+    m_nCourseChangeConnected (0)
 {
 }
 
@@ -97,27 +137,25 @@ YansWifiChannel::Send(Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double
     double rxPowerDbm;
     Time delay;
     Ptr<MobilityModel> receiverMobility;
-    WifiMacHeader hdr;
 
+    // Only the first MAC header is needed: peek it in place, after the
+    // A-MPDU subframe header if the packet is an aggregate.
     WifiMacHeader hdrTmp;
-    Ptr<Packet> packetTmp;
-    packetTmp = packet->Copy();
     AmpduTag ampdutag;
-    if (packetTmp->RemovePacketTag(ampdutag)) {
-
-      //  NS_LOG_UNCOND("ampdutag exists " << packetTmp->GetSize());
-      MpduAggregator::DeaggregatedMpdus packets =  MpduAggregator::Deaggregate(packetTmp);
-      MpduAggregator::DeaggregatedMpdusCI n = packets.begin();
-
-      (*n).first->PeekHeader(hdrTmp);
-
+    if (packet->PeekPacketTag(ampdutag)) {
+      AmpduContainer::PeekMacHeader(packet, hdrTmp);
     } else {
-
-      //  NS_LOG_UNCOND("ampdutag doesn't exist' " << packetTmp->GetSize());
-      packetTmp->PeekHeader (hdrTmp);
+      packet->PeekHeader (hdrTmp);
     }
 
-    packet->PeekHeader (hdr);//!! 
+    if (m_dmgMode && senderAntCtrl)
+    {
+        std::map<Ptr<YansWifiPhy>, uint32_t>::const_iterator s = m_phyIndex.find(sender);
+        NS_ASSERT (s != m_phyIndex.end());
+        SendDmg(s->second, senderAntCtrl, hdrTmp.GetAddr1(), packet, txPowerDbm,
+                txVector, preamble, packetType, duration);
+        return;
+    }
 
     for (PhyList::const_iterator i = m_phyList.begin(); i != m_phyList.end(); i++, j++)
     {
@@ -147,10 +185,6 @@ YansWifiChannel::Send(Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double
 		rxPowerDbm = m_loss->CalcRxPower(txPowerDbm, senderMobility, receiverMobility) +
 						 senderAntCtrl->GetTxGainDbi(azimuth, elevation) +                // Sender's antenna gain.
 						 receiverAntCtrl->GetRxGainDbi(azimuth + M_PI, -elevation); // Receiver's antenna gain.
-
-		/* DAN: Don't copy packets if below noise floor */
-		//if (rxPowerDbm < -77)
-		//    continue;
 	    }
 	    else
 	    {
@@ -160,28 +194,298 @@ YansWifiChannel::Send(Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double
             NS_LOG_DEBUG("propagation: txPower=" << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
                          "distance=" << senderMobility->GetDistanceFrom(receiverMobility) << "m, delay=" << delay);
 
-            Ptr<Packet> copy = packet->Copy();
-            Ptr<Object> dstNetDevice = m_phyList[j]->GetDevice();
-            uint32_t dstNode;
-            if (dstNetDevice == 0)
-            {
-                dstNode = 0xffffffff;
-            }
-            else
-            {
-                dstNode = dstNetDevice->GetObject<NetDevice>()->GetNode()->GetId();
-            }
+            ScheduleReceive(j, packet, rxPowerDbm, packetType, duration, delay, txVector, preamble);
+        }
+    }
+}
+
+void
+YansWifiChannel::SendDmg (uint32_t senderIndex, Ptr<DmgAntennaController> senderAntCtrl,
+                          Mac48Address addr1, Ptr<const Packet> packet, double txPowerDbm,
+                          WifiTxVector txVector, WifiPreamble preamble, uint8_t packetType,
+                          Time duration) const
+{
+    if (senderIndex >= m_linkBudgetsValid.size() || !m_linkBudgetsValid[senderIndex])
+    {
+        BuildLinkBudgets(senderIndex);
+    }
+    Ptr<YansWifiPhy> sender = m_phyList[senderIndex];
+    Ptr<MobilityModel> senderMobility = sender->GetMobility()->GetObject<MobilityModel> ();
+    const LinkBudgets &links = m_linkBudgets[senderIndex];
+
+    // Links are sorted by decreasing best-case gain: the candidates are the
+    // prefix of the list above the floor, plus the mobile links, whose gain
+    // is stale, and the addressed receiver, whose antennas must be pointed
+    // even if it cannot hear the frame.
+    uint32_t addressed = m_phyList.size();
+    std::map<Mac48Address, uint32_t>::const_iterator a = m_addressIndex.find(addr1);
+    if (a != m_addressIndex.end())
+    {
+        addressed = a->second;
+    }
+    double minGainDb = m_dmgRxPowerFloorDbm - txPowerDbm;
+    std::vector<std::pair<uint32_t, const LinkBudget *> > candidates;
+    uint32_t prefix = 0;
+    for (; prefix < links.size() && links[prefix].bestGainDb >= minGainDb; prefix++)
+    {
+        candidates.push_back(std::make_pair(links[prefix].receiver, &links[prefix]));
+    }
+    const std::vector<uint32_t> &mobileLinks = m_mobileLinks[senderIndex];
+    for (uint32_t m = 0; m < mobileLinks.size(); m++)
+    {
+        if (mobileLinks[m] >= prefix)
+        {
+            candidates.push_back(std::make_pair(links[mobileLinks[m]].receiver, &links[mobileLinks[m]]));
+        }
+    }
+    if (addressed < m_phyList.size() && addressed != senderIndex)
+    {
+        uint32_t position = m_linkPositions[senderIndex][addressed];
+        if (position >= prefix && !links[position].mobile)
+        {
+            candidates.push_back(std::make_pair(addressed, &links[position]));
+        }
+    }
+    // Deliver in PHY list order, as the non-DMG path does: antenna pointing
+    // and same-time events depend on it.
+    std::sort(candidates.begin(), candidates.end());
+
+    // Refresh the moving links and gather the directions of the receivers
+    // on the sender channel, so that the sender gains take one call per
+    // pointing of its antenna: the addressed receiver re-points it, and
+    // the receivers before it still see the previous pointing.
+    std::vector<LinkBudget> budgets;
+    budgets.reserve(candidates.size());
+    uint32_t split = candidates.size();
+    for (uint32_t c = 0; c < candidates.size(); c++)
+    {
+        uint32_t j = candidates[c].first;
+        Ptr<YansWifiPhy> receiver = m_phyList[j];
+        if (receiver->GetChannelNumber() != sender->GetChannelNumber())
+        {
+            continue;
+        }
+        budgets.push_back(*candidates[c].second);
+        if (budgets.back().mobile)
+        {
+            ComputeLinkBudget(senderMobility, receiver->GetMobility()->GetObject<MobilityModel>(), budgets.back());
+        }
+        if (j == addressed)
+        {
+            split = budgets.size() - 1;
+        }
+    }
+    uint32_t n = budgets.size();
+    split = std::min(split, n);
+    std::vector<double> azimuths(n), elevations(n), txGains(n);
+    for (uint32_t c = 0; c < n; c++)
+    {
+        azimuths[c] = budgets[c].azimuth;
+        elevations[c] = budgets[c].elevation;
+    }
+    if (split > 0)
+    {
+        senderAntCtrl->GetTxGainsDbi(&azimuths[0], &elevations[0], &txGains[0], split);
+    }
+
+    for (uint32_t c = 0; c < n; c++)
+    {
+        const LinkBudget &link = budgets[c];
+        uint32_t j = link.receiver;
+        Ptr<YansWifiPhy> receiver = m_phyList[j];
+        Ptr<DmgAntennaController> receiverAntCtrl = receiver->GetDmgAntennaController();
+
+        if (c == split)
+        {
+            senderAntCtrl->PointAntenna(receiver);
+            receiverAntCtrl->PointAntenna(sender);
+            senderAntCtrl->GetTxGainsDbi(&azimuths[c], &elevations[c], &txGains[c], n - c);
+        }
+
+        double rxPowerDbm = txPowerDbm + link.pathGainDb +
+            txGains[c] +
+            receiverAntCtrl->GetRxGainDbi(link.azimuth + M_PI, -link.elevation);
+
+        NS_LOG_DEBUG("propagation: txPower=" << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
+                     "distance=" << senderMobility->GetDistanceFrom(receiver->GetMobility()->GetObject<MobilityModel>()) << "m, delay=" << link.delay);
+
+        ScheduleReceive(j, packet, rxPowerDbm, packetType, duration, link.delay, txVector, preamble);
+    }
+}
 
-            double *atts = new double[3];
-            *atts = rxPowerDbm;
-            *(atts + 1) = packetType;
-            *(atts + 2) = duration.GetNanoSeconds();
+bool
+YansWifiChannel::SendPpdu (Ptr<YansWifiPhy> sender, Ptr<const YansWifiPpdu> ppdu, double txPowerDbm) const
+{
+    Ptr<DmgAntennaController> senderAntCtrl = sender->GetDmgAntennaController();
+    if (!m_dmgMode || !senderAntCtrl)
+    {
+        return false;
+    }
+    std::map<Ptr<YansWifiPhy>, uint32_t>::const_iterator s = m_phyIndex.find(sender);
+    NS_ASSERT (s != m_phyIndex.end());
+    uint32_t senderIndex = s->second;
+    if (senderIndex >= m_linkBudgetsValid.size() || !m_linkBudgetsValid[senderIndex])
+    {
+        BuildLinkBudgets(senderIndex);
+    }
+
+    WifiMacHeader hdr;
+    AmpduContainer::PeekMacHeader(ppdu->mpdus[0], hdr);
+    std::map<Mac48Address, uint32_t>::const_iterator a = m_addressIndex.find(hdr.GetAddr1());
+    if (a == m_addressIndex.end())
+    {
+        return false;
+    }
+    uint32_t j = a->second;
+    Ptr<YansWifiPhy> receiver = m_phyList[j];
+    if (j == senderIndex || receiver->GetChannelNumber() != sender->GetChannelNumber())
+    {
+        return false;
+    }
+
+    const LinkBudgets &links = m_linkBudgets[senderIndex];
+    NS_ASSERT (j < m_linkPositions[senderIndex].size());
+    uint32_t position = m_linkPositions[senderIndex][j];
+    NS_ASSERT (position < links.size() && links[position].receiver == j);
+    LinkBudget link = links[position];
+    if (link.mobile)
+    {
+        ComputeLinkBudget(sender->GetMobility()->GetObject<MobilityModel>(),
+                          receiver->GetMobility()->GetObject<MobilityModel>(), link);
+    }
+
+    Ptr<DmgAntennaController> receiverAntCtrl = receiver->GetDmgAntennaController();
+    senderAntCtrl->PointAntenna(receiver);
+    receiverAntCtrl->PointAntenna(sender);
+    double rxPowerDbm = txPowerDbm + link.pathGainDb +
+        senderAntCtrl->GetTxGainDbi(link.azimuth, link.elevation) +
+        receiverAntCtrl->GetRxGainDbi(link.azimuth + M_PI, -link.elevation);
+
+    NS_LOG_DEBUG("PPDU propagation: txPower=" << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, delay=" << link.delay);
+
+    Simulator::ScheduleWithContext(GetReceiverContext(j),
+                                   link.delay, &YansWifiChannel::ReceivePpdu, this,
+                                   j, ppdu, rxPowerDbm);
+    return true;
+}
+
+void
+YansWifiChannel::ReceivePpdu (uint32_t i, Ptr<const YansWifiPpdu> ppdu, double rxPowerDbm) const
+{
+    m_phyList[i]->StartReceivePpdu(ppdu, rxPowerDbm);
+}
+
+void
+YansWifiChannel::ComputeLinkBudget (Ptr<MobilityModel> senderMobility,
+                                    Ptr<MobilityModel> receiverMobility,
+                                    LinkBudget &link) const
+{
+    Vector senderPos = senderMobility->GetPosition();
+    Vector receiverPos = receiverMobility->GetPosition();
+    link.pathGainDb = m_loss->CalcRxPower(0, senderMobility, receiverMobility);
+    link.azimuth = CalculateAzimuthAngle(senderPos, receiverPos);
+    link.elevation = CalculateElevationAngle(senderPos, receiverPos);
+    link.delay = m_delay->GetDelay(senderMobility, receiverMobility);
+}
+
+void
+YansWifiChannel::BuildLinkBudgets (uint32_t sender) const
+{
+    NS_LOG_FUNCTION (this << sender);
+    if (m_linkBudgets.size() != m_phyList.size())
+    {
+        m_linkBudgets.resize(m_phyList.size());
+        m_linkBudgetsValid.resize(m_phyList.size(), false);
+        m_mobileLinks.resize(m_phyList.size());
+        m_linkPositions.resize(m_phyList.size());
+    }
+    for (; m_nCourseChangeConnected < m_phyList.size(); m_nCourseChangeConnected++)
+    {
+        Ptr<YansWifiPhy> phy = m_phyList[m_nCourseChangeConnected];
+        phy->GetMobility()->GetObject<MobilityModel>()->TraceConnectWithoutContext("CourseChange",
+            MakeCallback(&YansWifiChannel::CourseChanged, const_cast<YansWifiChannel *> (this)));
+        m_addressIndex[phy->GetAddress()] = m_nCourseChangeConnected;
+    }
 
-            Simulator::ScheduleWithContext(dstNode,
-                                           delay, &YansWifiChannel::Receive, this,
-                                           j, copy, atts, txVector, preamble);
+    Ptr<YansWifiPhy> senderPhy = m_phyList[sender];
+    Ptr<MobilityModel> senderMobility = senderPhy->GetMobility()->GetObject<MobilityModel>();
+    bool senderMobile = IsMoving(senderMobility);
+    double maxTxGainDbi = senderPhy->GetDmgAntennaController()->GetMaxGainDbi();
+
+    LinkBudgets &links = m_linkBudgets[sender];
+    links.clear();
+    for (uint32_t j = 0; j < m_phyList.size(); j++)
+    {
+        if (j == sender)
+        {
+            continue;
         }
+        Ptr<YansWifiPhy> receiver = m_phyList[j];
+        Ptr<MobilityModel> receiverMobility = receiver->GetMobility()->GetObject<MobilityModel>();
+        LinkBudget link;
+        link.receiver = j;
+        link.mobile = senderMobile || IsMoving(receiverMobility);
+        ComputeLinkBudget(senderMobility, receiverMobility, link);
+        link.bestGainDb = link.pathGainDb + maxTxGainDbi +
+            receiver->GetDmgAntennaController()->GetMaxGainDbi() + receiver->GetRxGain();
+        links.push_back(link);
+    }
+    std::stable_sort(links.begin(), links.end(), LinkBudgetBestFirst());
+    std::vector<uint32_t> &mobileLinks = m_mobileLinks[sender];
+    std::vector<uint32_t> &positions = m_linkPositions[sender];
+    mobileLinks.clear();
+    positions.assign(m_phyList.size(), 0);
+    for (uint32_t l = 0; l < links.size(); l++)
+    {
+        if (links[l].mobile)
+        {
+            mobileLinks.push_back(l);
+        }
+        positions[links[l].receiver] = l;
+    }
+    m_linkBudgetsValid[sender] = true;
+}
+
+void
+YansWifiChannel::CourseChanged (Ptr<const MobilityModel>)
+{
+    FlushLinkBudgetCache();
+}
+
+void
+YansWifiChannel::FlushLinkBudgetCache (void)
+{
+    NS_LOG_FUNCTION (this);
+    m_linkBudgetsValid.assign(m_linkBudgetsValid.size(), false);
+}
+
+void
+YansWifiChannel::ScheduleReceive (uint32_t i, Ptr<const Packet> packet, double rxPowerDbm,
+                                  uint8_t packetType, Time duration, Time delay,
+                                  WifiTxVector txVector, WifiPreamble preamble) const
+{
+    Ptr<Packet> copy = packet->Copy();
+    uint32_t dstNode = GetReceiverContext(i);
+
+    double *atts = new double[3];
+    *atts = rxPowerDbm;
+    *(atts + 1) = packetType;
+    *(atts + 2) = duration.GetNanoSeconds();
+
+    Simulator::ScheduleWithContext(dstNode,
+                                   delay, &YansWifiChannel::Receive, this,
+                                   i, copy, atts, txVector, preamble);
+}
+
+uint32_t
+YansWifiChannel::GetReceiverContext (uint32_t i) const
+{
+    Ptr<Object> dstNetDevice = m_phyList[i]->GetDevice();
+    if (dstNetDevice == 0)
+    {
+        return 0xffffffff;
     }
+    return dstNetDevice->GetObject<NetDevice>()->GetNode()->GetId();
 }
 
 void YansWifiChannel::Receive(uint32_t i, Ptr<Packet> packet, double *atts,
@@ -203,7 +507,9 @@ Ptr<NetDevice> YansWifiChannel::GetDevice (uint32_t i) const
 
 void YansWifiChannel::Add (Ptr<YansWifiPhy> phy)
 {
+    m_phyIndex[phy] = m_phyList.size();
     m_phyList.push_back(phy);
+    FlushLinkBudgetCache();
 }
 
 int64_t YansWifiChannel::AssignStreams (int64_t stream)
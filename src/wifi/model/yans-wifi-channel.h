@@ -21,6 +21,7 @@
 #define YANS_WIFI_CHANNEL_H
 
 #include <vector>
+#include <map>
 #include <stdint.h>
 #include "ns3/packet.h"
 #include "wifi-channel.h"
@@ -28,13 +29,17 @@
 #include "wifi-preamble.h"
 #include "wifi-tx-vector.h"
 #include "ns3/nstime.h"
+#include "ns3/mac48-address.h"
 
 namespace ns3 {
 
 class NetDevice;
 class PropagationLossModel;
 class PropagationDelayModel;
+class MobilityModel;
 class YansWifiPhy;
+struct YansWifiPpdu;
+class DmgAntennaController;
 
 /**
  * \brief A Yans wifi channel
@@ -47,6 +52,14 @@ class YansWifiPhy;
  * class and contains a ns3::PropagationLossModel and a ns3::PropagationDelayModel.
  * By default, no propagation models are set so, it is the caller's responsability
  * to set them before using the channel.
+ *
+ * When the DmgMode attribute is set, transmissions from PHYs with a
+ * DmgAntennaController use precomputed link budgets: the path loss, delay
+ * and angles between every pair of nodes are computed once and then reused
+ * until a node moves (CourseChange) or FlushLinkBudgetCache is called.
+ * Receivers whose best-case received power (max TX antenna gain + max RX
+ * antenna gain) is below DmgRxPowerFloor are not scheduled at all. This
+ * mode assumes deterministic propagation loss and delay models.
  */
 class YansWifiChannel : public WifiChannel
 {
@@ -93,6 +106,18 @@ public:
    */
   void Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double txPowerDbm,
              WifiTxVector txVector, WifiPreamble preamble, uint8_t packetType, Time duration) const;
+  /**
+   * \param sender the device from which the PPDU is originating.
+   * \param ppdu the PPDU to send
+   * \param txPowerDbm the tx power associated to the PPDU
+   * \return true if the PPDU was sent, false if it cannot be sent as a whole
+   *
+   * Deliver the PPDU to the receiver addressed by its first subframe only,
+   * with one reception event. Only available in DMG mode, for a sender
+   * with a DmgAntennaController and a receiver on the same channel.
+   * Invoked only from YansWifiPhy::SendPpdu.
+   */
+  bool SendPpdu (Ptr<YansWifiPhy> sender, Ptr<const YansWifiPpdu> ppdu, double txPowerDbm) const;
 
  /**
   * Assign a fixed random variable stream number to the random variables
@@ -104,6 +129,14 @@ public:
   */
   int64_t AssignStreams (int64_t stream);
 
+  /**
+   * Drop the link budgets cached in DMG mode. Must be called whenever the
+   * propagation loss model state (e.g. LoS between a pair of nodes) or the
+   * antenna gains change after the first transmission. Node movements are
+   * tracked automatically.
+   */
+  void FlushLinkBudgetCache (void);
+
 private:
   //YansWifiChannel& operator = (const YansWifiChannel &);
   //YansWifiChannel (const YansWifiChannel &);
@@ -125,11 +158,78 @@ private:
    */
   void Receive (uint32_t i, Ptr<Packet> packet, double *atts,
                 WifiTxVector txVector, WifiPreamble preamble) const;
+  /**
+   * Scheduled by SendPpdu for the addressed receiver.
+   *
+   * \param i index of the receiver in the PHY list
+   * \param ppdu the PPDU being sent
+   * \param rxPowerDbm the received power in dBm
+   */
+  void ReceivePpdu (uint32_t i, Ptr<const YansWifiPpdu> ppdu, double rxPowerDbm) const;
+  /**
+   * Return the context of the events of the PHY at index i: the ID of the
+   * node of its device.
+   */
+  uint32_t GetReceiverContext (uint32_t i) const;
+  /**
+   * Schedule the reception of a copy of the packet on the PHY at index i.
+   */
+  void ScheduleReceive (uint32_t i, Ptr<const Packet> packet, double rxPowerDbm,
+                        uint8_t packetType, Time duration, Time delay,
+                        WifiTxVector txVector, WifiPreamble preamble) const;
+  /**
+   * Send using the cached link budgets of the given sender (DMG mode).
+   */
+  void SendDmg (uint32_t senderIndex, Ptr<DmgAntennaController> senderAntCtrl,
+                Mac48Address addr1, Ptr<const Packet> packet, double txPowerDbm,
+                WifiTxVector txVector, WifiPreamble preamble, uint8_t packetType,
+                Time duration) const;
+
+  /**
+   * Static part of the link between a sender and a receiver.
+   */
+  struct LinkBudget
+  {
+    uint32_t receiver;  //!< index of the receiver in the PHY list
+    bool mobile;        //!< either end moves: recompute the fields below at each Send
+    double pathGainDb;  //!< propagation loss model output for a 0 dBm transmission
+    double azimuth;     //!< azimuth from the sender to the receiver
+    double elevation;   //!< elevation from the sender to the receiver
+    Time delay;         //!< propagation delay
+    double bestGainDb;  //!< pathGainDb plus the best TX, RX antenna and receiver gains
+  };
+  typedef std::vector<LinkBudget> LinkBudgets;
+
+  /**
+   * Compute the link budgets from the PHY at index sender to all others,
+   * sorted by decreasing bestGainDb.
+   */
+  void BuildLinkBudgets (uint32_t sender) const;
+  /**
+   * Fill the geometry and path loss fields of a link budget.
+   */
+  void ComputeLinkBudget (Ptr<MobilityModel> senderMobility,
+                          Ptr<MobilityModel> receiverMobility,
+                          LinkBudget &link) const;
+  /**
+   * Invalidate the cached link budgets when a node moves.
+   */
+  void CourseChanged (Ptr<const MobilityModel> mobility);
 
 
   PhyList m_phyList; //!< List of YansWifiPhys connected to this YansWifiChannel
   Ptr<PropagationLossModel> m_loss; //!< Propagation loss model
   Ptr<PropagationDelayModel> m_delay; //!< Propagation delay model
+
+  bool m_dmgMode;                //!< use cached link budgets and culling for DMG PHYs
+  double m_dmgRxPowerFloorDbm;   //!< receivers below this best-case power are not scheduled
+  std::map<Ptr<YansWifiPhy>, uint32_t> m_phyIndex; //!< index of each PHY in m_phyList
+  mutable std::vector<LinkBudgets> m_linkBudgets;  //!< cached link budgets, per sender
+  mutable std::vector<bool> m_linkBudgetsValid;    //!< validity of m_linkBudgets, per sender
+  mutable std::vector<std::vector<uint32_t> > m_mobileLinks;   //!< positions of the mobile links in m_linkBudgets, per sender
+  mutable std::vector<std::vector<uint32_t> > m_linkPositions; //!< position of each receiver in m_linkBudgets, per sender
+  mutable std::map<Mac48Address, uint32_t> m_addressIndex; //!< PHY index of each address
+  mutable uint32_t m_nCourseChangeConnected; //!< number of PHYs whose mobility reports to CourseChanged
 };
 
 } // namespace ns3
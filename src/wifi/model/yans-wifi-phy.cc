@@ -755,6 +755,191 @@ void YansWifiPhy::SendPacket(Ptr<const Packet> packet, WifiTxVector txVector, Wi
 
 }
 
+bool
+YansWifiPhy::SendPpdu (const std::vector<Ptr<const Packet> > &mpdus, WifiTxVector txVector, WifiPreamble preamble)
+{
+    NS_LOG_FUNCTION (this << mpdus.size() << txVector.GetMode() << preamble << (uint32_t)txVector.GetTxPowerLevel());
+    NS_ASSERT(!mpdus.empty());
+    NS_ASSERT(!m_state->IsStateTx () && !m_state->IsStateSwitching ());
+
+    if (m_state->IsStateSleep ())
+    {
+        return false;
+    }
+
+    // The subframe durations SendPacket would compute, with the gap MacLow
+    // leaves between the subframes
+    Ptr<YansWifiPpdu> ppdu = Create<YansWifiPpdu> ();
+    ppdu->mpdus = mpdus;
+    ppdu->txVector = txVector;
+    ppdu->preamble = preamble;
+    ppdu->duration = Seconds(0);
+    WifiPreamble subframePreamble = preamble;
+    for (uint32_t i = 0; i < mpdus.size(); i++)
+    {
+        bool last = (i + 1 == mpdus.size());
+        Time duration = CalculateTxDuration(mpdus[i]->GetSize(), txVector, subframePreamble, GetFrequency(), last ? 2 : 1, 1);
+        ppdu->durations.push_back(duration);
+        ppdu->duration += duration;
+        if (!last)
+        {
+            ppdu->duration += NanoSeconds(1);
+        }
+        subframePreamble = WIFI_PREAMBLE_NONE;
+    }
+    NS_LOG_DEBUG("PPDU of " << mpdus.size() << " subframes, duration = " << ppdu->duration << ". Time now: " << Simulator::Now());
+
+    double txPowerDbm = GetPowerDbm(txVector.GetTxPowerLevel());
+    if (!m_channel->SendPpdu(this, ppdu, txPowerDbm + m_txGainDb))
+    {
+        return false;
+    }
+
+    if (m_state->IsStateRx())
+    {
+        m_endRxEvent.Cancel();
+        m_interference.NotifyRxEnd();
+    }
+    m_state->SwitchToTx(ppdu->duration, mpdus[0], txPowerDbm, txVector, preamble);
+    // The traces of each subframe fire when SendPacket would send it
+    Time start = Seconds(0);
+    subframePreamble = preamble;
+    for (uint32_t i = 0; i < mpdus.size(); i++)
+    {
+        if (i == 0)
+        {
+            NotifyPpduSubframeTx(mpdus[i], txVector, subframePreamble);
+        }
+        else
+        {
+            Simulator::Schedule(start, &YansWifiPhy::NotifyPpduSubframeTx, this,
+                                mpdus[i], txVector, subframePreamble);
+        }
+        start += ppdu->durations[i] + NanoSeconds(1);
+        subframePreamble = WIFI_PREAMBLE_NONE;
+    }
+    return true;
+}
+
+void
+YansWifiPhy::NotifyPpduSubframeTx (Ptr<const Packet> mpdu, WifiTxVector txVector, WifiPreamble preamble)
+{
+    uint32_t dataRate500KbpsUnits;
+    if (txVector.GetMode().GetModulationClass() == WIFI_MOD_CLASS_HT)
+    {
+        dataRate500KbpsUnits = 128 + WifiModeToMcs (txVector.GetMode());
+    }
+    else
+    {
+        dataRate500KbpsUnits = txVector.GetMode().GetDataRate () * txVector.GetNss() / 500000;
+    }
+    bool isShortPreamble = (WIFI_PREAMBLE_SHORT == preamble);
+    NotifyTxBegin(mpdu);
+    NotifyMonitorSniffTx(mpdu, (uint16_t)GetChannelFrequencyMhz(), GetChannelNumber(), dataRate500KbpsUnits, isShortPreamble, txVector.GetTxPowerLevel());
+    NotifyTxEnd(mpdu);
+}
+
+void
+YansWifiPhy::StartReceivePpdu (Ptr<const YansWifiPpdu> ppdu, double rxPowerDbm)
+{
+    NS_LOG_FUNCTION (this << ppdu->mpdus.size() << rxPowerDbm << ppdu->txVector.GetMode());
+    rxPowerDbm += m_rxGainDb;
+    double rxPowerW = DbmToW(rxPowerDbm);
+    WifiMode txMode = ppdu->txVector.GetMode();
+
+    if ((m_state->IsStateIdle() || m_state->IsStateCcaBusy())
+        && rxPowerW > m_edThresholdW
+        && (IsModeSupported(txMode) || IsMcsSupported(txMode)))
+    {
+        NS_LOG_DEBUG ("sync to PPDU (power=" << rxPowerW << "W). Time now: "<<Simulator::Now());
+        m_state->SwitchToRx (ppdu->duration);
+        NS_ASSERT(m_endRxEvent.IsExpired());
+        StartReceivePpduSubframe(ppdu, rxPowerW, 0);
+        return;
+    }
+
+    NS_LOG_DEBUG("drop PPDU (state=" << m_state->GetState() << ", power=" << rxPowerW << "W, mode=" << txMode << ")");
+    for (uint32_t i = 0; i < ppdu->mpdus.size(); i++)
+    {
+        NotifyRxDrop(ppdu->mpdus[i]);
+    }
+}
+
+void
+YansWifiPhy::StartReceivePpduSubframe (Ptr<const YansWifiPpdu> ppdu, double rxPowerW, uint32_t index)
+{
+    NotifyRxBegin(ppdu->mpdus[index]);
+    m_endRxEvent = Simulator::Schedule(ppdu->durations[index], &YansWifiPhy::EndReceivePpdu, this,
+                                       ppdu, rxPowerW, index);
+}
+
+void
+YansWifiPhy::EndReceivePpdu (Ptr<const YansWifiPpdu> ppdu, double rxPowerW, uint32_t index)
+{
+    NS_LOG_FUNCTION (this << index << rxPowerW);
+    NS_ASSERT (IsStateRx ());
+
+    WifiMode mode = ppdu->txVector.GetMode();
+    uint32_t dataRate500KbpsUnits;
+    if (mode.GetModulationClass() == WIFI_MOD_CLASS_HT)
+    {
+        dataRate500KbpsUnits = 128 + WifiModeToMcs(mode);
+    }
+    else
+    {
+        dataRate500KbpsUnits = mode.GetDataRate() * ppdu->txVector.GetNss() / 500000;
+    }
+    bool isShortPreamble = (WIFI_PREAMBLE_SHORT == ppdu->preamble);
+    double signalDbm = RatioToDb (rxPowerW) + 30;
+
+    // The subframe is received as EndReceive would, with no interference:
+    // the PPDU was sent in an isolated SP
+    WifiPreamble preamble = (index == 0) ? ppdu->preamble : WIFI_PREAMBLE_NONE;
+    bool last = (index + 1 == ppdu->mpdus.size());
+    Ptr<Packet> packet = ppdu->mpdus[index]->Copy();
+    struct InterferenceHelper::SnrPer snrPer;
+    snrPer = m_interference.CalculateSnrPer(packet->GetSize(), rxPowerW, ppdu->durations[index], ppdu->txVector, preamble);
+
+    double minPer = 1 - std::pow(1 - m_frameMinBer, packet->GetSize() * 8);
+    if (snrPer.per < minPer) {
+        snrPer.per = minPer;
+    }
+    NS_LOG_DEBUG("subframe " << index << ": snr=" << snrPer.snr << ", per=" << snrPer.per << ", size=" << packet->GetSize());
+
+    if (!last)
+    {
+        // The next subframe starts after the gap MacLow leaves
+        m_endRxEvent = Simulator::Schedule(NanoSeconds(1), &YansWifiPhy::StartReceivePpduSubframe, this,
+                                           ppdu, rxPowerW, index + 1);
+    }
+    if (m_random->GetValue() > snrPer.per)
+    {
+        NotifyRxEnd(packet);
+        double noiseDbm = RatioToDb (rxPowerW / snrPer.snr) - GetRxNoiseFigure () + 30;
+        NotifyMonitorSniffRx(packet, (uint16_t)GetChannelFrequencyMhz (), GetChannelNumber (), dataRate500KbpsUnits, isShortPreamble, signalDbm, noiseDbm);
+        if (last)
+        {
+            m_state->SwitchFromRxEndOk(packet, snrPer.snr, mode, preamble);
+        }
+        else
+        {
+            m_state->ReceiveSubframeOk(packet, snrPer.snr, mode, preamble);
+        }
+    }
+    else
+    {
+        NotifyRxDrop(packet);
+        if (last)
+        {
+            m_state->SwitchFromRxEndError(packet, snrPer.snr);
+        }
+        else
+        {
+            m_state->ReceiveSubframeError(packet, snrPer.snr);
+        }
+    }
+}
+
 uint32_t YansWifiPhy::GetNModes(void) const
 {
     return m_deviceRateSet.size();
@@ -38,6 +38,8 @@
 #include "interference-helper.h"
 #include "dmg-antenna-controller.h"
 #include "ns3/mac48-address.h"
+#include "ns3/simple-ref-count.h"
+#include <vector>
 
 namespace ns3 {
 
@@ -46,6 +48,20 @@ namespace ns3 {
 class YansWifiChannel;
 class WifiPhyStateHelper;
 
+/**
+ * \ingroup wifi
+ *
+ * The subframes of an A-MPDU sent as one PPDU by YansWifiPhy::SendPpdu.
+ */
+struct YansWifiPpdu : public SimpleRefCount<YansWifiPpdu>
+{
+  std::vector<Ptr<const Packet> > mpdus; //!< the A-MPDU subframes, in order
+  std::vector<Time> durations;           //!< airtime of each subframe, as SendPacket computes it
+  WifiTxVector txVector;                 //!< TXVECTOR of the PPDU
+  WifiPreamble preamble;                 //!< preamble of the first subframe
+  Time duration;                         //!< airtime of the PPDU, gaps between subframes included
+};
+
 
 /**
  * \brief 802.11 PHY layer model
@@ -122,6 +138,14 @@ public:
                            WifiPreamble preamble,
                            uint8_t packetType,
                            Time rxDuration);
+  /**
+   * Starting receiving a PPDU sent with SendPpdu. Each subframe is
+   * delivered at its own end, as if it was sent with SendPacket.
+   *
+   * \param ppdu the arriving PPDU
+   * \param rxPowerDbm the receive power in dBm
+   */
+  void StartReceivePpdu (Ptr<const YansWifiPpdu> ppdu, double rxPowerDbm);
 
   /**
    * Sets the RX loss (dB) in the Signal-to-Noise-Ratio due to non-idealities in the receiver.
@@ -262,6 +286,11 @@ public:
   virtual void SetReceiveOkCallback (WifiPhy::RxOkCallback callback);
   virtual void SetReceiveErrorCallback (WifiPhy::RxErrorCallback callback);
   virtual void SendPacket (Ptr<const Packet> packet, WifiTxVector txvector, enum WifiPreamble preamble, uint8_t packetType);
+  /**
+   * Only in DMG mode of the channel, towards a receiver on the same channel:
+   * the PPDU is heard by the addressed receiver only.
+   */
+  virtual bool SendPpdu (const std::vector<Ptr<const Packet> > &mpdus, WifiTxVector txvector, enum WifiPreamble preamble);
   virtual void RegisterListener (WifiPhyListener *listener);
   virtual void UnregisterListener (WifiPhyListener *listener);
   virtual void SetSleepMode (void);
@@ -490,6 +519,32 @@ private:
    * \param event the corresponding event of the first time the packet arrives
    */
   void EndReceive (Ptr<Packet> packet, Ptr<InterferenceHelper::Event> event);
+  /**
+   * The first bit of a subframe of a PPDU sent with SendPpdu has arrived.
+   *
+   * \param ppdu the PPDU
+   * \param rxPowerW the receive power in W
+   * \param index the index of the subframe in the PPDU
+   */
+  void StartReceivePpduSubframe (Ptr<const YansWifiPpdu> ppdu, double rxPowerW, uint32_t index);
+  /**
+   * The last bit of a subframe of a PPDU sent with SendPpdu has arrived:
+   * deliver it.
+   *
+   * \param ppdu the PPDU
+   * \param rxPowerW the receive power in W
+   * \param index the index of the subframe in the PPDU
+   */
+  void EndReceivePpdu (Ptr<const YansWifiPpdu> ppdu, double rxPowerW, uint32_t index);
+  /**
+   * Fire the transmission traces of a subframe of a PPDU sent with
+   * SendPpdu, at the time SendPacket would send it.
+   *
+   * \param mpdu the subframe
+   * \param txVector the TXVECTOR of the PPDU
+   * \param preamble the preamble of the subframe
+   */
+  void NotifyPpduSubframeTx (Ptr<const Packet> mpdu, WifiTxVector txVector, WifiPreamble preamble);
 
 private:
   virtual void DoInitialize (void);
@@ -21,6 +21,9 @@
 #include "ns3/log.h"
 #include "ns3/qos-utils.h"
 #include "ns3/ctrl-headers.h"
+#include "ns3/block-ack-bitmap.h"
+#include "ns3/block-ack-cache.h"
+#include "ns3/wifi-mac-header.h"
 #include <list>
 
 using namespace ns3;
@@ -276,6 +279,89 @@ CtrlBAckResponseHeaderTest::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (m_blockAckHdr.IsPacketReceived (80), false, "error in compressed bitmap");
 }
 
+//Test for the bitmaps of sequence numbers
+class BlockAckBitmapTest : public TestCase
+{
+public:
+  BlockAckBitmapTest ();
+private:
+  virtual void DoRun ();
+};
+
+BlockAckBitmapTest::BlockAckBitmapTest ()
+  : TestCase ("Check the circular bitmap of sequence numbers and the block ack cache")
+{
+}
+
+void
+BlockAckBitmapTest::DoRun (void)
+{
+  BlockAckBitmap bitmap;
+  uint16_t seq;
+  NS_TEST_EXPECT_MSG_EQ (bitmap.FindFirst (0, 4096, seq), false, "error in empty bitmap");
+
+  //          4090       58
+  bitmap.Set (4090);
+  bitmap.Set (4095);
+  bitmap.Set (3);
+  bitmap.Set (58);
+  bitmap.Set (58);
+  NS_TEST_EXPECT_MSG_EQ (bitmap.GetCount (), 4, "error in bitmap count");
+  NS_TEST_EXPECT_MSG_EQ (bitmap.GetWord (4090), 0x0000000000000221LL, "error in bitmap word");
+  NS_TEST_EXPECT_MSG_EQ (bitmap.GetWord (4095), 0x0800000000000011LL, "error in bitmap word");
+  NS_TEST_EXPECT_MSG_EQ (bitmap.FindFirst (4091, 4096, seq), true, "error in bitmap search");
+  NS_TEST_EXPECT_MSG_EQ (seq, 4095, "error in bitmap search");
+  NS_TEST_EXPECT_MSG_EQ (bitmap.FindFirst (0, 4096, seq), true, "error in bitmap search");
+  NS_TEST_EXPECT_MSG_EQ (seq, 3, "error in bitmap search");
+  NS_TEST_EXPECT_MSG_EQ (bitmap.FindFirst (4, 54, seq), false, "error in bitmap search");
+  NS_TEST_EXPECT_MSG_EQ (bitmap.FindFirst (59, 4096, seq), true, "error in bitmap search");
+  NS_TEST_EXPECT_MSG_EQ (seq, 4090, "error in bitmap search");
+
+  bitmap.ResetRange (4095, 3);
+  NS_TEST_EXPECT_MSG_EQ (bitmap.GetCount (), 2, "error in bitmap count");
+  NS_TEST_EXPECT_MSG_EQ (bitmap.IsSet (4090) && bitmap.IsSet (58), true, "error in bitmap reset");
+  bitmap.Reset (4090);
+  bitmap.Reset (4090);
+  NS_TEST_EXPECT_MSG_EQ (bitmap.GetCount (), 1, "error in bitmap count");
+
+  // A window across the wrap fits in 64 slots, 4090 and 58 share one
+  BlockAckRing<uint16_t> ring;
+  for (uint16_t i = 4090; i != 10; i = (i + 1) % 4096)
+    {
+      ring.Insert (i, i);
+    }
+  ring.Insert (4095, 1);
+  NS_TEST_EXPECT_MSG_EQ (ring.GetSize (), 64, "error in ring size");
+  NS_TEST_EXPECT_MSG_EQ (ring.Get (4095), 1, "error in ring value");
+  ring.Remove (4090);
+  ring.Insert (58, 58);
+  NS_TEST_EXPECT_MSG_EQ (ring.GetSize (), 64, "error in ring size");
+  ring.Insert (4090, 4090);
+  NS_TEST_EXPECT_MSG_EQ (ring.GetSize (), 128, "error in ring size");
+  NS_TEST_EXPECT_MSG_EQ ((ring.Get (4090) == 4090 && ring.Get (58) == 58 && ring.Get (3) == 3),
+                         true, "error in ring values");
+
+  // A compressed block ack from the cache: the fragments are not acknowledged
+  BlockAckCache cache;
+  cache.Init (4090, 64);
+  WifiMacHeader hdr;
+  hdr.SetType (WIFI_MAC_QOSDATA);
+  hdr.SetFragmentNumber (0);
+  for (uint16_t i = 4090; i != 10; i = (i + 1) % 4096)
+    {
+      hdr.SetSequenceNumber (i);
+      cache.UpdateWithMpdu (&hdr);
+    }
+  hdr.SetSequenceNumber (4094);
+  hdr.SetFragmentNumber (1);
+  cache.UpdateWithMpdu (&hdr);
+  CtrlBAckResponseHeader blockAck;
+  blockAck.SetType (COMPRESSED_BLOCK_ACK);
+  blockAck.SetStartingSequence (4090);
+  cache.FillBlockAckBitmap (&blockAck);
+  NS_TEST_EXPECT_MSG_EQ (blockAck.GetCompressedBitmap (), 0x000000000000ffefLL, "error in block ack cache bitmap");
+}
+
 class BlockAckTestSuite : public TestSuite
 {
 public:
@@ -288,6 +374,7 @@ BlockAckTestSuite::BlockAckTestSuite ()
   AddTestCase (new PacketBufferingCaseA, TestCase::QUICK);
   AddTestCase (new PacketBufferingCaseB, TestCase::QUICK);
   AddTestCase (new CtrlBAckResponseHeaderTest, TestCase::QUICK);
+  AddTestCase (new BlockAckBitmapTest, TestCase::QUICK);
 }
 
 static BlockAckTestSuite g_blockAckTestSuite;
@@ -39,8 +39,45 @@
 #include "ns3/pointer.h"
 #include "ns3/rng-seed-manager.h"
 #include "ns3/edca-txop-n.h"
+#include "ns3/mac-low.h"
 #include "ns3/config.h"
 #include "ns3/boolean.h"
+#include "ns3/wifi-mac-queue.h"
+#include "ns3/llc-snap-header.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/double.h"
+#include "ns3/dmg-optimization-solver.h"
+#include "ns3/dmg-beacon-interval.h"
+#include "ns3/dmg-airtime-allocator.h"
+#include "ns3/dmg-layer-scheduler.h"
+#include "ns3/dmg-route-planner.h"
+#include "ns3/dmg-channel-planner.h"
+#include "ns3/dmg-sp-recorder.h"
+#include "ns3/dmg-airtime-model.h"
+#include "ns3/dmg-mcs-table.h"
+#include "ns3/sensitivity-model-60-ghz.h"
+#include "ns3/dmg-destination-fixed-wifi-manager.h"
+#include "ns3/dmg-snr-wifi-manager.h"
+#include "ns3/mpdu-standard-aggregator.h"
+#include "ns3/wifi-mac-trailer.h"
+#include "ns3/cone-antenna.h"
+#include "ns3/measured-2d-antenna.h"
+#include "ns3/beamforming-engine.h"
+#include "ns3/uinteger.h"
+#include "ns3/dmg-antenna-controller.h"
+#include "ns3/ampdu-tag.h"
+#include "ns3/ampdu-subframe-header.h"
+#include "ns3/nist-error-rate-model.h"
+#include "ns3/tabulated-error-rate-model.h"
+#include "ns3/dmg-error-rate-model.h"
+#include "ns3/dmg-almighty-controller.h"
+#include "ns3/dmg-wifi-mac.h"
+#include "ns3/yans-wifi-helper.h"
+#include "ns3/dmg-wifi-mac-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4.h"
+#include <cmath>
 
 using namespace ns3;
 
@@ -477,6 +514,2127 @@ Bug555TestCase::DoRun (void)
 }
 
 //-----------------------------------------------------------------------------
+/**
+ * Check that the per-flow indexes of WifiMacQueue return the same packets, in
+ * the same FIFO order, as a linear scan of the queue would.
+ */
+class WifiMacQueueFlowIndexTest : public TestCase
+{
+public:
+  WifiMacQueueFlowIndexTest () : TestCase ("WifiMacQueue per-flow indexes")
+  {
+  }
+  virtual void DoRun (void);
+private:
+  void Enqueue (Ptr<WifiMacQueue> queue, Mac48Address addr1, uint8_t tid,
+                std::pair<Ipv4Address, Ipv4Address> flow, uint32_t size, bool front);
+};
+
+void
+WifiMacQueueFlowIndexTest::Enqueue (Ptr<WifiMacQueue> queue, Mac48Address addr1, uint8_t tid,
+                                    std::pair<Ipv4Address, Ipv4Address> flow, uint32_t size, bool front)
+{
+  Ptr<Packet> packet = Create<Packet> (size);
+  Ipv4Header ipv4;
+  ipv4.SetSource (flow.first);
+  ipv4.SetDestination (flow.second);
+  ipv4.SetPayloadSize (size);
+  packet->AddHeader (ipv4);
+  LlcSnapHeader llc;
+  llc.SetType (0x0800);
+  packet->AddHeader (llc);
+
+  WifiMacHeader hdr;
+  hdr.SetType (WIFI_MAC_QOSDATA);
+  hdr.SetAddr1 (addr1);
+  hdr.SetQosTid (tid);
+  if (front)
+    {
+      queue->PushFront (packet, hdr);
+    }
+  else
+    {
+      queue->Enqueue (packet, hdr);
+    }
+}
+
+void
+WifiMacQueueFlowIndexTest::DoRun (void)
+{
+  Ptr<WifiMacQueue> queue = CreateObject<WifiMacQueue> ();
+  queue->SetMaxSize (100);
+  Mac48Address hopA ("00:00:00:00:00:01");
+  Mac48Address hopB ("00:00:00:00:00:02");
+  std::pair<Ipv4Address, Ipv4Address> flow1 (Ipv4Address ("10.0.0.1"), Ipv4Address ("10.0.0.9"));
+  std::pair<Ipv4Address, Ipv4Address> flow2 (Ipv4Address ("10.0.0.2"), Ipv4Address ("10.0.0.9"));
+
+  Enqueue (queue, hopA, 0, flow1, 100, false);
+  Enqueue (queue, hopB, 0, flow1, 200, false);
+  Enqueue (queue, hopA, 0, flow2, 300, false);
+  Enqueue (queue, hopA, 0, flow1, 400, false);
+  Enqueue (queue, hopA, 5, flow1, 500, false);
+  Enqueue (queue, hopA, 0, flow1, 600, true);
+
+  NS_TEST_EXPECT_MSG_EQ (queue->GetSize (), 6, "wrong queue size");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPacketsByAddress (WifiMacHeader::ADDR1, hopA, flow1), 4, "wrong flow count");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPacketsByAddress (WifiMacHeader::ADDR1, hopA, flow2), 1, "wrong flow count");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPacketsByAddress (WifiMacHeader::ADDR1, hopB, flow2), 0, "wrong flow count");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPacketsByTidAndAddress (0, WifiMacHeader::ADDR1, hopA), 4, "wrong tid count");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPacketsByTidAndAddress (5, WifiMacHeader::ADDR1, hopA), 1, "wrong tid count");
+
+  WifiMacHeader hdr;
+  Time tstamp;
+  // only the heads of the other flows: the packet of 100 bytes must not
+  // overtake the head of flow1. flow0 comes first in the index, but its
+  // head is queued later than the one of flow2
+  std::pair<Ipv4Address, Ipv4Address> flow0 (Ipv4Address ("10.0.0.0"), Ipv4Address ("10.0.0.9"));
+  Simulator::Stop (MicroSeconds (1));
+  Simulator::Run ();
+  Enqueue (queue, hopA, 0, flow0, 150, false);
+  Ptr<const Packet> small = queue->PeekFittingFlowHeadByTid (&hdr, 0, hopA, flow1, 500, &tstamp);
+  NS_TEST_ASSERT_MSG_NE (small, 0, "no head of flow2 or flow0 fits");
+  NS_TEST_EXPECT_MSG_EQ (small->GetSize (), 300 + 28, "the oldest fitting head expected");
+  NS_TEST_EXPECT_MSG_EQ ((small->GetSize () + hdr.GetSize () <= 500), true, "header not counted");
+  small = queue->PeekFittingFlowHeadByTid (&hdr, 0, hopA, flow1, 300 + 28, &tstamp);
+  NS_TEST_ASSERT_MSG_NE (small, 0, "the head of flow0 fits");
+  NS_TEST_EXPECT_MSG_EQ (small->GetSize (), 150 + 28, "wrong fitting head");
+  small = queue->PeekFittingFlowHeadByTid (&hdr, 0, hopA, flow0, 500, &tstamp);
+  NS_TEST_EXPECT_MSG_EQ (small->GetSize (), 300 + 28, "wrong fitting head");
+  small = queue->PeekFittingFlowHeadByTid (&hdr, 0, hopA, flow2, 1000, &tstamp);
+  NS_TEST_ASSERT_MSG_NE (small, 0, "the head of flow1 fits");
+  NS_TEST_EXPECT_MSG_EQ (small->GetSize (), 600 + 28, "a packet other than the head of flow1");
+  small = queue->PeekFittingFlowHeadByTid (&hdr, 0, hopA, flow0, 300 + 28, &tstamp);
+  NS_TEST_EXPECT_MSG_EQ (small, 0, "packet larger than the bound or not a head");
+  NS_TEST_EXPECT_MSG_EQ (queue->Remove (queue->PeekByTidAndAddress (&hdr, 0, WifiMacHeader::ADDR1, hopA, flow0, &tstamp)),
+                         true, "flow0 not removed");
+  // the packet pushed at the front comes first
+  Ptr<const Packet> packet = queue->PeekByAddress (&hdr, WifiMacHeader::ADDR1, hopA, flow1, &tstamp);
+  NS_TEST_ASSERT_MSG_NE (packet, 0, "no packet for flow1 via hopA");
+  NS_TEST_EXPECT_MSG_EQ (packet->GetSize (), 600 + 28, "wrong head of flow");
+  NS_TEST_EXPECT_MSG_EQ (queue->Remove (packet), true, "peeked packet not removed");
+
+  packet = queue->DequeueByAddress (&hdr, WifiMacHeader::ADDR1, hopA, flow1);
+  NS_TEST_EXPECT_MSG_EQ (packet->GetSize (), 100 + 28, "wrong FIFO order");
+  packet = queue->PeekByTidAndAddress (&hdr, 5, WifiMacHeader::ADDR1, hopA, flow1, &tstamp);
+  NS_TEST_EXPECT_MSG_EQ (packet->GetSize (), 500 + 28, "wrong packet for tid 5");
+  packet = queue->DequeueByTidAndAddress (&hdr, 0, WifiMacHeader::ADDR1, hopA, flow1);
+  NS_TEST_EXPECT_MSG_EQ (packet->GetSize (), 400 + 28, "wrong packet for tid 0");
+  packet = queue->DequeueByTidAndAddress (&hdr, 0, WifiMacHeader::ADDR1, hopA, flow1);
+  NS_TEST_EXPECT_MSG_EQ (packet, 0, "flow1 tid 0 should be empty");
+
+  // the non-indexed dequeue keeps the sub-queues consistent
+  packet = queue->Dequeue (&hdr);
+  NS_TEST_EXPECT_MSG_EQ (packet->GetSize (), 200 + 28, "wrong head of queue");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPacketsByAddress (WifiMacHeader::ADDR1, hopB, flow1), 0, "stale index");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetSize (), 2, "wrong queue size");
+
+  queue->Flush ();
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPacketsByAddress (WifiMacHeader::ADDR1, hopA, flow2), 0, "index not flushed");
+  Simulator::Destroy ();
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+class DmgOptimizationSolverTest : public TestCase
+{
+public:
+  DmgOptimizationSolverTest () : TestCase ("DMG flow rate optimization solvers")
+  {
+  }
+  virtual void DoRun (void);
+};
+
+void
+DmgOptimizationSolverTest::DoRun (void)
+{
+  // Flows 0 and 1 share clique 0 (100 Mb/s links), flows 1 and 2 share
+  // clique 1 (50 Mb/s links).
+  std::vector<DmgOptimizationSolver::Clique> cliques (2);
+  cliques[0].flows.push_back (0);
+  cliques[0].capacity.push_back (100);
+  cliques[0].flows.push_back (1);
+  cliques[0].capacity.push_back (100);
+  cliques[1].flows.push_back (1);
+  cliques[1].capacity.push_back (50);
+  cliques[1].flows.push_back (2);
+  cliques[1].capacity.push_back (50);
+  std::vector<double> demand (3, 1000);
+
+  // Max-min fair: clique 1 is the bottleneck of flows 1 and 2 at 25, flow 0
+  // takes what is left in clique 0.
+  Ptr<DmgOptimizationSolver> waterFilling = CreateObject<DmgWaterFillingSolver> ();
+  std::vector<double> rate = waterFilling->Solve (demand, cliques);
+  NS_TEST_EXPECT_MSG_EQ_TOL (rate[0], 75, 1e-6, "water-filling rate of flow 0");
+  NS_TEST_EXPECT_MSG_EQ_TOL (rate[1], 25, 1e-6, "water-filling rate of flow 1");
+  NS_TEST_EXPECT_MSG_EQ_TOL (rate[2], 25, 1e-6, "water-filling rate of flow 2");
+
+  Ptr<DmgOptimizationSolver> progressive = CreateObject<DmgProgressiveFillingSolver> ();
+  progressive->SetAttribute ("StepLength", DoubleValue (0.5));
+  rate = progressive->Solve (demand, cliques);
+  NS_TEST_EXPECT_MSG_EQ_TOL (rate[0], 75, 0.5, "progressive filling rate of flow 0");
+  NS_TEST_EXPECT_MSG_EQ_TOL (rate[1], 25, 0.5, "progressive filling rate of flow 1");
+  NS_TEST_EXPECT_MSG_EQ_TOL (rate[2], 25, 0.5, "progressive filling rate of flow 2");
+
+  // Max throughput starves the flow crossing both cliques.
+  Ptr<DmgOptimizationSolver> simplex = CreateObject<DmgSimplexSolver> ();
+  rate = simplex->Solve (demand, cliques);
+  NS_TEST_EXPECT_MSG_EQ_TOL (rate[0], 100, 1e-6, "simplex rate of flow 0");
+  NS_TEST_EXPECT_MSG_EQ_TOL (rate[1], 0, 1e-6, "simplex rate of flow 1");
+  NS_TEST_EXPECT_MSG_EQ_TOL (rate[2], 50, 1e-6, "simplex rate of flow 2");
+
+  // Demands are never exceeded.
+  demand[0] = 10;
+  rate = waterFilling->Solve (demand, cliques);
+  NS_TEST_EXPECT_MSG_EQ_TOL (rate[0], 10, 1e-6, "water-filling rate of a satisfied flow");
+  NS_TEST_EXPECT_MSG_EQ_TOL (rate[1], 25, 1e-6, "water-filling rate of a bottlenecked flow");
+  rate = simplex->Solve (demand, cliques);
+  NS_TEST_EXPECT_MSG_EQ_TOL (rate[0] + rate[1] + rate[2], 60, 1e-6, "simplex total throughput");
+  NS_TEST_EXPECT_MSG_EQ_TOL (rate[0], 10, 1e-6, "simplex rate of a satisfied flow");
+
+  // A link that is down stops the flows crossing it only.
+  cliques[1].capacity[0] = 0;
+  rate = progressive->Solve (demand, cliques);
+  NS_TEST_EXPECT_MSG_EQ_TOL (rate[1], 0, 1e-6, "progressive filling rate of a flow crossing a link down");
+  NS_TEST_EXPECT_MSG_EQ_TOL (rate[2], 50, 0.5, "progressive filling rate of flow 2 with a link down");
+}
+
+//-----------------------------------------------------------------------------
+class DmgAirtimeAllocatorTest : public TestCase
+{
+public:
+  DmgAirtimeAllocatorTest () : TestCase ("DMG free airtime allocator")
+  {
+  }
+  virtual void DoRun (void);
+};
+
+void
+DmgAirtimeAllocatorTest::DoRun (void)
+{
+  DmgAirtimeAllocator airtime;
+  uint64_t start, stop;
+  NS_TEST_EXPECT_MSG_EQ (airtime.FirstFit (0, start, stop), false, "no free airtime yet");
+
+  airtime.Release (0, 1000);
+  airtime.Reserve (100, 200);
+  airtime.Reserve (500, 550);
+  airtime.Reserve (900, 1200);
+  // Free: [0,100) [200,500) [550,900)
+  NS_TEST_EXPECT_MSG_EQ (airtime.GetNFreeIntervals (), 3, "wrong number of gaps");
+  NS_TEST_EXPECT_MSG_EQ (airtime.GetFreeTime (), 750, "wrong free time");
+
+  NS_TEST_EXPECT_MSG_EQ (airtime.FirstFit (150, start, stop), true, "first fit failed");
+  NS_TEST_EXPECT_MSG_EQ (start, 200, "wrong first fit start");
+  NS_TEST_EXPECT_MSG_EQ (stop, 500, "wrong first fit stop");
+  NS_TEST_EXPECT_MSG_EQ (airtime.BestFit (301, start, stop), true, "best fit failed");
+  NS_TEST_EXPECT_MSG_EQ (start, 550, "wrong best fit start");
+  NS_TEST_EXPECT_MSG_EQ (airtime.BestFit (90, start, stop), true, "best fit failed");
+  NS_TEST_EXPECT_MSG_EQ (start, 0, "wrong best fit start");
+  NS_TEST_EXPECT_MSG_EQ (airtime.FirstFit (351, start, stop), false, "no gap is that long");
+
+  // Releasing merges with the adjacent gaps, reserving across gaps splits them
+  airtime.Release (100, 200);
+  airtime.Release (500, 550);
+  NS_TEST_EXPECT_MSG_EQ (airtime.GetNFreeIntervals (), 1, "gaps not merged");
+  NS_TEST_EXPECT_MSG_EQ (airtime.FirstFit (900, start, stop), true, "merged gap not found");
+  NS_TEST_EXPECT_MSG_EQ (stop, 900, "wrong merged gap stop");
+  airtime.Reserve (50, 60);
+  airtime.Reserve (40, 850);
+  std::vector<std::pair<uint64_t, uint64_t> > gaps = airtime.GetFreeIntervals ();
+  NS_TEST_ASSERT_MSG_EQ (gaps.size (), 2, "wrong number of gaps");
+  NS_TEST_EXPECT_MSG_EQ (gaps[0].first, 0, "wrong gap");
+  NS_TEST_EXPECT_MSG_EQ (gaps[0].second, 40, "wrong gap");
+  NS_TEST_EXPECT_MSG_EQ (gaps[1].first, 850, "wrong gap");
+  NS_TEST_EXPECT_MSG_EQ (gaps[1].second, 900, "wrong gap");
+
+  // Copies are independent
+  DmgAirtimeAllocator copy = airtime;
+  copy.Reserve (0, 1000);
+  NS_TEST_EXPECT_MSG_EQ (copy.GetFreeTime (), 0, "copy not reserved");
+  NS_TEST_EXPECT_MSG_EQ (airtime.GetFreeTime (), 90, "original changed by the copy");
+}
+
+//-----------------------------------------------------------------------------
+class DmgLayerSchedulerTest : public TestCase
+{
+public:
+  DmgLayerSchedulerTest () : TestCase ("DMG SPs packed in concurrent layers")
+  {
+  }
+  virtual void DoRun (void);
+};
+
+void
+DmgLayerSchedulerTest::DoRun (void)
+{
+  // Chain 0-1-2-3-4: only the links sharing a node conflict
+  DmgLayerScheduler layers;
+  uint32_t a = layers.AddLink (0, 1, 400);
+  uint32_t b = layers.AddLink (1, 2, 300);
+  uint32_t c = layers.AddLink (2, 3, 400);
+  uint32_t d = layers.AddLink (3, 4, 300);
+  NS_TEST_EXPECT_MSG_EQ (layers.Schedule (1000), true, "chain does not fit");
+  NS_TEST_EXPECT_MSG_EQ (layers.GetNLayers (), 2, "a chain needs two layers");
+  NS_TEST_EXPECT_MSG_EQ (layers.GetLayer (a), layers.GetLayer (c), "0-1 and 2-3 are concurrent");
+  NS_TEST_EXPECT_MSG_EQ (layers.GetLayer (b), layers.GetLayer (d), "1-2 and 3-4 are concurrent");
+  NS_TEST_ASSERT_MSG_EQ (layers.GetSps (a).size (), 1, "0-1 sliced");
+  NS_TEST_EXPECT_MSG_EQ (layers.GetSps (a)[0].first, 0, "0-1 does not start with the schedule");
+  NS_TEST_EXPECT_MSG_EQ (layers.GetSps (c)[0].first, 0, "2-3 does not start with the schedule");
+  NS_TEST_ASSERT_MSG_EQ (layers.GetSps (b).size (), 1, "1-2 sliced");
+  NS_TEST_EXPECT_MSG_EQ (layers.GetSps (b)[0].first, 400, "1-2 overlaps a link sharing a node");
+  NS_TEST_EXPECT_MSG_EQ (layers.GetSps (d)[0].first, 400, "3-4 overlaps a link sharing a node");
+  NS_TEST_EXPECT_MSG_EQ_TOL (layers.GetLayerUtilization (0), 0.8, 1e-9, "wrong utilization of layer 0");
+  NS_TEST_EXPECT_MSG_EQ_TOL (layers.GetLayerOccupancy (0), 0.4, 1e-9, "wrong occupancy of layer 0");
+  NS_TEST_EXPECT_MSG_EQ_TOL (layers.GetLayerUtilization (1), 0.6, 1e-9, "wrong utilization of layer 1");
+  NS_TEST_EXPECT_MSG_EQ_TOL (layers.GetConcurrency (), 2, 1e-9, "two links should always be active");
+
+  // 0-1 interferes with 2-3: three layers, and 1-2 no longer fits
+  layers.AddConflict (a, c);
+  NS_TEST_EXPECT_MSG_EQ (layers.Schedule (1000), false, "1-2 should not fit");
+  NS_TEST_EXPECT_MSG_EQ (layers.GetNLayers (), 3, "interference needs a third layer");
+  NS_TEST_EXPECT_MSG_EQ (layers.GetSps (a)[0].first, 400, "0-1 overlaps the interfering 2-3");
+  NS_TEST_EXPECT_MSG_EQ (layers.GetSps (d)[0].first, 400, "3-4 overlaps a link sharing a node");
+  NS_TEST_ASSERT_MSG_EQ (layers.GetSps (b).size (), 1, "1-2 sliced");
+  NS_TEST_EXPECT_MSG_EQ (layers.GetSps (b)[0].first, 800, "1-2 not in the last gap");
+  NS_TEST_EXPECT_MSG_EQ (layers.GetUnplacedNs (b), 100, "wrong airtime left out");
+
+  // Interference alone is a soft conflict: what does not fit around the
+  // interferer overlaps it
+  layers.Clear ();
+  a = layers.AddLink (0, 1, 600);
+  b = layers.AddLink (2, 3, 600);
+  layers.AddConflict (a, b);
+  NS_TEST_EXPECT_MSG_EQ (layers.Schedule (1000), true, "interfering links should fit");
+  NS_TEST_EXPECT_MSG_EQ (layers.GetNLayers (), 2, "interfering links in the same layer");
+  NS_TEST_ASSERT_MSG_EQ (layers.GetSps (b).size (), 2, "2-3 not sliced");
+  NS_TEST_EXPECT_MSG_EQ (layers.GetSps (b)[0].first, 600, "2-3 does not start after 0-1");
+  NS_TEST_EXPECT_MSG_EQ (layers.GetSps (b)[1].first, 0, "2-3 does not overlap 0-1");
+  NS_TEST_EXPECT_MSG_EQ (layers.GetSps (b)[1].second, 200, "wrong overlap with 0-1");
+  NS_TEST_EXPECT_MSG_EQ_TOL (layers.GetConcurrency (), 1.2, 1e-9, "wrong concurrency");
+
+  // The SPs of a node carry their layer
+  Ptr<DmgBeaconInterval> bi = CreateObject<DmgBeaconInterval> ();
+  bi->SetBiDuration (MicroSeconds (1000));
+  for (uint32_t layer = 0; layer < 2; layer++)
+    {
+      Ptr<DmgServicePeriod> sp = CreateObject<DmgServicePeriod> ();
+      sp->SetSpStart (MicroSeconds (400 * layer));
+      sp->SetSpStop (MicroSeconds (400 * layer + 400 - 100 * layer));
+      sp->SetSpLayer (layer);
+      bi->AddSp (sp);
+    }
+  NS_TEST_EXPECT_MSG_EQ (bi->GetNLayers (), 2, "wrong number of layers of the node");
+  NS_TEST_EXPECT_MSG_EQ_TOL (bi->GetLayerUtilization (1), 0.3, 1e-9, "wrong utilization of the node layer");
+}
+
+//-----------------------------------------------------------------------------
+class DmgRoutePlannerTest : public TestCase
+{
+public:
+  DmgRoutePlannerTest () : TestCase ("DMG flow paths from the gateways")
+  {
+  }
+  virtual void DoRun (void);
+};
+
+void
+DmgRoutePlannerTest::DoRun (void)
+{
+  // 0-1-3 takes less airtime, 0-2-3 has the faster slowest link
+  DmgRoutePlanner planner;
+  planner.SetNNodes (4);
+  planner.AddLink (0, 1, 0.2, 0.2);
+  planner.AddLink (1, 3, 1.5, 1.5);
+  planner.AddLink (0, 2, 1, 1);
+  NS_TEST_EXPECT_MSG_EQ (planner.AddLink (2, 3, 1, 1), 3, "wrong link index");
+  planner.AddGateway (0);
+  std::vector<uint32_t> sinks (1, 3);
+  NS_TEST_EXPECT_MSG_EQ (planner.Route (DmgRoutePlanner::MIN_AIRTIME, sinks, std::vector<double> ()), true, "3 not reached");
+  NS_TEST_ASSERT_MSG_EQ (planner.GetPath (0).size (), 3, "wrong min airtime path length");
+  NS_TEST_EXPECT_MSG_EQ (planner.GetPath (0)[1], 1, "min airtime path not through 1");
+  NS_TEST_EXPECT_MSG_EQ (planner.Route (DmgRoutePlanner::WIDEST_PATH, sinks, std::vector<double> ()), true, "3 not reached");
+  NS_TEST_ASSERT_MSG_EQ (planner.GetPath (0).size (), 3, "wrong widest path length");
+  NS_TEST_EXPECT_MSG_EQ (planner.GetPath (0)[1], 2, "widest path not through 2");
+
+  // Two symmetric sinks: the minimum airtime routes both through 1, the
+  // clique load one splits them
+  planner.Clear ();
+  planner.SetNNodes (5);
+  planner.AddLink (0, 1, 1, 1);
+  planner.AddLink (0, 2, 1, 1);
+  planner.AddLink (1, 3, 1, 1);
+  planner.AddLink (2, 3, 1.1, 1.1);
+  planner.AddLink (1, 4, 1, 1);
+  planner.AddLink (2, 4, 1.1, 1.1);
+  planner.AddGateway (0);
+  sinks.clear ();
+  sinks.push_back (3);
+  sinks.push_back (4);
+  std::vector<double> demands (2, 1000);
+  planner.Route (DmgRoutePlanner::MIN_AIRTIME, sinks, demands);
+  NS_TEST_EXPECT_MSG_EQ ((planner.GetPath (0)[1] == 1 && planner.GetPath (1)[1] == 1), true, "min airtime paths not through 1");
+  NS_TEST_EXPECT_MSG_EQ_TOL (planner.GetMaxNodeLoad (), 4, 1e-9, "wrong load of node 1");
+  planner.Route (DmgRoutePlanner::CLIQUE_LOAD, sinks, demands);
+  NS_TEST_EXPECT_MSG_EQ ((planner.GetPath (0)[1] != planner.GetPath (1)[1]), true, "clique load paths not split");
+  NS_TEST_EXPECT_MSG_EQ_TOL (planner.GetMaxNodeLoad (), 2.1, 1e-9, "wrong load of the busiest node");
+
+  // Chain 0-1-2-3-4 with gateways at both ends, 5 out of reach
+  planner.Clear ();
+  planner.SetNNodes (6);
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      planner.AddLink (i, i + 1, 1, 1);
+    }
+  planner.AddGateway (0);
+  planner.AddGateway (4);
+  sinks.clear ();
+  sinks.push_back (1);
+  sinks.push_back (3);
+  NS_TEST_EXPECT_MSG_EQ (planner.Route (DmgRoutePlanner::MIN_AIRTIME, sinks, std::vector<double> ()), true, "sinks not reached");
+  NS_TEST_EXPECT_MSG_EQ (planner.GetPath (0).front (), 0, "1 not routed from gateway 0");
+  NS_TEST_EXPECT_MSG_EQ (planner.GetPath (1).front (), 4, "3 not routed from gateway 4");
+  NS_TEST_EXPECT_MSG_EQ (planner.GetPath (1).size (), 2, "wrong path from gateway 4");
+  sinks.push_back (5);
+  NS_TEST_EXPECT_MSG_EQ (planner.Route (DmgRoutePlanner::MIN_AIRTIME, sinks, std::vector<double> ()), false, "5 reached");
+  NS_TEST_EXPECT_MSG_EQ (planner.GetPath (2).empty (), true, "path to 5");
+}
+
+//-----------------------------------------------------------------------------
+class DmgChannelPlannerTest : public TestCase
+{
+public:
+  DmgChannelPlannerTest () : TestCase ("DMG channels of the links")
+  {
+  }
+  virtual void DoRun (void);
+};
+
+void
+DmgChannelPlannerTest::DoRun (void)
+{
+  // Star around node 0: one channel per link
+  DmgChannelPlanner planner;
+  planner.SetNChannels (3);
+  planner.SetNNodes (4);
+  for (uint32_t i = 1; i < 4; i++)
+    {
+      planner.AddLink (0, i, 0.3);
+    }
+  NS_TEST_EXPECT_MSG_EQ (planner.Assign (), true, "radios exceeded");
+  NS_TEST_EXPECT_MSG_EQ (planner.GetNodeChannels (0).size (), 3, "star links share a channel");
+  NS_TEST_EXPECT_MSG_EQ_TOL (planner.GetMaxConflictLoad (), 0.3, 1e-9, "wrong load of the star links");
+
+  // Two radios at the center: two links share a channel
+  planner.SetNodeRadios (0, 2);
+  NS_TEST_EXPECT_MSG_EQ (planner.Assign (), true, "radios exceeded");
+  NS_TEST_EXPECT_MSG_EQ (planner.GetNodeChannels (0).size (), 2, "center does not use its two radios");
+  NS_TEST_EXPECT_MSG_EQ_TOL (planner.GetMaxConflictLoad (), 0.6, 1e-9, "wrong load of the shared channel");
+
+  // Chain 0-1-2-3 on two channels, 2-3 interfering with 0-1: 2-3 joins
+  // the lighter 1-2
+  planner.Clear ();
+  planner.SetNChannels (2);
+  planner.SetNNodes (4);
+  planner.AddLink (0, 1, 0.5);
+  planner.AddLink (1, 2, 0.2);
+  NS_TEST_EXPECT_MSG_EQ (planner.AddLink (2, 3, 0.4), 2, "wrong link index");
+  planner.AddConflict (0, 2);
+  NS_TEST_EXPECT_MSG_EQ (planner.Assign (), true, "radios exceeded");
+  NS_TEST_EXPECT_MSG_NE (planner.GetChannel (0), planner.GetChannel (1), "0-1 and 1-2 share a channel");
+  NS_TEST_EXPECT_MSG_EQ (planner.GetChannel (2), planner.GetChannel (1), "2-3 not with 1-2");
+  NS_TEST_EXPECT_MSG_EQ_TOL (planner.GetMaxConflictLoad (), 0.6, 1e-9, "wrong load of 1-2 and 2-3");
+
+  // A single radio at 1: its links share the channel
+  planner.SetNodeRadios (1, 1);
+  NS_TEST_EXPECT_MSG_EQ (planner.Assign (), true, "radios exceeded");
+  NS_TEST_EXPECT_MSG_EQ (planner.GetNodeChannels (1).size (), 1, "node 1 uses two channels");
+
+  // 1-2 colored last, between single radio nodes already on different
+  // channels
+  planner.Clear ();
+  planner.SetNNodes (4);
+  planner.SetNodeRadios (1, 1);
+  planner.SetNodeRadios (2, 1);
+  planner.AddLink (0, 1, 1);
+  planner.AddLink (2, 3, 1);
+  planner.AddLink (1, 2, 1);
+  planner.AddConflict (0, 1);
+  NS_TEST_EXPECT_MSG_EQ (planner.Assign (), false, "radios not exceeded");
+}
+
+//-----------------------------------------------------------------------------
+class DmgSpRecorderTest : public TestCase
+{
+public:
+  DmgSpRecorderTest () : TestCase ("DMG SP stats written and read back")
+  {
+  }
+  virtual void DoRun (void);
+};
+
+void
+DmgSpRecorderTest::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("dmg-sp-stats.bin");
+  DmgSpRecorder recorder;
+  NS_TEST_ASSERT_MSG_EQ (recorder.Open (filename), true, "cannot create " << filename);
+  // Seven records over blocks of three: two full blocks and one partial
+  recorder.SetBlockSize (3);
+  std::vector<DmgSpStats> written;
+  for (uint32_t i = 0; i < 7; i++)
+    {
+      DmgSpStats stats;
+      stats.source = Mac48Address::Allocate ();
+      stats.destination = Mac48Address ("00:00:00:00:01:ff");
+      stats.startNs = 5000000000ULL + i * 1024000;
+      stats.allocatedNs = 400000 + i;
+      stats.usedNs = 380000 - i;
+      stats.bytes = 1470 * 30 * i;
+      stats.nMpdus = 30 * i;
+      stats.nPpdus = i;
+      stats.tailNs = 1000 * i;
+      stats.switchNs = i;
+      stats.nPacked = i % 3;
+      stats.reverseNs = 20000 * (i % 2);
+      stats.ack = i % 2;
+      recorder.Record (stats);
+      written.push_back (stats);
+    }
+  NS_TEST_EXPECT_MSG_EQ (recorder.GetNRecords (), 7, "records lost");
+  recorder.Close ();
+
+  DmgSpReader reader;
+  NS_TEST_ASSERT_MSG_EQ (reader.Open (filename), true, "file not recognized");
+  DmgSpStats stats;
+  for (uint32_t i = 0; i < written.size (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (reader.Read (stats), true, "record " << i << " missing");
+      NS_TEST_EXPECT_MSG_EQ (stats.source, written[i].source, "wrong source of record " << i);
+      NS_TEST_EXPECT_MSG_EQ (stats.destination, written[i].destination, "wrong destination of record " << i);
+      NS_TEST_EXPECT_MSG_EQ (stats.startNs, written[i].startNs, "wrong start of record " << i);
+      NS_TEST_EXPECT_MSG_EQ (stats.allocatedNs, written[i].allocatedNs, "wrong allocated time of record " << i);
+      NS_TEST_EXPECT_MSG_EQ (stats.usedNs, written[i].usedNs, "wrong used time of record " << i);
+      NS_TEST_EXPECT_MSG_EQ (stats.bytes, written[i].bytes, "wrong bytes of record " << i);
+      NS_TEST_EXPECT_MSG_EQ (stats.nMpdus, written[i].nMpdus, "wrong MPDUs of record " << i);
+      NS_TEST_EXPECT_MSG_EQ (stats.nPpdus, written[i].nPpdus, "wrong PPDUs of record " << i);
+      NS_TEST_EXPECT_MSG_EQ (stats.tailNs, written[i].tailNs, "wrong tail of record " << i);
+      NS_TEST_EXPECT_MSG_EQ (stats.switchNs, written[i].switchNs, "wrong switch time of record " << i);
+      NS_TEST_EXPECT_MSG_EQ (stats.nPacked, written[i].nPacked, "wrong packed MPDUs of record " << i);
+      NS_TEST_EXPECT_MSG_EQ (stats.reverseNs, written[i].reverseNs, "wrong reverse direction time of record " << i);
+      NS_TEST_EXPECT_MSG_EQ (stats.ack, written[i].ack, "wrong ACK flag of record " << i);
+    }
+  NS_TEST_EXPECT_MSG_EQ (reader.Read (stats), false, "records past the end");
+
+  // Not a recorder file
+  std::ofstream other (filename.c_str ());
+  other << "source,destination" << std::endl;
+  other.close ();
+  NS_TEST_EXPECT_MSG_EQ (reader.Open (filename), false, "text file read as SP stats");
+}
+
+//-----------------------------------------------------------------------------
+class DmgAirtimeModelTest : public TestCase
+{
+public:
+  DmgAirtimeModelTest () : TestCase ("DMG SP exchange airtime model")
+  {
+  }
+  virtual void DoRun (void);
+};
+
+void
+DmgAirtimeModelTest::DoRun (void)
+{
+  Ptr<YansWifiPhy> phy = CreateObject<YansWifiPhy> ();
+  phy->ConfigureStandard (WIFI_PHY_STANDARD_80211ad);
+  DmgAirtimeModel model;
+  model.SetPhy (phy);
+  // The measurements stop at the BlockAck reception, without the guard
+  // MacLow keeps for the ACK timeout
+  model.SetAckTimeoutGuard (Seconds (0));
+
+  // Exchange durations (ns) measured in SPs with 1470 bytes of UDP payload
+  const char *names[] = {"VHTMCS24a", "VHTMCS21a", "VHTMCS18a"};
+  const uint32_t nMpdus[] = {1, 5, 10, 30};
+  const double measured[3][4] = {{9624, 16880, 26107, 65291},
+                                 {10836, 21745, 35332, 92700},
+                                 {12782, 30454, 52724, 143830}};
+  for (uint32_t m = 0; m < 3; m++)
+    {
+      WifiMode mode (names[m]);
+      for (uint32_t k = 0; k < 4; k++)
+        {
+          double ns = model.GetExchangeDuration (mode, nMpdus[k], 1470 + 36).GetNanoSeconds ();
+          NS_TEST_EXPECT_MSG_EQ_TOL (ns, measured[m][k], 0.06 * measured[m][k],
+                                     names[m] << " with " << nMpdus[k] << " MPDUs far from the measurements");
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (model.GetNEntries (), 12, "durations not memoized");
+  model.GetExchangeDuration (WifiMode ("VHTMCS24a"), 30, 1506);
+  NS_TEST_EXPECT_MSG_EQ (model.GetNEntries (), 12, "memoized duration computed again");
+
+  // Every DMG mode, any aggregation depth and payload
+  model.Clear ();
+  model.Precompute (7, 500);
+  NS_TEST_EXPECT_MSG_EQ (model.GetNEntries (), phy->GetNModes (), "one entry per mode expected");
+  for (uint32_t i = 0; i < phy->GetNModes (); i++)
+    {
+      Time one = model.GetExchangeDuration (phy->GetMode (i), 1, 500);
+      Time seven = model.GetExchangeDuration (phy->GetMode (i), 7, 500);
+      NS_TEST_EXPECT_MSG_GT (one, Seconds (0), phy->GetMode (i).GetUniqueName () << " has no airtime");
+      NS_TEST_EXPECT_MSG_GT (seven, one, phy->GetMode (i).GetUniqueName () << " airtime not growing with the MPDUs");
+    }
+  NS_TEST_EXPECT_MSG_EQ (DmgAirtimeModel::GetPsduSize (3, 1001), 2 * 1036 + 1035, "wrong A-MPDU padding");
+  NS_TEST_EXPECT_MSG_EQ (DmgAirtimeModel::GetPsduSize (1, 1001), 1035, "a single MPDU is an A-MPDU subframe too");
+
+  // The guards are charged as MacLow does
+  Time base = model.GetExchangeDuration (WifiMode ("VHTMCS24a"), 5, 1506);
+  model.SetPropagationGuard (NanoSeconds (100));
+  model.SetAckTimeoutGuard (MicroSeconds (2));
+  NS_TEST_EXPECT_MSG_EQ (model.GetExchangeDuration (WifiMode ("VHTMCS24a"), 5, 1506), base + NanoSeconds (2200),
+                         "guards not charged");
+}
+
+//-----------------------------------------------------------------------------
+/* A DMG PHY whose MCS thresholds are the 802.11ad sensitivities */
+static Ptr<YansWifiPhy>
+CreateDmgPhy (bool ofdm)
+{
+  Ptr<YansWifiPhy> phy = CreateObject<YansWifiPhy> ();
+  phy->SetAttribute ("dmgOfdm", BooleanValue (ofdm));
+  phy->SetRxNoiseFigure (0);
+  phy->SetErrorRateModel (CreateObject<SensitivityModel60GHz> ());
+  phy->ConfigureStandard (WIFI_PHY_STANDARD_80211ad);
+  return phy;
+}
+
+class DmgMcsTableTest : public TestCase
+{
+public:
+  DmgMcsTableTest () : TestCase ("DMG MCS thresholds and per destination modes")
+  {
+  }
+  virtual void DoRun (void);
+};
+
+void
+DmgMcsTableTest::DoRun (void)
+{
+  // Without noise figure the thresholds are the receiver sensitivities
+  DmgMcsTable ofdm;
+  ofdm.Build (CreateDmgPhy (true));
+  NS_TEST_ASSERT_MSG_EQ (ofdm.GetNModes (), 12, "VHTMCS13a-24a expected");
+  NS_TEST_EXPECT_MSG_EQ (ofdm.LookupRxPower (-46.99).GetUniqueName (), "VHTMCS24a", "wrong mode above -47 dBm");
+  NS_TEST_EXPECT_MSG_EQ (ofdm.LookupRxPower (-47.01).GetUniqueName (), "VHTMCS23a", "wrong mode below -47 dBm");
+  NS_TEST_EXPECT_MSG_EQ (ofdm.LookupRxPower (-65.99).GetUniqueName (), "VHTMCS13a", "wrong mode above -66 dBm");
+  NS_TEST_EXPECT_MSG_EQ (ofdm.LookupRxPower (-66.01).GetUniqueName (), "VHTMCS0", "no data mode below -66 dBm");
+  for (uint32_t i = 1; i < ofdm.GetNModes (); i++)
+    {
+      NS_TEST_EXPECT_MSG_GT (ofdm.GetThresholdDb (i), ofdm.GetThresholdDb (i - 1), "thresholds not sorted");
+      NS_TEST_EXPECT_MSG_GT (ofdm.GetMode (i).GetDataRate (), ofdm.GetMode (i - 1).GetDataRate (), "rates not sorted");
+    }
+
+  // VHTMCS5 needs the SNR of the faster VHTMCS7
+  DmgMcsTable sc;
+  sc.Build (CreateDmgPhy (false));
+  NS_TEST_EXPECT_MSG_EQ (sc.GetNModes (), 11, "VHTMCS1-12 but VHTMCS5 expected");
+  NS_TEST_EXPECT_MSG_EQ (sc.LookupRxPower (-61.5).GetUniqueName (), "VHTMCS7", "wrong mode at -61.5 dBm");
+  NS_TEST_EXPECT_MSG_EQ (sc.LookupRxPower (-52).GetUniqueName (), "VHTMCS12", "wrong mode at -52 dBm");
+
+  Ptr<DmgDestinationFixedWifiManager> manager = CreateObject<DmgDestinationFixedWifiManager> ();
+  manager->SetupPhy (CreateDmgPhy (true));
+  Mac48Address a = Mac48Address ("00:00:00:00:00:01");
+  Mac48Address b = Mac48Address ("00:00:00:00:00:02");
+  manager->AddDestinationWifiMode (7, a, WifiMode ("VHTMCS20a"));
+  manager->AddDestinationWifiMode (3, b, WifiMode ("VHTMCS15a"));
+  NS_TEST_EXPECT_MSG_EQ (manager->GetDestinationWifiMode (7), WifiMode ("VHTMCS20a"), "wrong mode of node 7");
+  NS_TEST_EXPECT_MSG_EQ (manager->GetDestinationWifiMode (b), WifiMode ("VHTMCS15a"), "wrong mode of node 3");
+  WifiMacHeader hdr;
+  hdr.SetType (WIFI_MAC_QOSDATA);
+  hdr.SetAddr1 (a);
+  Ptr<Packet> packet = Create<Packet> (1000);
+  NS_TEST_EXPECT_MSG_EQ (manager->GetDataTxVector (a, &hdr, packet, 1030).GetMode (), WifiMode ("VHTMCS20a"), "wrong data mode");
+  // The station keeps its node ID, the mode is updated
+  manager->AddDestinationWifiMode (a, WifiMode ("VHTMCS24a"));
+  NS_TEST_EXPECT_MSG_EQ (manager->GetDataTxVector (a, &hdr, packet, 1030).GetMode (), WifiMode ("VHTMCS24a"), "mode not updated");
+
+  // A destination without node ID is kept by address until it gets one
+  Mac48Address c = Mac48Address ("00:00:00:00:00:03");
+  manager->AddDestinationWifiMode (c, WifiMode ("VHTMCS17a"));
+  NS_TEST_EXPECT_MSG_EQ (manager->GetDestinationWifiMode (c), WifiMode ("VHTMCS17a"), "wrong mode of the address");
+  hdr.SetAddr1 (c);
+  NS_TEST_EXPECT_MSG_EQ (manager->GetDataTxVector (c, &hdr, packet, 1030).GetMode (), WifiMode ("VHTMCS17a"), "wrong data mode of the address");
+  manager->AddDestinationWifiMode (5, c, WifiMode ("VHTMCS21a"));
+  NS_TEST_EXPECT_MSG_EQ (manager->GetDestinationWifiMode (c), WifiMode ("VHTMCS21a"), "the node ID does not supersede the address");
+  NS_TEST_EXPECT_MSG_EQ (manager->GetDataTxVector (c, &hdr, packet, 1030).GetMode (), WifiMode ("VHTMCS21a"), "wrong data mode of node 5");
+}
+
+//-----------------------------------------------------------------------------
+class DmgSnrWifiManagerTest : public TestCase
+{
+public:
+  DmgSnrWifiManagerTest () : TestCase ("DMG rate adaptation on SNR and BlockAck losses")
+  {
+  }
+  virtual void DoRun (void);
+};
+
+void
+DmgSnrWifiManagerTest::DoRun (void)
+{
+  Ptr<DmgSnrWifiManager> manager = CreateObject<DmgSnrWifiManager> ();
+  manager->SetAttribute ("SnrSmoothing", DoubleValue (1));
+  manager->SetAttribute ("RecoverySuccesses", UintegerValue (4));
+  manager->SetupPhy (CreateDmgPhy (true));
+  const DmgMcsTable &table = manager->GetMcsTable ();
+  uint32_t top = table.GetNModes () - 1;
+  NS_TEST_ASSERT_MSG_EQ (table.GetMode (top), WifiMode ("VHTMCS24a"), "wrong fastest mode");
+
+  Mac48Address a = Mac48Address ("00:00:00:00:00:01");
+  WifiMacHeader hdr;
+  hdr.SetType (WIFI_MAC_QOSDATA);
+  hdr.SetAddr1 (a);
+  hdr.SetAddr2 (a);
+  Ptr<Packet> packet = Create<Packet> (1000);
+  WifiMode ackMode = WifiMode ("VHTMCS20a");
+
+  // The controller's mode until the first SNR sample
+  manager->AddDestinationWifiMode (7, a, WifiMode ("VHTMCS20a"));
+  NS_TEST_EXPECT_MSG_EQ (manager->GetDataTxVector (a, &hdr, packet, 1030).GetMode (), WifiMode ("VHTMCS20a"), "seeded mode not used");
+
+  double thresholdDb = table.GetThresholdDb (top);
+  manager->ReportRxOk (a, &hdr, std::pow (10.0, (thresholdDb + 3) / 10), ackMode);
+  NS_TEST_EXPECT_MSG_EQ (manager->GetDataTxVector (a, &hdr, packet, 1030).GetMode (), WifiMode ("VHTMCS24a"), "no step up at high SNR");
+  // Down as soon as the SNR is below the threshold, up only past the hysteresis
+  manager->ReportRxOk (a, &hdr, std::pow (10.0, (thresholdDb - 0.01) / 10), ackMode);
+  NS_TEST_EXPECT_MSG_EQ (manager->GetDataTxVector (a, &hdr, packet, 1030).GetMode (), WifiMode ("VHTMCS23a"), "no step down");
+  manager->ReportRxOk (a, &hdr, std::pow (10.0, (thresholdDb + 0.5) / 10), ackMode);
+  NS_TEST_EXPECT_MSG_EQ (manager->GetDataTxVector (a, &hdr, packet, 1030).GetMode (), WifiMode ("VHTMCS23a"), "no hysteresis");
+  manager->ReportRxOk (a, &hdr, std::pow (10.0, (thresholdDb + 1.5) / 10), ackMode);
+  NS_TEST_EXPECT_MSG_EQ (manager->GetDataTxVector (a, &hdr, packet, 1030).GetMode (), WifiMode ("VHTMCS24a"), "no step up past the hysteresis");
+
+  // Three losses in a row bring the success ratio below 0.9
+  manager->ReportDataFailed (a, &hdr);
+  manager->ReportDataFailed (a, &hdr);
+  NS_TEST_EXPECT_MSG_EQ (manager->GetDataTxVector (a, &hdr, packet, 1030).GetMode (), WifiMode ("VHTMCS24a"), "early back off");
+  manager->ReportDataFailed (a, &hdr);
+  NS_TEST_EXPECT_MSG_EQ (manager->GetDataTxVector (a, &hdr, packet, 1030).GetMode (), WifiMode ("VHTMCS23a"), "no back off");
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      manager->ReportDataOk (a, &hdr, 0, ackMode, 0);
+    }
+  NS_TEST_EXPECT_MSG_EQ (manager->GetDataTxVector (a, &hdr, packet, 1030).GetMode (), WifiMode ("VHTMCS24a"), "no recovery");
+
+  manager->ReportRxOk (a, &hdr, std::pow (10.0, (table.GetThresholdDb (0) - 1) / 10), ackMode);
+  NS_TEST_EXPECT_MSG_EQ (manager->GetDataTxVector (a, &hdr, packet, 1030).GetMode (), WifiMode ("VHTMCS0"), "no control mode at low SNR");
+}
+
+//-----------------------------------------------------------------------------
+class TabulatedErrorRateModelTest : public TestCase
+{
+public:
+  TabulatedErrorRateModelTest () : TestCase ("Tabulated chunk success rates against the analytic models")
+  {
+  }
+  virtual void DoRun (void);
+
+private:
+  /* Check the success rates of mode on the grid of the table, and return
+   * the mean difference from the analytic model off the grid */
+  double Compare (Ptr<TabulatedErrorRateModel> tabulated, WifiMode mode);
+};
+
+double
+TabulatedErrorRateModelTest::Compare (Ptr<TabulatedErrorRateModel> tabulated, WifiMode mode)
+{
+  static const uint32_t sizes[] = {1, 100, 1500, 12000, 100000, 2000000};
+  static const uint32_t nSizes = sizeof (sizes) / sizeof (sizes[0]);
+  Ptr<ErrorRateModel> model = tabulated->GetErrorRateModel ();
+  // The chunks are tabulated by powers of 2: on the SNRs of the grid the
+  // other sizes are exact for the models raising a bit success rate to the
+  // number of bits
+  for (double snrDb = -5; snrDb < 50; snrDb += 0.5)
+    {
+      double snr = std::pow (10.0, snrDb / 10);
+      for (uint32_t i = 0; i < nSizes; i++)
+        {
+          NS_TEST_EXPECT_MSG_EQ_TOL (tabulated->GetChunkSuccessRate (mode, snr, sizes[i]),
+                                     model->GetChunkSuccessRate (mode, snr, sizes[i]), 1e-6,
+                                     mode << " at " << snrDb << " dB for " << sizes[i] << " bits");
+        }
+    }
+  double meanError = 0;
+  uint32_t n = 0;
+  for (double snrDb = -5; snrDb < 50; snrDb += 0.0137)
+    {
+      double snr = std::pow (10.0, snrDb / 10);
+      for (uint32_t i = 0; i < nSizes; i++)
+        {
+          meanError += std::fabs (tabulated->GetChunkSuccessRate (mode, snr, sizes[i])
+                                  - model->GetChunkSuccessRate (mode, snr, sizes[i]));
+          n++;
+        }
+    }
+  return meanError / n;
+}
+
+void
+TabulatedErrorRateModelTest::DoRun (void)
+{
+  Ptr<TabulatedErrorRateModel> nist = CreateObject<TabulatedErrorRateModel> ();
+  nist->SetErrorRateModel (CreateObject<NistErrorRateModel> ());
+  WifiMode ofdmModes[] = {WifiPhy::GetOfdmRate6Mbps (), WifiPhy::GetOfdmRate24Mbps (), WifiPhy::GetOfdmRate54Mbps ()};
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      NS_TEST_EXPECT_MSG_LT (Compare (nist, ofdmModes[i]), 1e-4, "success rates of " << ofdmModes[i] << " off");
+    }
+
+  // The 60 GHz model steps every 0.1 dB: the tables are only close to it
+  // on average
+  Ptr<TabulatedErrorRateModel> dmg = CreateObject<TabulatedErrorRateModel> ();
+  dmg->SetErrorRateModel (CreateObject<SensitivityModel60GHz> ());
+  const char *dmgModes[] = {"VHTMCS0", "VHTMCS1", "VHTMCS12", "VHTMCS13a", "VHTMCS24a"};
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      NS_TEST_EXPECT_MSG_LT (Compare (dmg, WifiMode (dmgModes[i])), 1e-3, "success rates of " << dmgModes[i] << " off");
+    }
+
+  // Off the grid the analytic model answers
+  WifiMode mode = WifiMode ("VHTMCS24a");
+  NS_TEST_EXPECT_MSG_EQ (dmg->GetChunkSuccessRate (mode, std::pow (10.0, 7.5), 8000),
+                         dmg->GetErrorRateModel ()->GetChunkSuccessRate (mode, std::pow (10.0, 7.5), 8000),
+                         "SNR above the grid not passed to the model");
+  NS_TEST_EXPECT_MSG_EQ (dmg->GetChunkSuccessRate (mode, 3000, 5000000),
+                         dmg->GetErrorRateModel ()->GetChunkSuccessRate (mode, 3000, 5000000),
+                         "chunk above the grid not passed to the model");
+
+  // Validation keeps the largest error
+  dmg->SetAttribute ("Validate", BooleanValue (true));
+  dmg->SetAttribute ("Tolerance", DoubleValue (1));
+  NS_TEST_EXPECT_MSG_EQ (dmg->GetMaxError (), 0, "error before validating");
+  double maxError = 0;
+  for (double snrDb = 25; snrDb < 30; snrDb += 0.0137)
+    {
+      double snr = std::pow (10.0, snrDb / 10);
+      maxError = std::max (maxError, std::fabs (dmg->GetChunkSuccessRate (mode, snr, 8000)
+                                                - dmg->GetErrorRateModel ()->GetChunkSuccessRate (mode, snr, 8000)));
+    }
+  NS_TEST_EXPECT_MSG_GT (dmg->GetMaxError (), 0, "no error found while validating");
+  NS_TEST_EXPECT_MSG_EQ_TOL (dmg->GetMaxError (), maxError, 1e-12, "wrong largest error");
+}
+
+//-----------------------------------------------------------------------------
+class DmgErrorRateModelTest : public TestCase
+{
+public:
+  DmgErrorRateModelTest () : TestCase ("DMG LDPC codeword error rate curves")
+  {
+  }
+  virtual void DoRun (void);
+};
+
+void
+DmgErrorRateModelTest::DoRun (void)
+{
+  Ptr<DmgErrorRateModel> model = CreateObject<DmgErrorRateModel> ();
+  const char *modes[] = {"VHTMCS1", "VHTMCS5", "VHTMCS12", "VHTMCS13a", "VHTMCS24a"};
+  const double sensitivities[] = {-68, -62, -53, -66, -47};
+  double noiseDbm = 10 * std::log10 (1.3803e-23 * 290.0 * WifiPhy::GetVHTMCS1 ().GetBandwidth ()) + 30;
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      WifiMode mode = WifiMode (modes[i]);
+      // 1% PER for the coded bits of 4096 bytes at the sensitivity
+      uint32_t nbits = (uint64_t) 4096 * 8 * mode.GetPhyRate () / mode.GetDataRate ();
+      double snrDb = sensitivities[i] - noiseDbm;
+      NS_TEST_EXPECT_MSG_EQ_TOL (model->GetChunkSuccessRate (mode, std::pow (10.0, snrDb / 10), nbits), 0.99, 1e-3,
+                                 "wrong PER of " << modes[i] << " at its sensitivity");
+      NS_TEST_EXPECT_MSG_EQ_TOL (model->GetSnrDb (mode, 0.01, nbits), snrDb, 1e-3, "wrong threshold of " << modes[i]);
+      NS_TEST_EXPECT_MSG_LT (model->GetSnrDb (mode, 0.5, nbits), snrDb, "50% PER not below the sensitivity of " << modes[i]);
+      double previous = 0;
+      for (double x = snrDb - 3; x < snrDb + 3; x += 0.05)
+        {
+          double psr = model->GetChunkSuccessRate (mode, std::pow (10.0, x / 10), nbits);
+          NS_TEST_EXPECT_MSG_GT_OR_EQ (psr, previous, modes[i] << " not monotonic at " << x << " dB");
+          previous = psr;
+        }
+      NS_TEST_EXPECT_MSG_LT (previous, 1 + 1e-12, "success rate above 1");
+      NS_TEST_EXPECT_MSG_GT (previous, 0.9999, modes[i] << " not decoded 3 dB over its sensitivity");
+      NS_TEST_EXPECT_MSG_LT (model->GetChunkSuccessRate (mode, std::pow (10.0, (snrDb - 3) / 10), nbits), 1e-6,
+                             modes[i] << " decoded 3 dB under its sensitivity");
+    }
+
+  // Without margin the AWGN curves are 15 dB to the left
+  model->SetAttribute ("Margin", DoubleValue (0));
+  NS_TEST_EXPECT_MSG_EQ_TOL (model->GetCodewordErrorRate (WifiMode ("VHTMCS24a"), -47 - noiseDbm - 15),
+                             1 - std::pow (0.99, 1 / (4096 * 8 / (672 * 13.0 / 16))), 1e-9,
+                             "wrong codeword error rate of VHTMCS24a");
+
+  // The MCS table of a PHY with the model reads the same thresholds
+  Ptr<YansWifiPhy> phy = CreateDmgPhy (true);
+  phy->SetErrorRateModel (CreateObject<DmgErrorRateModel> ());
+  DmgMcsTable table;
+  table.Build (phy);
+  NS_TEST_EXPECT_MSG_EQ (table.LookupRxPower (-46.99).GetUniqueName (), "VHTMCS24a", "wrong mode above -47 dBm");
+  NS_TEST_EXPECT_MSG_EQ (table.LookupRxPower (-47.01).GetUniqueName (), "VHTMCS23a", "wrong mode below -47 dBm");
+  NS_TEST_EXPECT_MSG_EQ (table.LookupRxPower (-66.01).GetUniqueName (), "VHTMCS0", "no data mode below -66 dBm");
+}
+
+//-----------------------------------------------------------------------------
+class AmpduContainerTest : public TestCase
+{
+public:
+  AmpduContainerTest () : TestCase ("A-MPDU container against serialized aggregation")
+  {
+  }
+  virtual void DoRun (void);
+};
+
+void
+AmpduContainerTest::DoRun (void)
+{
+  Ptr<MpduStandardAggregator> aggregator = CreateObject<MpduStandardAggregator> ();
+  aggregator->SetAttribute ("MaxAmpduSize", UintegerValue (8000));
+  Ptr<AmpduContainer> ampdu = Create<AmpduContainer> ();
+  Ptr<Packet> aggregatedPacket = Create<Packet> ();
+  WifiMacHeader hdr;
+  hdr.SetType (WIFI_MAC_QOSDATA);
+  hdr.SetAddr1 (Mac48Address ("00:00:00:00:00:02"));
+  hdr.SetFragmentNumber (0);
+  uint32_t nAggregated = 0;
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      // every padding from 0 to 3 bytes
+      Ptr<Packet> payload = Create<Packet> (1000 + i);
+      hdr.SetSequenceNumber (i);
+      Ptr<Packet> mpdu = payload->Copy ();
+      mpdu->AddHeader (hdr);
+      mpdu->AddTrailer (WifiMacTrailer ());
+      NS_TEST_EXPECT_MSG_EQ (aggregator->CanBeAggregated (mpdu->GetSize (), Ptr<const AmpduContainer> (ampdu), 0),
+                             aggregator->CanBeAggregated (mpdu->GetSize (), aggregatedPacket, 0), "limit differs " << i);
+      bool added = aggregator->Aggregate (payload, hdr, ampdu);
+      NS_TEST_EXPECT_MSG_EQ (added, aggregator->Aggregate (mpdu, aggregatedPacket), "aggregation differs " << i);
+      NS_TEST_EXPECT_MSG_EQ (ampdu->GetSize (), aggregatedPacket->GetSize (), "size differs " << i);
+      nAggregated += added ? 1 : 0;
+    }
+  NS_TEST_ASSERT_MSG_EQ (ampdu->GetNMpdus (), nAggregated, "wrong number of MPDUs");
+  NS_TEST_EXPECT_MSG_LT (nAggregated, 10, "MaxAmpduSize not enforced");
+
+  Ptr<Packet> serialized = ampdu->Serialize ();
+  NS_TEST_ASSERT_MSG_EQ (serialized->GetSize (), aggregatedPacket->GetSize (), "serialized size differs");
+  std::vector<uint8_t> a (serialized->GetSize ()), b (serialized->GetSize ());
+  serialized->CopyData (&a[0], a.size ());
+  aggregatedPacket->CopyData (&b[0], b.size ());
+  NS_TEST_EXPECT_MSG_EQ ((a == b), true, "serialized bytes differ");
+
+  // The subframes handed to the PHY add up to the A-MPDU
+  uint32_t total = 0;
+  for (uint32_t i = 0; i < ampdu->GetNMpdus (); i++)
+    {
+      Ptr<Packet> subframe = ampdu->GetMpdu (i);
+      aggregator->AddHeaderAndPad (subframe, i + 1 == ampdu->GetNMpdus ());
+      NS_TEST_EXPECT_MSG_EQ (subframe->GetSize (), ampdu->GetSubframeSize (i), "subframe size differs " << i);
+      WifiMacHeader peeked;
+      AmpduContainer::PeekMacHeader (subframe, peeked);
+      NS_TEST_EXPECT_MSG_EQ (peeked.GetSequenceNumber (), i, "wrong MAC header " << i);
+      total += subframe->GetSize ();
+    }
+  NS_TEST_EXPECT_MSG_EQ (total, ampdu->GetSize (), "subframes do not add up");
+  // The payloads are referenced, not copied
+  NS_TEST_EXPECT_MSG_EQ (ampdu->GetPayload (0)->GetSize (), 1000, "payload modified");
+}
+
+//-----------------------------------------------------------------------------
+class AntennaBatchGainTest : public TestCase
+{
+public:
+  AntennaBatchGainTest () : TestCase ("Antenna gains toward a batch of directions")
+  {
+  }
+  virtual void DoRun (void);
+};
+
+void
+AntennaBatchGainTest::DoRun (void)
+{
+  std::vector<double> azimuth, elevation;
+  for (int i = -400; i <= 400; i++)
+    {
+      // up to 8*pi away from the pointing, on and around the beam edges
+      azimuth.push_back (i * M_PI / 50 + 1e-3 * (i % 3));
+      elevation.push_back ((i % 7) * 0.05);
+    }
+  uint32_t n = azimuth.size ();
+  std::vector<double> gains (n);
+
+  Ptr<ConeAntenna> cone = CreateObject<ConeAntenna> ();
+  cone->SetBeamwidthDegrees (30);
+  cone->SetAzimuthAngle (2.5);
+  cone->GetTxGainsDbi (&azimuth[0], &elevation[0], &gains[0], n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (gains[i], cone->GetTxGainDbi (azimuth[i], elevation[i]), "cone batch gain " << i);
+    }
+
+  Ptr<Measured2DAntenna> measured = CreateObject<Measured2DAntenna> ();
+  measured->SetAttribute ("LookupTableSize", UintegerValue (3600));
+  measured->SetAzimuthAngle (-1);
+  // By default the gains are interpolated between the measurements
+  Ptr<Measured2DAntenna> exact = CreateObject<Measured2DAntenna> ();
+  exact->SetAzimuthAngle (-1);
+  measured->GetRxGainsDbi (&azimuth[0], &elevation[0], &gains[0], n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (gains[i], measured->GetRxGainDbi (azimuth[i], elevation[i]), "measured batch gain " << i);
+      NS_TEST_EXPECT_MSG_EQ_TOL (gains[i], exact->GetRxGainDbi (azimuth[i], elevation[i]), 0.05,
+                                 "lookup table far from the measurements " << i);
+    }
+}
+
+//-----------------------------------------------------------------------------
+class BeamformingEngineTest : public TestCase
+{
+public:
+  BeamformingEngineTest () : TestCase ("Sector sweep and best sector cache of the BeamformingEngine")
+  {
+  }
+  virtual void DoRun (void);
+private:
+  void SectorSweep (Ptr<const MobilityModel> peer, Time duration);
+  Time m_sweepAirtime;
+};
+
+void
+BeamformingEngineTest::SectorSweep (Ptr<const MobilityModel>, Time duration)
+{
+  m_sweepAirtime += duration;
+}
+
+void
+BeamformingEngineTest::DoRun (void)
+{
+  Ptr<ConeAntenna> cone = CreateObject<ConeAntenna> ();
+  cone->SetBeamwidthDegrees (30);
+  cone->SetAzimuthAngle (1);
+  Ptr<ConstantPositionMobilityModel> node = CreateObject<ConstantPositionMobilityModel> ();
+  node->SetPosition (Vector (0, 0, 0));
+  Ptr<ConstantPositionMobilityModel> peer = CreateObject<ConstantPositionMobilityModel> ();
+  peer->SetPosition (Vector (10 * cos (1.66), 10 * sin (1.66), 0)); // 95 degrees
+
+  Ptr<BeamformingEngine> engine = CreateObject<BeamformingEngine> ();
+  engine->SetAntenna (cone);
+  engine->SetMobility (node);
+  engine->TraceConnectWithoutContext ("SectorSweep", MakeCallback (&BeamformingEngineTest::SectorSweep, this));
+  NS_TEST_ASSERT_MSG_EQ (engine->GetNSectors (), 12, "30 degrees sectors expected");
+  NS_TEST_EXPECT_MSG_EQ (engine->GetBestSector (peer), 3, "the 90 degrees sector is the closest to the peer");
+  NS_TEST_EXPECT_MSG_EQ (cone->GetAzimuthAngle (), 1, "the sweep must not steer the antenna of the node");
+  NS_TEST_EXPECT_MSG_EQ (engine->GetBestSector (peer), 3, "cached sector changed");
+  NS_TEST_EXPECT_MSG_EQ (engine->GetNSweeps (), 1, "a cached sector must not be swept again");
+
+  // the peer moves to -100 degrees
+  peer->SetPosition (Vector (10 * cos (-1.75), 10 * sin (-1.75), 0));
+  NS_TEST_EXPECT_MSG_EQ (engine->GetBestSector (peer), 9, "sector not updated after the peer moved");
+  NS_TEST_EXPECT_MSG_EQ (engine->GetNSweeps (), 2, "no sweep after the peer moved");
+  engine->InvalidatePeer (peer);
+  engine->GetBestSector (peer);
+  NS_TEST_EXPECT_MSG_EQ (engine->GetNSweeps (), 3, "no sweep after the link was blocked");
+  NS_TEST_EXPECT_MSG_EQ (m_sweepAirtime, MicroSeconds (16) * 36, "3 sweeps of 12 SSW frames expected");
+
+  // the engine moves to another node: the first one is no longer tracked
+  Ptr<ConstantPositionMobilityModel> other = CreateObject<ConstantPositionMobilityModel> ();
+  other->SetPosition (Vector (0, 0, 0));
+  engine->SetMobility (other);
+  engine->GetBestSector (peer);
+  node->SetPosition (Vector (1, 0, 0));
+  engine->GetBestSector (peer);
+  NS_TEST_EXPECT_MSG_EQ (engine->GetNSweeps (), 4, "the previous node of the engine is still tracked");
+  engine->Dispose ();
+
+  // the measured antenna is swept through its own copy as well
+  Ptr<Measured2DAntenna> measured = CreateObject<Measured2DAntenna> ();
+  measured->SetAzimuthAngle (1);
+  engine = CreateObject<BeamformingEngine> ();
+  engine->SetAntenna (measured);
+  engine->SetMobility (node);
+  engine->GetBestSector (peer);
+  NS_TEST_EXPECT_MSG_EQ (engine->GetNSweeps (), 1, "no sweep with the measured antenna");
+  NS_TEST_EXPECT_MSG_EQ (measured->GetAzimuthAngle (), 1, "the sweep must not steer the measured antenna of the node");
+  engine->Dispose ();
+}
+
+//-----------------------------------------------------------------------------
+class DmgBeaconIntervalUpdateTest : public TestCase
+{
+public:
+  DmgBeaconIntervalUpdateTest () : TestCase ("DMG Service Period update at the Beacon Interval boundary")
+  {
+  }
+  virtual void DoRun (void);
+
+private:
+  Ptr<DmgServicePeriod> CreateSp (Time start, Time stop);
+  void Update (std::vector<Ptr<DmgServicePeriod> > sps, bool expected);
+  void CheckNextSp (Time start, Time stop);
+
+  Ptr<DmgBeaconInterval> m_bi;
+};
+
+Ptr<DmgServicePeriod>
+DmgBeaconIntervalUpdateTest::CreateSp (Time start, Time stop)
+{
+  Ptr<DmgServicePeriod> sp = CreateObject<DmgServicePeriod> ();
+  sp->SetSpStart (start);
+  sp->SetSpStop (stop);
+  sp->SetSpDestination (Mac48Address ("00:00:00:00:00:01"));
+  sp->SetSpFlowSrcSinkIpv4Address (Ipv4Address ("10.0.0.1"), Ipv4Address ("10.0.0.2"));
+  sp->SetSpIfTx (true);
+  return sp;
+}
+
+void
+DmgBeaconIntervalUpdateTest::Update (std::vector<Ptr<DmgServicePeriod> > sps, bool expected)
+{
+  NS_TEST_EXPECT_MSG_EQ (m_bi->ScheduleSpUpdate (sps), expected, "unexpected result of ScheduleSpUpdate");
+}
+
+void
+DmgBeaconIntervalUpdateTest::CheckNextSp (Time start, Time stop)
+{
+  NS_TEST_EXPECT_MSG_EQ (m_bi->GetNextSpStart (), start, "wrong next SP start");
+  NS_TEST_EXPECT_MSG_EQ (m_bi->GetNextSpStop (), stop, "wrong next SP stop");
+}
+
+void
+DmgBeaconIntervalUpdateTest::DoRun (void)
+{
+  m_bi = CreateObject<DmgBeaconInterval> ();
+  m_bi->SetBiDuration (MilliSeconds (100));
+  m_bi->AddSp (CreateSp (MilliSeconds (60), MilliSeconds (80)));
+
+  std::vector<Ptr<DmgServicePeriod> > same;
+  same.push_back (CreateSp (MilliSeconds (60), MilliSeconds (80)));
+  std::vector<Ptr<DmgServicePeriod> > sps;
+  sps.push_back (CreateSp (MilliSeconds (20), MilliSeconds (40)));
+
+  Simulator::Schedule (MilliSeconds (10), &DmgBeaconIntervalUpdateTest::Update, this, same, false);
+  Simulator::Schedule (MilliSeconds (30), &DmgBeaconIntervalUpdateTest::Update, this, sps, true);
+  // The current Beacon Interval completes with the old schedule
+  Simulator::Schedule (MilliSeconds (50), &DmgBeaconIntervalUpdateTest::CheckNextSp,
+                       this, MilliSeconds (60), MilliSeconds (80));
+  Simulator::Schedule (MilliSeconds (110), &DmgBeaconIntervalUpdateTest::CheckNextSp,
+                       this, MilliSeconds (120), MilliSeconds (140));
+  Simulator::Run ();
+  Simulator::Destroy ();
+  m_bi = 0;
+}
+
+//-----------------------------------------------------------------------------
+/* The incremental re-planning of UpdateFlowDemand and NotifyLinkChange must
+ * give the rates of a full FlowRateProgressiveFilling with the same demands
+ * and links. */
+class DmgControllerReplanTest : public TestCase
+{
+public:
+  DmgControllerReplanTest () : TestCase ("DMG controller incremental re-planning against a full one")
+  {
+  }
+  virtual void DoRun (void);
+
+private:
+  std::vector<double> FullReplan (std::vector<double> flowsDmd);
+  void CheckRates (std::vector<double> rates, std::vector<double> expected, std::string what);
+
+  Ptr<DmgAlmightyController> m_ctrl;
+};
+
+std::vector<double>
+DmgControllerReplanTest::FullReplan (std::vector<double> flowsDmd)
+{
+  // Steps of 300 Mb/s: flows 1 and 2 go from 900 to 1200 Mb/s at once
+  return m_ctrl->FlowRateProgressiveFilling (flowsDmd, 300, 1500, 0.1, 16);
+}
+
+void
+DmgControllerReplanTest::CheckRates (std::vector<double> rates, std::vector<double> expected, std::string what)
+{
+  NS_TEST_ASSERT_MSG_EQ (rates.size (), expected.size (), what << ": wrong number of flows");
+  for (uint32_t fIdx = 0; fIdx < rates.size (); fIdx++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (rates[fIdx], expected[fIdx], what << ": rate of flow " << fIdx);
+    }
+}
+
+void
+DmgControllerReplanTest::DoRun (void)
+{
+  // Flows 0-3-4, 0-3-1 and 0-3-1-2, from the gateway 0. The long link 1-2
+  // makes the cliques of nodes 1 and 3 saturate in the same filling step,
+  // where the order of the cliques decides the rates
+  NodeContainer nodes;
+  nodes.Create (5);
+  double positions[5][2] = {{0, 0}, {20, 0}, {20, 80}, {10, 0}, {10, 10}};
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+      mobility->SetPosition (Vector (positions[i][0], positions[i][1], 0));
+      nodes.Get (i)->AggregateObject (mobility);
+    }
+
+  YansWifiChannelHelper channelHelper;
+  channelHelper.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
+  channelHelper.AddPropagationLoss ("ns3::FriisLoSPropagationLossModel", "Frequency", DoubleValue (60.48e9));
+  YansWifiPhyHelper phy = YansWifiPhyHelper::Default ();
+  phy.SetChannel (channelHelper.Create ());
+  phy.SetErrorRateModel ("ns3::SensitivityModel60GHz");
+  WifiHelper wifi = WifiHelper::Default ();
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211ad);
+  wifi.SetRemoteStationManager ("ns3::DmgDestinationFixedWifiManager");
+  DmgWifiMacHelper mac = DmgWifiMacHelper::Default ();
+  mac.SetType ("ns3::DmgWifiMac");
+  NetDeviceContainer devices = wifi.Install (phy, mac, nodes);
+  for (uint32_t i = 0; i < devices.GetN (); i++)
+    {
+      Ptr<WifiNetDevice> dev = devices.Get (i)->GetObject<WifiNetDevice> ();
+      Ptr<ConeAntenna> antenna = CreateObject<ConeAntenna> ();
+      antenna->SetGainDbi (15);
+      Ptr<DmgAntennaController> antCtrl = CreateObject<DmgAntennaController> ();
+      antCtrl->SetAntenna (antenna);
+      antCtrl->SetPhy (dev->GetPhy ());
+      Ptr<DmgWifiMac> dmgMac = dev->GetMac ()->GetObject<DmgWifiMac> ();
+      dmgMac->SetDmgAntennaController (antCtrl);
+      dmgMac->SetDmgBeaconInterval (CreateObject<DmgBeaconInterval> ());
+      dev->GetPhy ()->GetObject<YansWifiPhy> ()->SetRxNoiseFigure (0);
+    }
+  InternetStackHelper stack;
+  stack.Install (nodes);
+  Ipv4AddressHelper address;
+  address.SetBase ("192.168.1.0", "255.255.255.0");
+  address.Assign (devices);
+
+  std::vector<std::vector<uint32_t> > paths (3);
+  uint32_t path0[] = {0, 3, 4};
+  uint32_t path1[] = {0, 3, 1};
+  uint32_t path2[] = {0, 3, 1, 2};
+  paths[0].assign (path0, path0 + 3);
+  paths[1].assign (path1, path1 + 3);
+  paths[2].assign (path2, path2 + 4);
+  m_ctrl = CreateObject<DmgAlmightyController> ();
+  m_ctrl->SetSimInterference (false);
+  m_ctrl->SetGw (0);
+  m_ctrl->SetMeshNodes (&nodes);
+  m_ctrl->SetFlowsPath (paths);
+  m_ctrl->ConfigureCliques ();
+  m_ctrl->ConfigureHierarchy ();
+  m_ctrl->ConfigureWifiManager ();
+  m_ctrl->SetBiDuration (1000000);
+  m_ctrl->SetBiOverheadFraction (0.1);
+
+  // The layers do not stop the simulation when a clique overflows
+  std::vector<double> flowsDmd (3, 3000);
+  flowsDmd[0] = 10;
+  FullReplan (flowsDmd);
+  m_ctrl->ConfigureScheduleInLayers ();
+  m_ctrl->ConfigureBeaconIntervals ();
+
+  // The search from flow 0 reaches the clique of node 3 before the one of
+  // node 1, which shares the flows 1 and 2 with it
+  flowsDmd[0] = 20;
+  std::vector<double> rates = m_ctrl->UpdateFlowDemand (flowsDmd);
+  CheckRates (rates, FullReplan (flowsDmd), "demand update");
+
+  rates = m_ctrl->NotifyLinkChange (1, 2, false);
+  CheckRates (rates, FullReplan (flowsDmd), "link down");
+  NS_TEST_EXPECT_MSG_EQ (rates[2], 0, "flow 2 crosses a link that is down");
+
+  rates = m_ctrl->NotifyLinkChange (2, 1, true);
+  CheckRates (rates, FullReplan (flowsDmd), "link up");
+  NS_TEST_EXPECT_MSG_GT (rates[2], 0, "flow 2 not restored");
+
+  Simulator::Destroy ();
+  m_ctrl = 0;
+}
+
+//-----------------------------------------------------------------------------
+/* The sector sweeps are charged once, to the BI in which they happen: the
+ * SPs of the BI of the beam training leave room for it, the later ones do
+ * not, and a sweep on the data path is charged to its own BI only. */
+class DmgControllerSweepChargeTest : public TestCase
+{
+public:
+  DmgControllerSweepChargeTest () : TestCase ("DMG controller charges each sector sweep to its BI")
+  {
+  }
+  virtual void DoRun (void);
+
+private:
+  /* Earliest SP start of the devices */
+  Time GetFirstSpStart (void);
+
+  NetDeviceContainer m_devices;
+};
+
+Time
+DmgControllerSweepChargeTest::GetFirstSpStart (void)
+{
+  Time first = Seconds (1);
+  for (uint32_t i = 0; i < m_devices.GetN (); i++)
+    {
+      std::vector<Ptr<DmgServicePeriod> > sps = m_devices.Get (i)->GetObject<WifiNetDevice> ()->
+        GetMac ()->GetObject<DmgWifiMac> ()->GetDmgBeaconInterval ()->GetSps ();
+      for (uint32_t spIdx = 0; spIdx < sps.size (); spIdx++)
+        {
+          first = std::min (first, sps[spIdx]->GetSpStart ());
+        }
+    }
+  return first;
+}
+
+void
+DmgControllerSweepChargeTest::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (3);
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+      mobility->SetPosition (Vector (10 * i, 0, 0));
+      nodes.Get (i)->AggregateObject (mobility);
+    }
+
+  YansWifiChannelHelper channelHelper;
+  channelHelper.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
+  channelHelper.AddPropagationLoss ("ns3::FriisLoSPropagationLossModel", "Frequency", DoubleValue (60.48e9));
+  YansWifiPhyHelper phy = YansWifiPhyHelper::Default ();
+  phy.SetChannel (channelHelper.Create ());
+  phy.SetErrorRateModel ("ns3::SensitivityModel60GHz");
+  WifiHelper wifi = WifiHelper::Default ();
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211ad);
+  wifi.SetRemoteStationManager ("ns3::DmgDestinationFixedWifiManager");
+  DmgWifiMacHelper mac = DmgWifiMacHelper::Default ();
+  mac.SetType ("ns3::DmgWifiMac");
+  m_devices = wifi.Install (phy, mac, nodes);
+  std::vector<Ptr<BeamformingEngine> > engines;
+  for (uint32_t i = 0; i < m_devices.GetN (); i++)
+    {
+      Ptr<WifiNetDevice> dev = m_devices.Get (i)->GetObject<WifiNetDevice> ();
+      Ptr<ConeAntenna> antenna = CreateObject<ConeAntenna> ();
+      antenna->SetGainDbi (15);
+      Ptr<DmgAntennaController> antCtrl = CreateObject<DmgAntennaController> ();
+      antCtrl->SetAntenna (antenna);
+      antCtrl->SetPhy (dev->GetPhy ());
+      Ptr<BeamformingEngine> engine = CreateObject<BeamformingEngine> ();
+      engine->SetAttribute ("Sectors", UintegerValue (4));
+      antCtrl->SetBeamformingEngine (engine);
+      engines.push_back (engine);
+      Ptr<DmgWifiMac> dmgMac = dev->GetMac ()->GetObject<DmgWifiMac> ();
+      dmgMac->SetDmgAntennaController (antCtrl);
+      dmgMac->SetDmgBeaconInterval (CreateObject<DmgBeaconInterval> ());
+    }
+  InternetStackHelper stack;
+  stack.Install (nodes);
+  Ipv4AddressHelper address;
+  address.SetBase ("192.168.1.0", "255.255.255.0");
+  address.Assign (m_devices);
+
+  std::vector<std::vector<uint32_t> > paths (2);
+  uint32_t path0[] = {0, 1};
+  uint32_t path1[] = {0, 1, 2};
+  paths[0].assign (path0, path0 + 2);
+  paths[1].assign (path1, path1 + 3);
+  Ptr<DmgAlmightyController> ctrl = CreateObject<DmgAlmightyController> ();
+  ctrl->SetSimInterference (false);
+  ctrl->SetGw (0);
+  ctrl->SetMeshNodes (&nodes);
+  ctrl->SetFlowsPath (paths);
+  ctrl->ConfigureCliques ();
+  ctrl->ConfigureHierarchy ();
+  ctrl->ConfigureWifiManager ();
+  ctrl->SetBiDuration (1000000);
+  ctrl->SetBiOverheadFraction (0.1);
+  ctrl->FlowRateProgressiveFilling (std::vector<double> (2, 1000), 100, 1500, 0.1, 16);
+  ctrl->ConfigureScheduleInLayers ();
+  ctrl->ConfigureBeaconIntervals ();
+
+  uint32_t sweeps = 0;
+  for (uint32_t i = 0; i < engines.size (); i++)
+    {
+      sweeps += engines[i]->GetNSweeps ();
+    }
+  Time sweepDuration = engines[0]->GetSweepDuration ();
+  NS_TEST_ASSERT_MSG_GT (sweeps, 0, "the beam training must sweep");
+  NS_TEST_EXPECT_MSG_EQ (NanoSeconds (ctrl->GetBiSweepOverheadNs (0)), sweepDuration * (int64_t) sweeps,
+                         "the sweeps of the training are not charged to the first BI");
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (GetFirstSpStart (), NanoSeconds (100000) + sweepDuration * (int64_t) sweeps,
+                               "the SPs of the first BI overlap the sweeps");
+
+  // Node 2 moves in the third BI: its link is swept again on the data path
+  Simulator::Schedule (MicroSeconds (2050), &ConstantPositionMobilityModel::SetPosition,
+                       nodes.Get (2)->GetObject<ConstantPositionMobilityModel> (), Vector (20, 1, 0));
+  Simulator::Stop (MicroSeconds (1500));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (GetFirstSpStart (), NanoSeconds (100000), "the sweeps are charged to the second BI");
+  NS_TEST_EXPECT_MSG_EQ (ctrl->GetBiSweepOverheadNs (1), 0, "no sweep expected in the second BI");
+
+  Simulator::Stop (MicroSeconds (4500));
+  Simulator::Run ();
+  uint64_t dataPathSweepNs = 0;
+  for (uint64_t bi = 2; bi < 6; bi++)
+    {
+      dataPathSweepNs += ctrl->GetBiSweepOverheadNs (bi);
+    }
+  NS_TEST_EXPECT_MSG_GT (dataPathSweepNs, 0, "the data path sweeps are not charged");
+  NS_TEST_EXPECT_MSG_EQ (GetFirstSpStart (), NanoSeconds (100000), "the data path sweeps are charged to the later BIs");
+
+  Simulator::Destroy ();
+}
+
+//-----------------------------------------------------------------------------
+/* The same A-MPDUs sent one subframe at a time, as MacLow does, and as whole
+ * PPDUs (SP fast-forward) must deliver the same fraction of MPDUs, each
+ * subframe at the same time. */
+class DmgSpFastForwardTest : public TestCase
+{
+public:
+  DmgSpFastForwardTest () : TestCase ("DMG SP fast-forward against per subframe reception")
+  {
+  }
+  virtual void DoRun (void);
+
+private:
+  struct Stats
+  {
+    uint32_t received;
+    /* Delivery delay of the subframes, by A-MPDU send time (ns) and number
+     * of MPDUs left in the A-MPDU (AmpduTag) */
+    std::map<std::pair<int64_t, uint8_t>, Time> delays;
+  };
+  Ptr<YansWifiPhy> CreatePhy (Ptr<YansWifiChannel> channel, Vector position, Mac48Address address);
+  std::vector<Ptr<const Packet> > CreateAmpdu (void);
+  void SendAmpdu (bool ppdu);
+  void SendSubframe (Ptr<const Packet> subframe, uint8_t packetType, WifiPreamble preamble);
+  void Receive (Ptr<Packet> packet, double snr, WifiMode mode, enum WifiPreamble preamble);
+  Stats Run (bool ppdu);
+
+  static const uint32_t N_AMPDUS = 200;
+  static const uint32_t N_MPDUS = 16;
+
+  Ptr<YansWifiPhy> m_tx;
+  Ptr<YansWifiPhy> m_rx;
+  WifiTxVector m_txVector;
+  Time m_sent;
+  Time m_ppduDuration;
+  Stats m_stats;
+};
+
+Ptr<YansWifiPhy>
+DmgSpFastForwardTest::CreatePhy (Ptr<YansWifiChannel> channel, Vector position, Mac48Address address)
+{
+  Ptr<YansWifiPhy> phy = CreateDmgPhy (false);
+  Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+  mobility->SetPosition (position);
+  phy->SetMobility (mobility);
+  phy->SetAddress (address);
+  // 1e-5 per bit: about 11% of the 1500 bytes subframes are lost
+  phy->SetFrameMinBer (1e-5);
+  Ptr<ConeAntenna> antenna = CreateObject<ConeAntenna> ();
+  antenna->SetBeamwidthDegrees (30);
+  Ptr<DmgAntennaController> antCtrl = CreateObject<DmgAntennaController> ();
+  antCtrl->SetPhy (phy);
+  antCtrl->SetAntenna (antenna);
+  phy->SetDmgAntennaController (antCtrl);
+  phy->SetChannel (channel);
+  return phy;
+}
+
+std::vector<Ptr<const Packet> >
+DmgSpFastForwardTest::CreateAmpdu (void)
+{
+  Ptr<MpduStandardAggregator> aggregator = CreateObject<MpduStandardAggregator> ();
+  WifiMacHeader hdr;
+  hdr.SetType (WIFI_MAC_QOSDATA);
+  hdr.SetAddr1 (m_rx->GetAddress ());
+  hdr.SetAddr2 (m_tx->GetAddress ());
+  hdr.SetFragmentNumber (0);
+  std::vector<Ptr<const Packet> > subframes;
+  for (uint32_t i = 0; i < N_MPDUS; i++)
+    {
+      hdr.SetSequenceNumber (i);
+      Ptr<Packet> subframe = Create<Packet> (1500);
+      subframe->AddHeader (hdr);
+      subframe->AddTrailer (WifiMacTrailer ());
+      aggregator->AddHeaderAndPad (subframe, i + 1 == N_MPDUS);
+      AmpduTag tag;
+      tag.SetAmpdu (true);
+      tag.SetNoOfMpdus (N_MPDUS - i);
+      subframe->AddPacketTag (tag);
+      subframes.push_back (subframe);
+    }
+  return subframes;
+}
+
+void
+DmgSpFastForwardTest::SendSubframe (Ptr<const Packet> subframe, uint8_t packetType, WifiPreamble preamble)
+{
+  m_tx->SendPacket (subframe, m_txVector, preamble, packetType);
+}
+
+void
+DmgSpFastForwardTest::SendAmpdu (bool ppdu)
+{
+  m_sent = Simulator::Now ();
+  std::vector<Ptr<const Packet> > subframes = CreateAmpdu ();
+  if (ppdu)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_tx->SendPpdu (subframes, m_txVector, WIFI_PREAMBLE_LONG), true, "PPDU not sent");
+      return;
+    }
+  // As MacLow::ForwardDown
+  Time delay = Seconds (0);
+  WifiPreamble preamble = WIFI_PREAMBLE_LONG;
+  for (uint32_t i = 0; i < N_MPDUS; i++)
+    {
+      uint8_t packetType = (i + 1 == N_MPDUS) ? 2 : 1;
+      Simulator::Schedule (delay, &DmgSpFastForwardTest::SendSubframe, this, subframes[i], packetType, preamble);
+      delay += m_tx->CalculateTxDuration (subframes[i]->GetSize (), m_txVector, preamble, m_tx->GetFrequency (), packetType, 0) + NanoSeconds (1);
+      preamble = WIFI_PREAMBLE_NONE;
+    }
+}
+
+void
+DmgSpFastForwardTest::Receive (Ptr<Packet> packet, double, WifiMode, enum WifiPreamble)
+{
+  Time delay = Simulator::Now () - m_sent;
+  m_stats.received++;
+  AmpduTag tag;
+  packet->PeekPacketTag (tag);
+  m_stats.delays[std::make_pair (m_sent.GetNanoSeconds (), tag.GetNoOfMpdus ())] = delay;
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (delay, m_ppduDuration + MicroSeconds (1), "subframe delivered after its PPDU");
+}
+
+DmgSpFastForwardTest::Stats
+DmgSpFastForwardTest::Run (bool ppdu)
+{
+  Ptr<YansWifiChannel> channel = CreateObject<YansWifiChannel> ();
+  channel->SetAttribute ("DmgMode", BooleanValue (true));
+  channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+  Ptr<FriisPropagationLossModel> loss = CreateObject<FriisPropagationLossModel> ();
+  loss->SetFrequency (60.48e9);
+  channel->SetPropagationLossModel (loss);
+  m_tx = CreatePhy (channel, Vector (0, 0, 0), Mac48Address ("00:00:00:00:00:01"));
+  m_rx = CreatePhy (channel, Vector (10, 0, 0), Mac48Address ("00:00:00:00:00:02"));
+  m_tx->AssignStreams (1);
+  m_rx->AssignStreams (2);
+  m_rx->SetReceiveOkCallback (MakeCallback (&DmgSpFastForwardTest::Receive, this));
+  m_txVector = WifiTxVector (m_tx->GetMode (4), 0, 0, false, 1, 0, false);
+  m_ppduDuration = Seconds (0);
+  std::vector<Ptr<const Packet> > subframes = CreateAmpdu ();
+  WifiPreamble preamble = WIFI_PREAMBLE_LONG;
+  for (uint32_t i = 0; i < N_MPDUS; i++)
+    {
+      m_ppduDuration += m_tx->CalculateTxDuration (subframes[i]->GetSize (), m_txVector, preamble, m_tx->GetFrequency (), (i + 1 == N_MPDUS) ? 2 : 1, 1);
+      preamble = WIFI_PREAMBLE_NONE;
+    }
+
+  m_stats.received = 0;
+  m_stats.delays.clear ();
+  for (uint32_t i = 0; i < N_AMPDUS; i++)
+    {
+      Simulator::Schedule (i * 2 * m_ppduDuration, &DmgSpFastForwardTest::SendAmpdu, this, ppdu);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+  m_tx = 0;
+  m_rx = 0;
+  return m_stats;
+}
+
+void
+DmgSpFastForwardTest::DoRun (void)
+{
+  Stats full = Run (false);
+  Stats fast = Run (true);
+  double sent = N_AMPDUS * N_MPDUS;
+  NS_TEST_ASSERT_MSG_GT (full.received, 0, "nothing received");
+  NS_TEST_EXPECT_MSG_LT (full.received, sent, "no loss at the minimum BER");
+  NS_TEST_EXPECT_MSG_EQ_TOL (fast.received / sent, full.received / sent, 0.03, "delivered fraction differs");
+  // The losses differ: compare the subframes delivered by both models
+  uint32_t compared = 0;
+  for (std::map<std::pair<int64_t, uint8_t>, Time>::const_iterator it = fast.delays.begin (); it != fast.delays.end (); ++it)
+    {
+      std::map<std::pair<int64_t, uint8_t>, Time>::const_iterator f = full.delays.find (it->first);
+      if (f != full.delays.end ())
+        {
+          NS_TEST_EXPECT_MSG_EQ (it->second, f->second, "subframe " << (uint32_t) it->first.second << " of the A-MPDU sent at "
+                                 << it->first.first << "ns delivered at another time");
+          compared++;
+        }
+    }
+  NS_TEST_EXPECT_MSG_GT (compared, sent / 2, "too few subframes delivered by both models");
+}
+
+//-----------------------------------------------------------------------------
+/* DMG devices of nodes 10 m apart on a line, with A-MPDUs, the SPs the
+ * controller schedules for the flows of paths and the Block Ack agreements
+ * of their links. attribute is a boolean attribute of DmgWifiMac to enable.
+ * The controller keeps nodes. */
+static NetDeviceContainer
+InstallDmgLine (NodeContainer *nodes, std::vector<std::vector<uint32_t> > paths,
+                std::string attribute, Ptr<DmgAlmightyController> ctrl)
+{
+  for (uint32_t i = 0; i < nodes->GetN (); i++)
+    {
+      Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+      mobility->SetPosition (Vector (10 * i, 0, 0));
+      nodes->Get (i)->AggregateObject (mobility);
+    }
+
+  YansWifiChannelHelper channelHelper;
+  channelHelper.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
+  channelHelper.AddPropagationLoss ("ns3::FriisLoSPropagationLossModel", "Frequency", DoubleValue (60.48e9));
+  YansWifiPhyHelper phy = YansWifiPhyHelper::Default ();
+  phy.SetChannel (channelHelper.Create ());
+  phy.SetErrorRateModel ("ns3::SensitivityModel60GHz");
+  WifiHelper wifi = WifiHelper::Default ();
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211ad);
+  wifi.SetRemoteStationManager ("ns3::DmgDestinationFixedWifiManager");
+  DmgWifiMacHelper mac = DmgWifiMacHelper::Default ();
+  mac.SetType ("ns3::DmgWifiMac", attribute, BooleanValue (true));
+  mac.SetBlockAckThresholdForAc (AC_BE, 1);
+  mac.SetMpduAggregatorForAc (AC_BE, "ns3::MpduStandardAggregator", "MaxAmpduSize", UintegerValue (64 * 1500));
+  NetDeviceContainer devices = wifi.Install (phy, mac, *nodes);
+  for (uint32_t i = 0; i < devices.GetN (); i++)
+    {
+      Ptr<WifiNetDevice> dev = devices.Get (i)->GetObject<WifiNetDevice> ();
+      Ptr<ConeAntenna> antenna = CreateObject<ConeAntenna> ();
+      antenna->SetGainDbi (15);
+      Ptr<DmgAntennaController> antCtrl = CreateObject<DmgAntennaController> ();
+      antCtrl->SetAntenna (antenna);
+      antCtrl->SetPhy (dev->GetPhy ());
+      Ptr<DmgWifiMac> dmgMac = dev->GetMac ()->GetObject<DmgWifiMac> ();
+      dmgMac->SetDmgAntennaController (antCtrl);
+      dmgMac->SetDmgBeaconInterval (CreateObject<DmgBeaconInterval> ());
+      dev->GetPhy ()->GetObject<YansWifiPhy> ()->SetRxNoiseFigure (0);
+    }
+  InternetStackHelper stack;
+  stack.Install (*nodes);
+  Ipv4AddressHelper address;
+  address.SetBase ("192.168.1.0", "255.255.255.0");
+  address.Assign (devices);
+
+  ctrl->SetSimInterference (false);
+  ctrl->SetGw (0);
+  ctrl->SetMeshNodes (nodes);
+  ctrl->SetFlowsPath (paths);
+  ctrl->ConfigureCliques ();
+  ctrl->ConfigureHierarchy ();
+  ctrl->ConfigureWifiManager ();
+  ctrl->FlowRateProgressiveFilling (std::vector<double> (paths.size (), 1000), 100, 1500, 0.1, 16);
+  ctrl->SetBiDuration (1000000);
+  ctrl->SetBiOverheadFraction (0.1);
+  ctrl->ConfigureSchedule ();
+  ctrl->ConfigureBeaconIntervals ();
+  ctrl->CreateBlockAckAgreement ();
+  return devices;
+}
+
+/* A packet as DmgWifiMac::Enqueue expects it: LLC/SNAP and IPv4 headers */
+static Ptr<Packet>
+CreateIpv4Packet (Ipv4Address source, Ipv4Address destination, uint16_t id, uint32_t size)
+{
+  Ptr<Packet> packet = Create<Packet> (size);
+  Ipv4Header ipv4;
+  ipv4.SetSource (source);
+  ipv4.SetDestination (destination);
+  ipv4.SetIdentification (id);
+  ipv4.SetProtocol (17);
+  ipv4.SetPayloadSize (size);
+  packet->AddHeader (ipv4);
+  LlcSnapHeader llc;
+  llc.SetType (0x0800);
+  packet->AddHeader (llc);
+  return packet;
+}
+
+/* The MAC header of a frame seen by a PHY trace, A-MPDU subframe or not.
+ * Return false for the subframes but the last of an A-MPDU */
+static bool
+PeekMpduHeader (Ptr<const Packet> packet, WifiMacHeader *hdr)
+{
+  Ptr<Packet> copy = packet->Copy ();
+  AmpduTag tag;
+  bool last = true;
+  if (copy->PeekPacketTag (tag))
+    {
+      AmpduSubframeHeader subframeHdr;
+      copy->RemoveHeader (subframeHdr);
+      last = (tag.GetNoOfMpdus () == 1);
+    }
+  copy->PeekHeader (*hdr);
+  return last;
+}
+
+/* With SP tail packing, the MPDUs that fill the end of the SPs of a link are
+ * the heads of its other flows: every flow is still delivered in the order
+ * of its packets. */
+class DmgSpTailPackingTest : public TestCase
+{
+public:
+  DmgSpTailPackingTest () : TestCase ("DMG SP tail packing keeps the order of each flow")
+  {
+  }
+  virtual void DoRun (void);
+
+private:
+  void Send (uint32_t flowIdx);
+  void Receive (Ptr<Packet> packet, Mac48Address from, Mac48Address to);
+  void NotifySpStats (const DmgSpStats &stats);
+
+  Ptr<DmgWifiMac> m_source;
+  Mac48Address m_nextHop;
+  Ipv4Address m_sourceIp;
+  std::vector<Ipv4Address> m_sinkIps;
+  std::vector<uint16_t> m_sent;
+  /* Identification of the next packet expected, by sink */
+  std::map<Ipv4Address, uint16_t> m_expected;
+  uint32_t m_received;
+  uint32_t m_reordered;
+  uint32_t m_packed;
+};
+
+void
+DmgSpTailPackingTest::Send (uint32_t flowIdx)
+{
+  // One large packet out of three: the smaller ones queued after it would
+  // fit in the tails it does not fit in
+  uint16_t id = m_sent[flowIdx]++;
+  uint32_t size = (id % 3 == 0) ? 1400 : 200;
+  m_source->Enqueue (CreateIpv4Packet (m_sourceIp, m_sinkIps[flowIdx], id, size), m_nextHop);
+}
+
+void
+DmgSpTailPackingTest::Receive (Ptr<Packet> packet, Mac48Address, Mac48Address)
+{
+  Ptr<Packet> copy = packet->Copy ();
+  LlcSnapHeader llc;
+  copy->RemoveHeader (llc);
+  Ipv4Header ipv4;
+  copy->RemoveHeader (ipv4);
+  std::map<Ipv4Address, uint16_t>::iterator expected = m_expected.find (ipv4.GetDestination ());
+  if (expected != m_expected.end () && ipv4.GetIdentification () < expected->second)
+    {
+      m_reordered++;
+    }
+  m_expected[ipv4.GetDestination ()] = ipv4.GetIdentification () + 1;
+  m_received++;
+}
+
+void
+DmgSpTailPackingTest::NotifySpStats (const DmgSpStats &stats)
+{
+  m_packed += stats.nPacked;
+}
+
+void
+DmgSpTailPackingTest::DoRun (void)
+{
+  // Flows 0-1 and 0-1-2 share the link 0-1
+  NodeContainer nodes;
+  nodes.Create (3);
+  std::vector<std::vector<uint32_t> > paths (2);
+  uint32_t path0[] = {0, 1};
+  uint32_t path1[] = {0, 1, 2};
+  paths[0].assign (path0, path0 + 2);
+  paths[1].assign (path1, path1 + 3);
+  NetDeviceContainer devices = InstallDmgLine (&nodes, paths, "SpTailPacking", CreateObject<DmgAlmightyController> ());
+
+  m_source = devices.Get (0)->GetObject<WifiNetDevice> ()->GetMac ()->GetObject<DmgWifiMac> ();
+  m_source->TraceConnectWithoutContext ("SpStats", MakeCallback (&DmgSpTailPackingTest::NotifySpStats, this));
+  Ptr<DmgWifiMac> nextHop = devices.Get (1)->GetObject<WifiNetDevice> ()->GetMac ()->GetObject<DmgWifiMac> ();
+  nextHop->SetForwardUpCallback (MakeCallback (&DmgSpTailPackingTest::Receive, this));
+  m_nextHop = nextHop->GetAddress ();
+  m_sourceIp = nodes.Get (0)->GetObject<Ipv4> ()->GetAddress (1, 0).GetLocal ();
+  m_sinkIps.clear ();
+  for (uint32_t i = 1; i < nodes.GetN (); i++)
+    {
+      m_sinkIps.push_back (nodes.Get (i)->GetObject<Ipv4> ()->GetAddress (1, 0).GetLocal ());
+    }
+  m_sent.assign (m_sinkIps.size (), 0);
+  m_expected.clear ();
+  m_received = 0;
+  m_reordered = 0;
+  m_packed = 0;
+
+  // About 1.3 Gb/s per flow: the SPs of both flows end backlogged
+  for (Time t = Seconds (0); t < MilliSeconds (5); t += MicroSeconds (5))
+    {
+      for (uint32_t flowIdx = 0; flowIdx < m_sinkIps.size (); flowIdx++)
+        {
+          Simulator::Schedule (t, &DmgSpTailPackingTest::Send, this, flowIdx);
+        }
+    }
+  Simulator::Stop (MilliSeconds (6));
+  Simulator::Run ();
+  Simulator::Destroy ();
+  m_source = 0;
+
+  NS_TEST_EXPECT_MSG_GT (m_received, 0, "nothing delivered");
+  NS_TEST_EXPECT_MSG_GT (m_packed, 0, "no SP tail packed");
+  NS_TEST_EXPECT_MSG_EQ (m_reordered, 0, "packets delivered out of the order of their flow");
+}
+
+//-----------------------------------------------------------------------------
+/* Reverse direction grants: the A-MPDUs of the SP owner grant the rest of
+ * the SP, never beyond it. The destination uses a grant with one PPDU of its
+ * own, which the owner acknowledges, or returns it when it has nothing to
+ * send. The owner is notified of the BlockAck of its A-MPDU once, at the
+ * end of the grant, even when the reverse PPDU is lost or the SP is cut
+ * short. */
+class DmgReverseDirectionTest : public TestCase
+{
+public:
+  DmgReverseDirectionTest () : TestCase ("DMG reverse direction grants in the SPs")
+  {
+  }
+  virtual void DoRun (void);
+
+private:
+  enum Scenario
+  {
+    GRANT,
+    LOST,   // the first reverse PPDU is lost
+    CUT     // the SP ends during the first grant used
+  };
+  struct Stats
+  {
+    uint32_t ownerPpdus;
+    uint32_t overruns;        // grants beyond the end of the SP
+    uint32_t used;            // BlockAcks announcing a reverse PPDU
+    uint32_t returned;        // BlockAcks returning the grant
+    uint32_t reversePpdus;
+    uint32_t reverseBlockAcks;
+    uint32_t reverseReceived; // reverse packets delivered to the owner
+    uint32_t deferred;        // BlockAcks notified at the end of their grant
+    uint32_t early;           // BlockAcks notified before the end of their grant
+    uint32_t repeated;        // PPDUs whose BlockAck is notified more than once
+    uint32_t released;        // owner PPDUs after the lost PPDU or the cut
+    uint64_t reverseNs;
+  };
+  Stats Run (Scenario scenario);
+  void SendForward (uint16_t id);
+  void SendReverse (uint16_t id);
+  void OwnerTx (Ptr<const Packet> packet);
+  void OwnerRx (Ptr<const Packet> packet);
+  void ResponderTx (Ptr<const Packet> packet);
+  void ResponderRx (Ptr<const Packet> packet);
+  void OwnerTxOk (const WifiMacHeader &hdr);
+  void Receive (Ptr<Packet> packet, Mac48Address from, Mac48Address to);
+  void NotifySpStats (const DmgSpStats &stats);
+  /* End of the Tx SP of the owner in progress at t */
+  Time GetOwnerSpEnd (Time t);
+  /* Only MacLow sees the cut: EdcaTxopN goes on until the end of the SP,
+   * whose exchanges are not checked */
+  bool IsAfterCut (void) const;
+
+  Scenario m_scenario;
+  Ptr<DmgWifiMac> m_owner;
+  Ptr<DmgWifiMac> m_responder;
+  Ptr<YansWifiPhy> m_responderPhy;
+  Ptr<MacLow> m_ownerLow;
+  Ipv4Address m_ownerIp;
+  Ipv4Address m_responderIp;
+  double m_txPower;
+  /* BlockAcks notified since the last PPDU of the owner. The MPDUs of a
+   * BlockAck are all notified at once */
+  uint32_t m_notified;
+  Time m_lastNotified;
+  /* Grant announced by the responder and not notified to the owner yet */
+  bool m_pending;
+  Time m_pendingEnd;
+  Time m_reverseBlockAckTime;
+  Time m_cutTime;
+  Time m_cutSpEnd;
+  bool m_faultDone;
+  bool m_faultReleased;
+  Stats m_stats;
+};
+
+void
+DmgReverseDirectionTest::SendForward (uint16_t id)
+{
+  m_owner->Enqueue (CreateIpv4Packet (m_ownerIp, m_responderIp, id, 1400), m_responder->GetAddress ());
+}
+
+void
+DmgReverseDirectionTest::SendReverse (uint16_t id)
+{
+  m_responder->Enqueue (CreateIpv4Packet (m_responderIp, m_ownerIp, id, 100), m_owner->GetAddress ());
+}
+
+Time
+DmgReverseDirectionTest::GetOwnerSpEnd (Time t)
+{
+  Ptr<DmgBeaconInterval> bi = m_owner->GetDmgBeaconInterval ();
+  Time biStart = bi->GetBiDuration () * (t.GetNanoSeconds () / bi->GetBiDuration ().GetNanoSeconds ());
+  std::vector<Ptr<DmgServicePeriod> > sps = bi->GetSps ();
+  for (uint32_t spIdx = 0; spIdx < sps.size (); spIdx++)
+    {
+      if (sps[spIdx]->GetSpIfTx () && biStart + sps[spIdx]->GetSpStart () <= t && t < biStart + sps[spIdx]->GetSpStop ())
+        {
+          return biStart + sps[spIdx]->GetSpStop ();
+        }
+    }
+  return Seconds (0);
+}
+
+bool
+DmgReverseDirectionTest::IsAfterCut (void) const
+{
+  return m_scenario == CUT && m_faultDone && Simulator::Now () < m_cutSpEnd;
+}
+
+void
+DmgReverseDirectionTest::OwnerTx (Ptr<const Packet> packet)
+{
+  WifiMacHeader hdr;
+  bool last = PeekMpduHeader (packet, &hdr);
+  if (hdr.IsQosData () && last)
+    {
+      m_stats.ownerPpdus++;
+      if (m_notified > 1)
+        {
+          m_stats.repeated++;
+        }
+      m_notified = 0;
+      if (m_faultReleased)
+        {
+          m_stats.released++;
+          // The responder can be heard again
+          m_responderPhy->SetTxPowerStart (m_txPower);
+          m_responderPhy->SetTxPowerEnd (m_txPower);
+        }
+    }
+  else if (hdr.IsBlockAck () && hdr.GetAddr1 () == m_responder->GetAddress () && !IsAfterCut ())
+    {
+      m_stats.reverseBlockAcks++;
+      m_reverseBlockAckTime = Simulator::Now ();
+    }
+}
+
+void
+DmgReverseDirectionTest::OwnerRx (Ptr<const Packet> packet)
+{
+  WifiMacHeader hdr;
+  PeekMpduHeader (packet, &hdr);
+  if (m_scenario == CUT && !m_faultDone && hdr.IsBlockAck () && hdr.GetDuration () > Seconds (0))
+    {
+      // The SP ends as soon as MacLow holds the BlockAck back, as
+      // EdcaTxopN::StopDmgSp ends it
+      m_faultDone = true;
+      m_cutTime = Simulator::Now ();
+      m_cutSpEnd = GetOwnerSpEnd (m_cutTime);
+      Simulator::ScheduleNow (&MacLow::NotifySpEnd, m_ownerLow);
+    }
+}
+
+void
+DmgReverseDirectionTest::ResponderTx (Ptr<const Packet> packet)
+{
+  WifiMacHeader hdr;
+  bool last = PeekMpduHeader (packet, &hdr);
+  if (IsAfterCut ())
+    {
+      return;
+    }
+  if (hdr.IsBlockAck () && hdr.GetAddr1 () == m_owner->GetAddress ())
+    {
+      if (hdr.GetDuration () == Seconds (0))
+        {
+          m_stats.returned++;
+          return;
+        }
+      m_stats.used++;
+      m_pending = true;
+      m_pendingEnd = Simulator::Now () + hdr.GetDuration ();
+      m_reverseBlockAckTime = Seconds (0);
+      if (m_scenario == LOST && !m_faultDone)
+        {
+          // Only the reverse PPDU is lost, not the BlockAck on the air
+          m_faultDone = true;
+          Simulator::Schedule (NanoSeconds (1), &YansWifiPhy::SetTxPowerStart, m_responderPhy, -100);
+          Simulator::Schedule (NanoSeconds (1), &YansWifiPhy::SetTxPowerEnd, m_responderPhy, -100);
+        }
+    }
+  else if (hdr.IsQosData () && last && hdr.GetAddr1 () == m_owner->GetAddress ())
+    {
+      m_stats.reversePpdus++;
+    }
+}
+
+void
+DmgReverseDirectionTest::ResponderRx (Ptr<const Packet> packet)
+{
+  WifiMacHeader hdr;
+  bool last = PeekMpduHeader (packet, &hdr);
+  if (hdr.IsQosData () && last && hdr.GetAddr2 () == m_owner->GetAddress ()
+      && Simulator::Now () + hdr.GetDuration () > GetOwnerSpEnd (Simulator::Now ()))
+    {
+      m_stats.overruns++;
+    }
+}
+
+void
+DmgReverseDirectionTest::OwnerTxOk (const WifiMacHeader &hdr)
+{
+  if (!hdr.IsQosData ())
+    {
+      return;
+    }
+  if (m_lastNotified != Simulator::Now ())
+    {
+      m_notified++;
+      m_lastNotified = Simulator::Now ();
+    }
+  if (!m_pending)
+    {
+      return;
+    }
+  m_pending = false;
+  bool atEnd;
+  if (m_scenario == CUT && m_cutTime == Simulator::Now ())
+    {
+      atEnd = true;
+      m_faultReleased = true;
+    }
+  else if (m_scenario == LOST && m_reverseBlockAckTime == Seconds (0))
+    {
+      // No reverse BlockAck: the owner waits for the whole grant
+      atEnd = Simulator::Now () >= m_pendingEnd;
+      m_faultReleased = true;
+    }
+  else
+    {
+      atEnd = m_reverseBlockAckTime > Seconds (0);
+    }
+  if (atEnd)
+    {
+      m_stats.deferred++;
+    }
+  else
+    {
+      m_stats.early++;
+    }
+}
+
+void
+DmgReverseDirectionTest::Receive (Ptr<Packet>, Mac48Address, Mac48Address to)
+{
+  if (to == m_owner->GetAddress ())
+    {
+      m_stats.reverseReceived++;
+    }
+}
+
+void
+DmgReverseDirectionTest::NotifySpStats (const DmgSpStats &stats)
+{
+  m_stats.reverseNs += stats.reverseNs;
+}
+
+DmgReverseDirectionTest::Stats
+DmgReverseDirectionTest::Run (Scenario scenario)
+{
+  NodeContainer nodes;
+  nodes.Create (3);
+  // Node 1 needs a second link to be in a clique: the flow to node 2 is
+  // idle
+  std::vector<std::vector<uint32_t> > paths (2);
+  uint32_t path0[] = {0, 1};
+  uint32_t path1[] = {0, 1, 2};
+  paths[0].assign (path0, path0 + 2);
+  paths[1].assign (path1, path1 + 3);
+  NetDeviceContainer devices = InstallDmgLine (&nodes, paths, "ReverseDirection", CreateObject<DmgAlmightyController> ());
+
+  m_scenario = scenario;
+  m_owner = devices.Get (0)->GetObject<WifiNetDevice> ()->GetMac ()->GetObject<DmgWifiMac> ();
+  m_responder = devices.Get (1)->GetObject<WifiNetDevice> ()->GetMac ()->GetObject<DmgWifiMac> ();
+  PointerValue edca;
+  m_owner->GetAttribute ("BE_EdcaTxopN", edca);
+  m_ownerLow = edca.Get<EdcaTxopN> ()->Low ();
+  m_responderPhy = devices.Get (1)->GetObject<WifiNetDevice> ()->GetPhy ()->GetObject<YansWifiPhy> ();
+  m_txPower = m_responderPhy->GetTxPowerStart ();
+  m_ownerIp = nodes.Get (0)->GetObject<Ipv4> ()->GetAddress (1, 0).GetLocal ();
+  m_responderIp = nodes.Get (1)->GetObject<Ipv4> ()->GetAddress (1, 0).GetLocal ();
+
+  devices.Get (0)->GetObject<WifiNetDevice> ()->GetPhy ()->TraceConnectWithoutContext ("PhyTxBegin", MakeCallback (&DmgReverseDirectionTest::OwnerTx, this));
+  devices.Get (0)->GetObject<WifiNetDevice> ()->GetPhy ()->TraceConnectWithoutContext ("PhyRxEnd", MakeCallback (&DmgReverseDirectionTest::OwnerRx, this));
+  m_responderPhy->TraceConnectWithoutContext ("PhyTxBegin", MakeCallback (&DmgReverseDirectionTest::ResponderTx, this));
+  m_responderPhy->TraceConnectWithoutContext ("PhyRxEnd", MakeCallback (&DmgReverseDirectionTest::ResponderRx, this));
+  m_owner->TraceConnectWithoutContext ("TxOkHeader", MakeCallback (&DmgReverseDirectionTest::OwnerTxOk, this));
+  m_owner->TraceConnectWithoutContext ("SpStats", MakeCallback (&DmgReverseDirectionTest::NotifySpStats, this));
+  // The packets are not handed to the IP stacks, which would answer them
+  m_owner->SetForwardUpCallback (MakeCallback (&DmgReverseDirectionTest::Receive, this));
+  m_responder->SetForwardUpCallback (MakeCallback (&DmgReverseDirectionTest::Receive, this));
+
+  m_stats = Stats ();
+  m_notified = 0;
+  m_lastNotified = Seconds (-1);
+  m_pending = false;
+  m_cutTime = Seconds (0);
+  m_cutSpEnd = Seconds (0);
+  m_faultDone = false;
+  m_faultReleased = false;
+  // The owner is backlogged. The responder, which has no SP toward it,
+  // has a packet for it now and then: some grants are returned
+  uint16_t id = 0;
+  for (Time t = Seconds (0); t < MilliSeconds (5); t += MicroSeconds (5))
+    {
+      Simulator::Schedule (t, &DmgReverseDirectionTest::SendForward, this, id++);
+    }
+  id = 0;
+  for (Time t = Seconds (0); t < MilliSeconds (5); t += MicroSeconds (70))
+    {
+      Simulator::Schedule (t, &DmgReverseDirectionTest::SendReverse, this, id++);
+    }
+  Simulator::Stop (MilliSeconds (6));
+  Simulator::Run ();
+  Simulator::Destroy ();
+  m_owner = 0;
+  m_responder = 0;
+  m_responderPhy = 0;
+  m_ownerLow = 0;
+  return m_stats;
+}
+
+void
+DmgReverseDirectionTest::DoRun (void)
+{
+  Stats grant = Run (GRANT);
+  NS_TEST_ASSERT_MSG_GT (grant.used, 0, "no grant used");
+  NS_TEST_EXPECT_MSG_GT (grant.returned, 0, "no grant returned");
+  NS_TEST_EXPECT_MSG_EQ (grant.overruns, 0, "grants beyond the end of the SP");
+  NS_TEST_EXPECT_MSG_EQ (grant.reversePpdus, grant.used, "one reverse PPDU per grant used");
+  NS_TEST_EXPECT_MSG_EQ (grant.reverseBlockAcks, grant.reversePpdus, "reverse PPDUs not acknowledged");
+  NS_TEST_EXPECT_MSG_GT (grant.reverseReceived, 0, "no reverse packet delivered");
+  NS_TEST_EXPECT_MSG_GT (grant.reverseNs, 0, "reverse time not accounted");
+  NS_TEST_EXPECT_MSG_EQ (grant.deferred, grant.used, "BlockAcks not notified after the reverse exchange");
+  NS_TEST_EXPECT_MSG_EQ (grant.early, 0, "BlockAcks notified before the end of the grant");
+  NS_TEST_EXPECT_MSG_EQ (grant.repeated, 0, "BlockAcks notified more than once");
+
+  Stats lost = Run (LOST);
+  NS_TEST_ASSERT_MSG_GT (lost.used, 1, "no grant used after the lost PPDU");
+  NS_TEST_EXPECT_MSG_EQ (lost.reverseBlockAcks + 1, lost.reversePpdus, "only the lost reverse PPDU is not acknowledged");
+  NS_TEST_EXPECT_MSG_EQ (lost.deferred, lost.used, "BlockAcks not notified at the end of the grant");
+  NS_TEST_EXPECT_MSG_EQ (lost.early, 0, "BlockAck notified before the end of the grant of the lost PPDU");
+  NS_TEST_EXPECT_MSG_EQ (lost.repeated, 0, "BlockAcks notified more than once");
+  NS_TEST_EXPECT_MSG_GT (lost.released, 0, "owner not released by the lost reverse PPDU");
+
+  Stats cut = Run (CUT);
+  NS_TEST_ASSERT_MSG_GT (cut.used, 1, "no grant used after the cut");
+  NS_TEST_EXPECT_MSG_EQ (cut.deferred, cut.used, "BlockAcks not notified at the end of the grant or of the SP");
+  NS_TEST_EXPECT_MSG_EQ (cut.early, 0, "BlockAck notified before the end of the grant");
+  NS_TEST_EXPECT_MSG_EQ (cut.repeated, 0, "BlockAcks notified more than once");
+  NS_TEST_EXPECT_MSG_GT (cut.released, 0, "owner not released by the end of the SP");
+}
+
 class WifiTestSuite : public TestSuite
 {
 public:
@@ -490,6 +2648,27 @@ WifiTestSuite::WifiTestSuite ()
   AddTestCase (new QosUtilsIsOldPacketTest, TestCase::QUICK);
   AddTestCase (new InterferenceHelperSequenceTest, TestCase::QUICK); // Bug 991
   AddTestCase (new Bug555TestCase, TestCase::QUICK); // Bug 555
+  AddTestCase (new WifiMacQueueFlowIndexTest, TestCase::QUICK);
+  AddTestCase (new DmgOptimizationSolverTest, TestCase::QUICK);
+  AddTestCase (new DmgAirtimeAllocatorTest, TestCase::QUICK);
+  AddTestCase (new DmgLayerSchedulerTest, TestCase::QUICK);
+  AddTestCase (new DmgRoutePlannerTest, TestCase::QUICK);
+  AddTestCase (new DmgChannelPlannerTest, TestCase::QUICK);
+  AddTestCase (new DmgSpRecorderTest, TestCase::QUICK);
+  AddTestCase (new DmgAirtimeModelTest, TestCase::QUICK);
+  AddTestCase (new DmgMcsTableTest, TestCase::QUICK);
+  AddTestCase (new DmgSnrWifiManagerTest, TestCase::QUICK);
+  AddTestCase (new TabulatedErrorRateModelTest, TestCase::QUICK);
+  AddTestCase (new DmgErrorRateModelTest, TestCase::QUICK);
+  AddTestCase (new AmpduContainerTest, TestCase::QUICK);
+  AddTestCase (new AntennaBatchGainTest, TestCase::QUICK);
+  AddTestCase (new BeamformingEngineTest, TestCase::QUICK);
+  AddTestCase (new DmgBeaconIntervalUpdateTest, TestCase::QUICK);
+  AddTestCase (new DmgControllerReplanTest, TestCase::QUICK);
+  AddTestCase (new DmgControllerSweepChargeTest, TestCase::QUICK);
+  AddTestCase (new DmgSpFastForwardTest, TestCase::QUICK);
+  AddTestCase (new DmgSpTailPackingTest, TestCase::QUICK);
+  AddTestCase (new DmgReverseDirectionTest, TestCase::QUICK);
 }
 
 static WifiTestSuite g_wifiTestSuite;